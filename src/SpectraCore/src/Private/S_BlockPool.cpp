@@ -0,0 +1,133 @@
+#include "S_BlockPool.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+
+namespace spectra::core::memory {
+	namespace {
+		uint64_t pack(void* pointer, uint64_t tag) {
+			return (reinterpret_cast<uint64_t>(pointer) & ((uint64_t{ 1 } << 48) - 1)) | (tag << 48);
+		}
+
+		uint64_t nextTag(uint64_t head) {
+			return ((head >> 48) + 1) & 0xFFFF;
+		}
+	}
+
+	// S_BlockPool implementations
+	S_BlockPool::S_BlockPool(size_t blockSize, size_t blockAlignment, size_t blocksPerChunk, E_MemoryTag tag, std::pmr::memory_resource* upstream)
+		: blockAlignment(std::max(blockAlignment, alignof(S_FreeBlock))),
+		blocksPerChunk(std::max<size_t>(blocksPerChunk, 1)), tag(tag), upstream(upstream) {
+		if ((this->blockAlignment & (this->blockAlignment - 1)) != 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::memory", "S_BlockPool", "Block alignment must be a power of two", static_cast<uint64_t>(blockAlignment));
+		}
+		this->blockSize = alignUp(std::max(blockSize, sizeof(S_FreeBlock)), this->blockAlignment);
+	}
+
+	S_BlockPool::~S_BlockPool() {
+		const size_t chunkBytes = blockSize * blocksPerChunk;
+		for (void* chunk : chunks) {
+			upstream->deallocate(chunk, chunkBytes, blockAlignment);
+			S_MemoryTracker::recordDeallocation(tag, chunkBytes);
+		}
+	}
+
+	void S_BlockPool::pushList(S_FreeBlock* first, S_FreeBlock* last) {
+		uint64_t head = freeHead.load(std::memory_order_relaxed);
+		do {
+			last->next = reinterpret_cast<S_FreeBlock*>(head & POINTER_MASK);
+		} while (!freeHead.compare_exchange_weak(head, pack(first, nextTag(head)), std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	S_BlockPool::S_FreeBlock* S_BlockPool::popBlock() {
+		uint64_t head = freeHead.load(std::memory_order_acquire);
+		while (true) {
+			auto* block = reinterpret_cast<S_FreeBlock*>(head & POINTER_MASK);
+			if (!block) {
+				return nullptr;
+			}
+
+			// The block may be popped and rewritten by another thread before our CAS. Chunks
+			// stay mapped for the pool's lifetime so the read is safe, and the tag makes the
+			// CAS fail if that happened.
+			S_FreeBlock* next = block->next;
+			if (freeHead.compare_exchange_weak(head, pack(next, nextTag(head)), std::memory_order_acquire, std::memory_order_acquire)) {
+				return block;
+			}
+		}
+	}
+
+	void* S_BlockPool::grow() {
+		std::lock_guard<std::mutex> lock(growMutex);
+
+		// Another thread may have grown the pool while we waited
+		if (S_FreeBlock* block = popBlock()) {
+			return block;
+		}
+
+		const size_t chunkBytes = blockSize * blocksPerChunk;
+		auto* chunk = static_cast<std::byte*>(upstream->allocate(chunkBytes, blockAlignment));
+		S_MemoryTracker::recordAllocation(tag, chunkBytes);
+		chunks.push_back(chunk);
+		chunkCount.fetch_add(1, std::memory_order_relaxed);
+
+		// Keep the first block for the caller and publish the rest in one CAS
+		if (blocksPerChunk > 1) {
+			auto* first = reinterpret_cast<S_FreeBlock*>(chunk + blockSize);
+			S_FreeBlock* current = first;
+			for (size_t i = 2; i < blocksPerChunk; ++i) {
+				auto* next = reinterpret_cast<S_FreeBlock*>(chunk + i * blockSize);
+				current->next = next;
+				current = next;
+			}
+			pushList(first, current);
+		}
+		return chunk;
+	}
+
+	void* S_BlockPool::allocateBlock() {
+		if (S_FreeBlock* block = popBlock()) {
+			return block;
+		}
+		return grow();
+	}
+
+	void S_BlockPool::releaseBlock(void* block) {
+		if (!block) {
+			return;
+		}
+		auto* freeBlock = static_cast<S_FreeBlock*>(block);
+		pushList(freeBlock, freeBlock);
+	}
+
+	size_t S_BlockPool::getBlockSize() const {
+		return blockSize;
+	}
+
+	size_t S_BlockPool::getBlockAlignment() const {
+		return blockAlignment;
+	}
+
+	size_t S_BlockPool::getCapacity() const {
+		return chunkCount.load(std::memory_order_relaxed) * blocksPerChunk;
+	}
+
+	E_MemoryTag S_BlockPool::getTag() const {
+		return tag;
+	}
+
+	void* S_BlockPool::do_allocate(size_t bytes, size_t alignment) {
+		if (bytes > blockSize || alignment > blockAlignment) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::memory", "S_BlockPool", "Request does not fit in a pool block", static_cast<uint64_t>(bytes), static_cast<uint64_t>(blockSize));
+		}
+		return allocateBlock();
+	}
+
+	void S_BlockPool::do_deallocate(void* pointer, size_t, size_t) {
+		releaseBlock(pointer);
+	}
+
+	bool S_BlockPool::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+		return this == &other;
+	}
+}
@@ -0,0 +1,104 @@
+#include "S_CpuFeatures.h"
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SPECTRA_CPUID_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define SPECTRA_CPUID_X86 1
+#endif
+
+namespace spectra::core::platform {
+	namespace {
+#if defined(SPECTRA_CPUID_X86)
+		void cpuid(uint32_t leaf, uint32_t subLeaf, uint32_t registers[4]) {
+#if defined(_MSC_VER)
+			int values[4];
+			__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subLeaf));
+			for (int i = 0; i < 4; ++i) {
+				registers[i] = static_cast<uint32_t>(values[i]);
+			}
+#else
+			__cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+		}
+
+		// Register state the OS saves on context switches (XCR0)
+		uint64_t readExtendedControlRegister() {
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			uint32_t low;
+			uint32_t high;
+			__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+			return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+		}
+
+		bool bit(uint32_t value, int index) {
+			return (value >> index) & 1u;
+		}
+
+		S_CpuFeatures detect() {
+			S_CpuFeatures features;
+			uint32_t registers[4];
+			cpuid(0, 0, registers);
+			const uint32_t maxLeaf = registers[0];
+			if (maxLeaf < 1) {
+				return features;
+			}
+
+			cpuid(1, 0, registers);
+			const uint32_t ecx1 = registers[2];
+			features.sse42 = bit(ecx1, 20);
+
+			// XMM and YMM state for AVX, plus opmask and ZMM state for AVX-512
+			const bool osSavesAvx = bit(ecx1, 27) && (readExtendedControlRegister() & 0x6) == 0x6;
+			const bool osSavesAvx512 = osSavesAvx && (readExtendedControlRegister() & 0xE0) == 0xE0;
+			features.avx = osSavesAvx && bit(ecx1, 28);
+			features.fma = features.avx && bit(ecx1, 12);
+
+			if (maxLeaf >= 7) {
+				cpuid(7, 0, registers);
+				const uint32_t ebx7 = registers[1];
+				features.avx2 = features.avx && bit(ebx7, 5);
+				features.avx512f = osSavesAvx512 && bit(ebx7, 16);
+				features.avx512dq = features.avx512f && bit(ebx7, 17);
+				features.avx512bw = features.avx512f && bit(ebx7, 30);
+				features.avx512vl = features.avx512f && bit(ebx7, 31);
+			}
+			return features;
+		}
+#else
+		S_CpuFeatures detect() {
+			return {};
+		}
+#endif
+	}
+
+	// S_CpuFeatures implementations
+	const S_CpuFeatures& S_CpuFeatures::get() {
+		static const S_CpuFeatures features = detect();
+		return features;
+	}
+
+	std::string S_CpuFeatures::toString() const {
+		std::string result;
+		const auto append = [&result](bool present, const char* name) {
+			if (present) {
+				result += result.empty() ? name : std::string(" ") + name;
+			}
+		};
+		append(sse42, "SSE4.2");
+		append(avx, "AVX");
+		append(avx2, "AVX2");
+		append(fma, "FMA");
+		append(avx512f, "AVX512F");
+		append(avx512vl, "AVX512VL");
+		append(avx512bw, "AVX512BW");
+		append(avx512dq, "AVX512DQ");
+		return result.empty() ? "none" : result;
+	}
+}
@@ -0,0 +1,363 @@
+#include "S_EntityWorld.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace spectra::core::ecs {
+	namespace {
+		constexpr uint8_t NO_COLUMN = 0xFF;
+
+		// Enough 16 KB chunks per upstream allocation to keep pool growth rare
+		constexpr size_t CHUNKS_PER_BLOCK = 16;
+	}
+
+	struct S_ArchetypeChunk {
+		std::byte* data = nullptr;
+		uint32_t count = 0;
+		std::vector<uint32_t> versions;  // Per column, the last version anything in it changed
+	};
+
+	// Column 0 holds the entity handles, columns 1.. the components in ascending id order
+	struct S_Archetype {
+		ComponentMask mask = 0;
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> sizes;
+		uint8_t columnOf[S_EntityWorld::MAX_COMPONENTS];
+		std::vector<uint32_t> componentOf;  // Per column, the component id; unused for column 0
+		uint32_t capacity = 0;
+		std::vector<S_ArchetypeChunk> chunks;
+
+		[[nodiscard]] std::byte* at(uint32_t chunk, uint32_t column, uint32_t row) const {
+			return chunks[chunk].data + offsets[column] + size_t(row) * sizes[column];
+		}
+
+		void stamp(uint32_t chunk, uint32_t version) {
+			std::fill(chunks[chunk].versions.begin(), chunks[chunk].versions.end(), version);
+		}
+	};
+
+	// S_ChunkView implementations
+	uint32_t S_ChunkView::getCount() const {
+		return count;
+	}
+
+	ComponentMask S_ChunkView::getComponents() const {
+		return components;
+	}
+
+	std::span<const S_Entity> S_ChunkView::getEntities() const {
+		return { reinterpret_cast<const S_Entity*>(archetype->chunks[chunk].data), count };
+	}
+
+	void* S_ChunkView::getColumn(uint32_t component, bool write) const {
+		if (component >= S_EntityWorld::MAX_COMPONENTS || !(components & (ComponentMask{ 1 } << component))) {
+			return nullptr;
+		}
+		const uint32_t column = archetype->columnOf[component];
+		if (write) {
+			archetype->chunks[chunk].versions[column] = version;
+		}
+		return archetype->chunks[chunk].data + archetype->offsets[column];
+	}
+
+	uint32_t S_ChunkView::getColumnVersion(uint32_t component) const {
+		if (component >= S_EntityWorld::MAX_COMPONENTS || !(components & (ComponentMask{ 1 } << component))) {
+			return 0;
+		}
+		return archetype->chunks[chunk].versions[archetype->columnOf[component]];
+	}
+
+	// S_EntityWorld implementations
+	S_EntityWorld::S_EntityWorld()
+		: chunkPool(CHUNK_BYTES, CHUNK_ALIGNMENT, CHUNKS_PER_BLOCK, memory::E_MemoryTag::SCENE) {
+	}
+
+	S_EntityWorld::~S_EntityWorld() {
+		for (const std::unique_ptr<S_Archetype>& archetype : archetypes) {
+			for (const S_ArchetypeChunk& chunk : archetype->chunks) {
+				chunkPool.releaseBlock(chunk.data);
+			}
+		}
+	}
+
+	uint32_t S_EntityWorld::registerComponent(std::string_view name, size_t size, size_t alignment, const void* defaultValue) {
+		if (components.size() >= MAX_COMPONENTS) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::ecs", "S_EntityWorld", "Too many component types",
+				std::string(name), MAX_COMPONENTS);
+		}
+		S_ComponentInfo info;
+		info.name = name;
+		info.size = size;
+		info.alignment = alignment;
+		info.defaultValue.resize(size);
+		std::memcpy(info.defaultValue.data(), defaultValue, size);
+		components.push_back(std::move(info));
+		return static_cast<uint32_t>(components.size() - 1);
+	}
+
+	uint32_t S_EntityWorld::findArchetype(ComponentMask mask) {
+		if (const auto found = archetypeByMask.find(mask); found != archetypeByMask.end()) {
+			return found->second;
+		}
+		if (components.size() < MAX_COMPONENTS && (mask >> components.size()) != 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::ecs", "S_EntityWorld", "Unknown component in mask",
+				mask, static_cast<uint64_t>(components.size()));
+		}
+
+		auto archetype = std::make_unique<S_Archetype>();
+		archetype->mask = mask;
+		std::fill(std::begin(archetype->columnOf), std::end(archetype->columnOf), NO_COLUMN);
+		archetype->sizes.push_back(sizeof(S_Entity));
+		archetype->componentOf.push_back(0);
+		size_t rowBytes = sizeof(S_Entity);
+		for (ComponentMask bits = mask; bits != 0; bits &= bits - 1) {
+			const uint32_t component = static_cast<uint32_t>(std::countr_zero(bits));
+			archetype->columnOf[component] = static_cast<uint8_t>(archetype->sizes.size());
+			archetype->sizes.push_back(static_cast<uint32_t>(components[component].size));
+			archetype->componentOf.push_back(component);
+			rowBytes += components[component].size;
+		}
+
+		// As many rows as fit once every column is padded to its alignment
+		archetype->offsets.resize(archetype->sizes.size());
+		for (uint32_t capacity = static_cast<uint32_t>(CHUNK_BYTES / rowBytes); capacity > 0; --capacity) {
+			size_t offset = 0;
+			for (size_t column = 0; column < archetype->sizes.size(); ++column) {
+				const size_t alignment = column == 0 ? alignof(S_Entity) : components[archetype->componentOf[column]].alignment;
+				offset = memory::alignUp(offset, alignment);
+				archetype->offsets[column] = static_cast<uint32_t>(offset);
+				offset += size_t(archetype->sizes[column]) * capacity;
+			}
+			if (offset <= CHUNK_BYTES) {
+				archetype->capacity = capacity;
+				break;
+			}
+		}
+		if (archetype->capacity == 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::ecs", "S_EntityWorld", "Components do not fit in a chunk",
+				mask, static_cast<uint64_t>(rowBytes));
+		}
+
+		archetypes.push_back(std::move(archetype));
+		const uint32_t index = static_cast<uint32_t>(archetypes.size() - 1);
+		archetypeByMask.emplace(mask, index);
+		return index;
+	}
+
+	S_Entity S_EntityWorld::allocateEntity() {
+		uint32_t index;
+		if (!freeIndices.empty()) {
+			index = freeIndices.back();
+			freeIndices.pop_back();
+		}
+		else {
+			index = static_cast<uint32_t>(records.size());
+			records.emplace_back();
+		}
+		records[index].alive = true;
+		++entityCount;
+		return { index, records[index].generation };
+	}
+
+	void S_EntityWorld::appendRow(uint32_t archetypeIndex, S_Entity entity) {
+		S_Archetype& archetype = *archetypes[archetypeIndex];
+		if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity) {
+			S_ArchetypeChunk chunk;
+			chunk.data = static_cast<std::byte*>(chunkPool.allocateBlock());
+			chunk.versions.assign(archetype.sizes.size(), version);
+			archetype.chunks.push_back(std::move(chunk));
+		}
+		const uint32_t chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+		const uint32_t row = archetype.chunks[chunk].count++;
+		std::memcpy(archetype.at(chunk, 0, row), &entity, sizeof(S_Entity));
+		for (size_t column = 1; column < archetype.sizes.size(); ++column) {
+			std::memcpy(archetype.at(chunk, static_cast<uint32_t>(column), row), components[archetype.componentOf[column]].defaultValue.data(),
+				archetype.sizes[column]);
+		}
+		archetype.stamp(chunk, version);
+
+		S_EntityRecord& record = records[entity.index];
+		record.archetype = archetypeIndex;
+		record.chunk = chunk;
+		record.row = row;
+	}
+
+	void S_EntityWorld::removeRow(uint32_t archetypeIndex, uint32_t chunk, uint32_t row) {
+		// The archetype's last row fills the hole, so only the last chunk is ever partly empty
+		S_Archetype& archetype = *archetypes[archetypeIndex];
+		const uint32_t lastChunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+		const uint32_t lastRow = archetype.chunks[lastChunk].count - 1;
+		if (chunk != lastChunk || row != lastRow) {
+			for (size_t column = 0; column < archetype.sizes.size(); ++column) {
+				std::memcpy(archetype.at(chunk, static_cast<uint32_t>(column), row), archetype.at(lastChunk, static_cast<uint32_t>(column), lastRow),
+					archetype.sizes[column]);
+			}
+			S_Entity moved;
+			std::memcpy(&moved, archetype.at(chunk, 0, row), sizeof(S_Entity));
+			records[moved.index].chunk = chunk;
+			records[moved.index].row = row;
+			archetype.stamp(chunk, version);
+		}
+		if (--archetype.chunks[lastChunk].count == 0) {
+			chunkPool.releaseBlock(archetype.chunks[lastChunk].data);
+			archetype.chunks.pop_back();
+		}
+	}
+
+	S_Entity S_EntityWorld::create(ComponentMask mask) {
+		const uint32_t archetype = findArchetype(mask);
+		const S_Entity entity = allocateEntity();
+		appendRow(archetype, entity);
+		structureVersion = version;
+		return entity;
+	}
+
+	void S_EntityWorld::create(ComponentMask mask, uint32_t count, std::vector<S_Entity>& entities) {
+		const uint32_t archetype = findArchetype(mask);
+		entities.reserve(entities.size() + count);
+		records.reserve(records.size() + count);
+		for (uint32_t i = 0; i < count; ++i) {
+			const S_Entity entity = allocateEntity();
+			appendRow(archetype, entity);
+			entities.push_back(entity);
+		}
+		structureVersion = version;
+	}
+
+	void S_EntityWorld::destroy(S_Entity entity) {
+		if (!isAlive(entity)) {
+			return;
+		}
+		S_EntityRecord& record = records[entity.index];
+		removeRow(record.archetype, record.chunk, record.row);
+		record.alive = false;
+		++record.generation;
+		freeIndices.push_back(entity.index);
+		--entityCount;
+		structureVersion = version;
+	}
+
+	bool S_EntityWorld::isAlive(S_Entity entity) const {
+		return entity.index < records.size() && records[entity.index].alive && records[entity.index].generation == entity.generation;
+	}
+
+	ComponentMask S_EntityWorld::getComponents(S_Entity entity) const {
+		return isAlive(entity) ? archetypes[records[entity.index].archetype]->mask : 0;
+	}
+
+	void S_EntityWorld::setComponents(S_Entity entity, ComponentMask mask) {
+		if (!isAlive(entity)) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::WARNING, "spectra::core::ecs", "S_EntityWorld", "Ignoring component change of a destroyed entity",
+				entity.index, entity.generation);
+			return;
+		}
+		const S_EntityRecord source = records[entity.index];
+		if (archetypes[source.archetype]->mask == mask) {
+			return;
+		}
+
+		const uint32_t target = findArchetype(mask);
+		appendRow(target, entity);
+		const S_Archetype& from = *archetypes[source.archetype];
+		const S_Archetype& to = *archetypes[target];
+		const S_EntityRecord& moved = records[entity.index];
+		for (ComponentMask bits = from.mask & to.mask; bits != 0; bits &= bits - 1) {
+			const uint32_t component = static_cast<uint32_t>(std::countr_zero(bits));
+			std::memcpy(to.at(moved.chunk, to.columnOf[component], moved.row), from.at(source.chunk, from.columnOf[component], source.row),
+				components[component].size);
+		}
+		removeRow(source.archetype, source.chunk, source.row);
+		structureVersion = version;
+	}
+
+	void* S_EntityWorld::getComponent(S_Entity entity, uint32_t component, bool write) {
+		if (!isAlive(entity) || component >= MAX_COMPONENTS) {
+			return nullptr;
+		}
+		const S_EntityRecord& record = records[entity.index];
+		S_Archetype& archetype = *archetypes[record.archetype];
+		const uint8_t column = archetype.columnOf[component];
+		if (column == NO_COLUMN) {
+			return nullptr;
+		}
+		if (write) {
+			archetype.chunks[record.chunk].versions[column] = version;
+		}
+		return archetype.at(record.chunk, column, record.row);
+	}
+
+	void S_EntityWorld::collectChunks(const S_Query& query, std::vector<S_ChunkView>& chunks) {
+		chunks.clear();
+		for (const std::unique_ptr<S_Archetype>& archetype : archetypes) {
+			if ((archetype->mask & query.all) != query.all || (archetype->mask & query.none) != 0) {
+				continue;
+			}
+			for (uint32_t chunk = 0; chunk < archetype->chunks.size(); ++chunk) {
+				S_ChunkView view;
+				view.archetype = archetype.get();
+				view.chunk = chunk;
+				view.count = archetype->chunks[chunk].count;
+				view.components = archetype->mask;
+				view.version = version;
+				chunks.push_back(view);
+			}
+		}
+	}
+
+	uint32_t S_EntityWorld::getVersion() const {
+		return version;
+	}
+
+	uint32_t S_EntityWorld::advanceVersion() {
+		return version++;
+	}
+
+	uint32_t S_EntityWorld::getStructureVersion() const {
+		return structureVersion;
+	}
+
+	uint32_t S_EntityWorld::getEntityCount() const {
+		return entityCount;
+	}
+
+	uint32_t S_EntityWorld::getEntityCapacity() const {
+		return static_cast<uint32_t>(records.size());
+	}
+
+	uint32_t S_EntityWorld::getComponentCount() const {
+		return static_cast<uint32_t>(components.size());
+	}
+
+	std::string_view S_EntityWorld::getComponentName(uint32_t component) const {
+		return component < components.size() ? std::string_view(components[component].name) : std::string_view();
+	}
+
+	S_EntityWorldStats S_EntityWorld::getStats() const {
+		S_EntityWorldStats stats;
+		stats.entityCount = entityCount;
+		stats.componentCount = static_cast<uint32_t>(components.size());
+		stats.archetypeCount = static_cast<uint32_t>(archetypes.size());
+		uint64_t capacity = 0;
+		for (const std::unique_ptr<S_Archetype>& archetype : archetypes) {
+			stats.chunkCount += static_cast<uint32_t>(archetype->chunks.size());
+			capacity += uint64_t(archetype->capacity) * archetype->chunks.size();
+		}
+		stats.chunkBytes = size_t(stats.chunkCount) * CHUNK_BYTES;
+		stats.occupancy = capacity > 0 ? static_cast<double>(entityCount) / static_cast<double>(capacity) : 0.0;
+		return stats;
+	}
+
+	void S_EntityWorld::publishStats() const {
+		using instrumentation::Instrumentation;
+		const S_EntityWorldStats stats = getStats();
+		const std::string category = "spectra::core::ecs";
+		Instrumentation::setGauge(category, "entityCount", stats.entityCount);
+		Instrumentation::setGauge(category, "componentCount", stats.componentCount);
+		Instrumentation::setGauge(category, "archetypeCount", stats.archetypeCount);
+		Instrumentation::setGauge(category, "chunkCount", stats.chunkCount);
+		Instrumentation::setGauge(category, "chunkBytes", static_cast<double>(stats.chunkBytes));
+		Instrumentation::setGauge(category, "occupancy", stats.occupancy);
+	}
+}
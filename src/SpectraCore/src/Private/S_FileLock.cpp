@@ -0,0 +1,80 @@
+#include "S_FileLock.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace spectra::core::platform {
+	S_FileLock::~S_FileLock() {
+		unlock();
+	}
+
+	bool S_FileLock::lock(const std::string& filePath) {
+		unlock();
+		path = filePath;
+#if defined(_WIN32)
+		const HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			lastError = "CreateFile failed with error " + std::to_string(GetLastError());
+			return false;
+		}
+		OVERLAPPED overlapped{};
+		if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+			lastError = "LockFileEx failed with error " + std::to_string(GetLastError());
+			CloseHandle(file);
+			return false;
+		}
+		handle = reinterpret_cast<intptr_t>(file);
+#else
+		const int file = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (file < 0) {
+			lastError = std::string("open failed: ") + std::strerror(errno);
+			return false;
+		}
+		int result = 0;
+		do {
+			result = flock(file, LOCK_EX);
+		} while (result != 0 && errno == EINTR);
+		if (result != 0) {
+			lastError = std::string("flock failed: ") + std::strerror(errno);
+			::close(file);
+			return false;
+		}
+		handle = file;
+#endif
+		return true;
+	}
+
+	void S_FileLock::unlock() {
+		if (handle == -1) {
+			return;
+		}
+#if defined(_WIN32)
+		OVERLAPPED overlapped{};
+		const HANDLE file = reinterpret_cast<HANDLE>(handle);
+		UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &overlapped);
+		CloseHandle(file);
+#else
+		flock(static_cast<int>(handle), LOCK_UN);
+		::close(static_cast<int>(handle));
+#endif
+		handle = -1;
+	}
+
+	bool S_FileLock::isLocked() const {
+		return handle != -1;
+	}
+
+	const std::string& S_FileLock::getLastError() const {
+		return lastError;
+	}
+}
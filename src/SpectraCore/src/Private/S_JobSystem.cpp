@@ -0,0 +1,498 @@
+#include "S_JobSystem.h"
+#include "S_WorkStealingDeque.h"
+#include "S_BlockPool.h"
+#include "SpectraInstrumentation.h"
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace spectra::core::jobs {
+	namespace {
+		// Pool index of the current thread, -1 outside the pool
+		thread_local int32_t tlsThreadIndex = -1;
+
+		// Steal victim selection for threads that have no worker context
+		thread_local uint32_t tlsForeignSeed = 0;
+
+		// Rounds of failed job searches before a worker goes to sleep
+		constexpr uint32_t SPIN_ROUNDS = 64;
+
+		// Upper bound on a sleep, in case a wake-up is missed
+		constexpr auto SLEEP_TIMEOUT = std::chrono::milliseconds(2);
+
+		uint32_t nextRandom(uint32_t& state) {
+			// xorshift32, good enough to spread steal attempts
+			if (state == 0) {
+				state = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+			}
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		// Jobs are freed on whichever thread ran them, so they come from a lock-free pool
+		memory::S_BlockPool& jobPool() {
+			static memory::S_BlockPool pool(sizeof(S_Job), alignof(S_Job), 1024, memory::E_MemoryTag::JOBS);
+			return pool;
+		}
+
+		uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start) {
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start).count());
+		}
+	}
+
+	struct alignas(64) S_JobSystem::S_WorkerContext {
+		S_WorkStealingDeque<S_Job*> deque{ DEQUE_CAPACITY };
+		std::thread thread;
+		uint32_t randomState = 0;
+
+		// Written by the owning thread only, read by getStats()
+		std::atomic<uint64_t> jobsExecuted{ 0 };
+		std::atomic<uint64_t> jobsStolen{ 0 };
+		std::atomic<uint64_t> stealAttempts{ 0 };
+		std::atomic<uint64_t> inlineExecutions{ 0 };
+		std::atomic<uint64_t> idleNanoseconds{ 0 };
+		std::atomic<uint64_t> waitNanoseconds{ 0 };
+	};
+
+	// S_Counter implementations
+	int32_t S_Counter::value() const {
+		return pending.load(std::memory_order_acquire);
+	}
+
+	bool S_Counter::isDone() const {
+		return pending.load(std::memory_order_seq_cst) == 0 && signalling.load(std::memory_order_seq_cst) == 0;
+	}
+
+	// S_JobSystem implementations
+	S_JobSystem::S_JobSystem() = default;
+
+	S_JobSystem::~S_JobSystem() {
+		// Loggers may already be gone during static destruction, so only stop the threads
+		if (running.load(std::memory_order_acquire)) {
+			stopWorkers();
+			running.store(false, std::memory_order_release);
+		}
+	}
+
+	S_JobSystem& S_JobSystem::getInstance() {
+		static S_JobSystem instance;
+		return instance;
+	}
+
+	void S_JobSystem::initialize(uint32_t workerThreads) {
+		if (running.load(std::memory_order_acquire)) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::WARNING, "spectra::core::jobs", "S_JobSystem", "Already initialized, ignoring initialize()");
+			return;
+		}
+
+		if (workerThreads == 0) {
+			const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+			workerThreads = hardwareThreads - 1;
+		}
+
+		stopping.store(false, std::memory_order_relaxed);
+		workers.clear();
+		for (uint32_t i = 0; i <= workerThreads; ++i) {
+			workers.push_back(std::make_unique<S_WorkerContext>());
+			workers.back()->randomState = 0x9E3779B9u * (i + 1);
+		}
+
+		tlsThreadIndex = 0;
+		running.store(true, std::memory_order_release);
+
+		for (uint32_t i = 1; i <= workerThreads; ++i) {
+			workers[i]->thread = std::thread(&S_JobSystem::workerLoop, this, i);
+		}
+
+		instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::INFO, "spectra::core::jobs", "S_JobSystem", "Started job system", static_cast<int>(workerThreads + 1));
+	}
+
+	void S_JobSystem::shutdown() {
+		if (!running.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		stopWorkers();
+
+		// Anything still queued runs here so no counter is left pending
+		tlsThreadIndex = 0;
+		while (S_Job* job = findJob(0)) {
+			execute(job);
+		}
+
+		publishStats();
+		running.store(false, std::memory_order_release);
+		tlsThreadIndex = -1;
+		workers.clear();
+
+		instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::INFO, "spectra::core::jobs", "S_JobSystem", "Stopped job system");
+	}
+
+	void S_JobSystem::stopWorkers() {
+		stopping.store(true, std::memory_order_release);
+		wakeWorkers(true);
+		for (size_t i = 1; i < workers.size(); ++i) {
+			if (workers[i]->thread.joinable()) {
+				workers[i]->thread.join();
+			}
+		}
+	}
+
+	bool S_JobSystem::isRunning() const {
+		return running.load(std::memory_order_acquire);
+	}
+
+	uint32_t S_JobSystem::getThreadCount() const {
+		return isRunning() ? static_cast<uint32_t>(workers.size()) : 1u;
+	}
+
+	int32_t S_JobSystem::getCurrentThreadIndex() {
+		return tlsThreadIndex;
+	}
+
+	S_Job* S_JobSystem::allocateJob() {
+		return new (jobPool().allocateBlock()) S_Job();
+	}
+
+	void S_JobSystem::releaseJob(S_Job* job) {
+		static_assert(std::is_trivially_destructible_v<S_Job>);
+		jobPool().releaseBlock(job);
+	}
+
+	void S_JobSystem::submit(S_Job* job) {
+		const int32_t index = tlsThreadIndex;
+		if (index >= 0 && static_cast<size_t>(index) < workers.size()) {
+			S_WorkerContext& self = *workers[index];
+			if (!self.deque.push(job)) {
+				self.inlineExecutions.fetch_add(1, std::memory_order_relaxed);
+				execute(job);
+				return;
+			}
+		}
+		else {
+			std::lock_guard<std::mutex> lock(injectionMutex);
+			injectionQueue.push_back(job);
+			injectionSize.fetch_add(1, std::memory_order_release);
+			jobsInjected.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Pairs with the fence in sleepUntilWork so either we see the sleeper or it sees the job
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepingWorkers.load(std::memory_order_relaxed) > 0) {
+			wakeWorkers(false);
+		}
+	}
+
+	void S_JobSystem::park(S_Counter& dependency, S_Job* job) {
+		bool ready;
+		{
+			std::lock_guard<std::mutex> lock(dependency.continuationMutex);
+			job->nextContinuation = dependency.continuations;
+			dependency.continuations = job;
+			dependency.hasContinuations.store(true, std::memory_order_seq_cst);
+			ready = dependency.pending.load(std::memory_order_seq_cst) == 0;
+		}
+
+		// The dependency may have finished before the job was parked, in which case
+		// the signalling thread might have missed it. Whoever drains first wins.
+		if (ready) {
+			releaseContinuations(dependency);
+		}
+	}
+
+	void S_JobSystem::releaseContinuations(S_Counter& counter) {
+		S_Job* list;
+		{
+			std::lock_guard<std::mutex> lock(counter.continuationMutex);
+			list = counter.continuations;
+			counter.continuations = nullptr;
+			counter.hasContinuations.store(false, std::memory_order_relaxed);
+		}
+
+		while (list) {
+			S_Job* next = list->nextContinuation;
+			list->nextContinuation = nullptr;
+			continuationsReleased.fetch_add(1, std::memory_order_relaxed);
+			submit(list);
+			list = next;
+		}
+	}
+
+	void S_JobSystem::signal(S_Counter& counter) {
+		counter.signalling.fetch_add(1, std::memory_order_seq_cst);
+		if (counter.pending.fetch_sub(1, std::memory_order_seq_cst) == 1 && counter.hasContinuations.load(std::memory_order_seq_cst)) {
+			releaseContinuations(counter);
+		}
+		// Last access, waiters may destroy the counter after this
+		counter.signalling.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	void S_JobSystem::recordException(S_Counter& counter, std::exception_ptr exception) {
+		std::lock_guard<std::mutex> lock(counter.exceptionMutex);
+		if (!counter.exception) {
+			counter.exception = std::move(exception);
+		}
+	}
+
+	void S_JobSystem::execute(S_Job* job) {
+		S_Counter* counter = job->counter;
+		try {
+			job->invoke(*job);
+		}
+		catch (...) {
+			// Caught so the counter still resolves and waiters do not hang; waitForCounter rethrows it
+			if (counter) {
+				recordException(*counter, std::current_exception());
+			}
+			else {
+				std::string what = "unknown exception";
+				try {
+					throw;
+				}
+				catch (const std::exception& e) {
+					what = e.what();
+				}
+				catch (...) {
+				}
+				instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::WARNING, "spectra::core::jobs", "S_JobSystem", "Job without a counter threw an exception", what);
+			}
+		}
+
+		releaseJob(job);
+		if (counter) {
+			signal(*counter);
+		}
+
+		const int32_t index = tlsThreadIndex;
+		if (index >= 0 && static_cast<size_t>(index) < workers.size()) {
+			workers[index]->jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	S_Job* S_JobSystem::findJob(int32_t index) {
+		if (index >= 0) {
+			if (S_Job* job = workers[index]->deque.pop()) {
+				return job;
+			}
+		}
+
+		if (injectionSize.load(std::memory_order_acquire) > 0) {
+			std::lock_guard<std::mutex> lock(injectionMutex);
+			if (!injectionQueue.empty()) {
+				S_Job* job = injectionQueue.front();
+				injectionQueue.pop_front();
+				injectionSize.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		return steal(index);
+	}
+
+	S_Job* S_JobSystem::steal(int32_t index) {
+		const uint32_t count = static_cast<uint32_t>(workers.size());
+		if (count == 0 || (count == 1 && index == 0)) {
+			return nullptr;
+		}
+
+		S_WorkerContext* self = index >= 0 ? workers[index].get() : nullptr;
+		uint32_t& randomState = self ? self->randomState : tlsForeignSeed;
+		const uint32_t start = nextRandom(randomState) % count;
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint32_t victim = (start + i) % count;
+			if (static_cast<int32_t>(victim) == index) {
+				continue;
+			}
+
+			if (self) {
+				self->stealAttempts.fetch_add(1, std::memory_order_relaxed);
+			}
+			if (S_Job* job = workers[victim]->deque.steal()) {
+				if (self) {
+					self->jobsStolen.fetch_add(1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	bool S_JobSystem::shouldSplit() const {
+		if (workers.size() <= 1) {
+			return false;
+		}
+
+		const int32_t index = tlsThreadIndex;
+		if (index < 0 || static_cast<size_t>(index) >= workers.size()) {
+			return injectionSize.load(std::memory_order_relaxed) == 0;
+		}
+		return workers[index]->deque.sizeApprox() == 0;
+	}
+
+	bool S_JobSystem::hasVisibleWork() const {
+		if (injectionSize.load(std::memory_order_relaxed) > 0) {
+			return true;
+		}
+		for (const auto& worker : workers) {
+			if (worker->deque.sizeApprox() > 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void S_JobSystem::wakeWorkers(bool all) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wakeEpoch.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (all) {
+			sleepCondition.notify_all();
+		}
+		else {
+			sleepCondition.notify_one();
+		}
+	}
+
+	void S_JobSystem::sleepUntilWork(S_WorkerContext& self) {
+		const auto start = std::chrono::steady_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			const uint64_t epoch = wakeEpoch.load(std::memory_order_relaxed);
+			sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			if (!hasVisibleWork()) {
+				sleepCondition.wait_for(lock, SLEEP_TIMEOUT, [&]() {
+					return stopping.load(std::memory_order_acquire) || wakeEpoch.load(std::memory_order_relaxed) != epoch;
+				});
+			}
+			sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+		}
+		self.idleNanoseconds.fetch_add(nanosecondsSince(start), std::memory_order_relaxed);
+	}
+
+	void S_JobSystem::workerLoop(uint32_t index) {
+		tlsThreadIndex = static_cast<int32_t>(index);
+		S_WorkerContext& self = *workers[index];
+
+		uint32_t failedRounds = 0;
+		while (!stopping.load(std::memory_order_acquire)) {
+			if (S_Job* job = findJob(static_cast<int32_t>(index))) {
+				execute(job);
+				failedRounds = 0;
+				continue;
+			}
+
+			if (++failedRounds < SPIN_ROUNDS) {
+				std::this_thread::yield();
+				continue;
+			}
+			failedRounds = 0;
+			sleepUntilWork(self);
+		}
+
+		tlsThreadIndex = -1;
+	}
+
+	void S_JobSystem::waitForCounter(S_Counter& counter) {
+		// Every job has signalled, so no other thread touches the exception any more
+		auto rethrow = [&counter]() {
+			if (counter.exception) {
+				std::rethrow_exception(std::exchange(counter.exception, nullptr));
+			}
+		};
+
+		if (counter.isDone()) {
+			rethrow();
+			return;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const int32_t index = tlsThreadIndex;
+		while (!counter.isDone()) {
+			if (S_Job* job = findJob(index)) {
+				execute(job);
+				continue;
+			}
+			std::this_thread::yield();
+		}
+
+		if (index >= 0 && static_cast<size_t>(index) < workers.size()) {
+			workers[index]->waitNanoseconds.fetch_add(nanosecondsSince(start), std::memory_order_relaxed);
+		}
+		rethrow();
+	}
+
+	bool S_JobSystem::executeNext() {
+		if (!isRunning()) {
+			return false;
+		}
+		if (S_Job* job = findJob(tlsThreadIndex)) {
+			execute(job);
+			return true;
+		}
+		return false;
+	}
+
+	S_JobSystemStats S_JobSystem::getStats() const {
+		S_JobSystemStats stats;
+		stats.threadCount = getThreadCount();
+		stats.jobsInjected = jobsInjected.load(std::memory_order_relaxed);
+		stats.continuationsReleased = continuationsReleased.load(std::memory_order_relaxed);
+
+		uint64_t idleNanoseconds = 0;
+		uint64_t waitNanoseconds = 0;
+		for (const auto& worker : workers) {
+			const uint64_t executed = worker->jobsExecuted.load(std::memory_order_relaxed);
+			stats.jobsPerThread.push_back(executed);
+			stats.jobsExecuted += executed;
+			stats.jobsStolen += worker->jobsStolen.load(std::memory_order_relaxed);
+			stats.stealAttempts += worker->stealAttempts.load(std::memory_order_relaxed);
+			stats.inlineExecutions += worker->inlineExecutions.load(std::memory_order_relaxed);
+			idleNanoseconds += worker->idleNanoseconds.load(std::memory_order_relaxed);
+			waitNanoseconds += worker->waitNanoseconds.load(std::memory_order_relaxed);
+		}
+		stats.idleMilliseconds = static_cast<double>(idleNanoseconds) / 1.0e6;
+		stats.waitMilliseconds = static_cast<double>(waitNanoseconds) / 1.0e6;
+		return stats;
+	}
+
+	void S_JobSystem::resetStats() {
+		jobsInjected.store(0, std::memory_order_relaxed);
+		continuationsReleased.store(0, std::memory_order_relaxed);
+		for (const auto& worker : workers) {
+			worker->jobsExecuted.store(0, std::memory_order_relaxed);
+			worker->jobsStolen.store(0, std::memory_order_relaxed);
+			worker->stealAttempts.store(0, std::memory_order_relaxed);
+			worker->inlineExecutions.store(0, std::memory_order_relaxed);
+			worker->idleNanoseconds.store(0, std::memory_order_relaxed);
+			worker->waitNanoseconds.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void S_JobSystem::publishStats() const {
+		using instrumentation::Instrumentation;
+		const S_JobSystemStats stats = getStats();
+		const std::string category = "spectra::core::jobs";
+		Instrumentation::setGauge(category, "threadCount", stats.threadCount);
+		Instrumentation::setGauge(category, "jobsExecuted", static_cast<double>(stats.jobsExecuted));
+		Instrumentation::setGauge(category, "jobsStolen", static_cast<double>(stats.jobsStolen));
+		Instrumentation::setGauge(category, "stealAttempts", static_cast<double>(stats.stealAttempts));
+		Instrumentation::setGauge(category, "jobsInjected", static_cast<double>(stats.jobsInjected));
+		Instrumentation::setGauge(category, "inlineExecutions", static_cast<double>(stats.inlineExecutions));
+		Instrumentation::setGauge(category, "continuationsReleased", static_cast<double>(stats.continuationsReleased));
+		Instrumentation::setGauge(category, "idleMilliseconds", stats.idleMilliseconds);
+		Instrumentation::setGauge(category, "waitMilliseconds", stats.waitMilliseconds);
+		for (size_t i = 0; i < stats.jobsPerThread.size(); ++i) {
+			Instrumentation::setGauge(category, "jobsExecuted.thread" + std::to_string(i), static_cast<double>(stats.jobsPerThread[i]));
+		}
+	}
+}
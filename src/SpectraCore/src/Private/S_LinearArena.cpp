@@ -0,0 +1,141 @@
+#include "S_LinearArena.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+
+namespace spectra::core::memory {
+	// S_LinearArena implementations
+	S_LinearArena::S_LinearArena(size_t blockSize, E_MemoryTag tag, std::pmr::memory_resource* upstream)
+		: blockSize(std::max<size_t>(blockSize, 64)), tag(tag), upstream(upstream) {}
+
+	S_LinearArena::~S_LinearArena() {
+		S_ArenaBlock* block = firstBlock;
+		while (block) {
+			S_ArenaBlock* next = block->next;
+			const size_t bytes = sizeof(S_ArenaBlock) + block->capacity;
+			upstream->deallocate(block, bytes, alignof(std::max_align_t));
+			S_MemoryTracker::recordDeallocation(tag, bytes);
+			block = next;
+		}
+	}
+
+	void* S_LinearArena::allocateSlow(size_t bytes, size_t alignment) {
+		if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::memory", "S_LinearArena", "Alignment must be a power of two", static_cast<uint64_t>(alignment));
+		}
+
+		peakUsedBytes = std::max(peakUsedBytes, getUsedBytes());
+		const size_t required = bytes + alignment;
+
+		// Reuse a block kept from before the last reset when it is large enough
+		S_ArenaBlock* next = currentBlock ? currentBlock->next : firstBlock;
+		if (!next || next->capacity < required) {
+			const size_t capacity = std::max(blockSize, alignUp(required, alignof(std::max_align_t)));
+			const size_t allocationBytes = sizeof(S_ArenaBlock) + capacity;
+			auto* block = static_cast<S_ArenaBlock*>(upstream->allocate(allocationBytes, alignof(std::max_align_t)));
+			S_MemoryTracker::recordAllocation(tag, allocationBytes);
+			reservedBytes += allocationBytes;
+
+			block->capacity = capacity;
+			block->next = next;
+			if (currentBlock) {
+				currentBlock->next = block;
+			}
+			else {
+				firstBlock = block;
+			}
+			next = block;
+		}
+
+		if (currentBlock) {
+			previousBlocksBytes += currentBlock->capacity;
+		}
+		currentBlock = next;
+		offset = 0;
+
+		void* result = allocateRaw(bytes, alignment);
+		peakUsedBytes = std::max(peakUsedBytes, getUsedBytes());
+		return result;
+	}
+
+	S_ArenaMarker S_LinearArena::getMarker() const {
+		return { currentBlock, offset, previousBlocksBytes };
+	}
+
+	void S_LinearArena::resetToMarker(const S_ArenaMarker& marker) {
+		peakUsedBytes = std::max(peakUsedBytes, getUsedBytes());
+		currentBlock = static_cast<S_ArenaBlock*>(marker.block);
+		offset = marker.offset;
+		previousBlocksBytes = marker.previousBlocksBytes;
+	}
+
+	void S_LinearArena::reset() {
+		resetToMarker({ firstBlock, 0, 0 });
+	}
+
+	size_t S_LinearArena::getUsedBytes() const {
+		return previousBlocksBytes + offset;
+	}
+
+	size_t S_LinearArena::getReservedBytes() const {
+		return reservedBytes;
+	}
+
+	size_t S_LinearArena::getPeakUsedBytes() const {
+		return std::max(peakUsedBytes, getUsedBytes());
+	}
+
+	E_MemoryTag S_LinearArena::getTag() const {
+		return tag;
+	}
+
+	void* S_LinearArena::do_allocate(size_t bytes, size_t alignment) {
+		return allocateRaw(bytes, alignment);
+	}
+
+	void S_LinearArena::do_deallocate(void*, size_t, size_t) {
+		// Released in bulk by reset()
+	}
+
+	bool S_LinearArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+		return this == &other;
+	}
+
+	// S_FrameArenas implementations
+	S_FrameArenas::S_FrameArenas(size_t framesInFlight, size_t blockSize, E_MemoryTag tag) {
+		framesInFlight = std::max<size_t>(framesInFlight, 1);
+		for (size_t i = 0; i < framesInFlight; ++i) {
+			arenas.push_back(std::make_unique<S_LinearArena>(blockSize, tag));
+		}
+	}
+
+	S_LinearArena& S_FrameArenas::beginFrame() {
+		currentIndex = (currentIndex + 1) % arenas.size();
+		arenas[currentIndex]->reset();
+		return *arenas[currentIndex];
+	}
+
+	S_LinearArena& S_FrameArenas::current() {
+		return *arenas[currentIndex];
+	}
+
+	size_t S_FrameArenas::getFramesInFlight() const {
+		return arenas.size();
+	}
+
+	// S_ScratchScope implementations
+	S_ScratchScope::S_ScratchScope() : arena(getThreadArena()), marker(arena.getMarker()) {}
+
+	S_ScratchScope::~S_ScratchScope() {
+		arena.resetToMarker(marker);
+	}
+
+	S_LinearArena& S_ScratchScope::getArena() {
+		return arena;
+	}
+
+	S_LinearArena& S_ScratchScope::getThreadArena() {
+		thread_local S_LinearArena threadArena(SCRATCH_BLOCK_SIZE, E_MemoryTag::SCRATCH);
+		return threadArena;
+	}
+}
@@ -0,0 +1,132 @@
+#include "S_MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace spectra::core::platform {
+	S_MappedFile::~S_MappedFile() {
+		close();
+	}
+
+	S_MappedFile::S_MappedFile(S_MappedFile&& other) noexcept
+		: data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)), fileHandle(std::exchange(other.fileHandle, nullptr)),
+		mappingHandle(std::exchange(other.mappingHandle, nullptr)), path(std::move(other.path)), lastError(std::move(other.lastError)) {}
+
+	S_MappedFile& S_MappedFile::operator=(S_MappedFile&& other) noexcept {
+		if (this != &other) {
+			close();
+			data = std::exchange(other.data, nullptr);
+			size = std::exchange(other.size, 0);
+			fileHandle = std::exchange(other.fileHandle, nullptr);
+			mappingHandle = std::exchange(other.mappingHandle, nullptr);
+			path = std::move(other.path);
+			lastError = std::move(other.lastError);
+		}
+		return *this;
+	}
+
+	bool S_MappedFile::open(const std::string& filePath) {
+		close();
+		path = filePath;
+#if defined(_WIN32)
+		const HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			lastError = "CreateFile failed with error " + std::to_string(GetLastError());
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			lastError = "File is empty or its size is unavailable";
+			CloseHandle(file);
+			return false;
+		}
+		const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) {
+			lastError = "CreateFileMapping failed with error " + std::to_string(GetLastError());
+			CloseHandle(file);
+			return false;
+		}
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view) {
+			lastError = "MapViewOfFile failed with error " + std::to_string(GetLastError());
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		fileHandle = file;
+		mappingHandle = mapping;
+		data = static_cast<const std::byte*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		const int file = ::open(filePath.c_str(), O_RDONLY);
+		if (file < 0) {
+			lastError = std::string("open failed: ") + std::strerror(errno);
+			return false;
+		}
+		struct stat status;
+		if (fstat(file, &status) != 0 || status.st_size == 0) {
+			lastError = "File is empty or its size is unavailable";
+			::close(file);
+			return false;
+		}
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file);  // The mapping keeps the file referenced
+		if (view == MAP_FAILED) {
+			lastError = std::string("mmap failed: ") + std::strerror(errno);
+			return false;
+		}
+		data = static_cast<const std::byte*>(view);
+		size = static_cast<size_t>(status.st_size);
+#endif
+		return true;
+	}
+
+	void S_MappedFile::close() {
+		if (!data) {
+			return;
+		}
+#if defined(_WIN32)
+		UnmapViewOfFile(data);
+		CloseHandle(static_cast<HANDLE>(mappingHandle));
+		CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+		munmap(const_cast<std::byte*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+		fileHandle = nullptr;
+		mappingHandle = nullptr;
+	}
+
+	bool S_MappedFile::isOpen() const {
+		return data != nullptr;
+	}
+
+	const std::byte* S_MappedFile::getData() const {
+		return data;
+	}
+
+	size_t S_MappedFile::getSize() const {
+		return size;
+	}
+
+	const std::string& S_MappedFile::getPath() const {
+		return path;
+	}
+
+	const std::string& S_MappedFile::getLastError() const {
+		return lastError;
+	}
+}
@@ -0,0 +1,116 @@
+#include "S_MemoryTracker.h"
+#include "SpectraInstrumentation.h"
+
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace spectra::core::memory {
+	namespace {
+		struct alignas(64) S_TagCounters {
+			std::atomic<uint64_t> currentBytes{ 0 };
+			std::atomic<uint64_t> peakBytes{ 0 };
+			std::atomic<uint64_t> activeAllocations{ 0 };
+			std::atomic<uint64_t> totalAllocations{ 0 };
+		};
+
+		std::array<S_TagCounters, static_cast<size_t>(E_MemoryTag::COUNT)>& tagCounters() {
+			static std::array<S_TagCounters, static_cast<size_t>(E_MemoryTag::COUNT)> counters;
+			return counters;
+		}
+
+		S_TagCounters& countersFor(E_MemoryTag tag) {
+			const size_t index = static_cast<size_t>(tag) < static_cast<size_t>(E_MemoryTag::COUNT)
+				? static_cast<size_t>(tag)
+				: static_cast<size_t>(E_MemoryTag::GENERAL);
+			return tagCounters()[index];
+		}
+	}
+
+	// S_MemoryTracker implementations
+	void S_MemoryTracker::recordAllocation(E_MemoryTag tag, size_t bytes) {
+		S_TagCounters& counters = countersFor(tag);
+		const uint64_t current = counters.currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		counters.activeAllocations.fetch_add(1, std::memory_order_relaxed);
+		counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+		while (current > peak && !counters.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+		}
+	}
+
+	void S_MemoryTracker::recordDeallocation(E_MemoryTag tag, size_t bytes, size_t allocations) {
+		S_TagCounters& counters = countersFor(tag);
+		counters.currentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		counters.activeAllocations.fetch_sub(allocations, std::memory_order_relaxed);
+	}
+
+	S_MemoryTagStats S_MemoryTracker::getStats(E_MemoryTag tag) {
+		const S_TagCounters& counters = countersFor(tag);
+		S_MemoryTagStats stats;
+		stats.currentBytes = counters.currentBytes.load(std::memory_order_relaxed);
+		stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+		stats.activeAllocations = counters.activeAllocations.load(std::memory_order_relaxed);
+		stats.totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	const char* S_MemoryTracker::getTagName(E_MemoryTag tag) {
+		switch (tag) {
+		case E_MemoryTag::GENERAL: return "GENERAL";
+		case E_MemoryTag::JOBS: return "JOBS";
+		case E_MemoryTag::SCRATCH: return "SCRATCH";
+		case E_MemoryTag::RENDER: return "RENDER";
+		case E_MemoryTag::GEOMETRY: return "GEOMETRY";
+		case E_MemoryTag::TEXTURES: return "TEXTURES";
+		case E_MemoryTag::MATERIALS: return "MATERIALS";
+		case E_MemoryTag::SCENE: return "SCENE";
+		case E_MemoryTag::STREAMING: return "STREAMING";
+		case E_MemoryTag::UI: return "UI";
+		case E_MemoryTag::COUNT: break;
+		}
+		return "UNKNOWN";
+	}
+
+	void S_MemoryTracker::publishStats() {
+		using instrumentation::Instrumentation;
+		const std::string category = "spectra::core::memory";
+		for (size_t i = 0; i < static_cast<size_t>(E_MemoryTag::COUNT); ++i) {
+			const auto tag = static_cast<E_MemoryTag>(i);
+			const S_MemoryTagStats stats = getStats(tag);
+			if (stats.totalAllocations == 0) {
+				continue;
+			}
+
+			const std::string prefix = getTagName(tag);
+			Instrumentation::setGauge(category, prefix + ".currentBytes", static_cast<double>(stats.currentBytes));
+			Instrumentation::setGauge(category, prefix + ".peakBytes", static_cast<double>(stats.peakBytes));
+			Instrumentation::setGauge(category, prefix + ".activeAllocations", static_cast<double>(stats.activeAllocations));
+			Instrumentation::setGauge(category, prefix + ".totalAllocations", static_cast<double>(stats.totalAllocations));
+		}
+	}
+
+	// S_TrackedResource implementations
+	S_TrackedResource::S_TrackedResource(E_MemoryTag tag, std::pmr::memory_resource* upstream)
+		: tag(tag), upstream(upstream) {}
+
+	E_MemoryTag S_TrackedResource::getTag() const {
+		return tag;
+	}
+
+	void* S_TrackedResource::do_allocate(size_t bytes, size_t alignment) {
+		void* pointer = upstream->allocate(bytes, alignment);
+		S_MemoryTracker::recordAllocation(tag, bytes);
+		return pointer;
+	}
+
+	void S_TrackedResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+		upstream->deallocate(pointer, bytes, alignment);
+		S_MemoryTracker::recordDeallocation(tag, bytes);
+	}
+
+	bool S_TrackedResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+		// Only the same instance, otherwise frees would be attributed to the wrong tag
+		return this == &other;
+	}
+}
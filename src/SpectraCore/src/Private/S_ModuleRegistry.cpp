@@ -0,0 +1,478 @@
+#include "S_ModuleRegistry.h"
+#include "S_JobSystem.h"
+#include "S_SharedLibrary.h"
+#include "SpectraInstrumentation.h"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace spectra::core::modules {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::core::modules";
+
+		enum : uint8_t {
+			UNVISITED = 0,
+			VISITING,
+			VISITED
+		};
+
+		double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+			return std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		const char* getStateName(E_ModuleState state) {
+			switch (state) {
+			case E_ModuleState::REGISTERED: return "not loaded";
+			case E_ModuleState::INITIALIZING: return "initializing";
+			case E_ModuleState::READY: return "ready";
+			case E_ModuleState::FAILED: return "failed";
+			case E_ModuleState::SHUTDOWN: return "shut down";
+			}
+			return "unknown";
+		}
+	}
+
+	struct S_ModuleRecord {
+		S_ModuleDesc desc;
+		std::vector<S_ModuleRecord*> dependencies;
+		std::vector<S_ModuleRecord*> dependents;
+		size_t index = 0;
+		std::atomic<E_ModuleState> state{ E_ModuleState::REGISTERED };
+		std::atomic<int32_t> remainingDependencies{ 0 };
+		std::atomic<bool> scheduled{ false };  // Owned by a running initializeAll()
+		ModuleFunction initFunction = nullptr;
+		ModuleFunction shutdownFunction = nullptr;
+		platform::S_SharedLibrary library;
+		S_ModuleTiming timing;
+		std::string error;
+	};
+
+	// S_ModuleRegistry implementations
+	S_ModuleRegistry& S_ModuleRegistry::getInstance() {
+		static S_ModuleRegistry instance;
+		return instance;
+	}
+
+	S_ModuleRegistry::S_ModuleRegistry() : creationTime(std::chrono::steady_clock::now()) {}
+
+	// Libraries close through S_SharedLibrary, shutdown functions only run from shutdownAll()
+	S_ModuleRegistry::~S_ModuleRegistry() = default;
+
+	void S_ModuleRegistry::registerModule(S_ModuleDesc desc) {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		if (recordIndices.contains(desc.name)) {
+			Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", "registerModule", "Module registered twice", desc.name);
+		}
+		if (!desc.init && desc.initSymbol.empty() && desc.libraryName.empty()) {
+			Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", "registerModule", "Module has neither an init function nor a library", desc.name);
+		}
+		if (desc.load == E_ModuleLoad::LAZY && desc.libraryName.empty()) {
+			Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", "registerModule", "Lazy module needs a library name", desc.name);
+		}
+
+		auto record = std::make_unique<S_ModuleRecord>();
+		record->index = records.size();
+		record->initFunction = desc.init;
+		record->shutdownFunction = desc.shutdown;
+		record->timing.name = desc.name;
+		record->timing.lazy = desc.load == E_ModuleLoad::LAZY;
+		record->desc = std::move(desc);
+
+		recordIndices.emplace(record->desc.name, record->index);
+		records.push_back(std::move(record));
+	}
+
+	S_ModuleRecord* S_ModuleRegistry::find(const std::string& name) const {
+		const auto it = recordIndices.find(name);
+		return it == recordIndices.end() ? nullptr : records[it->second].get();
+	}
+
+	void S_ModuleRegistry::resolveDependencies() {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		for (const auto& record : records) {
+			record->dependencies.clear();
+			record->dependents.clear();
+		}
+		for (const auto& record : records) {
+			for (const std::string& dependencyName : record->desc.dependencies) {
+				S_ModuleRecord* dependency = find(dependencyName);
+				if (!dependency) {
+					Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", "resolveDependencies",
+						"Module depends on an unregistered module", record->desc.name, dependencyName);
+				}
+				record->dependencies.push_back(dependency);
+				dependency->dependents.push_back(record.get());
+			}
+		}
+	}
+
+	// Depth-first post-order, so every module lands after its dependencies. Ready modules
+	// are skipped along with their subtrees, they have nothing left to initialize.
+	void S_ModuleRegistry::collectClosure(S_ModuleRecord* record, std::vector<S_ModuleRecord*>& closure, std::vector<uint8_t>& visited) const {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		if (visited[record->index] == VISITED) {
+			return;
+		}
+		if (visited[record->index] == VISITING) {
+			Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", "collectClosure", "Module dependency cycle", record->desc.name);
+		}
+		if (record->state.load(std::memory_order_acquire) == E_ModuleState::READY) {
+			visited[record->index] = VISITED;
+			return;
+		}
+
+		visited[record->index] = VISITING;
+		for (S_ModuleRecord* dependency : record->dependencies) {
+			collectClosure(dependency, closure, visited);
+		}
+		visited[record->index] = VISITED;
+		closure.push_back(record);
+	}
+
+	void S_ModuleRegistry::initializeAll() {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		std::call_once(resolveFlag, [this]() { resolveDependencies(); });
+
+		std::vector<S_ModuleRecord*> batch;
+		std::vector<uint8_t> visited(records.size(), UNVISITED);
+		for (const auto& record : records) {
+			if (record->desc.load == E_ModuleLoad::EAGER && record->state.load(std::memory_order_acquire) == E_ModuleState::REGISTERED) {
+				collectClosure(record.get(), batch, visited);
+			}
+		}
+		if (batch.empty()) {
+			return;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		for (S_ModuleRecord* record : batch) {
+			record->scheduled.store(true, std::memory_order_relaxed);
+		}
+		for (S_ModuleRecord* record : batch) {
+			int32_t remaining = 0;
+			for (S_ModuleRecord* dependency : record->dependencies) {
+				remaining += dependency->scheduled.load(std::memory_order_relaxed) ? 1 : 0;
+			}
+			record->remainingDependencies.store(remaining, std::memory_order_relaxed);
+		}
+		pendingModules.store(batch.size(), std::memory_order_release);
+
+		for (S_ModuleRecord* record : batch) {
+			if (record->remainingDependencies.load(std::memory_order_relaxed) == 0) {
+				dispatch(record);
+			}
+		}
+
+		// The calling thread runs main-thread-only modules and otherwise helps with jobs.
+		// SpectraCore starts the job system from here, so the first modules always run inline.
+		auto& jobSystem = jobs::S_JobSystem::getInstance();
+		while (pendingModules.load(std::memory_order_acquire) > 0) {
+			S_ModuleRecord* next = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(mainQueueMutex);
+				if (!mainQueue.empty()) {
+					next = mainQueue.back();
+					mainQueue.pop_back();
+				}
+			}
+			if (next) {
+				runModule(next);
+				finishModule(next);
+				continue;
+			}
+			if (!jobSystem.executeNext()) {
+				std::this_thread::yield();
+			}
+		}
+
+		for (S_ModuleRecord* record : batch) {
+			record->scheduled.store(false, std::memory_order_release);
+		}
+		startupWallMilliseconds = millisecondsBetween(start, std::chrono::steady_clock::now());
+		startupThreadCount = jobSystem.getThreadCount();
+
+		Instrumentation::logCore(E_LogLevel::INFO, "S_ModuleRegistry", "initializeAll", "Module startup finished",
+			static_cast<uint64_t>(batch.size()), startupWallMilliseconds);
+		publishTimings();
+		reportFailures(batch, "initializeAll");
+	}
+
+	void S_ModuleRegistry::dispatch(S_ModuleRecord* record) {
+		auto& jobSystem = jobs::S_JobSystem::getInstance();
+		if (!record->desc.mainThreadOnly && jobSystem.isRunning()) {
+			jobSystem.run([this, record]() {
+				runModule(record);
+				finishModule(record);
+			});
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mainQueueMutex);
+		mainQueue.push_back(record);
+	}
+
+	void S_ModuleRegistry::runModule(S_ModuleRecord* record) {
+		bool dependencyFailed = false;
+		for (S_ModuleRecord* dependency : record->dependencies) {
+			dependencyFailed |= dependency->state.load(std::memory_order_acquire) != E_ModuleState::READY;
+		}
+
+		if (dependencyFailed) {
+			record->error = "a dependency failed to initialize";
+			record->state.store(E_ModuleState::FAILED, std::memory_order_release);
+		}
+		else {
+			initializeModule(record);
+		}
+	}
+
+	// Releases dependents before dropping the pending count, initializeAll() returns once it hits zero
+	void S_ModuleRegistry::finishModule(S_ModuleRecord* record) {
+		for (S_ModuleRecord* dependent : record->dependents) {
+			if (dependent->scheduled.load(std::memory_order_relaxed)
+				&& dependent->remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				dispatch(dependent);
+			}
+		}
+		pendingModules.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	void S_ModuleRegistry::initializeModule(S_ModuleRecord* record) {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		record->error.clear();
+		record->state.store(E_ModuleState::INITIALIZING, std::memory_order_release);
+		const auto start = std::chrono::steady_clock::now();
+		record->timing.startMilliseconds = millisecondsBetween(creationTime, start);
+		record->timing.threadIndex = jobs::S_JobSystem::getCurrentThreadIndex();
+
+		try {
+			const S_ModuleDesc& desc = record->desc;
+			if (!desc.libraryName.empty() && !record->library.isOpen()) {
+				// Next to the executable first, then the platform's library search path
+				const std::string fileName = platform::S_SharedLibrary::getPlatformFileName(desc.libraryName);
+				if (!record->library.open(platform::S_SharedLibrary::getExecutableDirectory() + fileName)
+					&& !record->library.open(fileName)) {
+					throw std::runtime_error("Cannot load " + fileName + ": " + record->library.getLastError());
+				}
+				record->timing.loadMilliseconds = millisecondsBetween(start, std::chrono::steady_clock::now());
+			}
+			if (!record->initFunction && !desc.initSymbol.empty()) {
+				record->initFunction = reinterpret_cast<ModuleFunction>(record->library.getSymbol(desc.initSymbol));
+				if (!record->initFunction) {
+					throw std::runtime_error(record->library.getLastError());
+				}
+			}
+			if (!record->shutdownFunction && !desc.shutdownSymbol.empty()) {
+				record->shutdownFunction = reinterpret_cast<ModuleFunction>(record->library.getSymbol(desc.shutdownSymbol));
+				if (!record->shutdownFunction) {
+					throw std::runtime_error(record->library.getLastError());
+				}
+			}
+
+			if (record->initFunction) {
+				record->initFunction();
+			}
+		}
+		catch (const std::exception& exception) {
+			record->error = exception.what();
+		}
+
+		record->timing.initMilliseconds = millisecondsBetween(start, std::chrono::steady_clock::now());
+		if (!record->error.empty()) {
+			record->state.store(E_ModuleState::FAILED, std::memory_order_release);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(orderMutex);
+			initializationOrder.push_back(record);
+		}
+		record->state.store(E_ModuleState::READY, std::memory_order_release);
+
+		Instrumentation::recordTiming(STATS_CATEGORY, record->desc.name, record->timing.initMilliseconds);
+		Instrumentation::logCore(E_LogLevel::DEBUG, "S_ModuleRegistry", "initializeModule", "Module initialized",
+			record->desc.name, record->timing.initMilliseconds, static_cast<int>(record->timing.threadIndex));
+	}
+
+	void S_ModuleRegistry::require(const std::string& name) {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		S_ModuleRecord* record = find(name);
+		if (!record) {
+			Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", "require", "Unknown module", name);
+		}
+		if (record->state.load(std::memory_order_acquire) == E_ModuleState::READY) {
+			return;
+		}
+
+		std::call_once(resolveFlag, [this]() { resolveDependencies(); });
+
+		std::lock_guard<std::mutex> lock(requireMutex);
+		std::vector<S_ModuleRecord*> closure;
+		std::vector<uint8_t> visited(records.size(), UNVISITED);
+		collectClosure(record, closure, visited);
+
+		// Serial on the calling thread: a lazy load is usually a single library
+		for (S_ModuleRecord* module : closure) {
+			if (module->scheduled.load(std::memory_order_acquire)) {
+				waitWhileScheduled(module);
+				continue;
+			}
+			if (module->state.load(std::memory_order_acquire) == E_ModuleState::READY) {
+				continue;
+			}
+			runModule(module);
+		}
+		reportFailures(closure, "require");
+	}
+
+	// The module belongs to an initializeAll() in flight, e.g. require() from a module's init
+	void S_ModuleRegistry::waitWhileScheduled(S_ModuleRecord* record) {
+		auto& jobSystem = jobs::S_JobSystem::getInstance();
+		while (true) {
+			const E_ModuleState state = record->state.load(std::memory_order_acquire);
+			if (state == E_ModuleState::READY || state == E_ModuleState::FAILED) {
+				return;
+			}
+			if (!jobSystem.executeNext()) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void S_ModuleRegistry::reportFailures(const std::vector<S_ModuleRecord*>& modules, const char* subComponent) const {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		std::string failures;
+		for (const S_ModuleRecord* record : modules) {
+			if (record->state.load(std::memory_order_acquire) == E_ModuleState::FAILED) {
+				failures += (failures.empty() ? "" : "; ") + record->desc.name + ": " + record->error;
+			}
+		}
+		if (!failures.empty()) {
+			Instrumentation::logCore(E_LogLevel::ERROR, "S_ModuleRegistry", subComponent, "Modules failed to initialize", failures);
+		}
+	}
+
+	void S_ModuleRegistry::shutdownAll() {
+		using spectra::instrumentation::Instrumentation;
+		using spectra::instrumentation::E_LogLevel;
+
+		std::vector<S_ModuleRecord*> order;
+		{
+			std::lock_guard<std::mutex> lock(orderMutex);
+			order.swap(initializationOrder);
+		}
+
+		for (auto it = order.rbegin(); it != order.rend(); ++it) {
+			S_ModuleRecord* record = *it;
+			try {
+				if (record->shutdownFunction) {
+					record->shutdownFunction();
+				}
+			}
+			catch (const std::exception& exception) {
+				Instrumentation::logCore(E_LogLevel::WARNING, "S_ModuleRegistry", "shutdownAll", "Module shutdown threw", record->desc.name, exception.what());
+			}
+			record->state.store(E_ModuleState::SHUTDOWN, std::memory_order_release);
+
+			// Symbols die with the library
+			if (record->library.isOpen()) {
+				record->initFunction = record->desc.init;
+				record->shutdownFunction = record->desc.shutdown;
+				record->library.close();
+			}
+		}
+	}
+
+	bool S_ModuleRegistry::isRegistered(const std::string& name) const {
+		return find(name) != nullptr;
+	}
+
+	E_ModuleState S_ModuleRegistry::getState(const std::string& name) const {
+		const S_ModuleRecord* record = find(name);
+		return record ? record->state.load(std::memory_order_acquire) : E_ModuleState::REGISTERED;
+	}
+
+	std::vector<S_ModuleTiming> S_ModuleRegistry::getTimings() const {
+		std::vector<S_ModuleTiming> timings;
+		timings.reserve(records.size());
+		std::vector<uint8_t> listed(records.size(), 0);
+		{
+			std::lock_guard<std::mutex> lock(orderMutex);
+			for (const S_ModuleRecord* record : initializationOrder) {
+				timings.push_back(record->timing);
+				timings.back().state = record->state.load(std::memory_order_acquire);
+				listed[record->index] = 1;
+			}
+		}
+		for (const auto& record : records) {
+			if (!listed[record->index]) {
+				timings.push_back(record->timing);
+				timings.back().state = record->state.load(std::memory_order_acquire);
+			}
+		}
+		return timings;
+	}
+
+	std::string S_ModuleRegistry::getStartupReport() const {
+		const std::vector<S_ModuleTiming> timings = getTimings();
+
+		size_t ready = 0;
+		double serialMilliseconds = 0.0;
+		for (const S_ModuleTiming& timing : timings) {
+			if (timing.state == E_ModuleState::READY) {
+				++ready;
+				serialMilliseconds += timing.initMilliseconds;
+			}
+		}
+
+		std::ostringstream report;
+		report << std::fixed << std::setprecision(3);
+		report << "Module startup: " << ready << "/" << timings.size() << " ready in " << startupWallMilliseconds
+			<< " ms on " << startupThreadCount << " threads (" << serialMilliseconds << " ms if serial)\n";
+		for (const S_ModuleTiming& timing : timings) {
+			report << "  " << std::left << std::setw(24) << timing.name << std::right;
+			if (timing.state != E_ModuleState::READY && timing.state != E_ModuleState::SHUTDOWN) {
+				report << " " << (timing.lazy ? "lazy, " : "") << getStateName(timing.state) << "\n";
+				continue;
+			}
+			report << " start " << std::setw(9) << timing.startMilliseconds << " ms"
+				<< "  init " << std::setw(9) << timing.initMilliseconds << " ms"
+				<< "  thread " << timing.threadIndex;
+			if (timing.lazy) {
+				report << "  lazy, load " << timing.loadMilliseconds << " ms";
+			}
+			report << "\n";
+		}
+		return report.str();
+	}
+
+	void S_ModuleRegistry::publishTimings() const {
+		using spectra::instrumentation::Instrumentation;
+
+		size_t ready = 0;
+		size_t failed = 0;
+		for (const auto& record : records) {
+			const E_ModuleState state = record->state.load(std::memory_order_acquire);
+			ready += state == E_ModuleState::READY ? 1 : 0;
+			failed += state == E_ModuleState::FAILED ? 1 : 0;
+		}
+		Instrumentation::setGauge(STATS_CATEGORY, "startupWallMilliseconds", startupWallMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "readyModules", static_cast<double>(ready));
+		Instrumentation::setGauge(STATS_CATEGORY, "failedModules", static_cast<double>(failed));
+	}
+}
@@ -0,0 +1,494 @@
+#include "S_RgbToSpectrum.h"
+#include "S_JobSystem.h"
+#include "S_SharedLibrary.h"
+#include "S_TemporaryPath.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+namespace spectra::core::math {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::core::math::spectrum";
+
+		// Cache layout: header, then the z nodes, then the coefficients, all native floats
+		constexpr char CACHE_MAGIC[8] = { 'S', 'P', 'R', 'G', 'B', 'S', 'P', 'C' };
+		constexpr uint32_t CACHE_VERSION = 1;
+
+		struct S_CacheHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t resolution;
+			uint32_t floatCount;
+			uint32_t reserved;
+		};
+
+		constexpr uint32_t FIT_SAMPLES = 95;  // 5 nm steps over [LAMBDA_MIN, LAMBDA_MAX]
+		constexpr double FIT_STEP = (LAMBDA_MAX - LAMBDA_MIN) / (FIT_SAMPLES - 1);
+
+		size_t getFloatCount(uint32_t resolution) {
+			return resolution + 9 * static_cast<size_t>(resolution) * resolution * resolution;
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		double smoothstep(double x) {
+			return x * x * (3.0 - 2.0 * x);
+		}
+
+		// Spectrum-to-sRGB weights per fitting wavelength under the sRGB white, normalized so a
+		// constant spectrum of 1 integrates to (1, 1, 1)
+		struct S_FitTables {
+			std::array<double, FIT_SAMPLES> lambda;  // Normalized to [0, 1]
+			std::array<double, FIT_SAMPLES> rgb[3];
+			double whiteXYZ[3];
+
+			S_FitTables() {
+				double sums[3] = {};
+				for (uint32_t i = 0; i < FIT_SAMPLES; ++i) {
+					const float nanometres = static_cast<float>(LAMBDA_MIN + i * FIT_STEP);
+					const double weight = (i == 0 || i == FIT_SAMPLES - 1 ? 0.5 : 1.0) * cie::whiteIlluminant(nanometres);
+					const S_Vec3 rgbWeight = xyzToLinearSRGB(S_Vec3(cie::x(nanometres), cie::y(nanometres), cie::z(nanometres)));
+					lambda[i] = (nanometres - LAMBDA_MIN) / (LAMBDA_MAX - LAMBDA_MIN);
+					for (int c = 0; c < 3; ++c) {
+						rgb[c][i] = weight * rgbWeight[c];
+						sums[c] += rgb[c][i];
+					}
+				}
+				for (int c = 0; c < 3; ++c) {
+					for (double& value : rgb[c]) {
+						value /= sums[c];
+					}
+				}
+				const S_Vec3 white = linearSRGBToXYZ(S_Vec3(1.0f));
+				whiteXYZ[0] = white.x;
+				whiteXYZ[1] = white.y;
+				whiteXYZ[2] = white.z;
+			}
+
+			// CIELAB of a linear sRGB colour, with its derivative when jacobian is given. The fit
+			// weighs errors roughly by how visible they are.
+			void toLab(const double rgb[3], double lab[3], double jacobian[3][3] = nullptr) const {
+				constexpr double RGB_TO_XYZ[3][3] = {
+					{ 0.4124564, 0.3575761, 0.1804375 },
+					{ 0.2126729, 0.7151522, 0.0721750 },
+					{ 0.0193339, 0.1191920, 0.9503041 },
+				};
+				constexpr double DELTA = 6.0 / 29.0;
+
+				double f[3];
+				double derivative[3];
+				for (int axis = 0; axis < 3; ++axis) {
+					const double t = (RGB_TO_XYZ[axis][0] * rgb[0] + RGB_TO_XYZ[axis][1] * rgb[1] + RGB_TO_XYZ[axis][2] * rgb[2]) / whiteXYZ[axis];
+					if (t > DELTA * DELTA * DELTA) {
+						f[axis] = std::cbrt(t);
+						derivative[axis] = 1.0 / (3.0 * f[axis] * f[axis] * whiteXYZ[axis]);
+					}
+					else {
+						f[axis] = t / (3.0 * DELTA * DELTA) + 4.0 / 29.0;
+						derivative[axis] = 1.0 / (3.0 * DELTA * DELTA * whiteXYZ[axis]);
+					}
+				}
+				lab[0] = 116.0 * f[1] - 16.0;
+				lab[1] = 500.0 * (f[0] - f[1]);
+				lab[2] = 200.0 * (f[1] - f[2]);
+
+				if (jacobian) {
+					for (int c = 0; c < 3; ++c) {
+						const double dfx = derivative[0] * RGB_TO_XYZ[0][c];
+						const double dfy = derivative[1] * RGB_TO_XYZ[1][c];
+						const double dfz = derivative[2] * RGB_TO_XYZ[2][c];
+						jacobian[0][c] = 116.0 * dfy;
+						jacobian[1][c] = 500.0 * (dfx - dfy);
+						jacobian[2][c] = 200.0 * (dfy - dfz);
+					}
+				}
+			}
+
+			// Lab difference between the target and the colour of the polynomial in normalized
+			// lambda, and its derivative with respect to the coefficients
+			void residual(const double coefficients[3], const double targetLab[3], double out[3], double jacobian[3][3]) const {
+				double rgbSum[3] = {};
+				double rgbDerivative[3][3] = {};  // [channel][coefficient]
+				for (uint32_t i = 0; i < FIT_SAMPLES; ++i) {
+					const double x = (coefficients[0] * lambda[i] + coefficients[1]) * lambda[i] + coefficients[2];
+					const double root = std::sqrt(1.0 + x * x);
+					const double s = 0.5 + x / (2.0 * root);
+					const double slope = 0.5 / (root * root * root);
+					const double powers[3] = { lambda[i] * lambda[i] * slope, lambda[i] * slope, slope };
+					for (int c = 0; c < 3; ++c) {
+						rgbSum[c] += rgb[c][i] * s;
+						for (int j = 0; j < 3; ++j) {
+							rgbDerivative[c][j] += rgb[c][i] * powers[j];
+						}
+					}
+				}
+
+				double lab[3];
+				double labDerivative[3][3];
+				toLab(rgbSum, lab, labDerivative);
+				for (int row = 0; row < 3; ++row) {
+					out[row] = targetLab[row] - lab[row];
+					for (int j = 0; j < 3; ++j) {
+						jacobian[row][j] = -(labDerivative[row][0] * rgbDerivative[0][j] + labDerivative[row][1] * rgbDerivative[1][j]
+							+ labDerivative[row][2] * rgbDerivative[2][j]);
+					}
+				}
+			}
+
+			// Gauss-Newton steps on the residual, starting from coefficients
+			void fit(const double rgbTarget[3], double coefficients[3]) const {
+				double targetLab[3];
+				toLab(rgbTarget, targetLab);
+				for (int iteration = 0; iteration < 15; ++iteration) {
+					double r[3];
+					double jacobian[3][3];
+					residual(coefficients, targetLab, r, jacobian);
+
+					// Cramer's rule on the 3x3 system
+					const auto determinant3 = [](const double m[3][3]) {
+						return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+							+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+					};
+					const double determinant = determinant3(jacobian);
+					if (std::abs(determinant) < 1e-15) {
+						break;
+					}
+					double squaredError = 0.0;
+					for (int j = 0; j < 3; ++j) {
+						double replaced[3][3];
+						std::memcpy(replaced, jacobian, sizeof(replaced));
+						for (int c = 0; c < 3; ++c) {
+							replaced[c][j] = r[c];
+						}
+						coefficients[j] -= determinant3(replaced) / determinant;
+						squaredError += r[j] * r[j];
+					}
+
+					// Keep the sigmoid out of its flat tails, where the Jacobian vanishes
+					const double largest = std::max({ coefficients[0], coefficients[1], coefficients[2] });
+					if (largest > 200.0) {
+						for (int j = 0; j < 3; ++j) {
+							coefficients[j] *= 200.0 / largest;
+						}
+					}
+					if (squaredError < 1e-6) {
+						break;
+					}
+				}
+			}
+		};
+
+		struct S_SharedTable {
+			S_RgbToSpectrumTable table;
+			std::once_flag initialized;
+		};
+
+		S_SharedTable& getSharedTable() {
+			static S_SharedTable shared;
+			return shared;
+		}
+
+		// Per-user cache directory, empty when the environment does not name one
+		std::filesystem::path getUserCacheDirectory() {
+#if defined(_WIN32)
+			if (const char* localAppData = std::getenv("LOCALAPPDATA")) {
+				return std::filesystem::path(localAppData) / "Spectra";
+			}
+#else
+			if (const char* xdgCache = std::getenv("XDG_CACHE_HOME"); xdgCache && *xdgCache) {
+				return std::filesystem::path(xdgCache) / "spectra";
+			}
+			if (const char* home = std::getenv("HOME"); home && *home) {
+				return std::filesystem::path(home) / ".cache" / "spectra";
+			}
+#endif
+			return {};
+		}
+	}
+
+	// S_RgbToSpectrumTable implementations
+	void S_RgbToSpectrumTable::bindOwned() {
+		scale = owned.data();
+		coefficients = owned.data() + resolution;
+	}
+
+	void S_RgbToSpectrumTable::generate(uint32_t tableResolution) {
+		if (tableResolution < 2) {
+			instrumentation::Instrumentation::logMath(instrumentation::E_LogLevel::ERROR, "spectra::core::math", "S_RgbToSpectrumTable",
+				"Resolution must be at least 2", tableResolution);
+		}
+		const auto start = std::chrono::steady_clock::now();
+
+		mapping.close();
+		resolution = tableResolution;
+		owned.assign(getFloatCount(resolution), 0.0f);
+		bindOwned();
+		float* nodes = owned.data();
+		float* output = owned.data() + resolution;
+		for (uint32_t k = 0; k < resolution; ++k) {
+			nodes[k] = static_cast<float>(smoothstep(smoothstep(k / static_cast<double>(resolution - 1))));
+		}
+
+		// One job per (largest channel, y) row; along z each fit starts from its neighbour's
+		// solution, walking out from a fifth of the way up where the fit is easiest
+		static const S_FitTables tables;
+		const uint32_t res = resolution;
+		jobs::S_JobSystem::getInstance().parallelFor(0, 3 * static_cast<size_t>(res), [&](size_t begin, size_t end) {
+			for (size_t row = begin; row < end; ++row) {
+				const uint32_t largest = static_cast<uint32_t>(row / res);
+				const uint32_t j = static_cast<uint32_t>(row % res);
+				const double y = j / static_cast<double>(res - 1);
+				for (uint32_t i = 0; i < res; ++i) {
+					const double x = i / static_cast<double>(res - 1);
+					auto solve = [&](uint32_t k, double coefficients[3]) {
+						const double brightness = nodes[k];
+						double rgb[3];
+						rgb[largest] = brightness;
+						rgb[(largest + 1) % 3] = x * brightness;
+						rgb[(largest + 2) % 3] = y * brightness;
+						tables.fit(rgb, coefficients);
+
+						// Back from normalized lambda to nanometres
+						const double offset = LAMBDA_MIN;
+						const double inverseRange = 1.0 / (LAMBDA_MAX - LAMBDA_MIN);
+						const double a = coefficients[0];
+						const double b = coefficients[1];
+						const double c = coefficients[2];
+						float* entry = output + 3 * (((static_cast<size_t>(largest) * res + k) * res + j) * res + i);
+						entry[0] = static_cast<float>(a * inverseRange * inverseRange);
+						entry[1] = static_cast<float>(b * inverseRange - 2.0 * a * offset * inverseRange * inverseRange);
+						entry[2] = static_cast<float>(c - b * offset * inverseRange + a * offset * offset * inverseRange * inverseRange);
+					};
+
+					const uint32_t startK = res / 5;
+					double coefficients[3] = {};
+					for (uint32_t k = startK; k < res; ++k) {
+						solve(k, coefficients);
+					}
+					coefficients[0] = coefficients[1] = coefficients[2] = 0.0;
+					for (uint32_t k = startK + 1; k-- > 0;) {
+						solve(k, coefficients);
+					}
+				}
+			}
+		});
+
+		const double milliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "generate", milliseconds);
+		instrumentation::Instrumentation::logMath(instrumentation::E_LogLevel::INFO, "spectra::core::math", "S_RgbToSpectrumTable",
+			"Generated RGB to spectrum table", resolution, milliseconds);
+	}
+
+	bool S_RgbToSpectrumTable::load(const std::string& path) {
+		const auto start = std::chrono::steady_clock::now();
+		platform::S_MappedFile file;
+		if (!file.open(path)) {
+			return false;
+		}
+
+		S_CacheHeader header;
+		if (file.getSize() < sizeof(header)) {
+			return false;
+		}
+		std::memcpy(&header, file.getData(), sizeof(header));
+		if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION || header.resolution < 2
+			|| header.floatCount != getFloatCount(header.resolution) || file.getSize() != sizeof(header) + header.floatCount * sizeof(float)) {
+			instrumentation::Instrumentation::logMath(instrumentation::E_LogLevel::WARNING, "spectra::core::math", "S_RgbToSpectrumTable",
+				"Ignoring stale RGB to spectrum cache", path);
+			return false;
+		}
+
+		mapping = std::move(file);
+		owned.clear();
+		owned.shrink_to_fit();
+		resolution = header.resolution;
+		scale = reinterpret_cast<const float*>(mapping.getData() + sizeof(header));
+		coefficients = scale + resolution;
+
+		const double milliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "load", milliseconds);
+		instrumentation::Instrumentation::logMath(instrumentation::E_LogLevel::INFO, "spectra::core::math", "S_RgbToSpectrumTable",
+			"Mapped RGB to spectrum table", path, milliseconds);
+		return true;
+	}
+
+	bool S_RgbToSpectrumTable::save(const std::string& path) const {
+		if (!isReady()) {
+			return false;
+		}
+
+		S_CacheHeader header{};
+		std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.version = CACHE_VERSION;
+		header.resolution = resolution;
+		header.floatCount = static_cast<uint32_t>(getFloatCount(resolution));
+
+		std::error_code error;
+		const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+		if (!directory.empty()) {
+			std::filesystem::create_directories(directory, error);
+		}
+
+		const std::string temporaryPath = platform::S_TemporaryPath::make(path);
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(scale), resolution * sizeof(float));
+			stream.write(reinterpret_cast<const char*>(coefficients), (header.floatCount - resolution) * sizeof(float));
+			if (!stream) {
+				instrumentation::Instrumentation::logMath(instrumentation::E_LogLevel::WARNING, "spectra::core::math", "S_RgbToSpectrumTable",
+					"Could not write RGB to spectrum cache", temporaryPath);
+				stream.close();
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error) {
+			instrumentation::Instrumentation::logMath(instrumentation::E_LogLevel::WARNING, "spectra::core::math", "S_RgbToSpectrumTable",
+				"Could not replace RGB to spectrum cache", path, error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	void S_RgbToSpectrumTable::loadOrGenerate(const std::string& cachePath, uint32_t tableResolution) {
+		loadOrGenerate(std::vector<std::string>{ cachePath }, tableResolution);
+	}
+
+	void S_RgbToSpectrumTable::loadOrGenerate(const std::vector<std::string>& cachePaths, uint32_t tableResolution) {
+		for (const std::string& path : cachePaths) {
+			if (load(path) && resolution == tableResolution) {
+				return;
+			}
+		}
+		generate(tableResolution);
+		for (const std::string& path : cachePaths) {
+			if (save(path)) {
+				load(path);
+				return;
+			}
+		}
+	}
+
+	bool S_RgbToSpectrumTable::isReady() const {
+		return coefficients != nullptr;
+	}
+
+	bool S_RgbToSpectrumTable::isMapped() const {
+		return mapping.isOpen();
+	}
+
+	const std::string& S_RgbToSpectrumTable::getCachePath() const {
+		return mapping.getPath();
+	}
+
+	uint32_t S_RgbToSpectrumTable::getResolution() const {
+		return resolution;
+	}
+
+	S_RgbSigmoidPolynomial S_RgbToSpectrumTable::lookup(const S_Vec3& color) const {
+		const S_Vec3 rgb = math::min(math::max(color, S_Vec3(0.0f)), S_Vec3(1.0f));
+
+		// Greys have an exact flat solution
+		if (rgb.x == rgb.y && rgb.y == rgb.z) {
+			const float value = rgb.x;
+			return { 0.0f, 0.0f, (value - 0.5f) / std::sqrt(value * (1.0f - value)) };
+		}
+
+		const int largest = rgb.x > rgb.y ? (rgb.x > rgb.z ? 0 : 2) : (rgb.y > rgb.z ? 1 : 2);
+		const float z = rgb[largest];
+		const float last = static_cast<float>(resolution - 1);
+		const float x = rgb[(largest + 1) % 3] * last / z;
+		const float y = rgb[(largest + 2) % 3] * last / z;
+
+		const uint32_t xi = std::min(static_cast<uint32_t>(x), resolution - 2);
+		const uint32_t yi = std::min(static_cast<uint32_t>(y), resolution - 2);
+		const uint32_t zi = static_cast<uint32_t>(std::clamp<ptrdiff_t>(std::upper_bound(scale, scale + resolution, z) - scale - 1, 0,
+			static_cast<ptrdiff_t>(resolution) - 2));
+		const float dx = x - static_cast<float>(xi);
+		const float dy = y - static_cast<float>(yi);
+		const float dz = (z - scale[zi]) / (scale[zi + 1] - scale[zi]);
+
+		// Trilinear blend of the eight surrounding entries
+		float result[3];
+		for (int c = 0; c < 3; ++c) {
+			auto at = [&](uint32_t xo, uint32_t yo, uint32_t zo) {
+				return coefficients[3 * (((static_cast<size_t>(largest) * resolution + zi + zo) * resolution + yi + yo) * resolution + xi + xo) + c];
+			};
+			const float x00 = at(0, 0, 0) + dx * (at(1, 0, 0) - at(0, 0, 0));
+			const float x10 = at(0, 1, 0) + dx * (at(1, 1, 0) - at(0, 1, 0));
+			const float x01 = at(0, 0, 1) + dx * (at(1, 0, 1) - at(0, 0, 1));
+			const float x11 = at(0, 1, 1) + dx * (at(1, 1, 1) - at(0, 1, 1));
+			const float y0 = x00 + dy * (x10 - x00);
+			const float y1 = x01 + dy * (x11 - x01);
+			result[c] = y0 + dz * (y1 - y0);
+		}
+		return { result[0], result[1], result[2] };
+	}
+
+	S_SampledSpectrum S_RgbToSpectrumTable::sampleAlbedo(const S_Vec3& rgb, const S_SampledWavelengths& wavelengths) const {
+		return lookup(rgb).sample(wavelengths);
+	}
+
+	S_SampledSpectrum S_RgbToSpectrumTable::sampleUnbounded(const S_Vec3& rgb, const S_SampledWavelengths& wavelengths) const {
+		const float largest = maxComponent(rgb);
+		if (largest <= 0.0f) {
+			return S_SampledSpectrum(0.0f);
+		}
+		const float scaleFactor = 2.0f * largest;
+		return lookup(rgb / scaleFactor).sample(wavelengths) * scaleFactor;
+	}
+
+	S_SampledSpectrum S_RgbToSpectrumTable::sampleIlluminant(const S_Vec3& rgb, const S_SampledWavelengths& wavelengths) const {
+		S_SampledSpectrum illuminant;
+		for (uint32_t i = 0; i < SPECTRUM_SAMPLES; ++i) {
+			illuminant[i] = cie::whiteIlluminant(wavelengths.lambda[i]);
+		}
+		return sampleUnbounded(rgb, wavelengths) * illuminant;
+	}
+
+	void S_RgbToSpectrumTable::initializeSRGB(const std::string& cachePath) {
+		S_SharedTable& shared = getSharedTable();
+		std::call_once(shared.initialized, [&] {
+			shared.table.loadOrGenerate(cachePath);
+		});
+	}
+
+	const S_RgbToSpectrumTable& S_RgbToSpectrumTable::getSRGB() {
+		S_SharedTable& shared = getSharedTable();
+		std::call_once(shared.initialized, [&] {
+			shared.table.loadOrGenerate(getDefaultCachePaths());
+		});
+		return shared.table;
+	}
+
+	std::vector<std::string> S_RgbToSpectrumTable::getDefaultCachePaths() {
+		constexpr const char* FILE_NAME = "spectra_srgb_to_spectrum.bin";
+		std::vector<std::string> paths;
+		const std::string executableDirectory = platform::S_SharedLibrary::getExecutableDirectory();
+		if (!executableDirectory.empty()) {
+			paths.push_back(executableDirectory + FILE_NAME);
+		}
+		if (const std::filesystem::path userDirectory = getUserCacheDirectory(); !userDirectory.empty()) {
+			paths.push_back((userDirectory / FILE_NAME).string());
+		}
+		std::error_code error;
+		if (const std::filesystem::path temporaryDirectory = std::filesystem::temp_directory_path(error); !error) {
+			paths.push_back((temporaryDirectory / FILE_NAME).string());
+		}
+		return paths;
+	}
+}
@@ -0,0 +1,122 @@
+#include "S_SharedLibrary.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <limits.h>
+#include <unistd.h>
+#endif
+
+namespace spectra::core::platform {
+	S_SharedLibrary::~S_SharedLibrary() {
+		close();
+	}
+
+	S_SharedLibrary::S_SharedLibrary(S_SharedLibrary&& other) noexcept
+		: handle(std::exchange(other.handle, nullptr)), path(std::move(other.path)), lastError(std::move(other.lastError)) {}
+
+	S_SharedLibrary& S_SharedLibrary::operator=(S_SharedLibrary&& other) noexcept {
+		if (this != &other) {
+			close();
+			handle = std::exchange(other.handle, nullptr);
+			path = std::move(other.path);
+			lastError = std::move(other.lastError);
+		}
+		return *this;
+	}
+
+	bool S_SharedLibrary::open(const std::string& libraryPath) {
+		close();
+		path = libraryPath;
+#if defined(_WIN32)
+		handle = reinterpret_cast<void*>(LoadLibraryA(libraryPath.c_str()));
+		if (!handle) {
+			lastError = "LoadLibrary failed with error " + std::to_string(GetLastError());
+		}
+#else
+		handle = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (!handle) {
+			const char* error = dlerror();
+			lastError = error ? error : "dlopen failed";
+		}
+#endif
+		return handle != nullptr;
+	}
+
+	void S_SharedLibrary::close() {
+		if (!handle) {
+			return;
+		}
+#if defined(_WIN32)
+		FreeLibrary(reinterpret_cast<HMODULE>(handle));
+#else
+		dlclose(handle);
+#endif
+		handle = nullptr;
+	}
+
+	bool S_SharedLibrary::isOpen() const {
+		return handle != nullptr;
+	}
+
+	void* S_SharedLibrary::getSymbol(const std::string& name) {
+		if (!handle) {
+			lastError = "Library is not open";
+			return nullptr;
+		}
+#if defined(_WIN32)
+		void* symbol = reinterpret_cast<void*>(GetProcAddress(reinterpret_cast<HMODULE>(handle), name.c_str()));
+		if (!symbol) {
+			lastError = "GetProcAddress failed for " + name;
+		}
+#else
+		void* symbol = dlsym(handle, name.c_str());
+		if (!symbol) {
+			const char* error = dlerror();
+			lastError = error ? error : "dlsym failed for " + name;
+		}
+#endif
+		return symbol;
+	}
+
+	const std::string& S_SharedLibrary::getPath() const {
+		return path;
+	}
+
+	const std::string& S_SharedLibrary::getLastError() const {
+		return lastError;
+	}
+
+	std::string S_SharedLibrary::getPlatformFileName(const std::string& moduleName) {
+#if defined(_WIN32)
+		return moduleName + ".dll";
+#elif defined(__APPLE__)
+		return "lib" + moduleName + ".dylib";
+#else
+		return "lib" + moduleName + ".so";
+#endif
+	}
+
+	std::string S_SharedLibrary::getExecutableDirectory() {
+		std::string executable;
+#if defined(_WIN32)
+		char buffer[MAX_PATH];
+		const DWORD length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+		executable.assign(buffer, length);
+		const size_t separator = executable.find_last_of("\\/");
+#else
+		char buffer[PATH_MAX];
+		const ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+		if (length > 0) {
+			executable.assign(buffer, static_cast<size_t>(length));
+		}
+		const size_t separator = executable.find_last_of('/');
+#endif
+		return separator == std::string::npos ? std::string() : executable.substr(0, separator + 1);
+	}
+}
@@ -0,0 +1,423 @@
+#include "S_StreamingManager.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace spectra::core::streaming {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::core::streaming";
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	// Read-only file handle for positional reads, which any number of threads may issue at once
+	struct S_StreamingPack {
+		intptr_t handle = -1;  // HANDLE on Windows, a descriptor elsewhere
+		std::string path;
+
+		S_StreamingPack() = default;
+		S_StreamingPack(const S_StreamingPack&) = delete;
+		S_StreamingPack& operator=(const S_StreamingPack&) = delete;
+
+		~S_StreamingPack() {
+			if (handle == -1) {
+				return;
+			}
+#if defined(_WIN32)
+			CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+			::close(static_cast<int>(handle));
+#endif
+		}
+
+		bool open(const std::string& filePath, std::string& error) {
+			path = filePath;
+#if defined(_WIN32)
+			const HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				error = "CreateFile failed with error " + std::to_string(GetLastError());
+				return false;
+			}
+			handle = reinterpret_cast<intptr_t>(file);
+#else
+			const int file = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+			if (file < 0) {
+				error = std::string("open failed: ") + std::strerror(errno);
+				return false;
+			}
+			handle = file;
+#endif
+			return true;
+		}
+
+		bool read(uint64_t offset, std::byte* out, size_t size) const {
+			while (size > 0) {
+#if defined(_WIN32)
+				OVERLAPPED overlapped{};
+				overlapped.Offset = static_cast<DWORD>(offset);
+				overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+				DWORD transferred = 0;
+				const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+				if (!ReadFile(reinterpret_cast<HANDLE>(handle), out, chunk, &transferred, &overlapped) || transferred == 0) {
+					return false;
+				}
+#else
+				const ssize_t transferred = ::pread(static_cast<int>(handle), out, size, static_cast<off_t>(offset));
+				if (transferred < 0 && errno == EINTR) {
+					continue;
+				}
+				if (transferred <= 0) {
+					return false;
+				}
+#endif
+				out += transferred;
+				offset += static_cast<uint64_t>(transferred);
+				size -= static_cast<size_t>(transferred);
+			}
+			return true;
+		}
+	};
+
+	// S_StreamingManager implementations
+	S_StreamingManager::S_StreamingManager(const S_StreamingSettings& settings)
+		: heap(std::min(settings.memoryBudget, memory::S_TlsfHeap::DEFAULT_POOL_SIZE), memory::E_MemoryTag::STREAMING),
+		memoryBudget(settings.memoryBudget), frame(1) {
+		const uint32_t threadCount = std::max(settings.ioThreads, 1u);
+		for (uint32_t i = 0; i < threadCount; ++i) {
+			ioThreads.emplace_back([this]() { ioLoop(); });
+		}
+	}
+
+	S_StreamingManager::~S_StreamingManager() {
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		workCondition.notify_all();
+		for (std::thread& thread : ioThreads) {
+			thread.join();
+		}
+		for (S_Page& page : pages) {
+			if (page.data) {
+				heap.release(page.data);
+			}
+		}
+	}
+
+	uint32_t S_StreamingManager::addPack(const std::string& path) {
+		auto pack = std::make_unique<S_StreamingPack>();
+		std::string error;
+		if (!pack->open(path, error)) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::WARNING, "spectra::core::streaming", "S_StreamingManager",
+				"Could not open pack", path, error);
+			return INVALID_PACK;
+		}
+		std::lock_guard lock(mutex);
+		packs.push_back(std::move(pack));
+		return static_cast<uint32_t>(packs.size() - 1);
+	}
+
+	uint32_t S_StreamingManager::addPage(uint32_t pack, uint64_t offset, uint32_t size) {
+		std::lock_guard lock(mutex);
+		if (pack >= packs.size() || size == 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::streaming", "S_StreamingManager",
+				"Page needs a pack and a size", pack, size);
+		}
+		S_Page& page = pages.emplace_back();
+		page.pack = pack;
+		page.offset = offset;
+		page.size = size;
+		return static_cast<uint32_t>(pages.size() - 1);
+	}
+
+	void S_StreamingManager::beginFrame() {
+		{
+			std::lock_guard lock(mutex);
+			++frame;
+			stalled = false;
+		}
+		workCondition.notify_all();
+	}
+
+	void S_StreamingManager::request(uint32_t pageIndex, float priority) {
+		{
+			std::lock_guard lock(mutex);
+			S_Page& page = pages.at(pageIndex);
+			page.requestFrame = frame;
+			page.priority = priority;
+			switch (page.state) {
+			case E_PageState::RESIDENT:
+			case E_PageState::LOADING:
+				page.referenced = true;
+				return;
+			case E_PageState::QUEUED:
+				++page.generation;
+				break;
+			case E_PageState::UNLOADED:
+			case E_PageState::FAILED:
+				page.state = E_PageState::QUEUED;
+				page.requestTime = std::chrono::steady_clock::now();
+				++page.generation;
+				++stats.requests;
+				++stats.queuedPages;
+				break;
+			}
+			queue.push_back({ priority, pageIndex, page.generation });
+			std::push_heap(queue.begin(), queue.end());
+			stalled = false;
+		}
+		workCondition.notify_one();
+	}
+
+	void S_StreamingManager::cancel(uint32_t pageIndex) {
+		std::lock_guard lock(mutex);
+		S_Page& page = pages.at(pageIndex);
+		if (page.state == E_PageState::RESIDENT) {
+			page.referenced = false;
+			page.requestFrame = 0;
+			return;
+		}
+		if (page.state == E_PageState::QUEUED) {
+			--stats.queuedPages;
+		}
+		else if (page.state != E_PageState::LOADING) {
+			return;
+		}
+		// A read in flight finishes into memory the I/O thread then releases
+		page.state = E_PageState::UNLOADED;
+		++page.generation;
+		++stats.cancelled;
+		idleCondition.notify_all();
+	}
+
+	std::span<const std::byte> S_StreamingManager::pin(uint32_t pageIndex) {
+		std::lock_guard lock(mutex);
+		S_Page& page = pages.at(pageIndex);
+		if (page.state != E_PageState::RESIDENT) {
+			return {};
+		}
+		++page.pins;
+		page.referenced = true;
+		return { page.data, page.size };
+	}
+
+	void S_StreamingManager::unpin(uint32_t pageIndex) {
+		std::lock_guard lock(mutex);
+		S_Page& page = pages.at(pageIndex);
+		if (page.pins == 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::streaming", "S_StreamingManager",
+				"Page is not pinned", pageIndex);
+		}
+		if (--page.pins == 0) {
+			wakeAfterRelease();
+		}
+	}
+
+	void S_StreamingManager::setMemoryBudget(size_t bytes) {
+		std::lock_guard lock(mutex);
+		memoryBudget = bytes;
+		while (committedBytes > memoryBudget && evictOne(std::numeric_limits<float>::infinity())) {
+		}
+		wakeAfterRelease();
+	}
+
+	E_PageState S_StreamingManager::getState(uint32_t pageIndex) const {
+		std::lock_guard lock(mutex);
+		return pages.at(pageIndex).state;
+	}
+
+	void S_StreamingManager::takeArrivals(std::vector<uint32_t>& out) {
+		std::lock_guard lock(mutex);
+		out.insert(out.end(), arrivals.begin(), arrivals.end());
+		arrivals.clear();
+	}
+
+	void S_StreamingManager::waitForIdle() {
+		std::unique_lock lock(mutex);
+		idleCondition.wait(lock, [&]() { return stats.loadingPages == 0 && (stats.queuedPages == 0 || stalled); });
+	}
+
+	float S_StreamingManager::projectedSize(float radius, float distance) {
+		return radius / std::max(distance, radius);
+	}
+
+	S_StreamingStats S_StreamingManager::getStats() const {
+		std::lock_guard lock(mutex);
+		stats.residentPages = static_cast<uint32_t>(clockRing.size());
+		stats.averageLatencyMilliseconds = stats.completed > 0 ? latencySum / static_cast<double>(stats.completed) : 0.0;
+		stats.readMegabytesPerSecond = stats.readMilliseconds > 0.0 ? static_cast<double>(stats.bytesRead) / (stats.readMilliseconds * 1000.0) : 0.0;
+		return stats;
+	}
+
+	void S_StreamingManager::publishStats() const {
+		using instrumentation::Instrumentation;
+		const S_StreamingStats current = getStats();
+
+		Instrumentation::setGauge(STATS_CATEGORY, "requests", static_cast<double>(current.requests));
+		Instrumentation::setGauge(STATS_CATEGORY, "completed", static_cast<double>(current.completed));
+		Instrumentation::setGauge(STATS_CATEGORY, "cancelled", static_cast<double>(current.cancelled));
+		Instrumentation::setGauge(STATS_CATEGORY, "evicted", static_cast<double>(current.evicted));
+		Instrumentation::setGauge(STATS_CATEGORY, "failed", static_cast<double>(current.failed));
+		Instrumentation::setGauge(STATS_CATEGORY, "residentBytes", static_cast<double>(current.residentBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "peakResidentBytes", static_cast<double>(current.peakResidentBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "queuedPages", current.queuedPages);
+		Instrumentation::setGauge(STATS_CATEGORY, "averageLatencyMilliseconds", current.averageLatencyMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "maxLatencyMilliseconds", current.maxLatencyMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "readMegabytesPerSecond", current.readMegabytesPerSecond);
+	}
+
+	void S_StreamingManager::ioLoop() {
+		std::unique_lock lock(mutex);
+		while (true) {
+			workCondition.wait(lock, [&]() { return stopping || (!queue.empty() && !stalled); });
+			if (stopping) {
+				return;
+			}
+
+			std::pop_heap(queue.begin(), queue.end());
+			const S_QueueEntry entry = queue.back();
+			queue.pop_back();
+			S_Page& page = pages[entry.page];
+			if (page.generation != entry.generation || page.state != E_PageState::QUEUED) {
+				continue;
+			}
+			if (page.size > memoryBudget) {
+				page.state = E_PageState::FAILED;
+				--stats.queuedPages;
+				++stats.failed;
+				instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::WARNING, "spectra::core::streaming", "S_StreamingManager",
+					"Page exceeds the memory budget", entry.page, page.size);
+				idleCondition.notify_all();
+				continue;
+			}
+			if (!reserve(page.size, entry.priority)) {
+				// Stays first in line until memory is unpinned or a new frame begins
+				queue.push_back(entry);
+				std::push_heap(queue.begin(), queue.end());
+				stalled = true;
+				idleCondition.notify_all();
+				continue;
+			}
+
+			std::byte* data = static_cast<std::byte*>(heap.allocateTagged(page.size, PAGE_ALIGNMENT, memory::E_MemoryTag::STREAMING));
+			page.state = E_PageState::LOADING;
+			--stats.queuedPages;
+			++stats.loadingPages;
+			const S_StreamingPack& pack = *packs[page.pack];
+			const uint64_t offset = page.offset;
+			const uint32_t size = page.size;
+			const uint32_t generation = page.generation;
+
+			lock.unlock();
+			const auto readStart = std::chrono::steady_clock::now();
+			const bool read = pack.read(offset, data, size);
+			const double readMilliseconds = millisecondsSince(readStart);
+			lock.lock();
+
+			S_Page& loaded = pages[entry.page];
+			--stats.loadingPages;
+			stats.readMilliseconds += readMilliseconds;
+			if (read && loaded.generation == generation) {
+				loaded.data = data;
+				loaded.state = E_PageState::RESIDENT;
+				loaded.referenced = true;
+				clockRing.push_back(entry.page);
+				arrivals.push_back(entry.page);
+				stats.bytesRead += size;
+				stats.residentBytes += size;
+				stats.peakResidentBytes = std::max(stats.peakResidentBytes, stats.residentBytes);
+				++stats.completed;
+				const double latency = millisecondsSince(loaded.requestTime);
+				latencySum += latency;
+				stats.maxLatencyMilliseconds = std::max(stats.maxLatencyMilliseconds, latency);
+				instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "latency", latency);
+			}
+			else {
+				heap.release(data);
+				committedBytes -= size;
+				if (!read && loaded.generation == generation) {
+					loaded.state = E_PageState::FAILED;
+					++stats.failed;
+					instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::WARNING, "spectra::core::streaming", "S_StreamingManager",
+						"Could not read page", entry.page, packs[loaded.pack]->path);
+				}
+				wakeAfterRelease();
+			}
+			idleCondition.notify_all();
+		}
+	}
+
+	bool S_StreamingManager::reserve(size_t bytes, float priority) {
+		while (committedBytes + bytes > memoryBudget) {
+			if (!evictOne(priority)) {
+				return false;
+			}
+		}
+		committedBytes += bytes;
+		return true;
+	}
+
+	bool S_StreamingManager::evictOne(float priority) {
+		// Two sweeps clear every clock bit once and then reach every unprotected page
+		for (size_t step = 0; step < clockRing.size() * 2; ++step) {
+			if (clockHand >= clockRing.size()) {
+				clockHand = 0;
+			}
+			S_Page& page = pages[clockRing[clockHand]];
+			if (page.pins > 0 || (page.requestFrame == frame && page.priority >= priority)) {
+				++clockHand;
+				continue;
+			}
+			if (page.referenced) {
+				page.referenced = false;
+				++clockHand;
+				continue;
+			}
+
+			// A page still wanted this frame goes back in line behind what displaced it
+			releaseData(page);
+			page.state = E_PageState::UNLOADED;
+			if (page.requestFrame == frame) {
+				page.state = E_PageState::QUEUED;
+				page.requestTime = std::chrono::steady_clock::now();
+				++page.generation;
+				++stats.queuedPages;
+				queue.push_back({ page.priority, clockRing[clockHand], page.generation });
+				std::push_heap(queue.begin(), queue.end());
+			}
+			++stats.evicted;
+			clockRing[clockHand] = clockRing.back();
+			clockRing.pop_back();
+			return true;
+		}
+		return false;
+	}
+
+	void S_StreamingManager::releaseData(S_Page& page) {
+		heap.release(page.data);
+		page.data = nullptr;
+		committedBytes -= page.size;
+		stats.residentBytes -= page.size;
+	}
+
+	void S_StreamingManager::wakeAfterRelease() {
+		if (stalled) {
+			stalled = false;
+			workCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,15 @@
+#include "S_TemporaryPath.h"
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace spectra::core::platform {
+	// S_TemporaryPath implementations
+	std::string S_TemporaryPath::make(const std::string& path) {
+		std::random_device device;
+		const uint64_t suffix = (static_cast<uint64_t>(device()) << 32 | device()) ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+		return path + "." + std::to_string(suffix) + ".tmp";
+	}
+}
@@ -0,0 +1,391 @@
+#include "S_TlsfHeap.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace spectra::core::memory {
+	// Physical blocks are laid out back to back in a pool and end with a zero-sized
+	// sentinel. The header is always valid; the free-list links live in the payload
+	// and are only meaningful while the block is free.
+	struct S_TlsfBlock {
+		S_TlsfBlock* prevPhysical;
+		uint64_t sizeAndFlags;  // Bit 0: free, bit 1: sentinel, bits 4..55: payload size, bits 56..63: tag
+		S_TlsfBlock* nextFree;
+		S_TlsfBlock* prevFree;
+	};
+
+	namespace {
+		constexpr size_t HEADER_SIZE = 2 * sizeof(void*);
+		constexpr size_t MIN_PAYLOAD = 2 * sizeof(void*);
+		constexpr uint64_t FREE_BIT = 1;
+		constexpr uint64_t SENTINEL_BIT = 2;
+		constexpr uint64_t TAG_SHIFT = 56;
+		constexpr uint64_t SIZE_MASK = ((uint64_t{ 1 } << TAG_SHIFT) - 1) & ~uint64_t{ 0xF };
+
+		static_assert(HEADER_SIZE == S_TlsfHeap::ALIGN_SIZE, "Header must keep payloads aligned");
+
+		size_t blockSize(const S_TlsfBlock* block) {
+			return static_cast<size_t>(block->sizeAndFlags & SIZE_MASK);
+		}
+
+		void setBlockSize(S_TlsfBlock* block, size_t size) {
+			block->sizeAndFlags = (block->sizeAndFlags & ~SIZE_MASK) | (static_cast<uint64_t>(size) & SIZE_MASK);
+		}
+
+		bool isFree(const S_TlsfBlock* block) {
+			return (block->sizeAndFlags & FREE_BIT) != 0;
+		}
+
+		void setFree(S_TlsfBlock* block, bool free) {
+			block->sizeAndFlags = free ? (block->sizeAndFlags | FREE_BIT) : (block->sizeAndFlags & ~FREE_BIT);
+		}
+
+		bool isSentinel(const S_TlsfBlock* block) {
+			return (block->sizeAndFlags & SENTINEL_BIT) != 0;
+		}
+
+		E_MemoryTag blockTag(const S_TlsfBlock* block) {
+			return static_cast<E_MemoryTag>(block->sizeAndFlags >> TAG_SHIFT);
+		}
+
+		void setBlockTag(S_TlsfBlock* block, E_MemoryTag tag) {
+			block->sizeAndFlags = (block->sizeAndFlags & ((uint64_t{ 1 } << TAG_SHIFT) - 1)) | (static_cast<uint64_t>(tag) << TAG_SHIFT);
+		}
+
+		std::byte* payloadOf(S_TlsfBlock* block) {
+			return reinterpret_cast<std::byte*>(block) + HEADER_SIZE;
+		}
+
+		S_TlsfBlock* blockFromPayload(const void* pointer) {
+			return reinterpret_cast<S_TlsfBlock*>(const_cast<std::byte*>(static_cast<const std::byte*>(pointer)) - HEADER_SIZE);
+		}
+
+		S_TlsfBlock* nextPhysical(S_TlsfBlock* block) {
+			return reinterpret_cast<S_TlsfBlock*>(payloadOf(block) + blockSize(block));
+		}
+
+		size_t highestBit(size_t value) {
+			return static_cast<size_t>(std::bit_width(value)) - 1;
+		}
+	}
+
+	// S_TlsfHeap implementations
+	S_TlsfHeap::S_TlsfHeap(size_t poolSize, E_MemoryTag defaultTag, std::pmr::memory_resource* upstream)
+		: poolSize(std::max<size_t>(poolSize, SMALL_BLOCK_SIZE)), defaultTag(defaultTag), upstream(upstream) {}
+
+	S_TlsfHeap::~S_TlsfHeap() {
+		std::lock_guard<std::mutex> lock(heapMutex);
+		// Allocations still live at destruction are dropped from the global accounting
+		for (size_t i = 0; i < bytesPerTag.size(); ++i) {
+			if (allocationsPerTag[i] > 0) {
+				S_MemoryTracker::recordDeallocation(static_cast<E_MemoryTag>(i), bytesPerTag[i], allocationsPerTag[i]);
+			}
+		}
+		for (const S_Pool& pool : pools) {
+			upstream->deallocate(pool.memory, pool.bytes, ALIGN_SIZE);
+		}
+	}
+
+	void S_TlsfHeap::mapping(size_t size, size_t& fl, size_t& sl) {
+		if (size < SMALL_BLOCK_SIZE) {
+			// Small sizes are spread linearly over the second level of list 0
+			fl = 0;
+			sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+			return;
+		}
+
+		const size_t bit = highestBit(size);
+		sl = (size >> (bit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		fl = bit - (FL_INDEX_SHIFT - 1);
+	}
+
+	void S_TlsfHeap::mappingSearch(size_t size, size_t& fl, size_t& sl) {
+		// Round up to the next list so any block found there is large enough
+		if (size >= SMALL_BLOCK_SIZE) {
+			size += (size_t{ 1 } << (highestBit(size) - SL_INDEX_COUNT_LOG2)) - 1;
+		}
+		mapping(size, fl, sl);
+	}
+
+	bool S_TlsfHeap::addPool(size_t minimumPayload) {
+		// findFree rounds requests up to the next list, the new block has to map at or above it
+		if (minimumPayload >= SMALL_BLOCK_SIZE) {
+			minimumPayload += size_t{ 1 } << (highestBit(minimumPayload) - SL_INDEX_COUNT_LOG2);
+		}
+		const size_t bytes = alignUp(std::max(poolSize, minimumPayload + 3 * HEADER_SIZE), ALIGN_SIZE);
+		if (bytes - 2 * HEADER_SIZE >= (size_t{ 1 } << FL_INDEX_MAX)) {
+			return false;
+		}
+
+		void* memory = upstream->allocate(bytes, ALIGN_SIZE);
+		auto* first = static_cast<S_TlsfBlock*>(memory);
+		first->prevPhysical = nullptr;
+		first->sizeAndFlags = 0;
+		setBlockSize(first, bytes - 2 * HEADER_SIZE);
+		setFree(first, true);
+
+		S_TlsfBlock* sentinel = nextPhysical(first);
+		sentinel->prevPhysical = first;
+		sentinel->sizeAndFlags = SENTINEL_BIT;
+
+		insertFree(first);
+		pools.push_back({ memory, bytes, first });
+		poolBytes += bytes;
+		return true;
+	}
+
+	void S_TlsfHeap::insertFree(S_TlsfBlock* block) {
+		size_t fl;
+		size_t sl;
+		mapping(blockSize(block), fl, sl);
+
+		S_TlsfBlock* head = freeLists[fl][sl];
+		block->nextFree = head;
+		block->prevFree = nullptr;
+		if (head) {
+			head->prevFree = block;
+		}
+		freeLists[fl][sl] = block;
+		flBitmap |= uint64_t{ 1 } << fl;
+		slBitmap[fl] |= 1u << sl;
+	}
+
+	void S_TlsfHeap::removeFree(S_TlsfBlock* block) {
+		size_t fl;
+		size_t sl;
+		mapping(blockSize(block), fl, sl);
+
+		if (block->prevFree) {
+			block->prevFree->nextFree = block->nextFree;
+		}
+		else {
+			freeLists[fl][sl] = block->nextFree;
+		}
+		if (block->nextFree) {
+			block->nextFree->prevFree = block->prevFree;
+		}
+
+		if (!freeLists[fl][sl]) {
+			slBitmap[fl] &= ~(1u << sl);
+			if (!slBitmap[fl]) {
+				flBitmap &= ~(uint64_t{ 1 } << fl);
+			}
+		}
+	}
+
+	S_TlsfBlock* S_TlsfHeap::findFree(size_t size) {
+		size_t fl;
+		size_t sl;
+		mappingSearch(size, fl, sl);
+		if (fl >= FL_INDEX_COUNT) {
+			return nullptr;
+		}
+
+		uint32_t slMap = slBitmap[fl] & (~0u << sl);
+		if (!slMap) {
+			const uint64_t flMap = fl + 1 < 64 ? flBitmap & (~uint64_t{ 0 } << (fl + 1)) : 0;
+			if (!flMap) {
+				return nullptr;
+			}
+			fl = static_cast<size_t>(std::countr_zero(flMap));
+			slMap = slBitmap[fl];
+		}
+		sl = static_cast<size_t>(std::countr_zero(slMap));
+
+		S_TlsfBlock* block = freeLists[fl][sl];
+		removeFree(block);
+		return block;
+	}
+
+	S_TlsfBlock* S_TlsfHeap::splitFront(S_TlsfBlock* block, size_t gap) {
+		// The leading gap becomes its own free block, the rest is returned
+		auto* rest = reinterpret_cast<S_TlsfBlock*>(reinterpret_cast<std::byte*>(block) + gap);
+		rest->prevPhysical = block;
+		rest->sizeAndFlags = 0;
+		setBlockSize(rest, blockSize(block) - gap);
+		nextPhysical(rest)->prevPhysical = rest;
+
+		setBlockSize(block, gap - HEADER_SIZE);
+		setFree(block, true);
+		insertFree(block);
+		return rest;
+	}
+
+	void S_TlsfHeap::trimBack(S_TlsfBlock* block, size_t size) {
+		if (blockSize(block) < size + HEADER_SIZE + MIN_PAYLOAD) {
+			return;
+		}
+
+		auto* rest = reinterpret_cast<S_TlsfBlock*>(payloadOf(block) + size);
+		rest->prevPhysical = block;
+		rest->sizeAndFlags = 0;
+		setBlockSize(rest, blockSize(block) - size - HEADER_SIZE);
+		setFree(rest, true);
+		nextPhysical(rest)->prevPhysical = rest;
+		setBlockSize(block, size);
+		insertFree(rest);
+	}
+
+	void* S_TlsfHeap::allocateTagged(size_t bytes, size_t alignment, E_MemoryTag tag) {
+		if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+			instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::memory", "S_TlsfHeap", "Alignment must be a power of two", static_cast<uint64_t>(alignment));
+		}
+
+		const size_t size = alignUp(std::max(bytes, MIN_PAYLOAD), ALIGN_SIZE);
+		// Over-aligned requests need room to carve a free block off the front
+		const size_t searchSize = alignment > ALIGN_SIZE ? size + alignment + HEADER_SIZE + MIN_PAYLOAD : size;
+
+		std::lock_guard<std::mutex> lock(heapMutex);
+		S_TlsfBlock* block = findFree(searchSize);
+		if (!block) {
+			if (!addPool(searchSize)) {
+				instrumentation::Instrumentation::logCore(instrumentation::E_LogLevel::ERROR, "spectra::core::memory", "S_TlsfHeap", "Allocation exceeds the maximum block size", static_cast<uint64_t>(bytes));
+			}
+			block = findFree(searchSize);
+		}
+
+		if (alignment > ALIGN_SIZE) {
+			const uintptr_t payload = reinterpret_cast<uintptr_t>(payloadOf(block));
+			size_t gap = alignUp(payload, alignment) - payload;
+			if (gap != 0 && gap < HEADER_SIZE + MIN_PAYLOAD) {
+				gap = alignUp(payload + HEADER_SIZE + MIN_PAYLOAD, alignment) - payload;
+			}
+			if (gap != 0) {
+				block = splitFront(block, gap);
+			}
+		}
+
+		trimBack(block, size);
+		setFree(block, false);
+		setBlockTag(block, tag);
+
+		const size_t allocated = blockSize(block);
+		usedBytes += allocated;
+		allocationCount++;
+		bytesPerTag[static_cast<size_t>(tag)] += allocated;
+		allocationsPerTag[static_cast<size_t>(tag)]++;
+		S_MemoryTracker::recordAllocation(tag, allocated);
+		return payloadOf(block);
+	}
+
+	void S_TlsfHeap::release(void* pointer) {
+		if (!pointer) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(heapMutex);
+		S_TlsfBlock* block = blockFromPayload(pointer);
+		const size_t allocated = blockSize(block);
+		const E_MemoryTag tag = blockTag(block);
+		usedBytes -= allocated;
+		allocationCount--;
+		bytesPerTag[static_cast<size_t>(tag)] -= allocated;
+		allocationsPerTag[static_cast<size_t>(tag)]--;
+		S_MemoryTracker::recordDeallocation(tag, allocated);
+
+		setFree(block, true);
+		setBlockTag(block, E_MemoryTag::GENERAL);
+
+		// Coalesce with both physical neighbours so free blocks are never adjacent
+		S_TlsfBlock* previous = block->prevPhysical;
+		if (previous && isFree(previous)) {
+			removeFree(previous);
+			setBlockSize(previous, blockSize(previous) + HEADER_SIZE + blockSize(block));
+			block = previous;
+			nextPhysical(block)->prevPhysical = block;
+		}
+
+		S_TlsfBlock* next = nextPhysical(block);
+		if (isFree(next)) {
+			removeFree(next);
+			setBlockSize(block, blockSize(block) + HEADER_SIZE + blockSize(next));
+			nextPhysical(block)->prevPhysical = block;
+		}
+
+		insertFree(block);
+	}
+
+	size_t S_TlsfHeap::getAllocationSize(const void* pointer) const {
+		return pointer ? blockSize(blockFromPayload(pointer)) : 0;
+	}
+
+	S_TlsfHeapStats S_TlsfHeap::getStats() const {
+		std::lock_guard<std::mutex> lock(heapMutex);
+		S_TlsfHeapStats stats;
+		stats.poolBytes = poolBytes;
+		stats.usedBytes = usedBytes;
+		stats.allocationCount = allocationCount;
+		stats.bytesPerTag = bytesPerTag;
+
+		for (size_t fl = 0; fl < FL_INDEX_COUNT; ++fl) {
+			for (size_t sl = 0; sl < SL_INDEX_COUNT; ++sl) {
+				for (S_TlsfBlock* block = freeLists[fl][sl]; block; block = block->nextFree) {
+					stats.freeBytes += blockSize(block);
+					stats.largestFreeBlock = std::max(stats.largestFreeBlock, blockSize(block));
+				}
+			}
+		}
+		return stats;
+	}
+
+	bool S_TlsfHeap::validate() const {
+		std::lock_guard<std::mutex> lock(heapMutex);
+		size_t freeBlocksInPools = 0;
+		for (const S_Pool& pool : pools) {
+			S_TlsfBlock* previous = nullptr;
+			S_TlsfBlock* block = pool.firstBlock;
+			while (!isSentinel(block)) {
+				if (block->prevPhysical != previous) {
+					return false;
+				}
+				if (isFree(block)) {
+					if (previous && isFree(previous)) {
+						return false;
+					}
+					freeBlocksInPools++;
+				}
+				previous = block;
+				block = nextPhysical(block);
+				if (reinterpret_cast<std::byte*>(block) > static_cast<std::byte*>(pool.memory) + pool.bytes - HEADER_SIZE) {
+					return false;
+				}
+			}
+			if (block->prevPhysical != previous) {
+				return false;
+			}
+		}
+
+		size_t freeBlocksInLists = 0;
+		for (size_t fl = 0; fl < FL_INDEX_COUNT; ++fl) {
+			for (size_t sl = 0; sl < SL_INDEX_COUNT; ++sl) {
+				const bool listBit = (slBitmap[fl] & (1u << sl)) != 0;
+				if (listBit != (freeLists[fl][sl] != nullptr)) {
+					return false;
+				}
+				for (S_TlsfBlock* block = freeLists[fl][sl]; block; block = block->nextFree) {
+					size_t blockFl;
+					size_t blockSl;
+					mapping(blockSize(block), blockFl, blockSl);
+					if (!isFree(block) || blockFl != fl || blockSl != sl) {
+						return false;
+					}
+					freeBlocksInLists++;
+				}
+			}
+		}
+		return freeBlocksInPools == freeBlocksInLists;
+	}
+
+	void* S_TlsfHeap::do_allocate(size_t bytes, size_t alignment) {
+		return allocateTagged(bytes, alignment, defaultTag);
+	}
+
+	void S_TlsfHeap::do_deallocate(void* pointer, size_t, size_t) {
+		release(pointer);
+	}
+
+	bool S_TlsfHeap::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+		return this == &other;
+	}
+}
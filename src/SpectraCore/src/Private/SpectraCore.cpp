@@ -1,5 +1,12 @@
 #include "SpectraCore.h"
+#include "S_JobSystem.h"
+#include "S_MemoryTracker.h"
 
 void SPECTRA_CORE SpectraCoreInit() {
+	spectra::core::jobs::S_JobSystem::getInstance().initialize();
+}
 
+void SPECTRA_CORE SpectraCoreShutdown() {
+	spectra::core::jobs::S_JobSystem::getInstance().shutdown();
+	spectra::core::memory::S_MemoryTracker::publishStats();
 }
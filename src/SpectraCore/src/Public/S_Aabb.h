@@ -0,0 +1,65 @@
+#pragma once
+#include <limits>
+
+#include "S_Vec3.h"
+
+namespace spectra::core::math {
+	// Axis-aligned bounding box. Default constructed boxes are empty and absorb
+	// the first point or box they are extended with.
+	struct S_Aabb {
+		S_Vec3 min{ std::numeric_limits<float>::infinity() };
+		S_Vec3 max{ -std::numeric_limits<float>::infinity() };
+
+		constexpr S_Aabb() = default;
+		constexpr S_Aabb(const S_Vec3& min, const S_Vec3& max) : min(min), max(max) {}
+
+		constexpr void extend(const S_Vec3& point) {
+			min = math::min(min, point);
+			max = math::max(max, point);
+		}
+
+		constexpr void extend(const S_Aabb& other) {
+			min = math::min(min, other.min);
+			max = math::max(max, other.max);
+		}
+
+		[[nodiscard]] constexpr bool isEmpty() const {
+			return min.x > max.x || min.y > max.y || min.z > max.z;
+		}
+
+		[[nodiscard]] constexpr S_Vec3 extent() const {
+			return max - min;
+		}
+
+		[[nodiscard]] constexpr S_Vec3 centroid() const {
+			return (min + max) * 0.5f;
+		}
+
+		// Zero for empty boxes, which keeps SAH sums well defined
+		[[nodiscard]] constexpr float surfaceArea() const {
+			if (isEmpty()) {
+				return 0.0f;
+			}
+			const S_Vec3 size = extent();
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		[[nodiscard]] constexpr int largestAxis() const {
+			const S_Vec3 size = extent();
+			return size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+		}
+
+		[[nodiscard]] constexpr S_Aabb intersection(const S_Aabb& other) const {
+			return { math::max(min, other.min), math::min(max, other.max) };
+		}
+
+		[[nodiscard]] constexpr bool contains(const S_Aabb& other) const {
+			return other.min.x >= min.x && other.min.y >= min.y && other.min.z >= min.z
+				&& other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+		}
+	};
+
+	[[nodiscard]] constexpr S_Aabb merge(const S_Aabb& a, const S_Aabb& b) {
+		return { min(a.min, b.min), max(a.max, b.max) };
+	}
+}
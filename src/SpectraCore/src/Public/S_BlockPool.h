@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "SpectraCore.h"
+#include "S_MemoryTracker.h"
+
+namespace spectra::core::memory {
+	// Pool of equally sized blocks. Allocation and release are lock-free (Treiber stack with
+	// an ABA tag packed next to the pointer); only growing by a new chunk takes a lock.
+	// Blocks may be released from any thread. Chunks are returned upstream on destruction.
+	class SPECTRA_CORE S_BlockPool : public std::pmr::memory_resource {
+		struct S_FreeBlock {
+			S_FreeBlock* next;
+		};
+
+		// Low 48 bits: block address, high 16 bits: ABA tag. User-space addresses on
+		// x64 and AArch64 fit in 48 bits.
+		std::atomic<uint64_t> freeHead{ 0 };
+		size_t blockSize;
+		size_t blockAlignment;
+		size_t blocksPerChunk;
+		E_MemoryTag tag;
+		std::pmr::memory_resource* upstream;
+		std::mutex growMutex;
+		std::vector<void*> chunks;
+		std::atomic<size_t> chunkCount{ 0 };
+
+		static constexpr uint64_t POINTER_MASK = (uint64_t{ 1 } << 48) - 1;
+
+		void pushList(S_FreeBlock* first, S_FreeBlock* last);
+		S_FreeBlock* popBlock();
+		void* grow();
+
+	public:
+		static_assert(sizeof(void*) == 8, "S_BlockPool packs pointers into 48 bits");
+
+		explicit S_BlockPool(size_t blockSize, size_t blockAlignment = alignof(std::max_align_t), size_t blocksPerChunk = 256,
+			E_MemoryTag tag = E_MemoryTag::GENERAL, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		~S_BlockPool() override;
+
+		S_BlockPool(const S_BlockPool&) = delete;
+		S_BlockPool& operator=(const S_BlockPool&) = delete;
+
+		[[nodiscard]] void* allocateBlock();
+		void releaseBlock(void* block);
+
+		[[nodiscard]] size_t getBlockSize() const;
+		[[nodiscard]] size_t getBlockAlignment() const;
+		[[nodiscard]] size_t getCapacity() const;  // Blocks carved so far
+		[[nodiscard]] E_MemoryTag getTag() const;
+
+	protected:
+		// Requests must fit in one block; larger ones are a programming error
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+}
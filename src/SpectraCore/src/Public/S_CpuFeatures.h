@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::platform {
+	// Instruction sets usable on this machine. A flag is only set when both the CPU reports
+	// the extension and the OS saves the matching register state, so it is safe to dispatch on.
+	struct SPECTRA_CORE S_CpuFeatures {
+		bool sse42 = false;
+		bool avx = false;
+		bool avx2 = false;
+		bool fma = false;
+		bool avx512f = false;
+		bool avx512vl = false;
+		bool avx512bw = false;
+		bool avx512dq = false;
+
+		// AVX2 with FMA, the baseline for 8-wide kernels
+		[[nodiscard]] bool hasAvx2Fma() const { return avx2 && fma; }
+
+		// The AVX-512 subsets the 16-wide kernels are compiled for
+		[[nodiscard]] bool hasAvx512() const { return avx512f && avx512vl && avx512bw && avx512dq; }
+
+		// Detected once, on first use
+		[[nodiscard]] static const S_CpuFeatures& get();
+
+		// "SSE4.2 AVX AVX2 FMA AVX512F ..." for logs
+		[[nodiscard]] std::string toString() const;
+	};
+}
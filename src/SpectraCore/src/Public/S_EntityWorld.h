@@ -0,0 +1,266 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "SpectraCore.h"
+#include "S_BlockPool.h"
+#include "S_JobSystem.h"
+
+namespace spectra::core::ecs {
+	// Generational handle. Stays valid while the entity moves between chunks and archetypes,
+	// and stops matching once the entity is destroyed and its index reused.
+	struct S_Entity {
+		static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+		uint32_t index = INVALID_INDEX;
+		uint32_t generation = 0;
+
+		[[nodiscard]] constexpr bool isValid() const { return index != INVALID_INDEX; }
+		constexpr bool operator==(const S_Entity& other) const = default;
+	};
+
+	// One bit per registered component
+	using ComponentMask = uint64_t;
+
+	// Typed id handed out by S_EntityWorld::registerComponent(). Ids belong to one world, so a
+	// C++ type can back several components, e.g. local and world transforms.
+	template<typename T>
+	struct S_ComponentType {
+		uint32_t id = 0xFFFFFFFFu;
+
+		[[nodiscard]] constexpr ComponentMask mask() const { return ComponentMask{ 1 } << id; }
+	};
+
+	// Entities that have every component in all and none of the components in none
+	struct S_Query {
+		ComponentMask all = 0;
+		ComponentMask none = 0;
+	};
+
+	struct S_EntityWorldStats {
+		uint32_t entityCount = 0;
+		uint32_t componentCount = 0;
+		uint32_t archetypeCount = 0;
+		uint32_t chunkCount = 0;
+		size_t chunkBytes = 0;
+		double occupancy = 0.0;  // Live entities over the capacity of allocated chunks
+	};
+
+	struct S_Archetype;
+	class S_EntityWorld;
+
+	// One chunk of one archetype as a system sees it. Columns hold getCount() elements in the
+	// row order of getEntities(). Views are invalidated by structural changes.
+	class SPECTRA_CORE S_ChunkView {
+	public:
+		[[nodiscard]] uint32_t getCount() const;
+		[[nodiscard]] ComponentMask getComponents() const;
+		[[nodiscard]] std::span<const S_Entity> getEntities() const;
+
+		template<typename T>
+		[[nodiscard]] bool has(S_ComponentType<T> type) const {
+			return (components & type.mask()) != 0;
+		}
+
+		// Empty when the chunk's archetype lacks the component
+		template<typename T>
+		[[nodiscard]] std::span<const T> read(S_ComponentType<T> type) const {
+			const void* column = getColumn(type.id, false);
+			return column ? std::span<const T>(static_cast<const T*>(column), count) : std::span<const T>();
+		}
+
+		// Like read(), and stamps the column with the world's current version
+		template<typename T>
+		[[nodiscard]] std::span<T> write(S_ComponentType<T> type) const {
+			void* column = getColumn(type.id, true);
+			return column ? std::span<T>(static_cast<T*>(column), count) : std::span<T>();
+		}
+
+		// Whether the column was written, or rows were added or moved in, after version
+		template<typename T>
+		[[nodiscard]] bool hasChangedSince(S_ComponentType<T> type, uint32_t version) const {
+			return getColumnVersion(type.id) > version;
+		}
+
+	private:
+		friend class S_EntityWorld;
+
+		S_Archetype* archetype = nullptr;
+		uint32_t chunk = 0;
+		uint32_t count = 0;
+		ComponentMask components = 0;
+		uint32_t version = 0;
+
+		void* getColumn(uint32_t component, bool write) const;
+		uint32_t getColumnVersion(uint32_t component) const;
+	};
+
+	// Entity storage grouped by archetype, the exact set of components an entity has. Each
+	// archetype keeps its entities in CHUNK_BYTES chunks laid out as one array per component,
+	// so systems stream through exactly the columns they touch. Chunks stay densely packed:
+	// removing a row fills it from the archetype's last chunk.
+	//
+	// Change tracking is per chunk and column. Writes stamp the column with getVersion(); a
+	// system that remembers the version returned by advanceVersion() sees every later write.
+	// Structural changes must happen outside of chunk iteration.
+	class SPECTRA_CORE S_EntityWorld {
+	public:
+		static constexpr uint32_t MAX_COMPONENTS = 64;
+		static constexpr size_t CHUNK_BYTES = 16384;
+		static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+		// Chunks come from a block pool tracked under E_MemoryTag::SCENE
+		S_EntityWorld();
+		~S_EntityWorld();
+
+		S_EntityWorld(const S_EntityWorld&) = delete;
+		S_EntityWorld& operator=(const S_EntityWorld&) = delete;
+
+		// Components are plain data moved between chunks with memcpy. New rows start as a copy
+		// of defaultValue.
+		template<typename T>
+		S_ComponentType<T> registerComponent(std::string_view name, const T& defaultValue = T{}) {
+			static_assert(std::is_trivially_copyable_v<T>, "Components are moved between chunks with memcpy");
+			static_assert(alignof(T) <= CHUNK_ALIGNMENT, "Component is over-aligned for a chunk");
+			return { registerComponent(name, sizeof(T), alignof(T), &defaultValue) };
+		}
+
+		S_Entity create(ComponentMask components);
+
+		// Appends count new entities to entities, all in one archetype
+		void create(ComponentMask components, uint32_t count, std::vector<S_Entity>& entities);
+
+		// Ignores handles of entities that are already gone
+		void destroy(S_Entity entity);
+
+		[[nodiscard]] bool isAlive(S_Entity entity) const;
+		[[nodiscard]] ComponentMask getComponents(S_Entity entity) const;
+
+		// Moves the entity to the archetype with exactly these components. Kept components
+		// keep their values, added ones start from their defaults.
+		void setComponents(S_Entity entity, ComponentMask components);
+
+		template<typename T>
+		void add(S_Entity entity, S_ComponentType<T> type, const T& value) {
+			setComponents(entity, getComponents(entity) | type.mask());
+			if (void* component = getComponent(entity, type.id, true)) {
+				*static_cast<T*>(component) = value;
+			}
+		}
+
+		template<typename T>
+		void remove(S_Entity entity, S_ComponentType<T> type) {
+			setComponents(entity, getComponents(entity) & ~type.mask());
+		}
+
+		template<typename T>
+		[[nodiscard]] bool has(S_Entity entity, S_ComponentType<T> type) const {
+			return (getComponents(entity) & type.mask()) != 0;
+		}
+
+		// Null when the entity is gone or lacks the component
+		template<typename T>
+		[[nodiscard]] const T* get(S_Entity entity, S_ComponentType<T> type) const {
+			return static_cast<const T*>(const_cast<S_EntityWorld*>(this)->getComponent(entity, type.id, false));
+		}
+
+		// Like get(), and stamps the entity's chunk column as changed
+		template<typename T>
+		[[nodiscard]] T* getMutable(S_Entity entity, S_ComponentType<T> type) {
+			return static_cast<T*>(getComponent(entity, type.id, true));
+		}
+
+		template<typename T>
+		void set(S_Entity entity, S_ComponentType<T> type, const T& value) {
+			if (T* component = getMutable(entity, type)) {
+				*component = value;
+			}
+		}
+
+		// Chunks of every archetype matching the query, in archetype creation order
+		void collectChunks(const S_Query& query, std::vector<S_ChunkView>& chunks);
+
+		template<typename F>
+		void forEachChunk(const S_Query& query, F&& function) {
+			std::vector<S_ChunkView> chunks;
+			collectChunks(query, chunks);
+			for (S_ChunkView& chunk : chunks) {
+				function(chunk);
+			}
+		}
+
+		// Hands chunks to the job system, one job per chunk at most; the function must be safe
+		// to call concurrently for different chunks
+		template<typename F>
+		void parallelForEachChunk(const S_Query& query, F&& function) {
+			std::vector<S_ChunkView> chunks;
+			collectChunks(query, chunks);
+			jobs::S_JobSystem::getInstance().parallelFor(0, chunks.size(), [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					function(chunks[i]);
+				}
+			}, 1);
+		}
+
+		// Version stamped by writes from now on
+		[[nodiscard]] uint32_t getVersion() const;
+
+		// Closes the current version and returns it. Writes after the call compare greater.
+		uint32_t advanceVersion();
+
+		// Version of the last create, destroy or component set change
+		[[nodiscard]] uint32_t getStructureVersion() const;
+
+		[[nodiscard]] uint32_t getEntityCount() const;
+
+		// Largest entity index handed out so far plus one, for arrays indexed by S_Entity::index
+		[[nodiscard]] uint32_t getEntityCapacity() const;
+
+		[[nodiscard]] uint32_t getComponentCount() const;
+		[[nodiscard]] std::string_view getComponentName(uint32_t component) const;
+		[[nodiscard]] S_EntityWorldStats getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::core::ecs"
+		void publishStats() const;
+
+	private:
+		struct S_ComponentInfo {
+			std::string name;
+			size_t size = 0;
+			size_t alignment = 0;
+			std::vector<std::byte> defaultValue;
+		};
+
+		struct S_EntityRecord {
+			uint32_t archetype = 0;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+			uint32_t generation = 0;
+			bool alive = false;
+		};
+
+		memory::S_BlockPool chunkPool;
+		std::vector<S_ComponentInfo> components;
+		std::vector<std::unique_ptr<S_Archetype>> archetypes;
+		std::unordered_map<ComponentMask, uint32_t> archetypeByMask;
+		std::vector<S_EntityRecord> records;
+		std::vector<uint32_t> freeIndices;
+		uint32_t entityCount = 0;
+		uint32_t version = 1;
+		uint32_t structureVersion = 1;
+
+		uint32_t registerComponent(std::string_view name, size_t size, size_t alignment, const void* defaultValue);
+		void* getComponent(S_Entity entity, uint32_t component, bool write);
+		uint32_t findArchetype(ComponentMask mask);
+		S_Entity allocateEntity();
+		void appendRow(uint32_t archetype, S_Entity entity);
+		void removeRow(uint32_t archetype, uint32_t chunk, uint32_t row);
+	};
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::platform {
+	// Exclusive lock held through a lock file (LockFileEx on Windows, flock elsewhere), for
+	// work that processes on one machine must not interleave. The lock belongs to the open
+	// file, so two S_FileLock objects exclude each other even within one process.
+	class SPECTRA_CORE S_FileLock {
+		intptr_t handle = -1;  // HANDLE on Windows, a descriptor elsewhere
+		std::string path;
+		std::string lastError;
+
+	public:
+		S_FileLock() = default;
+		~S_FileLock();
+
+		S_FileLock(const S_FileLock&) = delete;
+		S_FileLock& operator=(const S_FileLock&) = delete;
+
+		// Creates the lock file if needed and blocks until the lock is held. Returns false on
+		// failure, see getLastError().
+		bool lock(const std::string& filePath);
+		void unlock();
+
+		[[nodiscard]] bool isLocked() const;
+		[[nodiscard]] const std::string& getLastError() const;
+	};
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::jobs {
+	class S_Counter;
+
+	// Unit of work. The callable lives inline in the payload so scheduling never boxes it.
+	struct alignas(64) S_Job {
+		static constexpr size_t PAYLOAD_SIZE = 96;
+
+		void (*invoke)(S_Job& job) = nullptr;  // Runs and then destroys the stored callable
+		S_Counter* counter = nullptr;          // Signalled after the job has run
+		S_Job* nextContinuation = nullptr;     // Intrusive link while parked on a dependency
+		alignas(16) unsigned char payload[PAYLOAD_SIZE];
+	};
+
+	// Number of outstanding jobs. Threads can wait on it and jobs can be parked on it as continuations.
+	class SPECTRA_CORE S_Counter {
+		std::atomic<int32_t> pending{ 0 };
+		std::atomic<int32_t> signalling{ 0 };  // Threads that decremented but may still touch the counter
+		std::atomic<bool> hasContinuations{ false };
+		std::mutex continuationMutex;
+		S_Job* continuations = nullptr;
+		std::mutex exceptionMutex;
+		std::exception_ptr exception;          // First exception thrown by one of its jobs
+
+		friend class S_JobSystem;
+
+	public:
+		S_Counter() = default;
+		~S_Counter() = default;
+		S_Counter(const S_Counter&) = delete;
+		S_Counter& operator=(const S_Counter&) = delete;
+
+		[[nodiscard]] int32_t value() const;
+
+		// True once every job has run and no thread still references the counter,
+		// so a counter on the stack may be destroyed as soon as this returns true.
+		[[nodiscard]] bool isDone() const;
+	};
+
+	struct S_JobSystemStats {
+		uint32_t threadCount = 0;
+		uint64_t jobsExecuted = 0;
+		uint64_t jobsStolen = 0;
+		uint64_t stealAttempts = 0;
+		uint64_t jobsInjected = 0;           // Submitted from threads outside the pool
+		uint64_t inlineExecutions = 0;       // Run immediately because the local deque was full
+		uint64_t continuationsReleased = 0;
+		double idleMilliseconds = 0.0;       // Time workers spent asleep
+		double waitMilliseconds = 0.0;       // Time spent inside waitForCounter
+		std::vector<uint64_t> jobsPerThread;
+	};
+
+	// Fixed pool of workers with one Chase-Lev deque each. The thread that calls initialize()
+	// becomes thread 0: it owns a deque too and executes jobs while it waits on a counter.
+	class SPECTRA_CORE S_JobSystem {
+	public:
+		static constexpr size_t DEQUE_CAPACITY = 4096;
+
+		static S_JobSystem& getInstance();
+
+		// workerThreads == 0 uses hardware_concurrency - 1 so the calling thread fills the last core
+		void initialize(uint32_t workerThreads = 0);
+		void shutdown();
+		[[nodiscard]] bool isRunning() const;
+
+		// Workers plus the initializing thread, 1 when the system is not running
+		[[nodiscard]] uint32_t getThreadCount() const;
+
+		// Index in [0, getThreadCount()) on pool threads, -1 on any other thread
+		[[nodiscard]] static int32_t getCurrentThreadIndex();
+
+		// Jobs run inline on the calling thread when the system is not running
+		template<typename F>
+		void run(F&& function, S_Counter* counter = nullptr);
+
+		// Parks the job until dependency reaches zero
+		template<typename F>
+		void runAfter(S_Counter& dependency, F&& function, S_Counter* counter = nullptr);
+
+		// Executes other jobs until the counter is done, then rethrows the first exception any
+		// of its jobs threw. Jobs without a counter that throw are logged as a WARNING.
+		void waitForCounter(S_Counter& counter);
+
+		// Runs one pending job on the calling thread, false when none was found.
+		// For loops that wait on something other than a counter.
+		bool executeNext();
+
+		// Calls function(chunkBegin, chunkEnd) over [begin, end) and blocks until all chunks ran.
+		// Ranges are split lazily, only while other threads are out of work, and never below minGrain.
+		// The first exception thrown by any chunk is rethrown here once every chunk has finished.
+		template<typename F>
+		void parallelFor(size_t begin, size_t end, F&& function, size_t minGrain = 1);
+
+		[[nodiscard]] S_JobSystemStats getStats() const;
+		void resetStats();
+
+		// Pushes the current stats to SpectraInstrumentation under "spectra::core::jobs"
+		void publishStats() const;
+
+		~S_JobSystem();
+		S_JobSystem(const S_JobSystem&) = delete;
+		S_JobSystem& operator=(const S_JobSystem&) = delete;
+
+	private:
+		struct S_WorkerContext;
+
+		std::vector<std::unique_ptr<S_WorkerContext>> workers;
+		std::mutex injectionMutex;
+		std::deque<S_Job*> injectionQueue;
+		std::atomic<size_t> injectionSize{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		std::atomic<uint32_t> sleepingWorkers{ 0 };
+		std::atomic<uint64_t> wakeEpoch{ 0 };
+		std::atomic<bool> running{ false };
+		std::atomic<bool> stopping{ false };
+		std::atomic<uint64_t> jobsInjected{ 0 };
+		std::atomic<uint64_t> continuationsReleased{ 0 };
+
+		S_JobSystem();
+
+		static S_Job* allocateJob();
+		static void releaseJob(S_Job* job);
+
+		template<typename F>
+		static S_Job* createJob(F&& function, S_Counter* counter);
+
+		template<typename F>
+		void splitRange(F* function, size_t begin, size_t end, size_t grain, S_Counter* counter);
+
+		void submit(S_Job* job);
+		void park(S_Counter& dependency, S_Job* job);
+		void releaseContinuations(S_Counter& counter);
+		void signal(S_Counter& counter);
+		static void recordException(S_Counter& counter, std::exception_ptr exception);
+		void execute(S_Job* job);
+		S_Job* findJob(int32_t index);
+		S_Job* steal(int32_t index);
+		bool shouldSplit() const;
+		bool hasVisibleWork() const;
+		void wakeWorkers(bool all);
+		void sleepUntilWork(S_WorkerContext& self);
+		void workerLoop(uint32_t index);
+		void stopWorkers();
+	};
+
+	template<typename F>
+	S_Job* S_JobSystem::createJob(F&& function, S_Counter* counter) {
+		using Fn = std::decay_t<F>;
+		static_assert(sizeof(Fn) <= S_Job::PAYLOAD_SIZE, "Job callable too large, capture by pointer instead");
+		static_assert(alignof(Fn) <= 16, "Job callable is over-aligned");
+
+		S_Job* job = allocateJob();
+		new (job->payload) Fn(std::forward<F>(function));
+		job->invoke = [](S_Job& self) {
+			Fn* stored = std::launder(reinterpret_cast<Fn*>(self.payload));
+			struct Destroy {
+				Fn* callable;
+				~Destroy() { callable->~Fn(); }
+			} destroy{ stored };
+			(*stored)();
+		};
+		job->counter = counter;
+		job->nextContinuation = nullptr;
+		if (counter) {
+			counter->pending.fetch_add(1, std::memory_order_seq_cst);
+		}
+		return job;
+	}
+
+	template<typename F>
+	void S_JobSystem::run(F&& function, S_Counter* counter) {
+		if (!isRunning()) {
+			function();
+			return;
+		}
+		submit(createJob(std::forward<F>(function), counter));
+	}
+
+	template<typename F>
+	void S_JobSystem::runAfter(S_Counter& dependency, F&& function, S_Counter* counter) {
+		if (!isRunning()) {
+			function();
+			return;
+		}
+		park(dependency, createJob(std::forward<F>(function), counter));
+	}
+
+	template<typename F>
+	void S_JobSystem::splitRange(F* function, size_t begin, size_t end, size_t grain, S_Counter* counter) {
+		while (begin < end) {
+			// Lazy binary splitting: only expose the upper half while someone could steal it
+			if (end - begin > grain && shouldSplit()) {
+				const size_t mid = begin + (end - begin) / 2;
+				run([this, function, mid, end, grain, counter]() {
+					splitRange(function, mid, end, grain, counter);
+				}, counter);
+				end = mid;
+				continue;
+			}
+
+			const size_t chunkEnd = std::min(end, begin + grain);
+			(*function)(begin, chunkEnd);
+			begin = chunkEnd;
+		}
+	}
+
+	template<typename F>
+	void S_JobSystem::parallelFor(size_t begin, size_t end, F&& function, size_t minGrain) {
+		if (begin >= end) {
+			return;
+		}
+
+		// Aim for roughly eight chunks per thread so stealing can balance uneven work
+		const size_t count = end - begin;
+		const size_t grain = std::max<size_t>({ minGrain, size_t{ 1 }, count / (static_cast<size_t>(getThreadCount()) * 8) });
+		if (count <= grain || getThreadCount() == 1) {
+			function(begin, end);
+			return;
+		}
+
+		using Fn = std::remove_reference_t<F>;
+		Fn* callable = &function;
+		S_Counter counter;
+		try {
+			splitRange(callable, begin, end, grain, &counter);
+		}
+		catch (...) {
+			// Queued chunks still reference counter and callable on this frame, so wait for them
+			recordException(counter, std::current_exception());
+		}
+		waitForCounter(counter);
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "SpectraCore.h"
+#include "S_MemoryTracker.h"
+
+namespace spectra::core::memory {
+	// Position in a linear arena, used to roll back everything allocated after it
+	struct S_ArenaMarker {
+		void* block = nullptr;
+		size_t offset = 0;
+		size_t previousBlocksBytes = 0;
+	};
+
+	// Bump allocator over a chain of blocks. Individual frees are no-ops; memory is
+	// reclaimed with reset() or resetToMarker(). Blocks are kept across resets, so once
+	// the arena has seen its peak usage it never calls the upstream resource again.
+	// Not thread-safe: use one arena per thread or the thread-local scratch arena.
+	class SPECTRA_CORE S_LinearArena : public std::pmr::memory_resource {
+		struct S_ArenaBlock {
+			S_ArenaBlock* next;
+			size_t capacity;
+		};
+
+		S_ArenaBlock* firstBlock = nullptr;
+		S_ArenaBlock* currentBlock = nullptr;
+		size_t offset = 0;
+		size_t previousBlocksBytes = 0;  // Capacity of the blocks before currentBlock
+		size_t blockSize;
+		size_t reservedBytes = 0;
+		size_t peakUsedBytes = 0;
+		E_MemoryTag tag;
+		std::pmr::memory_resource* upstream;
+
+		void* allocateSlow(size_t bytes, size_t alignment);
+		static std::byte* dataOf(S_ArenaBlock* block) {
+			return reinterpret_cast<std::byte*>(block + 1);
+		}
+
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
+		explicit S_LinearArena(size_t blockSize = DEFAULT_BLOCK_SIZE, E_MemoryTag tag = E_MemoryTag::GENERAL,
+			std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		~S_LinearArena() override;
+
+		S_LinearArena(const S_LinearArena&) = delete;
+		S_LinearArena& operator=(const S_LinearArena&) = delete;
+
+		// Fast path stays inline: one add, one compare
+		void* allocateRaw(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+			if (currentBlock) {
+				const uintptr_t base = reinterpret_cast<uintptr_t>(dataOf(currentBlock));
+				const uintptr_t start = alignUp(base + offset, alignment);
+				if (start + bytes <= base + currentBlock->capacity) {
+					offset = start + bytes - base;
+					return reinterpret_cast<void*>(start);
+				}
+			}
+			return allocateSlow(bytes, alignment);
+		}
+
+		// Uninitialized storage; the arena never runs destructors
+		template<typename T>
+		T* allocateArray(size_t count) {
+			static_assert(std::is_trivially_destructible_v<T>, "Arena memory is released without running destructors");
+			return static_cast<T*>(allocateRaw(sizeof(T) * count, alignof(T)));
+		}
+
+		template<typename T, typename... Args>
+		T* create(Args&&... args) {
+			static_assert(std::is_trivially_destructible_v<T>, "Arena memory is released without running destructors");
+			return new (allocateRaw(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		[[nodiscard]] S_ArenaMarker getMarker() const;
+		void resetToMarker(const S_ArenaMarker& marker);
+		void reset();
+
+		[[nodiscard]] size_t getUsedBytes() const;
+		[[nodiscard]] size_t getReservedBytes() const;
+		[[nodiscard]] size_t getPeakUsedBytes() const;
+		[[nodiscard]] E_MemoryTag getTag() const;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+
+	// One linear arena per frame in flight. beginFrame() rotates to the next arena and
+	// resets it, so data allocated in a frame stays valid until that slot comes around again.
+	class SPECTRA_CORE S_FrameArenas {
+		std::vector<std::unique_ptr<S_LinearArena>> arenas;
+		size_t currentIndex = 0;
+
+	public:
+		explicit S_FrameArenas(size_t framesInFlight = 2, size_t blockSize = S_LinearArena::DEFAULT_BLOCK_SIZE,
+			E_MemoryTag tag = E_MemoryTag::RENDER);
+		S_FrameArenas(const S_FrameArenas&) = delete;
+		S_FrameArenas& operator=(const S_FrameArenas&) = delete;
+
+		S_LinearArena& beginFrame();
+		[[nodiscard]] S_LinearArena& current();
+		[[nodiscard]] size_t getFramesInFlight() const;
+	};
+
+	// Scope over the calling thread's scratch arena. Everything allocated through it
+	// is released when the scope ends, so scratch memory must not escape the scope.
+	class SPECTRA_CORE S_ScratchScope {
+		S_LinearArena& arena;
+		S_ArenaMarker marker;
+
+	public:
+		static constexpr size_t SCRATCH_BLOCK_SIZE = 256 * 1024;
+
+		S_ScratchScope();
+		~S_ScratchScope();
+
+		S_ScratchScope(const S_ScratchScope&) = delete;
+		S_ScratchScope& operator=(const S_ScratchScope&) = delete;
+
+		[[nodiscard]] S_LinearArena& getArena();
+
+		void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+			return arena.allocateRaw(bytes, alignment);
+		}
+
+		template<typename T>
+		T* allocateArray(size_t count) {
+			return arena.allocateArray<T>(count);
+		}
+
+		// Lazily created on first use and tagged SCRATCH
+		[[nodiscard]] static S_LinearArena& getThreadArena();
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::platform {
+	// Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere).
+	// Pages are loaded on first touch and shared between processes mapping the same file.
+	class SPECTRA_CORE S_MappedFile {
+		const std::byte* data = nullptr;
+		size_t size = 0;
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+		std::string path;
+		std::string lastError;
+
+	public:
+		S_MappedFile() = default;
+		~S_MappedFile();
+
+		S_MappedFile(const S_MappedFile&) = delete;
+		S_MappedFile& operator=(const S_MappedFile&) = delete;
+		S_MappedFile(S_MappedFile&& other) noexcept;
+		S_MappedFile& operator=(S_MappedFile&& other) noexcept;
+
+		// Returns false on failure, see getLastError(). Empty files cannot be mapped.
+		bool open(const std::string& filePath);
+		void close();
+
+		[[nodiscard]] bool isOpen() const;
+		[[nodiscard]] const std::byte* getData() const;
+		[[nodiscard]] size_t getSize() const;
+
+		[[nodiscard]] const std::string& getPath() const;
+		[[nodiscard]] const std::string& getLastError() const;
+	};
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::memory {
+	// Subsystem that owns an allocation, used to attribute memory in stats
+	enum class SPECTRA_CORE E_MemoryTag : uint8_t {
+		GENERAL = 0,
+		JOBS,
+		SCRATCH,
+		RENDER,
+		GEOMETRY,
+		TEXTURES,
+		MATERIALS,
+		SCENE,
+		STREAMING,
+		UI,
+		COUNT
+	};
+
+	struct S_MemoryTagStats {
+		uint64_t currentBytes = 0;
+		uint64_t peakBytes = 0;
+		uint64_t activeAllocations = 0;
+		uint64_t totalAllocations = 0;
+	};
+
+	// Process-wide per-tag accounting. Every allocator in this module reports here:
+	// arenas and pools per reserved block, heaps and tracked resources per allocation.
+	class SPECTRA_CORE S_MemoryTracker {
+	public:
+		static void recordAllocation(E_MemoryTag tag, size_t bytes);
+		static void recordDeallocation(E_MemoryTag tag, size_t bytes, size_t allocations = 1);
+
+		[[nodiscard]] static S_MemoryTagStats getStats(E_MemoryTag tag);
+		[[nodiscard]] static const char* getTagName(E_MemoryTag tag);
+
+		// Pushes per-tag gauges to SpectraInstrumentation under "spectra::core::memory"
+		static void publishStats();
+	};
+
+	// Forwards to an upstream resource and records every allocation against a tag.
+	// Lets plain std::pmr containers show up in the per-subsystem stats.
+	class SPECTRA_CORE S_TrackedResource final : public std::pmr::memory_resource {
+		E_MemoryTag tag;
+		std::pmr::memory_resource* upstream;
+
+	public:
+		explicit S_TrackedResource(E_MemoryTag tag, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+		[[nodiscard]] E_MemoryTag getTag() const;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+
+	[[nodiscard]] constexpr size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::modules {
+	using ModuleFunction = void(*)();
+
+	enum class SPECTRA_CORE E_ModuleLoad : uint8_t {
+		EAGER = 0,   // Initialized by initializeAll()
+		LAZY         // Loaded from its shared library on the first require()
+	};
+
+	enum class SPECTRA_CORE E_ModuleState : uint8_t {
+		REGISTERED = 0,
+		INITIALIZING,
+		READY,
+		FAILED,
+		SHUTDOWN
+	};
+
+	struct S_ModuleDesc {
+		std::string name;
+		std::vector<std::string> dependencies;
+		ModuleFunction init = nullptr;
+		ModuleFunction shutdown = nullptr;
+		E_ModuleLoad load = E_ModuleLoad::EAGER;
+
+		// Set for modules that must not run on a worker, e.g. the one that starts the job system
+		bool mainThreadOnly = false;
+
+		// Resolved from the module's shared library when init is null. The symbols
+		// need C linkage, libraryName is the target name without prefix or extension.
+		std::string libraryName;
+		std::string initSymbol;
+		std::string shutdownSymbol;
+	};
+
+	struct S_ModuleTiming {
+		std::string name;
+		double startMilliseconds = 0.0;  // Since the registry was created
+		double loadMilliseconds = 0.0;   // Opening the shared library, lazy modules only
+		double initMilliseconds = 0.0;
+		int32_t threadIndex = -1;
+		bool lazy = false;
+		E_ModuleState state = E_ModuleState::REGISTERED;
+	};
+
+	// Record per registered module, defined in S_ModuleRegistry.cpp
+	struct S_ModuleRecord;
+
+	// Startup graph of the engine's modules. Modules declare their dependencies and the
+	// registry initializes them in dependency order; modules whose dependencies are met
+	// run concurrently on the job system once SpectraCore has started it. Register every
+	// module before initializeAll(), registration is not thread-safe.
+	class SPECTRA_CORE S_ModuleRegistry {
+	public:
+		static S_ModuleRegistry& getInstance();
+
+		void registerModule(S_ModuleDesc desc);
+
+		// Initializes every eager module and everything it depends on. Logs an ERROR
+		// for missing dependencies, cycles and modules that failed to initialize.
+		void initializeAll();
+
+		// Initializes a module and its dependencies on first use, cheap once it is ready.
+		// Thread-safe.
+		void require(const std::string& name);
+
+		// Shuts modules down in the reverse of their initialization order
+		void shutdownAll();
+
+		[[nodiscard]] bool isRegistered(const std::string& name) const;
+		[[nodiscard]] E_ModuleState getState(const std::string& name) const;
+
+		// In initialization order, followed by modules that were not initialized
+		[[nodiscard]] std::vector<S_ModuleTiming> getTimings() const;
+		[[nodiscard]] std::string getStartupReport() const;
+
+		// Pushes startup totals to SpectraInstrumentation under "spectra::core::modules".
+		// Per-module init times are recorded there as timings when each module finishes.
+		void publishTimings() const;
+
+		~S_ModuleRegistry();
+		S_ModuleRegistry(const S_ModuleRegistry&) = delete;
+		S_ModuleRegistry& operator=(const S_ModuleRegistry&) = delete;
+
+	private:
+		std::vector<std::unique_ptr<S_ModuleRecord>> records;
+		std::unordered_map<std::string, size_t> recordIndices;
+		std::vector<S_ModuleRecord*> initializationOrder;
+		mutable std::mutex orderMutex;
+		std::mutex requireMutex;
+		std::mutex mainQueueMutex;
+		std::vector<S_ModuleRecord*> mainQueue;
+		std::atomic<size_t> pendingModules{ 0 };
+		std::once_flag resolveFlag;
+		std::chrono::steady_clock::time_point creationTime;
+		double startupWallMilliseconds = 0.0;
+		uint32_t startupThreadCount = 1;
+
+		S_ModuleRegistry();
+
+		S_ModuleRecord* find(const std::string& name) const;
+		void resolveDependencies();
+		void collectClosure(S_ModuleRecord* record, std::vector<S_ModuleRecord*>& closure, std::vector<uint8_t>& visited) const;
+		void dispatch(S_ModuleRecord* record);
+		void runModule(S_ModuleRecord* record);
+		void finishModule(S_ModuleRecord* record);
+		void initializeModule(S_ModuleRecord* record);
+		void waitWhileScheduled(S_ModuleRecord* record);
+		void reportFailures(const std::vector<S_ModuleRecord*>& modules, const char* subComponent) const;
+		double millisecondsSinceStart() const;
+	};
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <limits>
+
+#include "S_Vec3.h"
+
+namespace spectra::core::math {
+	// Half-open segment origin + t * direction for t in [tMin, tMax)
+	struct S_Ray {
+		S_Vec3 origin;
+		S_Vec3 direction;
+		float tMin = 0.0f;
+		float tMax = std::numeric_limits<float>::infinity();
+
+		[[nodiscard]] constexpr S_Vec3 at(float t) const {
+			return origin + direction * t;
+		}
+	};
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SpectraCore.h"
+#include "S_MappedFile.h"
+#include "S_Spectrum.h"
+#include "S_Vec3.h"
+
+namespace spectra::core::math {
+	// Smooth, bounded reflectance spectrum sigmoid(c0 * lambda^2 + c1 * lambda + c2), lambda in
+	// nanometres (Jakob and Hanika 2019). Three floats per RGB colour, always within [0, 1].
+	struct S_RgbSigmoidPolynomial {
+		float c0 = 0.0f;
+		float c1 = 0.0f;
+		float c2 = 0.0f;
+
+		[[nodiscard]] static float sigmoid(float x) {
+			if (std::isinf(x)) {
+				return x > 0.0f ? 1.0f : 0.0f;
+			}
+			return 0.5f + x / (2.0f * std::sqrt(1.0f + x * x));
+		}
+
+		[[nodiscard]] float evaluate(float lambda) const {
+			return sigmoid((c0 * lambda + c1) * lambda + c2);
+		}
+
+		[[nodiscard]] S_SampledSpectrum sample(const S_SampledWavelengths& wavelengths) const {
+			S_SampledSpectrum result;
+			for (uint32_t i = 0; i < SPECTRUM_SAMPLES; ++i) {
+				result[i] = evaluate(wavelengths.lambda[i]);
+			}
+			return result;
+		}
+	};
+
+	// Precomputed sigmoid-polynomial coefficients over the sRGB gamut, indexed by the largest
+	// channel, its value and the other two channels relative to it. Generating the table solves
+	// a small Gauss-Newton fit per entry, so it is done once and cached as a flat binary file
+	// that later runs map into memory instead of reading.
+	class SPECTRA_CORE S_RgbToSpectrumTable {
+		uint32_t resolution = 0;
+		const float* scale = nullptr;         // Largest-channel value at each z node, [resolution]
+		const float* coefficients = nullptr;  // [3][resolution z][resolution y][resolution x][3]
+		std::vector<float> owned;             // Backing storage when generated rather than mapped
+		platform::S_MappedFile mapping;
+
+		void bindOwned();
+
+	public:
+		static constexpr uint32_t DEFAULT_RESOLUTION = 64;
+
+		S_RgbToSpectrumTable() = default;
+		S_RgbToSpectrumTable(const S_RgbToSpectrumTable&) = delete;
+		S_RgbToSpectrumTable& operator=(const S_RgbToSpectrumTable&) = delete;
+
+		// Fits every entry, in parallel on the job system when it is running
+		void generate(uint32_t tableResolution = DEFAULT_RESOLUTION);
+
+		// Maps a table written by save(). Returns false when the file is missing or does not
+		// match the current format, leaving the table unchanged.
+		bool load(const std::string& path);
+
+		// Writes to a temporary file and renames it over path, so readers never map a partial table
+		bool save(const std::string& path) const;
+
+		// load(), falling back to generate() and save() when the cache is missing or stale
+		void loadOrGenerate(const std::string& cachePath, uint32_t tableResolution = DEFAULT_RESOLUTION);
+
+		// Maps the first valid cache in order; otherwise generates and saves to the first
+		// writable path, so read-only installs fall back to later locations
+		void loadOrGenerate(const std::vector<std::string>& cachePaths, uint32_t tableResolution = DEFAULT_RESOLUTION);
+
+		[[nodiscard]] bool isReady() const;
+		[[nodiscard]] bool isMapped() const;
+		[[nodiscard]] const std::string& getCachePath() const;  // Of the mapped file, empty when not mapped
+		[[nodiscard]] uint32_t getResolution() const;
+
+		// Reflectance spectrum whose sRGB colour under the sRGB white is rgb, clamped to [0, 1]
+		[[nodiscard]] S_RgbSigmoidPolynomial lookup(const S_Vec3& rgb) const;
+
+		[[nodiscard]] S_SampledSpectrum sampleAlbedo(const S_Vec3& rgb, const S_SampledWavelengths& wavelengths) const;
+
+		// Any non-negative rgb, e.g. scattering coefficients: the polynomial for rgb / (2 * max)
+		// scaled back up
+		[[nodiscard]] S_SampledSpectrum sampleUnbounded(const S_Vec3& rgb, const S_SampledWavelengths& wavelengths) const;
+
+		// Emission of an rgb light, the unbounded spectrum times the sRGB white illuminant
+		[[nodiscard]] S_SampledSpectrum sampleIlluminant(const S_Vec3& rgb, const S_SampledWavelengths& wavelengths) const;
+
+		// Shared sRGB table, loaded on first use. initializeSRGB() picks the cache location
+		// when called before getSRGB(); otherwise the default paths are used.
+		static void initializeSRGB(const std::string& cachePath);
+		[[nodiscard]] static const S_RgbToSpectrumTable& getSRGB();
+
+		// Beside the executable, then the per-user cache directory, then the temp directory
+		[[nodiscard]] static std::vector<std::string> getDefaultCachePaths();
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::platform {
+	// Runtime-loaded shared library (LoadLibrary on Windows, dlopen elsewhere).
+	// Closes the library on destruction.
+	class SPECTRA_CORE S_SharedLibrary {
+		void* handle = nullptr;
+		std::string path;
+		std::string lastError;
+
+	public:
+		S_SharedLibrary() = default;
+		~S_SharedLibrary();
+
+		S_SharedLibrary(const S_SharedLibrary&) = delete;
+		S_SharedLibrary& operator=(const S_SharedLibrary&) = delete;
+		S_SharedLibrary(S_SharedLibrary&& other) noexcept;
+		S_SharedLibrary& operator=(S_SharedLibrary&& other) noexcept;
+
+		// Returns false on failure, see getLastError()
+		bool open(const std::string& libraryPath);
+		void close();
+
+		[[nodiscard]] bool isOpen() const;
+
+		// Symbols must have C linkage to be found by name
+		[[nodiscard]] void* getSymbol(const std::string& name);
+
+		[[nodiscard]] const std::string& getPath() const;
+		[[nodiscard]] const std::string& getLastError() const;
+
+		// "SpectraMaterials" -> "SpectraMaterials.dll" / "libSpectraMaterials.so" / "libSpectraMaterials.dylib"
+		[[nodiscard]] static std::string getPlatformFileName(const std::string& moduleName);
+
+		// Directory of the running executable, with a trailing separator
+		[[nodiscard]] static std::string getExecutableDirectory();
+	};
+}
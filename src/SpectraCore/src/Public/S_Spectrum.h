@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "S_Vec3.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPECTRA_SPECTRUM_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace spectra::core::math {
+	// Wavelengths per path. Four fill one SSE register, the hero wavelength plus three
+	// evenly rotated companions (Wilkie et al. 2014).
+	constexpr uint32_t SPECTRUM_SAMPLES = 4;
+	constexpr float LAMBDA_MIN = 360.0f;  // Nanometres
+	constexpr float LAMBDA_MAX = 830.0f;
+
+	// Radiance or reflectance at the wavelengths of one S_SampledWavelengths, one lane each.
+	// Header-only SSE with a scalar fallback so path tracers keep it in a register.
+	struct alignas(16) S_SampledSpectrum {
+		float values[SPECTRUM_SAMPLES] = {};
+
+		constexpr S_SampledSpectrum() = default;
+		constexpr explicit S_SampledSpectrum(float value) : values{ value, value, value, value } {}
+		constexpr S_SampledSpectrum(float a, float b, float c, float d) : values{ a, b, c, d } {}
+
+		[[nodiscard]] constexpr float operator[](uint32_t i) const { return values[i]; }
+		[[nodiscard]] constexpr float& operator[](uint32_t i) { return values[i]; }
+
+#if defined(SPECTRA_SPECTRUM_SSE)
+		[[nodiscard]] __m128 load() const { return _mm_load_ps(values); }
+		static S_SampledSpectrum fromRegister(__m128 lanes) {
+			S_SampledSpectrum result;
+			_mm_store_ps(result.values, lanes);
+			return result;
+		}
+#define SPECTRA_SPECTRUM_LANES(sse, scalar) return fromRegister(sse)
+#else
+#define SPECTRA_SPECTRUM_LANES(sse, scalar) \
+	S_SampledSpectrum result; \
+	for (uint32_t i = 0; i < SPECTRUM_SAMPLES; ++i) { result.values[i] = scalar; } \
+	return result
+#endif
+
+		S_SampledSpectrum operator+(const S_SampledSpectrum& o) const { SPECTRA_SPECTRUM_LANES(_mm_add_ps(load(), o.load()), values[i] + o.values[i]); }
+		S_SampledSpectrum operator-(const S_SampledSpectrum& o) const { SPECTRA_SPECTRUM_LANES(_mm_sub_ps(load(), o.load()), values[i] - o.values[i]); }
+		S_SampledSpectrum operator*(const S_SampledSpectrum& o) const { SPECTRA_SPECTRUM_LANES(_mm_mul_ps(load(), o.load()), values[i] * o.values[i]); }
+		S_SampledSpectrum operator*(float s) const { SPECTRA_SPECTRUM_LANES(_mm_mul_ps(load(), _mm_set1_ps(s)), values[i] * s); }
+		S_SampledSpectrum operator/(float s) const { return *this * (1.0f / s); }
+
+		// Lanes with a zero divisor become zero, as for terminated secondary wavelengths
+		S_SampledSpectrum operator/(const S_SampledSpectrum& o) const {
+			SPECTRA_SPECTRUM_LANES(_mm_and_ps(_mm_div_ps(load(), o.load()), _mm_cmpneq_ps(o.load(), _mm_setzero_ps())),
+				o.values[i] != 0.0f ? values[i] / o.values[i] : 0.0f);
+		}
+
+		S_SampledSpectrum& operator+=(const S_SampledSpectrum& o) { return *this = *this + o; }
+		S_SampledSpectrum& operator-=(const S_SampledSpectrum& o) { return *this = *this - o; }
+		S_SampledSpectrum& operator*=(const S_SampledSpectrum& o) { return *this = *this * o; }
+		S_SampledSpectrum& operator*=(float s) { return *this = *this * s; }
+		S_SampledSpectrum& operator/=(const S_SampledSpectrum& o) { return *this = *this / o; }
+		S_SampledSpectrum& operator/=(float s) { return *this = *this / s; }
+
+		friend S_SampledSpectrum min(const S_SampledSpectrum& a, const S_SampledSpectrum& b) {
+			SPECTRA_SPECTRUM_LANES(_mm_min_ps(a.load(), b.load()), std::min(a.values[i], b.values[i]));
+		}
+		friend S_SampledSpectrum max(const S_SampledSpectrum& a, const S_SampledSpectrum& b) {
+			SPECTRA_SPECTRUM_LANES(_mm_max_ps(a.load(), b.load()), std::max(a.values[i], b.values[i]));
+		}
+		friend S_SampledSpectrum sqrt(const S_SampledSpectrum& s) {
+			SPECTRA_SPECTRUM_LANES(_mm_sqrt_ps(s.load()), std::sqrt(s.values[i]));
+		}
+#undef SPECTRA_SPECTRUM_LANES
+
+		[[nodiscard]] bool isBlack() const {
+#if defined(SPECTRA_SPECTRUM_SSE)
+			return _mm_movemask_ps(_mm_cmpneq_ps(load(), _mm_setzero_ps())) == 0;
+#else
+			return values[0] == 0.0f && values[1] == 0.0f && values[2] == 0.0f && values[3] == 0.0f;
+#endif
+		}
+
+		[[nodiscard]] float average() const {
+			return (values[0] + values[1] + values[2] + values[3]) * (1.0f / SPECTRUM_SAMPLES);
+		}
+
+		[[nodiscard]] float maxValue() const {
+			return std::max(std::max(values[0], values[1]), std::max(values[2], values[3]));
+		}
+	};
+
+	inline S_SampledSpectrum operator*(float s, const S_SampledSpectrum& spectrum) {
+		return spectrum * s;
+	}
+
+	[[nodiscard]] inline S_SampledSpectrum exp(const S_SampledSpectrum& s) {
+		return { std::exp(s[0]), std::exp(s[1]), std::exp(s[2]), std::exp(s[3]) };
+	}
+
+	[[nodiscard]] inline S_SampledSpectrum clampZero(const S_SampledSpectrum& s) {
+		return max(s, S_SampledSpectrum(0.0f));
+	}
+
+	// The wavelengths a path carries, with their sampling densities kept alongside (SoA) so
+	// estimators divide lane by lane
+	struct alignas(16) S_SampledWavelengths {
+		S_SampledSpectrum lambda;
+		S_SampledSpectrum pdf;
+
+		// Hero wavelength at u, companions spaced a quarter of the range apart and wrapped
+		[[nodiscard]] static S_SampledWavelengths sampleUniform(float u, float lambdaMin = LAMBDA_MIN, float lambdaMax = LAMBDA_MAX) {
+			S_SampledWavelengths wavelengths;
+			const float range = lambdaMax - lambdaMin;
+			wavelengths.lambda[0] = lambdaMin + u * range;
+			for (uint32_t i = 1; i < SPECTRUM_SAMPLES; ++i) {
+				float lambda = wavelengths.lambda[i - 1] + range / SPECTRUM_SAMPLES;
+				wavelengths.lambda[i] = lambda > lambdaMax ? lambda - range : lambda;
+			}
+			wavelengths.pdf = S_SampledSpectrum(1.0f / range);
+			return wavelengths;
+		}
+
+		// Importance samples the visible range where the eye is most sensitive (Radziszewski et al. 2009)
+		[[nodiscard]] static S_SampledWavelengths sampleVisible(float u) {
+			S_SampledWavelengths wavelengths;
+			for (uint32_t i = 0; i < SPECTRUM_SAMPLES; ++i) {
+				float up = u + static_cast<float>(i) / SPECTRUM_SAMPLES;
+				up = up > 1.0f ? up - 1.0f : up;
+				wavelengths.lambda[i] = 538.0f - 138.888889f * std::atanh(0.85691062f - 1.82750197f * up);
+				wavelengths.pdf[i] = visiblePdf(wavelengths.lambda[i]);
+			}
+			return wavelengths;
+		}
+
+		[[nodiscard]] static float visiblePdf(float lambda) {
+			if (lambda < LAMBDA_MIN || lambda > LAMBDA_MAX) {
+				return 0.0f;
+			}
+			const float c = std::cosh(0.0072f * (lambda - 538.0f));
+			return 0.0039398042f / (c * c);
+		}
+
+		// Keeps only the hero wavelength, e.g. after wavelength-dependent refraction
+		void terminateSecondary() {
+			if (secondaryTerminated()) {
+				return;
+			}
+			pdf = S_SampledSpectrum(pdf[0] / SPECTRUM_SAMPLES, 0.0f, 0.0f, 0.0f);
+		}
+
+		[[nodiscard]] bool secondaryTerminated() const {
+			return pdf[1] == 0.0f && pdf[2] == 0.0f && pdf[3] == 0.0f;
+		}
+	};
+
+	// CIE 1931 2-degree matching functions as the piecewise Gaussian fit of Wyman et al. 2013,
+	// within about 1% of the tabulated data over the visible range
+	namespace cie {
+		[[nodiscard]] inline float piecewiseGaussian(float lambda, float mean, float sigmaBelow, float sigmaAbove) {
+			const float t = (lambda - mean) / (lambda < mean ? sigmaBelow : sigmaAbove);
+			return std::exp(-0.5f * t * t);
+		}
+
+		[[nodiscard]] inline float x(float lambda) {
+			return 1.056f * piecewiseGaussian(lambda, 599.8f, 37.9f, 31.0f) + 0.362f * piecewiseGaussian(lambda, 442.0f, 16.0f, 26.7f)
+				- 0.065f * piecewiseGaussian(lambda, 501.1f, 20.4f, 26.2f);
+		}
+
+		[[nodiscard]] inline float y(float lambda) {
+			return 0.821f * piecewiseGaussian(lambda, 568.8f, 46.9f, 40.5f) + 0.286f * piecewiseGaussian(lambda, 530.9f, 16.3f, 31.1f);
+		}
+
+		[[nodiscard]] inline float z(float lambda) {
+			return 1.217f * piecewiseGaussian(lambda, 437.0f, 11.8f, 36.0f) + 0.681f * piecewiseGaussian(lambda, 459.0f, 26.0f, 13.8f);
+		}
+
+		// Integral of y over all wavelengths, sqrt(pi / 2) * (sigmaBelow + sigmaAbove) per lobe
+		constexpr float Y_INTEGRAL = 1.25331414f * (0.821f * (46.9f + 40.5f) + 0.286f * (16.3f + 31.1f));
+
+		// Spectral power of the sRGB white, a 6504 K blackbody standing in for D65, 1 at 560 nm
+		[[nodiscard]] inline float whiteIlluminant(float lambda) {
+			auto planck = [](float nanometres) {
+				const double metres = nanometres * 1e-9;
+				return 1.0 / (metres * metres * metres * metres * metres * (std::exp(1.4387769e-2 / (metres * 6504.0)) - 1.0));
+			};
+			return static_cast<float>(planck(lambda) / planck(560.0f));
+		}
+	}
+
+	// Monte Carlo estimate of CIE XYZ from one set of wavelength samples, Y = 1 for a
+	// constant spectrum of 1
+	[[nodiscard]] inline S_Vec3 toXYZ(const S_SampledSpectrum& spectrum, const S_SampledWavelengths& wavelengths) {
+		const S_SampledSpectrum weighted = spectrum / wavelengths.pdf;
+		S_Vec3 xyz;
+		for (uint32_t i = 0; i < SPECTRUM_SAMPLES; ++i) {
+			const float lambda = wavelengths.lambda[i];
+			xyz += S_Vec3(cie::x(lambda), cie::y(lambda), cie::z(lambda)) * weighted[i];
+		}
+		return xyz / (SPECTRUM_SAMPLES * cie::Y_INTEGRAL);
+	}
+
+	[[nodiscard]] constexpr S_Vec3 xyzToLinearSRGB(const S_Vec3& xyz) {
+		return { 3.2404542f * xyz.x - 1.5371385f * xyz.y - 0.4985314f * xyz.z,
+			-0.9692660f * xyz.x + 1.8760108f * xyz.y + 0.0415560f * xyz.z,
+			0.0556434f * xyz.x - 0.2040259f * xyz.y + 1.0572252f * xyz.z };
+	}
+
+	[[nodiscard]] constexpr S_Vec3 linearSRGBToXYZ(const S_Vec3& rgb) {
+		return { 0.4124564f * rgb.x + 0.3575761f * rgb.y + 0.1804375f * rgb.z,
+			0.2126729f * rgb.x + 0.7151522f * rgb.y + 0.0721750f * rgb.z,
+			0.0193339f * rgb.x + 0.1191920f * rgb.y + 0.9503041f * rgb.z };
+	}
+}
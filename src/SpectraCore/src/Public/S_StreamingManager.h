@@ -0,0 +1,160 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpectraCore.h"
+#include "S_TlsfHeap.h"
+
+namespace spectra::core::streaming {
+	enum class SPECTRA_CORE E_PageState : uint8_t {
+		UNLOADED = 0,
+		QUEUED,     // Waiting for an I/O thread, or for memory
+		LOADING,
+		RESIDENT,
+		FAILED      // The read failed; requesting the page again retries it
+	};
+
+	struct S_StreamingSettings {
+		uint32_t ioThreads = 2;
+		size_t memoryBudget = 256 * 1024 * 1024;  // Hard limit on the bytes of resident and loading pages
+	};
+
+	struct S_StreamingStats {
+		uint64_t requests = 0;                 // Pages queued, not counting priority updates
+		uint64_t completed = 0;
+		uint64_t cancelled = 0;
+		uint64_t evicted = 0;
+		uint64_t failed = 0;
+		uint64_t bytesRead = 0;
+		size_t residentBytes = 0;
+		size_t peakResidentBytes = 0;
+		uint32_t residentPages = 0;
+		uint32_t queuedPages = 0;
+		uint32_t loadingPages = 0;
+		double readMilliseconds = 0.0;         // Summed over the I/O threads
+		double averageLatencyMilliseconds = 0.0;  // From request to resident
+		double maxLatencyMilliseconds = 0.0;
+		double readMegabytesPerSecond = 0.0;   // Per I/O thread, while reading
+	};
+
+	// Open pack file, defined in S_StreamingManager.cpp
+	struct S_StreamingPack;
+
+	// Loads pages, byte ranges of pack files such as the pages of a cluster page file, on its
+	// own I/O threads so blocking reads never occupy the job system. Requests carry a priority
+	// and are read highest first; page memory comes from a TLSF heap tagged STREAMING and never
+	// exceeds the budget. To make room, resident pages are evicted in clock order, which spares
+	// pinned pages, gives recently requested or pinned ones a second chance and never evicts a
+	// page requested this frame with at least the incoming priority; evicted pages requested
+	// this frame are queued again. A request that cannot be made room for waits until pages are
+	// unpinned or the next frame begins. Requests last until loaded or cancelled. Thread-safe.
+	class SPECTRA_CORE S_StreamingManager {
+	public:
+		static constexpr uint32_t INVALID_PACK = 0xFFFFFFFFu;
+		static constexpr size_t PAGE_ALIGNMENT = 64;
+
+		explicit S_StreamingManager(const S_StreamingSettings& settings = {});
+		~S_StreamingManager();
+
+		S_StreamingManager(const S_StreamingManager&) = delete;
+		S_StreamingManager& operator=(const S_StreamingManager&) = delete;
+
+		// INVALID_PACK, with a WARNING, when the file cannot be opened
+		uint32_t addPack(const std::string& path);
+
+		// Registers size bytes at offset of pack as a page and returns its index
+		uint32_t addPage(uint32_t pack, uint64_t offset, uint32_t size);
+
+		// Starts a new frame of requests; pages requested in earlier frames become ordinary
+		// eviction candidates again
+		void beginFrame();
+
+		// Queues the page, or updates the priority of a queued one; larger loads sooner, e.g.
+		// projectedSize(). Resident pages are only marked as used.
+		void request(uint32_t page, float priority);
+
+		// Drops a queued page, discards the data of one being read or makes a resident one the
+		// next to be evicted
+		void cancel(uint32_t page);
+
+		// The page's data, which stays valid and resident until unpin(); empty unless resident
+		[[nodiscard]] std::span<const std::byte> pin(uint32_t page);
+		void unpin(uint32_t page);
+
+		// Evicts unpinned pages as needed to fit a new budget
+		void setMemoryBudget(size_t bytes);
+
+		[[nodiscard]] E_PageState getState(uint32_t page) const;
+
+		// Appends the pages that became resident since the last call
+		void takeArrivals(std::vector<uint32_t>& arrivals);
+
+		// Blocks until nothing is being read and no queued page could start
+		void waitForIdle();
+
+		// Angular size of a bounding sphere seen from distance, a priority that favours what
+		// covers the most of the screen
+		[[nodiscard]] static float projectedSize(float radius, float distance);
+
+		[[nodiscard]] S_StreamingStats getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::core::streaming"
+		void publishStats() const;
+
+	private:
+		struct S_Page {
+			uint64_t offset = 0;
+			uint32_t pack = 0;
+			uint32_t size = 0;
+			std::byte* data = nullptr;
+			E_PageState state = E_PageState::UNLOADED;
+			bool referenced = false;   // Clock bit, set by requests and pins
+			uint32_t pins = 0;
+			uint32_t generation = 0;   // Bumped whenever queue entries or a read in flight go stale
+			uint64_t requestFrame = 0;
+			float priority = 0.0f;
+			std::chrono::steady_clock::time_point requestTime;
+		};
+
+		struct S_QueueEntry {
+			float priority;
+			uint32_t page;
+			uint32_t generation;
+
+			bool operator<(const S_QueueEntry& other) const { return priority < other.priority; }
+		};
+
+		memory::S_TlsfHeap heap;
+		std::vector<std::unique_ptr<S_StreamingPack>> packs;
+		std::vector<S_Page> pages;
+		std::vector<S_QueueEntry> queue;      // Max-heap, with stale entries skipped when popped
+		std::vector<uint32_t> clockRing;      // Resident pages
+		size_t clockHand = 0;
+		std::vector<uint32_t> arrivals;
+		std::vector<std::thread> ioThreads;
+		mutable std::mutex mutex;
+		std::condition_variable workCondition;
+		std::condition_variable idleCondition;
+		size_t memoryBudget;
+		size_t committedBytes = 0;            // Resident and loading pages
+		uint64_t frame = 0;
+		bool stalled = false;                 // The best queued page waits for memory
+		bool stopping = false;
+		double latencySum = 0.0;
+		mutable S_StreamingStats stats;
+
+		void ioLoop();
+		bool reserve(size_t bytes, float priority);
+		bool evictOne(float priority);
+		void releaseData(S_Page& page);
+		void wakeAfterRelease();
+	};
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+#include "SpectraCore.h"
+
+namespace spectra::core::platform {
+	// Names of files written next to their destination, then renamed over it once complete
+	class SPECTRA_CORE S_TemporaryPath {
+	public:
+		// path + "." + a random suffix + ".tmp". Unique per call, so threads or processes saving
+		// the same file at once never write to the same temporary file.
+		[[nodiscard]] static std::string make(const std::string& path);
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "SpectraCore.h"
+#include "S_MemoryTracker.h"
+
+namespace spectra::core::memory {
+	// Boundary tag in front of every block, defined in S_TlsfHeap.cpp
+	struct S_TlsfBlock;
+
+	struct S_TlsfHeapStats {
+		size_t poolBytes = 0;         // Reserved from upstream
+		size_t usedBytes = 0;         // Payload bytes handed out
+		size_t freeBytes = 0;
+		size_t largestFreeBlock = 0;
+		size_t allocationCount = 0;
+		std::array<size_t, static_cast<size_t>(E_MemoryTag::COUNT)> bytesPerTag{};
+	};
+
+	// Two-level segregated fit heap (Masmano et al.) for long-lived allocations such as
+	// asset data. Allocation and release are O(1) with immediate coalescing, so it does
+	// not degrade with fragmentation the way a general-purpose malloc can. Every
+	// allocation carries an E_MemoryTag for per-subsystem accounting. Thread-safe.
+	class SPECTRA_CORE S_TlsfHeap : public std::pmr::memory_resource {
+	public:
+		static constexpr size_t ALIGN_SIZE_LOG2 = 4;
+		static constexpr size_t ALIGN_SIZE = size_t{ 1 } << ALIGN_SIZE_LOG2;
+		static constexpr size_t SL_INDEX_COUNT_LOG2 = 5;
+		static constexpr size_t SL_INDEX_COUNT = size_t{ 1 } << SL_INDEX_COUNT_LOG2;
+		static constexpr size_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+		static constexpr size_t FL_INDEX_MAX = 40;
+		static constexpr size_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+		static constexpr size_t SMALL_BLOCK_SIZE = size_t{ 1 } << FL_INDEX_SHIFT;
+		static constexpr size_t DEFAULT_POOL_SIZE = 64 * 1024 * 1024;
+
+		explicit S_TlsfHeap(size_t poolSize = DEFAULT_POOL_SIZE, E_MemoryTag defaultTag = E_MemoryTag::GENERAL,
+			std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		~S_TlsfHeap() override;
+
+		S_TlsfHeap(const S_TlsfHeap&) = delete;
+		S_TlsfHeap& operator=(const S_TlsfHeap&) = delete;
+
+		// Grows by another pool from upstream when no free block is large enough
+		[[nodiscard]] void* allocateTagged(size_t bytes, size_t alignment, E_MemoryTag tag);
+		void release(void* pointer);
+
+		// Usable size of a live allocation, at least the requested size
+		[[nodiscard]] size_t getAllocationSize(const void* pointer) const;
+
+		[[nodiscard]] S_TlsfHeapStats getStats() const;
+
+		// Walks every pool and checks block links and free-list consistency
+		[[nodiscard]] bool validate() const;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	private:
+		struct S_Pool {
+			void* memory;
+			size_t bytes;
+			S_TlsfBlock* firstBlock;
+		};
+
+		uint64_t flBitmap = 0;
+		std::array<uint32_t, FL_INDEX_COUNT> slBitmap{};
+		std::array<std::array<S_TlsfBlock*, SL_INDEX_COUNT>, FL_INDEX_COUNT> freeLists{};
+		std::vector<S_Pool> pools;
+		size_t poolSize;
+		E_MemoryTag defaultTag;
+		std::pmr::memory_resource* upstream;
+		mutable std::mutex heapMutex;
+		size_t usedBytes = 0;
+		size_t poolBytes = 0;
+		size_t allocationCount = 0;
+		std::array<size_t, static_cast<size_t>(E_MemoryTag::COUNT)> bytesPerTag{};
+		std::array<size_t, static_cast<size_t>(E_MemoryTag::COUNT)> allocationsPerTag{};
+
+		static void mapping(size_t size, size_t& fl, size_t& sl);
+		static void mappingSearch(size_t size, size_t& fl, size_t& sl);
+
+		bool addPool(size_t minimumPayload);
+		void insertFree(S_TlsfBlock* block);
+		void removeFree(S_TlsfBlock* block);
+		S_TlsfBlock* findFree(size_t size);
+		S_TlsfBlock* splitFront(S_TlsfBlock* block, size_t gap);
+		void trimBack(S_TlsfBlock* block, size_t size);
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cmath>
+
+#include "S_Aabb.h"
+#include "S_Vec3.h"
+
+namespace spectra::core::math {
+	// Unit quaternion, vector part first
+	struct S_Quat {
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+		float w = 1.0f;
+
+		[[nodiscard]] static S_Quat fromAxisAngle(const S_Vec3& axis, float radians) {
+			const S_Vec3 unit = normalize(axis);
+			const float half = radians * 0.5f;
+			const float s = std::sin(half);
+			return { unit.x * s, unit.y * s, unit.z * s, std::cos(half) };
+		}
+
+		constexpr S_Quat operator*(const S_Quat& other) const {
+			return {
+				w * other.x + x * other.w + y * other.z - z * other.y,
+				w * other.y - x * other.z + y * other.w + z * other.x,
+				w * other.z + x * other.y - y * other.x + z * other.w,
+				w * other.w - x * other.x - y * other.y - z * other.z
+			};
+		}
+
+		[[nodiscard]] constexpr S_Vec3 rotate(const S_Vec3& vector) const {
+			const S_Vec3 axis(x, y, z);
+			const S_Vec3 t = cross(axis, vector) * 2.0f;
+			return vector + t * w + cross(axis, t);
+		}
+
+		constexpr bool operator==(const S_Quat& other) const = default;
+	};
+
+	// Similarity transform: uniform scale, then rotation, then translation. Closed under
+	// composition, so hierarchies never pick up shear.
+	struct S_Transform {
+		S_Vec3 translation{ 0.0f };
+		S_Quat rotation;
+		float scale = 1.0f;
+
+		[[nodiscard]] constexpr S_Vec3 transformPoint(const S_Vec3& point) const {
+			return rotation.rotate(point * scale) + translation;
+		}
+
+		[[nodiscard]] constexpr S_Vec3 transformVector(const S_Vec3& vector) const {
+			return rotation.rotate(vector * scale);
+		}
+
+		// Box around the transformed box (Arvo 1990), tight for the rotated corners
+		[[nodiscard]] constexpr S_Aabb transformAabb(const S_Aabb& box) const {
+			if (box.isEmpty()) {
+				return box;
+			}
+			const S_Vec3 center = transformPoint(box.centroid());
+			const S_Vec3 half = box.extent() * (0.5f * (scale < 0.0f ? -scale : scale));
+			const S_Vec3 columns[3] = { rotation.rotate({ 1.0f, 0.0f, 0.0f }), rotation.rotate({ 0.0f, 1.0f, 0.0f }), rotation.rotate({ 0.0f, 0.0f, 1.0f }) };
+			S_Vec3 radius(0.0f);
+			for (int axis = 0; axis < 3; ++axis) {
+				const S_Vec3& column = columns[axis];
+				radius += S_Vec3(column.x < 0.0f ? -column.x : column.x, column.y < 0.0f ? -column.y : column.y,
+					column.z < 0.0f ? -column.z : column.z) * half[axis];
+			}
+			return { center - radius, center + radius };
+		}
+
+		constexpr bool operator==(const S_Transform& other) const = default;
+	};
+
+	// Parent * child: applies child first, so the result maps child space to the parent's parent
+	[[nodiscard]] constexpr S_Transform compose(const S_Transform& parent, const S_Transform& child) {
+		return { parent.transformPoint(child.translation), parent.rotation * child.rotation, parent.scale * child.scale };
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace spectra::core::math {
+	// Three floats with value semantics, used for points, directions and RGB.
+	// Header-only so the compiler can keep it in registers across module boundaries.
+	struct S_Vec3 {
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+
+		constexpr S_Vec3() = default;
+		constexpr S_Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+		constexpr explicit S_Vec3(float scalar) : x(scalar), y(scalar), z(scalar) {}
+
+		[[nodiscard]] constexpr float operator[](int axis) const { return axis == 0 ? x : axis == 1 ? y : z; }
+		[[nodiscard]] constexpr float& operator[](int axis) { return axis == 0 ? x : axis == 1 ? y : z; }
+
+		constexpr S_Vec3 operator-() const { return { -x, -y, -z }; }
+		constexpr S_Vec3 operator+(const S_Vec3& other) const { return { x + other.x, y + other.y, z + other.z }; }
+		constexpr S_Vec3 operator-(const S_Vec3& other) const { return { x - other.x, y - other.y, z - other.z }; }
+		constexpr S_Vec3 operator*(const S_Vec3& other) const { return { x * other.x, y * other.y, z * other.z }; }
+		constexpr S_Vec3 operator/(const S_Vec3& other) const { return { x / other.x, y / other.y, z / other.z }; }
+		constexpr S_Vec3 operator*(float scalar) const { return { x * scalar, y * scalar, z * scalar }; }
+		constexpr S_Vec3 operator/(float scalar) const { return *this * (1.0f / scalar); }
+
+		constexpr S_Vec3& operator+=(const S_Vec3& other) { x += other.x; y += other.y; z += other.z; return *this; }
+		constexpr S_Vec3& operator-=(const S_Vec3& other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+		constexpr S_Vec3& operator*=(const S_Vec3& other) { x *= other.x; y *= other.y; z *= other.z; return *this; }
+		constexpr S_Vec3& operator*=(float scalar) { x *= scalar; y *= scalar; z *= scalar; return *this; }
+		constexpr S_Vec3& operator/=(float scalar) { return *this *= 1.0f / scalar; }
+
+		constexpr bool operator==(const S_Vec3& other) const = default;
+	};
+
+	constexpr S_Vec3 operator*(float scalar, const S_Vec3& vector) {
+		return vector * scalar;
+	}
+
+	[[nodiscard]] constexpr float dot(const S_Vec3& a, const S_Vec3& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	[[nodiscard]] constexpr S_Vec3 cross(const S_Vec3& a, const S_Vec3& b) {
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	[[nodiscard]] constexpr float lengthSquared(const S_Vec3& vector) {
+		return dot(vector, vector);
+	}
+
+	[[nodiscard]] inline float length(const S_Vec3& vector) {
+		return std::sqrt(lengthSquared(vector));
+	}
+
+	[[nodiscard]] inline S_Vec3 normalize(const S_Vec3& vector) {
+		return vector / length(vector);
+	}
+
+	[[nodiscard]] constexpr S_Vec3 min(const S_Vec3& a, const S_Vec3& b) {
+		return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) };
+	}
+
+	[[nodiscard]] constexpr S_Vec3 max(const S_Vec3& a, const S_Vec3& b) {
+		return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) };
+	}
+
+	[[nodiscard]] constexpr float minComponent(const S_Vec3& vector) {
+		return std::min(vector.x, std::min(vector.y, vector.z));
+	}
+
+	[[nodiscard]] constexpr float maxComponent(const S_Vec3& vector) {
+		return std::max(vector.x, std::max(vector.y, vector.z));
+	}
+
+	[[nodiscard]] constexpr S_Vec3 lerp(const S_Vec3& a, const S_Vec3& b, float t) {
+		return a + (b - a) * t;
+	}
+
+	// Mirror direction about a unit normal
+	[[nodiscard]] constexpr S_Vec3 reflect(const S_Vec3& direction, const S_Vec3& normal) {
+		return direction - normal * (2.0f * dot(direction, normal));
+	}
+
+	// Rec. 709 relative luminance of a linear RGB value
+	[[nodiscard]] constexpr float luminance(const S_Vec3& rgb) {
+		return 0.2126f * rgb.x + 0.7152f * rgb.y + 0.0722f * rgb.z;
+	}
+
+	// Tangent and bitangent completing a unit normal to a right-handed basis (Duff et al. 2017)
+	inline void buildOrthonormalBasis(const S_Vec3& normal, S_Vec3& tangent, S_Vec3& bitangent) {
+		const float sign = std::copysign(1.0f, normal.z);
+		const float a = -1.0f / (sign + normal.z);
+		const float b = normal.x * normal.y * a;
+		tangent = { 1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x };
+		bitangent = { b, sign + normal.y * normal.y * a, -normal.y };
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace spectra::core::jobs {
+	// Fixed-capacity Chase-Lev deque (Le et al. 2013 memory orderings).
+	// The owning thread pushes and pops at the bottom, any thread may steal from the top.
+	template<typename T>
+	class S_WorkStealingDeque {
+		static_assert(std::is_pointer_v<T>, "S_WorkStealingDeque stores pointers only");
+
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		alignas(64) std::unique_ptr<std::atomic<T>[]> buffer;
+		int64_t mask;
+
+	public:
+		// Capacity is rounded up to a power of two
+		explicit S_WorkStealingDeque(size_t capacity = 4096) {
+			size_t size = 1;
+			while (size < capacity) size <<= 1;
+			buffer = std::make_unique<std::atomic<T>[]>(size);
+			mask = static_cast<int64_t>(size) - 1;
+		}
+
+		S_WorkStealingDeque(const S_WorkStealingDeque&) = delete;
+		S_WorkStealingDeque& operator=(const S_WorkStealingDeque&) = delete;
+
+		// Owner only. Returns false when the deque is full.
+		bool push(T item) {
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			if (b - t > mask) {
+				return false;
+			}
+			buffer[b & mask].store(item, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Owner only. Returns nullptr when empty or when a thief won the last item.
+		T pop() {
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b) {
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			T item = buffer[b & mask].load(std::memory_order_relaxed);
+			if (t == b) {
+				// Last item: race against thieves for it
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					item = nullptr;
+				}
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		// Any thread. Returns nullptr when empty or when the race was lost.
+		T steal() {
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b) {
+				return nullptr;
+			}
+
+			T item = buffer[t & mask].load(std::memory_order_acquire);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return item;
+		}
+
+		// Racy snapshot, only meant for scheduling heuristics
+		[[nodiscard]] size_t sizeApprox() const {
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_relaxed);
+			return b > t ? static_cast<size_t>(b - t) : 0;
+		}
+
+		[[nodiscard]] size_t capacity() const {
+			return static_cast<size_t>(mask + 1);
+		}
+	};
+}
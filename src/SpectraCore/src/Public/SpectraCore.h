@@ -1,10 +1,15 @@
 #pragma once
 
 #ifndef SPECTRA_CORE
+#if defined(_WIN32)
 #define SPECTRA_CORE __declspec(dllexport)
+#else
+#define SPECTRA_CORE __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECTRA_CORE SpectraCoreInit();
+void SPECTRA_CORE SpectraCoreShutdown();
 
 #ifndef SIGN_EXTEND_4
 #define SIGN_EXTEND_4(bits) ((bits & 0x00) ? (bits | 0xf0) : bits)
@@ -1,5 +1,5 @@
 #include "SpectraDX12Backend.h"
 
-void SPECTRE_DX12_BACKEND SpectraDX12BackendInit() {
+extern "C" void SPECTRE_DX12_BACKEND SpectraDX12BackendInit() {
 
 }
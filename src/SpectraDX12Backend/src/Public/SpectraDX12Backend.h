@@ -1,7 +1,12 @@
 #pragma once
 
 #ifndef SPECTRE_DX12_BACKEND
+#if defined(_WIN32)
 #define SPECTRE_DX12_BACKEND __declspec(dllexport)
+#else
+#define SPECTRE_DX12_BACKEND __attribute__((visibility("default")))
+#endif
 #endif
 
-void SPECTRE_DX12_BACKEND SpectraDX12BackendInit();
\ No newline at end of file
+// C linkage so the module registry can resolve it after loading the library at runtime
+extern "C" void SPECTRE_DX12_BACKEND SpectraDX12BackendInit();
\ No newline at end of file
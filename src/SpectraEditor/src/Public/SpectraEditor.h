@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPECTRA_EDITOR
+#if defined(_WIN32)
 #define SPECTRA_EDITOR __declspec(dllexport)
+#else
+#define SPECTRA_EDITOR __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECTRA_EDITOR SpectraEditorInit();
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <chrono>
 #include <format>  // For std::format
+#include <algorithm>
 
 void SPEC_INSTRUMENTATION SpectraInstrumentationInit() {
 }
@@ -153,6 +154,24 @@ namespace spectra {
                     if (arg.type() == typeid(int)) {
                         formattedArgs.emplace_back(std::format("{}", std::any_cast<int>(arg)));
                     }
+                    else if (arg.type() == typeid(unsigned int)) {
+                        formattedArgs.emplace_back(std::format("{}", std::any_cast<unsigned int>(arg)));
+                    }
+                    else if (arg.type() == typeid(int64_t)) {
+                        formattedArgs.emplace_back(std::format("{}", std::any_cast<int64_t>(arg)));
+                    }
+                    else if (arg.type() == typeid(uint64_t)) {
+                        formattedArgs.emplace_back(std::format("{}", std::any_cast<uint64_t>(arg)));
+                    }
+                    else if (arg.type() == typeid(double)) {
+                        formattedArgs.emplace_back(std::format("{}", std::any_cast<double>(arg)));
+                    }
+                    else if (arg.type() == typeid(float)) {
+                        formattedArgs.emplace_back(std::format("{}", std::any_cast<float>(arg)));
+                    }
+                    else if (arg.type() == typeid(bool)) {
+                        formattedArgs.emplace_back(std::any_cast<bool>(arg) ? "true" : "false");
+                    }
                     else if (arg.type() == typeid(std::string)) {
                         formattedArgs.emplace_back(std::any_cast<std::string>(arg));
                     }
@@ -287,6 +306,288 @@ namespace spectra {
             MathLogger::getInstance().flush();
         }
 
+        // CoreLogger implementations
+        Instrumentation::CoreLogger::CoreLogger() : BaseLogger("spectra::core") {}
+
+        Instrumentation::CoreLogger& Instrumentation::CoreLogger::getInstance() {
+            static CoreLogger instance;
+            return instance;
+        }
+
+        void Instrumentation::setCoreEnabled(bool enable) {
+            CoreLogger::getInstance().setEnabled(enable);
+        }
+
+        bool Instrumentation::isCoreEnabled() {
+            return CoreLogger::getInstance().isEnabled();
+        }
+
+        void Instrumentation::setCoreMinLevel(E_LogLevel level) {
+            CoreLogger::getInstance().setMinLevel(level);
+        }
+
+        E_LogLevel Instrumentation::getCoreMinLevel() {
+            return CoreLogger::getInstance().getMinLevel();
+        }
+
+        void Instrumentation::setCoreOutputDestinations(E_LogOutput destinations) {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            if (UINT_8(CoreLogger::getInstance().getOutputDestinations() & E_LogOutput::FILE) && !UINT_8(destinations & E_LogOutput::FILE) && coreFileStream.is_open()) {
+                coreFileStream.close();
+            }
+
+            if (!UINT_8(CoreLogger::getInstance().getOutputDestinations() & E_LogOutput::FILE) && UINT_8(destinations & E_LogOutput::FILE)) {
+                coreFileStream.open(coreFileName, std::ios::app);
+                if (!coreFileStream.is_open()) {
+                    if (UINT_8(destinations & E_LogOutput::CONSOLE)) {
+                        std::cerr << "[WARNING] spectra::core: Failed to open log file " << coreFileName << ", disabling file output\n";
+                    }
+                }
+            }
+
+            CoreLogger::getInstance().setOutputDestinations(destinations);
+        }
+
+        E_LogOutput Instrumentation::getCoreOutputDestinations() {
+            return CoreLogger::getInstance().getOutputDestinations();
+        }
+
+        int Instrumentation::getCoreLogCount(E_LogLevel level) {
+            return CoreLogger::getInstance().getLogCount(level);
+        }
+
+        int Instrumentation::getCoreTotalLogCount() {
+            return CoreLogger::getInstance().getTotalLogCount();
+        }
+
+        void Instrumentation::flushCore() {
+            CoreLogger::getInstance().flush();
+        }
+
+        // RenderLogger implementations
+        Instrumentation::RenderLogger::RenderLogger() : BaseLogger("spectra::render") {}
+
+        Instrumentation::RenderLogger& Instrumentation::RenderLogger::getInstance() {
+            static RenderLogger instance;
+            return instance;
+        }
+
+        void Instrumentation::setRenderEnabled(bool enable) {
+            RenderLogger::getInstance().setEnabled(enable);
+        }
+
+        bool Instrumentation::isRenderEnabled() {
+            return RenderLogger::getInstance().isEnabled();
+        }
+
+        void Instrumentation::setRenderMinLevel(E_LogLevel level) {
+            RenderLogger::getInstance().setMinLevel(level);
+        }
+
+        E_LogLevel Instrumentation::getRenderMinLevel() {
+            return RenderLogger::getInstance().getMinLevel();
+        }
+
+        void Instrumentation::setRenderOutputDestinations(E_LogOutput destinations) {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            if (UINT_8(RenderLogger::getInstance().getOutputDestinations() & E_LogOutput::FILE) && !UINT_8(destinations & E_LogOutput::FILE) && renderFileStream.is_open()) {
+                renderFileStream.close();
+            }
+
+            if (!UINT_8(RenderLogger::getInstance().getOutputDestinations() & E_LogOutput::FILE) && UINT_8(destinations & E_LogOutput::FILE)) {
+                renderFileStream.open(renderFileName, std::ios::app);
+                if (!renderFileStream.is_open()) {
+                    if (UINT_8(destinations & E_LogOutput::CONSOLE)) {
+                        std::cerr << "[WARNING] spectra::render: Failed to open log file " << renderFileName << ", disabling file output\n";
+                    }
+                }
+            }
+
+            RenderLogger::getInstance().setOutputDestinations(destinations);
+        }
+
+        E_LogOutput Instrumentation::getRenderOutputDestinations() {
+            return RenderLogger::getInstance().getOutputDestinations();
+        }
+
+        int Instrumentation::getRenderLogCount(E_LogLevel level) {
+            return RenderLogger::getInstance().getLogCount(level);
+        }
+
+        int Instrumentation::getRenderTotalLogCount() {
+            return RenderLogger::getInstance().getTotalLogCount();
+        }
+
+        void Instrumentation::flushRender() {
+            RenderLogger::getInstance().flush();
+        }
+
+        // UILogger implementations
+        Instrumentation::UILogger::UILogger() : BaseLogger("spectra::ui") {}
+
+        Instrumentation::UILogger& Instrumentation::UILogger::getInstance() {
+            static UILogger instance;
+            return instance;
+        }
+
+        void Instrumentation::setUIEnabled(bool enable) {
+            UILogger::getInstance().setEnabled(enable);
+        }
+
+        bool Instrumentation::isUIEnabled() {
+            return UILogger::getInstance().isEnabled();
+        }
+
+        void Instrumentation::setUIMinLevel(E_LogLevel level) {
+            UILogger::getInstance().setMinLevel(level);
+        }
+
+        E_LogLevel Instrumentation::getUIMinLevel() {
+            return UILogger::getInstance().getMinLevel();
+        }
+
+        void Instrumentation::setUIOutputDestinations(E_LogOutput destinations) {
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            if (UINT_8(UILogger::getInstance().getOutputDestinations() & E_LogOutput::FILE) && !UINT_8(destinations & E_LogOutput::FILE) && uiFileStream.is_open()) {
+                uiFileStream.close();
+            }
+
+            if (!UINT_8(UILogger::getInstance().getOutputDestinations() & E_LogOutput::FILE) && UINT_8(destinations & E_LogOutput::FILE)) {
+                uiFileStream.open(uiFileName, std::ios::app);
+                if (!uiFileStream.is_open()) {
+                    if (UINT_8(destinations & E_LogOutput::CONSOLE)) {
+                        std::cerr << "[WARNING] spectra::ui: Failed to open log file " << uiFileName << ", disabling file output\n";
+                    }
+                }
+            }
+
+            UILogger::getInstance().setOutputDestinations(destinations);
+        }
+
+        E_LogOutput Instrumentation::getUIOutputDestinations() {
+            return UILogger::getInstance().getOutputDestinations();
+        }
+
+        int Instrumentation::getUILogCount(E_LogLevel level) {
+            return UILogger::getInstance().getLogCount(level);
+        }
+
+        int Instrumentation::getUITotalLogCount() {
+            return UILogger::getInstance().getTotalLogCount();
+        }
+
+        void Instrumentation::flushUI() {
+            UILogger::getInstance().flush();
+        }
+
+        // StatEntry implementations
+        double StatEntry::mean() const {
+            return sampleCount > 0 ? value / static_cast<double>(sampleCount) : 0.0;
+        }
+
+        std::string StatEntry::toString() const {
+            switch (kind) {
+            case E_StatKind::COUNTER:
+                return std::format("{}::{} = {}", category, name, value);
+            case E_StatKind::GAUGE:
+                return std::format("{}::{} = {} (min {}, max {})", category, name, value, minValue, maxValue);
+            case E_StatKind::TIMING:
+                return std::format("{}::{} = {} ms total, {} samples (mean {} ms, min {} ms, max {} ms)",
+                    category, name, value, sampleCount, mean(), minValue, maxValue);
+            }
+            return category + "::" + name;
+        }
+
+        // StatRegistry implementations
+        void StatRegistry::record(const std::string& category, const std::string& name, E_StatKind kind, double value) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            auto [it, inserted] = stats.try_emplace(category + "::" + name);
+            StatEntry& entry = it->second;
+            if (inserted) {
+                entry.category = category;
+                entry.name = name;
+                entry.kind = kind;
+                entry.minValue = value;
+                entry.maxValue = value;
+            }
+
+            entry.minValue = std::min(entry.minValue, value);
+            entry.maxValue = std::max(entry.maxValue, value);
+            entry.sampleCount++;
+            if (kind == E_StatKind::GAUGE) {
+                entry.value = value;
+            }
+            else {
+                entry.value += value;
+            }
+        }
+
+        std::vector<StatEntry> StatRegistry::getStats() const {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            std::vector<StatEntry> result;
+            result.reserve(stats.size());
+            for (const auto& pair : stats) {
+                result.push_back(pair.second);
+            }
+            return result;
+        }
+
+        std::string StatRegistry::getReport() const {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            std::string result = "Stats Report:\n";
+            for (const auto& pair : stats) {
+                result += "  " + pair.second.toString() + "\n";
+            }
+            return result;
+        }
+
+        void StatRegistry::reset() {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.clear();
+        }
+
+        void Instrumentation::addCounter(const std::string& category, const std::string& name, double delta) {
+            statRegistry.record(category, name, E_StatKind::COUNTER, delta);
+        }
+
+        void Instrumentation::setGauge(const std::string& category, const std::string& name, double value) {
+            statRegistry.record(category, name, E_StatKind::GAUGE, value);
+        }
+
+        void Instrumentation::recordTiming(const std::string& category, const std::string& name, double milliseconds) {
+            statRegistry.record(category, name, E_StatKind::TIMING, milliseconds);
+        }
+
+        std::vector<StatEntry> Instrumentation::getStats() {
+            return statRegistry.getStats();
+        }
+
+        std::string Instrumentation::getStatsReport() {
+            return statRegistry.getReport();
+        }
+
+        void Instrumentation::resetStats() {
+            statRegistry.reset();
+        }
+
+        void Instrumentation::reportStats() {
+            for (const auto& entry : statRegistry.getStats()) {
+                logCore(E_LogLevel::INFO, entry.category, "Stats", entry.toString());
+            }
+        }
+
+        // ScopedTimer implementations
+        Instrumentation::ScopedTimer::ScopedTimer(std::string cat, std::string statName)
+            : category(std::move(cat)), name(std::move(statName)), start(std::chrono::steady_clock::now()) {}
+
+        Instrumentation::ScopedTimer::~ScopedTimer() {
+            recordTiming(category, name, elapsedMilliseconds());
+        }
+
+        double Instrumentation::ScopedTimer::elapsedMilliseconds() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
         void Instrumentation::addToBuffer(const LogEntry& entry) {
             std::lock_guard<std::mutex> lock(bufferMutex);
             logBuffer.push_back(entry);
@@ -296,22 +597,42 @@ namespace spectra {
             std::lock_guard<std::mutex> lock(bufferMutex);
             if (logBuffer.empty()) return;
 
-            // Flush MathLogger
-            if (UINT_8(MathLogger::getInstance().getOutputDestinations() & E_LogOutput::CONSOLE)) {
-                for (const auto& entry : logBuffer) {
+            // Route each entry to the destinations of the logger that produced it
+            for (const auto& entry : logBuffer) {
+                const bool isCore = entry.libraryName == "spectra::core";
+                const bool isRender = entry.libraryName == "spectra::render";
+                const bool isUI = entry.libraryName == "spectra::ui";
+                const E_LogOutput destinations = isCore
+                    ? CoreLogger::getInstance().getOutputDestinations()
+                    : isRender
+                    ? RenderLogger::getInstance().getOutputDestinations()
+                    : isUI
+                    ? UILogger::getInstance().getOutputDestinations()
+                    : MathLogger::getInstance().getOutputDestinations();
+                std::ofstream& fileStream = isCore ? coreFileStream : isRender ? renderFileStream : isUI ? uiFileStream : mathFileStream;
+
+                if (UINT_8(destinations & E_LogOutput::CONSOLE)) {
                     std::cerr << "[TEMP] " << entry.toString() << "\n";
                 }
-                std::cerr.flush();
-            }
-            if (UINT_8(MathLogger::getInstance().getOutputDestinations() & E_LogOutput::FILE)) {
-                if (mathFileStream.is_open()) {
-                    for (const auto& entry : logBuffer) {
-                        mathFileStream << "[PERM] " << entry.toString() << "\n";
-                    }
-                    mathFileStream.flush();
+                if (UINT_8(destinations & E_LogOutput::FILE) && fileStream.is_open()) {
+                    fileStream << "[PERM] " << entry.toString() << "\n";
                 }
             }
 
+            std::cerr.flush();
+            if (mathFileStream.is_open()) {
+                mathFileStream.flush();
+            }
+            if (coreFileStream.is_open()) {
+                coreFileStream.flush();
+            }
+            if (renderFileStream.is_open()) {
+                renderFileStream.flush();
+            }
+            if (uiFileStream.is_open()) {
+                uiFileStream.flush();
+            }
+
             logBuffer.clear();
         }
     }
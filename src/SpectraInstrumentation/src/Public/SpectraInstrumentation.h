@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPEC_INSTRUMENTATION
+#if defined(_WIN32)
 #define SPEC_INSTRUMENTATION __declspec(dllexport)
+#else
+#define SPEC_INSTRUMENTATION __attribute__((visibility("default")))
+#endif
 #include <iostream>
 #endif
 
@@ -12,12 +16,16 @@
 void SPEC_INSTRUMENTATION SpectraInstrumentationInit();
 
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <unordered_map>
 #include <any>
 #include <vector>
 #include <mutex>
 #include <deque>  // For circular buffer
+#include <map>
+#include <chrono>
+#include <cstdint>
 
 namespace spectra {
     namespace instrumentation {
@@ -116,6 +124,46 @@ namespace spectra {
             virtual void flush() = 0;
         };
 
+        // Kind of value a stat accumulates
+        enum class SPEC_INSTRUMENTATION E_StatKind : uint8_t {
+            COUNTER = 0,  // Sum of all recorded increments
+            GAUGE = 1,    // Last recorded value
+            TIMING = 2    // Durations in milliseconds, aggregated into total/min/max
+        };
+
+        // Aggregated value of a single named stat
+        class SPEC_INSTRUMENTATION StatEntry {
+        public:
+            std::string category;
+            std::string name;
+            E_StatKind kind = E_StatKind::COUNTER;
+            double value = 0.0;  // Sum for counters and timings, last value for gauges
+            double minValue = 0.0;
+            double maxValue = 0.0;
+            uint64_t sampleCount = 0;
+
+            double mean() const;
+
+            // Convert the stat to a single report line
+            std::string toString() const;
+        };
+
+        // Thread-safe store of named stats, keyed by "category::name"
+        class SPEC_INSTRUMENTATION StatRegistry {
+        private:
+            std::map<std::string, StatEntry> stats;  // Ordered so reports group by category
+            mutable std::mutex statsMutex;
+
+        public:
+            void record(const std::string& category, const std::string& name, E_StatKind kind, double value);
+
+            std::vector<StatEntry> getStats() const;
+
+            std::string getReport() const;
+
+            void reset();
+        };
+
         // Global instrumentation manager with nested loggers
         class SPEC_INSTRUMENTATION Instrumentation {
         private:
@@ -123,6 +171,13 @@ namespace spectra {
             static std::mutex bufferMutex;  // Thread safety for the buffer
             static std::ofstream mathFileStream;  // File stream for MathLogger
             static std::string mathFileName;  // File name for MathLogger
+            static std::ofstream coreFileStream;  // File stream for CoreLogger
+            static std::string coreFileName;  // File name for CoreLogger
+            static std::ofstream renderFileStream;  // File stream for RenderLogger
+            static std::string renderFileName;  // File name for RenderLogger
+            static std::ofstream uiFileStream;  // File stream for UILogger
+            static std::string uiFileName;  // File name for UILogger
+            static StatRegistry statRegistry;  // Counters, gauges and timings from all libraries
 
             // Base class for nested loggers
             class SPEC_INSTRUMENTATION BaseLogger : public I_Logger {
@@ -150,15 +205,22 @@ namespace spectra {
                     const std::string& message, const std::vector<std::any>& args) override;
 
             public:
+                // Takes string views so call sites with literals do not build strings for filtered logs
                 template<typename... Args>
-                void log(E_LogLevel level, const std::string& component, const std::string& subComponent,
-                    const std::string& message, Args&&... args) {
+                void log(E_LogLevel level, std::string_view component, std::string_view subComponent,
+                    std::string_view message, Args&&... args) {
+                    // Filtered logs return before packing so they never touch the heap
+                    if (isValidLevel(level) && (!enabled || static_cast<int>(level) < static_cast<int>(minLevel))) {
+                        return;
+                    }
+
                     // Pack the variadic arguments into a vector of std::any
                     std::vector<std::any> packedArgs;
+                    packedArgs.reserve(sizeof...(Args));
                     (packedArgs.emplace_back(std::forward<Args>(args)), ...);
 
                     // Call the virtual log method
-                    logInternal(level, component, subComponent, message, packedArgs);
+                    logInternal(level, std::string(component), std::string(subComponent), std::string(message), packedArgs);
                 }
 
                 void setEnabled(bool enable) override;
@@ -181,8 +243,8 @@ namespace spectra {
             };
 
             template<typename ...Args>
-			static void logMath(E_LogLevel level, const std::string& component, const std::string& subComponent,
-                const std::string& message, Args&&... args) {
+			static void logMath(E_LogLevel level, std::string_view component, std::string_view subComponent,
+                std::string_view message, Args&&... args) {
                 MathLogger::getInstance().log(level, component, subComponent, message, std::forward<Args>(args)...);
             }
 
@@ -196,6 +258,103 @@ namespace spectra {
             static int getMathTotalLogCount();
             static void flushMath();
 
+            // Logger for spectra::core runtime systems (jobs, memory, modules)
+            class SPEC_INSTRUMENTATION CoreLogger final : public BaseLogger {
+            public:
+                CoreLogger();
+                static CoreLogger& getInstance();
+            };
+
+            template<typename ...Args>
+            static void logCore(E_LogLevel level, std::string_view component, std::string_view subComponent,
+                std::string_view message, Args&&... args) {
+                CoreLogger::getInstance().log(level, component, subComponent, message, std::forward<Args>(args)...);
+            }
+
+            static void setCoreEnabled(bool enable);
+            static bool isCoreEnabled();
+            static void setCoreMinLevel(E_LogLevel level);
+            static E_LogLevel getCoreMinLevel();
+            static void setCoreOutputDestinations(E_LogOutput destinations);
+            static E_LogOutput getCoreOutputDestinations();
+            static int getCoreLogCount(E_LogLevel level);
+            static int getCoreTotalLogCount();
+            static void flushCore();
+
+            // Logger for spectra::render (render engine, pipeline and their subsystems)
+            class SPEC_INSTRUMENTATION RenderLogger final : public BaseLogger {
+            public:
+                RenderLogger();
+                static RenderLogger& getInstance();
+            };
+
+            template<typename ...Args>
+            static void logRender(E_LogLevel level, std::string_view component, std::string_view subComponent,
+                std::string_view message, Args&&... args) {
+                RenderLogger::getInstance().log(level, component, subComponent, message, std::forward<Args>(args)...);
+            }
+
+            static void setRenderEnabled(bool enable);
+            static bool isRenderEnabled();
+            static void setRenderMinLevel(E_LogLevel level);
+            static E_LogLevel getRenderMinLevel();
+            static void setRenderOutputDestinations(E_LogOutput destinations);
+            static E_LogOutput getRenderOutputDestinations();
+            static int getRenderLogCount(E_LogLevel level);
+            static int getRenderTotalLogCount();
+            static void flushRender();
+
+            // Logger for spectra::ui (node graphs, viewports, widgets and editors)
+            class SPEC_INSTRUMENTATION UILogger final : public BaseLogger {
+            public:
+                UILogger();
+                static UILogger& getInstance();
+            };
+
+            template<typename ...Args>
+            static void logUI(E_LogLevel level, std::string_view component, std::string_view subComponent,
+                std::string_view message, Args&&... args) {
+                UILogger::getInstance().log(level, component, subComponent, message, std::forward<Args>(args)...);
+            }
+
+            static void setUIEnabled(bool enable);
+            static bool isUIEnabled();
+            static void setUIMinLevel(E_LogLevel level);
+            static E_LogLevel getUIMinLevel();
+            static void setUIOutputDestinations(E_LogOutput destinations);
+            static E_LogOutput getUIOutputDestinations();
+            static int getUILogCount(E_LogLevel level);
+            static int getUITotalLogCount();
+            static void flushUI();
+
+            // Stats are aggregated in memory and only written out by reportStats()
+            static void addCounter(const std::string& category, const std::string& name, double delta = 1.0);
+            static void setGauge(const std::string& category, const std::string& name, double value);
+            static void recordTiming(const std::string& category, const std::string& name, double milliseconds);
+            static std::vector<StatEntry> getStats();
+            static std::string getStatsReport();
+            static void resetStats();
+
+            // Log the current stats report at INFO level through the CoreLogger
+            static void reportStats();
+
+            // RAII timer that records its lifetime as a TIMING stat
+            class SPEC_INSTRUMENTATION ScopedTimer {
+            private:
+                std::string category;
+                std::string name;
+                std::chrono::steady_clock::time_point start;
+
+            public:
+                ScopedTimer(std::string cat, std::string statName);
+                ~ScopedTimer();
+
+                ScopedTimer(const ScopedTimer&) = delete;
+                ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+                double elapsedMilliseconds() const;
+            };
+
             // Add a log entry to the central buffer
             static void addToBuffer(const LogEntry& entry);
 
@@ -209,4 +368,11 @@ namespace spectra {
 inline std::vector<spectra::instrumentation::LogEntry> spectra::instrumentation::Instrumentation::logBuffer;
 inline std::mutex spectra::instrumentation::Instrumentation::bufferMutex;
 inline std::ofstream spectra::instrumentation::Instrumentation::mathFileStream;
-inline std::string spectra::instrumentation::Instrumentation::mathFileName = "math_log.txt";
\ No newline at end of file
+inline std::string spectra::instrumentation::Instrumentation::mathFileName = "math_log.txt";
+inline std::ofstream spectra::instrumentation::Instrumentation::coreFileStream;
+inline std::string spectra::instrumentation::Instrumentation::coreFileName = "core_log.txt";
+inline std::ofstream spectra::instrumentation::Instrumentation::renderFileStream;
+inline std::string spectra::instrumentation::Instrumentation::renderFileName = "render_log.txt";
+inline std::ofstream spectra::instrumentation::Instrumentation::uiFileStream;
+inline std::string spectra::instrumentation::Instrumentation::uiFileName = "ui_log.txt";
+inline spectra::instrumentation::StatRegistry spectra::instrumentation::Instrumentation::statRegistry;
\ No newline at end of file
@@ -0,0 +1,778 @@
+#include "S_BlockCompression.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace spectra::materials::blocks {
+	namespace {
+		constexpr uint8_t WEIGHTS2[4] = { 0, 21, 43, 64 };
+		constexpr uint8_t WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+		constexpr uint8_t WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// Two-subset partitions of BC7 mode 1, bit i set where pixel i belongs to subset 1
+		constexpr uint16_t PARTITIONS2[64] = {
+			0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+			0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+			0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+			0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+			0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+			0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+			0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+			0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+		};
+
+		// Pixel of subset 1 whose index is stored without its top bit; subset 0's is pixel 0
+		constexpr uint8_t ANCHORS2[64] = {
+			15, 15, 15, 15, 15, 15, 15, 15,
+			15, 15, 15, 15, 15, 15, 15, 15,
+			15, 2, 8, 2, 2, 8, 8, 15,
+			2, 8, 2, 2, 8, 8, 2, 2,
+			15, 15, 6, 8, 2, 8, 15, 15,
+			2, 8, 2, 2, 2, 15, 15, 6,
+			6, 2, 6, 8, 15, 15, 2, 2,
+			15, 15, 15, 15, 15, 2, 2, 15
+		};
+
+		// Palette position of each index as a fraction of the way from endpoint 0 to endpoint 1
+		constexpr float BC1_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		constexpr float BC4_WEIGHTS[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+		struct S_Points {
+			float values[16][4];
+			uint8_t pixels[16];  // Position in the block
+			uint32_t count = 0;
+		};
+
+		S_Points gather(const S_Block& block, uint16_t mask) {
+			S_Points points;
+			for (uint32_t i = 0; i < 16; ++i) {
+				if (mask & (1u << i)) {
+					for (uint32_t c = 0; c < 4; ++c) {
+						points.values[points.count][c] = block.pixels[i][c];
+					}
+					points.pixels[points.count++] = static_cast<uint8_t>(i);
+				}
+			}
+			return points;
+		}
+
+		// Mean and principal axis of the first channels by power iteration. The residual is the
+		// squared distance the best line through the mean leaves, to rank BC7 partitions.
+		void fitLine(const S_Points& points, uint32_t channels, float mean[4], float axis[4], float& residual) {
+			for (uint32_t c = 0; c < 4; ++c) {
+				mean[c] = 0.0f;
+				axis[c] = 0.0f;
+			}
+			for (uint32_t i = 0; i < points.count; ++i) {
+				for (uint32_t c = 0; c < channels; ++c) {
+					mean[c] += points.values[i][c];
+				}
+			}
+			for (uint32_t c = 0; c < channels; ++c) {
+				mean[c] /= static_cast<float>(points.count);
+			}
+			float covariance[4][4] = {};
+			for (uint32_t i = 0; i < points.count; ++i) {
+				for (uint32_t a = 0; a < channels; ++a) {
+					for (uint32_t b = 0; b < channels; ++b) {
+						covariance[a][b] += (points.values[i][a] - mean[a]) * (points.values[i][b] - mean[b]);
+					}
+				}
+			}
+
+			// Start from the row of the widest channel, which is never orthogonal to the answer
+			uint32_t widest = 0;
+			float trace = 0.0f;
+			for (uint32_t c = 0; c < channels; ++c) {
+				trace += covariance[c][c];
+				if (covariance[c][c] > covariance[widest][widest]) {
+					widest = c;
+				}
+			}
+			residual = 0.0f;
+			if (trace <= 0.0f) {
+				axis[0] = 1.0f;
+				return;
+			}
+			for (uint32_t c = 0; c < channels; ++c) {
+				axis[c] = covariance[widest][c];
+			}
+			for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+				float product[4] = {};
+				float length = 0.0f;
+				for (uint32_t a = 0; a < channels; ++a) {
+					for (uint32_t b = 0; b < channels; ++b) {
+						product[a] += covariance[a][b] * axis[b];
+					}
+					length += product[a] * product[a];
+				}
+				if (length <= 1e-20f) {
+					break;
+				}
+				const float inverse = 1.0f / std::sqrt(length);
+				for (uint32_t c = 0; c < channels; ++c) {
+					axis[c] = product[c] * inverse;
+				}
+			}
+			float explained = 0.0f;
+			for (uint32_t a = 0; a < channels; ++a) {
+				for (uint32_t b = 0; b < channels; ++b) {
+					explained += axis[a] * covariance[a][b] * axis[b];
+				}
+			}
+			residual = std::max(trace - explained, 0.0f);
+		}
+
+		// Endpoints spanning the points' projections on the axis
+		void lineEndpoints(const S_Points& points, uint32_t channels, const float mean[4], const float axis[4], float endpoints[2][4]) {
+			float low = 0.0f;
+			float high = 0.0f;
+			for (uint32_t i = 0; i < points.count; ++i) {
+				float t = 0.0f;
+				for (uint32_t c = 0; c < channels; ++c) {
+					t += (points.values[i][c] - mean[c]) * axis[c];
+				}
+				low = std::min(low, t);
+				high = std::max(high, t);
+			}
+			for (uint32_t c = 0; c < 4; ++c) {
+				endpoints[0][c] = c < channels ? std::clamp(mean[c] + axis[c] * low, 0.0f, 255.0f) : 255.0f;
+				endpoints[1][c] = c < channels ? std::clamp(mean[c] + axis[c] * high, 0.0f, 255.0f) : 255.0f;
+			}
+		}
+
+		// Least squares endpoints for the chosen indices; false when the indices do not pin both down
+		bool refineEndpoints(const S_Points& points, uint32_t channels, const uint8_t* indices, const float* weights, float endpoints[2][4]) {
+			float a = 0.0f;
+			float b = 0.0f;
+			float c = 0.0f;
+			float first[4] = {};
+			float second[4] = {};
+			for (uint32_t i = 0; i < points.count; ++i) {
+				const float w = weights[indices[i]];
+				a += (1.0f - w) * (1.0f - w);
+				b += (1.0f - w) * w;
+				c += w * w;
+				for (uint32_t channel = 0; channel < channels; ++channel) {
+					first[channel] += (1.0f - w) * points.values[i][channel];
+					second[channel] += w * points.values[i][channel];
+				}
+			}
+			const float determinant = a * c - b * b;
+			if (std::fabs(determinant) < 1e-4f) {
+				return false;
+			}
+			for (uint32_t channel = 0; channel < channels; ++channel) {
+				endpoints[0][channel] = std::clamp((c * first[channel] - b * second[channel]) / determinant, 0.0f, 255.0f);
+				endpoints[1][channel] = std::clamp((a * second[channel] - b * first[channel]) / determinant, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		// Little-endian bit stream of one 128-bit block
+		struct S_BitWriter {
+			uint64_t words[2] = {};
+			uint32_t position = 0;
+
+			void put(uint64_t value, uint32_t count) {
+				value &= (1ull << count) - 1;
+				const uint32_t word = position >> 6;
+				const uint32_t shift = position & 63;
+				words[word] |= value << shift;
+				if (shift + count > 64) {
+					words[word + 1] |= value >> (64 - shift);
+				}
+				position += count;
+			}
+		};
+
+		struct S_BitReader {
+			uint64_t words[2] = {};
+			uint32_t position = 0;
+
+			uint32_t get(uint32_t count) {
+				const uint32_t word = position >> 6;
+				const uint32_t shift = position & 63;
+				uint64_t value = words[word] >> shift;
+				if (shift + count > 64) {
+					value |= words[word + 1] << (64 - shift);
+				}
+				position += count;
+				return static_cast<uint32_t>(value & ((1ull << count) - 1));
+			}
+		};
+
+		int32_t squared(int32_t value) {
+			return value * value;
+		}
+
+		// BC1
+		uint16_t toRgb565(const float color[4]) {
+			const uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+			const uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+			const uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void bc1Palette(uint16_t color0, uint16_t color1, int32_t palette[4][3]) {
+			for (uint32_t e = 0; e < 2; ++e) {
+				const uint32_t color = e ? color1 : color0;
+				const uint32_t r = (color >> 11) & 31;
+				const uint32_t g = (color >> 5) & 63;
+				const uint32_t b = color & 31;
+				palette[e][0] = static_cast<int32_t>((r << 3) | (r >> 2));
+				palette[e][1] = static_cast<int32_t>((g << 2) | (g >> 4));
+				palette[e][2] = static_cast<int32_t>((b << 3) | (b >> 2));
+			}
+			for (uint32_t c = 0; c < 3; ++c) {
+				if (color0 > color1) {
+					palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+				}
+				else {
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+					palette[3][c] = 0;
+				}
+			}
+		}
+
+		struct S_Bc1Encoding {
+			uint16_t colors[2] = {};
+			uint8_t indices[16] = {};
+			int32_t error = INT32_MAX;
+		};
+
+		void tryBc1(const S_Block& block, const float endpoints[2][4], S_Bc1Encoding& best) {
+			S_Bc1Encoding candidate;
+			candidate.colors[0] = toRgb565(endpoints[0]);
+			candidate.colors[1] = toRgb565(endpoints[1]);
+			if (candidate.colors[0] < candidate.colors[1]) {
+				std::swap(candidate.colors[0], candidate.colors[1]);
+			}
+			int32_t palette[4][3];
+			bc1Palette(candidate.colors[0], candidate.colors[1], palette);
+			const uint32_t entries = candidate.colors[0] > candidate.colors[1] ? 4 : 3;  // Equal colors: skip the black entry
+			candidate.error = 0;
+			for (uint32_t i = 0; i < 16; ++i) {
+				int32_t nearest = INT32_MAX;
+				for (uint32_t k = 0; k < entries; ++k) {
+					int32_t distance = 0;
+					for (uint32_t c = 0; c < 3; ++c) {
+						distance += squared(palette[k][c] - block.pixels[i][c]);
+					}
+					if (distance < nearest) {
+						nearest = distance;
+						candidate.indices[i] = static_cast<uint8_t>(k);
+					}
+				}
+				candidate.error += nearest;
+			}
+			if (candidate.error < best.error) {
+				best = candidate;
+			}
+		}
+
+		// BC4
+		void bc4Palette(uint32_t endpoint0, uint32_t endpoint1, int32_t palette[8]) {
+			palette[0] = static_cast<int32_t>(endpoint0);
+			palette[1] = static_cast<int32_t>(endpoint1);
+			if (endpoint0 > endpoint1) {
+				for (uint32_t i = 2; i < 8; ++i) {
+					palette[i] = static_cast<int32_t>(((8 - i) * endpoint0 + (i - 1) * endpoint1 + 3) / 7);
+				}
+			}
+			else {
+				for (uint32_t i = 2; i < 6; ++i) {
+					palette[i] = static_cast<int32_t>(((6 - i) * endpoint0 + (i - 1) * endpoint1 + 2) / 5);
+				}
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		struct S_Bc4Encoding {
+			uint8_t endpoints[2] = {};
+			uint8_t indices[16] = {};
+			int32_t error = INT32_MAX;
+		};
+
+		void tryBc4(const uint8_t values[16], int32_t endpoint0, int32_t endpoint1, S_Bc4Encoding& best) {
+			S_Bc4Encoding candidate;
+			candidate.endpoints[0] = static_cast<uint8_t>(std::clamp(endpoint0, 0, 255));
+			candidate.endpoints[1] = static_cast<uint8_t>(std::clamp(endpoint1, 0, 255));
+			int32_t palette[8];
+			bc4Palette(candidate.endpoints[0], candidate.endpoints[1], palette);
+			candidate.error = 0;
+			for (uint32_t i = 0; i < 16; ++i) {
+				int32_t nearest = INT32_MAX;
+				for (uint32_t k = 0; k < 8; ++k) {
+					const int32_t distance = squared(palette[k] - values[i]);
+					if (distance < nearest) {
+						nearest = distance;
+						candidate.indices[i] = static_cast<uint8_t>(k);
+					}
+				}
+				candidate.error += nearest;
+			}
+			if (candidate.error < best.error) {
+				best = candidate;
+			}
+		}
+
+		// BC7
+		struct S_Bc7Mode {
+			uint32_t number;
+			uint32_t channels;   // Encoded; the others decode as 255
+			uint32_t colorBits;  // Per endpoint channel, p-bit excluded
+			bool sharedPbit;     // One p-bit per subset rather than per endpoint
+			uint32_t indexBits;
+		};
+
+		constexpr S_Bc7Mode MODE1{ 1, 3, 6, true, 3 };
+		constexpr S_Bc7Mode MODE6{ 6, 4, 7, false, 4 };
+		constexpr S_Bc7Mode MODE7{ 7, 4, 5, false, 2 };  // Two subsets with alpha, same partitions as mode 1
+
+		struct S_SubsetEncoding {
+			uint8_t endpoints[2][4] = {};  // colorBits wide
+			uint8_t pbits[2] = {};
+			uint8_t indices[16] = {};      // Per point of the subset
+			int32_t error = INT32_MAX;
+		};
+
+		const uint8_t* getWeights(uint32_t indexBits) {
+			return indexBits == 2 ? WEIGHTS2 : indexBits == 3 ? WEIGHTS3 : WEIGHTS4;
+		}
+
+		uint32_t unquantize(uint32_t value, uint32_t pbit, uint32_t colorBits) {
+			const uint32_t bits = colorBits + 1;
+			const uint32_t code = (value << 1) | pbit;
+			return (code << (8 - bits)) | (code >> (2 * bits - 8));
+		}
+
+		// Code with the given p-bit whose expansion lands nearest the target
+		uint32_t quantize(float target, uint32_t pbit, uint32_t colorBits) {
+			const int32_t maximum = (1 << colorBits) - 1;
+			const float scaled = target * static_cast<float>((2 << colorBits) - 1) / 255.0f;
+			const int32_t guess = std::clamp(static_cast<int32_t>(std::lround((scaled - static_cast<float>(pbit)) * 0.5f)), 0, maximum);
+			uint32_t best = static_cast<uint32_t>(guess);
+			float bestDistance = 1e30f;
+			for (int32_t candidate = std::max(guess - 1, 0); candidate <= std::min(guess + 1, maximum); ++candidate) {
+				const float distance = std::fabs(static_cast<float>(unquantize(static_cast<uint32_t>(candidate), pbit, colorBits)) - target);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = static_cast<uint32_t>(candidate);
+				}
+			}
+			return best;
+		}
+
+		// Indices and error of a subset whose endpoints are quantized, stopping once the error reaches limit
+		void assignIndices(const S_Points& points, const S_Bc7Mode& mode, S_SubsetEncoding& candidate, int32_t limit) {
+			const uint8_t* weights = getWeights(mode.indexBits);
+			const uint32_t entries = 1u << mode.indexBits;
+			int32_t expanded[2][4];
+			for (uint32_t e = 0; e < 2; ++e) {
+				for (uint32_t c = 0; c < 4; ++c) {
+					expanded[e][c] = c < mode.channels
+						? static_cast<int32_t>(unquantize(candidate.endpoints[e][c], candidate.pbits[e], mode.colorBits)) : 255;
+				}
+			}
+			int32_t palette[16][4];
+			for (uint32_t k = 0; k < entries; ++k) {
+				for (uint32_t c = 0; c < 4; ++c) {
+					palette[k][c] = ((64 - weights[k]) * expanded[0][c] + weights[k] * expanded[1][c] + 32) >> 6;
+				}
+			}
+			candidate.error = 0;
+			for (uint32_t i = 0; i < points.count && candidate.error < limit; ++i) {
+				int32_t nearest = INT32_MAX;
+				for (uint32_t k = 0; k < entries; ++k) {
+					int32_t distance = 0;
+					for (uint32_t c = 0; c < 4; ++c) {
+						distance += squared(palette[k][c] - static_cast<int32_t>(points.values[i][c]));
+					}
+					if (distance < nearest) {
+						nearest = distance;
+						candidate.indices[i] = static_cast<uint8_t>(k);
+					}
+				}
+				candidate.error += nearest;
+			}
+		}
+
+		// Quantizes the endpoints under every p-bit choice and keeps the one with the least error
+		void quantizeSubset(const S_Points& points, const S_Bc7Mode& mode, const float endpoints[2][4], S_SubsetEncoding& best) {
+			const uint32_t choices = mode.sharedPbit ? 2 : 4;
+			for (uint32_t choice = 0; choice < choices; ++choice) {
+				S_SubsetEncoding candidate;
+				candidate.pbits[0] = static_cast<uint8_t>(choice & 1);
+				candidate.pbits[1] = static_cast<uint8_t>(mode.sharedPbit ? choice & 1 : choice >> 1);
+				for (uint32_t e = 0; e < 2; ++e) {
+					for (uint32_t c = 0; c < mode.channels; ++c) {
+						candidate.endpoints[e][c] = static_cast<uint8_t>(quantize(endpoints[e][c], candidate.pbits[e], mode.colorBits));
+					}
+				}
+				assignIndices(points, mode, candidate, best.error);
+				if (candidate.error < best.error) {
+					best = candidate;
+				}
+			}
+		}
+
+		// Moves single endpoint codes one step at a time while that lowers the error. Rounding each
+		// channel to its nearest code is not the best choice once the palette is quantized.
+		void searchEndpoints(const S_Points& points, const S_Bc7Mode& mode, S_SubsetEncoding& best) {
+			const int32_t maximum = (1 << mode.colorBits) - 1;
+			bool improved = true;
+			for (uint32_t round = 0; round < 4 && improved && best.error > 0; ++round) {
+				improved = false;
+				for (uint32_t e = 0; e < 2; ++e) {
+					for (uint32_t c = 0; c < mode.channels; ++c) {
+						for (const int32_t step : { -1, 1 }) {
+							const int32_t code = best.endpoints[e][c] + step;
+							if (code < 0 || code > maximum) {
+								continue;
+							}
+							S_SubsetEncoding candidate = best;
+							candidate.endpoints[e][c] = static_cast<uint8_t>(code);
+							assignIndices(points, mode, candidate, best.error);
+							if (candidate.error < best.error) {
+								best = candidate;
+								improved = true;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void encodeSubset(const S_Points& points, const S_Bc7Mode& mode, uint32_t iterations, S_SubsetEncoding& best) {
+			float mean[4];
+			float axis[4];
+			float residual;
+			float endpoints[2][4];
+			fitLine(points, mode.channels, mean, axis, residual);
+			lineEndpoints(points, mode.channels, mean, axis, endpoints);
+			quantizeSubset(points, mode, endpoints, best);
+
+			float weights[16];
+			for (uint32_t k = 0; k < (1u << mode.indexBits); ++k) {
+				weights[k] = getWeights(mode.indexBits)[k] / 64.0f;
+			}
+			for (uint32_t iteration = 0; iteration < iterations && best.error > 0; ++iteration) {
+				const int32_t previous = best.error;
+				if (!refineEndpoints(points, mode.channels, best.indices, weights, endpoints)) {
+					break;
+				}
+				quantizeSubset(points, mode, endpoints, best);
+				if (best.error >= previous) {
+					break;
+				}
+			}
+		}
+
+		// The anchor's index is stored without its top bit, so it must be in the lower half
+		void fixAnchor(S_SubsetEncoding& subset, uint32_t anchor, uint32_t count, const S_Bc7Mode& mode) {
+			const uint32_t highest = (1u << mode.indexBits) - 1;
+			if (subset.indices[anchor] <= highest / 2) {
+				return;
+			}
+			for (uint32_t c = 0; c < 4; ++c) {
+				std::swap(subset.endpoints[0][c], subset.endpoints[1][c]);
+			}
+			std::swap(subset.pbits[0], subset.pbits[1]);
+			for (uint32_t i = 0; i < count; ++i) {
+				subset.indices[i] = static_cast<uint8_t>(highest - subset.indices[i]);
+			}
+		}
+
+		void storeBlock(const S_BitWriter& writer, std::byte* output) {
+			std::memcpy(output, writer.words, BC7_BYTES);
+		}
+	}
+
+	void encodeBc1(const S_Block& block, E_TextureQuality quality, std::byte* output) {
+		const S_Points points = gather(block, 0xFFFF);
+		float mean[4];
+		float axis[4];
+		float residual;
+		float endpoints[2][4];
+		fitLine(points, 3, mean, axis, residual);
+		lineEndpoints(points, 3, mean, axis, endpoints);
+
+		// Higher end first, so the common ordering c0 > c1 rarely needs a swap
+		std::swap(endpoints[0], endpoints[1]);
+		S_Bc1Encoding best;
+		tryBc1(block, endpoints, best);
+		const uint32_t iterations = quality == E_TextureQuality::FAST ? 0 : quality == E_TextureQuality::NORMAL ? 1 : 3;
+		for (uint32_t iteration = 0; iteration < iterations && best.error > 0; ++iteration) {
+			if (!refineEndpoints(points, 3, best.indices, BC1_WEIGHTS, endpoints)) {
+				break;
+			}
+			tryBc1(block, endpoints, best);
+		}
+
+		uint32_t indices = 0;
+		for (uint32_t i = 0; i < 16; ++i) {
+			indices |= static_cast<uint32_t>(best.indices[i]) << (2 * i);
+		}
+		std::memcpy(output, best.colors, 4);
+		std::memcpy(output + 4, &indices, 4);
+	}
+
+	void encodeBc4(const S_Block& block, uint32_t channel, E_TextureQuality quality, std::byte* output) {
+		uint8_t values[16];
+		int32_t low = 255;
+		int32_t high = 0;
+		for (uint32_t i = 0; i < 16; ++i) {
+			values[i] = block.pixels[i][channel];
+			low = std::min<int32_t>(low, values[i]);
+			high = std::max<int32_t>(high, values[i]);
+		}
+
+		S_Bc4Encoding best;
+		tryBc4(values, high, low, best);
+		if (quality != E_TextureQuality::FAST) {
+			S_Points points;
+			points.count = 16;
+			for (uint32_t i = 0; i < 16; ++i) {
+				points.values[i][0] = values[i];
+			}
+			for (uint32_t iteration = 0; iteration < 2 && best.error > 0 && best.endpoints[0] > best.endpoints[1]; ++iteration) {
+				float endpoints[2][4];
+				if (!refineEndpoints(points, 1, best.indices, BC4_WEIGHTS, endpoints)) {
+					break;
+				}
+				tryBc4(values, static_cast<int32_t>(std::lround(endpoints[0][0])), static_cast<int32_t>(std::lround(endpoints[1][0])), best);
+			}
+		}
+		if (quality == E_TextureQuality::HIGH && best.error > 0) {
+			// The six-value mode has exact 0 and 255, so its endpoints need only span the rest
+			int32_t innerLow = 255;
+			int32_t innerHigh = 0;
+			for (const uint8_t value : values) {
+				if (value != 0 && value != 255) {
+					innerLow = std::min<int32_t>(innerLow, value);
+					innerHigh = std::max<int32_t>(innerHigh, value);
+				}
+			}
+			if (innerLow <= innerHigh) {
+				tryBc4(values, innerLow, innerHigh, best);
+			}
+			const int32_t center0 = best.endpoints[0];
+			const int32_t center1 = best.endpoints[1];
+			for (int32_t d0 = -2; d0 <= 2; ++d0) {
+				for (int32_t d1 = -2; d1 <= 2; ++d1) {
+					const int32_t endpoint0 = center0 + d0;
+					const int32_t endpoint1 = center1 + d1;
+					// Keep the mode the search started in
+					if ((endpoint0 > endpoint1) == (center0 > center1)) {
+						tryBc4(values, endpoint0, endpoint1, best);
+					}
+				}
+			}
+		}
+
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 16; ++i) {
+			indices |= static_cast<uint64_t>(best.indices[i]) << (3 * i);
+		}
+		output[0] = static_cast<std::byte>(best.endpoints[0]);
+		output[1] = static_cast<std::byte>(best.endpoints[1]);
+		std::memcpy(output + 2, &indices, 6);
+	}
+
+	void encodeBc5(const S_Block& block, E_TextureQuality quality, std::byte* output) {
+		encodeBc4(block, 0, quality, output);
+		encodeBc4(block, 1, quality, output + BC4_BYTES);
+	}
+
+	void encodeBc7(const S_Block& block, E_TextureQuality quality, std::byte* output) {
+		const uint32_t iterations = quality == E_TextureQuality::FAST ? 0 : quality == E_TextureQuality::NORMAL ? 1 : 3;
+		const S_Points points = gather(block, 0xFFFF);
+		S_SubsetEncoding single;
+		encodeSubset(points, MODE6, iterations, single);
+
+		// Two subsets: rank the partitions by how well a line fits each subset, encode the best few.
+		// Mode 1 drops alpha, so blocks with alpha need mode 7 and its coarser endpoints.
+		bool opaque = true;
+		for (uint32_t i = 0; i < 16; ++i) {
+			opaque = opaque && block.pixels[i][3] == 255;
+		}
+		const S_Bc7Mode& pairMode = opaque ? MODE1 : MODE7;
+		const uint32_t candidates = quality == E_TextureQuality::FAST || single.error == 0 ? 0
+			: quality == E_TextureQuality::HIGH ? 4 : opaque ? 2 : 0;
+		int32_t bestPartition = -1;
+		S_SubsetEncoding bestSubsets[2];
+		if (candidates > 0) {
+			float residuals[64];
+			uint8_t ranking[64];
+			for (uint32_t partition = 0; partition < 64; ++partition) {
+				float mean[4];
+				float axis[4];
+				float residual0;
+				float residual1;
+				fitLine(gather(block, static_cast<uint16_t>(~PARTITIONS2[partition])), pairMode.channels, mean, axis, residual0);
+				fitLine(gather(block, PARTITIONS2[partition]), pairMode.channels, mean, axis, residual1);
+				residuals[partition] = residual0 + residual1;
+				ranking[partition] = static_cast<uint8_t>(partition);
+			}
+			std::partial_sort(ranking, ranking + candidates, ranking + 64,
+				[&](uint8_t a, uint8_t b) { return residuals[a] < residuals[b]; });
+
+			int32_t bestError = single.error;
+			for (uint32_t candidate = 0; candidate < candidates; ++candidate) {
+				const uint32_t partition = ranking[candidate];
+				S_SubsetEncoding subsets[2];
+				encodeSubset(gather(block, static_cast<uint16_t>(~PARTITIONS2[partition])), pairMode, iterations, subsets[0]);
+				encodeSubset(gather(block, PARTITIONS2[partition]), pairMode, iterations, subsets[1]);
+				if (subsets[0].error + subsets[1].error < bestError) {
+					bestError = subsets[0].error + subsets[1].error;
+					bestPartition = static_cast<int32_t>(partition);
+					bestSubsets[0] = subsets[0];
+					bestSubsets[1] = subsets[1];
+				}
+			}
+		}
+		if (quality == E_TextureQuality::HIGH) {
+			searchEndpoints(points, MODE6, single);
+			if (bestPartition >= 0) {
+				searchEndpoints(gather(block, static_cast<uint16_t>(~PARTITIONS2[bestPartition])), pairMode, bestSubsets[0]);
+				searchEndpoints(gather(block, PARTITIONS2[bestPartition]), pairMode, bestSubsets[1]);
+				if (single.error <= bestSubsets[0].error + bestSubsets[1].error) {
+					bestPartition = -1;
+				}
+			}
+		}
+
+		S_BitWriter writer;
+		if (bestPartition < 0) {
+			fixAnchor(single, 0, 16, MODE6);
+			writer.put(1u << 6, 7);
+			for (uint32_t c = 0; c < 4; ++c) {
+				writer.put(single.endpoints[0][c], 7);
+				writer.put(single.endpoints[1][c], 7);
+			}
+			writer.put(single.pbits[0], 1);
+			writer.put(single.pbits[1], 1);
+			for (uint32_t i = 0; i < 16; ++i) {
+				writer.put(single.indices[i], i == 0 ? 3 : 4);
+			}
+			storeBlock(writer, output);
+			return;
+		}
+
+		const uint16_t mask = PARTITIONS2[bestPartition];
+		const uint32_t anchor = ANCHORS2[bestPartition];
+		uint32_t counts[2] = {};
+		uint32_t anchorPoint = 0;
+		for (uint32_t i = 0; i < 16; ++i) {
+			const uint32_t subset = (mask >> i) & 1;
+			if (i == anchor) {
+				anchorPoint = counts[1];
+			}
+			++counts[subset];
+		}
+		fixAnchor(bestSubsets[0], 0, counts[0], pairMode);
+		fixAnchor(bestSubsets[1], anchorPoint, counts[1], pairMode);
+
+		writer.put(1u << pairMode.number, pairMode.number + 1);
+		writer.put(static_cast<uint32_t>(bestPartition), 6);
+		for (uint32_t c = 0; c < pairMode.channels; ++c) {
+			for (const S_SubsetEncoding& subset : bestSubsets) {
+				writer.put(subset.endpoints[0][c], pairMode.colorBits);
+				writer.put(subset.endpoints[1][c], pairMode.colorBits);
+			}
+		}
+		for (const S_SubsetEncoding& subset : bestSubsets) {
+			writer.put(subset.pbits[0], 1);
+			if (!pairMode.sharedPbit) {
+				writer.put(subset.pbits[1], 1);
+			}
+		}
+		uint32_t next[2] = {};
+		for (uint32_t i = 0; i < 16; ++i) {
+			const uint32_t subset = (mask >> i) & 1;
+			writer.put(bestSubsets[subset].indices[next[subset]++], i == 0 || i == anchor ? pairMode.indexBits - 1 : pairMode.indexBits);
+		}
+		storeBlock(writer, output);
+	}
+
+	void decodeBc1(const std::byte* input, S_Block& block) {
+		uint16_t colors[2];
+		uint32_t indices;
+		std::memcpy(colors, input, 4);
+		std::memcpy(&indices, input + 4, 4);
+		int32_t palette[4][3];
+		bc1Palette(colors[0], colors[1], palette);
+		for (uint32_t i = 0; i < 16; ++i) {
+			const uint32_t index = (indices >> (2 * i)) & 3;
+			for (uint32_t c = 0; c < 3; ++c) {
+				block.pixels[i][c] = static_cast<uint8_t>(palette[index][c]);
+			}
+			block.pixels[i][3] = colors[0] <= colors[1] && index == 3 ? 0 : 255;
+		}
+	}
+
+	void decodeBc4(const std::byte* input, uint32_t channel, S_Block& block) {
+		uint64_t indices = 0;
+		std::memcpy(&indices, input + 2, 6);
+		int32_t palette[8];
+		bc4Palette(std::to_integer<uint32_t>(input[0]), std::to_integer<uint32_t>(input[1]), palette);
+		for (uint32_t i = 0; i < 16; ++i) {
+			block.pixels[i][channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+	void decodeBc5(const std::byte* input, S_Block& block) {
+		decodeBc4(input, 0, block);
+		decodeBc4(input + BC4_BYTES, 1, block);
+	}
+
+	void decodeBc7(const std::byte* input, S_Block& block) {
+		S_BitReader reader;
+		std::memcpy(reader.words, input, BC7_BYTES);
+		const uint32_t first = std::to_integer<uint32_t>(input[0]);
+		const uint32_t mode = first ? static_cast<uint32_t>(std::countr_zero(first)) : 8;
+		if (mode != 1 && mode != 6 && mode != 7) {
+			std::memset(block.pixels, 0, sizeof(block.pixels));
+			return;
+		}
+		reader.get(mode + 1);
+
+		const S_Bc7Mode& info = mode == 1 ? MODE1 : mode == 6 ? MODE6 : MODE7;
+		const uint32_t subsetCount = mode == 6 ? 1 : 2;
+		const uint32_t partition = subsetCount == 2 ? reader.get(6) : 0;
+		uint32_t endpoints[2][2][4] = {};  // Subset, endpoint, channel
+		for (uint32_t c = 0; c < info.channels; ++c) {
+			for (uint32_t s = 0; s < subsetCount; ++s) {
+				endpoints[s][0][c] = reader.get(info.colorBits);
+				endpoints[s][1][c] = reader.get(info.colorBits);
+			}
+		}
+		uint32_t pbits[2][2] = {};
+		for (uint32_t s = 0; s < subsetCount; ++s) {
+			pbits[s][0] = reader.get(1);
+			pbits[s][1] = info.sharedPbit ? pbits[s][0] : reader.get(1);
+		}
+
+		const uint16_t mask = subsetCount == 2 ? PARTITIONS2[partition] : 0;
+		const uint32_t anchor = subsetCount == 2 ? ANCHORS2[partition] : 0;
+		const uint8_t* weights = getWeights(info.indexBits);
+		for (uint32_t i = 0; i < 16; ++i) {
+			const uint32_t subset = (mask >> i) & 1;
+			const uint32_t index = reader.get(i == 0 || (subsetCount == 2 && i == anchor) ? info.indexBits - 1 : info.indexBits);
+			for (uint32_t c = 0; c < 4; ++c) {
+				if (c >= info.channels) {
+					block.pixels[i][c] = 255;
+					continue;
+				}
+				const uint32_t value0 = unquantize(endpoints[subset][0][c], pbits[subset][0], info.colorBits);
+				const uint32_t value1 = unquantize(endpoints[subset][1][c], pbits[subset][1], info.colorBits);
+				block.pixels[i][c] = static_cast<uint8_t>(((64 - weights[index]) * value0 + weights[index] * value1 + 32) >> 6);
+			}
+		}
+	}
+}
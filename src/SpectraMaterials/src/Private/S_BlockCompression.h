@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "S_TextureProcessor.h"
+
+// Encoders and decoders of single 4x4 blocks. Encoders fit endpoints along the principal
+// axis of the block's colors and pick indices by exhaustive search over the palette; the
+// tiers of E_TextureQuality add least squares refinement and wider searches. Decoders follow
+// the D3D rules and exist for previews and measuring error.
+namespace spectra::materials::blocks {
+	// Row-major RGBA8 pixels of one block; blocks over the image edge repeat the last row and column
+	struct S_Block {
+		uint8_t pixels[16][4];
+	};
+
+	constexpr uint32_t BC1_BYTES = 8;
+	constexpr uint32_t BC4_BYTES = 8;
+	constexpr uint32_t BC5_BYTES = 16;
+	constexpr uint32_t BC7_BYTES = 16;
+
+	// Opaque four-color blocks only; alpha is not encoded
+	void encodeBc1(const S_Block& block, E_TextureQuality quality, std::byte* output);
+	void encodeBc4(const S_Block& block, uint32_t channel, E_TextureQuality quality, std::byte* output);
+	void encodeBc5(const S_Block& block, E_TextureQuality quality, std::byte* output);  // Red and green
+
+	// Mode 6 for every block, plus mode 1 with its best partitions for opaque blocks from NORMAL on.
+	// HIGH adds mode 7 for blocks with alpha and searches the quantized endpoints.
+	void encodeBc7(const S_Block& block, E_TextureQuality quality, std::byte* output);
+
+	void decodeBc1(const std::byte* input, S_Block& block);
+	void decodeBc4(const std::byte* input, uint32_t channel, S_Block& block);  // Writes only that channel
+	void decodeBc5(const std::byte* input, S_Block& block);                   // Red and green
+	void decodeBc7(const std::byte* input, S_Block& block);                   // Modes 1, 6 and 7, zeros otherwise
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "S_MaterialGraph.h"
+
+namespace spectra::materials {
+	// Two independent 64-bit lanes of murmur-style mixing. Not cryptographic: cache keys
+	// assume collisions between honest inputs never happen, which 128 bits make safe.
+	struct S_ContentHasher {
+		uint64_t a = 0x9E3779B97F4A7C15ull;
+		uint64_t b = 0xC2B2AE3D27D4EB4Full;
+		uint64_t count = 0;
+
+		static uint64_t mix(uint64_t x) {
+			x ^= x >> 33;
+			x *= 0xFF51AFD7ED558CCDull;
+			x ^= x >> 33;
+			x *= 0xC4CEB9FE1A85EC53ull;
+			return x ^ (x >> 33);
+		}
+
+		void add(uint64_t value) {
+			a = std::rotl(a ^ mix(value), 27) * 5 + 0x52DCE729ull;
+			b = std::rotl(b ^ mix(value * 0x87C37B91114253D5ull + count), 31) * 5 + 0x38495AB5ull;
+			++count;
+		}
+
+		void addBytes(std::span<const std::byte> bytes) {
+			size_t offset = 0;
+			for (; offset + sizeof(uint64_t) <= bytes.size(); offset += sizeof(uint64_t)) {
+				uint64_t word;
+				std::memcpy(&word, bytes.data() + offset, sizeof(word));
+				add(word);
+			}
+			uint64_t tail = bytes.size();
+			std::memcpy(&tail, bytes.data() + offset, bytes.size() - offset);
+			add(tail);
+		}
+
+		[[nodiscard]] S_MaterialKey finish() const {
+			return { mix(a ^ count), mix(b + a) };
+		}
+	};
+}
@@ -0,0 +1,342 @@
+#include "S_MaterialCache.h"
+#include "S_ContentHasher.h"
+#include "S_FileLock.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace spectra::materials {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::materials::cache";
+		constexpr uint32_t PACK_MAGIC = 0x4B50534D;  // "MSPK"
+		constexpr uint32_t PACK_VERSION = 1;
+		constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+		uint64_t secondsSinceEpoch() {
+			return static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		uint64_t alignUp(uint64_t value, uint64_t alignment) {
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		uint64_t checksum(std::span<const std::byte> bytes) {
+			S_ContentHasher hasher;
+			hasher.addBytes(bytes);
+			return hasher.finish().low;
+		}
+	}
+
+	struct S_MaterialCache::S_PackHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t fileSize;
+		uint32_t entryCount;
+		uint32_t reserved;
+		uint64_t indexChecksum;
+	};
+
+	// Sorted by key, blobs in the same order
+	struct S_MaterialCache::S_PackEntry {
+		S_MaterialKey key;
+		uint64_t offset;
+		uint64_t checksum;
+		uint64_t lastUse;  // Seconds since the epoch
+		uint32_t size;
+		E_CacheBlobType type;
+	};
+
+	// S_MaterialCache implementations
+	S_MaterialCache::S_MaterialCache(S_MaterialCacheSettings cacheSettings) : settings(std::move(cacheSettings)) {
+		std::error_code error;
+		std::filesystem::create_directories(settings.directory, error);
+		if (error) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_MaterialCache", "S_MaterialCache",
+				"Could not create the cache directory", settings.directory, error.message());
+		}
+		packPath = std::filesystem::path(settings.directory) / "materials.pack";
+		lockPath = std::filesystem::path(settings.directory) / "materials.lock";
+
+		std::lock_guard guard(mutex);
+		reloadPack();
+	}
+
+	S_MaterialCache::~S_MaterialCache() {
+		flush();
+	}
+
+	S_MaterialKey S_MaterialCache::getProgramKey(const S_MaterialGraph& graph) {
+		const S_MaterialKey graphKey = graph.computeContentKey();
+		S_ContentHasher hasher;
+		hasher.add(graphKey.high);
+		hasher.add(graphKey.low);
+		hasher.add(S_MaterialCompiler::VERSION);
+		hasher.add(S_MaterialProgram::FORMAT_VERSION);
+		hasher.add(static_cast<uint64_t>(E_CacheBlobType::MATERIAL_PROGRAM));
+		return hasher.finish();
+	}
+
+	const S_MaterialCache::S_PackEntry* S_MaterialCache::openPack(const std::filesystem::path& path, core::platform::S_MappedFile& file,
+		uint32_t& entryCount) {
+		using namespace spectra::instrumentation;
+
+		file.close();
+		entryCount = 0;
+		std::error_code error;
+		if (!std::filesystem::exists(path, error)) {
+			return nullptr;
+		}
+		if (!file.open(path.string())) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_MaterialCache", "openPack", "Could not map the pack", path.string(), file.getLastError());
+			return nullptr;
+		}
+
+		const std::byte* data = file.getData();
+		const uint64_t size = file.getSize();
+		S_PackHeader header{};
+		bool valid = size >= sizeof(header);
+		if (valid) {
+			std::memcpy(&header, data, sizeof(header));
+			valid = header.magic == PACK_MAGIC && header.version == PACK_VERSION && header.fileSize == size
+				&& sizeof(header) + uint64_t(header.entryCount) * sizeof(S_PackEntry) <= size;
+		}
+		const auto* entries = reinterpret_cast<const S_PackEntry*>(data + sizeof(header));
+		if (valid) {
+			valid = checksum({ data + sizeof(header), header.entryCount * sizeof(S_PackEntry) }) == header.indexChecksum;
+		}
+		for (uint32_t i = 0; valid && i < header.entryCount; ++i) {
+			valid = entries[i].offset <= size && entries[i].size <= size - entries[i].offset;
+		}
+		if (!valid) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_MaterialCache", "openPack", "Ignoring a corrupt pack", path.string());
+			file.close();
+			return nullptr;
+		}
+		entryCount = header.entryCount;
+		return entries;
+	}
+
+	// The file is examined before it is mapped, so a pack replaced in between reads as stale
+	void S_MaterialCache::reloadPack() {
+		std::error_code error;
+		packWriteTime = std::filesystem::last_write_time(packPath, error);
+		packFileSize = error ? 0 : std::filesystem::file_size(packPath, error);
+		packEntries = openPack(packPath, pack, packEntryCount);
+		stats.entries = packEntryCount;
+		stats.packBytes = pack.isOpen() ? pack.getSize() : 0;
+	}
+
+	bool S_MaterialCache::isPackStale() const {
+		std::error_code error;
+		const auto writeTime = std::filesystem::last_write_time(packPath, error);
+		if (error) {
+			return false;
+		}
+		const uintmax_t fileSize = std::filesystem::file_size(packPath, error);
+		return !error && (writeTime != packWriteTime || fileSize != packFileSize);
+	}
+
+	const S_MaterialCache::S_PackEntry* S_MaterialCache::findEntry(const S_MaterialKey& key) const {
+		const S_PackEntry* end = packEntries + packEntryCount;
+		const S_PackEntry* entry = std::lower_bound(packEntries, end, key,
+			[](const S_PackEntry& candidate, const S_MaterialKey& value) { return candidate.key < value; });
+		return entry != end && entry->key == key ? entry : nullptr;
+	}
+
+	bool S_MaterialCache::find(const S_MaterialKey& key, E_CacheBlobType type, std::vector<std::byte>& blob) {
+		std::lock_guard guard(mutex);
+		if (const auto it = pending.find(key); it != pending.end() && it->second.type == type) {
+			blob = it->second.blob;
+			++stats.hits;
+			return true;
+		}
+
+		const S_PackEntry* entry = findEntry(key);
+		if (!entry && isPackStale()) {
+			reloadPack();
+			++stats.reloads;
+			entry = findEntry(key);
+		}
+		if (!entry || entry->type != type) {
+			++stats.misses;
+			return false;
+		}
+		const std::span<const std::byte> bytes(pack.getData() + entry->offset, entry->size);
+		if (checksum(bytes) != entry->checksum) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_MaterialCache", "find",
+				"Cached blob failed its checksum", packPath.string(), entry->offset);
+			++stats.corruptEntries;
+			++stats.misses;
+			return false;
+		}
+		blob.assign(bytes.begin(), bytes.end());
+		lastUses[key] = secondsSinceEpoch();
+		++stats.hits;
+		return true;
+	}
+
+	void S_MaterialCache::store(const S_MaterialKey& key, E_CacheBlobType type, std::span<const std::byte> blob) {
+		std::lock_guard guard(mutex);
+		pending[key] = { type, std::vector<std::byte>(blob.begin(), blob.end()) };
+		++stats.stores;
+	}
+
+	S_MaterialProgram S_MaterialCache::getProgram(const S_MaterialGraph& graph, S_MaterialCompiler& compiler) {
+		const S_MaterialKey key = getProgramKey(graph);
+		std::vector<std::byte> blob;
+		S_MaterialProgram program;
+		if (find(key, E_CacheBlobType::MATERIAL_PROGRAM, blob) && S_MaterialProgram::deserialize(blob, program)) {
+			return program;
+		}
+		program = compiler.compile(graph);
+		store(key, E_CacheBlobType::MATERIAL_PROGRAM, program.serialize());
+		return program;
+	}
+
+	bool S_MaterialCache::flush() {
+		using namespace spectra::instrumentation;
+
+		std::lock_guard guard(mutex);
+		if (pending.empty() && lastUses.empty()) {
+			return true;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		core::platform::S_FileLock fileLock;
+		if (!fileLock.lock(lockPath.string())) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_MaterialCache", "flush", "Could not lock the cache", lockPath.string(),
+				fileLock.getLastError());
+			return false;
+		}
+
+		// Merge into the newest pack, which other processes may have written since ours was mapped
+		core::platform::S_MappedFile current;
+		uint32_t currentCount = 0;
+		const S_PackEntry* currentEntries = openPack(packPath, current, currentCount);
+
+		struct S_MergedEntry {
+			S_MaterialKey key;
+			E_CacheBlobType type;
+			uint64_t lastUse;
+			uint64_t checksum;
+			std::span<const std::byte> blob;
+		};
+		std::vector<S_MergedEntry> merged;
+		merged.reserve(currentCount + pending.size());
+		for (uint32_t i = 0; i < currentCount; ++i) {
+			const S_PackEntry& entry = currentEntries[i];
+			if (pending.contains(entry.key)) {
+				continue;  // A fresh blob also repairs a corrupt one
+			}
+			const auto used = lastUses.find(entry.key);
+			merged.push_back({ entry.key, entry.type, used == lastUses.end() ? entry.lastUse : std::max(entry.lastUse, used->second),
+				entry.checksum, { current.getData() + entry.offset, entry.size } });
+		}
+		const uint64_t now = secondsSinceEpoch();
+		for (const auto& [key, entry] : pending) {
+			merged.push_back({ key, entry.type, now, checksum(entry.blob), entry.blob });
+		}
+
+		// Least recently used beyond the budget go; ties broken by key so every process agrees
+		std::sort(merged.begin(), merged.end(), [](const S_MergedEntry& a, const S_MergedEntry& b) {
+			return a.lastUse != b.lastUse ? a.lastUse > b.lastUse : a.key < b.key;
+		});
+		uint64_t keptBytes = 0;
+		size_t kept = 0;
+		while (kept < merged.size() && keptBytes + merged[kept].blob.size() <= settings.maxBytes) {
+			keptBytes += merged[kept++].blob.size();
+		}
+		const size_t evicted = merged.size() - kept;
+		merged.resize(kept);
+		std::sort(merged.begin(), merged.end(), [](const S_MergedEntry& a, const S_MergedEntry& b) { return a.key < b.key; });
+
+		std::vector<S_PackEntry> index(merged.size());
+		uint64_t offset = alignUp(sizeof(S_PackHeader) + index.size() * sizeof(S_PackEntry), BLOB_ALIGNMENT);
+		for (size_t i = 0; i < merged.size(); ++i) {
+			index[i] = { merged[i].key, offset, merged[i].checksum, merged[i].lastUse, static_cast<uint32_t>(merged[i].blob.size()), merged[i].type };
+			offset = alignUp(offset + merged[i].blob.size(), BLOB_ALIGNMENT);
+		}
+		const S_PackHeader header{ PACK_MAGIC, PACK_VERSION, offset, static_cast<uint32_t>(index.size()), 0,
+			checksum({ reinterpret_cast<const std::byte*>(index.data()), index.size() * sizeof(S_PackEntry) }) };
+
+		std::filesystem::path temporaryPath = packPath;
+		temporaryPath += ".tmp";
+		{
+			constexpr char zeros[BLOB_ALIGNMENT] = {};
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(S_PackEntry)));
+			uint64_t position = sizeof(header) + index.size() * sizeof(S_PackEntry);
+			for (size_t i = 0; i < merged.size(); ++i) {
+				stream.write(zeros, static_cast<std::streamsize>(index[i].offset - position));
+				stream.write(reinterpret_cast<const char*>(merged[i].blob.data()), static_cast<std::streamsize>(merged[i].blob.size()));
+				position = index[i].offset + merged[i].blob.size();
+			}
+			stream.write(zeros, static_cast<std::streamsize>(header.fileSize - position));
+			if (!stream) {
+				Instrumentation::logRender(E_LogLevel::WARNING, "S_MaterialCache", "flush", "Could not write the pack", temporaryPath.string());
+				stream.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		// Windows will not replace a file that is mapped, so let go of both views first
+		current.close();
+		pack.close();
+		packEntries = nullptr;
+		packEntryCount = 0;
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, packPath, error);
+		if (error) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_MaterialCache", "flush", "Could not replace the pack", packPath.string(),
+				error.message());
+			std::filesystem::remove(temporaryPath, error);
+			reloadPack();
+			return false;
+		}
+		fileLock.unlock();
+
+		pending.clear();
+		lastUses.clear();
+		stats.evictions += evicted;
+		++stats.flushes;
+		reloadPack();
+		stats.flushMilliseconds = millisecondsSince(start);
+		Instrumentation::recordTiming(STATS_CATEGORY, "flush", stats.flushMilliseconds);
+		return true;
+	}
+
+	S_MaterialCacheStats S_MaterialCache::getStats() const {
+		std::lock_guard guard(mutex);
+		return stats;
+	}
+
+	std::string S_MaterialCache::getPackPath() const {
+		return packPath.string();
+	}
+
+	void S_MaterialCache::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		const S_MaterialCacheStats current = getStats();
+		Instrumentation::setGauge(STATS_CATEGORY, "hits", static_cast<double>(current.hits));
+		Instrumentation::setGauge(STATS_CATEGORY, "misses", static_cast<double>(current.misses));
+		Instrumentation::setGauge(STATS_CATEGORY, "stores", static_cast<double>(current.stores));
+		Instrumentation::setGauge(STATS_CATEGORY, "evictions", static_cast<double>(current.evictions));
+		Instrumentation::setGauge(STATS_CATEGORY, "flushes", static_cast<double>(current.flushes));
+		Instrumentation::setGauge(STATS_CATEGORY, "reloads", static_cast<double>(current.reloads));
+		Instrumentation::setGauge(STATS_CATEGORY, "corruptEntries", static_cast<double>(current.corruptEntries));
+		Instrumentation::setGauge(STATS_CATEGORY, "entries", static_cast<double>(current.entries));
+		Instrumentation::setGauge(STATS_CATEGORY, "packBytes", static_cast<double>(current.packBytes));
+	}
+}
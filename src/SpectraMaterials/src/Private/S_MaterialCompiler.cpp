@@ -0,0 +1,527 @@
+#include "S_MaterialCompiler.h"
+#include "S_MaterialOps.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+namespace spectra::materials {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::materials";
+
+		constexpr uint8_t MARK_NONE = 0;
+		constexpr uint8_t MARK_VISITING = 1;
+		constexpr uint8_t MARK_DONE = 2;
+
+		uint32_t getOperandCount(E_MaterialOp op) {
+			switch (op) {
+			case E_MaterialOp::ABSOLUTE:
+			case E_MaterialOp::SQUARE_ROOT:
+			case E_MaterialOp::FLOOR:
+				return 1;
+			case E_MaterialOp::MIX:
+				return 3;
+			case E_MaterialOp::COUNT:
+			case E_MaterialOp::LOAD_INPUT:
+				return 0;  // Constants and loads read no other value
+			default:
+				return 2;
+			}
+		}
+
+		E_MaterialOp getElementOp(E_MaterialNodeType type) {
+			switch (type) {
+			case E_MaterialNodeType::ADD:
+				return E_MaterialOp::ADD;
+			case E_MaterialNodeType::SUBTRACT:
+				return E_MaterialOp::SUBTRACT;
+			case E_MaterialNodeType::MULTIPLY:
+				return E_MaterialOp::MULTIPLY;
+			case E_MaterialNodeType::DIVIDE:
+				return E_MaterialOp::DIVIDE;
+			case E_MaterialNodeType::MINIMUM:
+				return E_MaterialOp::MINIMUM;
+			case E_MaterialNodeType::MAXIMUM:
+				return E_MaterialOp::MAXIMUM;
+			case E_MaterialNodeType::ABSOLUTE:
+				return E_MaterialOp::ABSOLUTE;
+			case E_MaterialNodeType::SQUARE_ROOT:
+				return E_MaterialOp::SQUARE_ROOT;
+			case E_MaterialNodeType::FLOOR:
+				return E_MaterialOp::FLOOR;
+			case E_MaterialNodeType::STEP:
+				return E_MaterialOp::STEP;
+			default:
+				return E_MaterialOp::COUNT;
+			}
+		}
+
+		// Division by 2^k is exactly multiplication by 2^-k while both are normal
+		bool hasExactReciprocal(float value) {
+			int exponent = 0;
+			return std::isnormal(value) && std::isnormal(1.0f / value) && std::fabs(std::frexp(value, &exponent)) == 0.5f;
+		}
+	}
+
+	// S_MaterialCompiler implementations
+	size_t S_MaterialCompiler::S_ValueKeyHash::operator()(const S_ValueKey& key) const {
+		uint64_t hash = static_cast<uint64_t>(key.op) * 0x9E3779B97F4A7C15ull;
+		for (const uint32_t operand : key.operands) {
+			hash = (hash ^ operand) * 0xFF51AFD7ED558CCDull;
+		}
+		return static_cast<size_t>(hash ^ (hash >> 32));
+	}
+
+	S_MaterialProgram S_MaterialCompiler::compile(const S_MaterialGraph& graph) {
+		using namespace spectra::instrumentation;
+
+		const auto start = std::chrono::steady_clock::now();
+		values.clear();
+		valueIndices.clear();
+		constantIndices.clear();
+		stats = {};
+		stats.graphNodes = static_cast<uint32_t>(graph.getNodes().size());
+
+		sortLiveNodes(graph);
+		stats.liveNodes = static_cast<uint32_t>(order.size());
+		nodeValues.assign(graph.getNodes().size(), {});
+		for (const uint32_t node : order) {
+			lowerNode(graph, node);
+		}
+
+		// Unconnected outputs take their defaults; VECTOR3 outputs broadcast FLOAT sources
+		std::array<uint32_t, MATERIAL_CHANNEL_COUNT> channelValues{};
+		auto outputValue = [&](E_MaterialOutput output, float defaultValue, bool vector) {
+			const S_MaterialSocket socket = graph.getOutput(output);
+			if (!socket.isValid()) {
+				S_NodeValue value;
+				value.components[0] = constant(defaultValue);
+				return value;
+			}
+			const S_NodeValue& value = nodeValues[socket.node];
+			if (!vector && value.type != E_MaterialValueType::FLOAT) {
+				Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Output takes a FLOAT, use a Split node",
+					static_cast<uint32_t>(output), socket.node);
+			}
+			return value;
+		};
+		const S_NodeValue baseColor = outputValue(E_MaterialOutput::BASE_COLOR, 0.8f, true);
+		const S_NodeValue emission = outputValue(E_MaterialOutput::EMISSION, 0.0f, true);
+		for (uint32_t i = 0; i < 3; ++i) {
+			channelValues[static_cast<size_t>(E_MaterialChannel::BASE_COLOR_R) + i] = component(baseColor, i);
+			channelValues[static_cast<size_t>(E_MaterialChannel::EMISSION_R) + i] = component(emission, i);
+		}
+		channelValues[static_cast<size_t>(E_MaterialChannel::ROUGHNESS)] = outputValue(E_MaterialOutput::ROUGHNESS, 0.5f, false).components[0];
+		channelValues[static_cast<size_t>(E_MaterialChannel::METALLIC)] = outputValue(E_MaterialOutput::METALLIC, 0.0f, false).components[0];
+		channelValues[static_cast<size_t>(E_MaterialChannel::OPACITY)] = outputValue(E_MaterialOutput::OPACITY, 1.0f, false).components[0];
+
+		S_MaterialProgram program;
+		allocateRegisters(channelValues, program);
+
+		stats.instructions = static_cast<uint32_t>(program.instructions.size());
+		stats.constants = static_cast<uint32_t>(program.constants.size());
+		stats.registers = program.registerCount;
+		stats.compileMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		program.stats = stats;
+		Instrumentation::recordTiming(STATS_CATEGORY, "compile", stats.compileMilliseconds);
+		return program;
+	}
+
+	// Post-order from the outputs: every node after its inputs, unreachable nodes left out
+	void S_MaterialCompiler::sortLiveNodes(const S_MaterialGraph& graph) {
+		using namespace spectra::instrumentation;
+
+		const std::vector<S_MaterialNode>& nodes = graph.getNodes();
+		order.clear();
+		marks.assign(nodes.size(), MARK_NONE);
+		std::vector<std::pair<uint32_t, uint32_t>> stack;  // Node and the next input to visit
+		for (uint32_t output = 0; output < static_cast<uint32_t>(E_MaterialOutput::COUNT); ++output) {
+			const S_MaterialSocket root = graph.getOutput(static_cast<E_MaterialOutput>(output));
+			if (!root.isValid()) {
+				continue;
+			}
+			if (root.node >= nodes.size()) {
+				Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Output connected to a missing node", output, root.node);
+			}
+			if (marks[root.node] != MARK_NONE) {
+				continue;
+			}
+			marks[root.node] = MARK_VISITING;
+			stack.push_back({ root.node, 0 });
+			while (!stack.empty()) {
+				const uint32_t node = stack.back().first;
+				const uint32_t slot = stack.back().second;
+				if (slot == S_MaterialGraph::getInputCount(nodes[node].type)) {
+					marks[node] = MARK_DONE;
+					order.push_back(node);
+					stack.pop_back();
+					continue;
+				}
+				++stack.back().second;
+
+				const uint32_t input = nodes[node].inputs[slot];
+				if (input == INVALID_NODE || input >= nodes.size()) {
+					Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Unconnected node input",
+						S_MaterialGraph::getNodeTypeName(nodes[node].type), node, slot);
+				}
+				if (marks[input] == MARK_VISITING) {
+					Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Cycle through node",
+						S_MaterialGraph::getNodeTypeName(nodes[input].type), input);
+				}
+				if (marks[input] == MARK_NONE) {
+					marks[input] = MARK_VISITING;
+					stack.push_back({ input, 0 });
+				}
+			}
+		}
+	}
+
+	void S_MaterialCompiler::lowerNode(const S_MaterialGraph& graph, uint32_t index) {
+		using namespace spectra::instrumentation;
+		using T = E_MaterialNodeType;
+		using O = E_MaterialOp;
+
+		const S_MaterialNode& node = graph.getNodes()[index];
+		auto in = [&](uint32_t slot) -> const S_NodeValue& { return nodeValues[node.inputs[slot]]; };
+		auto load = [&](E_ShadingChannel channel) { return emit(O::LOAD_INPUT, static_cast<uint32_t>(channel)); };
+		auto dot = [&](const S_NodeValue& a, const S_NodeValue& b) {
+			uint32_t sum = emit(O::MULTIPLY, component(a, 0), component(b, 0));
+			for (uint32_t i = 1; i < 3; ++i) {
+				sum = emit(O::ADD, sum, emit(O::MULTIPLY, component(a, i), component(b, i)));
+			}
+			return sum;
+		};
+
+		S_NodeValue result;
+		switch (node.type) {
+		case T::CONSTANT:
+			result.type = node.valueType;
+			for (uint32_t i = 0; i < (result.type == E_MaterialValueType::VECTOR3 ? 3u : 1u); ++i) {
+				result.components[i] = constant(node.value[i]);
+			}
+			break;
+		case T::INPUT:
+			switch (static_cast<E_MaterialInput>(node.parameter)) {
+			case E_MaterialInput::U:
+				result.components[0] = load(E_ShadingChannel::U);
+				break;
+			case E_MaterialInput::V:
+				result.components[0] = load(E_ShadingChannel::V);
+				break;
+			case E_MaterialInput::POSITION:
+			case E_MaterialInput::NORMAL: {
+				const uint32_t first = static_cast<uint32_t>(node.parameter == static_cast<uint32_t>(E_MaterialInput::POSITION)
+					? E_ShadingChannel::POSITION_X : E_ShadingChannel::NORMAL_X);
+				result.type = E_MaterialValueType::VECTOR3;
+				for (uint32_t i = 0; i < 3; ++i) {
+					result.components[i] = load(static_cast<E_ShadingChannel>(first + i));
+				}
+				break;
+			}
+			case E_MaterialInput::COS_THETA:
+				result.components[0] = load(E_ShadingChannel::COS_THETA);
+				break;
+			default:
+				Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Unknown material input", index, node.parameter);
+			}
+			break;
+		case T::ADD:
+		case T::SUBTRACT:
+		case T::MULTIPLY:
+		case T::DIVIDE:
+		case T::MINIMUM:
+		case T::MAXIMUM:
+		case T::STEP:
+			result = binary(getElementOp(node.type), in(0), in(1));
+			break;
+		case T::ABSOLUTE:
+		case T::SQUARE_ROOT:
+		case T::FLOOR:
+		case T::FRACTION:
+		case T::SATURATE:
+			result.type = in(0).type;
+			for (uint32_t i = 0; i < (result.type == E_MaterialValueType::VECTOR3 ? 3u : 1u); ++i) {
+				const uint32_t x = in(0).components[i];
+				if (node.type == T::FRACTION) {
+					result.components[i] = emit(O::SUBTRACT, x, emit(O::FLOOR, x));
+				}
+				else if (node.type == T::SATURATE) {
+					result.components[i] = emit(O::MINIMUM, emit(O::MAXIMUM, x, constant(0.0f)), constant(1.0f));
+				}
+				else {
+					result.components[i] = emit(getElementOp(node.type), x);
+				}
+			}
+			break;
+		case T::MIX: {
+			const bool vector = in(0).type == E_MaterialValueType::VECTOR3 || in(1).type == E_MaterialValueType::VECTOR3
+				|| in(2).type == E_MaterialValueType::VECTOR3;
+			result.type = vector ? E_MaterialValueType::VECTOR3 : E_MaterialValueType::FLOAT;
+			for (uint32_t i = 0; i < (vector ? 3u : 1u); ++i) {
+				result.components[i] = emit(O::MIX, component(in(0), i), component(in(1), i), component(in(2), i));
+			}
+			break;
+		}
+		case T::DOT:
+			result.components[0] = dot(in(0), in(1));
+			break;
+		case T::LENGTH:
+			result.components[0] = emit(O::SQUARE_ROOT, dot(in(0), in(0)));
+			break;
+		case T::NORMALIZE: {
+			const uint32_t length = emit(O::SQUARE_ROOT, dot(in(0), in(0)));
+			result.type = E_MaterialValueType::VECTOR3;
+			for (uint32_t i = 0; i < 3; ++i) {
+				result.components[i] = emit(O::DIVIDE, component(in(0), i), length);
+			}
+			break;
+		}
+		case T::COMBINE:
+			result.type = E_MaterialValueType::VECTOR3;
+			for (uint32_t i = 0; i < 3; ++i) {
+				result.components[i] = component(in(i), 0);
+			}
+			break;
+		case T::SPLIT:
+			if (node.parameter >= 3) {
+				Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Split component out of range", index, node.parameter);
+			}
+			result.components[0] = component(in(0), node.parameter);
+			break;
+		case T::CHECKER: {
+			// fract((floor(u * scale) + floor(v * scale)) / 2) * 2
+			const uint32_t scale = component(in(2), 0);
+			const uint32_t cells = emit(O::ADD, emit(O::FLOOR, emit(O::MULTIPLY, component(in(0), 0), scale)),
+				emit(O::FLOOR, emit(O::MULTIPLY, component(in(1), 0), scale)));
+			const uint32_t half = emit(O::MULTIPLY, cells, constant(0.5f));
+			result.components[0] = emit(O::MULTIPLY, emit(O::SUBTRACT, half, emit(O::FLOOR, half)), constant(2.0f));
+			break;
+		}
+		case T::FRESNEL: {
+			// f0 + (1 - f0) * (1 - cosTheta)^5 as mix(f0, 1, m^5)
+			const uint32_t m = emit(O::MINIMUM, emit(O::MAXIMUM, emit(O::SUBTRACT, constant(1.0f), component(in(1), 0)), constant(0.0f)),
+				constant(1.0f));
+			const uint32_t m2 = emit(O::MULTIPLY, m, m);
+			const uint32_t m5 = emit(O::MULTIPLY, emit(O::MULTIPLY, m2, m2), m);
+			result.type = in(0).type;
+			for (uint32_t i = 0; i < (result.type == E_MaterialValueType::VECTOR3 ? 3u : 1u); ++i) {
+				result.components[i] = emit(O::MIX, in(0).components[i], constant(1.0f), m5);
+			}
+			break;
+		}
+		default:
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialCompiler", "compile", "Unknown node type", index, static_cast<uint32_t>(node.type));
+		}
+		nodeValues[index] = result;
+	}
+
+	S_MaterialCompiler::S_NodeValue S_MaterialCompiler::binary(E_MaterialOp op, const S_NodeValue& a, const S_NodeValue& b) {
+		S_NodeValue result;
+		const bool vector = a.type == E_MaterialValueType::VECTOR3 || b.type == E_MaterialValueType::VECTOR3;
+		result.type = vector ? E_MaterialValueType::VECTOR3 : E_MaterialValueType::FLOAT;
+		for (uint32_t i = 0; i < (vector ? 3u : 1u); ++i) {
+			result.components[i] = emit(op, component(a, i), component(b, i));
+		}
+		return result;
+	}
+
+	uint32_t S_MaterialCompiler::component(const S_NodeValue& value, uint32_t index) const {
+		return value.components[value.type == E_MaterialValueType::VECTOR3 ? index : 0];
+	}
+
+	uint32_t S_MaterialCompiler::constant(float value) {
+		const auto [it, inserted] = constantIndices.try_emplace(std::bit_cast<uint32_t>(value), static_cast<uint32_t>(values.size()));
+		if (inserted) {
+			S_Value constantValue;
+			constantValue.constant = value;
+			values.push_back(constantValue);
+		}
+		return it->second;
+	}
+
+	bool S_MaterialCompiler::isConstant(uint32_t value, float constantValue) const {
+		return values[value].op == E_MaterialOp::COUNT && values[value].constant == constantValue;
+	}
+
+	// Folds, simplifies and merges before creating a value, so the SSA stays minimal as it grows
+	uint32_t S_MaterialCompiler::emit(E_MaterialOp op, uint32_t a, uint32_t b, uint32_t c) {
+		using O = E_MaterialOp;
+
+		if (op != O::LOAD_INPUT) {
+			const std::array<uint32_t, 3> operands{ a, b, c };
+			const uint32_t operandCount = getOperandCount(op);
+			bool folded = true;
+			std::array<float, 3> constants{};
+			for (uint32_t i = 0; i < operandCount; ++i) {
+				folded = folded && values[operands[i]].op == O::COUNT;
+				constants[i] = values[operands[i]].constant;
+			}
+			if (folded) {
+				++stats.foldedOperations;
+				return constant(ops::apply(op, constants[0], constants[1], constants[2]));
+			}
+
+			uint32_t simplified = NO_VALUE;
+			switch (op) {
+			case O::ADD:
+				simplified = isConstant(b, 0.0f) ? a : isConstant(a, 0.0f) ? b : NO_VALUE;
+				break;
+			case O::SUBTRACT:
+				simplified = isConstant(b, 0.0f) ? a : NO_VALUE;
+				break;
+			case O::MULTIPLY:
+				if (isConstant(a, 0.0f) || isConstant(b, 0.0f)) {
+					simplified = constant(0.0f);
+				}
+				else {
+					simplified = isConstant(b, 1.0f) ? a : isConstant(a, 1.0f) ? b : NO_VALUE;
+				}
+				break;
+			case O::DIVIDE:
+				if (isConstant(b, 1.0f)) {
+					simplified = a;
+				}
+				else if (values[b].op == O::COUNT && hasExactReciprocal(values[b].constant)) {
+					++stats.simplifiedOperations;
+					return emit(O::MULTIPLY, a, constant(1.0f / values[b].constant));
+				}
+				break;
+			case O::MINIMUM:
+			case O::MAXIMUM:
+				simplified = a == b ? a : NO_VALUE;
+				break;
+			case O::MIX:
+				simplified = isConstant(c, 0.0f) || a == b ? a : isConstant(c, 1.0f) ? b : NO_VALUE;
+				break;
+			default:
+				break;
+			}
+			if (simplified != NO_VALUE) {
+				++stats.simplifiedOperations;
+				return simplified;
+			}
+			if ((op == O::ADD || op == O::MULTIPLY) && a > b) {
+				std::swap(a, b);
+			}
+		}
+
+		const S_ValueKey key{ op, { a, b, c } };
+		const auto [it, inserted] = valueIndices.try_emplace(key, static_cast<uint32_t>(values.size()));
+		if (!inserted) {
+			++stats.mergedOperations;
+			return it->second;
+		}
+		values.push_back({ op, { a, b, c }, 0.0f });
+		return it->second;
+	}
+
+	// Values are already in dependency order, so instructions follow it. Each material channel is
+	// stored right after its value is computed, which lets the value's register go early.
+	void S_MaterialCompiler::allocateRegisters(const std::array<uint32_t, MATERIAL_CHANNEL_COUNT>& channelValues, S_MaterialProgram& program) {
+		const uint32_t valueCount = static_cast<uint32_t>(values.size());
+		marks.assign(valueCount, MARK_NONE);
+		for (const uint32_t value : channelValues) {
+			marks[value] = MARK_DONE;
+		}
+		for (uint32_t value = valueCount; value-- > 0;) {
+			if (marks[value] == MARK_DONE) {
+				for (uint32_t i = 0; i < getOperandCount(values[value].op); ++i) {
+					marks[values[value].operands[i]] = MARK_DONE;
+				}
+			}
+		}
+
+		std::vector<uint32_t> registers(valueCount, NO_VALUE);
+		std::vector<uint32_t> lastUse(valueCount, 0);
+		for (uint32_t value = 0; value < valueCount; ++value) {
+			if (marks[value] != MARK_DONE) {
+				continue;
+			}
+			lastUse[value] = value;
+			if (values[value].op == E_MaterialOp::COUNT) {
+				registers[value] = static_cast<uint32_t>(program.constants.size());
+				program.constants.push_back(values[value].constant);
+			}
+			for (uint32_t i = 0; i < getOperandCount(values[value].op); ++i) {
+				lastUse[values[value].operands[i]] = value;
+			}
+		}
+		const uint32_t constantCount = static_cast<uint32_t>(program.constants.size());
+
+		auto store = [&](uint32_t value) {
+			for (uint32_t channel = 0; channel < MATERIAL_CHANNEL_COUNT; ++channel) {
+				if (channelValues[channel] == value) {
+					S_MaterialInstruction instruction;
+					instruction.op = E_MaterialOp::STORE_OUTPUT;
+					instruction.destination = static_cast<uint16_t>(channel);
+					instruction.operands[0] = static_cast<uint16_t>(registers[value]);
+					program.instructions.push_back(instruction);
+				}
+			}
+		};
+		for (uint32_t value = 0; value < valueCount; ++value) {
+			if (marks[value] == MARK_DONE && values[value].op == E_MaterialOp::COUNT) {
+				store(value);
+			}
+		}
+
+		// Lowest free register first keeps the register file compact
+		std::vector<uint32_t> freeRegisters;
+		uint32_t registerCount = constantCount;
+		auto release = [&](uint32_t reg) {
+			freeRegisters.push_back(reg);
+			std::push_heap(freeRegisters.begin(), freeRegisters.end(), std::greater<>());
+		};
+		for (uint32_t value = 0; value < valueCount; ++value) {
+			const S_Value& node = values[value];
+			if (marks[value] != MARK_DONE || node.op == E_MaterialOp::COUNT) {
+				continue;
+			}
+			const uint32_t operandCount = getOperandCount(node.op);
+			for (uint32_t i = 0; i < operandCount; ++i) {
+				const uint32_t operand = node.operands[i];
+				const bool repeated = (i > 0 && node.operands[0] == operand) || (i > 1 && node.operands[1] == operand);
+				if (!repeated && lastUse[operand] == value && values[operand].op != E_MaterialOp::COUNT) {
+					release(registers[operand]);
+				}
+			}
+
+			uint32_t destination = registerCount;
+			if (freeRegisters.empty()) {
+				++registerCount;
+			}
+			else {
+				std::pop_heap(freeRegisters.begin(), freeRegisters.end(), std::greater<>());
+				destination = freeRegisters.back();
+				freeRegisters.pop_back();
+			}
+			registers[value] = destination;
+
+			S_MaterialInstruction instruction;
+			instruction.op = node.op;
+			instruction.destination = static_cast<uint16_t>(destination);
+			if (node.op == E_MaterialOp::LOAD_INPUT) {
+				instruction.operands[0] = static_cast<uint16_t>(node.operands[0]);
+				program.inputMask |= 1u << node.operands[0];
+			}
+			for (uint32_t i = 0; i < operandCount; ++i) {
+				instruction.operands[i] = static_cast<uint16_t>(registers[node.operands[i]]);
+			}
+			program.instructions.push_back(instruction);
+			store(value);
+			if (lastUse[value] == value) {
+				release(destination);
+			}
+		}
+
+		if (registerCount > S_MaterialProgram::MAX_REGISTERS) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_MaterialCompiler", "compile",
+				"Material needs more registers than the interpreter has", registerCount, S_MaterialProgram::MAX_REGISTERS);
+		}
+		program.registerCount = registerCount;
+	}
+}
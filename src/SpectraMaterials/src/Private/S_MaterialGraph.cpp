@@ -0,0 +1,163 @@
+#include "S_MaterialGraph.h"
+#include "S_ContentHasher.h"
+#include "SpectraInstrumentation.h"
+
+#include <bit>
+#include <iterator>
+#include <utility>
+
+namespace spectra::materials {
+	namespace {
+		struct S_NodeTypeInfo {
+			const char* name;
+			uint32_t inputs;
+		};
+
+		constexpr S_NodeTypeInfo NODE_TYPES[] = {
+			{ "Constant", 0 }, { "Input", 0 },
+			{ "Add", 2 }, { "Subtract", 2 }, { "Multiply", 2 }, { "Divide", 2 }, { "Minimum", 2 }, { "Maximum", 2 },
+			{ "Absolute", 1 }, { "SquareRoot", 1 }, { "Floor", 1 }, { "Fraction", 1 }, { "Saturate", 1 },
+			{ "Mix", 3 }, { "Step", 2 }, { "Dot", 2 }, { "Length", 1 }, { "Normalize", 1 },
+			{ "Combine", 3 }, { "Split", 1 }, { "Checker", 3 }, { "Fresnel", 2 }
+		};
+		static_assert(std::size(NODE_TYPES) == static_cast<size_t>(E_MaterialNodeType::COUNT));
+	}
+
+	// S_MaterialGraph implementations
+	S_MaterialGraph::S_MaterialGraph() {
+		outputs.fill(INVALID_NODE);
+	}
+
+	S_MaterialSocket S_MaterialGraph::addRaw(const S_MaterialNode& node) {
+		nodes.push_back(node);
+		return { static_cast<uint32_t>(nodes.size() - 1) };
+	}
+
+	S_MaterialSocket S_MaterialGraph::constant(float value) {
+		S_MaterialNode node;
+		node.value = { value, value, value };
+		return addRaw(node);
+	}
+
+	S_MaterialSocket S_MaterialGraph::constant(const core::math::S_Vec3& value) {
+		S_MaterialNode node;
+		node.valueType = E_MaterialValueType::VECTOR3;
+		node.value = { value.x, value.y, value.z };
+		return addRaw(node);
+	}
+
+	S_MaterialSocket S_MaterialGraph::input(E_MaterialInput input) {
+		S_MaterialNode node;
+		node.type = E_MaterialNodeType::INPUT;
+		node.parameter = static_cast<uint32_t>(input);
+		return addRaw(node);
+	}
+
+	S_MaterialSocket S_MaterialGraph::addNode(E_MaterialNodeType type, std::initializer_list<S_MaterialSocket> inputs, uint32_t parameter) {
+		using namespace spectra::instrumentation;
+
+		if (type == E_MaterialNodeType::CONSTANT || type == E_MaterialNodeType::INPUT || type >= E_MaterialNodeType::COUNT) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialGraph", "addNode", "Use constant() or input() for this node type",
+				static_cast<uint32_t>(type));
+		}
+		if (inputs.size() > getInputCount(type)) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_MaterialGraph", "addNode", "Too many inputs", getNodeTypeName(type), inputs.size());
+		}
+
+		S_MaterialNode node;
+		node.type = type;
+		node.parameter = parameter;
+		uint32_t slot = 0;
+		for (const S_MaterialSocket socket : inputs) {
+			node.inputs[slot++] = socket.node;
+		}
+		return addRaw(node);
+	}
+
+	void S_MaterialGraph::connect(S_MaterialSocket node, uint32_t slot, S_MaterialSocket source) {
+		if (node.node >= nodes.size() || slot >= getInputCount(nodes[node.node].type)) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_MaterialGraph", "connect",
+				"No such node input", node.node, slot);
+		}
+		nodes[node.node].inputs[slot] = source.node;
+	}
+
+	void S_MaterialGraph::setOutput(E_MaterialOutput output, S_MaterialSocket source) {
+		outputs[static_cast<size_t>(output)] = source.node;
+	}
+
+	void S_MaterialGraph::clear() {
+		nodes.clear();
+		outputs.fill(INVALID_NODE);
+	}
+
+	const std::vector<S_MaterialNode>& S_MaterialGraph::getNodes() const {
+		return nodes;
+	}
+
+	S_MaterialSocket S_MaterialGraph::getOutput(E_MaterialOutput output) const {
+		return { outputs[static_cast<size_t>(output)] };
+	}
+
+	S_MaterialKey S_MaterialGraph::computeContentKey() const {
+		constexpr uint32_t VISITING = INVALID_NODE - 1;
+
+		S_ContentHasher hasher;
+		std::vector<uint32_t> canonical(nodes.size(), INVALID_NODE);
+		std::vector<std::pair<uint32_t, uint32_t>> stack;  // Node and the next input to visit
+		uint32_t nextIndex = 0;
+		auto canonicalIndex = [&](uint32_t node) { return node < nodes.size() ? canonical[node] : INVALID_NODE; };
+
+		for (const uint32_t root : outputs) {
+			if (root >= nodes.size() || canonical[root] != INVALID_NODE) {
+				continue;
+			}
+			canonical[root] = VISITING;
+			stack.push_back({ root, 0 });
+			while (!stack.empty()) {
+				const uint32_t node = stack.back().first;
+				const uint32_t slot = stack.back().second;
+				const S_MaterialNode& current = nodes[node];
+				if (slot < getInputCount(current.type)) {
+					++stack.back().second;
+					const uint32_t input = current.inputs[slot];
+					if (input < nodes.size() && canonical[input] == INVALID_NODE) {
+						canonical[input] = VISITING;
+						stack.push_back({ input, 0 });
+					}
+					continue;
+				}
+				stack.pop_back();
+
+				// Inputs are numbered by now, except on a cycle, which hashes as VISITING
+				hasher.add(static_cast<uint64_t>(current.type));
+				if (current.type == E_MaterialNodeType::CONSTANT) {
+					const uint32_t components = current.valueType == E_MaterialValueType::VECTOR3 ? 3 : 1;
+					hasher.add(static_cast<uint64_t>(current.valueType));
+					for (uint32_t i = 0; i < components; ++i) {
+						hasher.add(std::bit_cast<uint32_t>(current.value[i]));
+					}
+				}
+				if (current.type == E_MaterialNodeType::INPUT || current.type == E_MaterialNodeType::SPLIT) {
+					hasher.add(current.parameter);
+				}
+				for (uint32_t i = 0; i < getInputCount(current.type); ++i) {
+					hasher.add(canonicalIndex(current.inputs[i]));
+				}
+				canonical[node] = nextIndex++;
+			}
+		}
+		for (const uint32_t root : outputs) {
+			hasher.add(canonicalIndex(root));
+		}
+		return hasher.finish();
+	}
+
+	uint32_t S_MaterialGraph::getInputCount(E_MaterialNodeType type) {
+		return type < E_MaterialNodeType::COUNT ? NODE_TYPES[static_cast<size_t>(type)].inputs : 0;
+	}
+
+	const char* S_MaterialGraph::getNodeTypeName(E_MaterialNodeType type) {
+		return type < E_MaterialNodeType::COUNT ? NODE_TYPES[static_cast<size_t>(type)].name : "Unknown";
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+#include "S_MaterialProgram.h"
+
+// Interface between S_MaterialProgram and the interpreter kernels. As with the ray kernels,
+// each instruction set lives in its own translation unit compiled for that set, so only
+// plain pointers cross this boundary.
+namespace spectra::materials::kernels {
+	struct S_KernelProgram {
+		const S_MaterialInstruction* instructions = nullptr;
+		uint32_t instructionCount = 0;
+		const float* constants = nullptr;
+		uint32_t constantCount = 0;
+	};
+
+	struct S_KernelIo {
+		const float* const* inputs = nullptr;  // SHADING_CHANNEL_COUNT channels
+		float* const* outputs = nullptr;       // MATERIAL_CHANNEL_COUNT channels, null ones skipped
+	};
+
+	// Evaluates shading points [begin, end)
+	using EvaluateKernel = void (*)(const S_KernelProgram& program, const S_KernelIo& io, uint32_t begin, uint32_t end);
+
+	void evaluateScalar(const S_KernelProgram& program, const S_KernelIo& io, uint32_t begin, uint32_t end);
+
+#if defined(SPECTRA_X86_KERNELS)
+	void evaluateAvx2(const S_KernelProgram& program, const S_KernelIo& io, uint32_t begin, uint32_t end);
+#endif
+}
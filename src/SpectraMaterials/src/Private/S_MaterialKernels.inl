@@ -0,0 +1,93 @@
+// Interpreter shared by the kernels, included after the policy P is defined. P supplies a
+// Float of LANES floats and the operations on it; nothing from the standard library is used
+// here, so no inline code compiled for one instruction set can leak into another.
+namespace spectra::materials::kernels {
+	namespace {
+		template<typename P>
+		void interpret(const S_KernelProgram& program, const S_KernelIo& io, uint32_t begin, uint32_t end) {
+			constexpr uint32_t LANES = S_MaterialProgram::LANES;
+			using Float = typename P::Float;
+
+			Float registers[S_MaterialProgram::MAX_REGISTERS];
+			for (uint32_t i = 0; i < program.constantCount; ++i) {
+				registers[i] = P::set1(program.constants[i]);
+			}
+
+			alignas(64) float partial[LANES];
+			const S_MaterialInstruction* const last = program.instructions + program.instructionCount;
+			for (uint32_t first = begin; first < end; first += LANES) {
+				const uint32_t count = end - first < LANES ? end - first : LANES;
+				for (const S_MaterialInstruction* instruction = program.instructions; instruction != last; ++instruction) {
+					const uint16_t* operands = instruction->operands.data();
+					Float& destination = registers[instruction->destination];
+					switch (instruction->op) {
+					case E_MaterialOp::LOAD_INPUT: {
+						const float* source = io.inputs[operands[0]] + first;
+						if (count == LANES) {
+							destination = P::load(source);
+						}
+						else {
+							for (uint32_t lane = 0; lane < LANES; ++lane) {
+								partial[lane] = lane < count ? source[lane] : 0.0f;
+							}
+							destination = P::load(partial);
+						}
+						break;
+					}
+					case E_MaterialOp::STORE_OUTPUT: {
+						float* target = io.outputs[instruction->destination];
+						if (!target) {
+							break;
+						}
+						if (count == LANES) {
+							P::store(target + first, registers[operands[0]]);
+						}
+						else {
+							P::store(partial, registers[operands[0]]);
+							for (uint32_t lane = 0; lane < count; ++lane) {
+								target[first + lane] = partial[lane];
+							}
+						}
+						break;
+					}
+					case E_MaterialOp::ADD:
+						destination = P::add(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::SUBTRACT:
+						destination = P::sub(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::MULTIPLY:
+						destination = P::mul(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::DIVIDE:
+						destination = P::div(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::MINIMUM:
+						destination = P::min(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::MAXIMUM:
+						destination = P::max(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::ABSOLUTE:
+						destination = P::abs(registers[operands[0]]);
+						break;
+					case E_MaterialOp::SQUARE_ROOT:
+						destination = P::sqrt(registers[operands[0]]);
+						break;
+					case E_MaterialOp::FLOOR:
+						destination = P::floor(registers[operands[0]]);
+						break;
+					case E_MaterialOp::STEP:
+						destination = P::step(registers[operands[0]], registers[operands[1]]);
+						break;
+					case E_MaterialOp::MIX:
+						destination = P::mix(registers[operands[0]], registers[operands[1]], registers[operands[2]]);
+						break;
+					default:
+						break;
+					}
+				}
+			}
+		}
+	}
+}
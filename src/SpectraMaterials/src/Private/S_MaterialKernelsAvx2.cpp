@@ -0,0 +1,36 @@
+#include "S_MaterialKernels.h"
+
+#include <immintrin.h>
+
+// Compiled with AVX2 enabled, only called after S_CpuFeatures reports AVX2 and FMA
+namespace spectra::materials::kernels {
+	namespace {
+		struct S_Avx2 {
+			using Float = __m256;
+
+			static Float set1(float value) { return _mm256_set1_ps(value); }
+			static Float load(const float* source) { return _mm256_loadu_ps(source); }
+			static void store(float* destination, Float value) { _mm256_storeu_ps(destination, value); }
+
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+			static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+			static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+			static Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+			static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+			static Float floor(Float a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+			static Float step(Float edge, Float x) { return _mm256_and_ps(_mm256_cmp_ps(x, edge, _CMP_GE_OQ), _mm256_set1_ps(1.0f)); }
+			static Float mix(Float a, Float b, Float t) { return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t)); }
+		};
+	}
+}
+
+#include "S_MaterialKernels.inl"
+
+namespace spectra::materials::kernels {
+	void evaluateAvx2(const S_KernelProgram& program, const S_KernelIo& io, uint32_t begin, uint32_t end) {
+		interpret<S_Avx2>(program, io, begin, end);
+	}
+}
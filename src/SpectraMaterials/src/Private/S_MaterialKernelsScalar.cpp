@@ -0,0 +1,52 @@
+#include "S_MaterialKernels.h"
+#include "S_MaterialOps.h"
+
+// Portable kernel, eight lanes as an array the compiler may vectorize for the baseline set
+namespace spectra::materials::kernels {
+	namespace {
+		struct S_Scalar {
+			struct Float {
+				float lanes[S_MaterialProgram::LANES];
+			};
+
+			template<typename F>
+			static Float each(F function) {
+				Float result;
+				for (uint32_t lane = 0; lane < S_MaterialProgram::LANES; ++lane) {
+					result.lanes[lane] = function(lane);
+				}
+				return result;
+			}
+
+			static Float set1(float value) { return each([&](uint32_t) { return value; }); }
+			static Float load(const float* source) { return each([&](uint32_t i) { return source[i]; }); }
+			static void store(float* destination, const Float& value) {
+				for (uint32_t lane = 0; lane < S_MaterialProgram::LANES; ++lane) {
+					destination[lane] = value.lanes[lane];
+				}
+			}
+
+			static Float add(const Float& a, const Float& b) { return each([&](uint32_t i) { return a.lanes[i] + b.lanes[i]; }); }
+			static Float sub(const Float& a, const Float& b) { return each([&](uint32_t i) { return a.lanes[i] - b.lanes[i]; }); }
+			static Float mul(const Float& a, const Float& b) { return each([&](uint32_t i) { return a.lanes[i] * b.lanes[i]; }); }
+			static Float div(const Float& a, const Float& b) { return each([&](uint32_t i) { return a.lanes[i] / b.lanes[i]; }); }
+			static Float min(const Float& a, const Float& b) { return each([&](uint32_t i) { return ops::minimum(a.lanes[i], b.lanes[i]); }); }
+			static Float max(const Float& a, const Float& b) { return each([&](uint32_t i) { return ops::maximum(a.lanes[i], b.lanes[i]); }); }
+			static Float abs(const Float& a) { return each([&](uint32_t i) { return std::fabs(a.lanes[i]); }); }
+			static Float sqrt(const Float& a) { return each([&](uint32_t i) { return std::sqrt(a.lanes[i]); }); }
+			static Float floor(const Float& a) { return each([&](uint32_t i) { return std::floor(a.lanes[i]); }); }
+			static Float step(const Float& edge, const Float& x) { return each([&](uint32_t i) { return ops::step(edge.lanes[i], x.lanes[i]); }); }
+			static Float mix(const Float& a, const Float& b, const Float& t) {
+				return each([&](uint32_t i) { return ops::mix(a.lanes[i], b.lanes[i], t.lanes[i]); });
+			}
+		};
+	}
+}
+
+#include "S_MaterialKernels.inl"
+
+namespace spectra::materials::kernels {
+	void evaluateScalar(const S_KernelProgram& program, const S_KernelIo& io, uint32_t begin, uint32_t end) {
+		interpret<S_Scalar>(program, io, begin, end);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cmath>
+
+#include "S_MaterialProgram.h"
+
+// Scalar semantics of every E_MaterialOp, shared by constant folding and the scalar kernel.
+// The vector kernels match them bit for bit, including NaN handling of MINIMUM and MAXIMUM.
+namespace spectra::materials::ops {
+	inline float minimum(float a, float b) { return a < b ? a : b; }
+	inline float maximum(float a, float b) { return a > b ? a : b; }
+	inline float step(float edge, float x) { return x >= edge ? 1.0f : 0.0f; }
+	inline float mix(float a, float b, float t) { return a + (b - a) * t; }
+
+	inline float apply(E_MaterialOp op, float a, float b, float c) {
+		switch (op) {
+		case E_MaterialOp::ADD:
+			return a + b;
+		case E_MaterialOp::SUBTRACT:
+			return a - b;
+		case E_MaterialOp::MULTIPLY:
+			return a * b;
+		case E_MaterialOp::DIVIDE:
+			return a / b;
+		case E_MaterialOp::MINIMUM:
+			return minimum(a, b);
+		case E_MaterialOp::MAXIMUM:
+			return maximum(a, b);
+		case E_MaterialOp::ABSOLUTE:
+			return std::fabs(a);
+		case E_MaterialOp::SQUARE_ROOT:
+			return std::sqrt(a);
+		case E_MaterialOp::FLOOR:
+			return std::floor(a);
+		case E_MaterialOp::STEP:
+			return step(a, b);
+		case E_MaterialOp::MIX:
+			return mix(a, b, c);
+		default:
+			return 0.0f;
+		}
+	}
+}
@@ -0,0 +1,192 @@
+#include "S_MaterialProgram.h"
+#include "S_CpuFeatures.h"
+#include "S_MaterialKernels.h"
+#include "SpectraInstrumentation.h"
+
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+namespace spectra::materials {
+	namespace {
+		constexpr const char* OP_NAMES[] = {
+			"load", "store", "add", "sub", "mul", "div", "min", "max", "abs", "sqrt", "floor", "step", "mix"
+		};
+		static_assert(std::size(OP_NAMES) == static_cast<size_t>(E_MaterialOp::COUNT));
+
+		constexpr const char* SHADING_CHANNEL_NAMES[] = {
+			"u", "v", "position.x", "position.y", "position.z", "normal.x", "normal.y", "normal.z", "cosTheta"
+		};
+		static_assert(std::size(SHADING_CHANNEL_NAMES) == SHADING_CHANNEL_COUNT);
+
+		constexpr const char* MATERIAL_CHANNEL_NAMES[] = {
+			"baseColor.r", "baseColor.g", "baseColor.b", "roughness", "metallic", "emission.r", "emission.g", "emission.b", "opacity"
+		};
+		static_assert(std::size(MATERIAL_CHANNEL_NAMES) == MATERIAL_CHANNEL_COUNT);
+
+		struct S_SerializedHeader {
+			uint32_t format;
+			uint32_t instructionCount;
+			uint32_t constantCount;
+			uint32_t registerCount;
+			uint32_t inputMask;
+			uint32_t reserved;
+			S_MaterialCompileStats stats;
+		};
+
+		uint32_t getOperandCount(E_MaterialOp op) {
+			switch (op) {
+			case E_MaterialOp::ABSOLUTE:
+			case E_MaterialOp::SQUARE_ROOT:
+			case E_MaterialOp::FLOOR:
+				return 1;
+			case E_MaterialOp::MIX:
+				return 3;
+			default:
+				return 2;
+			}
+		}
+	}
+
+	// S_MaterialProgram implementations
+	void S_MaterialProgram::evaluate(const S_ShadingPoints& points, const S_MaterialResults& results, E_MaterialKernel kernel) const {
+		if (instructions.empty() || points.count == 0) {
+			return;
+		}
+		for (uint32_t channel = 0; channel < SHADING_CHANNEL_COUNT; ++channel) {
+			if ((inputMask & (1u << channel)) && !points.channels[channel]) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_MaterialProgram", "evaluate",
+					"Material reads a shading channel that was not supplied", SHADING_CHANNEL_NAMES[channel]);
+			}
+		}
+
+		kernels::EvaluateKernel function = kernels::evaluateScalar;
+#if defined(SPECTRA_X86_KERNELS)
+		if (kernel != E_MaterialKernel::SCALAR && getBestKernel() == E_MaterialKernel::AVX2) {
+			function = kernels::evaluateAvx2;
+		}
+#endif
+		const kernels::S_KernelProgram program{ instructions.data(), static_cast<uint32_t>(instructions.size()),
+			constants.data(), static_cast<uint32_t>(constants.size()) };
+		const kernels::S_KernelIo io{ points.channels.data(), results.channels.data() };
+		function(program, io, 0, points.count);
+	}
+
+	const std::vector<S_MaterialInstruction>& S_MaterialProgram::getInstructions() const {
+		return instructions;
+	}
+
+	const std::vector<float>& S_MaterialProgram::getConstants() const {
+		return constants;
+	}
+
+	uint32_t S_MaterialProgram::getRegisterCount() const {
+		return registerCount;
+	}
+
+	uint32_t S_MaterialProgram::getInputMask() const {
+		return inputMask;
+	}
+
+	const S_MaterialCompileStats& S_MaterialProgram::getStats() const {
+		return stats;
+	}
+
+	std::string S_MaterialProgram::disassemble() const {
+		std::ostringstream text;
+		for (size_t i = 0; i < constants.size(); ++i) {
+			text << "r" << i << " = " << constants[i] << "\n";
+		}
+		for (const S_MaterialInstruction& instruction : instructions) {
+			switch (instruction.op) {
+			case E_MaterialOp::LOAD_INPUT:
+				text << "r" << instruction.destination << " = load " << SHADING_CHANNEL_NAMES[instruction.operands[0]] << "\n";
+				break;
+			case E_MaterialOp::STORE_OUTPUT:
+				text << "store " << MATERIAL_CHANNEL_NAMES[instruction.destination] << ", r" << instruction.operands[0] << "\n";
+				break;
+			default: {
+				text << "r" << instruction.destination << " = " << OP_NAMES[static_cast<size_t>(instruction.op)];
+				const uint32_t operandCount = getOperandCount(instruction.op);
+				for (uint32_t i = 0; i < operandCount; ++i) {
+					text << (i ? ", r" : " r") << instruction.operands[i];
+				}
+				text << "\n";
+			}
+			}
+		}
+		return text.str();
+	}
+
+	std::vector<std::byte> S_MaterialProgram::serialize() const {
+		const S_SerializedHeader header{ FORMAT_VERSION, static_cast<uint32_t>(instructions.size()), static_cast<uint32_t>(constants.size()),
+			registerCount, inputMask, 0, stats };
+		const size_t instructionBytes = instructions.size() * sizeof(S_MaterialInstruction);
+		std::vector<std::byte> blob(sizeof(header) + instructionBytes + constants.size() * sizeof(float));
+		std::memcpy(blob.data(), &header, sizeof(header));
+		std::memcpy(blob.data() + sizeof(header), instructions.data(), instructionBytes);
+		std::memcpy(blob.data() + sizeof(header) + instructionBytes, constants.data(), constants.size() * sizeof(float));
+		return blob;
+	}
+
+	bool S_MaterialProgram::deserialize(std::span<const std::byte> blob, S_MaterialProgram& program) {
+		S_SerializedHeader header;
+		if (blob.size() < sizeof(header)) {
+			return false;
+		}
+		std::memcpy(&header, blob.data(), sizeof(header));
+		const size_t instructionBytes = size_t(header.instructionCount) * sizeof(S_MaterialInstruction);
+		if (header.format != FORMAT_VERSION || header.registerCount > MAX_REGISTERS || header.constantCount > header.registerCount
+			|| blob.size() != sizeof(header) + instructionBytes + size_t(header.constantCount) * sizeof(float)) {
+			return false;
+		}
+
+		std::vector<S_MaterialInstruction> instructions(header.instructionCount);
+		std::memcpy(instructions.data(), blob.data() + sizeof(header), instructionBytes);
+		for (const S_MaterialInstruction& instruction : instructions) {
+			if (instruction.op >= E_MaterialOp::COUNT) {
+				return false;
+			}
+			const bool load = instruction.op == E_MaterialOp::LOAD_INPUT;
+			const bool store = instruction.op == E_MaterialOp::STORE_OUTPUT;
+			const uint32_t operandCount = load || store ? 1 : getOperandCount(instruction.op);
+			if (instruction.destination >= (store ? MATERIAL_CHANNEL_COUNT : header.registerCount)) {
+				return false;
+			}
+			for (uint32_t i = 0; i < operandCount; ++i) {
+				if (instruction.operands[i] >= (load ? SHADING_CHANNEL_COUNT : header.registerCount)) {
+					return false;
+				}
+			}
+		}
+
+		program.instructions = std::move(instructions);
+		program.constants.resize(header.constantCount);
+		std::memcpy(program.constants.data(), blob.data() + sizeof(header) + instructionBytes, header.constantCount * sizeof(float));
+		program.registerCount = header.registerCount;
+		program.inputMask = header.inputMask;
+		program.stats = header.stats;
+		return true;
+	}
+
+	E_MaterialKernel S_MaterialProgram::getBestKernel() {
+#if defined(SPECTRA_X86_KERNELS)
+		if (core::platform::S_CpuFeatures::get().hasAvx2Fma()) {
+			return E_MaterialKernel::AVX2;
+		}
+#endif
+		return E_MaterialKernel::SCALAR;
+	}
+
+	const char* S_MaterialProgram::getKernelName(E_MaterialKernel kernel) {
+		switch (kernel) {
+		case E_MaterialKernel::SCALAR:
+			return "scalar";
+		case E_MaterialKernel::AVX2:
+			return "AVX2";
+		default:
+			return "best";
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+// Separable filter passes and 8-bit conversions of S_TextureProcessor, one translation unit
+// per instruction set as with the interpreter kernels. Sums run in tap order without
+// contraction and conversions are exact, so every kernel returns the same bits.
+namespace spectra::materials::kernels {
+	// output[i] = sum over k of weights[k] * rows[k][i], for i < floatCount
+	using FilterRowsKernel = void (*)(const float* const* rows, const float* weights, uint32_t tapCount, uint32_t floatCount, float* output);
+
+	// RGBA pixel x of output = sum over k of weights[x * tapCount + k] * pixel indices[x * tapCount + k] of row
+	using FilterPixelsKernel = void (*)(const float* row, const uint32_t* indices, const float* weights, uint32_t tapCount,
+		uint32_t pixelCount, float* output);
+
+	// Lookup tables of the 8-bit conversions, built once by S_TextureProcessor. Encoding to sRGB
+	// reads the code at the start of the value's step, then compares against the one threshold
+	// a step can hold; a step is narrower than the smallest gap between thresholds, near black.
+	struct S_ColorTables {
+		static constexpr uint32_t ENCODE_STEPS = 4096;
+
+		float decode[512];                 // sRGB to linear, then code / 255
+		int32_t encodeBase[ENCODE_STEPS];  // sRGB code of linear value step / ENCODE_STEPS
+		float thresholds[256];             // Linear value halfway between neighbouring sRGB codes, then one above 1
+	};
+
+	// count bytes to floats, a multiple of four. The first three channels of each pixel go through
+	// the sRGB curve when srgb is set.
+	using DecodeKernel = void (*)(const uint8_t* source, uint32_t count, bool srgb, const S_ColorTables& tables, float* output);
+
+	// Clamps count floats to [0, 1] in place and rounds them to bytes like decode's inverse,
+	// rounding halves up. count is a multiple of four.
+	using EncodeKernel = void (*)(float* values, uint32_t count, bool srgb, const S_ColorTables& tables, uint8_t* output);
+
+	void filterRowsScalar(const float* const* rows, const float* weights, uint32_t tapCount, uint32_t floatCount, float* output);
+	void filterPixelsScalar(const float* row, const uint32_t* indices, const float* weights, uint32_t tapCount, uint32_t pixelCount, float* output);
+	void decodeScalar(const uint8_t* source, uint32_t count, bool srgb, const S_ColorTables& tables, float* output);
+	void encodeScalar(float* values, uint32_t count, bool srgb, const S_ColorTables& tables, uint8_t* output);
+
+#if defined(SPECTRA_X86_KERNELS)
+	void filterRowsAvx2(const float* const* rows, const float* weights, uint32_t tapCount, uint32_t floatCount, float* output);
+	void filterPixelsAvx2(const float* row, const uint32_t* indices, const float* weights, uint32_t tapCount, uint32_t pixelCount, float* output);
+	void decodeAvx2(const uint8_t* source, uint32_t count, bool srgb, const S_ColorTables& tables, float* output);
+	void encodeAvx2(float* values, uint32_t count, bool srgb, const S_ColorTables& tables, uint8_t* output);
+#endif
+}
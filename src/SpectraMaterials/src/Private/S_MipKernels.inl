@@ -0,0 +1,39 @@
+// Filter passes shared by the kernels, included after the policy P is defined. P supplies a
+// Wide of WIDTH floats and a Pixel of four, with the operations on them; as in
+// S_MaterialKernels.inl nothing from the standard library is used here.
+namespace spectra::materials::kernels {
+	namespace {
+		template<typename P>
+		void filterRows(const float* const* rows, const float* weights, uint32_t tapCount, uint32_t floatCount, float* output) {
+			uint32_t i = 0;
+			for (; i + P::WIDTH <= floatCount; i += P::WIDTH) {
+				typename P::Wide sum = P::mul(P::set1(weights[0]), P::load(rows[0] + i));
+				for (uint32_t k = 1; k < tapCount; ++k) {
+					sum = P::add(sum, P::mul(P::set1(weights[k]), P::load(rows[k] + i)));
+				}
+				P::store(output + i, sum);
+			}
+			for (; i < floatCount; ++i) {
+				float sum = weights[0] * rows[0][i];
+				for (uint32_t k = 1; k < tapCount; ++k) {
+					sum = sum + weights[k] * rows[k][i];
+				}
+				output[i] = sum;
+			}
+		}
+
+		template<typename P>
+		void filterPixels(const float* row, const uint32_t* indices, const float* weights, uint32_t tapCount, uint32_t pixelCount,
+			float* output) {
+			for (uint32_t x = 0; x < pixelCount; ++x) {
+				const uint32_t* pixelIndices = indices + x * tapCount;
+				const float* pixelWeights = weights + x * tapCount;
+				typename P::Pixel sum = P::mul4(P::set4(pixelWeights[0]), P::load4(row + 4 * pixelIndices[0]));
+				for (uint32_t k = 1; k < tapCount; ++k) {
+					sum = P::add4(sum, P::mul4(P::set4(pixelWeights[k]), P::load4(row + 4 * pixelIndices[k])));
+				}
+				P::store4(output + 4 * x, sum);
+			}
+		}
+	}
+}
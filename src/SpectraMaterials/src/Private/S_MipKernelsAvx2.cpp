@@ -0,0 +1,78 @@
+#include "S_MipKernels.h"
+
+#include <immintrin.h>
+
+// Compiled with AVX2 enabled, only called after S_CpuFeatures reports AVX2 and FMA
+namespace spectra::materials::kernels {
+	namespace {
+		struct S_Avx2 {
+			static constexpr uint32_t WIDTH = 8;
+			using Wide = __m256;
+			using Pixel = __m128;
+
+			static Wide set1(float value) { return _mm256_set1_ps(value); }
+			static Wide load(const float* source) { return _mm256_loadu_ps(source); }
+			static void store(float* destination, Wide value) { _mm256_storeu_ps(destination, value); }
+			static Wide add(Wide a, Wide b) { return _mm256_add_ps(a, b); }
+			static Wide mul(Wide a, Wide b) { return _mm256_mul_ps(a, b); }
+
+			static Pixel set4(float value) { return _mm_set1_ps(value); }
+			static Pixel load4(const float* source) { return _mm_loadu_ps(source); }
+			static void store4(float* destination, Pixel value) { _mm_storeu_ps(destination, value); }
+			static Pixel add4(Pixel a, Pixel b) { return _mm_add_ps(a, b); }
+			static Pixel mul4(Pixel a, Pixel b) { return _mm_mul_ps(a, b); }
+		};
+	}
+}
+
+#include "S_MipKernels.inl"
+
+namespace spectra::materials::kernels {
+	void filterRowsAvx2(const float* const* rows, const float* weights, uint32_t tapCount, uint32_t floatCount, float* output) {
+		filterRows<S_Avx2>(rows, weights, tapCount, floatCount, output);
+	}
+
+	void filterPixelsAvx2(const float* row, const uint32_t* indices, const float* weights, uint32_t tapCount, uint32_t pixelCount, float* output) {
+		filterPixels<S_Avx2>(row, indices, weights, tapCount, pixelCount, output);
+	}
+}
+
+namespace spectra::materials::kernels {
+	void decodeAvx2(const uint8_t* source, uint32_t count, bool srgb, const S_ColorTables& tables, float* output) {
+		// Alpha, and every channel of linear formats, reads the second half of the table
+		const __m256i offsets = srgb ? _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256) : _mm256_set1_epi32(256);
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			const __m256i codes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i)));
+			_mm256_storeu_ps(output + i, _mm256_i32gather_ps(tables.decode, _mm256_add_epi32(codes, offsets), 4));
+		}
+		decodeScalar(source + i, count - i, srgb, tables, output + i);
+	}
+
+	void encodeAvx2(float* values, uint32_t count, bool srgb, const S_ColorTables& tables, uint8_t* output) {
+		const __m256i srgbLanes = srgb ? _mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0) : _mm256_setzero_si256();
+		const __m256 steps = _mm256_set1_ps(static_cast<float>(S_ColorTables::ENCODE_STEPS));
+		const __m256i lastStep = _mm256_set1_epi32(S_ColorTables::ENCODE_STEPS - 1);
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			const __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(values + i), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+			_mm256_storeu_ps(values + i, value);
+
+			// Comparison masks are -1 where a lane rounds up, so they are subtracted
+			const __m256i step = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(value, steps)), lastStep);
+			const __m256i base = _mm256_i32gather_epi32(tables.encodeBase, step, 4);
+			const __m256 threshold = _mm256_i32gather_ps(tables.thresholds, base, 4);
+			const __m256i srgbCodes = _mm256_sub_epi32(base, _mm256_castps_si256(_mm256_cmp_ps(value, threshold, _CMP_GE_OQ)));
+
+			const __m256 scaled = _mm256_mul_ps(value, _mm256_set1_ps(255.0f));
+			const __m256i whole = _mm256_cvttps_epi32(scaled);
+			const __m256 fraction = _mm256_sub_ps(scaled, _mm256_cvtepi32_ps(whole));
+			const __m256i unormCodes = _mm256_sub_epi32(whole, _mm256_castps_si256(_mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ)));
+
+			const __m256i codes = _mm256_blendv_epi8(unormCodes, srgbCodes, srgbLanes);
+			const __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(codes), _mm256_extracti128_si256(codes, 1));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(words, words));
+		}
+		encodeScalar(values + i, count - i, srgb, tables, output + i);
+	}
+}
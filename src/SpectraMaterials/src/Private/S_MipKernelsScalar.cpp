@@ -0,0 +1,105 @@
+#include "S_MipKernels.h"
+
+// Portable kernel, lanes as arrays the compiler may vectorize for the baseline set
+namespace spectra::materials::kernels {
+	namespace {
+		struct S_Scalar {
+			static constexpr uint32_t WIDTH = 8;
+
+			struct Wide {
+				float lanes[WIDTH];
+			};
+
+			struct Pixel {
+				float lanes[4];
+			};
+
+			static Wide set1(float value) {
+				Wide result;
+				for (float& lane : result.lanes) {
+					lane = value;
+				}
+				return result;
+			}
+			static Wide load(const float* source) {
+				Wide result;
+				for (uint32_t i = 0; i < WIDTH; ++i) {
+					result.lanes[i] = source[i];
+				}
+				return result;
+			}
+			static void store(float* destination, const Wide& value) {
+				for (uint32_t i = 0; i < WIDTH; ++i) {
+					destination[i] = value.lanes[i];
+				}
+			}
+			static Wide add(const Wide& a, const Wide& b) {
+				Wide result;
+				for (uint32_t i = 0; i < WIDTH; ++i) {
+					result.lanes[i] = a.lanes[i] + b.lanes[i];
+				}
+				return result;
+			}
+			static Wide mul(const Wide& a, const Wide& b) {
+				Wide result;
+				for (uint32_t i = 0; i < WIDTH; ++i) {
+					result.lanes[i] = a.lanes[i] * b.lanes[i];
+				}
+				return result;
+			}
+
+			static Pixel set4(float value) { return { { value, value, value, value } }; }
+			static Pixel load4(const float* source) { return { { source[0], source[1], source[2], source[3] } }; }
+			static void store4(float* destination, const Pixel& value) {
+				for (uint32_t i = 0; i < 4; ++i) {
+					destination[i] = value.lanes[i];
+				}
+			}
+			static Pixel add4(const Pixel& a, const Pixel& b) {
+				return { { a.lanes[0] + b.lanes[0], a.lanes[1] + b.lanes[1], a.lanes[2] + b.lanes[2], a.lanes[3] + b.lanes[3] } };
+			}
+			static Pixel mul4(const Pixel& a, const Pixel& b) {
+				return { { a.lanes[0] * b.lanes[0], a.lanes[1] * b.lanes[1], a.lanes[2] * b.lanes[2], a.lanes[3] * b.lanes[3] } };
+			}
+		};
+	}
+}
+
+#include "S_MipKernels.inl"
+
+namespace spectra::materials::kernels {
+	void filterRowsScalar(const float* const* rows, const float* weights, uint32_t tapCount, uint32_t floatCount, float* output) {
+		filterRows<S_Scalar>(rows, weights, tapCount, floatCount, output);
+	}
+
+	void filterPixelsScalar(const float* row, const uint32_t* indices, const float* weights, uint32_t tapCount, uint32_t pixelCount, float* output) {
+		filterPixels<S_Scalar>(row, indices, weights, tapCount, pixelCount, output);
+	}
+}
+
+namespace spectra::materials::kernels {
+	void decodeScalar(const uint8_t* source, uint32_t count, bool srgb, const S_ColorTables& tables, float* output) {
+		for (uint32_t i = 0; i < count; ++i) {
+			output[i] = tables.decode[source[i] + (srgb && i % 4 != 3 ? 0 : 256)];
+		}
+	}
+
+	// Comparisons in the order of the AVX2 min and max, so NaN clamps to 0 in both
+	void encodeScalar(float* values, uint32_t count, bool srgb, const S_ColorTables& tables, uint8_t* output) {
+		for (uint32_t i = 0; i < count; ++i) {
+			float value = values[i] > 0.0f ? values[i] : 0.0f;
+			value = value < 1.0f ? value : 1.0f;
+			values[i] = value;
+			if (srgb && i % 4 != 3) {
+				const uint32_t step = static_cast<uint32_t>(value * static_cast<float>(S_ColorTables::ENCODE_STEPS));
+				const int32_t base = tables.encodeBase[step < S_ColorTables::ENCODE_STEPS ? step : S_ColorTables::ENCODE_STEPS - 1];
+				output[i] = static_cast<uint8_t>(base + (value >= tables.thresholds[base] ? 1 : 0));
+			}
+			else {
+				const float scaled = value * 255.0f;
+				const int32_t whole = static_cast<int32_t>(scaled);
+				output[i] = static_cast<uint8_t>(whole + (scaled - static_cast<float>(whole) >= 0.5f ? 1 : 0));
+			}
+		}
+	}
+}
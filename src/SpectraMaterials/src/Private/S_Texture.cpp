@@ -0,0 +1,265 @@
+#include "S_Texture.h"
+#include "S_BlockCompression.h"
+#include "S_TemporaryPath.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace spectra::materials {
+	namespace {
+		constexpr uint32_t TEXTURE_MAGIC = 0x58455453;  // "STEX"
+		constexpr uint64_t LEVEL_ALIGNMENT = 64;
+
+		constexpr const char* FORMAT_NAMES[] = {
+			"RGBA8_UNORM", "RGBA8_SRGB", "BC1_UNORM", "BC1_SRGB", "BC4_UNORM", "BC5_UNORM", "BC7_UNORM", "BC7_SRGB"
+		};
+		static_assert(std::size(FORMAT_NAMES) == static_cast<size_t>(E_TextureFormat::COUNT));
+
+		uint64_t alignUp(uint64_t value, uint64_t alignment) {
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	struct S_TextureView::S_Header {
+		uint32_t magic;
+		uint32_t version;
+		E_TextureFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levelCount;
+		uint64_t size;
+	};
+
+	struct S_TextureView::S_LevelEntry {
+		uint64_t offset;
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowPitch;
+		uint32_t reserved;
+	};
+
+	// S_TextureView implementations
+	bool S_TextureView::parse(std::span<const std::byte> bytes, S_TextureView& view) {
+		view = S_TextureView{};
+		if (bytes.size() < sizeof(S_Header) || reinterpret_cast<uintptr_t>(bytes.data()) % alignof(S_Header) != 0) {
+			return false;
+		}
+		const auto* header = reinterpret_cast<const S_Header*>(bytes.data());
+		if (header->magic != TEXTURE_MAGIC || header->version != FORMAT_VERSION || header->format >= E_TextureFormat::COUNT
+			|| header->size != bytes.size() || header->levelCount == 0 || header->levelCount > 32
+			|| sizeof(S_Header) + header->levelCount * sizeof(S_LevelEntry) > bytes.size()) {
+			return false;
+		}
+		const auto* levels = reinterpret_cast<const S_LevelEntry*>(bytes.data() + sizeof(S_Header));
+		for (uint32_t level = 0; level < header->levelCount; ++level) {
+			const S_LevelEntry& entry = levels[level];
+			if (entry.offset > bytes.size() || entry.size > bytes.size() - entry.offset
+				|| entry.width != std::max(header->width >> level, 1u) || entry.height != std::max(header->height >> level, 1u)) {
+				return false;
+			}
+		}
+		view.bytes = bytes;
+		view.header = header;
+		view.levels = levels;
+		return true;
+	}
+
+	bool S_TextureView::isValid() const {
+		return header != nullptr;
+	}
+
+	E_TextureFormat S_TextureView::getFormat() const {
+		return header ? header->format : E_TextureFormat::COUNT;
+	}
+
+	uint32_t S_TextureView::getWidth() const {
+		return header ? header->width : 0;
+	}
+
+	uint32_t S_TextureView::getHeight() const {
+		return header ? header->height : 0;
+	}
+
+	uint32_t S_TextureView::getLevelCount() const {
+		return header ? header->levelCount : 0;
+	}
+
+	S_TextureLevel S_TextureView::getLevel(uint32_t level) const {
+		if (level >= getLevelCount()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_TextureView", "getLevel", "Level out of range", level);
+		}
+		const S_LevelEntry& entry = levels[level];
+		return { entry.width, entry.height, entry.rowPitch, bytes.subspan(entry.offset, entry.size) };
+	}
+
+	std::vector<uint8_t> S_TextureView::decodeLevel(uint32_t level) const {
+		const S_TextureLevel data = getLevel(level);
+		const E_TextureFormat format = getFormat();
+		std::vector<uint8_t> pixels(size_t(data.width) * data.height * 4);
+		if (!isCompressed(format)) {
+			std::memcpy(pixels.data(), data.data.data(), pixels.size());
+			return pixels;
+		}
+
+		const uint32_t blockBytes = getBytesPerBlock(format);
+		for (uint32_t blockY = 0; blockY < (data.height + 3) / 4; ++blockY) {
+			for (uint32_t blockX = 0; blockX < (data.width + 3) / 4; ++blockX) {
+				const std::byte* input = data.data.data() + size_t(blockY) * data.rowPitch + size_t(blockX) * blockBytes;
+				blocks::S_Block block{};
+				switch (format) {
+				case E_TextureFormat::BC1_UNORM:
+				case E_TextureFormat::BC1_SRGB:
+					blocks::decodeBc1(input, block);
+					break;
+				case E_TextureFormat::BC4_UNORM:
+				case E_TextureFormat::BC5_UNORM:
+					// Sampled as (r, g, 0, 1)
+					for (auto& pixel : block.pixels) {
+						pixel[3] = 255;
+					}
+					format == E_TextureFormat::BC4_UNORM ? blocks::decodeBc4(input, 0, block) : blocks::decodeBc5(input, block);
+					break;
+				default:
+					blocks::decodeBc7(input, block);
+					break;
+				}
+				for (uint32_t i = 0; i < 16; ++i) {
+					const uint32_t x = blockX * 4 + i % 4;
+					const uint32_t y = blockY * 4 + i / 4;
+					if (x < data.width && y < data.height) {
+						std::memcpy(&pixels[(size_t(y) * data.width + x) * 4], block.pixels[i], 4);
+					}
+				}
+			}
+		}
+		return pixels;
+	}
+
+	bool S_TextureView::isCompressed(E_TextureFormat format) {
+		return format != E_TextureFormat::RGBA8_UNORM && format != E_TextureFormat::RGBA8_SRGB;
+	}
+
+	bool S_TextureView::isSrgb(E_TextureFormat format) {
+		return format == E_TextureFormat::RGBA8_SRGB || format == E_TextureFormat::BC1_SRGB || format == E_TextureFormat::BC7_SRGB;
+	}
+
+	uint32_t S_TextureView::getBytesPerBlock(E_TextureFormat format) {
+		switch (format) {
+		case E_TextureFormat::BC1_UNORM:
+		case E_TextureFormat::BC1_SRGB:
+			return blocks::BC1_BYTES;
+		case E_TextureFormat::BC4_UNORM:
+			return blocks::BC4_BYTES;
+		case E_TextureFormat::BC5_UNORM:
+			return blocks::BC5_BYTES;
+		case E_TextureFormat::BC7_UNORM:
+		case E_TextureFormat::BC7_SRGB:
+			return blocks::BC7_BYTES;
+		default:
+			return 4;
+		}
+	}
+
+	const char* S_TextureView::getFormatName(E_TextureFormat format) {
+		return format < E_TextureFormat::COUNT ? FORMAT_NAMES[static_cast<size_t>(format)] : "unknown";
+	}
+
+	// S_Texture implementations
+	S_Texture::S_Texture(const S_Texture& other) : bytes(other.bytes) {
+		S_TextureView::parse(bytes, view);
+	}
+
+	S_Texture::S_Texture(S_Texture&& other) noexcept : bytes(std::move(other.bytes)), view(std::exchange(other.view, {})) {
+	}
+
+	S_Texture& S_Texture::operator=(const S_Texture& other) {
+		if (this != &other) {
+			bytes = other.bytes;
+			S_TextureView::parse(bytes, view);
+		}
+		return *this;
+	}
+
+	S_Texture& S_Texture::operator=(S_Texture&& other) noexcept {
+		if (this != &other) {
+			bytes = std::move(other.bytes);
+			view = std::exchange(other.view, {});
+		}
+		return *this;
+	}
+
+	void S_Texture::allocate(E_TextureFormat format, uint32_t width, uint32_t height, uint32_t levelCount) {
+		const bool compressed = S_TextureView::isCompressed(format);
+		const uint32_t blockBytes = S_TextureView::getBytesPerBlock(format);
+		std::vector<S_TextureView::S_LevelEntry> entries(levelCount);
+		uint64_t offset = alignUp(sizeof(S_TextureView::S_Header) + levelCount * sizeof(S_TextureView::S_LevelEntry), LEVEL_ALIGNMENT);
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			S_TextureView::S_LevelEntry& entry = entries[level];
+			entry.width = std::max(width >> level, 1u);
+			entry.height = std::max(height >> level, 1u);
+			entry.rowPitch = compressed ? (entry.width + 3) / 4 * blockBytes : entry.width * 4;
+			entry.offset = offset;
+			entry.size = uint64_t(entry.rowPitch) * (compressed ? (entry.height + 3) / 4 : entry.height);
+			offset = alignUp(offset + entry.size, LEVEL_ALIGNMENT);
+		}
+		const S_TextureView::S_Header header{ TEXTURE_MAGIC, S_TextureView::FORMAT_VERSION, format, width, height, levelCount, offset };
+
+		bytes.assign(offset, std::byte{ 0 });
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		std::memcpy(bytes.data() + sizeof(header), entries.data(), entries.size() * sizeof(S_TextureView::S_LevelEntry));
+		S_TextureView::parse(bytes, view);
+	}
+
+	bool S_Texture::assign(std::vector<std::byte> containerBytes) {
+		bytes = std::move(containerBytes);
+		if (!S_TextureView::parse(bytes, view)) {
+			bytes.clear();
+			return false;
+		}
+		return true;
+	}
+
+	std::span<std::byte> S_Texture::getLevelData(uint32_t level) {
+		const S_TextureLevel data = view.getLevel(level);
+		return { bytes.data() + (data.data.data() - bytes.data()), data.data.size() };
+	}
+
+	const S_TextureView& S_Texture::getView() const {
+		return view;
+	}
+
+	std::span<const std::byte> S_Texture::getBytes() const {
+		return bytes;
+	}
+
+	bool S_Texture::save(const std::string& path) const {
+		const std::string temporaryPath = core::platform::S_TemporaryPath::make(path);
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			if (!stream) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_Texture", "save",
+					"Could not write texture", temporaryPath);
+				stream.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_Texture", "save",
+				"Could not replace texture", path, error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+}
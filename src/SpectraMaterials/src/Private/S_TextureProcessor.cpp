@@ -0,0 +1,297 @@
+#include "S_TextureProcessor.h"
+#include "S_BlockCompression.h"
+#include "S_ContentHasher.h"
+#include "S_JobSystem.h"
+#include "S_MaterialCache.h"
+#include "S_MipKernels.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace spectra::materials {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::materials::textures";
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		float srgbToLinear(float value) {
+			return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		// Decoding is a lookup; encoding rounds exactly against the linear values halfway between
+		// neighbouring codes, which avoids a pow per channel
+		const kernels::S_ColorTables& getColorTables() {
+			static const kernels::S_ColorTables tables = []() {
+				kernels::S_ColorTables result;
+				for (uint32_t i = 0; i < 256; ++i) {
+					result.decode[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+					result.decode[256 + i] = static_cast<float>(i) / 255.0f;
+				}
+				for (uint32_t i = 0; i < 255; ++i) {
+					result.thresholds[i] = srgbToLinear((static_cast<float>(i) + 0.5f) / 255.0f);
+				}
+				result.thresholds[255] = 2.0f;
+				for (uint32_t step = 0; step < kernels::S_ColorTables::ENCODE_STEPS; ++step) {
+					const float value = static_cast<float>(step) / static_cast<float>(kernels::S_ColorTables::ENCODE_STEPS);
+					result.encodeBase[step] = static_cast<int32_t>(std::upper_bound(result.thresholds, result.thresholds + 255, value) - result.thresholds);
+				}
+				return result;
+			}();
+			return tables;
+		}
+
+		struct S_MipKernelSet {
+			kernels::FilterRowsKernel filterRows = kernels::filterRowsScalar;
+			kernels::FilterPixelsKernel filterPixels = kernels::filterPixelsScalar;
+			kernels::DecodeKernel decode = kernels::decodeScalar;
+			kernels::EncodeKernel encode = kernels::encodeScalar;
+		};
+
+		S_MipKernelSet selectKernels(E_MaterialKernel kernel) {
+			S_MipKernelSet set;
+#if defined(SPECTRA_X86_KERNELS)
+			if (kernel != E_MaterialKernel::SCALAR && S_MaterialProgram::getBestKernel() == E_MaterialKernel::AVX2) {
+				set = { kernels::filterRowsAvx2, kernels::filterPixelsAvx2, kernels::decodeAvx2, kernels::encodeAvx2 };
+			}
+#else
+			(void)kernel;
+#endif
+			return set;
+		}
+
+		// Filter support in destination pixels
+		float getSupport(E_MipFilter filter) {
+			switch (filter) {
+			case E_MipFilter::BOX:
+				return 0.5f;
+			case E_MipFilter::TENT:
+				return 1.0f;
+			default:
+				return 2.0f;
+			}
+		}
+
+		float getWeight(E_MipFilter filter, float x) {
+			x = std::fabs(x);
+			switch (filter) {
+			case E_MipFilter::BOX:
+				return x <= 0.5f ? 1.0f : 0.0f;
+			case E_MipFilter::TENT:
+				return std::max(1.0f - x, 0.0f);
+			default: {
+				if (x < 1e-6f) {
+					return 1.0f;
+				}
+				if (x >= 2.0f) {
+					return 0.0f;
+				}
+				const float angle = std::numbers::pi_v<float> * x;
+				return 2.0f * std::sin(angle) * std::sin(angle * 0.5f) / (angle * angle);
+			}
+			}
+		}
+
+		// Source pixels and normalized weights of every destination pixel along one axis
+		uint32_t computeTaps(uint32_t sourceSize, uint32_t size, E_MipFilter filter, E_TextureAddress address,
+			std::vector<uint32_t>& indices, std::vector<float>& weights) {
+			const float scale = static_cast<float>(sourceSize) / static_cast<float>(size);
+			const float radius = getSupport(filter) * scale;
+			const uint32_t tapCount = static_cast<uint32_t>(std::ceil(2.0f * radius)) + 1;
+			indices.assign(size_t(size) * tapCount, 0);
+			weights.assign(size_t(size) * tapCount, 0.0f);
+			for (uint32_t i = 0; i < size; ++i) {
+				const float center = (static_cast<float>(i) + 0.5f) * scale;
+				const int32_t first = static_cast<int32_t>(std::ceil(center - radius - 0.5f));
+				float total = 0.0f;
+				for (uint32_t k = 0; k < tapCount; ++k) {
+					const int32_t source = first + static_cast<int32_t>(k);
+					const int32_t count = static_cast<int32_t>(sourceSize);
+					const float weight = getWeight(filter, (static_cast<float>(source) + 0.5f - center) / scale);
+					indices[i * tapCount + k] = static_cast<uint32_t>(address == E_TextureAddress::WRAP
+						? (source % count + count) % count : std::clamp(source, 0, count - 1));
+					weights[i * tapCount + k] = weight;
+					total += weight;
+				}
+				for (uint32_t k = 0; k < tapCount; ++k) {
+					weights[i * tapCount + k] /= total;
+				}
+			}
+			return tapCount;
+		}
+	}
+
+	// S_TextureProcessor implementations
+	S_Texture S_TextureProcessor::process(const S_TextureImage& image, const S_TextureSettings& settings) {
+		using namespace spectra::instrumentation;
+
+		if (!image.pixels || image.width == 0 || image.height == 0) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_TextureProcessor", "process", "Empty image", image.width, image.height);
+		}
+		if (settings.format >= E_TextureFormat::COUNT) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_TextureProcessor", "process", "Unknown format", static_cast<uint32_t>(settings.format));
+		}
+		const auto start = std::chrono::steady_clock::now();
+		stats = {};
+		stats.levels = settings.mips ? static_cast<uint32_t>(std::bit_width(std::max(image.width, image.height))) : 1;
+
+		S_Texture texture;
+		texture.allocate(settings.format, image.width, image.height, stats.levels);
+		storeLevel(texture, 0, image.pixels, settings.format, settings.quality);
+		if (stats.levels > 1) {
+			const auto mipStart = std::chrono::steady_clock::now();
+			const kernels::DecodeKernel decode = selectKernels(settings.kernel).decode;
+			const kernels::S_ColorTables& tables = getColorTables();
+			const bool srgb = S_TextureView::isSrgb(settings.format);
+			const size_t pixelCount = size_t(image.width) * image.height;
+			current.resize(pixelCount * 4);
+			core::jobs::S_JobSystem::getInstance().parallelFor(0, pixelCount, [&](size_t begin, size_t end) {
+				decode(image.pixels + begin * 4, static_cast<uint32_t>((end - begin) * 4), srgb, tables, current.data() + begin * 4);
+			}, 1024);
+			stats.mipMilliseconds += millisecondsSince(mipStart);
+
+			uint32_t width = image.width;
+			uint32_t height = image.height;
+			for (uint32_t level = 1; level < stats.levels; ++level) {
+				const uint32_t levelWidth = std::max(width >> 1, 1u);
+				const uint32_t levelHeight = std::max(height >> 1, 1u);
+				downsample(width, height, levelWidth, levelHeight, settings);
+				std::swap(current, next);
+				storeLevel(texture, level, pixels.data(), settings.format, settings.quality);
+				width = levelWidth;
+				height = levelHeight;
+			}
+		}
+		stats.totalMilliseconds = millisecondsSince(start);
+		Instrumentation::recordTiming(STATS_CATEGORY, "process", stats.totalMilliseconds);
+		return texture;
+	}
+
+	S_Texture S_TextureProcessor::process(const S_TextureImage& image, const S_TextureSettings& settings, S_MaterialCache& cache) {
+		const auto start = std::chrono::steady_clock::now();
+		const S_MaterialKey key = getTextureKey(image, settings);
+		std::vector<std::byte> blob;
+		S_Texture texture;
+		if (cache.find(key, E_CacheBlobType::TEXTURE, blob) && texture.assign(std::move(blob))) {
+			stats = {};
+			stats.levels = texture.getView().getLevelCount();
+			stats.cacheHit = true;
+			stats.totalMilliseconds = millisecondsSince(start);
+			return texture;
+		}
+		texture = process(image, settings);
+		cache.store(key, E_CacheBlobType::TEXTURE, texture.getBytes());
+		return texture;
+	}
+
+	S_MaterialKey S_TextureProcessor::getTextureKey(const S_TextureImage& image, const S_TextureSettings& settings) {
+		S_ContentHasher hasher;
+		hasher.add(VERSION);
+		hasher.add(S_TextureView::FORMAT_VERSION);
+		hasher.add(static_cast<uint64_t>(E_CacheBlobType::TEXTURE));
+		hasher.add((uint64_t(image.width) << 32) | image.height);
+		hasher.add(static_cast<uint64_t>(settings.format));
+		hasher.add(static_cast<uint64_t>(settings.filter));
+		hasher.add(static_cast<uint64_t>(settings.address));
+		hasher.add(static_cast<uint64_t>(settings.quality));
+		hasher.add(settings.mips);
+		hasher.addBytes({ reinterpret_cast<const std::byte*>(image.pixels), size_t(image.width) * image.height * 4 });
+		return hasher.finish();
+	}
+
+	const S_TextureProcessStats& S_TextureProcessor::getStats() const {
+		return stats;
+	}
+
+	void S_TextureProcessor::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "levels", stats.levels);
+		Instrumentation::setGauge(STATS_CATEGORY, "blocks", static_cast<double>(stats.blocks));
+		Instrumentation::setGauge(STATS_CATEGORY, "cacheHit", stats.cacheHit ? 1.0 : 0.0);
+		Instrumentation::setGauge(STATS_CATEGORY, "mipMilliseconds", stats.mipMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "compressMilliseconds", stats.compressMilliseconds);
+	}
+
+	// Vertical pass into a source-wide row, then horizontal into the level, one job per band of rows
+	void S_TextureProcessor::downsample(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height,
+		const S_TextureSettings& settings) {
+		const auto start = std::chrono::steady_clock::now();
+		const uint32_t tapsX = computeTaps(sourceWidth, width, settings.filter, settings.address, tapIndices[0], tapWeights[0]);
+		const uint32_t tapsY = computeTaps(sourceHeight, height, settings.filter, settings.address, tapIndices[1], tapWeights[1]);
+		next.resize(size_t(width) * height * 4);
+		pixels.resize(next.size());
+
+		const S_MipKernelSet mipKernels = selectKernels(settings.kernel);
+		const kernels::S_ColorTables& tables = getColorTables();
+		const bool srgb = S_TextureView::isSrgb(settings.format);
+		const size_t sourcePitch = size_t(sourceWidth) * 4;
+		core::jobs::S_JobSystem::getInstance().parallelFor(0, height, [&](size_t begin, size_t end) {
+			std::vector<float> row(sourcePitch);
+			std::vector<const float*> rows(tapsY);
+			for (size_t y = begin; y < end; ++y) {
+				for (uint32_t k = 0; k < tapsY; ++k) {
+					rows[k] = current.data() + tapIndices[1][y * tapsY + k] * sourcePitch;
+				}
+				mipKernels.filterRows(rows.data(), tapWeights[1].data() + y * tapsY, tapsY, static_cast<uint32_t>(sourcePitch), row.data());
+				float* output = next.data() + y * width * 4;
+				mipKernels.filterPixels(row.data(), tapIndices[0].data(), tapWeights[0].data(), tapsX, width, output);
+
+				// Clamped in place so Lanczos ringing does not build up level over level
+				mipKernels.encode(output, width * 4, srgb, tables, pixels.data() + y * width * 4);
+			}
+		});
+		stats.mipMilliseconds += millisecondsSince(start);
+	}
+
+	void S_TextureProcessor::storeLevel(S_Texture& texture, uint32_t level, const uint8_t* levelPixels, E_TextureFormat format,
+		E_TextureQuality quality) {
+		const std::span<std::byte> data = texture.getLevelData(level);
+		const S_TextureLevel info = texture.getView().getLevel(level);
+		if (!S_TextureView::isCompressed(format)) {
+			std::memcpy(data.data(), levelPixels, data.size());
+			return;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const uint32_t blocksX = (info.width + 3) / 4;
+		const uint32_t blocksY = (info.height + 3) / 4;
+		const uint32_t blockBytes = S_TextureView::getBytesPerBlock(format);
+		core::jobs::S_JobSystem::getInstance().parallelFor(0, blocksY, [&](size_t begin, size_t end) {
+			blocks::S_Block block;
+			for (size_t blockY = begin; blockY < end; ++blockY) {
+				for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+					for (uint32_t i = 0; i < 16; ++i) {
+						const uint32_t x = std::min(blockX * 4 + i % 4, info.width - 1);
+						const uint32_t y = std::min(static_cast<uint32_t>(blockY) * 4 + i / 4, info.height - 1);
+						std::memcpy(block.pixels[i], levelPixels + (size_t(y) * info.width + x) * 4, 4);
+					}
+					std::byte* output = data.data() + blockY * info.rowPitch + size_t(blockX) * blockBytes;
+					switch (format) {
+					case E_TextureFormat::BC1_UNORM:
+					case E_TextureFormat::BC1_SRGB:
+						blocks::encodeBc1(block, quality, output);
+						break;
+					case E_TextureFormat::BC4_UNORM:
+						blocks::encodeBc4(block, 0, quality, output);
+						break;
+					case E_TextureFormat::BC5_UNORM:
+						blocks::encodeBc5(block, quality, output);
+						break;
+					default:
+						blocks::encodeBc7(block, quality, output);
+						break;
+					}
+				}
+			}
+		});
+		stats.blocks += uint64_t(blocksX) * blocksY;
+		stats.compressMilliseconds += millisecondsSince(start);
+	}
+}
@@ -1,4 +1,4 @@
 #include "SpectraMaterials.h"
 
-void SPECTRA_MATERIALS SpectraMaterialsInit() {
+extern "C" void SPECTRA_MATERIALS SpectraMaterialsInit() {
 }
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SpectraMaterials.h"
+#include "S_MappedFile.h"
+#include "S_MaterialCompiler.h"
+#include "S_MaterialGraph.h"
+#include "S_MaterialProgram.h"
+
+namespace spectra::materials {
+	enum class SPECTRA_MATERIALS E_CacheBlobType : uint32_t {
+		MATERIAL_PROGRAM = 0,  // S_MaterialProgram::serialize()
+		SHADER,                // Backend shader binaries
+		TEXTURE                // S_Texture containers
+	};
+
+	struct S_MaterialCacheSettings {
+		std::string directory;             // Created if missing
+		uint64_t maxBytes = 256ull << 20;  // Blob bytes kept by flush(), least recently used evicted first
+	};
+
+	struct S_MaterialCacheStats {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t stores = 0;
+		uint64_t evictions = 0;
+		uint64_t flushes = 0;
+		uint64_t reloads = 0;         // Newer packs picked up after a miss
+		uint64_t corruptEntries = 0;  // Blobs failing their checksum, treated as misses
+		uint64_t entries = 0;         // In the pack this cache maps
+		uint64_t packBytes = 0;
+		double flushMilliseconds = 0.0;
+	};
+
+	// Persistent, content-addressed store for compiled materials and other blobs, shared by
+	// every process on the machine. Everything lives in one pack file: a header, an index
+	// sorted by key, then the blobs, mapped read-only. Packs are never modified in place:
+	// flush() merges this cache's new entries with whatever pack is on disk under a lock file,
+	// writes a new pack and renames it over the old one. Readers take no lock, as a mapping
+	// keeps its snapshot alive across the rename, and pick up newer packs when a lookup misses.
+	// Recency is kept in memory and written by flush(), which evicts the least recently used
+	// entries beyond maxBytes. On Windows a pack another process maps cannot be replaced, so
+	// flush() logs a WARNING and keeps its entries for the next attempt. Thread-safe.
+	class SPECTRA_MATERIALS S_MaterialCache {
+	public:
+		explicit S_MaterialCache(S_MaterialCacheSettings settings);
+		~S_MaterialCache();  // Flushes
+		S_MaterialCache(const S_MaterialCache&) = delete;
+		S_MaterialCache& operator=(const S_MaterialCache&) = delete;
+
+		// Key of the graph's program for this compiler and program format
+		[[nodiscard]] static S_MaterialKey getProgramKey(const S_MaterialGraph& graph);
+
+		// Copies the blob out, since flush() remaps the pack
+		bool find(const S_MaterialKey& key, E_CacheBlobType type, std::vector<std::byte>& blob);
+
+		// Visible to this cache at once, to other processes after flush()
+		void store(const S_MaterialKey& key, E_CacheBlobType type, std::span<const std::byte> blob);
+
+		// Cached program for the graph, compiled and stored on a miss
+		[[nodiscard]] S_MaterialProgram getProgram(const S_MaterialGraph& graph, S_MaterialCompiler& compiler);
+
+		// Returns false if the pack could not be replaced; pending entries are kept
+		bool flush();
+
+		[[nodiscard]] S_MaterialCacheStats getStats() const;
+		[[nodiscard]] std::string getPackPath() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::materials::cache"
+		void publishStats() const;
+
+	private:
+		struct S_PackHeader;
+		struct S_PackEntry;
+
+		struct S_PendingEntry {
+			E_CacheBlobType type = E_CacheBlobType::MATERIAL_PROGRAM;
+			std::vector<std::byte> blob;
+		};
+
+		struct S_KeyHash {
+			size_t operator()(const S_MaterialKey& key) const { return static_cast<size_t>(key.low ^ (key.high >> 7)); }
+		};
+
+		S_MaterialCacheSettings settings;
+		std::filesystem::path packPath;
+		std::filesystem::path lockPath;
+		mutable std::mutex mutex;  // Guards everything below
+		core::platform::S_MappedFile pack;
+		const S_PackEntry* packEntries = nullptr;
+		uint32_t packEntryCount = 0;
+		std::filesystem::file_time_type packWriteTime{};
+		uintmax_t packFileSize = 0;
+		std::unordered_map<S_MaterialKey, S_PendingEntry, S_KeyHash> pending;
+		std::unordered_map<S_MaterialKey, uint64_t, S_KeyHash> lastUses;  // Seconds since the epoch, of pack entries used
+		S_MaterialCacheStats stats;
+
+		void reloadPack();
+		[[nodiscard]] bool isPackStale() const;
+		[[nodiscard]] const S_PackEntry* findEntry(const S_MaterialKey& key) const;
+
+		// Maps and validates a pack, returning its index; a missing or invalid pack has none
+		static const S_PackEntry* openPack(const std::filesystem::path& path, core::platform::S_MappedFile& file, uint32_t& entryCount);
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "SpectraMaterials.h"
+#include "S_MaterialGraph.h"
+#include "S_MaterialProgram.h"
+
+namespace spectra::materials {
+	// Lowers an S_MaterialGraph to an S_MaterialProgram:
+	//  1. Nodes no output reaches are dropped, cycles and unconnected inputs are errors.
+	//  2. Live nodes are expanded in dependency order into scalar operations, one per vector
+	//     component, in SSA form. Operations on constants are folded, identities such as
+	//     x * 1 simplified and repeated operations merged as they are created.
+	//  3. Operations no output reads any more are removed, and the rest get registers by a
+	//     linear scan that reuses a register once its last reader has run.
+	// Folding treats x * 0 as 0 and x + 0 as x, so NaN, infinity and the sign of zero are not
+	// preserved through them. Keep the compiler around to reuse its working memory.
+	class SPECTRA_MATERIALS S_MaterialCompiler {
+	public:
+		// Part of every cache key; bump whenever the generated code changes
+		static constexpr uint32_t VERSION = 1;
+
+		// Logs an ERROR for invalid graphs
+		[[nodiscard]] S_MaterialProgram compile(const S_MaterialGraph& graph);
+
+	private:
+		static constexpr uint32_t NO_VALUE = 0xFFFFFFFFu;
+
+		struct S_Value {
+			E_MaterialOp op = E_MaterialOp::COUNT;  // COUNT for constants
+			std::array<uint32_t, 3> operands{ NO_VALUE, NO_VALUE, NO_VALUE };
+			float constant = 0.0f;
+		};
+
+		struct S_ValueKey {
+			E_MaterialOp op;
+			std::array<uint32_t, 3> operands;
+
+			[[nodiscard]] bool operator==(const S_ValueKey&) const = default;
+		};
+
+		struct S_ValueKeyHash {
+			size_t operator()(const S_ValueKey& key) const;
+		};
+
+		// Scalar values of one node's output; FLOAT uses the first component only
+		struct S_NodeValue {
+			E_MaterialValueType type = E_MaterialValueType::FLOAT;
+			std::array<uint32_t, 3> components{ NO_VALUE, NO_VALUE, NO_VALUE };
+		};
+
+		std::vector<S_Value> values;
+		std::unordered_map<S_ValueKey, uint32_t, S_ValueKeyHash> valueIndices;
+		std::unordered_map<uint32_t, uint32_t> constantIndices;  // By bit pattern
+		std::vector<S_NodeValue> nodeValues;
+		std::vector<uint32_t> order;
+		std::vector<uint8_t> marks;
+		S_MaterialCompileStats stats;
+
+		void sortLiveNodes(const S_MaterialGraph& graph);
+		void lowerNode(const S_MaterialGraph& graph, uint32_t node);
+		[[nodiscard]] S_NodeValue binary(E_MaterialOp op, const S_NodeValue& a, const S_NodeValue& b);
+		[[nodiscard]] uint32_t component(const S_NodeValue& value, uint32_t index) const;
+
+		[[nodiscard]] uint32_t constant(float value);
+		[[nodiscard]] uint32_t emit(E_MaterialOp op, uint32_t a, uint32_t b = NO_VALUE, uint32_t c = NO_VALUE);
+		[[nodiscard]] bool isConstant(uint32_t value, float constantValue) const;
+
+		void allocateRegisters(const std::array<uint32_t, MATERIAL_CHANNEL_COUNT>& channelValues, S_MaterialProgram& program);
+	};
+}
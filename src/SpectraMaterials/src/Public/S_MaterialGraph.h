@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "SpectraMaterials.h"
+#include "S_Vec3.h"
+
+namespace spectra::materials {
+	constexpr uint32_t INVALID_NODE = 0xFFFFFFFFu;
+	constexpr uint32_t MAX_NODE_INPUTS = 3;
+
+	enum class SPECTRA_MATERIALS E_MaterialValueType : uint8_t {
+		FLOAT = 0,
+		VECTOR3
+	};
+
+	// Inputs a node graph can read, see E_ShadingChannel for how they reach the program
+	enum class SPECTRA_MATERIALS E_MaterialInput : uint8_t {
+		U = 0,
+		V,
+		POSITION,   // VECTOR3
+		NORMAL,     // VECTOR3, shading normal
+		COS_THETA,  // Between the normal and the outgoing direction
+		COUNT
+	};
+
+	enum class SPECTRA_MATERIALS E_MaterialOutput : uint8_t {
+		BASE_COLOR = 0,  // VECTOR3, defaults to 0.8
+		ROUGHNESS,       // Defaults to 0.5
+		METALLIC,        // Defaults to 0
+		EMISSION,        // VECTOR3, defaults to 0
+		OPACITY,         // Defaults to 1
+		COUNT
+	};
+
+	enum class SPECTRA_MATERIALS E_MaterialNodeType : uint8_t {
+		CONSTANT = 0,  // FLOAT or VECTOR3 value
+		INPUT,         // parameter is an E_MaterialInput
+		ADD,           // Binary and ternary nodes work per component, broadcasting FLOAT inputs
+		SUBTRACT,
+		MULTIPLY,
+		DIVIDE,
+		MINIMUM,
+		MAXIMUM,
+		ABSOLUTE,
+		SQUARE_ROOT,
+		FLOOR,
+		FRACTION,      // x - floor(x)
+		SATURATE,      // Clamped to [0, 1]
+		MIX,           // (a, b, t): a + (b - a) * t
+		STEP,          // (edge, x): 1 where x >= edge, else 0
+		DOT,           // FLOAT from two VECTOR3s
+		LENGTH,
+		NORMALIZE,
+		COMBINE,       // VECTOR3 from three FLOATs
+		SPLIT,         // FLOAT component parameter of a VECTOR3
+		CHECKER,       // (u, v, scale): 0 and 1 in alternating squares of 1 / scale
+		FRESNEL,       // (f0, cosTheta): Schlick's approximation
+		COUNT
+	};
+
+	// 128-bit content hash identifying a material, see S_MaterialGraph::computeContentKey()
+	struct S_MaterialKey {
+		uint64_t high = 0;
+		uint64_t low = 0;
+
+		[[nodiscard]] bool operator==(const S_MaterialKey&) const = default;
+		[[nodiscard]] auto operator<=>(const S_MaterialKey&) const = default;
+	};
+
+	// Output of a node, what node inputs and material outputs connect to
+	struct S_MaterialSocket {
+		uint32_t node = INVALID_NODE;
+
+		[[nodiscard]] bool isValid() const { return node != INVALID_NODE; }
+	};
+
+	struct S_MaterialNode {
+		E_MaterialNodeType type = E_MaterialNodeType::CONSTANT;
+		E_MaterialValueType valueType = E_MaterialValueType::FLOAT;  // Of CONSTANT nodes
+		uint32_t parameter = 0;
+		std::array<uint32_t, MAX_NODE_INPUTS> inputs{ INVALID_NODE, INVALID_NODE, INVALID_NODE };
+		std::array<float, 3> value{};
+	};
+
+	// Node graph as an editor builds it: nodes in creation order, linked by index. The graph
+	// is only checked when compiled, so it may pass through invalid states while being edited.
+	class SPECTRA_MATERIALS S_MaterialGraph {
+	public:
+		S_MaterialGraph();
+
+		S_MaterialSocket constant(float value);
+		S_MaterialSocket constant(const core::math::S_Vec3& value);
+		S_MaterialSocket input(E_MaterialInput input);
+
+		// Any node but CONSTANT and INPUT, with its inputs in the order listed for the type
+		S_MaterialSocket addNode(E_MaterialNodeType type, std::initializer_list<S_MaterialSocket> inputs, uint32_t parameter = 0);
+
+		// Rewires one input of a node; an unconnected source disconnects it
+		void connect(S_MaterialSocket node, uint32_t slot, S_MaterialSocket source);
+		void setOutput(E_MaterialOutput output, S_MaterialSocket source);
+		void clear();
+
+		[[nodiscard]] const std::vector<S_MaterialNode>& getNodes() const;
+		[[nodiscard]] S_MaterialSocket getOutput(E_MaterialOutput output) const;
+
+		// Hash of what the outputs reach, nodes numbered in dependency order. Creation order,
+		// dead nodes and parameters a node type ignores leave it unchanged.
+		[[nodiscard]] S_MaterialKey computeContentKey() const;
+
+		[[nodiscard]] static uint32_t getInputCount(E_MaterialNodeType type);
+		[[nodiscard]] static const char* getNodeTypeName(E_MaterialNodeType type);
+
+	private:
+		std::vector<S_MaterialNode> nodes;
+		std::array<uint32_t, static_cast<size_t>(E_MaterialOutput::COUNT)> outputs;
+
+		S_MaterialSocket addRaw(const S_MaterialNode& node);
+	};
+}
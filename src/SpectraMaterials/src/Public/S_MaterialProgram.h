@@ -0,0 +1,138 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SpectraMaterials.h"
+#include "S_MaterialGraph.h"
+
+namespace spectra::materials {
+	// What the renderer supplies per shading point, one structure-of-arrays channel each
+	enum class SPECTRA_MATERIALS E_ShadingChannel : uint8_t {
+		U = 0,
+		V,
+		POSITION_X,
+		POSITION_Y,
+		POSITION_Z,
+		NORMAL_X,
+		NORMAL_Y,
+		NORMAL_Z,
+		COS_THETA,
+		COUNT
+	};
+
+	// What an evaluated material returns per shading point, one channel each
+	enum class SPECTRA_MATERIALS E_MaterialChannel : uint8_t {
+		BASE_COLOR_R = 0,
+		BASE_COLOR_G,
+		BASE_COLOR_B,
+		ROUGHNESS,
+		METALLIC,
+		EMISSION_R,
+		EMISSION_G,
+		EMISSION_B,
+		OPACITY,
+		COUNT
+	};
+
+	constexpr uint32_t SHADING_CHANNEL_COUNT = static_cast<uint32_t>(E_ShadingChannel::COUNT);
+	constexpr uint32_t MATERIAL_CHANNEL_COUNT = static_cast<uint32_t>(E_MaterialChannel::COUNT);
+
+	// Register machine operations. Every operand is a register holding one float per lane.
+	enum class SPECTRA_MATERIALS E_MaterialOp : uint8_t {
+		LOAD_INPUT = 0,  // destination = shading channel operands[0]
+		STORE_OUTPUT,    // Material channel destination = operands[0]
+		ADD,
+		SUBTRACT,
+		MULTIPLY,
+		DIVIDE,
+		MINIMUM,         // Second operand where either is NaN, as SSE minps
+		MAXIMUM,
+		ABSOLUTE,
+		SQUARE_ROOT,
+		FLOOR,
+		STEP,            // operands[1] >= operands[0] ? 1 : 0
+		MIX,             // operands[0] + (operands[1] - operands[0]) * operands[2]
+		COUNT
+	};
+
+	struct S_MaterialInstruction {
+		E_MaterialOp op = E_MaterialOp::COUNT;
+		uint8_t reserved = 0;
+		uint16_t destination = 0;
+		std::array<uint16_t, 3> operands{};
+	};
+
+	enum class SPECTRA_MATERIALS E_MaterialKernel : uint8_t {
+		SCALAR = 0,  // Eight lanes in plain C++
+		AVX2,        // Eight lanes in one register
+		BEST = 0xFF  // Widest kernel the CPU and the build support
+	};
+
+	// Channels a program does not read may be null
+	struct S_ShadingPoints {
+		std::array<const float*, SHADING_CHANNEL_COUNT> channels{};
+		uint32_t count = 0;
+	};
+
+	// Channels left null are not written
+	struct S_MaterialResults {
+		std::array<float*, MATERIAL_CHANNEL_COUNT> channels{};
+	};
+
+	struct S_MaterialCompileStats {
+		uint32_t graphNodes = 0;
+		uint32_t liveNodes = 0;            // Reachable from an output
+		uint32_t foldedOperations = 0;     // All operands constant, evaluated while compiling
+		uint32_t simplifiedOperations = 0; // Identities such as x * 1 and mix(a, b, 0)
+		uint32_t mergedOperations = 0;     // Repeats of an operation already computed
+		uint32_t instructions = 0;
+		uint32_t constants = 0;
+		uint32_t registers = 0;            // Constants included
+		double compileMilliseconds = 0.0;
+	};
+
+	// Flat instruction stream compiled from an S_MaterialGraph by S_MaterialCompiler. Constants
+	// live in the first registers and are loaded once per evaluate(); the instructions then run
+	// once per group of LANES shading points, so dispatch costs one switch per instruction for
+	// eight points rather than a graph walk per point.
+	class SPECTRA_MATERIALS S_MaterialProgram {
+	public:
+		static constexpr uint32_t LANES = 8;
+		static constexpr uint32_t MAX_REGISTERS = 256;
+		static constexpr uint32_t FORMAT_VERSION = 1;  // Of serialize(), part of every cache key
+
+		// Evaluates points.count points. A kernel the CPU lacks falls back to SCALAR; every
+		// kernel returns the same bits.
+		void evaluate(const S_ShadingPoints& points, const S_MaterialResults& results, E_MaterialKernel kernel = E_MaterialKernel::BEST) const;
+
+		[[nodiscard]] const std::vector<S_MaterialInstruction>& getInstructions() const;
+		[[nodiscard]] const std::vector<float>& getConstants() const;
+		[[nodiscard]] uint32_t getRegisterCount() const;
+		[[nodiscard]] uint32_t getInputMask() const;  // Bit per E_ShadingChannel read
+		[[nodiscard]] const S_MaterialCompileStats& getStats() const;
+
+		// One line per constant and instruction, e.g. "r4 = mul r2, r0"
+		[[nodiscard]] std::string disassemble() const;
+
+		// Flat copy for S_MaterialCache. deserialize() rejects blobs of another FORMAT_VERSION and
+		// any whose instructions reach outside the register file.
+		[[nodiscard]] std::vector<std::byte> serialize() const;
+		static bool deserialize(std::span<const std::byte> blob, S_MaterialProgram& program);
+
+		[[nodiscard]] static E_MaterialKernel getBestKernel();
+		[[nodiscard]] static const char* getKernelName(E_MaterialKernel kernel);
+
+	private:
+		friend class S_MaterialCompiler;
+
+		std::vector<S_MaterialInstruction> instructions;
+		std::vector<float> constants;
+		uint32_t registerCount = 0;
+		uint32_t inputMask = 0;
+		S_MaterialCompileStats stats;
+	};
+}
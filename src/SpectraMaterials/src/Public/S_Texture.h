@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SpectraMaterials.h"
+
+namespace spectra::materials {
+	enum class SPECTRA_MATERIALS E_TextureFormat : uint32_t {
+		RGBA8_UNORM = 0,
+		RGBA8_SRGB,
+		BC1_UNORM,  // RGB, alpha dropped
+		BC1_SRGB,
+		BC4_UNORM,  // Red
+		BC5_UNORM,  // Red and green, e.g. tangent space normals
+		BC7_UNORM,  // RGBA
+		BC7_SRGB,
+		COUNT
+	};
+
+	struct S_TextureLevel {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t rowPitch = 0;  // Bytes per row of pixels, or of 4x4 blocks for BC formats
+		std::span<const std::byte> data;
+	};
+
+	// Non-owning view of a texture container: a header, one entry per mip level and the level
+	// data, each level 64-byte aligned so a mapped file can be uploaded without copying.
+	class SPECTRA_MATERIALS S_TextureView {
+	public:
+		static constexpr uint32_t FORMAT_VERSION = 1;
+
+		// Validates the header and every level range; false leaves the view empty
+		static bool parse(std::span<const std::byte> bytes, S_TextureView& view);
+
+		[[nodiscard]] bool isValid() const;
+		[[nodiscard]] E_TextureFormat getFormat() const;
+		[[nodiscard]] uint32_t getWidth() const;
+		[[nodiscard]] uint32_t getHeight() const;
+		[[nodiscard]] uint32_t getLevelCount() const;
+		[[nodiscard]] S_TextureLevel getLevel(uint32_t level) const;
+
+		// RGBA8 pixels of a level, for previews and tests. BC7 blocks in modes other than the
+		// ones S_TextureProcessor writes (1 and 6) decode as transparent black.
+		[[nodiscard]] std::vector<uint8_t> decodeLevel(uint32_t level) const;
+
+		[[nodiscard]] static bool isCompressed(E_TextureFormat format);
+		[[nodiscard]] static bool isSrgb(E_TextureFormat format);
+		[[nodiscard]] static uint32_t getBytesPerBlock(E_TextureFormat format);  // Per pixel when uncompressed
+		[[nodiscard]] static const char* getFormatName(E_TextureFormat format);
+
+	private:
+		friend class S_Texture;
+
+		struct S_Header;
+		struct S_LevelEntry;
+
+		std::span<const std::byte> bytes;
+		const S_Header* header = nullptr;
+		const S_LevelEntry* levels = nullptr;
+	};
+
+	// Texture container owning its bytes, as S_TextureProcessor produces and S_MaterialCache stores it
+	class SPECTRA_MATERIALS S_Texture {
+	public:
+		S_Texture() = default;
+		S_Texture(const S_Texture& other);
+		S_Texture(S_Texture&& other) noexcept;
+		S_Texture& operator=(const S_Texture& other);
+		S_Texture& operator=(S_Texture&& other) noexcept;
+
+		// Lays out the container for the given level sizes; fill each level through getLevelData()
+		void allocate(E_TextureFormat format, uint32_t width, uint32_t height, uint32_t levelCount);
+
+		// Takes a container, e.g. from S_MaterialCache; false if it does not parse
+		bool assign(std::vector<std::byte> containerBytes);
+
+		[[nodiscard]] std::span<std::byte> getLevelData(uint32_t level);
+		[[nodiscard]] const S_TextureView& getView() const;
+		[[nodiscard]] std::span<const std::byte> getBytes() const;
+
+		// Written to path + ".tmp" and renamed into place; false, with a WARNING, on failure
+		bool save(const std::string& path) const;
+
+	private:
+		std::vector<std::byte> bytes;
+		S_TextureView view;
+	};
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "SpectraMaterials.h"
+#include "S_MaterialGraph.h"
+#include "S_MaterialProgram.h"
+#include "S_Texture.h"
+
+namespace spectra::materials {
+	class S_MaterialCache;
+
+	// Source pixels, RGBA8 rows without padding. Color channels are read as sRGB for the SRGB formats.
+	struct S_TextureImage {
+		const uint8_t* pixels = nullptr;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	// Mip reduction filter, evaluated in linear light
+	enum class SPECTRA_MATERIALS E_MipFilter : uint8_t {
+		BOX = 0,   // Average of the source pixels under the destination pixel
+		TENT,      // Triangle twice as wide, softer and without the box's aliasing
+		LANCZOS    // Two lobe Lanczos, sharpest; ringing is clamped per level
+	};
+
+	enum class SPECTRA_MATERIALS E_TextureAddress : uint8_t {
+		WRAP = 0,
+		CLAMP
+	};
+
+	// How hard the block encoders search. FAST fits every block along its principal axis;
+	// NORMAL refines endpoints by least squares and adds two-subset BC7 blocks; HIGH refines
+	// further, searches more partitions and nudges BC4 endpoints.
+	enum class SPECTRA_MATERIALS E_TextureQuality : uint8_t {
+		FAST = 0,
+		NORMAL,
+		HIGH
+	};
+
+	struct S_TextureSettings {
+		E_TextureFormat format = E_TextureFormat::BC7_SRGB;
+		E_MipFilter filter = E_MipFilter::TENT;
+		E_TextureAddress address = E_TextureAddress::WRAP;
+		E_TextureQuality quality = E_TextureQuality::NORMAL;
+		bool mips = true;
+		E_MaterialKernel kernel = E_MaterialKernel::BEST;  // For the mip filters
+	};
+
+	struct S_TextureProcessStats {
+		uint32_t levels = 0;
+		uint64_t blocks = 0;             // Compressed, all levels
+		bool cacheHit = false;
+		double mipMilliseconds = 0.0;
+		double compressMilliseconds = 0.0;
+		double totalMilliseconds = 0.0;
+	};
+
+	// Turns source images into mip-mapped, block-compressed textures. Level 0 is converted to
+	// linear floats once; every further level is filtered from the one above it in two separable
+	// passes on the job system, clamped and rounded back to 8 bits (to sRGB for the SRGB
+	// formats). Blocks of each level are then encoded a row of blocks per job. Filters give the
+	// same bits on every kernel. Keep the processor around to reuse its working memory.
+	class SPECTRA_MATERIALS S_TextureProcessor {
+	public:
+		// Part of every cache key; bump whenever the output for the same input changes
+		static constexpr uint32_t VERSION = 2;
+
+		// Logs an ERROR for an empty image or an unknown format
+		[[nodiscard]] S_Texture process(const S_TextureImage& image, const S_TextureSettings& settings);
+
+		// As above, through the cache: a texture processed before, by any process, is read back
+		[[nodiscard]] S_Texture process(const S_TextureImage& image, const S_TextureSettings& settings, S_MaterialCache& cache);
+
+		// Hash of the pixels, the settings that change the output and the versions
+		[[nodiscard]] static S_MaterialKey getTextureKey(const S_TextureImage& image, const S_TextureSettings& settings);
+
+		// Of the last process()
+		[[nodiscard]] const S_TextureProcessStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::materials::textures"
+		void publishStats() const;
+
+	private:
+		std::vector<float> current;     // Linear RGBA of the level just produced
+		std::vector<float> next;
+		std::vector<uint8_t> pixels;    // The same level in 8 bits
+		std::vector<uint32_t> tapIndices[2];  // Per axis, tapCount source pixels per destination pixel
+		std::vector<float> tapWeights[2];
+		S_TextureProcessStats stats;
+
+		void downsample(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height, const S_TextureSettings& settings);
+		void storeLevel(S_Texture& texture, uint32_t level, const uint8_t* levelPixels, E_TextureFormat format, E_TextureQuality quality);
+	};
+}
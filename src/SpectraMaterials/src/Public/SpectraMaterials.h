@@ -1,7 +1,12 @@
 #pragma once
 
 #ifndef SPECTRA_MATERIALS
+#if defined(_WIN32)
 #define SPECTRA_MATERIALS __declspec(dllexport)
+#else
+#define SPECTRA_MATERIALS __attribute__((visibility("default")))
+#endif
 #endif
 
-void SPECTRA_MATERIALS SpectraMaterialsInit();
\ No newline at end of file
+// C linkage so the module registry can also resolve it by name from a runtime-loaded library
+extern "C" void SPECTRA_MATERIALS SpectraMaterialsInit();
\ No newline at end of file
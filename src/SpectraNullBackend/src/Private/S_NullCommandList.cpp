@@ -0,0 +1,175 @@
+#include "S_NullCommandList.h"
+
+#include <algorithm>
+
+namespace spectra::backend {
+	using pipeline::S_ResourceHandle;
+
+	namespace {
+		constexpr uint32_t MAX_BARRIERS_PER_COMMAND = (MAX_COMMAND_SIZE - sizeof(S_CommandHeader) - sizeof(S_BarrierCommand))
+			/ sizeof(pipeline::S_ResourceBarrier);
+		constexpr uint32_t MAX_CONSTANTS_PER_COMMAND = (MAX_COMMAND_SIZE - sizeof(S_CommandHeader) - sizeof(S_SetConstantsCommand))
+			/ sizeof(uint32_t);
+		constexpr uint32_t MAX_RENDER_TARGETS = 8;
+	}
+
+	// S_NullCommandList implementations
+	void S_NullCommandList::reset(pipeline::E_QueueType listQueue, core::memory::S_LinearArena& listArena, S_RecordCounters& listCounters) {
+		arena = &listArena;
+		counters = &listCounters;
+		firstSegment = nullptr;
+		currentSegment = nullptr;
+		queue = listQueue;
+		bytes = 0;
+		closed = false;
+		submitted = false;
+		startTime = std::chrono::steady_clock::now();
+	}
+
+	std::byte* S_NullCommandList::reserveSlow(uint32_t size) {
+		const uint32_t capacity = std::max(SEGMENT_SIZE, size);
+		auto* segment = static_cast<S_CommandSegment*>(arena->allocateRaw(sizeof(S_CommandSegment) + capacity, alignof(S_CommandSegment)));
+		segment->next = nullptr;
+		segment->used = size;
+		segment->capacity = capacity;
+		if (currentSegment) {
+			currentSegment->next = segment;
+		}
+		else {
+			firstSegment = segment;
+		}
+		currentSegment = segment;
+		return segment->data();
+	}
+
+	void S_NullCommandList::pushEmpty(E_CommandOp op) {
+		std::byte* data = reserve(sizeof(S_CommandHeader));
+		const S_CommandHeader header{ op, 0, static_cast<uint16_t>(sizeof(S_CommandHeader)) };
+		std::memcpy(data, &header, sizeof(header));
+		bytes += sizeof(header);
+	}
+
+	pipeline::E_QueueType S_NullCommandList::getQueue() const {
+		return queue;
+	}
+
+	void S_NullCommandList::barrier(std::span<const pipeline::S_ResourceBarrier> barriers) {
+		for (size_t first = 0; first < barriers.size(); first += MAX_BARRIERS_PER_COMMAND) {
+			const uint32_t count = static_cast<uint32_t>(std::min<size_t>(MAX_BARRIERS_PER_COMMAND, barriers.size() - first));
+			push(E_CommandOp::BARRIER, S_BarrierCommand{ count }, barriers.data() + first,
+				count * static_cast<uint32_t>(sizeof(pipeline::S_ResourceBarrier)));
+		}
+	}
+
+	void S_NullCommandList::setPipeline(pipeline::S_PipelineHandle pipeline) {
+		push(E_CommandOp::SET_PIPELINE, S_SetPipelineCommand{ pipeline.index });
+	}
+
+	void S_NullCommandList::setRenderTargets(std::span<const S_ResourceHandle> colors, S_ResourceHandle depth) {
+		const uint32_t count = static_cast<uint32_t>(std::min<size_t>(colors.size(), MAX_RENDER_TARGETS));
+		push(E_CommandOp::SET_RENDER_TARGETS, S_SetRenderTargetsCommand{ depth.index, count }, colors.data(),
+			count * static_cast<uint32_t>(sizeof(S_ResourceHandle)));
+	}
+
+	void S_NullCommandList::clearRenderTarget(S_ResourceHandle target, const std::array<float, 4>& color) {
+		push(E_CommandOp::CLEAR_RENDER_TARGET, S_ClearRenderTargetCommand{ target.index, { color[0], color[1], color[2], color[3] } });
+	}
+
+	void S_NullCommandList::clearDepth(S_ResourceHandle target, float depth) {
+		push(E_CommandOp::CLEAR_DEPTH, S_ClearDepthCommand{ target.index, depth });
+	}
+
+	void S_NullCommandList::setViewport(const pipeline::S_Viewport& viewport) {
+		push(E_CommandOp::SET_VIEWPORT, viewport);
+	}
+
+	void S_NullCommandList::setScissor(const pipeline::S_Rect& scissor) {
+		push(E_CommandOp::SET_SCISSOR, scissor);
+	}
+
+	void S_NullCommandList::setVertexBuffer(uint32_t slot, S_ResourceHandle buffer, uint64_t offset, uint32_t stride) {
+		push(E_CommandOp::SET_VERTEX_BUFFER, S_SetVertexBufferCommand{ offset, slot, buffer.index, stride });
+	}
+
+	void S_NullCommandList::setIndexBuffer(S_ResourceHandle buffer, uint64_t offset, bool indices32) {
+		push(E_CommandOp::SET_INDEX_BUFFER, S_SetIndexBufferCommand{ offset, buffer.index, indices32 ? 1u : 0u });
+	}
+
+	void S_NullCommandList::setResource(uint32_t slot, S_ResourceHandle resource) {
+		push(E_CommandOp::SET_RESOURCE, S_SetResourceCommand{ slot, resource.index });
+	}
+
+	void S_NullCommandList::setConstants(uint32_t offset, std::span<const uint32_t> values) {
+		for (size_t first = 0; first < values.size(); first += MAX_CONSTANTS_PER_COMMAND) {
+			const uint32_t count = static_cast<uint32_t>(std::min<size_t>(MAX_CONSTANTS_PER_COMMAND, values.size() - first));
+			push(E_CommandOp::SET_CONSTANTS, S_SetConstantsCommand{ offset + static_cast<uint32_t>(first), count }, values.data() + first,
+				count * static_cast<uint32_t>(sizeof(uint32_t)));
+		}
+	}
+
+	void S_NullCommandList::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+		push(E_CommandOp::DRAW, S_DrawCommand{ vertexCount, instanceCount, firstVertex, firstInstance });
+	}
+
+	void S_NullCommandList::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset,
+		uint32_t firstInstance) {
+		push(E_CommandOp::DRAW_INDEXED, S_DrawIndexedCommand{ indexCount, instanceCount, firstIndex, vertexOffset, firstInstance });
+	}
+
+	void S_NullCommandList::drawIndirect(S_ResourceHandle arguments, uint64_t offset, uint32_t drawCount) {
+		push(E_CommandOp::DRAW_INDIRECT, S_DrawIndirectCommand{ offset, arguments.index, drawCount });
+	}
+
+	void S_NullCommandList::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+		push(E_CommandOp::DISPATCH, S_DispatchCommand{ groupsX, groupsY, groupsZ });
+	}
+
+	void S_NullCommandList::copyBuffer(S_ResourceHandle destination, uint64_t destinationOffset, S_ResourceHandle source,
+		uint64_t sourceOffset, uint64_t size) {
+		push(E_CommandOp::COPY_BUFFER, S_CopyBufferCommand{ destinationOffset, sourceOffset, size, destination.index, source.index });
+	}
+
+	void S_NullCommandList::copyTexture(S_ResourceHandle destination, S_ResourceHandle source) {
+		push(E_CommandOp::COPY_TEXTURE, S_CopyTextureCommand{ destination.index, source.index });
+	}
+
+	void S_NullCommandList::beginMarker(std::string_view name) {
+		const uint32_t length = static_cast<uint32_t>(std::min<size_t>(name.size(), MAX_MARKER_LENGTH));
+		push(E_CommandOp::BEGIN_MARKER, S_BeginMarkerCommand{ length }, name.data(), length);
+	}
+
+	void S_NullCommandList::endMarker() {
+		pushEmpty(E_CommandOp::END_MARKER);
+	}
+
+	void S_NullCommandList::close() {
+		if (closed) {
+			return;
+		}
+		closed = true;
+		++counters->commandLists;
+		counters->commandBytes += bytes;
+		counters->recordNanoseconds += static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+	}
+
+	const S_CommandSegment* S_NullCommandList::getFirstSegment() const {
+		return firstSegment;
+	}
+
+	uint64_t S_NullCommandList::getBytes() const {
+		return bytes;
+	}
+
+	bool S_NullCommandList::isClosed() const {
+		return closed;
+	}
+
+	bool S_NullCommandList::isSubmitted() const {
+		return submitted;
+	}
+
+	void S_NullCommandList::markSubmitted() {
+		submitted = true;
+	}
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "S_LinearArena.h"
+#include "S_RenderDevice.h"
+
+namespace spectra::backend {
+	// Commands are stored back to back: a 4-byte header, then the payload struct, then any
+	// variable-length tail, padded to 4 bytes. Payloads are copied in and out with memcpy, so
+	// the stream has no alignment requirements beyond that padding.
+	enum class E_CommandOp : uint8_t {
+		BARRIER = 0,
+		SET_PIPELINE,
+		SET_RENDER_TARGETS,
+		CLEAR_RENDER_TARGET,
+		CLEAR_DEPTH,
+		SET_VIEWPORT,
+		SET_SCISSOR,
+		SET_VERTEX_BUFFER,
+		SET_INDEX_BUFFER,
+		SET_RESOURCE,
+		SET_CONSTANTS,
+		DRAW,
+		DRAW_INDEXED,
+		DRAW_INDIRECT,
+		DISPATCH,
+		COPY_BUFFER,
+		COPY_TEXTURE,
+		BEGIN_MARKER,
+		END_MARKER,
+		COUNT
+	};
+
+	struct S_CommandHeader {
+		E_CommandOp op = E_CommandOp::COUNT;
+		uint8_t reserved = 0;
+		uint16_t size = 0;  // Whole command including the header and padding
+	};
+
+	constexpr uint32_t MAX_COMMAND_SIZE = 0xFFFC;
+	constexpr uint32_t MAX_MARKER_LENGTH = 255;
+
+	struct S_BarrierCommand {
+		uint32_t count;  // S_ResourceBarrier entries follow
+	};
+
+	struct S_SetPipelineCommand {
+		uint32_t pipeline;
+	};
+
+	struct S_SetRenderTargetsCommand {
+		uint32_t depth;
+		uint32_t count;  // Color handles follow
+	};
+
+	struct S_ClearRenderTargetCommand {
+		uint32_t target;
+		float color[4];
+	};
+
+	struct S_ClearDepthCommand {
+		uint32_t target;
+		float depth;
+	};
+
+	struct S_SetVertexBufferCommand {
+		uint64_t offset;
+		uint32_t slot;
+		uint32_t buffer;
+		uint32_t stride;
+	};
+
+	struct S_SetIndexBufferCommand {
+		uint64_t offset;
+		uint32_t buffer;
+		uint32_t indices32;
+	};
+
+	struct S_SetResourceCommand {
+		uint32_t slot;
+		uint32_t resource;
+	};
+
+	struct S_SetConstantsCommand {
+		uint32_t offset;
+		uint32_t count;  // Values follow
+	};
+
+	struct S_DrawCommand {
+		uint32_t vertexCount;
+		uint32_t instanceCount;
+		uint32_t firstVertex;
+		uint32_t firstInstance;
+	};
+
+	struct S_DrawIndexedCommand {
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+
+	struct S_DrawIndirectCommand {
+		uint64_t offset;
+		uint32_t arguments;
+		uint32_t drawCount;
+	};
+
+	struct S_DispatchCommand {
+		uint32_t groupsX;
+		uint32_t groupsY;
+		uint32_t groupsZ;
+	};
+
+	struct S_CopyBufferCommand {
+		uint64_t destinationOffset;
+		uint64_t sourceOffset;
+		uint64_t size;
+		uint32_t destination;
+		uint32_t source;
+	};
+
+	struct S_CopyTextureCommand {
+		uint32_t destination;
+		uint32_t source;
+	};
+
+	struct S_BeginMarkerCommand {
+		uint32_t length;  // Characters follow, not terminated
+	};
+
+	// Piece of a command list's stream, carved from the recording thread's frame arena
+	struct S_CommandSegment {
+		S_CommandSegment* next;
+		uint32_t used;
+		uint32_t capacity;
+
+		[[nodiscard]] std::byte* data() { return reinterpret_cast<std::byte*>(this + 1); }
+		[[nodiscard]] const std::byte* data() const { return reinterpret_cast<const std::byte*>(this + 1); }
+	};
+
+	// Per-thread recording totals, owned by the thread's allocator and read at endFrame()
+	struct S_RecordCounters {
+		uint64_t commandLists = 0;
+		uint64_t commandBytes = 0;
+		uint64_t recordNanoseconds = 0;
+	};
+
+	// Records into a chain of segments from one thread's frame arena. Recording touches no
+	// shared state: the arena, the list and the counters all belong to the recording thread.
+	class S_NullCommandList final : public pipeline::I_CommandList {
+		static constexpr uint32_t SEGMENT_SIZE = 16 * 1024;
+
+		core::memory::S_LinearArena* arena = nullptr;
+		S_RecordCounters* counters = nullptr;
+		S_CommandSegment* firstSegment = nullptr;
+		S_CommandSegment* currentSegment = nullptr;
+		pipeline::E_QueueType queue = pipeline::E_QueueType::GRAPHICS;
+		uint64_t bytes = 0;
+		std::chrono::steady_clock::time_point startTime;
+		bool closed = false;
+		bool submitted = false;
+
+		std::byte* reserveSlow(uint32_t size);
+
+		std::byte* reserve(uint32_t size) {
+			if (currentSegment && currentSegment->used + size <= currentSegment->capacity) {
+				std::byte* data = currentSegment->data() + currentSegment->used;
+				currentSegment->used += size;
+				return data;
+			}
+			return reserveSlow(size);
+		}
+
+		// Header, payload and an optional tail in one reservation
+		template<typename T>
+		void push(E_CommandOp op, const T& payload, const void* tail = nullptr, uint32_t tailSize = 0) {
+			const uint32_t size = (static_cast<uint32_t>(sizeof(S_CommandHeader) + sizeof(T)) + tailSize + 3) & ~3u;
+			std::byte* data = reserve(size);
+			const S_CommandHeader header{ op, 0, static_cast<uint16_t>(size) };
+			std::memcpy(data, &header, sizeof(header));
+			std::memcpy(data + sizeof(header), &payload, sizeof(T));
+			if (tailSize) {
+				std::memcpy(data + sizeof(header) + sizeof(T), tail, tailSize);
+			}
+			bytes += size;
+		}
+
+		void pushEmpty(E_CommandOp op);
+
+	public:
+		void reset(pipeline::E_QueueType listQueue, core::memory::S_LinearArena& listArena, S_RecordCounters& listCounters);
+
+		[[nodiscard]] pipeline::E_QueueType getQueue() const override;
+
+		void barrier(std::span<const pipeline::S_ResourceBarrier> barriers) override;
+		void setPipeline(pipeline::S_PipelineHandle pipeline) override;
+		void setRenderTargets(std::span<const pipeline::S_ResourceHandle> colors, pipeline::S_ResourceHandle depth) override;
+		void clearRenderTarget(pipeline::S_ResourceHandle target, const std::array<float, 4>& color) override;
+		void clearDepth(pipeline::S_ResourceHandle target, float depth) override;
+		void setViewport(const pipeline::S_Viewport& viewport) override;
+		void setScissor(const pipeline::S_Rect& scissor) override;
+		void setVertexBuffer(uint32_t slot, pipeline::S_ResourceHandle buffer, uint64_t offset, uint32_t stride) override;
+		void setIndexBuffer(pipeline::S_ResourceHandle buffer, uint64_t offset, bool indices32) override;
+		void setResource(uint32_t slot, pipeline::S_ResourceHandle resource) override;
+		void setConstants(uint32_t offset, std::span<const uint32_t> values) override;
+		void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+		void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) override;
+		void drawIndirect(pipeline::S_ResourceHandle arguments, uint64_t offset, uint32_t drawCount) override;
+		void dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) override;
+		void copyBuffer(pipeline::S_ResourceHandle destination, uint64_t destinationOffset, pipeline::S_ResourceHandle source,
+			uint64_t sourceOffset, uint64_t size) override;
+		void copyTexture(pipeline::S_ResourceHandle destination, pipeline::S_ResourceHandle source) override;
+		void beginMarker(std::string_view name) override;
+		void endMarker() override;
+		void close() override;
+
+		[[nodiscard]] const S_CommandSegment* getFirstSegment() const;
+		[[nodiscard]] uint64_t getBytes() const;
+		[[nodiscard]] bool isClosed() const;
+		[[nodiscard]] bool isSubmitted() const;
+		void markSubmitted();
+	};
+}
@@ -0,0 +1,484 @@
+#include "S_NullDevice.h"
+#include "S_JobSystem.h"
+#include "S_NullCommandList.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace spectra::backend {
+	using namespace spectra::pipeline;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::backend::null";
+
+		// Each recording thread's arena grows in blocks of this size and keeps them across frames
+		constexpr size_t ARENA_BLOCK_SIZE = 256 * 1024;
+
+		// Validation errors past this many per frame are counted but not logged
+		constexpr uint64_t MAX_LOGGED_ERRORS = 32;
+
+		bool isWithin(E_ResourceAccess access, E_ResourceAccess mask) {
+			return (static_cast<uint32_t>(access) & ~static_cast<uint32_t>(mask)) == 0;
+		}
+
+		template<typename T>
+		T readPayload(const std::byte* command) {
+			T payload;
+			std::memcpy(&payload, command + sizeof(S_CommandHeader), sizeof(T));
+			return payload;
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	// Command allocator of one thread: an arena and a pool of list objects per frame in flight
+	struct alignas(64) S_ThreadRecorder {
+		core::memory::S_FrameArenas arenas{ S_NullDevice::FRAMES_IN_FLIGHT, ARENA_BLOCK_SIZE, core::memory::E_MemoryTag::RENDER };
+		std::array<std::vector<std::unique_ptr<S_NullCommandList>>, S_NullDevice::FRAMES_IN_FLIGHT> lists;
+		std::array<uint32_t, S_NullDevice::FRAMES_IN_FLIGHT> listsUsed{};
+		S_RecordCounters counters;
+	};
+
+	// S_NullDevice implementations
+	S_NullDevice::S_NullDevice() {
+		growRecorders();
+	}
+
+	S_NullDevice::~S_NullDevice() {
+		waitIdle();
+	}
+
+	const char* S_NullDevice::getName() const {
+		return "Null";
+	}
+
+	S_ResourceHandle S_NullDevice::createBuffer(const S_BufferDesc& desc, std::string_view name, E_ResourceAccess initialAccess) {
+		S_NullResource resource;
+		resource.name = name;
+		resource.kind = E_ResourceKind::BUFFER;
+		resource.buffer = desc;
+		resource.state = initialAccess;
+		std::lock_guard lock(objectMutex);
+		return addResource(std::move(resource));
+	}
+
+	S_ResourceHandle S_NullDevice::createTexture(const S_TextureDesc& desc, std::string_view name, E_ResourceAccess initialAccess) {
+		S_NullResource resource;
+		resource.name = name;
+		resource.kind = E_ResourceKind::TEXTURE;
+		resource.texture = desc;
+		resource.state = initialAccess;
+		std::lock_guard lock(objectMutex);
+		return addResource(std::move(resource));
+	}
+
+	S_HeapHandle S_NullDevice::createHeap(E_HeapCategory category, uint64_t size) {
+		std::lock_guard lock(objectMutex);
+		heaps.push_back({ category, size, true });
+		return { static_cast<uint32_t>(heaps.size() - 1) };
+	}
+
+	S_ResourceHandle S_NullDevice::createPlacedBuffer(S_HeapHandle heap, uint64_t offset, const S_BufferDesc& desc, std::string_view name) {
+		S_NullResource resource;
+		resource.name = name;
+		resource.kind = E_ResourceKind::BUFFER;
+		resource.buffer = desc;
+		resource.heap = heap.index;
+		resource.offset = offset;
+		std::lock_guard lock(objectMutex);
+		if (heap.index >= heaps.size() || !heaps[heap.index].alive) {
+			reportError("Placed buffer in a destroyed or unknown heap", "createPlacedBuffer", heap.index);
+		}
+		else if (heaps[heap.index].category != E_HeapCategory::BUFFER || offset + getBufferSize(desc) > heaps[heap.index].size) {
+			reportError("Placed buffer outside its heap or in a texture heap", "createPlacedBuffer", offset);
+		}
+		return addResource(std::move(resource));
+	}
+
+	S_ResourceHandle S_NullDevice::createPlacedTexture(S_HeapHandle heap, uint64_t offset, const S_TextureDesc& desc, std::string_view name) {
+		S_NullResource resource;
+		resource.name = name;
+		resource.kind = E_ResourceKind::TEXTURE;
+		resource.texture = desc;
+		resource.heap = heap.index;
+		resource.offset = offset;
+		std::lock_guard lock(objectMutex);
+		if (heap.index >= heaps.size() || !heaps[heap.index].alive) {
+			reportError("Placed texture in a destroyed or unknown heap", "createPlacedTexture", heap.index);
+		}
+		else if (heaps[heap.index].category == E_HeapCategory::BUFFER || offset + getTextureSize(desc) > heaps[heap.index].size) {
+			reportError("Placed texture outside its heap or in a buffer heap", "createPlacedTexture", offset);
+		}
+		return addResource(std::move(resource));
+	}
+
+	S_PipelineHandle S_NullDevice::createPipeline(const S_PipelineDesc& desc) {
+		std::lock_guard lock(objectMutex);
+		pipelines.push_back({ desc, true });
+		return { static_cast<uint32_t>(pipelines.size() - 1) };
+	}
+
+	S_ResourceHandle S_NullDevice::addResource(S_NullResource resource) {
+		resource.alive = true;
+		if (!freeResources.empty()) {
+			const uint32_t index = freeResources.back();
+			freeResources.pop_back();
+			resources[index] = std::move(resource);
+			return { index };
+		}
+		resources.push_back(std::move(resource));
+		return { static_cast<uint32_t>(resources.size() - 1) };
+	}
+
+	void S_NullDevice::destroyResource(S_ResourceHandle resource) {
+		std::lock_guard lock(objectMutex);
+		if (checkResource(resource.index, "destroyResource")) {
+			pendingReleases.push_back({ frameIndex, resource.index, E_ObjectKind::RESOURCE });
+		}
+	}
+
+	void S_NullDevice::destroyHeap(S_HeapHandle heap) {
+		std::lock_guard lock(objectMutex);
+		if (heap.index < heaps.size() && heaps[heap.index].alive) {
+			pendingReleases.push_back({ frameIndex, heap.index, E_ObjectKind::HEAP });
+		}
+	}
+
+	void S_NullDevice::destroyPipeline(S_PipelineHandle pipeline) {
+		std::lock_guard lock(objectMutex);
+		if (pipeline.index < pipelines.size() && pipelines[pipeline.index].alive) {
+			pendingReleases.push_back({ frameIndex, pipeline.index, E_ObjectKind::PIPELINE });
+		}
+	}
+
+	void S_NullDevice::releasePending(bool all) {
+		std::lock_guard lock(objectMutex);
+		auto released = std::remove_if(pendingReleases.begin(), pendingReleases.end(), [&](const S_PendingRelease& release) {
+			if (!all && release.frame + FRAMES_IN_FLIGHT > frameIndex) {
+				return false;
+			}
+			switch (release.kind) {
+			case E_ObjectKind::RESOURCE:
+				resources[release.index] = {};
+				freeResources.push_back(release.index);
+				break;
+			case E_ObjectKind::HEAP:
+				heaps[release.index].alive = false;
+				break;
+			case E_ObjectKind::PIPELINE:
+				pipelines[release.index].alive = false;
+				break;
+			}
+			return true;
+			});
+		pendingReleases.erase(released, pendingReleases.end());
+	}
+
+	void S_NullDevice::growRecorders() {
+		// One allocator per job system thread plus the shared one, which stays last
+		const size_t needed = static_cast<size_t>(core::jobs::S_JobSystem::getInstance().getThreadCount()) + 1;
+		while (recorders.size() < needed) {
+			recorders.push_back(std::make_unique<S_ThreadRecorder>());
+		}
+	}
+
+	void S_NullDevice::beginFrame() {
+		growRecorders();
+		++frameIndex;
+		const size_t slot = frameIndex % FRAMES_IN_FLIGHT;
+		for (const std::unique_ptr<S_ThreadRecorder>& recorder : recorders) {
+			recorder->arenas.beginFrame();
+			recorder->listsUsed[slot] = 0;
+		}
+		releasePending(false);
+		frameStats = {};
+		frameStats.frame = frameIndex;
+	}
+
+	void S_NullDevice::endFrame() {
+		uint64_t recordNanoseconds = 0;
+		for (const std::unique_ptr<S_ThreadRecorder>& recorder : recorders) {
+			S_RecordCounters& counters = recorder->counters;
+			frameStats.recordingThreads += counters.commandLists ? 1 : 0;
+			frameStats.commandLists += counters.commandLists;
+			frameStats.commandBytes += counters.commandBytes;
+			frameStats.allocatorBytes += recorder->arenas.current().getReservedBytes();
+			recordNanoseconds += counters.recordNanoseconds;
+			counters = {};
+		}
+		frameStats.recordMilliseconds = static_cast<double>(recordNanoseconds) / 1.0e6;
+		stats = frameStats;
+
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "record", stats.recordMilliseconds);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "submit", stats.submitMilliseconds);
+	}
+
+	I_CommandList* S_NullDevice::beginCommandList(E_QueueType queue) {
+		const int32_t threadIndex = core::jobs::S_JobSystem::getCurrentThreadIndex();
+		const size_t shared = recorders.size() - 1;
+		if (threadIndex >= 0 && static_cast<size_t>(threadIndex) >= shared) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_NullDevice", "beginCommandList",
+				"Job system has more threads than command allocators; call beginFrame() after it starts", threadIndex);
+		}
+		S_ThreadRecorder& recorder = *recorders[threadIndex >= 0 ? static_cast<size_t>(threadIndex) : shared];
+
+		const size_t slot = frameIndex % FRAMES_IN_FLIGHT;
+		std::vector<std::unique_ptr<S_NullCommandList>>& pool = recorder.lists[slot];
+		if (recorder.listsUsed[slot] == pool.size()) {
+			pool.push_back(std::make_unique<S_NullCommandList>());
+		}
+		S_NullCommandList* commandList = pool[recorder.listsUsed[slot]++].get();
+		commandList->reset(queue, recorder.arenas.current(), recorder.counters);
+		return commandList;
+	}
+
+	void S_NullDevice::submit(E_QueueType queue, std::span<I_CommandList* const> lists, std::span<const S_QueueWait> waits,
+		uint64_t signalValue) {
+		const auto start = std::chrono::steady_clock::now();
+		std::lock_guard lock(objectMutex);
+
+		const uint32_t queueIndex = static_cast<uint32_t>(queue);
+		for (const S_QueueWait& wait : waits) {
+			if (wait.value > signaledValues[static_cast<uint32_t>(wait.queue)]) {
+				reportError("Wait for a value not signalled by an earlier submit; the GPU would hang", "submit", wait.value);
+			}
+		}
+		for (I_CommandList* list : lists) {
+			auto* commandList = static_cast<S_NullCommandList*>(list);
+			if (!commandList || !commandList->isClosed() || commandList->isSubmitted() || commandList->getQueue() != queue) {
+				reportError("Submitted list is unclosed, already submitted or for another queue", "submit", queueIndex);
+				continue;
+			}
+			validateList(*commandList);
+			commandList->markSubmitted();
+		}
+		if (signalValue) {
+			if (signalValue <= signaledValues[queueIndex]) {
+				reportError("Signal does not exceed the queue's last signalled value", "submit", signalValue);
+			}
+			signaledValues[queueIndex] = std::max(signaledValues[queueIndex], signalValue);
+		}
+		++frameStats.submits;
+		frameStats.submitMilliseconds += millisecondsSince(start);
+	}
+
+	void S_NullDevice::validateList(const S_NullCommandList& commandList) {
+		const E_QueueType queue = commandList.getQueue();
+		const E_ResourceAccess queueMask = getQueueAccessMask(queue);
+		uint32_t pipeline = INVALID_INDEX;
+		uint32_t markerDepth = 0;
+
+		const auto checkPipeline = [&](E_PipelineType type, const char* command) {
+			if (pipeline == INVALID_INDEX || pipelines[pipeline].desc.type != type) {
+				reportError("No pipeline of the right type bound", command, pipeline);
+			}
+		};
+		const auto checkQueue = [&](bool supported, const char* command) {
+			if (!supported) {
+				reportError("Command not supported by the list's queue", command, static_cast<uint32_t>(queue));
+			}
+		};
+
+		for (const S_CommandSegment* segment = commandList.getFirstSegment(); segment; segment = segment->next) {
+			for (uint32_t offset = 0; offset < segment->used;) {
+				const std::byte* command = segment->data() + offset;
+				S_CommandHeader header;
+				std::memcpy(&header, command, sizeof(header));
+				if (header.size < sizeof(header) || offset + header.size > segment->used) {
+					reportError("Corrupt command stream", "validate", offset);
+					return;
+				}
+				offset += header.size;
+				++frameStats.commands;
+
+				switch (header.op) {
+				case E_CommandOp::BARRIER: {
+					const auto payload = readPayload<S_BarrierCommand>(command);
+					const std::byte* entries = command + sizeof(S_CommandHeader) + sizeof(S_BarrierCommand);
+					for (uint32_t index = 0; index < payload.count; ++index) {
+						S_ResourceBarrier barrier;
+						std::memcpy(&barrier, entries + index * sizeof(S_ResourceBarrier), sizeof(barrier));
+						++frameStats.barriers;
+						if (!checkResource(barrier.resource.index, "barrier")) {
+							continue;
+						}
+						if (barrier.type == E_BarrierType::TRANSITION) {
+							S_NullResource& resource = resources[barrier.resource.index];
+							if (resource.state != barrier.before) {
+								reportError("Transition's before state differs from the resource's state", resource.name.c_str(),
+									static_cast<uint32_t>(resource.state));
+							}
+							if (!isWithin(barrier.before | barrier.after, queueMask)) {
+								reportError("Transition not supported by the list's queue", resource.name.c_str(),
+									static_cast<uint32_t>(barrier.before | barrier.after));
+							}
+							resource.state = barrier.after;
+						}
+						else if (barrier.type == E_BarrierType::ALIASING && barrier.previousResource.isValid()) {
+							checkResource(barrier.previousResource.index, "aliasing barrier");
+						}
+					}
+					break;
+				}
+				case E_CommandOp::SET_PIPELINE: {
+					const auto payload = readPayload<S_SetPipelineCommand>(command);
+					if (payload.pipeline >= pipelines.size() || !pipelines[payload.pipeline].alive) {
+						reportError("Destroyed or unknown pipeline", "setPipeline", payload.pipeline);
+						pipeline = INVALID_INDEX;
+					}
+					else {
+						pipeline = payload.pipeline;
+					}
+					break;
+				}
+				case E_CommandOp::SET_RENDER_TARGETS: {
+					const auto payload = readPayload<S_SetRenderTargetsCommand>(command);
+					const std::byte* colors = command + sizeof(S_CommandHeader) + sizeof(S_SetRenderTargetsCommand);
+					for (uint32_t index = 0; index < payload.count; ++index) {
+						S_ResourceHandle color;
+						std::memcpy(&color, colors + index * sizeof(S_ResourceHandle), sizeof(color));
+						checkResource(color.index, "setRenderTargets");
+					}
+					if (payload.depth != INVALID_INDEX) {
+						checkResource(payload.depth, "setRenderTargets");
+					}
+					checkQueue(queue == E_QueueType::GRAPHICS, "setRenderTargets");
+					break;
+				}
+				case E_CommandOp::CLEAR_RENDER_TARGET:
+				case E_CommandOp::CLEAR_DEPTH: {
+					const bool color = header.op == E_CommandOp::CLEAR_RENDER_TARGET;
+					const uint32_t target = color ? readPayload<S_ClearRenderTargetCommand>(command).target
+						: readPayload<S_ClearDepthCommand>(command).target;
+					if (checkResource(target, "clear")
+						&& resources[target].state != (color ? E_ResourceAccess::RENDER_TARGET : E_ResourceAccess::DEPTH_WRITE)) {
+						reportError("Clear of a resource not in its writable state", resources[target].name.c_str(),
+							static_cast<uint32_t>(resources[target].state));
+					}
+					checkQueue(queue == E_QueueType::GRAPHICS, "clear");
+					break;
+				}
+				case E_CommandOp::SET_VIEWPORT:
+				case E_CommandOp::SET_SCISSOR:
+					checkQueue(queue == E_QueueType::GRAPHICS, "setViewport");
+					break;
+				case E_CommandOp::SET_VERTEX_BUFFER:
+					checkResource(readPayload<S_SetVertexBufferCommand>(command).buffer, "setVertexBuffer");
+					break;
+				case E_CommandOp::SET_INDEX_BUFFER:
+					checkResource(readPayload<S_SetIndexBufferCommand>(command).buffer, "setIndexBuffer");
+					break;
+				case E_CommandOp::SET_RESOURCE:
+					checkResource(readPayload<S_SetResourceCommand>(command).resource, "setResource");
+					break;
+				case E_CommandOp::SET_CONSTANTS: {
+					const auto payload = readPayload<S_SetConstantsCommand>(command);
+					if (pipeline != INVALID_INDEX && payload.offset + payload.count > pipelines[pipeline].desc.constantCount) {
+						reportError("Constants past the pipeline's constant count", "setConstants", payload.offset + payload.count);
+					}
+					break;
+				}
+				case E_CommandOp::DRAW:
+				case E_CommandOp::DRAW_INDEXED:
+				case E_CommandOp::DRAW_INDIRECT:
+					++frameStats.draws;
+					checkPipeline(E_PipelineType::GRAPHICS, "draw");
+					checkQueue(queue == E_QueueType::GRAPHICS, "draw");
+					if (header.op == E_CommandOp::DRAW_INDIRECT) {
+						checkResource(readPayload<S_DrawIndirectCommand>(command).arguments, "drawIndirect");
+					}
+					break;
+				case E_CommandOp::DISPATCH:
+					++frameStats.dispatches;
+					checkPipeline(E_PipelineType::COMPUTE, "dispatch");
+					checkQueue(queue != E_QueueType::COPY, "dispatch");
+					break;
+				case E_CommandOp::COPY_BUFFER: {
+					const auto payload = readPayload<S_CopyBufferCommand>(command);
+					++frameStats.copies;
+					checkResource(payload.destination, "copyBuffer");
+					checkResource(payload.source, "copyBuffer");
+					break;
+				}
+				case E_CommandOp::COPY_TEXTURE: {
+					const auto payload = readPayload<S_CopyTextureCommand>(command);
+					++frameStats.copies;
+					checkResource(payload.destination, "copyTexture");
+					checkResource(payload.source, "copyTexture");
+					break;
+				}
+				case E_CommandOp::BEGIN_MARKER:
+					++markerDepth;
+					break;
+				case E_CommandOp::END_MARKER:
+					if (markerDepth == 0) {
+						reportError("endMarker without beginMarker", "endMarker", 0);
+					}
+					else {
+						--markerDepth;
+					}
+					break;
+				default:
+					reportError("Corrupt command stream", "validate", static_cast<uint32_t>(header.op));
+					return;
+				}
+			}
+		}
+		if (markerDepth != 0) {
+			reportError("List closed with open markers", "close", markerDepth);
+		}
+	}
+
+	bool S_NullDevice::checkResource(uint32_t resource, const char* command) {
+		if (resource >= resources.size() || !resources[resource].alive) {
+			reportError("Destroyed or unknown resource", command, resource);
+			return false;
+		}
+		return true;
+	}
+
+	void S_NullDevice::reportError(const char* message, const char* detail, uint64_t value) {
+		if (++frameStats.validationErrors <= MAX_LOGGED_ERRORS) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_NullDevice", "validation", message, detail, value);
+		}
+	}
+
+	uint64_t S_NullDevice::getSignaledValue(E_QueueType queue) const {
+		return signaledValues[static_cast<uint32_t>(queue)];
+	}
+
+	void S_NullDevice::waitIdle() {
+		releasePending(true);
+	}
+
+	const S_NullDeviceStats& S_NullDevice::getStats() const {
+		return stats;
+	}
+
+	uint32_t S_NullDevice::getLiveResourceCount() const {
+		std::lock_guard lock(objectMutex);
+		return static_cast<uint32_t>(std::count_if(resources.begin(), resources.end(), [](const S_NullResource& resource) {
+			return resource.alive;
+			}));
+	}
+
+	void S_NullDevice::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "recordingThreads", static_cast<double>(stats.recordingThreads));
+		Instrumentation::setGauge(STATS_CATEGORY, "commandLists", static_cast<double>(stats.commandLists));
+		Instrumentation::setGauge(STATS_CATEGORY, "commandBytes", static_cast<double>(stats.commandBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "commands", static_cast<double>(stats.commands));
+		Instrumentation::setGauge(STATS_CATEGORY, "draws", static_cast<double>(stats.draws));
+		Instrumentation::setGauge(STATS_CATEGORY, "dispatches", static_cast<double>(stats.dispatches));
+		Instrumentation::setGauge(STATS_CATEGORY, "barriers", static_cast<double>(stats.barriers));
+		Instrumentation::setGauge(STATS_CATEGORY, "submits", static_cast<double>(stats.submits));
+		Instrumentation::setGauge(STATS_CATEGORY, "validationErrors", static_cast<double>(stats.validationErrors));
+		Instrumentation::setGauge(STATS_CATEGORY, "allocatorBytes", static_cast<double>(stats.allocatorBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "recordMilliseconds", stats.recordMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "submitMilliseconds", stats.submitMilliseconds);
+	}
+}
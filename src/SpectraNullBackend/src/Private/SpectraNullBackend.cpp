@@ -0,0 +1,4 @@
+#include "SpectraNullBackend.h"
+
+void SPECTRA_NULL_BACKEND SpectraNullBackendInit() {
+}
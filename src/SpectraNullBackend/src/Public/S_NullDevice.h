@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SpectraNullBackend.h"
+#include "S_RenderDevice.h"
+
+namespace spectra::backend {
+	class S_NullCommandList;
+	struct S_ThreadRecorder;
+
+	// Totals of the frame last finished by endFrame()
+	struct S_NullDeviceStats {
+		uint64_t frame = 0;
+		uint32_t recordingThreads = 0;  // Threads that recorded at least one list
+		uint64_t commandLists = 0;
+		uint64_t commandBytes = 0;
+		uint64_t commands = 0;          // Counted when submitted, as are the draws onwards
+		uint64_t draws = 0;
+		uint64_t dispatches = 0;
+		uint64_t copies = 0;
+		uint64_t barriers = 0;
+		uint64_t submits = 0;
+		uint64_t validationErrors = 0;
+		uint64_t allocatorBytes = 0;    // Reserved by the frame's command allocators on every thread
+		double recordMilliseconds = 0.0;  // Summed over threads, from beginCommandList() to close()
+		double submitMilliseconds = 0.0;
+	};
+
+	// Backend that executes nothing. Command lists are encoded into compact linear streams in
+	// per-thread, per-frame arenas, so recording costs what a real backend's CPU side costs
+	// minus the driver. submit() walks the streams as a driver would and validates them:
+	// handle lifetimes, barrier states against the tracked state of every resource, pipeline
+	// types and queue capabilities, and timeline waits that could never be satisfied.
+	// Queues complete their work the moment it is submitted.
+	class SPECTRA_NULL_BACKEND S_NullDevice final : public pipeline::I_RenderDevice {
+	public:
+		static constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+
+		S_NullDevice();
+		~S_NullDevice() override;
+		S_NullDevice(const S_NullDevice&) = delete;
+		S_NullDevice& operator=(const S_NullDevice&) = delete;
+
+		[[nodiscard]] const char* getName() const override;
+
+		[[nodiscard]] pipeline::S_ResourceHandle createBuffer(const pipeline::S_BufferDesc& desc, std::string_view name,
+			pipeline::E_ResourceAccess initialAccess = pipeline::E_ResourceAccess::NONE) override;
+		[[nodiscard]] pipeline::S_ResourceHandle createTexture(const pipeline::S_TextureDesc& desc, std::string_view name,
+			pipeline::E_ResourceAccess initialAccess = pipeline::E_ResourceAccess::NONE) override;
+		[[nodiscard]] pipeline::S_HeapHandle createHeap(pipeline::E_HeapCategory category, uint64_t size) override;
+		[[nodiscard]] pipeline::S_ResourceHandle createPlacedBuffer(pipeline::S_HeapHandle heap, uint64_t offset,
+			const pipeline::S_BufferDesc& desc, std::string_view name) override;
+		[[nodiscard]] pipeline::S_ResourceHandle createPlacedTexture(pipeline::S_HeapHandle heap, uint64_t offset,
+			const pipeline::S_TextureDesc& desc, std::string_view name) override;
+		[[nodiscard]] pipeline::S_PipelineHandle createPipeline(const pipeline::S_PipelineDesc& desc) override;
+
+		void destroyResource(pipeline::S_ResourceHandle resource) override;
+		void destroyHeap(pipeline::S_HeapHandle heap) override;
+		void destroyPipeline(pipeline::S_PipelineHandle pipeline) override;
+
+		void beginFrame() override;
+		void endFrame() override;
+
+		// Threads of the job system each use their own allocator; any other thread shares one
+		// more, so at most one thread outside the pool may record at a time
+		[[nodiscard]] pipeline::I_CommandList* beginCommandList(pipeline::E_QueueType queue) override;
+		void submit(pipeline::E_QueueType queue, std::span<pipeline::I_CommandList* const> lists,
+			std::span<const pipeline::S_QueueWait> waits, uint64_t signalValue) override;
+
+		[[nodiscard]] uint64_t getSignaledValue(pipeline::E_QueueType queue) const override;
+		void waitIdle() override;
+
+		[[nodiscard]] const S_NullDeviceStats& getStats() const;
+		[[nodiscard]] uint32_t getLiveResourceCount() const;
+
+		// Pushes the last frame's stats to SpectraInstrumentation under "spectra::backend::null"
+		void publishStats() const;
+
+	private:
+		enum class E_ObjectKind : uint8_t {
+			RESOURCE = 0,
+			HEAP,
+			PIPELINE
+		};
+
+		struct S_NullResource {
+			std::string name;
+			pipeline::E_ResourceKind kind = pipeline::E_ResourceKind::BUFFER;
+			pipeline::S_TextureDesc texture;
+			pipeline::S_BufferDesc buffer;
+			pipeline::E_ResourceAccess state = pipeline::E_ResourceAccess::NONE;  // After the last submitted barrier
+			uint32_t heap = pipeline::INVALID_INDEX;
+			uint64_t offset = 0;
+			bool alive = false;
+		};
+
+		struct S_NullHeap {
+			pipeline::E_HeapCategory category = pipeline::E_HeapCategory::BUFFER;
+			uint64_t size = 0;
+			bool alive = false;
+		};
+
+		struct S_NullPipeline {
+			pipeline::S_PipelineDesc desc;
+			bool alive = false;
+		};
+
+		struct S_PendingRelease {
+			uint64_t frame = 0;
+			uint32_t index = 0;
+			E_ObjectKind kind = E_ObjectKind::RESOURCE;
+		};
+
+		mutable std::mutex objectMutex;  // Guards the object tables below
+		std::vector<S_NullResource> resources;
+		std::vector<uint32_t> freeResources;
+		std::vector<S_NullHeap> heaps;
+		std::vector<S_NullPipeline> pipelines;
+		std::vector<S_PendingRelease> pendingReleases;
+
+		std::vector<std::unique_ptr<S_ThreadRecorder>> recorders;  // Job system threads, then the shared one
+		uint64_t frameIndex = 0;
+		std::array<uint64_t, pipeline::QUEUE_TYPE_COUNT> signaledValues{};
+		S_NullDeviceStats frameStats;  // Being accumulated
+		S_NullDeviceStats stats;       // Of the last finished frame
+
+		pipeline::S_ResourceHandle addResource(S_NullResource resource);
+		void releasePending(bool all);
+		void validateList(const S_NullCommandList& commandList);
+		bool checkResource(uint32_t resource, const char* command);
+		void reportError(const char* message, const char* detail, uint64_t value);
+		void growRecorders();
+	};
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#ifndef SPECTRA_NULL_BACKEND
+#if defined(_WIN32)
+#define SPECTRA_NULL_BACKEND __declspec(dllexport)
+#else
+#define SPECTRA_NULL_BACKEND __attribute__((visibility("default")))
+#endif
+#endif
+
+void SPECTRA_NULL_BACKEND SpectraNullBackendInit();
@@ -0,0 +1,943 @@
+#include "S_Bvh.h"
+#include "S_JobSystem.h"
+#include "S_MemoryTracker.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace spectra::render {
+	using core::math::S_Aabb;
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::bvh";
+
+		constexpr uint32_t MAX_BINS = 64;
+		constexpr uint32_t MAX_LEAF_SIZE = 254;
+
+		// Past this depth nodes split at the object median, which keeps the tree within MAX_DEPTH
+		constexpr uint32_t SAH_DEPTH_LIMIT = 48;
+
+		// Nodes with at least this many references are binned by several jobs
+		constexpr uint32_t PARALLEL_BINNING_THRESHOLD = 1u << 16;
+		constexpr uint32_t MIN_BINNING_BLOCK = 1u << 14;
+
+		std::pmr::memory_resource* geometryResource() {
+			static core::memory::S_TrackedResource resource(core::memory::E_MemoryTag::GEOMETRY);
+			return &resource;
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		struct S_Reference {
+			S_Aabb bounds;
+			uint32_t primitive = 0;
+		};
+
+		struct S_BinaryNode {
+			S_Aabb bounds;
+			uint32_t children[2] = {};
+			uint32_t first = 0;
+			uint32_t count = 0;  // Zero for internal nodes
+		};
+
+		struct S_BuildRange {
+			uint32_t begin = 0;
+			uint32_t end = 0;
+			uint32_t capacityEnd = 0;  // References may be written up to here, the gap after end feeds spatial splits
+			uint32_t depth = 0;
+			S_Aabb bounds;
+			S_Aabb centroidBounds;
+		};
+
+		struct S_Bin {
+			S_Aabb bounds;
+			uint32_t count = 0;  // Object bins: references; spatial bins: references starting here
+			uint32_t exits = 0;  // Spatial bins: references ending here
+		};
+
+		struct S_BinSet {
+			S_Bin bins[3][MAX_BINS];
+
+			void reset(uint32_t binCount) {
+				for (auto& axisBins : bins) {
+					std::fill_n(axisBins, binCount, S_Bin{});
+				}
+			}
+		};
+
+		struct S_Split {
+			float cost = std::numeric_limits<float>::infinity();
+			int axis = -1;
+			uint32_t bin = 0;         // Left side holds bins [0, bin]
+			bool spatial = false;
+			float position = 0.0f;    // Plane of a spatial split
+			uint32_t leftCount = 0;
+			uint32_t rightCount = 0;
+			S_Aabb leftBounds;
+			S_Aabb rightBounds;
+		};
+
+		// Maps centroids to bins over a node's centroid bounds
+		struct S_BinMapping {
+			S_Vec3 origin;
+			S_Vec3 scale;  // Zero on axes where all centroids coincide
+			int binCount = 0;
+
+			S_BinMapping(const S_Aabb& centroidBounds, uint32_t binCount) : origin(centroidBounds.min), binCount(static_cast<int>(binCount)) {
+				const S_Vec3 extent = centroidBounds.extent();
+				for (int axis = 0; axis < 3; ++axis) {
+					scale[axis] = extent[axis] > 0.0f ? static_cast<float>(binCount) * (1.0f - 1e-5f) / extent[axis] : 0.0f;
+				}
+			}
+
+			[[nodiscard]] uint32_t bin(const S_Vec3& centroid, int axis) const {
+				const int index = static_cast<int>((centroid[axis] - origin[axis]) * scale[axis]);
+				return static_cast<uint32_t>(std::clamp(index, 0, binCount - 1));
+			}
+		};
+
+		// Equal-width bins over a node's bounds for spatial splits
+		struct S_SpatialBins {
+			S_Vec3 origin;
+			S_Vec3 size;
+			S_Vec3 inverseSize;
+			int binCount = 0;
+
+			S_SpatialBins(const S_Aabb& bounds, uint32_t binCount)
+				: origin(bounds.min), size(bounds.extent() / static_cast<float>(binCount)), binCount(static_cast<int>(binCount)) {
+				for (int axis = 0; axis < 3; ++axis) {
+					inverseSize[axis] = size[axis] > 0.0f ? 1.0f / size[axis] : 0.0f;
+				}
+			}
+
+			[[nodiscard]] uint32_t bin(float value, int axis) const {
+				return static_cast<uint32_t>(std::clamp(static_cast<int>((value - origin[axis]) * inverseSize[axis]), 0, binCount - 1));
+			}
+
+			// Plane between bin and bin + 1
+			[[nodiscard]] float plane(uint32_t bin, int axis) const {
+				return origin[axis] + size[axis] * static_cast<float>(bin + 1);
+			}
+		};
+
+		void computeRangeBounds(const S_Reference* references, uint32_t begin, uint32_t end, S_Aabb& bounds, S_Aabb& centroidBounds) {
+			bounds = {};
+			centroidBounds = {};
+			for (uint32_t i = begin; i < end; ++i) {
+				bounds.extend(references[i].bounds);
+				centroidBounds.extend(references[i].bounds.centroid());
+			}
+		}
+
+		// Binary SAH builder. Children of large nodes are built as separate jobs; every node
+		// owns a slice of the reference array plus some slack for spatial split duplicates.
+		class S_BinaryBuilder {
+		public:
+			S_BinaryBuilder(std::span<const S_Aabb> primitiveBounds, const S_BvhBuildSettings& settings, const BvhSplitFunction& splitPrimitive)
+				: primitiveBounds(primitiveBounds), settings(settings), splitPrimitive(splitPrimitive) {}
+
+			std::vector<S_Reference> references;
+			std::unique_ptr<S_BinaryNode[]> nodes;
+			std::atomic<uint32_t> nodeCount{ 0 };
+			std::atomic<uint32_t> spatialSplitCount{ 0 };
+
+			uint32_t build() {
+				auto& jobSystem = core::jobs::S_JobSystem::getInstance();
+				const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+				const uint32_t capacity = settings.spatialSplits
+					? primitiveCount + static_cast<uint32_t>(static_cast<float>(primitiveCount) * std::max(settings.spatialSplitBudget, 0.0f))
+					: primitiveCount;
+
+				references.resize(capacity);
+				nodes = std::make_unique_for_overwrite<S_BinaryNode[]>(2 * static_cast<size_t>(capacity));
+
+				S_BuildRange root{ 0, primitiveCount, capacity, 0, {}, {} };
+				std::mutex rootMutex;
+				jobSystem.parallelFor(0, primitiveCount, [&](size_t begin, size_t end) {
+					S_Aabb bounds;
+					S_Aabb centroidBounds;
+					for (size_t i = begin; i < end; ++i) {
+						references[i] = { primitiveBounds[i], static_cast<uint32_t>(i) };
+						bounds.extend(primitiveBounds[i]);
+						centroidBounds.extend(primitiveBounds[i].centroid());
+					}
+					std::lock_guard lock(rootMutex);
+					root.bounds.extend(bounds);
+					root.centroidBounds.extend(centroidBounds);
+				}, MIN_BINNING_BLOCK);
+
+				rootArea = root.bounds.surfaceArea();
+				const uint32_t rootIndex = nodeCount.fetch_add(1);
+				auto binScratch = std::make_unique<S_BinSet>();
+				buildNode(rootIndex, root, *binScratch);
+				return rootIndex;
+			}
+
+		private:
+			std::span<const S_Aabb> primitiveBounds;
+			const S_BvhBuildSettings& settings;
+			const BvhSplitFunction& splitPrimitive;
+			float rootArea = 0.0f;
+
+			void makeLeaf(S_BinaryNode& node, const S_BuildRange& range) {
+				node.first = range.begin;
+				node.count = range.end - range.begin;
+			}
+
+			// binScratch is reused down the subtree built on this call stack; jobs bring their own
+			void buildNode(uint32_t nodeIndex, const S_BuildRange& range, S_BinSet& binScratch) {
+				S_BinaryNode& node = nodes[nodeIndex];
+				node.bounds = range.bounds;
+				const uint32_t count = range.end - range.begin;
+				if (count == 1) {
+					makeLeaf(node, range);
+					return;
+				}
+
+				S_Split split;
+				if (range.depth < SAH_DEPTH_LIMIT) {
+					split = findObjectSplit(range, binScratch);
+					const bool hasSlack = range.capacityEnd > range.end;
+					if (settings.spatialSplits && hasSlack && split.axis >= 0) {
+						const float overlap = split.leftBounds.intersection(split.rightBounds).surfaceArea();
+						if (overlap > settings.spatialSplitOverlap * rootArea) {
+							const S_Split spatial = findSpatialSplit(range);
+							if (spatial.cost < split.cost && spatial.leftCount + spatial.rightCount <= range.capacityEnd - range.begin) {
+								split = spatial;
+							}
+						}
+					}
+				}
+
+				const float leafCost = settings.intersectionCost * static_cast<float>(count);
+				if (count <= settings.maxLeafSize && !(split.cost < leafCost)) {
+					makeLeaf(node, range);
+					return;
+				}
+
+				S_BuildRange left;
+				S_BuildRange right;
+				if (split.axis < 0 || !(split.spatial ? partitionSpatial(range, split, left, right) : partitionObject(range, split, left, right))) {
+					partitionMedian(range, left, right);
+				}
+
+				const uint32_t leftIndex = nodeCount.fetch_add(2);
+				const uint32_t rightIndex = leftIndex + 1;
+				node.children[0] = leftIndex;
+				node.children[1] = rightIndex;
+				node.count = 0;
+
+				auto& jobSystem = core::jobs::S_JobSystem::getInstance();
+				if (count >= settings.parallelThreshold && jobSystem.isRunning()) {
+					core::jobs::S_Counter counter;
+					jobSystem.run([this, leftIndex, left] {
+						auto jobScratch = std::make_unique<S_BinSet>();
+						buildNode(leftIndex, left, *jobScratch);
+					}, &counter);
+					// The left job references this frame, so it must finish before an exception leaves it
+					std::exception_ptr failure;
+					try {
+						buildNode(rightIndex, right, binScratch);
+					}
+					catch (...) {
+						failure = std::current_exception();
+					}
+					jobSystem.waitForCounter(counter);
+					if (failure) {
+						std::rethrow_exception(failure);
+					}
+				}
+				else {
+					buildNode(leftIndex, left, binScratch);
+					buildNode(rightIndex, right, binScratch);
+				}
+			}
+
+			// Small nodes use fewer bins, they cannot fill more and resetting them dominates
+			[[nodiscard]] uint32_t objectBinCount(uint32_t count) const {
+				return std::min(settings.binCount, std::max(4u, count));
+			}
+
+			void binObjects(const S_BinMapping& mapping, uint32_t begin, uint32_t end, S_BinSet& binSet) const {
+				// Local copy so the compiler need not reload the mapping after every bin store
+				const S_BinMapping local = mapping;
+				for (uint32_t i = begin; i < end; ++i) {
+					const S_Aabb bounds = references[i].bounds;
+					const S_Vec3 centroid = bounds.centroid();
+					const uint32_t binX = local.bin(centroid, 0);
+					const uint32_t binY = local.bin(centroid, 1);
+					const uint32_t binZ = local.bin(centroid, 2);
+					binSet.bins[0][binX].bounds.extend(bounds);
+					++binSet.bins[0][binX].count;
+					binSet.bins[1][binY].bounds.extend(bounds);
+					++binSet.bins[1][binY].count;
+					binSet.bins[2][binZ].bounds.extend(bounds);
+					++binSet.bins[2][binZ].count;
+				}
+			}
+
+			S_Split findObjectSplit(const S_BuildRange& range, S_BinSet& binSet) const {
+				const uint32_t count = range.end - range.begin;
+				const uint32_t binCount = objectBinCount(count);
+				const S_BinMapping mapping(range.centroidBounds, binCount);
+
+				binSet.reset(binCount);
+				auto& jobSystem = core::jobs::S_JobSystem::getInstance();
+				if (count >= PARALLEL_BINNING_THRESHOLD && jobSystem.isRunning()) {
+					const uint32_t blockSize = std::max(MIN_BINNING_BLOCK, count / (jobSystem.getThreadCount() * 4));
+					const uint32_t blockCount = (count + blockSize - 1) / blockSize;
+					std::vector<S_BinSet> partial(blockCount);
+					jobSystem.parallelFor(0, blockCount, [&](size_t firstBlock, size_t lastBlock) {
+						for (size_t block = firstBlock; block < lastBlock; ++block) {
+							const uint32_t begin = range.begin + static_cast<uint32_t>(block) * blockSize;
+							binObjects(mapping, begin, std::min(begin + blockSize, range.end), partial[block]);
+						}
+					});
+					for (const S_BinSet& set : partial) {
+						for (int axis = 0; axis < 3; ++axis) {
+							for (uint32_t i = 0; i < binCount; ++i) {
+								binSet.bins[axis][i].bounds.extend(set.bins[axis][i].bounds);
+								binSet.bins[axis][i].count += set.bins[axis][i].count;
+							}
+						}
+					}
+				}
+				else {
+					binObjects(mapping, range.begin, range.end, binSet);
+				}
+
+				S_Split best;
+				for (int axis = 0; axis < 3; ++axis) {
+					if (mapping.scale[axis] == 0.0f) {
+						continue;
+					}
+					sweepBins(binSet.bins[axis], binCount, false, range.bounds, axis, best);
+				}
+				return best;
+			}
+
+			// Evaluates every plane between bins, keeping the split if it beats best
+			void sweepBins(const S_Bin* bins, uint32_t binCount, bool spatial, const S_Aabb& nodeBounds, int axis, S_Split& best) const {
+				float rightAreas[MAX_BINS];
+				uint32_t rightCounts[MAX_BINS];
+				S_Aabb accumulated;
+				uint32_t accumulatedCount = 0;
+				for (uint32_t i = binCount - 1; i > 0; --i) {
+					accumulated.extend(bins[i].bounds);
+					accumulatedCount += spatial ? bins[i].exits : bins[i].count;
+					rightAreas[i] = accumulated.surfaceArea();
+					rightCounts[i] = accumulatedCount;
+				}
+
+				const float area = nodeBounds.surfaceArea();
+				const float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+				const float previousCost = best.cost;
+				accumulated = {};
+				accumulatedCount = 0;
+				for (uint32_t i = 0; i + 1 < binCount; ++i) {
+					accumulated.extend(bins[i].bounds);
+					accumulatedCount += bins[i].count;
+					const uint32_t rightCount = rightCounts[i + 1];
+					if (accumulatedCount == 0 || rightCount == 0) {
+						continue;
+					}
+
+					const float cost = settings.traversalCost + settings.intersectionCost * inverseArea
+						* (accumulated.surfaceArea() * static_cast<float>(accumulatedCount) + rightAreas[i + 1] * static_cast<float>(rightCount));
+					if (cost < best.cost) {
+						best.cost = cost;
+						best.axis = axis;
+						best.bin = i;
+						best.spatial = spatial;
+						best.leftCount = accumulatedCount;
+						best.rightCount = rightCount;
+					}
+				}
+
+				// Child boxes only for the winner, most sweeps do not improve on the previous axis
+				if (best.cost < previousCost) {
+					best.leftBounds = {};
+					best.rightBounds = {};
+					for (uint32_t i = 0; i < binCount; ++i) {
+						(i <= best.bin ? best.leftBounds : best.rightBounds).extend(bins[i].bounds);
+					}
+				}
+			}
+
+			void splitReference(const S_Reference& reference, const S_Aabb& clip, int axis, float position, S_Aabb& left, S_Aabb& right) const {
+				if (splitPrimitive) {
+					splitPrimitive(reference.primitive, clip, axis, position, left, right);
+					return;
+				}
+				left = clip;
+				right = clip;
+				left.max[axis] = std::min(left.max[axis], position);
+				right.min[axis] = std::max(right.min[axis], position);
+			}
+
+			// Bins references by the spatial extent they cover, clipping each to the bins it spans
+			S_Split findSpatialSplit(const S_BuildRange& range) const {
+				const S_SpatialBins spatialBins(range.bounds, settings.binCount);
+
+				S_Split best;
+				auto bins = std::make_unique<S_Bin[]>(settings.binCount);
+				for (int axis = 0; axis < 3; ++axis) {
+					if (!(spatialBins.size[axis] > 0.0f)) {
+						continue;
+					}
+					std::fill_n(bins.get(), settings.binCount, S_Bin{});
+					for (uint32_t i = range.begin; i < range.end; ++i) {
+						const S_Reference& reference = references[i];
+						const uint32_t firstBin = spatialBins.bin(reference.bounds.min[axis], axis);
+						const uint32_t lastBin = std::max(firstBin, spatialBins.bin(reference.bounds.max[axis], axis));
+						S_Aabb remaining = reference.bounds;
+						for (uint32_t bin = firstBin; bin < lastBin; ++bin) {
+							S_Aabb left;
+							S_Aabb right;
+							splitReference(reference, remaining, axis, spatialBins.plane(bin, axis), left, right);
+							bins[bin].bounds.extend(left);
+							remaining = right;
+						}
+						bins[lastBin].bounds.extend(remaining);
+						++bins[firstBin].count;
+						++bins[lastBin].exits;
+					}
+
+					const float previousCost = best.cost;
+					sweepBins(bins.get(), settings.binCount, true, range.bounds, axis, best);
+					if (best.cost < previousCost) {
+						best.position = spatialBins.plane(best.bin, axis);
+					}
+				}
+				return best;
+			}
+
+			// Hands the slack after range.end to the children in proportion to their size
+			void distributeSlack(const S_BuildRange& range, uint32_t leftCount, uint32_t rightCount, uint32_t& rightBegin) {
+				const uint32_t slack = range.capacityEnd - range.begin - leftCount - rightCount;
+				const uint32_t leftSlack = static_cast<uint32_t>(static_cast<uint64_t>(slack) * leftCount / (leftCount + rightCount));
+				const uint32_t middle = range.begin + leftCount;
+				rightBegin = middle + leftSlack;
+				if (leftSlack > 0 && rightBegin != middle) {
+					std::copy_backward(references.begin() + middle, references.begin() + middle + rightCount, references.begin() + rightBegin + rightCount);
+				}
+			}
+
+			void finishChildren(const S_BuildRange& range, uint32_t leftCount, uint32_t rightBegin, uint32_t rightCount, S_BuildRange& left, S_BuildRange& right) {
+				left = { range.begin, range.begin + leftCount, rightBegin, range.depth + 1, {}, {} };
+				right = { rightBegin, rightBegin + rightCount, range.capacityEnd, range.depth + 1, {}, {} };
+				computeRangeBounds(references.data(), left.begin, left.end, left.bounds, left.centroidBounds);
+				computeRangeBounds(references.data(), right.begin, right.end, right.bounds, right.centroidBounds);
+			}
+
+			bool partitionObject(const S_BuildRange& range, const S_Split& split, S_BuildRange& left, S_BuildRange& right) {
+				const S_BinMapping mapping(range.centroidBounds, objectBinCount(range.end - range.begin));
+				const auto middle = std::partition(references.begin() + range.begin, references.begin() + range.end, [&](const S_Reference& reference) {
+					return mapping.bin(reference.bounds.centroid(), split.axis) <= split.bin;
+				});
+
+				const uint32_t leftCount = static_cast<uint32_t>(middle - references.begin()) - range.begin;
+				const uint32_t rightCount = range.end - range.begin - leftCount;
+				if (leftCount == 0 || rightCount == 0) {
+					return false;
+				}
+
+				uint32_t rightBegin;
+				distributeSlack(range, leftCount, rightCount, rightBegin);
+				finishChildren(range, leftCount, rightBegin, rightCount, left, right);
+				return true;
+			}
+
+			bool partitionSpatial(const S_BuildRange& range, const S_Split& split, S_BuildRange& left, S_BuildRange& right) {
+				const int axis = split.axis;
+				std::vector<S_Reference> rightReferences;
+				rightReferences.reserve(split.rightCount);
+
+				// Classified with the same bins as the search, so the counts never exceed the ones it
+				// checked against the slack. Each reference writes at most one left entry, which keeps
+				// the write cursor behind the read cursor.
+				const S_SpatialBins spatialBins(range.bounds, settings.binCount);
+				uint32_t write = range.begin;
+				for (uint32_t read = range.begin; read < range.end; ++read) {
+					const S_Reference reference = references[read];
+					const uint32_t firstBin = spatialBins.bin(reference.bounds.min[axis], axis);
+					const uint32_t lastBin = std::max(firstBin, spatialBins.bin(reference.bounds.max[axis], axis));
+					if (lastBin <= split.bin) {
+						references[write++] = reference;
+					}
+					else if (firstBin > split.bin) {
+						rightReferences.push_back(reference);
+					}
+					else {
+						S_Aabb leftBounds;
+						S_Aabb rightBounds;
+						splitReference(reference, reference.bounds, axis, split.position, leftBounds, rightBounds);
+						if (!leftBounds.isEmpty()) {
+							references[write++] = { leftBounds, reference.primitive };
+						}
+						if (!rightBounds.isEmpty()) {
+							rightReferences.push_back({ rightBounds, reference.primitive });
+						}
+					}
+				}
+
+				const uint32_t leftCount = write - range.begin;
+				const uint32_t rightCount = static_cast<uint32_t>(rightReferences.size());
+				if (leftCount == 0 || rightCount == 0) {
+					// Clipping emptied one side; put the references back together and let the caller fall back
+					std::copy(rightReferences.begin(), rightReferences.end(), references.begin() + write);
+					return false;
+				}
+
+				const uint32_t slack = range.capacityEnd - range.begin - leftCount - rightCount;
+				const uint32_t rightBegin = range.begin + leftCount
+					+ static_cast<uint32_t>(static_cast<uint64_t>(slack) * leftCount / (leftCount + rightCount));
+				std::copy(rightReferences.begin(), rightReferences.end(), references.begin() + rightBegin);
+				spatialSplitCount.fetch_add(1, std::memory_order_relaxed);
+				finishChildren(range, leftCount, rightBegin, rightCount, left, right);
+				return true;
+			}
+
+			void partitionMedian(const S_BuildRange& range, S_BuildRange& left, S_BuildRange& right) {
+				const int axis = range.centroidBounds.largestAxis();
+				const uint32_t middle = range.begin + (range.end - range.begin) / 2;
+				std::nth_element(references.begin() + range.begin, references.begin() + middle, references.begin() + range.end,
+					[axis](const S_Reference& a, const S_Reference& b) { return a.bounds.centroid()[axis] < b.bounds.centroid()[axis]; });
+
+				const uint32_t leftCount = middle - range.begin;
+				const uint32_t rightCount = range.end - middle;
+				uint32_t rightBegin;
+				distributeSlack(range, leftCount, rightCount, rightBegin);
+				finishChildren(range, leftCount, rightBegin, rightCount, left, right);
+			}
+		};
+
+		// Snaps child bounds outwards onto an 8-bit grid with a power-of-two step per axis
+		template<uint32_t N>
+		void quantizeChildren(S_WideBvhNode<N>& node, const S_Aabb* childBounds, uint32_t childCount) {
+			S_Aabb total;
+			for (uint32_t i = 0; i < childCount; ++i) {
+				total.extend(childBounds[i]);
+			}
+
+			for (int axis = 0; axis < 3; ++axis) {
+				const float origin = total.min[axis];
+				const float extent = total.max[axis] - origin;
+				int exponent = -126;
+				if (extent > 0.0f) {
+					std::frexp(extent / 255.0f, &exponent);
+				}
+				exponent = std::clamp(exponent, -126, 127);
+				node.origin[axis] = origin;
+				node.exponent[axis] = static_cast<int8_t>(exponent);
+				while (exponent < 127 && origin + 255.0f * node.scale(axis) < total.max[axis]) {
+					node.exponent[axis] = static_cast<int8_t>(++exponent);
+				}
+
+				const float step = node.scale(axis);
+				for (uint32_t i = 0; i < childCount; ++i) {
+					int lower = std::clamp(static_cast<int>(std::floor((childBounds[i].min[axis] - origin) / step)), 0, 255);
+					while (lower > 0 && origin + static_cast<float>(lower) * step > childBounds[i].min[axis]) {
+						--lower;
+					}
+					int upper = std::clamp(static_cast<int>(std::ceil((childBounds[i].max[axis] - origin) / step)), 0, 255);
+					while (upper < 255 && origin + static_cast<float>(upper) * step < childBounds[i].max[axis]) {
+						++upper;
+					}
+					node.lower[axis][i] = static_cast<uint8_t>(lower);
+					node.upper[axis][i] = static_cast<uint8_t>(upper);
+				}
+				for (uint32_t i = childCount; i < N; ++i) {
+					node.lower[axis][i] = 0;
+					node.upper[axis][i] = 0;
+				}
+			}
+		}
+
+		// Turns the binary tree into N-wide nodes by repeatedly opening the largest internal child
+		template<uint32_t N>
+		class S_WideCollapser {
+		public:
+			S_WideCollapser(const S_BinaryBuilder& builder, const S_BvhBuildSettings& settings, std::pmr::vector<S_WideBvhNode<N>>& nodes,
+				std::pmr::vector<uint32_t>& primitiveIndices, std::pmr::vector<S_Aabb>& nodeBounds, float rootArea)
+				: builder(builder), settings(settings), nodes(nodes), primitiveIndices(primitiveIndices), nodeBounds(nodeBounds),
+				inverseRootArea(rootArea > 0.0f ? 1.0f / rootArea : 0.0f) {}
+
+			uint32_t leafCount = 0;
+			uint32_t maxDepth = 0;
+			double sahCost = 0.0;
+
+			uint32_t emit(uint32_t binaryIndex, uint32_t depth) {
+				const S_BinaryNode* binary = builder.nodes.get();
+				uint32_t children[N];
+				uint32_t childCount = 0;
+				if (binary[binaryIndex].count > 0) {
+					children[childCount++] = binaryIndex;
+				}
+				else {
+					children[childCount++] = binary[binaryIndex].children[0];
+					children[childCount++] = binary[binaryIndex].children[1];
+				}
+
+				while (childCount < N) {
+					int largest = -1;
+					float largestArea = -1.0f;
+					for (uint32_t i = 0; i < childCount; ++i) {
+						const S_BinaryNode& child = binary[children[i]];
+						if (child.count == 0 && child.bounds.surfaceArea() > largestArea) {
+							largest = static_cast<int>(i);
+							largestArea = child.bounds.surfaceArea();
+						}
+					}
+					if (largest < 0) {
+						break;
+					}
+					const S_BinaryNode& opened = binary[children[largest]];
+					children[largest] = opened.children[0];
+					children[childCount++] = opened.children[1];
+				}
+
+				const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+				nodes.emplace_back();
+				nodeBounds.push_back(binary[binaryIndex].bounds);
+				maxDepth = std::max(maxDepth, depth + 1);
+				sahCost += settings.traversalCost * binary[binaryIndex].bounds.surfaceArea() * inverseRootArea;
+
+				S_WideBvhNode<N> wide{};
+				S_Aabb childBounds[N];
+				wide.childCount = static_cast<uint8_t>(childCount);
+				for (uint32_t i = 0; i < childCount; ++i) {
+					const S_BinaryNode& child = binary[children[i]];
+					childBounds[i] = child.bounds;
+					if (child.count > 0) {
+						wide.child[i] = static_cast<uint32_t>(primitiveIndices.size());
+						wide.childType[i] = static_cast<uint8_t>(child.count);
+						for (uint32_t reference = child.first; reference < child.first + child.count; ++reference) {
+							primitiveIndices.push_back(builder.references[reference].primitive);
+						}
+						++leafCount;
+						sahCost += settings.intersectionCost * static_cast<float>(child.count) * child.bounds.surfaceArea() * inverseRootArea;
+					}
+					else {
+						wide.childType[i] = S_WideBvhNode<N>::INTERNAL_CHILD;
+						wide.child[i] = emit(children[i], depth + 1);
+					}
+				}
+				quantizeChildren(wide, childBounds, childCount);
+				nodes[nodeIndex] = wide;
+				return nodeIndex;
+			}
+
+		private:
+			const S_BinaryBuilder& builder;
+			const S_BvhBuildSettings& settings;
+			std::pmr::vector<S_WideBvhNode<N>>& nodes;
+			std::pmr::vector<uint32_t>& primitiveIndices;
+			std::pmr::vector<S_Aabb>& nodeBounds;
+			float inverseRootArea;
+		};
+	}
+
+	// S_Bvh implementations
+	S_Bvh::S_Bvh() : nodes4(geometryResource()), nodes8(geometryResource()), primitiveIndices(geometryResource()), nodeBounds(geometryResource()) {}
+
+	void S_Bvh::build(std::span<const S_Aabb> primitiveBounds, const S_BvhBuildSettings& settings, const BvhSplitFunction& splitPrimitive) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (settings.width != E_BvhWidth::WIDE_4 && settings.width != E_BvhWidth::WIDE_8) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Bvh", "build", "Unsupported width", static_cast<uint32_t>(settings.width));
+		}
+		if (settings.binCount < 2 || settings.binCount > MAX_BINS || settings.maxLeafSize == 0 || settings.maxLeafSize > MAX_LEAF_SIZE) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Bvh", "build", "Bin count must be in [2, 64] and leaf size in [1, 254]",
+				settings.binCount, settings.maxLeafSize);
+		}
+		if (primitiveBounds.size() >= std::numeric_limits<uint32_t>::max() / 4) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Bvh", "build", "Too many primitives", static_cast<uint64_t>(primitiveBounds.size()));
+		}
+
+		clear();
+		const auto start = std::chrono::steady_clock::now();
+		width = settings.width;
+		primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+		stats.primitiveCount = primitiveCount;
+
+		if (primitiveCount > 0) {
+			S_BinaryBuilder builder(primitiveBounds, settings, splitPrimitive);
+			const uint32_t root = builder.build();
+			bounds = builder.nodes[root].bounds;
+			primitiveIndices.reserve(builder.references.size());
+
+			const float rootArea = bounds.surfaceArea();
+			const auto collapse = [&](auto& nodes, auto collapser) {
+				nodes.reserve(builder.nodeCount.load() / 2 + 1);
+				collapser.emit(root, 0);
+				stats.leafCount = collapser.leafCount;
+				stats.maxDepth = collapser.maxDepth;
+				stats.sahCost = static_cast<float>(collapser.sahCost);
+			};
+			if (width == E_BvhWidth::WIDE_8) {
+				collapse(nodes8, S_WideCollapser<8>(builder, settings, nodes8, primitiveIndices, nodeBounds, rootArea));
+			}
+			else {
+				collapse(nodes4, S_WideCollapser<4>(builder, settings, nodes4, primitiveIndices, nodeBounds, rootArea));
+			}
+			nodes4.shrink_to_fit();
+			nodes8.shrink_to_fit();
+			primitiveIndices.shrink_to_fit();
+			stats.spatialSplitCount = builder.spatialSplitCount.load();
+			// Split references are bounded by their clipped part, tighter than a refit sees them;
+			// the first partial refit starts from a full one instead
+			if (stats.spatialSplitCount > 0) {
+				nodeBounds.clear();
+			}
+			nodeBounds.shrink_to_fit();
+		}
+
+		built = true;
+		stats.buildMilliseconds = millisecondsSince(start);
+		stats.referenceCount = static_cast<uint32_t>(primitiveIndices.size());
+		stats.nodeCount = static_cast<uint32_t>(width == E_BvhWidth::WIDE_8 ? nodes8.size() : nodes4.size());
+		stats.nodeBytes = nodes4.size() * sizeof(S_WideBvhNode<4>) + nodes8.size() * sizeof(S_WideBvhNode<8>);
+		stats.indexBytes = primitiveIndices.size() * sizeof(uint32_t);
+		stats.bytesPerPrimitive = primitiveCount > 0 ? static_cast<double>(stats.nodeBytes + stats.indexBytes) / primitiveCount : 0.0;
+
+		Instrumentation::recordTiming(STATS_CATEGORY, "build", stats.buildMilliseconds);
+		Instrumentation::logRender(E_LogLevel::INFO, "S_Bvh", "build", "Built BVH", primitiveCount, stats.nodeCount, stats.buildMilliseconds);
+	}
+
+	template<uint32_t N>
+	void S_Bvh::refitNodes(std::pmr::vector<S_WideBvhNode<N>>& nodes, std::span<const S_Aabb> primitiveBounds) {
+		std::vector<S_Aabb> childBounds(nodes.size() * N);
+		nodeBounds.assign(nodes.size(), S_Aabb{});
+
+		// Leaves are independent; internal children depend on their subtree, and since children
+		// always follow their parent in the array a reverse sweep sees them first
+		core::jobs::S_JobSystem::getInstance().parallelFor(0, nodes.size(), [&](size_t begin, size_t end) {
+			for (size_t nodeIndex = begin; nodeIndex < end; ++nodeIndex) {
+				const S_WideBvhNode<N>& node = nodes[nodeIndex];
+				for (uint32_t i = 0; i < node.childCount; ++i) {
+					if (node.childType[i] == S_WideBvhNode<N>::INTERNAL_CHILD) {
+						continue;
+					}
+					S_Aabb leafBounds;
+					for (uint32_t entry = node.child[i]; entry < node.child[i] + node.childType[i]; ++entry) {
+						leafBounds.extend(primitiveBounds[primitiveIndices[entry]]);
+					}
+					childBounds[nodeIndex * N + i] = leafBounds;
+				}
+			}
+		}, 256);
+
+		for (size_t nodeIndex = nodes.size(); nodeIndex-- > 0;) {
+			S_WideBvhNode<N>& node = nodes[nodeIndex];
+			S_Aabb* children = &childBounds[nodeIndex * N];
+			for (uint32_t i = 0; i < node.childCount; ++i) {
+				if (node.childType[i] == S_WideBvhNode<N>::INTERNAL_CHILD) {
+					children[i] = nodeBounds[node.child[i]];
+				}
+				nodeBounds[nodeIndex].extend(children[i]);
+			}
+			quantizeChildren(node, children, node.childCount);
+		}
+		bounds = nodes.empty() ? S_Aabb{} : nodeBounds[0];
+		stats.refitNodeCount = static_cast<uint32_t>(nodes.size());
+	}
+
+	template<uint32_t N>
+	void S_Bvh::refitDirtyNodes(std::pmr::vector<S_WideBvhNode<N>>& nodes, std::span<const S_Aabb> primitiveBounds,
+		std::span<const uint8_t> dirtyPrimitives) {
+		// Same reverse sweep as a full refit, skipping nodes with nothing dirty below them
+		std::vector<uint8_t> dirtyNodes(nodes.size(), 0);
+		uint32_t refitted = 0;
+		for (size_t nodeIndex = nodes.size(); nodeIndex-- > 0;) {
+			S_WideBvhNode<N>& node = nodes[nodeIndex];
+			bool dirty = false;
+			for (uint32_t i = 0; i < node.childCount && !dirty; ++i) {
+				if (node.childType[i] == S_WideBvhNode<N>::INTERNAL_CHILD) {
+					dirty = dirtyNodes[node.child[i]] != 0;
+					continue;
+				}
+				for (uint32_t entry = node.child[i]; entry < node.child[i] + node.childType[i] && !dirty; ++entry) {
+					dirty = dirtyPrimitives[primitiveIndices[entry]] != 0;
+				}
+			}
+			if (!dirty) {
+				continue;
+			}
+
+			S_Aabb children[N];
+			S_Aabb merged;
+			for (uint32_t i = 0; i < node.childCount; ++i) {
+				if (node.childType[i] == S_WideBvhNode<N>::INTERNAL_CHILD) {
+					children[i] = nodeBounds[node.child[i]];
+				}
+				else {
+					for (uint32_t entry = node.child[i]; entry < node.child[i] + node.childType[i]; ++entry) {
+						children[i].extend(primitiveBounds[primitiveIndices[entry]]);
+					}
+				}
+				merged.extend(children[i]);
+			}
+			quantizeChildren(node, children, node.childCount);
+			nodeBounds[nodeIndex] = merged;
+			dirtyNodes[nodeIndex] = 1;
+			++refitted;
+		}
+		bounds = nodes.empty() ? S_Aabb{} : nodeBounds[0];
+		stats.refitNodeCount = refitted;
+	}
+
+	void S_Bvh::refit(std::span<const S_Aabb> primitiveBounds) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (!built || primitiveBounds.size() != primitiveCount) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Bvh", "refit", "Refit needs a built tree over the same primitives",
+				primitiveCount, static_cast<uint64_t>(primitiveBounds.size()));
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		if (width == E_BvhWidth::WIDE_8) {
+			refitNodes(nodes8, primitiveBounds);
+		}
+		else {
+			refitNodes(nodes4, primitiveBounds);
+		}
+		stats.refitMilliseconds = millisecondsSince(start);
+		Instrumentation::recordTiming(STATS_CATEGORY, "refit", stats.refitMilliseconds);
+	}
+
+	void S_Bvh::refit(std::span<const S_Aabb> primitiveBounds, std::span<const uint8_t> dirtyPrimitives) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (dirtyPrimitives.size() != primitiveBounds.size()) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Bvh", "refit", "Need one dirty flag per primitive",
+				static_cast<uint64_t>(dirtyPrimitives.size()), static_cast<uint64_t>(primitiveBounds.size()));
+		}
+		const size_t nodeCount = width == E_BvhWidth::WIDE_8 ? nodes8.size() : nodes4.size();
+		if (!built || nodeBounds.size() != nodeCount) {
+			refit(primitiveBounds);
+			return;
+		}
+		if (primitiveBounds.size() != primitiveCount) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Bvh", "refit", "Refit needs a built tree over the same primitives",
+				primitiveCount, static_cast<uint64_t>(primitiveBounds.size()));
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		if (width == E_BvhWidth::WIDE_8) {
+			refitDirtyNodes(nodes8, primitiveBounds, dirtyPrimitives);
+		}
+		else {
+			refitDirtyNodes(nodes4, primitiveBounds, dirtyPrimitives);
+		}
+		stats.refitMilliseconds = millisecondsSince(start);
+		Instrumentation::recordTiming(STATS_CATEGORY, "refit", stats.refitMilliseconds);
+	}
+
+	void S_Bvh::assign(const S_BvhView& view) {
+		if (view.primitiveIndices.size() < view.primitiveCount || (view.width != E_BvhWidth::WIDE_4 && view.width != E_BvhWidth::WIDE_8)) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Bvh", "assign", "View is not a complete tree",
+				view.primitiveCount, static_cast<uint64_t>(view.primitiveIndices.size()));
+		}
+
+		clear();
+		if (view.isEmpty()) {
+			return;
+		}
+		width = view.width;
+		nodes4.assign(view.nodes4.begin(), view.nodes4.end());
+		nodes8.assign(view.nodes8.begin(), view.nodes8.end());
+		primitiveIndices.assign(view.primitiveIndices.begin(), view.primitiveIndices.end());
+		bounds = view.bounds;
+		primitiveCount = view.primitiveCount;
+		built = true;
+
+		stats.primitiveCount = primitiveCount;
+		stats.referenceCount = static_cast<uint32_t>(primitiveIndices.size());
+		stats.nodeCount = static_cast<uint32_t>(width == E_BvhWidth::WIDE_8 ? nodes8.size() : nodes4.size());
+		stats.nodeBytes = nodes4.size() * sizeof(S_WideBvhNode<4>) + nodes8.size() * sizeof(S_WideBvhNode<8>);
+		stats.indexBytes = primitiveIndices.size() * sizeof(uint32_t);
+		stats.bytesPerPrimitive = primitiveCount > 0 ? static_cast<double>(stats.nodeBytes + stats.indexBytes) / primitiveCount : 0.0;
+	}
+
+	void S_Bvh::clear() {
+		nodes4.clear();
+		nodes8.clear();
+		primitiveIndices.clear();
+		nodeBounds.clear();
+		bounds = {};
+		primitiveCount = 0;
+		built = false;
+		stats = {};
+	}
+
+	bool S_Bvh::isBuilt() const {
+		return built;
+	}
+
+	E_BvhWidth S_Bvh::getWidth() const {
+		return width;
+	}
+
+	const S_Aabb& S_Bvh::getBounds() const {
+		return bounds;
+	}
+
+	const S_BvhStats& S_Bvh::getStats() const {
+		return stats;
+	}
+
+	const std::pmr::vector<uint32_t>& S_Bvh::getPrimitiveIndices() const {
+		return primitiveIndices;
+	}
+
+	const std::pmr::vector<S_WideBvhNode<4>>& S_Bvh::getNodes4() const {
+		return nodes4;
+	}
+
+	const std::pmr::vector<S_WideBvhNode<8>>& S_Bvh::getNodes8() const {
+		return nodes8;
+	}
+
+	S_BvhView S_Bvh::getView() const {
+		S_BvhView view;
+		if (built) {
+			view.width = width;
+			view.primitiveCount = primitiveCount;
+			view.bounds = bounds;
+			view.nodes4 = nodes4;
+			view.nodes8 = nodes8;
+			view.primitiveIndices = primitiveIndices;
+		}
+		return view;
+	}
+
+	void S_Bvh::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "buildMilliseconds", stats.buildMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "refitMilliseconds", stats.refitMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "refitNodes", static_cast<double>(stats.refitNodeCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "primitives", static_cast<double>(stats.primitiveCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "references", static_cast<double>(stats.referenceCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "spatialSplits", static_cast<double>(stats.spatialSplitCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "nodes", static_cast<double>(stats.nodeCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "leaves", static_cast<double>(stats.leafCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "maxDepth", static_cast<double>(stats.maxDepth));
+		Instrumentation::setGauge(STATS_CATEGORY, "sahCost", stats.sahCost);
+		Instrumentation::setGauge(STATS_CATEGORY, "bytesPerPrimitive", stats.bytesPerPrimitive);
+	}
+}
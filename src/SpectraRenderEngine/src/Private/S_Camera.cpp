@@ -0,0 +1,40 @@
+#include "S_Camera.h"
+
+#include <cmath>
+#include <numbers>
+
+namespace spectra::render {
+	using core::math::S_Vec3;
+
+	S_Camera::S_Camera(const S_Vec3& position, const S_Vec3& target, const S_Vec3& up, float verticalFovDegrees, float aspectRatio)
+		: origin(position) {
+		const float halfHeight = std::tan(verticalFovDegrees * std::numbers::pi_v<float> / 360.0f);
+		const float halfWidth = halfHeight * aspectRatio;
+
+		const S_Vec3 forward = core::math::normalize(target - position);
+		const S_Vec3 right = core::math::normalize(core::math::cross(forward, up));
+		const S_Vec3 cameraUp = core::math::cross(right, forward);
+
+		horizontal = right * (2.0f * halfWidth);
+		vertical = cameraUp * (-2.0f * halfHeight);
+		topLeft = forward - right * halfWidth + cameraUp * halfHeight;
+	}
+
+	core::math::S_Ray S_Camera::generateRay(float u, float v) const {
+		return { origin, core::math::normalize(topLeft + horizontal * u + vertical * v) };
+	}
+
+	bool S_Camera::project(const S_Vec3& point, float& u, float& v) const {
+		// Directions through the image plane have a forward component of one
+		const S_Vec3 forward = topLeft + horizontal * 0.5f + vertical * 0.5f;
+		const S_Vec3 offset = point - origin;
+		const float depth = core::math::dot(offset, forward);
+		if (depth <= 0.0f) {
+			return false;
+		}
+		const S_Vec3 onPlane = offset / depth - topLeft;
+		u = core::math::dot(onPlane, horizontal) / core::math::lengthSquared(horizontal);
+		v = core::math::dot(onPlane, vertical) / core::math::lengthSquared(vertical);
+		return true;
+	}
+}
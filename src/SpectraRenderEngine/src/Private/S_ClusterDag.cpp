@@ -0,0 +1,533 @@
+#include "S_ClusterDag.h"
+#include "S_MeshSimplifier.h"
+#include "S_JobSystem.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace spectra::render {
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::clusters";
+		constexpr uint32_t FILE_MAGIC = 0x444C4353;  // "SCLD"
+		constexpr uint32_t PAGE_MAGIC = 0x47504353;  // "SCPG"
+		constexpr uint32_t NO_OWNER = 0xFFFFFFFFu;
+
+		struct S_PageHeader {
+			uint32_t magic;
+			uint32_t clusterCount;
+			uint32_t vertexCount;
+			uint32_t triangleBytes;
+		};
+
+		// Clusters simplified together, and what their simplification produced
+		struct S_GroupResult {
+			S_MeshletSet meshlets;
+			S_LodBounds lod;
+			double milliseconds = 0.0;
+			bool refined = false;
+		};
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// Smallest sphere around both spheres
+		S_LodBounds mergeSpheres(const S_LodBounds& a, const S_LodBounds& b) {
+			const S_Vec3 offset = b.center - a.center;
+			const float distance = core::math::length(offset);
+			if (distance + b.radius <= a.radius) {
+				return a;
+			}
+			if (distance + a.radius <= b.radius) {
+				return b;
+			}
+			S_LodBounds merged;
+			merged.radius = (distance + a.radius + b.radius) * 0.5f;
+			merged.center = a.center + offset * ((merged.radius - a.radius) / distance);
+			return merged;
+		}
+
+		// Projected error of bounds seen from position; infinite from inside the sphere
+		float projectError(const S_LodBounds& bounds, const S_Vec3& position) {
+			if (bounds.error <= 0.0f) {
+				return 0.0f;
+			}
+			const float distance = core::math::length(bounds.center - position) - bounds.radius;
+			return distance > 0.0f ? bounds.error / distance : std::numeric_limits<float>::infinity();
+		}
+
+		size_t alignUp(size_t value, size_t alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		// Neighbouring clusters merged greedily into groups of up to groupSize, each time taking
+		// the unassigned neighbour sharing the most vertices with the group
+		std::vector<std::vector<uint32_t>> groupClusters(std::span<const S_Cluster> clusters, std::span<const uint32_t> clusterVertices,
+			std::span<const uint32_t> current, uint32_t groupSize) {
+			std::vector<std::pair<uint32_t, uint32_t>> vertexClusters;
+			for (uint32_t i = 0; i < current.size(); ++i) {
+				const S_Cluster& cluster = clusters[current[i]];
+				for (uint32_t v = 0; v < cluster.vertexCount; ++v) {
+					vertexClusters.emplace_back(clusterVertices[cluster.vertexOffset + v], i);
+				}
+			}
+			std::sort(vertexClusters.begin(), vertexClusters.end());
+
+			std::vector<std::pair<uint32_t, uint32_t>> pairs;
+			for (size_t i = 0; i < vertexClusters.size();) {
+				size_t run = i + 1;
+				while (run < vertexClusters.size() && vertexClusters[run].first == vertexClusters[i].first) {
+					++run;
+				}
+				for (size_t a = i; a < run; ++a) {
+					for (size_t b = i; b < run; ++b) {
+						if (a != b) {
+							pairs.emplace_back(vertexClusters[a].second, vertexClusters[b].second);
+						}
+					}
+				}
+				i = run;
+			}
+			std::sort(pairs.begin(), pairs.end());
+
+			// Neighbours of each cluster with the number of vertices they share
+			std::vector<std::vector<std::pair<uint32_t, uint32_t>>> neighbours(current.size());
+			for (size_t i = 0; i < pairs.size();) {
+				size_t run = i + 1;
+				while (run < pairs.size() && pairs[run] == pairs[i]) {
+					++run;
+				}
+				neighbours[pairs[i].first].emplace_back(pairs[i].second, static_cast<uint32_t>(run - i));
+				i = run;
+			}
+
+			std::vector<std::vector<uint32_t>> groups;
+			std::vector<uint8_t> assigned(current.size(), 0);
+			std::vector<uint32_t> shared(current.size(), 0);
+			std::vector<uint32_t> touched;
+			for (uint32_t seed = 0; seed < current.size(); ++seed) {
+				if (assigned[seed]) {
+					continue;
+				}
+				std::vector<uint32_t> group{ seed };
+				assigned[seed] = 1;
+				while (group.size() < groupSize) {
+					for (uint32_t member : touched) {
+						shared[member] = 0;
+					}
+					touched.clear();
+					uint32_t best = NO_OWNER;
+					for (uint32_t member : group) {
+						for (const auto& [neighbour, count] : neighbours[member]) {
+							if (assigned[neighbour]) {
+								continue;
+							}
+							if (shared[neighbour] == 0) {
+								touched.push_back(neighbour);
+							}
+							shared[neighbour] += count;
+							if (best == NO_OWNER || shared[neighbour] > shared[best]) {
+								best = neighbour;
+							}
+						}
+					}
+					if (best == NO_OWNER) {
+						break;
+					}
+					assigned[best] = 1;
+					group.push_back(best);
+				}
+				for (uint32_t& member : group) {
+					member = current[member];
+				}
+				groups.push_back(std::move(group));
+			}
+			return groups;
+		}
+	}
+
+	struct S_ClusterPageView::S_Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t clusterCount;
+		uint32_t pageCount;
+		uint32_t pageSize;
+		uint32_t reserved;
+		uint64_t size;
+	};
+
+	struct S_ClusterPageView::S_PageEntry {
+		uint64_t offset;
+		uint32_t size;
+		uint32_t clusterCount;
+	};
+
+	// S_ClusterPageView implementations
+	bool S_ClusterPageView::parse(std::span<const std::byte> bytes, S_ClusterPageView& view) {
+		view = S_ClusterPageView{};
+		if (bytes.size() < sizeof(S_Header) || reinterpret_cast<uintptr_t>(bytes.data()) % alignof(S_Header) != 0) {
+			return false;
+		}
+		const auto* header = reinterpret_cast<const S_Header*>(bytes.data());
+		const size_t tableBytes = sizeof(S_Header) + size_t(header->pageCount) * sizeof(S_PageEntry) + size_t(header->clusterCount) * sizeof(S_ClusterRecord);
+		if (header->magic != FILE_MAGIC || header->version != FORMAT_VERSION || header->size != bytes.size() || tableBytes > bytes.size()) {
+			return false;
+		}
+		const auto* pages = reinterpret_cast<const S_PageEntry*>(bytes.data() + sizeof(S_Header));
+		const auto* clusters = reinterpret_cast<const S_ClusterRecord*>(bytes.data() + sizeof(S_Header) + size_t(header->pageCount) * sizeof(S_PageEntry));
+		for (uint32_t page = 0; page < header->pageCount; ++page) {
+			S_ClusterPage parsed;
+			if (pages[page].offset > bytes.size() || pages[page].size > bytes.size() - pages[page].offset
+				|| !parsePage(bytes.subspan(pages[page].offset, pages[page].size), parsed) || parsed.clusters.size() != pages[page].clusterCount) {
+				return false;
+			}
+		}
+		for (uint32_t cluster = 0; cluster < header->clusterCount; ++cluster) {
+			if (clusters[cluster].page >= header->pageCount || clusters[cluster].pageCluster >= pages[clusters[cluster].page].clusterCount) {
+				return false;
+			}
+		}
+		view.bytes = bytes;
+		view.header = header;
+		view.pages = pages;
+		view.clusters = clusters;
+		return true;
+	}
+
+	bool S_ClusterPageView::parsePage(std::span<const std::byte> bytes, S_ClusterPage& page) {
+		page = S_ClusterPage{};
+		if (bytes.size() < sizeof(S_PageHeader) || reinterpret_cast<uintptr_t>(bytes.data()) % alignof(S_ClusterPageCluster) != 0) {
+			return false;
+		}
+		S_PageHeader header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		const size_t clusterBytes = size_t(header.clusterCount) * sizeof(S_ClusterPageCluster);
+		const size_t positionBytes = size_t(header.vertexCount) * sizeof(S_Vec3);
+		if (header.magic != PAGE_MAGIC || sizeof(S_PageHeader) + clusterBytes + positionBytes + header.triangleBytes > bytes.size()) {
+			return false;
+		}
+		const auto* clusters = reinterpret_cast<const S_ClusterPageCluster*>(bytes.data() + sizeof(S_PageHeader));
+		const auto* positions = reinterpret_cast<const S_Vec3*>(bytes.data() + sizeof(S_PageHeader) + clusterBytes);
+		const auto* triangles = reinterpret_cast<const uint8_t*>(bytes.data() + sizeof(S_PageHeader) + clusterBytes + positionBytes);
+		for (uint32_t i = 0; i < header.clusterCount; ++i) {
+			const S_ClusterPageCluster& cluster = clusters[i];
+			if (size_t(cluster.vertexOffset) + cluster.vertexCount > header.vertexCount
+				|| size_t(cluster.triangleOffset) + size_t(cluster.triangleCount) * 3 > header.triangleBytes) {
+				return false;
+			}
+			for (uint32_t corner = 0; corner < cluster.triangleCount * 3; ++corner) {
+				if (triangles[cluster.triangleOffset + corner] >= cluster.vertexCount) {
+					return false;
+				}
+			}
+		}
+		page.clusters = { clusters, header.clusterCount };
+		page.positions = { positions, header.vertexCount };
+		page.triangles = { triangles, header.triangleBytes };
+		return true;
+	}
+
+	bool S_ClusterPageView::isValid() const {
+		return header != nullptr;
+	}
+
+	uint32_t S_ClusterPageView::getClusterCount() const {
+		return header ? header->clusterCount : 0;
+	}
+
+	const S_ClusterRecord& S_ClusterPageView::getCluster(uint32_t cluster) const {
+		if (cluster >= getClusterCount()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_ClusterPageView", "getCluster", "Cluster out of range", cluster);
+		}
+		return clusters[cluster];
+	}
+
+	uint32_t S_ClusterPageView::getPageCount() const {
+		return header ? header->pageCount : 0;
+	}
+
+	std::span<const std::byte> S_ClusterPageView::getPageBytes(uint32_t page) const {
+		if (page >= getPageCount()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_ClusterPageView", "getPageBytes", "Page out of range", page);
+		}
+		return bytes.subspan(pages[page].offset, pages[page].size);
+	}
+
+	S_ClusterPage S_ClusterPageView::getPage(uint32_t page) const {
+		S_ClusterPage parsed;
+		parsePage(getPageBytes(page), parsed);
+		return parsed;
+	}
+
+	// S_ClusterDag implementations
+	void S_ClusterDag::build(std::span<const S_Vec3> sourcePositions, std::span<const uint32_t> indices, const S_ClusterDagSettings& settings) {
+		const auto start = std::chrono::steady_clock::now();
+		if (settings.groupSize < 2 || settings.reductionTarget <= 0.0f || settings.reductionTarget >= 1.0f) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_ClusterDag", "build", "Invalid settings",
+				settings.groupSize, settings.reductionTarget);
+		}
+		positions.assign(sourcePositions.begin(), sourcePositions.end());
+		clusters.clear();
+		clusterVertices.clear();
+		clusterTriangles.clear();
+		stats = {};
+		stats.sourceTriangles = static_cast<uint32_t>(indices.size() / 3);
+
+		{
+			S_MeshletSet meshlets;
+			S_MeshletBuilder::build(positions, indices, settings.meshlets, meshlets);
+			appendClusters(meshlets, 0, {});
+		}
+		std::vector<uint32_t> current(clusters.size());
+		for (uint32_t i = 0; i < current.size(); ++i) {
+			current[i] = i;
+		}
+
+		std::vector<uint8_t> locked;
+		std::vector<uint32_t> owner;
+		std::vector<uint32_t> next;
+		uint32_t level = 0;
+		while (current.size() > 1 && level + 1 < settings.maxLevels) {
+			const std::vector<std::vector<uint32_t>> groups = groupClusters(clusters, clusterVertices, current, settings.groupSize);
+
+			// A vertex used by two groups lies on a border both sides must keep
+			locked.assign(positions.size(), 0);
+			owner.assign(positions.size(), NO_OWNER);
+			for (uint32_t group = 0; group < groups.size(); ++group) {
+				for (uint32_t cluster : groups[group]) {
+					for (uint32_t v = 0; v < clusters[cluster].vertexCount; ++v) {
+						const uint32_t vertex = clusterVertices[clusters[cluster].vertexOffset + v];
+						if (owner[vertex] == NO_OWNER) {
+							owner[vertex] = group;
+						}
+						else if (owner[vertex] != group) {
+							locked[vertex] = 1;
+						}
+					}
+				}
+			}
+
+			std::vector<S_GroupResult> results(groups.size());
+			core::jobs::S_JobSystem::getInstance().parallelFor(0, groups.size(), [&](size_t begin, size_t end) {
+				std::vector<uint32_t> triangles;
+				std::vector<uint32_t> simplified;
+				for (size_t group = begin; group < end; ++group) {
+					const auto groupStart = std::chrono::steady_clock::now();
+					S_GroupResult& result = results[group];
+					triangles.clear();
+					float childError = 0.0f;
+					for (uint32_t clusterIndex : groups[group]) {
+						const S_Cluster& cluster = clusters[clusterIndex];
+						for (uint32_t corner = 0; corner < cluster.triangleCount * 3; ++corner) {
+							triangles.push_back(clusterVertices[cluster.vertexOffset + clusterTriangles[cluster.triangleOffset + corner]]);
+						}
+						result.lod = clusterIndex == groups[group].front() ? cluster.lod : mergeSpheres(result.lod, cluster.lod);
+						childError = std::max(childError, cluster.lod.error);
+					}
+					const uint32_t sourceTriangles = static_cast<uint32_t>(triangles.size() / 3);
+					const uint32_t target = static_cast<uint32_t>(sourceTriangles * settings.reductionTarget);
+					const float error = simplify::simplify(positions, triangles, locked, target, simplified);
+					result.lod.error = std::max(childError, error);
+					result.refined = simplified.size() / 3 <= static_cast<size_t>(sourceTriangles * (1.0f - settings.minimumReduction));
+					if (result.refined) {
+						S_MeshletBuilder::build(positions, simplified, settings.meshlets, result.meshlets);
+					}
+					result.milliseconds = millisecondsSince(groupStart);
+				}
+			}, 1);
+
+			// Stuck groups hand their clusters on unchanged, to be grouped with other neighbours
+			next.clear();
+			bool refined = false;
+			for (uint32_t group = 0; group < groups.size(); ++group) {
+				const S_GroupResult& result = results[group];
+				stats.simplifyMilliseconds += result.milliseconds;
+				if (!result.refined) {
+					next.insert(next.end(), groups[group].begin(), groups[group].end());
+					continue;
+				}
+				refined = true;
+				const uint32_t groupIndex = stats.groupCount++;
+				for (uint32_t clusterIndex : groups[group]) {
+					clusters[clusterIndex].parent = result.lod;
+					clusters[clusterIndex].parentGroup = groupIndex;
+				}
+				const uint32_t first = static_cast<uint32_t>(clusters.size());
+				appendClusters(result.meshlets, level + 1, result.lod);
+				for (uint32_t i = first; i < clusters.size(); ++i) {
+					next.push_back(i);
+				}
+			}
+			current.swap(next);
+			++level;
+			if (!refined) {
+				break;
+			}
+		}
+
+		for (S_Cluster& cluster : clusters) {
+			stats.levelCount = std::max(stats.levelCount, cluster.level + 1);
+			if (cluster.parentGroup == S_Cluster::NO_GROUP) {
+				cluster.parent = { cluster.lod.center, cluster.lod.radius, std::numeric_limits<float>::infinity() };
+				++stats.rootCount;
+				stats.rootTriangles += cluster.triangleCount;
+			}
+		}
+		stats.clusterCount = static_cast<uint32_t>(clusters.size());
+		stats.buildMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "build", stats.buildMilliseconds);
+	}
+
+	void S_ClusterDag::appendClusters(const S_MeshletSet& meshlets, uint32_t level, const S_LodBounds& lod) {
+		for (uint32_t i = 0; i < meshlets.meshlets.size(); ++i) {
+			const S_Meshlet& meshlet = meshlets.meshlets[i];
+			S_Cluster cluster;
+			cluster.vertexOffset = static_cast<uint32_t>(clusterVertices.size());
+			cluster.triangleOffset = static_cast<uint32_t>(clusterTriangles.size());
+			cluster.vertexCount = meshlet.vertexCount;
+			cluster.triangleCount = meshlet.triangleCount;
+			cluster.bounds = S_MeshletBuilder::computeBounds(positions, meshlets, i);
+			// Level 0 clusters are exact and bound only themselves
+			cluster.lod = level == 0 ? S_LodBounds{ cluster.bounds.center, cluster.bounds.radius, 0.0f } : lod;
+			cluster.level = level;
+			clusterVertices.insert(clusterVertices.end(), meshlets.vertices.begin() + meshlet.vertexOffset,
+				meshlets.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+			clusterTriangles.insert(clusterTriangles.end(), meshlets.triangles.begin() + meshlet.triangleOffset,
+				meshlets.triangles.begin() + meshlet.triangleOffset + size_t(meshlet.triangleCount) * 3);
+			clusters.push_back(cluster);
+		}
+	}
+
+	void S_ClusterDag::selectClusters(const S_Vec3& viewPosition, float threshold, std::vector<uint32_t>& selected) const {
+		selected.clear();
+		for (uint32_t i = 0; i < clusters.size(); ++i) {
+			const S_Cluster& cluster = clusters[i];
+			if (projectError(cluster.lod, viewPosition) <= threshold && projectError(cluster.parent, viewPosition) > threshold) {
+				selected.push_back(i);
+			}
+		}
+	}
+
+	std::span<const S_Cluster> S_ClusterDag::getClusters() const {
+		return clusters;
+	}
+
+	std::span<const uint32_t> S_ClusterDag::getClusterVertices() const {
+		return clusterVertices;
+	}
+
+	std::span<const uint8_t> S_ClusterDag::getClusterTriangles() const {
+		return clusterTriangles;
+	}
+
+	std::span<const S_Vec3> S_ClusterDag::getPositions() const {
+		return positions;
+	}
+
+	std::vector<std::byte> S_ClusterDag::writePages(uint32_t pageSize) const {
+		// Clusters needed together, roots first (NO_GROUP sorts highest) and then coarse groups before fine ones
+		std::vector<uint32_t> order(clusters.size());
+		for (uint32_t i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return clusters[a].parentGroup > clusters[b].parentGroup; });
+
+		auto clusterBytes = [&](uint32_t cluster) {
+			return sizeof(S_ClusterPageCluster) + clusters[cluster].vertexCount * sizeof(S_Vec3) + clusters[cluster].triangleCount * 3;
+		};
+
+		// Whole groups go on one page; a group larger than a page gets a page of its own
+		std::vector<std::pair<uint32_t, uint32_t>> pageRanges;  // Into order
+		size_t pageBytes = sizeof(S_PageHeader);
+		for (uint32_t i = 0; i < order.size();) {
+			uint32_t end = i + 1;
+			size_t unitBytes = clusterBytes(order[i]);
+			while (end < order.size() && clusters[order[end]].parentGroup == clusters[order[i]].parentGroup
+				&& clusters[order[i]].parentGroup != S_Cluster::NO_GROUP) {
+				unitBytes += clusterBytes(order[end++]);
+			}
+			if (pageRanges.empty() || pageBytes + unitBytes > pageSize) {
+				pageRanges.emplace_back(i, i);
+				pageBytes = sizeof(S_PageHeader);
+			}
+			pageRanges.back().second = end;
+			pageBytes += unitBytes;
+			i = end;
+		}
+
+		const size_t tableBytes = sizeof(S_ClusterPageView::S_Header) + pageRanges.size() * sizeof(S_ClusterPageView::S_PageEntry)
+			+ clusters.size() * sizeof(S_ClusterRecord);
+		std::vector<std::byte> bytes(alignUp(tableBytes, S_ClusterPageView::PAGE_ALIGNMENT));
+		std::vector<S_ClusterPageView::S_PageEntry> pages;
+		std::vector<S_ClusterRecord> records;
+		std::vector<S_ClusterPageCluster> pageClusters;
+		std::vector<S_Vec3> pagePositions;
+		std::vector<uint8_t> pageTriangles;
+		for (uint32_t page = 0; page < pageRanges.size(); ++page) {
+			pageClusters.clear();
+			pagePositions.clear();
+			pageTriangles.clear();
+			for (uint32_t i = pageRanges[page].first; i < pageRanges[page].second; ++i) {
+				const S_Cluster& cluster = clusters[order[i]];
+				S_ClusterPageCluster entry;
+				entry.bounds = cluster.bounds;
+				entry.vertexOffset = static_cast<uint32_t>(pagePositions.size());
+				entry.triangleOffset = static_cast<uint32_t>(pageTriangles.size());
+				entry.vertexCount = cluster.vertexCount;
+				entry.triangleCount = cluster.triangleCount;
+				for (uint32_t v = 0; v < cluster.vertexCount; ++v) {
+					pagePositions.push_back(positions[clusterVertices[cluster.vertexOffset + v]]);
+				}
+				pageTriangles.insert(pageTriangles.end(), clusterTriangles.begin() + cluster.triangleOffset,
+					clusterTriangles.begin() + cluster.triangleOffset + size_t(cluster.triangleCount) * 3);
+				records.push_back({ cluster.lod, cluster.parent, page, static_cast<uint32_t>(pageClusters.size()) });
+				pageClusters.push_back(entry);
+			}
+
+			const S_PageHeader header{ PAGE_MAGIC, static_cast<uint32_t>(pageClusters.size()), static_cast<uint32_t>(pagePositions.size()),
+				static_cast<uint32_t>(pageTriangles.size()) };
+			const size_t offset = bytes.size();
+			const size_t size = sizeof(header) + pageClusters.size() * sizeof(S_ClusterPageCluster) + pagePositions.size() * sizeof(S_Vec3) + pageTriangles.size();
+			bytes.resize(alignUp(offset + size, S_ClusterPageView::PAGE_ALIGNMENT));
+			std::byte* cursor = bytes.data() + offset;
+			std::memcpy(cursor, &header, sizeof(header));
+			cursor += sizeof(header);
+			std::memcpy(cursor, pageClusters.data(), pageClusters.size() * sizeof(S_ClusterPageCluster));
+			cursor += pageClusters.size() * sizeof(S_ClusterPageCluster);
+			std::memcpy(cursor, pagePositions.data(), pagePositions.size() * sizeof(S_Vec3));
+			cursor += pagePositions.size() * sizeof(S_Vec3);
+			std::memcpy(cursor, pageTriangles.data(), pageTriangles.size());
+			pages.push_back({ offset, static_cast<uint32_t>(size), header.clusterCount });
+		}
+
+		const S_ClusterPageView::S_Header header{ FILE_MAGIC, S_ClusterPageView::FORMAT_VERSION, static_cast<uint32_t>(records.size()),
+			static_cast<uint32_t>(pages.size()), pageSize, 0, bytes.size() };
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		std::memcpy(bytes.data() + sizeof(header), pages.data(), pages.size() * sizeof(S_ClusterPageView::S_PageEntry));
+		std::memcpy(bytes.data() + sizeof(header) + pages.size() * sizeof(S_ClusterPageView::S_PageEntry), records.data(),
+			records.size() * sizeof(S_ClusterRecord));
+		return bytes;
+	}
+
+	const S_ClusterDagStats& S_ClusterDag::getStats() const {
+		return stats;
+	}
+
+	void S_ClusterDag::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "buildMilliseconds", stats.buildMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "simplifyMilliseconds", stats.simplifyMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "levels", static_cast<double>(stats.levelCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "clusters", static_cast<double>(stats.clusterCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "groups", static_cast<double>(stats.groupCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "roots", static_cast<double>(stats.rootCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "rootTriangles", static_cast<double>(stats.rootTriangles));
+	}
+}
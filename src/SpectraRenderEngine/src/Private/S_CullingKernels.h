@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+
+#include "S_Visibility.h"
+
+// Interface between S_Visibility and the culling kernels, one translation unit per instruction
+// set. Frustum kernels stream SoA bound columns and write the indices that pass; SIMD ones take
+// ranges that are a multiple of their width and leave the remainder to the scalar kernel.
+// The raster kernel evaluates one row of a tile per step.
+namespace spectra::render::kernels {
+	constexpr uint32_t OCCLUSION_TILE_WIDTH = S_OcclusionBuffer::TILE_WIDTH;
+	constexpr uint32_t OCCLUSION_TILE_HEIGHT = S_OcclusionBuffer::TILE_HEIGHT;
+	constexpr uint32_t OCCLUSION_FULL_MASK = 0xFFFFFFFFu;
+	static_assert(OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_HEIGHT == 32, "Tile coverage is one 32-bit mask");
+
+	struct S_BoxColumns {
+		const float* minX = nullptr;
+		const float* minY = nullptr;
+		const float* minZ = nullptr;
+		const float* maxX = nullptr;
+		const float* maxY = nullptr;
+		const float* maxZ = nullptr;
+	};
+
+	struct S_SphereColumns {
+		const float* x = nullptr;
+		const float* y = nullptr;
+		const float* z = nullptr;
+		const float* radius = nullptr;
+	};
+
+	// Inside where a * x + b * y + c * z + d >= 0, with unit (a, b, c)
+	struct S_CullingPlanes {
+		float a[6] = {};
+		float b[6] = {};
+		float c[6] = {};
+		float d[6] = {};
+	};
+
+	// Screen-space triangle in pixels. A pixel centre (x, y) is covered when every edge function
+	// A * x + B * y + C is non-negative; depth over the triangle is the plane A * x + B * y + C.
+	struct S_RasterTriangle {
+		float edges[3][3];
+		float depth[3];
+		float zMin;
+		float zMax;
+		uint32_t tileMinX;
+		uint32_t tileMinY;
+		uint32_t tileMaxX;  // Inclusive
+		uint32_t tileMaxY;
+	};
+
+	using CullBoxesKernel = uint32_t (*)(const S_BoxColumns& boxes, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible);
+	using CullSpheresKernel = uint32_t (*)(const S_SphereColumns& spheres, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible);
+	using RasterizeKernel = void (*)(const S_RasterTriangle* triangles, const uint32_t* ids, uint32_t count, S_OcclusionTile* tiles,
+		uint32_t tilesPerRow, uint32_t tileRowBegin, uint32_t tileRowEnd);
+
+	uint32_t cullBoxesScalar(const S_BoxColumns& boxes, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible);
+	uint32_t cullSpheresScalar(const S_SphereColumns& spheres, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible);
+	void rasterizeOccludersScalar(const S_RasterTriangle* triangles, const uint32_t* ids, uint32_t count, S_OcclusionTile* tiles,
+		uint32_t tilesPerRow, uint32_t tileRowBegin, uint32_t tileRowEnd);
+
+#if defined(SPECTRA_X86_KERNELS)
+	uint32_t cullBoxesAvx2(const S_BoxColumns& boxes, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible);
+	uint32_t cullSpheresAvx2(const S_SphereColumns& spheres, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible);
+	void rasterizeOccludersAvx2(const S_RasterTriangle* triangles, const uint32_t* ids, uint32_t count, S_OcclusionTile* tiles,
+		uint32_t tilesPerRow, uint32_t tileRowBegin, uint32_t tileRowEnd);
+#endif
+}
@@ -0,0 +1,165 @@
+// Culling shared by the kernel translation units, included after the policy P is defined. P
+// supplies a Float of WIDTH lanes, a Mask from comparing Floats, contiguous loads, the lane
+// indices and a movemask. Every step is an exactly rounded IEEE operation in the same order for
+// every policy, so all kernels keep and cover exactly the same things.
+namespace spectra::render::kernels {
+	namespace {
+		// Local rather than std::min and friends: out-of-line copies of those are shared by
+		// every translation unit, whatever instruction set each was compiled for
+		inline float minimum(float a, float b) { return b < a ? b : a; }
+		inline float maximum(float a, float b) { return a < b ? b : a; }
+		inline float clampTo(float value, float low, float high) { return minimum(maximum(value, low), high); }
+
+		// Appends base + lane for every lane not set in rejected
+		inline uint32_t appendSurvivors(uint32_t rejected, uint32_t width, uint32_t base, uint32_t* visible) {
+			uint32_t count = 0;
+			for (uint32_t lane = 0; lane < width; ++lane) {
+				visible[count] = base + lane;
+				count += ((rejected >> lane) & 1u) ^ 1u;
+			}
+			return count;
+		}
+
+		template<typename P>
+		typename P::Float planeDistance(const S_CullingPlanes& planes, uint32_t plane, typename P::Float x, typename P::Float y, typename P::Float z) {
+			return P::add(P::add(P::add(P::mul(P::set1(planes.a[plane]), x), P::mul(P::set1(planes.b[plane]), y)),
+				P::mul(P::set1(planes.c[plane]), z)), P::set1(planes.d[plane]));
+		}
+
+		template<typename P>
+		uint32_t cullBoxes(const S_BoxColumns& boxes, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible) {
+			// A box is outside a plane when its corner farthest along the normal is; which column
+			// holds that corner depends only on the plane
+			const float* cornerX[6];
+			const float* cornerY[6];
+			const float* cornerZ[6];
+			for (uint32_t plane = 0; plane < 6; ++plane) {
+				cornerX[plane] = planes.a[plane] >= 0.0f ? boxes.maxX : boxes.minX;
+				cornerY[plane] = planes.b[plane] >= 0.0f ? boxes.maxY : boxes.minY;
+				cornerZ[plane] = planes.c[plane] >= 0.0f ? boxes.maxZ : boxes.minZ;
+			}
+
+			uint32_t count = 0;
+			for (uint32_t i = begin; i < end; i += P::WIDTH) {
+				typename P::Mask outside = P::lt(planeDistance<P>(planes, 0, P::load(cornerX[0] + i), P::load(cornerY[0] + i), P::load(cornerZ[0] + i)),
+					P::set1(0.0f));
+				for (uint32_t plane = 1; plane < 6; ++plane) {
+					const typename P::Float distance = planeDistance<P>(planes, plane, P::load(cornerX[plane] + i), P::load(cornerY[plane] + i),
+						P::load(cornerZ[plane] + i));
+					outside = P::orMask(outside, P::lt(distance, P::set1(0.0f)));
+				}
+				count += appendSurvivors(P::movemask(outside), P::WIDTH, i, visible + count);
+			}
+			return count;
+		}
+
+		template<typename P>
+		uint32_t cullSpheres(const S_SphereColumns& spheres, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible) {
+			uint32_t count = 0;
+			for (uint32_t i = begin; i < end; i += P::WIDTH) {
+				const typename P::Float x = P::load(spheres.x + i);
+				const typename P::Float y = P::load(spheres.y + i);
+				const typename P::Float z = P::load(spheres.z + i);
+				const typename P::Float negativeRadius = P::sub(P::set1(0.0f), P::load(spheres.radius + i));
+				typename P::Mask outside = P::lt(planeDistance<P>(planes, 0, x, y, z), negativeRadius);
+				for (uint32_t plane = 1; plane < 6; ++plane) {
+					outside = P::orMask(outside, P::lt(planeDistance<P>(planes, plane, x, y, z), negativeRadius));
+				}
+				count += appendSurvivors(P::movemask(outside), P::WIDTH, i, visible + count);
+			}
+			return count;
+		}
+
+		// Bit row * OCCLUSION_TILE_WIDTH + column is set for pixel centres inside the triangle
+		template<typename P>
+		uint32_t coverTile(const S_RasterTriangle& triangle, float tileX, float tileY) {
+			// Pixel centres nearest and farthest along each edge bound the whole tile. Rounding is
+			// monotone, so with the per-pixel arithmetic these bounds are exact.
+			bool full = true;
+			for (uint32_t edge = 0; edge < 3; ++edge) {
+				const float a = triangle.edges[edge][0];
+				const float b = triangle.edges[edge][1];
+				const float lowX = tileX + 0.5f;
+				const float highX = tileX + static_cast<float>(OCCLUSION_TILE_WIDTH) - 0.5f;
+				const float lowY = tileY + 0.5f;
+				const float highY = tileY + static_cast<float>(OCCLUSION_TILE_HEIGHT) - 0.5f;
+				const float largest = a * (a >= 0.0f ? highX : lowX) + (b * (b >= 0.0f ? highY : lowY) + triangle.edges[edge][2]);
+				if (largest < 0.0f) {
+					return 0;
+				}
+				const float smallest = a * (a >= 0.0f ? lowX : highX) + (b * (b >= 0.0f ? lowY : highY) + triangle.edges[edge][2]);
+				full = full && smallest >= 0.0f;
+			}
+			if (full) {
+				return OCCLUSION_FULL_MASK;
+			}
+
+			const typename P::Float lanes = P::laneIndex();
+			uint32_t mask = 0;
+			for (uint32_t row = 0; row < OCCLUSION_TILE_HEIGHT; ++row) {
+				const float y = tileY + static_cast<float>(row) + 0.5f;
+				float rowOffsets[3];
+				for (uint32_t edge = 0; edge < 3; ++edge) {
+					rowOffsets[edge] = triangle.edges[edge][1] * y + triangle.edges[edge][2];
+				}
+				for (uint32_t column = 0; column < OCCLUSION_TILE_WIDTH; column += P::WIDTH) {
+					const typename P::Float x = P::add(P::set1(tileX + static_cast<float>(column) + 0.5f), lanes);
+					typename P::Mask inside = P::ge(P::add(P::mul(P::set1(triangle.edges[0][0]), x), P::set1(rowOffsets[0])), P::set1(0.0f));
+					for (uint32_t edge = 1; edge < 3; ++edge) {
+						inside = P::andMask(inside, P::ge(P::add(P::mul(P::set1(triangle.edges[edge][0]), x), P::set1(rowOffsets[edge])), P::set1(0.0f)));
+					}
+					mask |= P::movemask(inside) << (row * OCCLUSION_TILE_WIDTH + column);
+				}
+			}
+			return mask;
+		}
+
+		inline void mergeTile(S_OcclusionTile& tile, uint32_t mask, float zMax) {
+			// A triangle much nearer than the working layer starts a new one, as the old layer
+			// would only ever become a poor reference
+			if (tile.zMax1 - zMax > tile.zMax0 - tile.zMax1) {
+				tile.zMax1 = 0.0f;
+				tile.mask = 0;
+			}
+			tile.zMax1 = maximum(tile.zMax1, zMax);
+			tile.mask |= mask;
+			if (tile.mask == OCCLUSION_FULL_MASK) {
+				tile.zMax0 = minimum(tile.zMax0, tile.zMax1);
+				tile.zMax1 = 0.0f;
+				tile.mask = 0;
+			}
+		}
+
+		template<typename P>
+		void rasterizeOccluders(const S_RasterTriangle* triangles, const uint32_t* ids, uint32_t count, S_OcclusionTile* tiles,
+			uint32_t tilesPerRow, uint32_t tileRowBegin, uint32_t tileRowEnd) {
+			for (uint32_t i = 0; i < count; ++i) {
+				const S_RasterTriangle& triangle = triangles[ids[i]];
+				const uint32_t firstRow = triangle.tileMinY > tileRowBegin ? triangle.tileMinY : tileRowBegin;
+				const uint32_t endRow = triangle.tileMaxY + 1 < tileRowEnd ? triangle.tileMaxY + 1 : tileRowEnd;
+				for (uint32_t tileRow = firstRow; tileRow < endRow; ++tileRow) {
+					const float tileY = static_cast<float>(tileRow * OCCLUSION_TILE_HEIGHT);
+					const float depthY0 = triangle.depth[1] * (tileY + 0.5f);
+					const float depthY1 = triangle.depth[1] * (tileY + static_cast<float>(OCCLUSION_TILE_HEIGHT) - 0.5f);
+					for (uint32_t tileColumn = triangle.tileMinX; tileColumn <= triangle.tileMaxX; ++tileColumn) {
+						// Depth plane range over the tile's pixel centres, within the triangle's own
+						const float tileX = static_cast<float>(tileColumn * OCCLUSION_TILE_WIDTH);
+						const float depthX0 = triangle.depth[0] * (tileX + 0.5f);
+						const float depthX1 = triangle.depth[0] * (tileX + static_cast<float>(OCCLUSION_TILE_WIDTH) - 0.5f);
+						const float nearest = clampTo(minimum(depthX0, depthX1) + minimum(depthY0, depthY1) + triangle.depth[2], triangle.zMin, triangle.zMax);
+						const float farthest = clampTo(maximum(depthX0, depthX1) + maximum(depthY0, depthY1) + triangle.depth[2], triangle.zMin, triangle.zMax);
+
+						S_OcclusionTile& tile = tiles[tileRow * tilesPerRow + tileColumn];
+						if (nearest >= tile.zMax0) {
+							continue;
+						}
+						const uint32_t mask = coverTile<P>(triangle, tileX, tileY);
+						if (mask != 0) {
+							mergeTile(tile, mask, farthest);
+						}
+					}
+				}
+			}
+		}
+	}
+}
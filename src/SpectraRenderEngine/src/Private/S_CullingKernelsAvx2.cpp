@@ -0,0 +1,46 @@
+#include "S_CullingKernels.h"
+
+#include <immintrin.h>
+
+// Compiled with AVX2 and FMA enabled, only called after S_CpuFeatures reports both. Eight boxes
+// or spheres per step from the SoA columns, and one eight-pixel tile row per step.
+namespace spectra::render::kernels {
+	namespace {
+		struct S_Avx2 {
+			static constexpr uint32_t WIDTH = 8;
+			using Float = __m256;
+			using Mask = __m256;
+
+			static Float set1(float value) { return _mm256_set1_ps(value); }
+			static Float load(const float* source) { return _mm256_loadu_ps(source); }
+			static Float laneIndex() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+
+			static Mask lt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static Mask ge(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+			static Mask andMask(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+			static Mask orMask(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+			static uint32_t movemask(Mask mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+		};
+	}
+}
+
+#include "S_CullingKernels.inl"
+
+namespace spectra::render::kernels {
+	uint32_t cullBoxesAvx2(const S_BoxColumns& boxes, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible) {
+		return cullBoxes<S_Avx2>(boxes, planes, begin, end, visible);
+	}
+
+	uint32_t cullSpheresAvx2(const S_SphereColumns& spheres, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible) {
+		return cullSpheres<S_Avx2>(spheres, planes, begin, end, visible);
+	}
+
+	void rasterizeOccludersAvx2(const S_RasterTriangle* triangles, const uint32_t* ids, uint32_t count, S_OcclusionTile* tiles,
+		uint32_t tilesPerRow, uint32_t tileRowBegin, uint32_t tileRowEnd) {
+		rasterizeOccluders<S_Avx2>(triangles, ids, count, tiles, tilesPerRow, tileRowBegin, tileRowEnd);
+	}
+}
@@ -0,0 +1,44 @@
+#include "S_CullingKernels.h"
+
+
+// Baseline kernels, one box, sphere or pixel per step; also cull what the SIMD kernels leave over
+namespace spectra::render::kernels {
+	namespace {
+		struct S_Scalar {
+			static constexpr uint32_t WIDTH = 1;
+			using Float = float;
+			using Mask = bool;
+
+			static Float set1(float value) { return value; }
+			static Float load(const float* source) { return *source; }
+			static Float laneIndex() { return 0.0f; }
+
+			static Float add(Float a, Float b) { return a + b; }
+			static Float sub(Float a, Float b) { return a - b; }
+			static Float mul(Float a, Float b) { return a * b; }
+
+			static Mask lt(Float a, Float b) { return a < b; }
+			static Mask ge(Float a, Float b) { return a >= b; }
+			static Mask andMask(Mask a, Mask b) { return a && b; }
+			static Mask orMask(Mask a, Mask b) { return a || b; }
+			static uint32_t movemask(Mask mask) { return mask ? 1u : 0u; }
+		};
+	}
+}
+
+#include "S_CullingKernels.inl"
+
+namespace spectra::render::kernels {
+	uint32_t cullBoxesScalar(const S_BoxColumns& boxes, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible) {
+		return cullBoxes<S_Scalar>(boxes, planes, begin, end, visible);
+	}
+
+	uint32_t cullSpheresScalar(const S_SphereColumns& spheres, const S_CullingPlanes& planes, uint32_t begin, uint32_t end, uint32_t* visible) {
+		return cullSpheres<S_Scalar>(spheres, planes, begin, end, visible);
+	}
+
+	void rasterizeOccludersScalar(const S_RasterTriangle* triangles, const uint32_t* ids, uint32_t count, S_OcclusionTile* tiles,
+		uint32_t tilesPerRow, uint32_t tileRowBegin, uint32_t tileRowEnd) {
+		rasterizeOccluders<S_Scalar>(triangles, ids, count, tiles, tilesPerRow, tileRowBegin, tileRowEnd);
+	}
+}
@@ -0,0 +1,364 @@
+#include "S_Denoiser.h"
+#include "S_JobSystem.h"
+#include "S_MemoryTracker.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPECTRA_DENOISER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace spectra::render {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::denoiser";
+
+		// Pixels filtered per inner-loop step; rows are padded to a multiple of this
+		constexpr uint32_t LANE_WIDTH = 4;
+
+		// Albedo below this is treated as this when demodulating, so black and emissive
+		// surfaces keep their color through the divide and multiply
+		constexpr float ALBEDO_FLOOR = 0.01f;
+
+		// B3-spline taps of the a-trous kernel
+		constexpr float KERNEL[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+		// Plane order within the scratch buffer: per-frame features, then two ping-pong sets of
+		// demodulated color plus variance
+		enum E_Plane : uint32_t {
+			ALBEDO_R = 0, ALBEDO_G, ALBEDO_B,
+			NORMAL_X, NORMAL_Y, NORMAL_Z,
+			DEPTH, DEPTH_SCALE, MASK,
+			FEATURE_PLANES
+		};
+		constexpr uint32_t COLOR_PLANES = 4;  // R, G, B, variance
+		constexpr uint32_t PLANE_COUNT = FEATURE_PLANES + 2 * COLOR_PLANES;
+
+		float luminance(float r, float g, float b) {
+			return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		std::pmr::memory_resource* planeResource() {
+			static core::memory::S_TrackedResource resource(core::memory::E_MemoryTag::RENDER);
+			return &resource;
+		}
+
+		// Four adjacent pixels of one plane, SSE when available and a plain loop otherwise
+		struct S_Lanes {
+#if defined(SPECTRA_DENOISER_SSE)
+			__m128 value;
+
+			static S_Lanes load(const float* p) { return { _mm_loadu_ps(p) }; }
+			static S_Lanes splat(float s) { return { _mm_set1_ps(s) }; }
+			void store(float* p) const { _mm_storeu_ps(p, value); }
+
+			S_Lanes operator+(S_Lanes o) const { return { _mm_add_ps(value, o.value) }; }
+			S_Lanes operator-(S_Lanes o) const { return { _mm_sub_ps(value, o.value) }; }
+			S_Lanes operator*(S_Lanes o) const { return { _mm_mul_ps(value, o.value) }; }
+			S_Lanes operator/(S_Lanes o) const { return { _mm_div_ps(value, o.value) }; }
+			friend S_Lanes min(S_Lanes a, S_Lanes b) { return { _mm_min_ps(a.value, b.value) }; }
+			friend S_Lanes max(S_Lanes a, S_Lanes b) { return { _mm_max_ps(a.value, b.value) }; }
+			friend S_Lanes abs(S_Lanes a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.value) }; }
+			friend S_Lanes sqrt(S_Lanes a) { return { _mm_sqrt_ps(a.value) }; }
+
+			friend S_Lanes floor(S_Lanes a) {
+				const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.value));
+				return { _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.value), _mm_set1_ps(1.0f))) };
+			}
+
+			// 2^a for integral a within the normal range
+			friend S_Lanes exp2Integer(S_Lanes a) {
+				const __m128i exponent = _mm_add_epi32(_mm_cvtps_epi32(a.value), _mm_set1_epi32(127));
+				return { _mm_castsi128_ps(_mm_slli_epi32(exponent, 23)) };
+			}
+#else
+			float value[LANE_WIDTH];
+
+			template<typename F>
+			static S_Lanes map(F f) {
+				S_Lanes result;
+				for (uint32_t i = 0; i < LANE_WIDTH; ++i) {
+					result.value[i] = f(i);
+				}
+				return result;
+			}
+
+			static S_Lanes load(const float* p) { return map([p](uint32_t i) { return p[i]; }); }
+			static S_Lanes splat(float s) { return map([s](uint32_t) { return s; }); }
+			void store(float* p) const { std::memcpy(p, value, sizeof(value)); }
+
+			S_Lanes operator+(S_Lanes o) const { return map([&](uint32_t i) { return value[i] + o.value[i]; }); }
+			S_Lanes operator-(S_Lanes o) const { return map([&](uint32_t i) { return value[i] - o.value[i]; }); }
+			S_Lanes operator*(S_Lanes o) const { return map([&](uint32_t i) { return value[i] * o.value[i]; }); }
+			S_Lanes operator/(S_Lanes o) const { return map([&](uint32_t i) { return value[i] / o.value[i]; }); }
+			friend S_Lanes min(S_Lanes a, S_Lanes b) { return map([&](uint32_t i) { return std::min(a.value[i], b.value[i]); }); }
+			friend S_Lanes max(S_Lanes a, S_Lanes b) { return map([&](uint32_t i) { return std::max(a.value[i], b.value[i]); }); }
+			friend S_Lanes abs(S_Lanes a) { return map([&](uint32_t i) { return std::abs(a.value[i]); }); }
+			friend S_Lanes sqrt(S_Lanes a) { return map([&](uint32_t i) { return std::sqrt(a.value[i]); }); }
+			friend S_Lanes floor(S_Lanes a) { return map([&](uint32_t i) { return std::floor(a.value[i]); }); }
+			friend S_Lanes exp2Integer(S_Lanes a) { return map([&](uint32_t i) { return std::ldexp(1.0f, static_cast<int>(a.value[i])); }); }
+#endif
+		};
+
+		// exp(-a) for a >= 0, relative error below 1e-6 and exactly 1 at 0; far tails flush to ~0
+		S_Lanes expNegative(S_Lanes a) {
+			const S_Lanes t = max(a * S_Lanes::splat(-1.44269504f), S_Lanes::splat(-126.0f));
+			const S_Lanes whole = floor(t);
+			const S_Lanes f = t - whole;
+			// Minimax polynomial for 2^f on [0, 1)
+			S_Lanes p = S_Lanes::splat(1.3333558e-3f);
+			p = p * f + S_Lanes::splat(9.6181291e-3f);
+			p = p * f + S_Lanes::splat(5.5504109e-2f);
+			p = p * f + S_Lanes::splat(2.4022651e-1f);
+			p = p * f + S_Lanes::splat(6.9314718e-1f);
+			p = p * f + S_Lanes::splat(1.0f);
+			return p * exp2Integer(whole);
+		}
+
+		// Padded planes: a zero border wide enough for the widest a-trous step, so every tap
+		// of every lane reads memory and the border drops out through the mask plane
+		struct S_PlaneLayout {
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t pad = 0;
+			uint32_t stride = 0;  // Floats per padded row
+			size_t planeSize = 0;
+
+			[[nodiscard]] size_t at(uint32_t x, uint32_t y) const {
+				return static_cast<size_t>(y + pad) * stride + x + pad;
+			}
+		};
+
+		// One a-trous pass over rows [y0, y1) and columns [x0, x1) of the image. Columns are
+		// processed in groups of LANE_WIDTH; lanes past the image edge read the border and are
+		// written back as zero by the mask.
+		void filterTile(const S_PlaneLayout& layout, const S_DenoiserSettings& settings, float* planes, uint32_t step,
+			const float* source, float* target, uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1) {
+			auto plane = [&](uint32_t index) { return planes + index * layout.planeSize; };
+			const float* albedo[3] = { plane(ALBEDO_R), plane(ALBEDO_G), plane(ALBEDO_B) };
+			const float* normal[3] = { plane(NORMAL_X), plane(NORMAL_Y), plane(NORMAL_Z) };
+			const float* depth = plane(DEPTH);
+			const float* depthScale = plane(DEPTH_SCALE);
+			const float* mask = plane(MASK);
+			const float* color[3] = { source, source + layout.planeSize, source + 2 * layout.planeSize };
+			const float* variance = source + 3 * layout.planeSize;
+			float* outColor[3] = { target, target + layout.planeSize, target + 2 * layout.planeSize };
+			float* outVariance = target + 3 * layout.planeSize;
+
+			const S_Lanes luminanceSigma = S_Lanes::splat(settings.luminanceSigma);
+			const S_Lanes normalPower = S_Lanes::splat(settings.normalPower);
+			const S_Lanes inverseAlbedoSigma2 = S_Lanes::splat(1.0f / std::max(settings.albedoSigma * settings.albedoSigma, 1e-12f));
+			const S_Lanes one = S_Lanes::splat(1.0f);
+			const S_Lanes zero = S_Lanes::splat(0.0f);
+			const S_Lanes luminanceR = S_Lanes::splat(0.2126f);
+			const S_Lanes luminanceG = S_Lanes::splat(0.7152f);
+			const S_Lanes luminanceB = S_Lanes::splat(0.0722f);
+			const ptrdiff_t stride = layout.stride;
+
+			for (uint32_t y = y0; y < y1; ++y) {
+				for (uint32_t x = x0; x < x1; x += LANE_WIDTH) {
+					const size_t p = layout.at(x, y);
+					const S_Lanes cp[3] = { S_Lanes::load(color[0] + p), S_Lanes::load(color[1] + p), S_Lanes::load(color[2] + p) };
+					const S_Lanes ap[3] = { S_Lanes::load(albedo[0] + p), S_Lanes::load(albedo[1] + p), S_Lanes::load(albedo[2] + p) };
+					const S_Lanes np[3] = { S_Lanes::load(normal[0] + p), S_Lanes::load(normal[1] + p), S_Lanes::load(normal[2] + p) };
+					const S_Lanes zp = S_Lanes::load(depth + p);
+					const S_Lanes zScale = S_Lanes::load(depthScale + p);
+					const S_Lanes lp = cp[0] * luminanceR + cp[1] * luminanceG + cp[2] * luminanceB;
+
+					// Noise level from the 3x3 Gaussian of the variance, steadier than the pixel's own
+					S_Lanes blurredVariance = zero;
+					for (int dy = -1; dy <= 1; ++dy) {
+						for (int dx = -1; dx <= 1; ++dx) {
+							const float weight = (dx == 0 ? 0.5f : 0.25f) * (dy == 0 ? 0.5f : 0.25f);
+							blurredVariance = blurredVariance + S_Lanes::splat(weight) * S_Lanes::load(variance + p + dy * stride + dx);
+						}
+					}
+					const S_Lanes inverseLuminanceScale = one / (luminanceSigma * sqrt(max(blurredVariance, zero)) + S_Lanes::splat(1e-4f));
+
+					S_Lanes sum[3] = { zero, zero, zero };
+					S_Lanes sumVariance = zero;
+					S_Lanes sumWeight = zero;
+					for (int ky = -2; ky <= 2; ++ky) {
+						for (int kx = -2; kx <= 2; ++kx) {
+							const size_t q = p + (ky * stride + kx) * static_cast<ptrdiff_t>(step);
+							const float distance = static_cast<float>(step) * std::sqrt(static_cast<float>(kx * kx + ky * ky));
+							const S_Lanes inverseDistance = S_Lanes::splat(distance > 0.0f ? 1.0f / distance : 0.0f);
+
+							const S_Lanes cq[3] = { S_Lanes::load(color[0] + q), S_Lanes::load(color[1] + q), S_Lanes::load(color[2] + q) };
+							const S_Lanes lq = cq[0] * luminanceR + cq[1] * luminanceG + cq[2] * luminanceB;
+							const S_Lanes cosine = np[0] * S_Lanes::load(normal[0] + q) + np[1] * S_Lanes::load(normal[1] + q)
+								+ np[2] * S_Lanes::load(normal[2] + q);
+							const S_Lanes da[3] = { ap[0] - S_Lanes::load(albedo[0] + q), ap[1] - S_Lanes::load(albedo[1] + q),
+								ap[2] - S_Lanes::load(albedo[2] + q) };
+
+							const S_Lanes exponent = abs(lp - lq) * inverseLuminanceScale
+								+ abs(zp - S_Lanes::load(depth + q)) * zScale * inverseDistance
+								+ normalPower * max(one - cosine, zero)
+								+ (da[0] * da[0] + da[1] * da[1] + da[2] * da[2]) * inverseAlbedoSigma2;
+							const S_Lanes weight = S_Lanes::splat(KERNEL[ky + 2] * KERNEL[kx + 2]) * S_Lanes::load(mask + q) * expNegative(exponent);
+
+							sum[0] = sum[0] + weight * cq[0];
+							sum[1] = sum[1] + weight * cq[1];
+							sum[2] = sum[2] + weight * cq[2];
+							sumVariance = sumVariance + weight * weight * S_Lanes::load(variance + q);
+							sumWeight = sumWeight + weight;
+						}
+					}
+
+					// Zero weight only happens on border lanes, which the mask clears anyway
+					const S_Lanes maskP = S_Lanes::load(mask + p);
+					const S_Lanes inverseWeight = maskP / max(sumWeight, S_Lanes::splat(1e-20f));
+					(sum[0] * inverseWeight).store(outColor[0] + p);
+					(sum[1] * inverseWeight).store(outColor[1] + p);
+					(sum[2] * inverseWeight).store(outColor[2] + p);
+					(sumVariance * inverseWeight * inverseWeight * maskP).store(outVariance + p);
+				}
+			}
+		}
+	}
+
+	// S_Denoiser implementations
+	S_Denoiser::S_Denoiser(const S_DenoiserSettings& settings)
+		: settings(settings), planes(planeResource()) {
+		this->settings.iterations = std::clamp(settings.iterations, 1u, 10u);
+		this->settings.tileSize = std::max(LANE_WIDTH, (settings.tileSize + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH);
+	}
+
+	void S_Denoiser::denoise(const S_DenoiserInput& input, std::vector<float>& output) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		const size_t pixelCount = static_cast<size_t>(input.width) * input.height;
+		if (pixelCount == 0 || input.color.size() < pixelCount * 3 || input.albedo.size() < pixelCount * 3
+			|| input.normal.size() < pixelCount * 3 || input.depth.size() < pixelCount
+			|| (!input.variance.empty() && input.variance.size() < pixelCount)) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_Denoiser", "denoise", "Input buffers do not match the image size",
+				input.width, input.height, input.color.size(), input.variance.size());
+		}
+		const auto start = std::chrono::steady_clock::now();
+
+		S_PlaneLayout layout;
+		layout.width = input.width;
+		layout.height = input.height;
+		layout.pad = ((2u << (settings.iterations - 1)) + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH;
+		layout.stride = layout.pad * 2 + (input.width + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH;
+		layout.planeSize = static_cast<size_t>(layout.stride) * (input.height + 2 * layout.pad);
+		planes.assign(layout.planeSize * PLANE_COUNT, 0.0f);
+		auto plane = [&](uint32_t index) { return planes.data() + index * layout.planeSize; };
+		float* colors[2] = { plane(FEATURE_PLANES), plane(FEATURE_PLANES + COLOR_PLANES) };
+
+		// Scatter into planes, dividing color by albedo and the variance by its luminance squared
+		for (uint32_t y = 0; y < input.height; ++y) {
+			for (uint32_t x = 0; x < input.width; ++x) {
+				const size_t i = static_cast<size_t>(y) * input.width + x;
+				const size_t p = layout.at(x, y);
+				float demodulate[3];
+				for (uint32_t c = 0; c < 3; ++c) {
+					const float a = std::max(input.albedo[i * 3 + c], ALBEDO_FLOOR);
+					demodulate[c] = 1.0f / a;
+					plane(ALBEDO_R + c)[p] = a;
+					plane(NORMAL_X + c)[p] = input.normal[i * 3 + c];
+					colors[0][c * layout.planeSize + p] = input.color[i * 3 + c] * demodulate[c];
+				}
+				if (!input.variance.empty()) {
+					const float albedoLuminance = luminance(plane(ALBEDO_R)[p], plane(ALBEDO_G)[p], plane(ALBEDO_B)[p]);
+					colors[0][3 * layout.planeSize + p] = input.variance[i] / (albedoLuminance * albedoLuminance);
+				}
+				plane(DEPTH)[p] = input.depth[i];
+				plane(MASK)[p] = 1.0f;
+			}
+		}
+
+		// Depth weights scale with the local depth gradient, so slanted surfaces still blend
+		for (uint32_t y = 0; y < input.height; ++y) {
+			for (uint32_t x = 0; x < input.width; ++x) {
+				const size_t p = layout.at(x, y);
+				const float z = plane(DEPTH)[p];
+				float gradient = 0.0f;
+				const size_t neighbours[4] = { p - 1, p + 1, p - layout.stride, p + layout.stride };
+				for (size_t n : neighbours) {
+					if (plane(MASK)[n] > 0.0f) {
+						gradient = std::max(gradient, std::abs(plane(DEPTH)[n] - z));
+					}
+				}
+				gradient = std::max(gradient, 1e-3f * std::abs(z) + 1e-6f);
+				plane(DEPTH_SCALE)[p] = 1.0f / (settings.depthSigma * gradient);
+			}
+		}
+
+		// Without a variance buffer, the 3x3 spread of the demodulated luminance stands in
+		if (input.variance.empty()) {
+			const float* color = colors[0];
+			for (uint32_t y = 0; y < input.height; ++y) {
+				for (uint32_t x = 0; x < input.width; ++x) {
+					const size_t p = layout.at(x, y);
+					float sum = 0.0f;
+					float sumSquared = 0.0f;
+					float count = 0.0f;
+					for (int dy = -1; dy <= 1; ++dy) {
+						for (int dx = -1; dx <= 1; ++dx) {
+							const size_t q = p + dy * static_cast<ptrdiff_t>(layout.stride) + dx;
+							if (plane(MASK)[q] > 0.0f) {
+								const float l = luminance(color[q], color[layout.planeSize + q], color[2 * layout.planeSize + q]);
+								sum += l;
+								sumSquared += l * l;
+								count += 1.0f;
+							}
+						}
+					}
+					const float mean = sum / count;
+					colors[0][3 * layout.planeSize + p] = std::max(0.0f, sumSquared / count - mean * mean);
+				}
+			}
+		}
+
+		const uint32_t tilesX = (input.width + settings.tileSize - 1) / settings.tileSize;
+		const uint32_t tilesY = (input.height + settings.tileSize - 1) / settings.tileSize;
+		uint32_t current = 0;
+		for (uint32_t iteration = 0; iteration < settings.iterations; ++iteration) {
+			const uint32_t step = 1u << iteration;
+			const float* source = colors[current];
+			float* target = colors[current ^ 1];
+			core::jobs::S_JobSystem::getInstance().parallelFor(0, static_cast<size_t>(tilesX) * tilesY, [&](size_t begin, size_t end) {
+				for (size_t tile = begin; tile < end; ++tile) {
+					const uint32_t x0 = static_cast<uint32_t>(tile % tilesX) * settings.tileSize;
+					const uint32_t y0 = static_cast<uint32_t>(tile / tilesX) * settings.tileSize;
+					filterTile(layout, settings, planes.data(), step, source, target,
+						x0, std::min(x0 + settings.tileSize, input.width), y0, std::min(y0 + settings.tileSize, input.height));
+				}
+			});
+			current ^= 1;
+		}
+
+		// Multiply the albedo back in
+		output.resize(pixelCount * 3);
+		for (uint32_t y = 0; y < input.height; ++y) {
+			for (uint32_t x = 0; x < input.width; ++x) {
+				const size_t i = static_cast<size_t>(y) * input.width + x;
+				const size_t p = layout.at(x, y);
+				for (uint32_t c = 0; c < 3; ++c) {
+					output[i * 3 + c] = colors[current][c * layout.planeSize + p] * plane(ALBEDO_R + c)[p];
+				}
+			}
+		}
+
+		lastMilliseconds = millisecondsSince(start);
+		Instrumentation::recordTiming(STATS_CATEGORY, "denoise", lastMilliseconds);
+	}
+
+	const S_DenoiserSettings& S_Denoiser::getSettings() const {
+		return settings;
+	}
+
+	double S_Denoiser::getLastMilliseconds() const {
+		return lastMilliseconds;
+	}
+}
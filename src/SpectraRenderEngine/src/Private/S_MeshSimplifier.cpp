@@ -0,0 +1,289 @@
+#include "S_MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace spectra::render::simplify {
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr double NO_COLLAPSE = std::numeric_limits<double>::infinity();
+
+		// Collapses that turn a face by more than this many degrees are rejected with the flips
+		constexpr double MIN_NORMAL_COSINE = 0.05;
+
+		// Symmetric 4x4 matrix of squared distances to a set of planes, upper triangle only
+		struct S_Quadric {
+			double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+			double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+			double a22 = 0.0, a23 = 0.0;
+			double a33 = 0.0;
+
+			static S_Quadric fromPlane(double a, double b, double c, double d) {
+				return { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+			}
+
+			S_Quadric& operator+=(const S_Quadric& other) {
+				a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+				a11 += other.a11; a12 += other.a12; a13 += other.a13;
+				a22 += other.a22; a23 += other.a23;
+				a33 += other.a33;
+				return *this;
+			}
+
+			[[nodiscard]] double evaluate(const double* p) const {
+				const double x = p[0], y = p[1], z = p[2];
+				return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+					+ a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+					+ a22 * z * z + 2.0 * a23 * z + a33;
+			}
+		};
+
+		struct S_Collapse {
+			double cost;
+			uint32_t from;
+			uint32_t to;
+
+			bool operator>(const S_Collapse& other) const { return cost > other.cost; }
+		};
+
+		void cross(const double* a, const double* b, const double* c, double* normal) {
+			const double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			normal[0] = u[1] * v[2] - u[2] * v[1];
+			normal[1] = u[2] * v[0] - u[0] * v[2];
+			normal[2] = u[0] * v[1] - u[1] * v[0];
+		}
+	}
+
+	float simplify(std::span<const S_Vec3> positions, std::span<const uint32_t> indices, std::span<const uint8_t> lockedVertices,
+		uint32_t targetTriangles, std::vector<uint32_t>& result) {
+		result.clear();
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount <= targetTriangles) {
+			result.assign(indices.begin(), indices.end());
+			return 0.0f;
+		}
+
+		// Compact local numbering; positions relative to the first vertex keep the quadrics well conditioned
+		std::vector<uint32_t> globals(indices.begin(), indices.end());
+		std::sort(globals.begin(), globals.end());
+		globals.erase(std::unique(globals.begin(), globals.end()), globals.end());
+		const uint32_t vertexCount = static_cast<uint32_t>(globals.size());
+		auto localOf = [&](uint32_t global) {
+			return static_cast<uint32_t>(std::lower_bound(globals.begin(), globals.end(), global) - globals.begin());
+		};
+
+		const S_Vec3 origin = positions[globals[0]];
+		std::vector<double> points(size_t(vertexCount) * 3);
+		std::vector<uint8_t> locked(vertexCount, 0);
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+			const S_Vec3 position = positions[globals[vertex]] - origin;
+			points[vertex * 3] = position.x;
+			points[vertex * 3 + 1] = position.y;
+			points[vertex * 3 + 2] = position.z;
+			locked[vertex] = lockedVertices[globals[vertex]];
+		}
+
+		std::vector<uint32_t> triangles(indices.size());
+		std::vector<uint8_t> alive(triangleCount, 1);
+		std::vector<S_Quadric> quadrics(vertexCount);
+		std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+		std::vector<std::pair<uint32_t, uint32_t>> edges;
+		edges.reserve(indices.size());
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+			uint32_t* corners = &triangles[size_t(triangle) * 3];
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				corners[corner] = localOf(indices[size_t(triangle) * 3 + corner]);
+				vertexTriangles[corners[corner]].push_back(triangle);
+			}
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				const uint32_t a = corners[corner];
+				const uint32_t b = corners[(corner + 1) % 3];
+				edges.emplace_back(std::min(a, b), std::max(a, b));
+			}
+
+			double normal[3];
+			cross(&points[corners[0] * 3], &points[corners[1] * 3], &points[corners[2] * 3], normal);
+			const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 0.0) {
+				const double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+				const double* p = &points[corners[0] * 3];
+				const S_Quadric plane = S_Quadric::fromPlane(a, b, c, -(a * p[0] + b * p[1] + c * p[2]));
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					quadrics[corners[corner]] += plane;
+				}
+			}
+		}
+
+		// Open and non-manifold edges keep their vertices, which holds group borders and holes in place
+		std::sort(edges.begin(), edges.end());
+		for (size_t i = 0; i < edges.size();) {
+			size_t run = i + 1;
+			while (run < edges.size() && edges[run] == edges[i]) {
+				++run;
+			}
+			if (run - i != 2) {
+				locked[edges[i].first] = 1;
+				locked[edges[i].second] = 1;
+			}
+			i = run;
+		}
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		auto collapseCost = [&](uint32_t from, uint32_t to) {
+			if (locked[from]) {
+				return NO_COLLAPSE;
+			}
+			S_Quadric quadric = quadrics[from];
+			quadric += quadrics[to];
+			return std::max(quadric.evaluate(&points[to * 3]), 0.0);
+		};
+
+		std::priority_queue<S_Collapse, std::vector<S_Collapse>, std::greater<S_Collapse>> queue;
+		auto pushEdge = [&](uint32_t a, uint32_t b) {
+			const double forward = collapseCost(a, b);
+			const double backward = collapseCost(b, a);
+			if (forward < NO_COLLAPSE || backward < NO_COLLAPSE) {
+				queue.push(forward <= backward ? S_Collapse{ forward, a, b } : S_Collapse{ backward, b, a });
+			}
+		};
+		for (const auto& [a, b] : edges) {
+			pushEdge(a, b);
+		}
+
+		std::vector<uint8_t> removed(vertexCount, 0);
+		std::vector<uint32_t> fromNeighbours;
+		std::vector<uint32_t> toNeighbours;
+		auto collectNeighbours = [&](uint32_t vertex, std::vector<uint32_t>& neighbours) {
+			neighbours.clear();
+			for (uint32_t triangle : vertexTriangles[vertex]) {
+				if (alive[triangle]) {
+					for (uint32_t corner = 0; corner < 3; ++corner) {
+						if (triangles[size_t(triangle) * 3 + corner] != vertex) {
+							neighbours.push_back(triangles[size_t(triangle) * 3 + corner]);
+						}
+					}
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		};
+
+		uint32_t liveTriangles = triangleCount;
+		double maxCost = 0.0;
+		while (liveTriangles > targetTriangles && !queue.empty()) {
+			const S_Collapse collapse = queue.top();
+			queue.pop();
+			const uint32_t from = collapse.from;
+			const uint32_t to = collapse.to;
+			if (removed[from] || removed[to]) {
+				continue;
+			}
+			// Quadrics only grow, so a stale entry is requeued at its current cost
+			const double cost = collapseCost(from, to);
+			if (cost == NO_COLLAPSE) {
+				continue;
+			}
+			if (cost > collapse.cost * (1.0 + 1e-9) + 1e-30) {
+				queue.push({ cost, from, to });
+				continue;
+			}
+
+			// The edge must still exist, and the two ends may only share the vertices opposite it
+			uint32_t sharedTriangles = 0;
+			for (uint32_t triangle : vertexTriangles[from]) {
+				const uint32_t* corners = &triangles[size_t(triangle) * 3];
+				sharedTriangles += alive[triangle] && (corners[0] == to || corners[1] == to || corners[2] == to);
+			}
+			if (sharedTriangles == 0) {
+				continue;
+			}
+			collectNeighbours(from, fromNeighbours);
+			collectNeighbours(to, toNeighbours);
+			size_t common = 0;
+			for (size_t i = 0, j = 0; i < fromNeighbours.size() && j < toNeighbours.size();) {
+				if (fromNeighbours[i] == toNeighbours[j]) {
+					++common;
+					++i;
+					++j;
+				}
+				else if (fromNeighbours[i] < toNeighbours[j]) {
+					++i;
+				}
+				else {
+					++j;
+				}
+			}
+			if (common != sharedTriangles) {
+				continue;
+			}
+
+			bool flips = false;
+			for (uint32_t triangle : vertexTriangles[from]) {
+				const uint32_t* corners = &triangles[size_t(triangle) * 3];
+				if (!alive[triangle] || corners[0] == to || corners[1] == to || corners[2] == to) {
+					continue;
+				}
+				const double* moved[3];
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					moved[corner] = &points[(corners[corner] == from ? to : corners[corner]) * 3];
+				}
+				double before[3];
+				double after[3];
+				cross(&points[corners[0] * 3], &points[corners[1] * 3], &points[corners[2] * 3], before);
+				cross(moved[0], moved[1], moved[2], after);
+				const double alignment = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+				const double lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2])
+					* (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+				if (alignment <= MIN_NORMAL_COSINE * lengths) {
+					flips = true;
+					break;
+				}
+			}
+			if (flips) {
+				continue;
+			}
+
+			for (uint32_t triangle : vertexTriangles[from]) {
+				if (!alive[triangle]) {
+					continue;
+				}
+				uint32_t* corners = &triangles[size_t(triangle) * 3];
+				if (corners[0] == to || corners[1] == to || corners[2] == to) {
+					alive[triangle] = 0;
+					--liveTriangles;
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					if (corners[corner] == from) {
+						corners[corner] = to;
+					}
+				}
+				vertexTriangles[to].push_back(triangle);
+			}
+			vertexTriangles[from].clear();
+			std::erase_if(vertexTriangles[to], [&](uint32_t triangle) { return !alive[triangle]; });
+			quadrics[to] += quadrics[from];
+			removed[from] = 1;
+			maxCost = std::max(maxCost, cost);
+
+			collectNeighbours(to, toNeighbours);
+			for (uint32_t neighbour : toNeighbours) {
+				pushEdge(to, neighbour);
+			}
+		}
+
+		result.reserve(size_t(liveTriangles) * 3);
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+			if (alive[triangle]) {
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					result.push_back(globals[triangles[size_t(triangle) * 3 + corner]]);
+				}
+			}
+		}
+		return static_cast<float>(std::sqrt(maxCost));
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "S_Vec3.h"
+
+// Edge collapse simplification under quadric error metrics (Garland and Heckbert 1997), used
+// by S_ClusterDag on one cluster group at a time. Collapses move a vertex onto a neighbour, so
+// the result only uses input vertices and no new positions are made.
+namespace spectra::render::simplify {
+	// Collapses edges of the triangles, cheapest first, until at most targetTriangles remain or
+	// no collapse is possible. Vertices flagged in lockedVertices, and vertices on edges used by
+	// only one triangle, never move. Collapses that flip a triangle or would make the surface
+	// non-manifold are skipped. Writes the remaining triangles and returns the largest distance
+	// error of a collapse, the square root of its quadric cost.
+	float simplify(std::span<const core::math::S_Vec3> positions, std::span<const uint32_t> indices, std::span<const uint8_t> lockedVertices,
+		uint32_t targetTriangles, std::vector<uint32_t>& result);
+}
@@ -0,0 +1,203 @@
+#include "S_Meshlets.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace spectra::render {
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+		S_Vec3 triangleCentroid(std::span<const S_Vec3> positions, const uint32_t* triangle) {
+			return (positions[triangle[0]] + positions[triangle[1]] + positions[triangle[2]]) * (1.0f / 3.0f);
+		}
+	}
+
+	void S_MeshletSet::clear() {
+		meshlets.clear();
+		vertices.clear();
+		triangles.clear();
+	}
+
+	// S_MeshletBuilder implementations
+	void S_MeshletBuilder::build(std::span<const S_Vec3> positions, std::span<const uint32_t> indices, const S_MeshletSettings& settings,
+		S_MeshletSet& set) {
+		if (settings.maxVertices < 3 || settings.maxVertices > 256 || settings.maxTriangles == 0 || indices.size() % 3 != 0) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_MeshletBuilder", "build", "Invalid meshlet limits",
+				settings.maxVertices, settings.maxTriangles);
+		}
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0) {
+			return;
+		}
+
+		// Triangles around each vertex, compressed rows over the vertices the triangles use
+		const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t index : indices) {
+			if (index >= vertexCount) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_MeshletBuilder", "build", "Index out of range", index);
+			}
+			++adjacencyOffsets[index + 1];
+		}
+		for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+			adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+		}
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t i = 0; i < indices.size(); ++i) {
+				adjacency[cursor[indices[i]]++] = i / 3;
+			}
+		}
+
+		std::vector<uint8_t> used(triangleCount, 0);
+		std::vector<uint32_t> candidateOf(triangleCount, NO_SLOT);  // Meshlet whose candidate list holds the triangle
+		std::vector<uint32_t> slots(vertexCount, NO_SLOT);
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> previousCandidates;
+		uint32_t scan = 0;
+
+		while (true) {
+			// Seed next to the previous meshlet when possible, so consecutive meshlets stay close
+			uint32_t seed = NO_SLOT;
+			for (uint32_t triangle : previousCandidates) {
+				if (!used[triangle]) {
+					seed = triangle;
+					break;
+				}
+			}
+			while (seed == NO_SLOT && scan < triangleCount) {
+				if (!used[scan]) {
+					seed = scan;
+				}
+				++scan;
+			}
+			if (seed == NO_SLOT) {
+				break;
+			}
+
+			const uint32_t meshletIndex = static_cast<uint32_t>(set.meshlets.size());
+			S_Meshlet meshlet;
+			meshlet.vertexOffset = static_cast<uint32_t>(set.vertices.size());
+			meshlet.triangleOffset = static_cast<uint32_t>(set.triangles.size());
+			S_Vec3 centroidSum(0.0f);
+			candidates.clear();
+
+			uint32_t next = seed;
+			while (next != NO_SLOT) {
+				const uint32_t* triangle = &indices[size_t(next) * 3];
+				used[next] = 1;
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					const uint32_t vertex = triangle[corner];
+					if (slots[vertex] == NO_SLOT) {
+						slots[vertex] = meshlet.vertexCount++;
+						set.vertices.push_back(vertex);
+					}
+					set.triangles.push_back(static_cast<uint8_t>(slots[vertex]));
+					for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; ++i) {
+						const uint32_t neighbour = adjacency[i];
+						if (!used[neighbour] && candidateOf[neighbour] != meshletIndex) {
+							candidateOf[neighbour] = meshletIndex;
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+				centroidSum += triangleCentroid(positions, triangle);
+				++meshlet.triangleCount;
+				if (meshlet.triangleCount == settings.maxTriangles) {
+					break;
+				}
+
+				// Fewest new vertices first, then nearest the centre; used candidates are dropped
+				const S_Vec3 centroid = centroidSum / static_cast<float>(meshlet.triangleCount);
+				next = NO_SLOT;
+				uint32_t bestNewVertices = 4;
+				float bestDistance = std::numeric_limits<float>::max();
+				size_t kept = 0;
+				for (size_t i = 0; i < candidates.size(); ++i) {
+					const uint32_t candidate = candidates[i];
+					if (used[candidate]) {
+						continue;
+					}
+					candidates[kept++] = candidate;
+					const uint32_t* corners = &indices[size_t(candidate) * 3];
+					const uint32_t newVertices = (slots[corners[0]] == NO_SLOT) + (slots[corners[1]] == NO_SLOT) + (slots[corners[2]] == NO_SLOT);
+					if (meshlet.vertexCount + newVertices > settings.maxVertices || newVertices > bestNewVertices) {
+						continue;
+					}
+					const float distance = core::math::lengthSquared(triangleCentroid(positions, corners) - centroid);
+					if (newVertices < bestNewVertices || distance < bestDistance) {
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+						next = candidate;
+					}
+				}
+				candidates.resize(kept);
+			}
+
+			for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+				slots[set.vertices[meshlet.vertexOffset + i]] = NO_SLOT;
+			}
+			set.meshlets.push_back(meshlet);
+			previousCandidates.swap(candidates);
+		}
+	}
+
+	S_MeshletBounds S_MeshletBuilder::computeBounds(std::span<const S_Vec3> positions, const S_MeshletSet& set, uint32_t meshletIndex) {
+		const S_Meshlet& meshlet = set.meshlets[meshletIndex];
+		S_MeshletBounds bounds;
+		if (meshlet.vertexCount == 0) {
+			return bounds;
+		}
+
+		S_Vec3 minimum(std::numeric_limits<float>::max());
+		S_Vec3 maximum(std::numeric_limits<float>::lowest());
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+			const S_Vec3& position = positions[set.vertices[meshlet.vertexOffset + i]];
+			minimum = core::math::min(minimum, position);
+			maximum = core::math::max(maximum, position);
+		}
+		bounds.center = (minimum + maximum) * 0.5f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+			bounds.radius = std::max(bounds.radius, core::math::length(positions[set.vertices[meshlet.vertexOffset + i]] - bounds.center));
+		}
+
+		// Cone around the mean face normal, spanning every face normal
+		std::vector<S_Vec3> normals;
+		normals.reserve(meshlet.triangleCount);
+		S_Vec3 axis(0.0f);
+		for (uint32_t triangle = 0; triangle < meshlet.triangleCount; ++triangle) {
+			const uint8_t* local = &set.triangles[meshlet.triangleOffset + size_t(triangle) * 3];
+			const S_Vec3& a = positions[set.vertices[meshlet.vertexOffset + local[0]]];
+			const S_Vec3& b = positions[set.vertices[meshlet.vertexOffset + local[1]]];
+			const S_Vec3& c = positions[set.vertices[meshlet.vertexOffset + local[2]]];
+			const S_Vec3 normal = core::math::cross(b - a, c - a);
+			const float area = core::math::length(normal);
+			if (area > 0.0f) {
+				normals.push_back(normal / area);
+				axis += normals.back();
+			}
+		}
+		const float axisLength = core::math::length(axis);
+		if (normals.empty() || axisLength <= 0.0f) {
+			return bounds;
+		}
+		bounds.coneAxis = axis / axisLength;
+		float minimumDot = 1.0f;
+		for (const S_Vec3& normal : normals) {
+			minimumDot = std::min(minimumDot, core::math::dot(normal, bounds.coneAxis));
+		}
+		// Past a hemisphere some face always points at the viewer
+		bounds.coneCutoff = minimumDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+		return bounds;
+	}
+
+	bool S_MeshletBuilder::isBackfacing(const S_MeshletBounds& bounds, const S_Vec3& viewPosition) {
+		const S_Vec3 offset = bounds.center - viewPosition;
+		return core::math::dot(offset, bounds.coneAxis) >= bounds.coneCutoff * core::math::length(offset) + bounds.radius;
+	}
+}
@@ -0,0 +1,649 @@
+#include "S_PathTracer.h"
+#include "S_JobSystem.h"
+#include "S_MemoryTracker.h"
+#include "S_TemporaryPath.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+
+namespace spectra::render {
+	using core::math::S_Ray;
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::pathtracer";
+
+		// Self-intersection guard for secondary rays
+		constexpr float RAY_EPSILON = 1e-4f;
+
+		// Paths shorter than this are never terminated by Russian roulette
+		constexpr uint32_t ROULETTE_START_DEPTH = 3;
+
+		// Sampler dimensions: the pixel jitter, then a fixed block per bounce so sample i of
+		// every decision comes from the same point set whatever happened earlier on the path
+		constexpr uint32_t PIXEL_DIMENSION = 0;
+		constexpr uint32_t LIGHT_SELECT_DIMENSION = 0;
+		constexpr uint32_t LIGHT_POSITION_DIMENSION = 1;
+		constexpr uint32_t BSDF_DIMENSION = 2;
+		constexpr uint32_t ROULETTE_DIMENSION = 3;
+		constexpr uint32_t DIMENSIONS_PER_BOUNCE = 4;
+
+		// Added to a pixel's mean before dividing, keeps near-black pixels from dominating the error
+		constexpr float ERROR_LUMINANCE_FLOOR = 0.05f;
+
+		std::pmr::memory_resource* accumulationResource() {
+			static core::memory::S_TrackedResource resource(core::memory::E_MemoryTag::RENDER);
+			return &resource;
+		}
+
+		S_Vec3 sampleCosineHemisphere(const S_Vec3& normal, float u1, float u2) {
+			const float radius = std::sqrt(u1);
+			const float phi = 2.0f * std::numbers::pi_v<float> * u2;
+			S_Vec3 tangent;
+			S_Vec3 bitangent;
+			core::math::buildOrthonormalBasis(normal, tangent, bitangent);
+			return tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi))
+				+ normal * std::sqrt(std::max(0.0f, 1.0f - u1));
+		}
+
+		S_Vec3 sampleUnitSphere(float u1, float u2) {
+			const float z = 1.0f - 2.0f * u1;
+			const float radius = std::sqrt(std::max(0.0f, 1.0f - z * z));
+			const float phi = 2.0f * std::numbers::pi_v<float> * u2;
+			return { radius * std::cos(phi), radius * std::sin(phi), z };
+		}
+
+		// Unit direction through a surface with relative index eta, normal facing the incoming side
+		S_Vec3 refract(const S_Vec3& direction, const S_Vec3& normal, float eta, float cosTheta) {
+			const S_Vec3 perpendicular = (direction + normal * cosTheta) * eta;
+			const S_Vec3 parallel = normal * -std::sqrt(std::abs(1.0f - core::math::lengthSquared(perpendicular)));
+			return perpendicular + parallel;
+		}
+
+		float schlickReflectance(float cosTheta, float eta) {
+			float r0 = (1.0f - eta) / (1.0f + eta);
+			r0 *= r0;
+			return r0 + (1.0f - r0) * std::pow(1.0f - cosTheta, 5.0f);
+		}
+
+		bool isFinite(const S_Vec3& value) {
+			return std::isfinite(value.x) && std::isfinite(value.y) && std::isfinite(value.z);
+		}
+
+		// Checkpoint layout: header, stats, tile states, then the accumulators tile by tile, all
+		// in native layout. Resuming requires every field but rays to match.
+		constexpr char CHECKPOINT_MAGIC[8] = { 'S', 'P', 'P', 'T', 'C', 'K', 'P', 'T' };
+		constexpr uint32_t CHECKPOINT_VERSION = 2;
+
+		struct S_CheckpointHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t tileSize;
+			uint32_t samplesPerPass;
+			uint32_t minSamples;
+			uint32_t maxSamples;
+			uint32_t maxAdaptiveBoost;
+			uint32_t maxDepth;
+			uint32_t sampler;
+			uint32_t tileCount;
+			float convergenceThreshold;
+			uint64_t seed;
+			uint64_t rays;
+		};
+
+		// Headers are compared with memcmp, so there must be no padding bytes
+		static_assert(sizeof(S_CheckpointHeader) == sizeof(CHECKPOINT_MAGIC) + 11 * sizeof(uint32_t) + sizeof(float) + 2 * sizeof(uint64_t));
+
+		S_CheckpointHeader makeCheckpointHeader(const S_PathTracerSettings& settings, size_t tileCount, uint64_t rays) {
+			S_CheckpointHeader header{};
+			std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+			header.version = CHECKPOINT_VERSION;
+			header.width = settings.width;
+			header.height = settings.height;
+			header.tileSize = settings.tileSize;
+			header.samplesPerPass = settings.samplesPerPass;
+			header.minSamples = settings.minSamples;
+			header.maxSamples = settings.maxSamples;
+			header.maxAdaptiveBoost = settings.maxAdaptiveBoost;
+			header.maxDepth = settings.maxDepth;
+			header.sampler = static_cast<uint32_t>(settings.sampler);
+			header.tileCount = static_cast<uint32_t>(tileCount);
+			header.convergenceThreshold = settings.convergenceThreshold;
+			header.seed = settings.seed;
+			header.rays = rays;
+			return header;
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	// S_PathTracer implementations
+	S_PathTracer::S_PathTracer(const S_PathTracerSettings& settings)
+		: settings(settings), sampler(settings.sampler, settings.seed), accumulators(accumulationResource()) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (settings.width == 0 || settings.height == 0 || settings.tileSize == 0) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_PathTracer", "S_PathTracer", "Image and tile size must be non-zero",
+				settings.width, settings.height, settings.tileSize);
+		}
+		if (settings.samplesPerPass == 0 || settings.maxSamples == 0) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_PathTracer", "S_PathTracer", "Sample counts must be non-zero",
+				settings.samplesPerPass, settings.maxSamples);
+		}
+		if (settings.minSamples > settings.maxSamples) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_PathTracer", "S_PathTracer", "minSamples exceeds maxSamples, clamping",
+				settings.minSamples, settings.maxSamples);
+			this->settings.minSamples = settings.maxSamples;
+		}
+		this->settings.maxAdaptiveBoost = std::max(1u, settings.maxAdaptiveBoost);
+
+		const uint32_t tileSize = this->settings.tileSize;
+		size_t pixelCount = 0;
+		for (uint32_t y = 0; y < settings.height; y += tileSize) {
+			for (uint32_t x = 0; x < settings.width; x += tileSize) {
+				S_TileState tile;
+				tile.x0 = x;
+				tile.y0 = y;
+				tile.x1 = std::min(x + tileSize, settings.width);
+				tile.y1 = std::min(y + tileSize, settings.height);
+				tiles.push_back(tile);
+				tileOffsets.push_back(pixelCount);
+				pixelCount += static_cast<size_t>(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+			}
+		}
+		accumulators.resize(pixelCount);
+		tileStreamed.assign(tiles.size(), 0);
+		tileQueued.assign(tiles.size(), 0);
+	}
+
+	void S_PathTracer::begin(const S_Scene& scene, const S_Camera& camera) {
+		this->scene = &scene;
+		this->camera = &camera;
+		std::fill(accumulators.begin(), accumulators.end(), S_PixelAccumulator{});
+		for (S_TileState& tile : tiles) {
+			tile.samples = 0;
+			tile.error = 0.0f;
+			tile.converged = false;
+		}
+		std::fill(tileStreamed.begin(), tileStreamed.end(), 0);
+		lastCheckpoint = std::chrono::steady_clock::now();
+		raysTraced.store(0, std::memory_order_relaxed);
+		stats = {};
+		stats.tileCount = static_cast<uint32_t>(tiles.size());
+	}
+
+	// Decided on the calling thread between passes so the schedule is deterministic
+	uint32_t S_PathTracer::samplesForPass(const S_TileState& tile) const {
+		uint32_t count = settings.samplesPerPass;
+		if (tile.samples >= settings.minSamples && settings.convergenceThreshold > 0.0f) {
+			const float boost = std::clamp(tile.error / settings.convergenceThreshold, 1.0f, static_cast<float>(settings.maxAdaptiveBoost));
+			count = static_cast<uint32_t>(std::ceil(static_cast<float>(settings.samplesPerPass) * boost));
+		}
+		else if (tile.samples < settings.minSamples) {
+			count = std::max(count, std::min(settings.minSamples - tile.samples, settings.samplesPerPass * settings.maxAdaptiveBoost));
+		}
+		return std::min(count, settings.maxSamples - tile.samples);
+	}
+
+	bool S_PathTracer::renderPass() {
+		if (!scene || !camera) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_PathTracer", "renderPass", "begin() was not called");
+		}
+
+		activeTiles.clear();
+		passSamples.clear();
+		for (uint32_t i = 0; i < tiles.size(); ++i) {
+			if (!tiles[i].converged && tiles[i].samples < settings.maxSamples) {
+				activeTiles.push_back(i);
+				passSamples.push_back(samplesForPass(tiles[i]));
+			}
+		}
+		return runPass();
+	}
+
+	bool S_PathTracer::renderTiles(std::span<const uint32_t> tileIndices) {
+		if (!scene || !camera || tiles.empty()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_PathTracer", "renderTiles", "begin() was not called");
+		}
+
+		// A tile listed twice would be rendered by two workers at once, so repeats are skipped
+		// by stamping each queued tile with the call
+		if (++queueStamp == 0) {
+			std::fill(tileQueued.begin(), tileQueued.end(), 0);
+			queueStamp = 1;
+		}
+		activeTiles.clear();
+		passSamples.clear();
+		for (const uint32_t i : tileIndices) {
+			if (i < tiles.size() && tileQueued[i] != queueStamp && !tiles[i].converged && tiles[i].samples < settings.maxSamples) {
+				tileQueued[i] = queueStamp;
+				activeTiles.push_back(i);
+				passSamples.push_back(samplesForPass(tiles[i]));
+			}
+		}
+		return runPass();
+	}
+
+	void S_PathTracer::setCancelFlag(const std::atomic<bool>* flag) {
+		cancelFlag = flag;
+	}
+
+	bool S_PathTracer::isCancelled() const {
+		return cancelFlag && cancelFlag->load(std::memory_order_relaxed);
+	}
+
+	// Renders activeTiles with passSamples
+	bool S_PathTracer::runPass() {
+		if (activeTiles.empty() || isCancelled()) {
+			streamFinishedTiles();
+			return false;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		core::jobs::S_JobSystem::getInstance().parallelFor(0, activeTiles.size(), [this](size_t begin, size_t end) {
+			for (size_t i = begin; i < end && !isCancelled(); ++i) {
+				renderTile(activeTiles[i], passSamples[i]);
+			}
+		});
+		const double passMilliseconds = millisecondsSince(start);
+		if (isCancelled()) {
+			return false;
+		}
+
+		stats.passes++;
+		stats.renderMilliseconds += passMilliseconds;
+		stats.rays = raysTraced.load(std::memory_order_relaxed);
+		stats.convergedTiles = 0;
+		stats.pixelSamples = 0;
+		for (const S_TileState& tile : tiles) {
+			stats.convergedTiles += tile.converged ? 1 : 0;
+			stats.pixelSamples += static_cast<uint64_t>(tile.samples) * (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+		}
+		stats.megaRaysPerSecond = stats.renderMilliseconds > 0.0
+			? static_cast<double>(stats.rays) / (stats.renderMilliseconds * 1000.0)
+			: 0.0;
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "pass", passMilliseconds);
+
+		streamFinishedTiles();
+		if (checkpointInterval > 0.0 && millisecondsSince(lastCheckpoint) >= checkpointInterval * 1000.0) {
+			saveCheckpoint(checkpointPath);
+			lastCheckpoint = std::chrono::steady_clock::now();
+		}
+		return true;
+	}
+
+	void S_PathTracer::render(const S_Scene& scene, const S_Camera& camera) {
+		begin(scene, camera);
+		while (renderPass()) {
+		}
+	}
+
+	bool S_PathTracer::isComplete() const {
+		return std::all_of(tiles.begin(), tiles.end(), [this](const S_TileState& tile) {
+			return tile.converged || tile.samples >= settings.maxSamples;
+		});
+	}
+
+	void S_PathTracer::renderTile(uint32_t tileIndex, uint32_t sampleCount) {
+		S_TileState& tile = tiles[tileIndex];
+		const float inverseWidth = 1.0f / static_cast<float>(settings.width);
+		const float inverseHeight = 1.0f / static_cast<float>(settings.height);
+		const uint32_t firstSample = tile.samples;
+		const uint32_t totalSamples = firstSample + sampleCount;
+		uint64_t rays = 0;
+		double errorSum = 0.0;
+
+		S_PixelAccumulator* pixels = accumulators.data() + tileOffsets[tileIndex];
+		for (uint32_t y = tile.y0; y < tile.y1; ++y) {
+			// Abandons the tile without counting its samples
+			if (isCancelled()) {
+				return;
+			}
+			for (uint32_t x = tile.x0; x < tile.x1; ++x) {
+				S_PixelAccumulator& pixel = *pixels++;
+
+				for (uint32_t sample = firstSample; sample < totalSamples; ++sample) {
+					const S_PixelSample pixelSample{ x, y, sample };
+					const S_Sample2D jitter = sampler.get2D(pixelSample, PIXEL_DIMENSION);
+					const float u = (static_cast<float>(x) + jitter.u) * inverseWidth;
+					const float v = (static_cast<float>(y) + jitter.v) * inverseHeight;
+					S_Vec3 radiance = tracePath(camera->generateRay(u, v), pixelSample, pixel, rays);
+					if (!isFinite(radiance)) {
+						radiance = S_Vec3(0.0f);
+					}
+
+					const float sampleLuminance = core::math::luminance(radiance);
+					pixel.radiance += radiance;
+					pixel.luminance += sampleLuminance;
+					pixel.luminanceSquared += sampleLuminance * sampleLuminance;
+				}
+
+				// Relative standard error of the pixel mean
+				if (totalSamples > 1) {
+					const float n = static_cast<float>(totalSamples);
+					const float mean = pixel.luminance / n;
+					const float variance = std::max(0.0f, pixel.luminanceSquared / n - mean * mean) * n / (n - 1.0f);
+					errorSum += std::sqrt(variance / n) / (mean + ERROR_LUMINANCE_FLOOR);
+				}
+			}
+		}
+
+		const uint32_t pixelCount = (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+		tile.samples = totalSamples;
+		tile.error = totalSamples > 1 ? static_cast<float>(errorSum / pixelCount) : 1.0f;
+		tile.converged = settings.convergenceThreshold > 0.0f && tile.samples >= settings.minSamples
+			&& tile.error <= settings.convergenceThreshold;
+		raysTraced.fetch_add(rays, std::memory_order_relaxed);
+	}
+
+	S_Vec3 S_PathTracer::tracePath(S_Ray ray, S_PixelSample pixelSample, S_PixelAccumulator& pixel, uint64_t& rays) const {
+		S_Vec3 radiance(0.0f);
+		S_Vec3 throughput(1.0f);
+		bool lightSampled = false;  // The previous vertex already sampled emissive triangles directly
+
+		for (uint32_t depth = 0;; ++depth) {
+			++rays;
+			S_Hit hit;
+			if (!scene->intersect(ray, hit)) {
+				radiance += throughput * scene->sky(ray.direction);
+				if (depth == 0) {
+					pixel.albedo += S_Vec3(1.0f);
+				}
+				break;
+			}
+
+			const S_SurfaceMaterial& material = scene->getMaterial(hit.material);
+			if (depth == 0) {
+				pixel.albedo += material.albedo;
+				pixel.normal += hit.normal;
+				pixel.depth += hit.t;
+			}
+			if (!(lightSampled && hit.sampledEmitter)) {
+				radiance += throughput * material.emission;
+			}
+			if (depth >= settings.maxDepth) {
+				break;
+			}
+
+			const uint32_t dimension = PIXEL_DIMENSION + 1 + depth * DIMENSIONS_PER_BOUNCE;
+			S_Vec3 direction;
+			lightSampled = false;
+			switch (material.type) {
+			case E_SurfaceType::DIFFUSE: {
+				S_LightSample light;
+				const float uSelect = sampler.get1D(pixelSample, dimension + LIGHT_SELECT_DIMENSION);
+				const S_Sample2D uLight = sampler.get2D(pixelSample, dimension + LIGHT_POSITION_DIMENSION);
+				if (scene->sampleLight(uSelect, uLight.u, uLight.v, light)) {
+					lightSampled = true;
+					S_Vec3 toLight = light.position - hit.position;
+					const float distanceSquared = core::math::lengthSquared(toLight);
+					const float distance = std::sqrt(distanceSquared);
+					toLight /= distance;
+					const float cosSurface = core::math::dot(hit.normal, toLight);
+					const float cosLight = std::abs(core::math::dot(light.normal, toLight));
+					if (cosSurface > 0.0f && cosLight > 0.0f) {
+						++rays;
+						if (!scene->occluded(S_Ray{ hit.position, toLight, RAY_EPSILON, distance * (1.0f - RAY_EPSILON) })) {
+							const float geometry = cosSurface * cosLight / (distanceSquared * light.pdfArea);
+							radiance += throughput * material.albedo * light.emission * (geometry * std::numbers::inv_pi_v<float>);
+						}
+					}
+				}
+
+				const S_Sample2D uBsdf = sampler.get2D(pixelSample, dimension + BSDF_DIMENSION);
+				direction = sampleCosineHemisphere(hit.normal, uBsdf.u, uBsdf.v);
+				break;
+			}
+			case E_SurfaceType::METAL: {
+				const S_Sample2D uBsdf = sampler.get2D(pixelSample, dimension + BSDF_DIMENSION);
+				direction = core::math::reflect(ray.direction, hit.normal) + sampleUnitSphere(uBsdf.u, uBsdf.v) * material.roughness;
+				if (core::math::dot(direction, hit.normal) <= 0.0f) {
+					return radiance;
+				}
+				direction = core::math::normalize(direction);
+				break;
+			}
+			case E_SurfaceType::DIELECTRIC: {
+				const float eta = hit.frontFace ? 1.0f / material.ior : material.ior;
+				const float cosTheta = std::min(core::math::dot(-ray.direction, hit.normal), 1.0f);
+				const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+				const bool reflects = eta * sinTheta > 1.0f || schlickReflectance(cosTheta, eta) > sampler.get1D(pixelSample, dimension + BSDF_DIMENSION);
+				direction = reflects
+					? core::math::reflect(ray.direction, hit.normal)
+					: core::math::normalize(refract(ray.direction, hit.normal, eta, cosTheta));
+				break;
+			}
+			}
+			throughput *= material.albedo;
+
+			if (depth >= ROULETTE_START_DEPTH) {
+				const float survival = std::clamp(core::math::maxComponent(throughput), 0.05f, 1.0f);
+				if (sampler.get1D(pixelSample, dimension + ROULETTE_DIMENSION) >= survival) {
+					break;
+				}
+				throughput /= survival;
+			}
+
+			ray = S_Ray{ hit.position, direction, RAY_EPSILON };
+		}
+		return radiance;
+	}
+
+	void S_PathTracer::resolve(std::vector<float>& rgb) const {
+		rgb.resize(accumulators.size() * 3);
+		for (uint32_t t = 0; t < tiles.size(); ++t) {
+			resolveTile(t, rgb);
+		}
+	}
+
+	void S_PathTracer::resolveTile(uint32_t tileIndex, std::span<float> rgb) const {
+		const S_TileState& tile = tiles[tileIndex];
+		const float scale = tile.samples > 0 ? 1.0f / static_cast<float>(tile.samples) : 0.0f;
+		const S_PixelAccumulator* pixel = accumulators.data() + tileOffsets[tileIndex];
+		for (uint32_t y = tile.y0; y < tile.y1; ++y) {
+			for (uint32_t x = tile.x0; x < tile.x1; ++x, ++pixel) {
+				const size_t pixelIndex = static_cast<size_t>(y) * settings.width + x;
+				const S_Vec3 value = pixel->radiance * scale;
+				rgb[pixelIndex * 3 + 0] = value.x;
+				rgb[pixelIndex * 3 + 1] = value.y;
+				rgb[pixelIndex * 3 + 2] = value.z;
+			}
+		}
+	}
+
+	void S_PathTracer::resolveFeatures(S_PathTracerFeatures& features) const {
+		const size_t pixelCount = accumulators.size();
+		features.albedo.resize(pixelCount * 3);
+		features.normal.resize(pixelCount * 3);
+		features.depth.resize(pixelCount);
+		features.variance.resize(pixelCount);
+		for (size_t t = 0; t < tiles.size(); ++t) {
+			const S_TileState& tile = tiles[t];
+			const float n = static_cast<float>(tile.samples);
+			const float scale = tile.samples > 0 ? 1.0f / n : 0.0f;
+			const S_PixelAccumulator* pixel = accumulators.data() + tileOffsets[t];
+			for (uint32_t y = tile.y0; y < tile.y1; ++y) {
+				for (uint32_t x = tile.x0; x < tile.x1; ++x, ++pixel) {
+					const size_t pixelIndex = static_cast<size_t>(y) * settings.width + x;
+					const S_Vec3 albedo = pixel->albedo * scale;
+					const float normalLength = core::math::length(pixel->normal);
+					const S_Vec3 normal = normalLength > 0.0f ? pixel->normal / normalLength : S_Vec3(0.0f);
+					for (int c = 0; c < 3; ++c) {
+						features.albedo[pixelIndex * 3 + c] = albedo[c];
+						features.normal[pixelIndex * 3 + c] = normal[c];
+					}
+					features.depth[pixelIndex] = pixel->depth * scale;
+
+					const float mean = pixel->luminance * scale;
+					features.variance[pixelIndex] = tile.samples > 1
+						? std::max(0.0f, pixel->luminanceSquared * scale - mean * mean) / (n - 1.0f)
+						: 0.0f;
+				}
+			}
+		}
+	}
+
+	void S_PathTracer::setOutput(S_TiledImageWriter* writer) {
+		if (writer && (writer->getWidth() != settings.width || writer->getHeight() != settings.height
+			|| writer->getTileSize() != settings.tileSize)) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_PathTracer", "setOutput",
+				"Writer does not match the image and tile size, ignoring it", writer->getWidth(), writer->getHeight(), writer->getTileSize());
+			writer = nullptr;
+		}
+		output = writer;
+		std::fill(tileStreamed.begin(), tileStreamed.end(), 0);
+	}
+
+	// Tiles are written in index order on the calling thread, one tile of scratch at a time
+	void S_PathTracer::streamFinishedTiles() {
+		if (!output) {
+			return;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		uint32_t streamed = 0;
+		for (size_t t = 0; t < tiles.size(); ++t) {
+			const S_TileState& tile = tiles[t];
+			if (tileStreamed[t] || tile.samples == 0 || !(tile.converged || tile.samples >= settings.maxSamples)) {
+				continue;
+			}
+			const size_t pixelCount = static_cast<size_t>(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+			const float scale = 1.0f / static_cast<float>(tile.samples);
+			const S_PixelAccumulator* pixels = accumulators.data() + tileOffsets[t];
+			tileScratch.resize(pixelCount * 3);
+			for (size_t i = 0; i < pixelCount; ++i) {
+				const S_Vec3 value = pixels[i].radiance * scale;
+				tileScratch[i * 3 + 0] = value.x;
+				tileScratch[i * 3 + 1] = value.y;
+				tileScratch[i * 3 + 2] = value.z;
+			}
+			output->writeTile(tile.x0 / settings.tileSize, tile.y0 / settings.tileSize, tileScratch);
+			tileStreamed[t] = 1;
+			++streamed;
+		}
+		if (streamed > 0) {
+			instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "stream", millisecondsSince(start));
+		}
+	}
+
+	void S_PathTracer::setCheckpoint(const std::string& path, double intervalSeconds) {
+		checkpointPath = path;
+		checkpointInterval = path.empty() ? 0.0 : intervalSeconds;
+		lastCheckpoint = std::chrono::steady_clock::now();
+	}
+
+	bool S_PathTracer::saveCheckpoint(const std::string& path) const {
+		const auto start = std::chrono::steady_clock::now();
+		const S_CheckpointHeader header = makeCheckpointHeader(settings, tiles.size(), raysTraced.load(std::memory_order_relaxed));
+
+		const std::string temporaryPath = core::platform::S_TemporaryPath::make(path);
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(&stats), sizeof(stats));
+			stream.write(reinterpret_cast<const char*>(tiles.data()), static_cast<std::streamsize>(tiles.size() * sizeof(S_TileState)));
+			stream.write(reinterpret_cast<const char*>(accumulators.data()),
+				static_cast<std::streamsize>(accumulators.size() * sizeof(S_PixelAccumulator)));
+			if (!stream) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_PathTracer", "saveCheckpoint",
+					"Could not write checkpoint", temporaryPath);
+				stream.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_PathTracer", "saveCheckpoint",
+				"Could not replace checkpoint", path, error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "checkpoint", millisecondsSince(start));
+		return true;
+	}
+
+	bool S_PathTracer::loadCheckpoint(const std::string& path) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (!scene || !camera) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_PathTracer", "loadCheckpoint", "begin() was not called");
+		}
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream) {
+			return false;
+		}
+
+		S_CheckpointHeader header{};
+		stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		const S_CheckpointHeader expected = makeCheckpointHeader(settings, tiles.size(), header.rays);
+		if (!stream || std::memcmp(&header, &expected, sizeof(header)) != 0) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_PathTracer", "loadCheckpoint", "Ignoring checkpoint from other settings", path);
+			return false;
+		}
+
+		// Read into copies so a truncated file leaves the render as it was
+		S_PathTracerStats loadedStats;
+		std::vector<S_TileState> loadedTiles(tiles.size());
+		stream.read(reinterpret_cast<char*>(&loadedStats), sizeof(loadedStats));
+		stream.read(reinterpret_cast<char*>(loadedTiles.data()), static_cast<std::streamsize>(loadedTiles.size() * sizeof(S_TileState)));
+		if (!stream) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_PathTracer", "loadCheckpoint", "Checkpoint is truncated", path);
+			return false;
+		}
+		std::pmr::vector<S_PixelAccumulator> loadedAccumulators(accumulators.size(), accumulationResource());
+		stream.read(reinterpret_cast<char*>(loadedAccumulators.data()),
+			static_cast<std::streamsize>(loadedAccumulators.size() * sizeof(S_PixelAccumulator)));
+		if (!stream) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_PathTracer", "loadCheckpoint", "Checkpoint is truncated", path);
+			return false;
+		}
+
+		stats = loadedStats;
+		tiles = std::move(loadedTiles);
+		accumulators.swap(loadedAccumulators);
+		raysTraced.store(header.rays, std::memory_order_relaxed);
+		std::fill(tileStreamed.begin(), tileStreamed.end(), 0);
+		lastCheckpoint = std::chrono::steady_clock::now();
+		Instrumentation::logRender(E_LogLevel::INFO, "S_PathTracer", "loadCheckpoint", "Resumed from checkpoint", path, stats.passes);
+		return true;
+	}
+
+	const S_PathTracerSettings& S_PathTracer::getSettings() const {
+		return settings;
+	}
+
+	const std::vector<S_TileState>& S_PathTracer::getTiles() const {
+		return tiles;
+	}
+
+	S_PathTracerStats S_PathTracer::getStats() const {
+		return stats;
+	}
+
+	void S_PathTracer::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "passes", static_cast<double>(stats.passes));
+		Instrumentation::setGauge(STATS_CATEGORY, "tileCount", static_cast<double>(stats.tileCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "convergedTiles", static_cast<double>(stats.convergedTiles));
+		Instrumentation::setGauge(STATS_CATEGORY, "pixelSamples", static_cast<double>(stats.pixelSamples));
+		Instrumentation::setGauge(STATS_CATEGORY, "rays", static_cast<double>(stats.rays));
+		Instrumentation::setGauge(STATS_CATEGORY, "renderMilliseconds", stats.renderMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "megaRaysPerSecond", stats.megaRaysPerSecond);
+	}
+}
@@ -0,0 +1,309 @@
+#include "S_QuantizedMesh.h"
+#include "S_VertexKernels.h"
+#include "S_JobSystem.h"
+#include "S_MemoryTracker.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace spectra::render {
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::vertices";
+		constexpr size_t PARALLEL_GRAIN = 4096;
+
+		// Bits of presentStreams
+		constexpr uint32_t POSITIONS = 1u << 0;
+		constexpr uint32_t NORMALS = 1u << 1;
+		constexpr uint32_t TANGENTS = 1u << 2;
+		constexpr uint32_t UVS = 1u << 3;
+		constexpr uint32_t WEIGHTS = 1u << 4;
+		constexpr uint32_t JOINTS = 1u << 5;
+
+		// Decoding an octahedral coordinate moves the direction by at most about three times
+		// the coordinate error, the stretch of the projection where the faces fold
+		constexpr double OCTAHEDRAL_STRETCH = 3.0;
+
+		std::pmr::memory_resource* geometryResource() {
+			static core::memory::S_TrackedResource resource(core::memory::E_MemoryTag::GEOMETRY);
+			return &resource;
+		}
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		E_SimdLevel resolveLevel(E_SimdLevel level) {
+			const E_SimdLevel best = S_RayStream::getBestSimdLevel();
+			if (level == E_SimdLevel::BEST || static_cast<uint8_t>(level) > static_cast<uint8_t>(best)) {
+				level = best;
+			}
+			return level;
+		}
+
+		// Calls run(begin, end, packets) for each job's range, split into whole packets of width and the rest
+		template<typename F>
+		void forEachPacketRange(uint32_t count, uint32_t width, F&& run) {
+			core::jobs::S_JobSystem::getInstance().parallelFor(0, count, [&](size_t begin, size_t end) {
+				const uint32_t first = static_cast<uint32_t>(begin);
+				const uint32_t last = static_cast<uint32_t>(end);
+				const uint32_t split = first + (last - first) / width * width;
+				if (split > first) {
+					run(first, split, true);
+				}
+				if (last > split) {
+					run(split, last, false);
+				}
+			}, PARALLEL_GRAIN);
+		}
+
+		// Range to unorm16: offset is the minimum, scale one step, inverseScale steps per unit
+		void fitRange(float minimum, float maximum, float& offset, float& scale, float& inverseScale) {
+			offset = minimum;
+			const float extent = maximum - minimum;
+			scale = extent > 0.0f ? extent / 65535.0f : 0.0f;
+			inverseScale = extent > 0.0f ? 65535.0f / extent : 0.0f;
+		}
+
+		// Half a step, with slack for the rounding of the float arithmetic around it
+		float rangeError(float offset, float scale) {
+			const float magnitude = std::max(std::fabs(offset), std::fabs(offset + scale * 65535.0f));
+			return scale * 0.51f + magnitude * 2.0f * std::numeric_limits<float>::epsilon();
+		}
+
+		double angleDegrees(const S_Vec3& a, const S_Vec3& b) {
+			const double ax = a.x, ay = a.y, az = a.z;
+			const double bx = b.x, by = b.y, bz = b.z;
+			const double cx = ay * bz - az * by;
+			const double cy = az * bx - ax * bz;
+			const double cz = ax * by - ay * bx;
+			return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz) * 180.0 / std::numbers::pi;
+		}
+	}
+
+	// S_QuantizedMesh implementations
+	S_QuantizedMesh::S_QuantizedMesh() : vertices(geometryResource()) {
+	}
+
+	void S_QuantizedMesh::encode(const S_VertexStreams& streams, E_SimdLevel level) {
+		const auto start = std::chrono::steady_clock::now();
+
+		size_t count = 0;
+		const size_t counts[] = { streams.positions.size(), streams.normals.size(), streams.tangents.size() / 4,
+			streams.uvs.size() / 2, streams.weights.size() / 4, streams.joints.size() / 4 };
+		const size_t sizes[] = { streams.positions.size(), streams.normals.size(), streams.tangents.size(),
+			streams.uvs.size(), streams.weights.size(), streams.joints.size() };
+		const size_t components[] = { 1, 1, 4, 2, 4, 4 };
+		presentStreams = 0;
+		for (uint32_t stream = 0; stream < 6; ++stream) {
+			if (sizes[stream] == 0) {
+				continue;
+			}
+			if (sizes[stream] % components[stream] != 0 || (count != 0 && counts[stream] != count)) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_QuantizedMesh", "encode",
+					"Vertex streams differ in length", stream, static_cast<uint64_t>(sizes[stream]));
+			}
+			count = counts[stream];
+			presentStreams |= 1u << stream;
+		}
+		if (count > std::numeric_limits<uint32_t>::max()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_QuantizedMesh", "encode", "Too many vertices",
+				static_cast<uint64_t>(count));
+		}
+		const uint32_t vertexCount = static_cast<uint32_t>(count);
+
+		kernels::S_VertexEncodeInput input;
+		positionOffset = S_Vec3(0.0f);
+		positionScale = S_Vec3(0.0f);
+		if (!streams.positions.empty()) {
+			S_Vec3 minimum(std::numeric_limits<float>::max());
+			S_Vec3 maximum(std::numeric_limits<float>::lowest());
+			for (const S_Vec3& position : streams.positions) {
+				for (int axis = 0; axis < 3; ++axis) {
+					minimum[axis] = std::min(minimum[axis], position[axis]);
+					maximum[axis] = std::max(maximum[axis], position[axis]);
+				}
+			}
+			for (int axis = 0; axis < 3; ++axis) {
+				fitRange(minimum[axis], maximum[axis], positionOffset[axis], positionScale[axis], input.positionInverseScale[axis]);
+				input.positionOffset[axis] = positionOffset[axis];
+			}
+			input.positions = &streams.positions[0].x;
+		}
+		uvOffset[0] = uvOffset[1] = uvScale[0] = uvScale[1] = 0.0f;
+		if (!streams.uvs.empty()) {
+			for (uint32_t axis = 0; axis < 2; ++axis) {
+				float minimum = std::numeric_limits<float>::max();
+				float maximum = std::numeric_limits<float>::lowest();
+				for (size_t i = axis; i < streams.uvs.size(); i += 2) {
+					minimum = std::min(minimum, streams.uvs[i]);
+					maximum = std::max(maximum, streams.uvs[i]);
+				}
+				fitRange(minimum, maximum, uvOffset[axis], uvScale[axis], input.uvInverseScale[axis]);
+				input.uvOffset[axis] = uvOffset[axis];
+			}
+			input.uvs = streams.uvs.data();
+		}
+		input.normals = streams.normals.empty() ? nullptr : &streams.normals[0].x;
+		input.tangents = streams.tangents.empty() ? nullptr : streams.tangents.data();
+		input.weights = streams.weights.empty() ? nullptr : streams.weights.data();
+		input.joints = streams.joints.empty() ? nullptr : streams.joints.data();
+
+		vertices.resize(vertexCount);
+		uint32_t* packed = reinterpret_cast<uint32_t*>(vertices.data());
+		kernels::VertexEncodeKernel kernel = nullptr;
+#if defined(SPECTRA_X86_KERNELS)
+		if (resolveLevel(level) != E_SimdLevel::SCALAR) {
+			kernel = kernels::encodeVerticesAvx2;
+		}
+#endif
+		forEachPacketRange(vertexCount, kernel ? 8 : 1, [&](uint32_t begin, uint32_t end, bool packets) {
+			(packets && kernel ? kernel : kernels::encodeVerticesScalar)(input, packed, begin, end);
+		});
+
+		stats.vertexCount = vertexCount;
+		stats.packedBytes = vertices.size() * sizeof(S_PackedVertex);
+		stats.floatBytes = sizeof(S_Vec3) * (streams.positions.size() + streams.normals.size())
+			+ sizeof(float) * (streams.tangents.size() + streams.uvs.size() + streams.weights.size()) + streams.joints.size();
+		stats.encodeMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "encode", stats.encodeMilliseconds);
+	}
+
+	void S_QuantizedMesh::decode(S_DecodedVertices& decoded, E_SimdLevel level) const {
+		const auto start = std::chrono::steady_clock::now();
+		const uint32_t vertexCount = getVertexCount();
+		decoded.positions.resize(presentStreams & POSITIONS ? vertexCount : 0);
+		decoded.normals.resize(presentStreams & NORMALS ? vertexCount : 0);
+		decoded.tangents.resize(presentStreams & TANGENTS ? size_t(vertexCount) * 4 : 0);
+		decoded.uvs.resize(presentStreams & UVS ? size_t(vertexCount) * 2 : 0);
+		decoded.weights.resize(presentStreams & WEIGHTS ? size_t(vertexCount) * 4 : 0);
+		decoded.joints.resize(presentStreams & JOINTS ? size_t(vertexCount) * 4 : 0);
+
+		kernels::S_VertexDecodeOutput output;
+		output.positions = decoded.positions.empty() ? nullptr : &decoded.positions[0].x;
+		output.normals = decoded.normals.empty() ? nullptr : &decoded.normals[0].x;
+		output.tangents = decoded.tangents.empty() ? nullptr : decoded.tangents.data();
+		output.uvs = decoded.uvs.empty() ? nullptr : decoded.uvs.data();
+		output.weights = decoded.weights.empty() ? nullptr : decoded.weights.data();
+		output.joints = decoded.joints.empty() ? nullptr : decoded.joints.data();
+		for (int axis = 0; axis < 3; ++axis) {
+			output.positionOffset[axis] = positionOffset[axis];
+			output.positionScale[axis] = positionScale[axis];
+		}
+		for (uint32_t axis = 0; axis < 2; ++axis) {
+			output.uvOffset[axis] = uvOffset[axis];
+			output.uvScale[axis] = uvScale[axis];
+		}
+
+		const uint32_t* packed = reinterpret_cast<const uint32_t*>(vertices.data());
+		kernels::VertexDecodeKernel kernel = nullptr;
+#if defined(SPECTRA_X86_KERNELS)
+		if (resolveLevel(level) != E_SimdLevel::SCALAR) {
+			kernel = kernels::decodeVerticesAvx2;
+		}
+#endif
+		forEachPacketRange(vertexCount, kernel ? 8 : 1, [&](uint32_t begin, uint32_t end, bool packets) {
+			(packets && kernel ? kernel : kernels::decodeVerticesScalar)(packed, output, begin, end);
+		});
+
+		stats.decodeMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "decode", stats.decodeMilliseconds);
+	}
+
+	const std::pmr::vector<S_PackedVertex>& S_QuantizedMesh::getVertices() const {
+		return vertices;
+	}
+
+	uint32_t S_QuantizedMesh::getVertexCount() const {
+		return static_cast<uint32_t>(vertices.size());
+	}
+
+	const S_Vec3& S_QuantizedMesh::getPositionOffset() const {
+		return positionOffset;
+	}
+
+	const S_Vec3& S_QuantizedMesh::getPositionScale() const {
+		return positionScale;
+	}
+
+	const float* S_QuantizedMesh::getUvOffset() const {
+		return uvOffset;
+	}
+
+	const float* S_QuantizedMesh::getUvScale() const {
+		return uvScale;
+	}
+
+	S_VertexErrorBounds S_QuantizedMesh::getErrorBounds() const {
+		S_VertexErrorBounds bounds;
+		if (presentStreams & POSITIONS) {
+			for (int axis = 0; axis < 3; ++axis) {
+				bounds.position = std::max(bounds.position, rangeError(positionOffset[axis], positionScale[axis]));
+			}
+		}
+		if (presentStreams & NORMALS) {
+			bounds.normalDegrees = static_cast<float>(OCTAHEDRAL_STRETCH / 32767.0 * 180.0 / std::numbers::pi);
+		}
+		if (presentStreams & TANGENTS) {
+			bounds.tangentDegrees = static_cast<float>(OCTAHEDRAL_STRETCH / 16383.0 * 180.0 / std::numbers::pi);
+		}
+		if (presentStreams & UVS) {
+			bounds.uv = std::max(rangeError(uvOffset[0], uvScale[0]), rangeError(uvOffset[1], uvScale[1]));
+		}
+		if (presentStreams & WEIGHTS) {
+			bounds.weight = 1.0f / 15.0f + 1e-6f;
+		}
+		return bounds;
+	}
+
+	S_VertexErrorBounds S_QuantizedMesh::measureError(const S_VertexStreams& original, const S_DecodedVertices& decoded) {
+		S_VertexErrorBounds error;
+		for (size_t i = 0; i < std::min(original.positions.size(), decoded.positions.size()); ++i) {
+			for (int axis = 0; axis < 3; ++axis) {
+				error.position = std::max(error.position, std::fabs(original.positions[i][axis] - decoded.positions[i][axis]));
+			}
+		}
+		for (size_t i = 0; i < std::min(original.normals.size(), decoded.normals.size()); ++i) {
+			error.normalDegrees = std::max(error.normalDegrees, static_cast<float>(angleDegrees(original.normals[i], decoded.normals[i])));
+		}
+		for (size_t i = 0; i + 3 < std::min(original.tangents.size(), decoded.tangents.size()); i += 4) {
+			const S_Vec3 a(original.tangents[i], original.tangents[i + 1], original.tangents[i + 2]);
+			const S_Vec3 b(decoded.tangents[i], decoded.tangents[i + 1], decoded.tangents[i + 2]);
+			const bool flipped = (original.tangents[i + 3] < 0.0f) != (decoded.tangents[i + 3] < 0.0f);
+			error.tangentDegrees = std::max(error.tangentDegrees, flipped ? 180.0f : static_cast<float>(angleDegrees(a, b)));
+		}
+		for (size_t i = 0; i < std::min(original.uvs.size(), decoded.uvs.size()); ++i) {
+			error.uv = std::max(error.uv, std::fabs(original.uvs[i] - decoded.uvs[i]));
+		}
+		for (size_t i = 0; i + 3 < std::min(original.weights.size(), decoded.weights.size()); i += 4) {
+			double sum = 0.0;
+			for (size_t lane = 0; lane < 4; ++lane) {
+				sum += std::max(original.weights[i + lane], 0.0f);
+			}
+			for (size_t lane = 0; lane < 4; ++lane) {
+				const double exact = sum > 0.0 ? std::max(original.weights[i + lane], 0.0f) / sum : 0.0;
+				error.weight = std::max(error.weight, static_cast<float>(std::fabs(exact - decoded.weights[i + lane])));
+			}
+		}
+		return error;
+	}
+
+	const S_QuantizedMeshStats& S_QuantizedMesh::getStats() const {
+		return stats;
+	}
+
+	void S_QuantizedMesh::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "encodeMilliseconds", stats.encodeMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "decodeMilliseconds", stats.decodeMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "vertices", static_cast<double>(stats.vertexCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "packedBytes", static_cast<double>(stats.packedBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "floatBytes", static_cast<double>(stats.floatBytes));
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+#include "S_Bvh.h"
+#include "S_Scene.h"
+
+// Interface between S_Scene and the packet traversal kernels. Each instruction set lives in
+// its own translation unit compiled for that set, so everything crossing this boundary is
+// plain pointers: no inline library code is shared with the baseline build.
+namespace spectra::render::kernels {
+	struct S_StreamGeometry {
+		const void* nodes = nullptr;  // S_WideBvhNode<width>
+		uint32_t width = 4;
+		const uint32_t* primitiveIndices = nullptr;
+		const core::math::S_Vec3* vertices = nullptr;
+		const S_Triangle* triangles = nullptr;
+		uint32_t triangleCount = 0;   // Primitive ids past this are spheres
+		const S_Sphere* spheres = nullptr;
+	};
+
+	struct S_StreamView {
+		const float* originX = nullptr;
+		const float* originY = nullptr;
+		const float* originZ = nullptr;
+		const float* directionX = nullptr;
+		const float* directionY = nullptr;
+		const float* directionZ = nullptr;
+		const float* tMin = nullptr;
+		float* tMax = nullptr;
+		uint32_t* primitive = nullptr;
+		const uint32_t* order = nullptr;  // Null traces rays by index
+	};
+
+	// Traces the rays at positions [begin, end) of the trace order
+	using StreamKernel = void (*)(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end);
+
+#if defined(SPECTRA_X86_KERNELS)
+	void intersectStreamAvx2(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end);
+	void occludedStreamAvx2(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end);
+	void intersectStreamAvx512(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end);
+	void occludedStreamAvx512(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end);
+#endif
+}
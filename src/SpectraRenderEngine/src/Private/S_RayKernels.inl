@@ -0,0 +1,251 @@
+// Packet traversal shared by the per-instruction-set kernel translation units. The includer
+// defines a SIMD traits type first (see S_RayKernelsAvx2.cpp); everything here has internal
+// linkage, so each instruction set gets its own copy and nothing leaks into the baseline build.
+#include <cstring>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace spectra::render::kernels {
+	namespace {
+		constexpr uint32_t NO_HIT = 0xFFFFFFFFu;
+		constexpr float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+
+		uint32_t lowestSetBit(uint32_t bits) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, bits);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctz(bits));
+#endif
+		}
+
+		float decodeScale(int8_t exponent) {
+			const uint32_t bits = static_cast<uint32_t>(exponent + 127) << 23;
+			float scale;
+			std::memcpy(&scale, &bits, sizeof(scale));
+			return scale;
+		}
+
+		template<typename S>
+		struct S_Packet {
+			typename S::Float originX, originY, originZ;
+			typename S::Float directionX, directionY, directionZ;
+			typename S::Float inverseX, inverseY, inverseZ;
+			typename S::Float tMin, tMax;
+			typename S::Mask active;
+			uint32_t rays[S::WIDTH];          // Stream index per lane
+			uint32_t hitPrimitive[S::WIDTH];
+		};
+
+		// Lanes past count repeat the last ray and start inactive
+		template<typename S>
+		void loadPacket(const S_StreamView& stream, uint32_t first, uint32_t count, S_Packet<S>& packet) {
+			for (uint32_t lane = 0; lane < S::WIDTH; ++lane) {
+				const uint32_t position = first + (lane < count ? lane : count - 1);
+				packet.rays[lane] = stream.order ? stream.order[position] : position;
+				packet.hitPrimitive[lane] = NO_HIT;
+			}
+			packet.originX = S::gather(stream.originX, packet.rays);
+			packet.originY = S::gather(stream.originY, packet.rays);
+			packet.originZ = S::gather(stream.originZ, packet.rays);
+			packet.directionX = S::gather(stream.directionX, packet.rays);
+			packet.directionY = S::gather(stream.directionY, packet.rays);
+			packet.directionZ = S::gather(stream.directionZ, packet.rays);
+			packet.inverseX = S::div(S::set1(1.0f), packet.directionX);
+			packet.inverseY = S::div(S::set1(1.0f), packet.directionY);
+			packet.inverseZ = S::div(S::set1(1.0f), packet.directionZ);
+			packet.tMin = S::gather(stream.tMin, packet.rays);
+			packet.tMax = S::gather(stream.tMax, packet.rays);
+			packet.active = S::firstLanes(count);
+		}
+
+		// Moller-Trumbore against every lane, double-sided like the scalar test
+		template<typename S>
+		typename S::Mask intersectTriangle(const S_Packet<S>& packet, const core::math::S_Vec3& v0, const core::math::S_Vec3& v1,
+			const core::math::S_Vec3& v2, typename S::Mask mask, typename S::Float& t) {
+			using F = typename S::Float;
+
+			const F edge1X = S::set1(v1.x - v0.x);
+			const F edge1Y = S::set1(v1.y - v0.y);
+			const F edge1Z = S::set1(v1.z - v0.z);
+			const F edge2X = S::set1(v2.x - v0.x);
+			const F edge2Y = S::set1(v2.y - v0.y);
+			const F edge2Z = S::set1(v2.z - v0.z);
+
+			const F pX = S::sub(S::mul(packet.directionY, edge2Z), S::mul(packet.directionZ, edge2Y));
+			const F pY = S::sub(S::mul(packet.directionZ, edge2X), S::mul(packet.directionX, edge2Z));
+			const F pZ = S::sub(S::mul(packet.directionX, edge2Y), S::mul(packet.directionY, edge2X));
+			const F determinant = S::add(S::add(S::mul(edge1X, pX), S::mul(edge1Y, pY)), S::mul(edge1Z, pZ));
+			mask = S::andMask(mask, S::ge(S::abs(determinant), S::set1(1e-12f)));
+			if (!S::any(mask)) {
+				return mask;
+			}
+
+			const F inverseDeterminant = S::div(S::set1(1.0f), determinant);
+			const F toOriginX = S::sub(packet.originX, S::set1(v0.x));
+			const F toOriginY = S::sub(packet.originY, S::set1(v0.y));
+			const F toOriginZ = S::sub(packet.originZ, S::set1(v0.z));
+			const F u = S::mul(S::add(S::add(S::mul(toOriginX, pX), S::mul(toOriginY, pY)), S::mul(toOriginZ, pZ)), inverseDeterminant);
+			mask = S::andMask(mask, S::andMask(S::ge(u, S::set1(0.0f)), S::le(u, S::set1(1.0f))));
+			if (!S::any(mask)) {
+				return mask;
+			}
+
+			const F qX = S::sub(S::mul(toOriginY, edge1Z), S::mul(toOriginZ, edge1Y));
+			const F qY = S::sub(S::mul(toOriginZ, edge1X), S::mul(toOriginX, edge1Z));
+			const F qZ = S::sub(S::mul(toOriginX, edge1Y), S::mul(toOriginY, edge1X));
+			const F v = S::mul(S::add(S::add(S::mul(packet.directionX, qX), S::mul(packet.directionY, qY)), S::mul(packet.directionZ, qZ)),
+				inverseDeterminant);
+			mask = S::andMask(mask, S::andMask(S::ge(v, S::set1(0.0f)), S::le(S::add(u, v), S::set1(1.0f))));
+
+			t = S::mul(S::add(S::add(S::mul(edge2X, qX), S::mul(edge2Y, qY)), S::mul(edge2Z, qZ)), inverseDeterminant);
+			return S::andMask(mask, S::andMask(S::ge(t, packet.tMin), S::lt(t, packet.tMax)));
+		}
+
+		template<typename S>
+		typename S::Mask intersectSphere(const S_Packet<S>& packet, const S_Sphere& sphere, typename S::Mask mask, typename S::Float& t) {
+			using F = typename S::Float;
+
+			const F offsetX = S::sub(packet.originX, S::set1(sphere.center.x));
+			const F offsetY = S::sub(packet.originY, S::set1(sphere.center.y));
+			const F offsetZ = S::sub(packet.originZ, S::set1(sphere.center.z));
+			const F a = S::add(S::add(S::mul(packet.directionX, packet.directionX), S::mul(packet.directionY, packet.directionY)),
+				S::mul(packet.directionZ, packet.directionZ));
+			const F halfB = S::add(S::add(S::mul(offsetX, packet.directionX), S::mul(offsetY, packet.directionY)), S::mul(offsetZ, packet.directionZ));
+			const F c = S::sub(S::add(S::add(S::mul(offsetX, offsetX), S::mul(offsetY, offsetY)), S::mul(offsetZ, offsetZ)),
+				S::set1(sphere.radius * sphere.radius));
+			const F discriminant = S::sub(S::mul(halfB, halfB), S::mul(a, c));
+			mask = S::andMask(mask, S::ge(discriminant, S::set1(0.0f)));
+			if (!S::any(mask)) {
+				return mask;
+			}
+
+			const F root = S::sqrt(S::max(discriminant, S::set1(0.0f)));
+			const F nearT = S::div(S::sub(S::sub(S::set1(0.0f), halfB), root), a);
+			const F farT = S::div(S::add(S::sub(S::set1(0.0f), halfB), root), a);
+			const auto nearValid = S::andMask(S::ge(nearT, packet.tMin), S::lt(nearT, packet.tMax));
+			const auto farValid = S::andMask(S::ge(farT, packet.tMin), S::lt(farT, packet.tMax));
+			t = S::select(nearValid, nearT, farT);
+			return S::andMask(mask, S::orMask(nearValid, farValid));
+		}
+
+		// Children are tested against all lanes at once and visited nearest first, by the
+		// closest entry distance of any lane. Lanes leave the packet only through tMax
+		// (closest hit) or by being occluded (any hit).
+		template<typename S, uint32_t N, bool ANY_HIT>
+		void tracePacket(const S_StreamGeometry& geometry, S_Packet<S>& packet) {
+			using F = typename S::Float;
+			using M = typename S::Mask;
+
+			const auto* nodes = static_cast<const S_WideBvhNode<N>*>(geometry.nodes);
+			uint64_t stack[S_Bvh::MAX_DEPTH * N];
+			uint32_t top = 0;
+			stack[top++] = 0;
+
+			while (top > 0) {
+				const uint64_t entry = stack[--top];
+				const uint32_t leafCount = static_cast<uint32_t>(entry >> 32);
+				if (leafCount > 0) {
+					const uint32_t first = static_cast<uint32_t>(entry);
+					for (uint32_t i = first; i < first + leafCount; ++i) {
+						const uint32_t primitive = geometry.primitiveIndices[i];
+						F t;
+						M hit;
+						if (primitive < geometry.triangleCount) {
+							const S_Triangle& triangle = geometry.triangles[primitive];
+							hit = intersectTriangle<S>(packet, geometry.vertices[triangle.vertices[0]], geometry.vertices[triangle.vertices[1]],
+								geometry.vertices[triangle.vertices[2]], packet.active, t);
+						}
+						else {
+							hit = intersectSphere<S>(packet, geometry.spheres[primitive - geometry.triangleCount], packet.active, t);
+						}
+						if (!S::any(hit)) {
+							continue;
+						}
+
+						for (uint32_t bits = S::bits(hit); bits != 0; bits &= bits - 1) {
+							packet.hitPrimitive[lowestSetBit(bits)] = primitive;
+						}
+						if constexpr (ANY_HIT) {
+							packet.active = S::andNot(packet.active, hit);
+							if (!S::any(packet.active)) {
+								return;
+							}
+						}
+						else {
+							packet.tMax = S::select(hit, t, packet.tMax);
+						}
+					}
+					continue;
+				}
+
+				const S_WideBvhNode<N>& node = nodes[static_cast<uint32_t>(entry)];
+				const float scale[3] = { decodeScale(node.exponent[0]), decodeScale(node.exponent[1]), decodeScale(node.exponent[2]) };
+
+				float distances[N];
+				uint64_t children[N];
+				uint32_t hitCount = 0;
+				for (uint32_t i = 0; i < node.childCount; ++i) {
+					const F lowerX = S::mul(S::sub(S::set1(node.origin[0] + static_cast<float>(node.lower[0][i]) * scale[0]), packet.originX), packet.inverseX);
+					const F upperX = S::mul(S::sub(S::set1(node.origin[0] + static_cast<float>(node.upper[0][i]) * scale[0]), packet.originX), packet.inverseX);
+					const F lowerY = S::mul(S::sub(S::set1(node.origin[1] + static_cast<float>(node.lower[1][i]) * scale[1]), packet.originY), packet.inverseY);
+					const F upperY = S::mul(S::sub(S::set1(node.origin[1] + static_cast<float>(node.upper[1][i]) * scale[1]), packet.originY), packet.inverseY);
+					const F lowerZ = S::mul(S::sub(S::set1(node.origin[2] + static_cast<float>(node.lower[2][i]) * scale[2]), packet.originZ), packet.inverseZ);
+					const F upperZ = S::mul(S::sub(S::set1(node.origin[2] + static_cast<float>(node.upper[2][i]) * scale[2]), packet.originZ), packet.inverseZ);
+
+					const F tNear = S::max(S::max(packet.tMin, S::min(lowerX, upperX)), S::max(S::min(lowerY, upperY), S::min(lowerZ, upperZ)));
+					const F tFar = S::min(S::min(packet.tMax, S::max(lowerX, upperX)), S::min(S::max(lowerY, upperY), S::max(lowerZ, upperZ)));
+					const M overlap = S::andMask(packet.active, S::le(tNear, tFar));
+					if (!S::any(overlap)) {
+						continue;
+					}
+
+					const float distance = S::reduceMin(S::select(overlap, tNear, S::set1(INFINITE_DISTANCE)));
+					const uint64_t child = node.childType[i] == S_WideBvhNode<N>::INTERNAL_CHILD
+						? static_cast<uint64_t>(node.child[i])
+						: (static_cast<uint64_t>(node.childType[i]) << 32) | node.child[i];
+					uint32_t slot = hitCount++;
+					while (slot > 0 && distances[slot - 1] < distance) {
+						distances[slot] = distances[slot - 1];
+						children[slot] = children[slot - 1];
+						--slot;
+					}
+					distances[slot] = distance;
+					children[slot] = child;
+				}
+				for (uint32_t i = 0; i < hitCount; ++i) {
+					stack[top++] = children[i];
+				}
+			}
+		}
+
+		template<typename S, bool ANY_HIT>
+		void traceStream(const S_StreamGeometry& geometry, const S_StreamView& stream, uint32_t begin, uint32_t end) {
+			S_Packet<S> packet;
+			for (uint32_t first = begin; first < end; first += S::WIDTH) {
+				const uint32_t count = end - first < S::WIDTH ? end - first : S::WIDTH;
+				loadPacket<S>(stream, first, count, packet);
+				if (geometry.width == 8) {
+					tracePacket<S, 8, ANY_HIT>(geometry, packet);
+				}
+				else {
+					tracePacket<S, 4, ANY_HIT>(geometry, packet);
+				}
+
+				float tMax[S::WIDTH];
+				S::store(tMax, packet.tMax);
+				for (uint32_t lane = 0; lane < count; ++lane) {
+					const uint32_t ray = packet.rays[lane];
+					stream.primitive[ray] = packet.hitPrimitive[lane];
+					if constexpr (!ANY_HIT) {
+						stream.tMax[ray] = tMax[lane];
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#include "S_RayKernels.h"
+
+#include <immintrin.h>
+
+// Compiled with AVX2 and FMA enabled, only called after S_CpuFeatures reports both
+namespace spectra::render::kernels {
+	namespace {
+		struct S_Avx2 {
+			static constexpr uint32_t WIDTH = 8;
+			using Float = __m256;
+			using Mask = __m256;
+
+			static Float set1(float value) { return _mm256_set1_ps(value); }
+			static Float gather(const float* base, const uint32_t* indices) {
+				return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), 4);
+			}
+			static void store(float* destination, Float value) { _mm256_storeu_ps(destination, value); }
+
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+			static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+			static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+			static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+			static Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+			static Mask lt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static Mask le(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+			static Mask ge(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+			static Mask andMask(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+			static Mask orMask(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+			static Mask andNot(Mask a, Mask b) { return _mm256_andnot_ps(b, a); }  // a and not b
+			static Mask firstLanes(uint32_t count) {
+				return _mm256_cmp_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_ps(static_cast<float>(count)), _CMP_LT_OQ);
+			}
+			static bool any(Mask mask) { return _mm256_movemask_ps(mask) != 0; }
+			static uint32_t bits(Mask mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+			static Float select(Mask mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+
+			static float reduceMin(Float value) {
+				const __m128 half = _mm_min_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+				const __m128 quarter = _mm_min_ps(half, _mm_movehl_ps(half, half));
+				return _mm_cvtss_f32(_mm_min_ss(quarter, _mm_shuffle_ps(quarter, quarter, 1)));
+			}
+		};
+	}
+}
+
+#include "S_RayKernels.inl"
+
+namespace spectra::render::kernels {
+	void intersectStreamAvx2(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end) {
+		traceStream<S_Avx2, false>(geometry, rays, begin, end);
+	}
+
+	void occludedStreamAvx2(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end) {
+		traceStream<S_Avx2, true>(geometry, rays, begin, end);
+	}
+}
@@ -0,0 +1,53 @@
+#include "S_RayKernels.h"
+
+#include <immintrin.h>
+
+// Compiled with AVX-512 F/VL/BW/DQ enabled, only called after S_CpuFeatures reports all of them
+namespace spectra::render::kernels {
+	namespace {
+		struct S_Avx512 {
+			static constexpr uint32_t WIDTH = 16;
+			using Float = __m512;
+			using Mask = __mmask16;
+
+			static Float set1(float value) { return _mm512_set1_ps(value); }
+			static Float gather(const float* base, const uint32_t* indices) {
+				return _mm512_i32gather_ps(_mm512_loadu_si512(indices), base, 4);
+			}
+			static void store(float* destination, Float value) { _mm512_storeu_ps(destination, value); }
+
+			static Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm512_div_ps(a, b); }
+			static Float min(Float a, Float b) { return _mm512_min_ps(a, b); }
+			static Float max(Float a, Float b) { return _mm512_max_ps(a, b); }
+			static Float sqrt(Float a) { return _mm512_sqrt_ps(a); }
+			static Float abs(Float a) { return _mm512_abs_ps(a); }
+
+			static Mask lt(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+			static Mask le(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+			static Mask ge(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+			static Mask andMask(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+			static Mask orMask(Mask a, Mask b) { return static_cast<Mask>(a | b); }
+			static Mask andNot(Mask a, Mask b) { return static_cast<Mask>(a & ~b); }
+			static Mask firstLanes(uint32_t count) { return static_cast<Mask>(count >= WIDTH ? 0xFFFFu : (1u << count) - 1u); }
+			static bool any(Mask mask) { return mask != 0; }
+			static uint32_t bits(Mask mask) { return mask; }
+			static Float select(Mask mask, Float a, Float b) { return _mm512_mask_blend_ps(mask, b, a); }
+			static float reduceMin(Float value) { return _mm512_reduce_min_ps(value); }
+		};
+	}
+}
+
+#include "S_RayKernels.inl"
+
+namespace spectra::render::kernels {
+	void intersectStreamAvx512(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end) {
+		traceStream<S_Avx512, false>(geometry, rays, begin, end);
+	}
+
+	void occludedStreamAvx512(const S_StreamGeometry& geometry, const S_StreamView& rays, uint32_t begin, uint32_t end) {
+		traceStream<S_Avx512, true>(geometry, rays, begin, end);
+	}
+}
@@ -0,0 +1,174 @@
+#include "S_RayStream.h"
+#include "S_CpuFeatures.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace spectra::render {
+	using core::math::S_Aabb;
+	using core::math::S_Ray;
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr uint32_t MORTON_BITS = 10;
+
+		// Spreads the low 10 bits of value so two zero bits follow each one
+		uint64_t spreadBits(uint32_t value) {
+			uint64_t x = value & 0x3FF;
+			x = (x | (x << 16)) & 0x30000FF;
+			x = (x | (x << 8)) & 0x300F00F;
+			x = (x | (x << 4)) & 0x30C30C3;
+			x = (x | (x << 2)) & 0x9249249;
+			return x;
+		}
+
+		uint32_t quantize(float value, float minimum, float inverseExtent) {
+			const float scaled = (value - minimum) * inverseExtent * static_cast<float>((1u << MORTON_BITS) - 1);
+			return static_cast<uint32_t>(std::clamp(scaled, 0.0f, static_cast<float>((1u << MORTON_BITS) - 1)));
+		}
+
+		uint64_t morton(uint32_t x, uint32_t y, uint32_t z) {
+			return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+		}
+
+		// LSD radix sort of (key, index) pairs, 16 bits per pass; passes whose digit is the same
+		// for every key are skipped, which is common for the octant and high origin bits
+		void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& indices) {
+			constexpr uint32_t DIGIT_BITS = 16;
+			constexpr uint32_t BUCKETS = 1u << DIGIT_BITS;
+
+			std::vector<uint64_t> sortedKeys(keys.size());
+			std::vector<uint32_t> sortedIndices(indices.size());
+			std::vector<uint32_t> offsets(BUCKETS);
+			for (uint32_t shift = 0; shift < 64; shift += DIGIT_BITS) {
+				std::fill(offsets.begin(), offsets.end(), 0u);
+				for (const uint64_t key : keys) {
+					++offsets[(key >> shift) & (BUCKETS - 1)];
+				}
+				if (offsets[(keys.front() >> shift) & (BUCKETS - 1)] == keys.size()) {
+					continue;
+				}
+
+				uint32_t sum = 0;
+				for (uint32_t& offset : offsets) {
+					const uint32_t count = offset;
+					offset = sum;
+					sum += count;
+				}
+				for (size_t i = 0; i < keys.size(); ++i) {
+					const uint32_t slot = offsets[(keys[i] >> shift) & (BUCKETS - 1)]++;
+					sortedKeys[slot] = keys[i];
+					sortedIndices[slot] = indices[i];
+				}
+				keys.swap(sortedKeys);
+				indices.swap(sortedIndices);
+			}
+		}
+	}
+
+	// S_RayStream implementations
+	void S_RayStream::resize(size_t count) {
+		originX.resize(count);
+		originY.resize(count);
+		originZ.resize(count);
+		directionX.resize(count);
+		directionY.resize(count);
+		directionZ.resize(count);
+		tMin.resize(count, 0.0f);
+		tMax.resize(count, std::numeric_limits<float>::infinity());
+		primitive.resize(count, NO_HIT);
+		order.clear();
+	}
+
+	size_t S_RayStream::size() const {
+		return originX.size();
+	}
+
+	void S_RayStream::setRay(size_t index, const S_Ray& ray) {
+		originX[index] = ray.origin.x;
+		originY[index] = ray.origin.y;
+		originZ[index] = ray.origin.z;
+		directionX[index] = ray.direction.x;
+		directionY[index] = ray.direction.y;
+		directionZ[index] = ray.direction.z;
+		tMin[index] = ray.tMin;
+		tMax[index] = ray.tMax;
+		primitive[index] = NO_HIT;
+	}
+
+	S_Ray S_RayStream::getRay(size_t index) const {
+		S_Ray ray;
+		ray.origin = { originX[index], originY[index], originZ[index] };
+		ray.direction = { directionX[index], directionY[index], directionZ[index] };
+		ray.tMin = tMin[index];
+		ray.tMax = tMax[index];
+		return ray;
+	}
+
+	void S_RayStream::sortForCoherence(const S_Aabb& bounds) {
+		const size_t count = size();
+		order.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			order[i] = static_cast<uint32_t>(i);
+		}
+		if (count < 2 || bounds.isEmpty()) {
+			return;
+		}
+
+		const S_Vec3 extent = bounds.extent();
+		const S_Vec3 inverseExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+			extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+		// Octant in the top 3 bits, then 30 bits of origin and 30 bits of direction
+		std::vector<uint64_t> keys(count);
+		for (size_t i = 0; i < count; ++i) {
+			const S_Vec3 direction = core::math::normalize(S_Vec3(directionX[i], directionY[i], directionZ[i]));
+			const uint64_t octant = (direction.x < 0.0f ? 1u : 0u) | (direction.y < 0.0f ? 2u : 0u) | (direction.z < 0.0f ? 4u : 0u);
+			const uint64_t origin = morton(quantize(originX[i], bounds.min.x, inverseExtent.x),
+				quantize(originY[i], bounds.min.y, inverseExtent.y), quantize(originZ[i], bounds.min.z, inverseExtent.z));
+			const uint64_t heading = morton(quantize(direction.x, -1.0f, 0.5f), quantize(direction.y, -1.0f, 0.5f),
+				quantize(direction.z, -1.0f, 0.5f));
+			keys[i] = (octant << 61) | (origin << 30) | heading;
+		}
+		radixSort(keys, order);
+	}
+
+	E_SimdLevel S_RayStream::getBestSimdLevel() {
+#if defined(SPECTRA_X86_KERNELS)
+		const auto& cpu = core::platform::S_CpuFeatures::get();
+		if (cpu.hasAvx512()) {
+			return E_SimdLevel::AVX512;
+		}
+		if (cpu.hasAvx2Fma()) {
+			return E_SimdLevel::AVX2;
+		}
+#endif
+		return E_SimdLevel::SCALAR;
+	}
+
+	uint32_t S_RayStream::getPacketWidth(E_SimdLevel level) {
+		switch (level == E_SimdLevel::BEST ? getBestSimdLevel() : level) {
+		case E_SimdLevel::AVX2:
+			return 8;
+		case E_SimdLevel::AVX512:
+			return 16;
+		default:
+			return 1;
+		}
+	}
+
+	const char* S_RayStream::getSimdLevelName(E_SimdLevel level) {
+		switch (level) {
+		case E_SimdLevel::SCALAR:
+			return "scalar";
+		case E_SimdLevel::AVX2:
+			return "AVX2";
+		case E_SimdLevel::AVX512:
+			return "AVX-512";
+		default:
+			return "best";
+		}
+	}
+}
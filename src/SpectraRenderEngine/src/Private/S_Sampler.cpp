@@ -0,0 +1,273 @@
+#include "S_Sampler.h"
+#include "S_Random.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace spectra::render {
+	namespace {
+		// Generator matrix of Sobol dimension 1 (polynomial x + 1), column k of the binary
+		// expansion as a 32-bit word with the first digit in the top bit. Dimension 0 is the
+		// identity, i.e. the radical inverse.
+		constexpr std::array<uint32_t, 32> makeSobolMatrix1() {
+			std::array<uint32_t, 32> columns{};
+			columns[0] = 1u << 31;
+			for (uint32_t k = 1; k < 32; ++k) {
+				columns[k] = columns[k - 1] ^ (columns[k - 1] >> 1);
+			}
+			return columns;
+		}
+		constexpr std::array<uint32_t, 32> SOBOL_MATRIX_1 = makeSobolMatrix1();
+
+		// Extensible rank-1 lattice (1, z) in base 2; z maximizes the worst normalized minimum
+		// distance over every power-of-two point count from 16 to 2^20 (0.759, hexagonal is 1.075)
+		constexpr uint32_t LATTICE_GENERATOR = 17939;
+
+		// Toroidal offsets of successive dimensions into the blue-noise tile, from the R2 sequence
+		// so nearby dimensions read far-apart texels
+		constexpr float R2_ALPHA_X = 0.7548776662f;
+		constexpr float R2_ALPHA_Y = 0.5698402910f;
+
+		constexpr float toUnitFloat(uint32_t bits) {
+			return static_cast<float>(bits >> 8) * 0x1.0p-24f;
+		}
+
+		uint32_t reverseBits(uint32_t x) {
+			x = (x << 16) | (x >> 16);
+			x = ((x & 0x00FF00FFu) << 8) | ((x & 0xFF00FF00u) >> 8);
+			x = ((x & 0x0F0F0F0Fu) << 4) | ((x & 0xF0F0F0F0u) >> 4);
+			x = ((x & 0x33333333u) << 2) | ((x & 0xCCCCCCCCu) >> 2);
+			x = ((x & 0x55555555u) << 1) | ((x & 0xAAAAAAAAu) >> 1);
+			return x;
+		}
+
+		uint32_t hash(uint64_t a, uint64_t b) {
+			return static_cast<uint32_t>(mixBits(a ^ mixBits(b + 0x9E3779B97F4A7C15ull)) >> 32);
+		}
+
+		// Laine-Karras style permutation with Vegdahl's constants: each output bit depends only on
+		// the input bits below it, so on bit-reversed values it is an Owen scramble
+		uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+			x ^= x * 0x3D20ADEAu;
+			x += seed;
+			x *= (seed >> 16) | 1u;
+			x ^= x * 0x05526C56u;
+			x ^= x * 0x53A22864u;
+			return x;
+		}
+
+		// Nested uniform (Owen) scramble of a 32-bit binary fraction (Burley 2020)
+		uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+			return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+		}
+
+		uint32_t sobolDimension1(uint32_t index) {
+			uint32_t result = 0;
+			for (uint32_t k = 0; index != 0; index >>= 1, ++k) {
+				if (index & 1u) {
+					result ^= SOBOL_MATRIX_1[k];
+				}
+			}
+			return result;
+		}
+
+		// 64x64 tileable blue noise by void-and-cluster (Ulichney 1993): pixels are ranked by
+		// repeatedly filling the largest void of a Gaussian-filtered binary pattern
+		class S_BlueNoiseTile {
+			static constexpr uint32_t SIZE = S_Sampler::BLUE_NOISE_SIZE;
+			static constexpr uint32_t COUNT = SIZE * SIZE;
+
+			std::unique_ptr<float[]> values = std::make_unique<float[]>(COUNT);
+
+		public:
+			S_BlueNoiseTile() {
+				constexpr float SIGMA = 1.5f;
+				std::vector<float> kernel(COUNT);
+				for (uint32_t y = 0; y < SIZE; ++y) {
+					for (uint32_t x = 0; x < SIZE; ++x) {
+						const float dx = static_cast<float>(std::min(x, SIZE - x));
+						const float dy = static_cast<float>(std::min(y, SIZE - y));
+						kernel[y * SIZE + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * SIGMA * SIGMA));
+					}
+				}
+
+				std::vector<uint8_t> pattern(COUNT, 0);
+				std::vector<float> energy(COUNT, 0.0f);
+				auto splat = [&](uint32_t pixel, float sign) {
+					const uint32_t px = pixel % SIZE;
+					const uint32_t py = pixel / SIZE;
+					for (uint32_t y = 0; y < SIZE; ++y) {
+						const uint32_t row = ((y + SIZE - py) % SIZE) * SIZE;
+						for (uint32_t x = 0; x < SIZE; ++x) {
+							energy[y * SIZE + x] += sign * kernel[row + (x + SIZE - px) % SIZE];
+						}
+					}
+				};
+				auto extreme = [&](uint8_t state, bool largest) {
+					uint32_t found = 0;
+					float foundEnergy = largest ? -1.0f : 1e30f;
+					for (uint32_t i = 0; i < COUNT; ++i) {
+						if (pattern[i] == state && (largest ? energy[i] > foundEnergy : energy[i] < foundEnergy)) {
+							found = i;
+							foundEnergy = energy[i];
+						}
+					}
+					return found;
+				};
+				auto set = [&](uint32_t pixel, uint8_t state) {
+					pattern[pixel] = state;
+					splat(pixel, state ? 1.0f : -1.0f);
+				};
+
+				// Initial pattern: a tenth of the pixels at random, then moved from the tightest
+				// cluster to the largest void until that stops changing anything
+				S_Pcg32 random(0xB1AE, 0);
+				uint32_t ones = 0;
+				while (ones < COUNT / 10) {
+					const uint32_t pixel = random.nextUint() % COUNT;
+					if (!pattern[pixel]) {
+						set(pixel, 1);
+						++ones;
+					}
+				}
+				for (uint32_t iteration = 0; iteration < COUNT; ++iteration) {
+					const uint32_t cluster = extreme(1, true);
+					set(cluster, 0);
+					const uint32_t voidPixel = extreme(0, false);
+					set(voidPixel, 1);
+					if (voidPixel == cluster) {
+						break;
+					}
+				}
+				const std::vector<uint8_t> prototype = pattern;
+				const std::vector<float> prototypeEnergy = energy;
+
+				// Ranks below the prototype's count: peel off tightest clusters
+				std::vector<uint32_t> rank(COUNT);
+				for (uint32_t r = ones; r-- > 0;) {
+					const uint32_t cluster = extreme(1, true);
+					set(cluster, 0);
+					rank[cluster] = r;
+				}
+
+				// The rest: fill the largest voids. Past half coverage this is the same as removing
+				// the tightest cluster of zeros, since the filtered ones and zeros sum to a constant.
+				pattern = prototype;
+				energy = prototypeEnergy;
+				for (uint32_t r = ones; r < COUNT; ++r) {
+					const uint32_t voidPixel = extreme(0, false);
+					set(voidPixel, 1);
+					rank[voidPixel] = r;
+				}
+
+				for (uint32_t i = 0; i < COUNT; ++i) {
+					values[i] = (static_cast<float>(rank[i]) + 0.5f) / COUNT;
+				}
+			}
+
+			[[nodiscard]] float get(uint32_t x, uint32_t y) const {
+				return values[(y % SIZE) * SIZE + x % SIZE];
+			}
+		};
+
+		const S_BlueNoiseTile& getBlueNoiseTile() {
+			static const S_BlueNoiseTile tile;
+			return tile;
+		}
+
+		// Cranley-Patterson rotation of a dimension for a pixel, as 32-bit fractions
+		void getRotation(E_SamplerType type, uint32_t seed, const S_PixelSample& sample, uint32_t dimension, uint32_t& shiftU, uint32_t& shiftV) {
+			if (type == E_SamplerType::BLUE_NOISE) {
+				const auto& tile = getBlueNoiseTile();
+				const float offsetX = std::fmod(R2_ALPHA_X * static_cast<float>(dimension + 1), 1.0f) * S_Sampler::BLUE_NOISE_SIZE;
+				const float offsetY = std::fmod(R2_ALPHA_Y * static_cast<float>(dimension + 1), 1.0f) * S_Sampler::BLUE_NOISE_SIZE;
+				const uint32_t x = sample.x + static_cast<uint32_t>(offsetX) + (seed & 0xFFFFu);
+				const uint32_t y = sample.y + static_cast<uint32_t>(offsetY) + (seed >> 16);
+				shiftU = static_cast<uint32_t>(tile.get(x, y) * 0x1.0p32f);
+				shiftV = static_cast<uint32_t>(tile.get(x + S_Sampler::BLUE_NOISE_SIZE / 2, y + S_Sampler::BLUE_NOISE_SIZE / 2 + 17) * 0x1.0p32f);
+				return;
+			}
+			const uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+			shiftU = hash(hash(seed, pixel), dimension * 2 + 0);
+			shiftV = hash(hash(seed, pixel), dimension * 2 + 1);
+		}
+	}
+
+	// S_Sampler implementations
+	S_Sampler::S_Sampler(E_SamplerType type, uint64_t seed)
+		: type(type), seed(static_cast<uint32_t>(mixBits(seed) >> 32)) {}
+
+	float S_Sampler::get1D(const S_PixelSample& sample, uint32_t dimension) const {
+		switch (type) {
+		case E_SamplerType::SOBOL: {
+			const uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+			const uint32_t dimensionSeed = hash(hash(seed, pixel), dimension);
+			const uint32_t shuffled = nestedUniformScramble(sample.index, dimensionSeed);
+			return toUnitFloat(nestedUniformScramble(reverseBits(shuffled), hash(dimensionSeed, 1)));
+		}
+		case E_SamplerType::RANK1:
+		case E_SamplerType::BLUE_NOISE:
+			return get2D(sample, dimension).u;
+		default: {
+			const uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+			return toUnitFloat(hash(hash(hash(seed, pixel), sample.index), dimension));
+		}
+		}
+	}
+
+	S_Sample2D S_Sampler::get2D(const S_PixelSample& sample, uint32_t dimension) const {
+		switch (type) {
+		case E_SamplerType::SOBOL: {
+			// Burley's shuffled scrambled Sobol: every pixel and dimension gets its own ordering
+			// of the same (0,2)-sequence, scrambled independently per axis
+			const uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+			const uint32_t dimensionSeed = hash(hash(seed, pixel), dimension);
+			const uint32_t shuffled = nestedUniformScramble(sample.index, dimensionSeed);
+			return { toUnitFloat(nestedUniformScramble(reverseBits(shuffled), hash(dimensionSeed, 1))),
+				toUnitFloat(nestedUniformScramble(sobolDimension1(shuffled), hash(dimensionSeed, 2))) };
+		}
+		case E_SamplerType::RANK1:
+		case E_SamplerType::BLUE_NOISE: {
+			// Shuffled per dimension only: within each power-of-two block every pixel sees the
+			// same lattice, so the per-pixel rotation alone decides how errors correlate
+			const uint32_t shuffled = nestedUniformScramble(sample.index, hash(seed, dimension));
+			const uint32_t radicalInverse = reverseBits(shuffled);
+			uint32_t shiftU;
+			uint32_t shiftV;
+			getRotation(type, seed, sample, dimension, shiftU, shiftV);
+			return { toUnitFloat(radicalInverse + shiftU), toUnitFloat(radicalInverse * LATTICE_GENERATOR + shiftV) };
+		}
+		default: {
+			const uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+			const uint32_t bits = hash(hash(hash(seed, pixel), sample.index), dimension);
+			return { toUnitFloat(bits), toUnitFloat(hash(bits, dimension)) };
+		}
+		}
+	}
+
+	E_SamplerType S_Sampler::getType() const {
+		return type;
+	}
+
+	const char* S_Sampler::getTypeName(E_SamplerType type) {
+		switch (type) {
+		case E_SamplerType::INDEPENDENT:
+			return "independent";
+		case E_SamplerType::SOBOL:
+			return "Owen-scrambled Sobol";
+		case E_SamplerType::RANK1:
+			return "rank-1 lattice";
+		case E_SamplerType::BLUE_NOISE:
+			return "blue-noise rank-1";
+		default:
+			return "unknown";
+		}
+	}
+
+	float S_Sampler::getBlueNoise(uint32_t x, uint32_t y) {
+		return getBlueNoiseTile().get(x, y);
+	}
+}
@@ -0,0 +1,510 @@
+#include "S_Scene.h"
+#include "S_SceneFile.h"
+#include "S_JobSystem.h"
+#include "S_RayKernels.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace spectra::render {
+	using core::math::S_Aabb;
+	using core::math::S_Ray;
+	using core::math::S_Vec3;
+
+	namespace {
+		bool intersectSphere(const S_Sphere& sphere, const S_Ray& ray, float& t) {
+			const S_Vec3 offset = ray.origin - sphere.center;
+			const float a = core::math::lengthSquared(ray.direction);
+			const float halfB = core::math::dot(offset, ray.direction);
+			const float c = core::math::lengthSquared(offset) - sphere.radius * sphere.radius;
+			const float discriminant = halfB * halfB - a * c;
+			if (discriminant < 0.0f) {
+				return false;
+			}
+
+			const float root = std::sqrt(discriminant);
+			float candidate = (-halfB - root) / a;
+			if (candidate < ray.tMin || candidate >= ray.tMax) {
+				candidate = (-halfB + root) / a;
+				if (candidate < ray.tMin || candidate >= ray.tMax) {
+					return false;
+				}
+			}
+			t = candidate;
+			return true;
+		}
+
+		// Moller-Trumbore, double-sided
+		bool intersectTriangle(const S_Vec3& v0, const S_Vec3& v1, const S_Vec3& v2, const S_Ray& ray, float& t) {
+			const S_Vec3 edge1 = v1 - v0;
+			const S_Vec3 edge2 = v2 - v0;
+			const S_Vec3 p = core::math::cross(ray.direction, edge2);
+			const float determinant = core::math::dot(edge1, p);
+			if (std::abs(determinant) < 1e-12f) {
+				return false;
+			}
+
+			const float inverseDeterminant = 1.0f / determinant;
+			const S_Vec3 toOrigin = ray.origin - v0;
+			const float u = core::math::dot(toOrigin, p) * inverseDeterminant;
+			if (u < 0.0f || u > 1.0f) {
+				return false;
+			}
+			const S_Vec3 q = core::math::cross(toOrigin, edge1);
+			const float v = core::math::dot(ray.direction, q) * inverseDeterminant;
+			if (v < 0.0f || u + v > 1.0f) {
+				return false;
+			}
+
+			const float candidate = core::math::dot(edge2, q) * inverseDeterminant;
+			if (candidate < ray.tMin || candidate >= ray.tMax) {
+				return false;
+			}
+			t = candidate;
+			return true;
+		}
+
+		// Bounds of the triangle on each side of the plane, clipped to clip. Used by spatial splits.
+		void splitTriangle(const S_Vec3* corners, const S_Aabb& clip, int axis, float position, S_Aabb& left, S_Aabb& right) {
+			left = {};
+			right = {};
+			for (int i = 0; i < 3; ++i) {
+				const S_Vec3& from = corners[i];
+				const S_Vec3& to = corners[(i + 1) % 3];
+				if (from[axis] <= position) {
+					left.extend(from);
+				}
+				if (from[axis] >= position) {
+					right.extend(from);
+				}
+				if ((from[axis] < position && to[axis] > position) || (from[axis] > position && to[axis] < position)) {
+					S_Vec3 crossing = core::math::lerp(from, to, (position - from[axis]) / (to[axis] - from[axis]));
+					crossing[axis] = position;
+					left.extend(crossing);
+					right.extend(crossing);
+				}
+			}
+			left = left.intersection(clip);
+			right = right.intersection(clip);
+		}
+	}
+
+	// S_Scene implementations
+	uint32_t S_Scene::addMaterial(const S_SurfaceMaterial& material) {
+		materials.push_back(material);
+		return static_cast<uint32_t>(materials.size() - 1);
+	}
+
+	void S_Scene::setMaterial(uint32_t index, const S_SurfaceMaterial& material) {
+		if (index >= materials.size()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "setMaterial", "Unknown material", index);
+		}
+		const bool emissionChanged = materials[index].emission != material.emission;
+		materials[index] = material;
+		if (emissionChanged) {
+			rebuildEmissive();
+		}
+	}
+
+	void S_Scene::addSphere(const S_Vec3& center, float radius, uint32_t material) {
+		if (material >= materials.size()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "addSphere", "Unknown material", material);
+		}
+		spheres.push_back({ center, radius, material });
+		accelerator.clear();
+	}
+
+	uint32_t S_Scene::addMesh(std::span<const S_Vec3> positions, std::span<const uint32_t> indices, uint32_t material) {
+		if (material >= materials.size()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "addMesh", "Unknown material", material);
+		}
+		if (indices.size() % 3 != 0) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "addMesh", "Index count is not a multiple of 3",
+				static_cast<uint64_t>(indices.size()));
+		}
+
+		const uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+		const uint32_t firstTriangle = static_cast<uint32_t>(triangles.size());
+		vertices.insert(vertices.end(), positions.begin(), positions.end());
+		triangles.reserve(triangles.size() + indices.size() / 3);
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			if (indices[i] >= positions.size() || indices[i + 1] >= positions.size() || indices[i + 2] >= positions.size()) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "addMesh", "Index out of range",
+					static_cast<uint64_t>(i));
+			}
+			triangles.push_back({ { baseVertex + indices[i], baseVertex + indices[i + 1], baseVertex + indices[i + 2] }, material });
+
+			if (core::math::maxComponent(materials[material].emission) > 0.0f) {
+				const S_Vec3& v0 = positions[indices[i]];
+				const float area = 0.5f * core::math::length(core::math::cross(positions[indices[i + 1]] - v0, positions[indices[i + 2]] - v0));
+				emissiveTriangles.push_back(static_cast<uint32_t>(triangles.size() - 1));
+				emissiveAreaCdf.push_back((emissiveAreaCdf.empty() ? 0.0f : emissiveAreaCdf.back()) + area);
+			}
+		}
+		accelerator.clear();
+		return firstTriangle;
+	}
+
+	void S_Scene::load(const S_SceneFileView& file) {
+		if (!file.isValid()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "load", "Scene file view is empty");
+		}
+
+		const std::span<const S_SurfaceMaterial> fileMaterials = file.getMaterials();
+		const std::span<const S_Sphere> fileSpheres = file.getSpheres();
+		const std::span<const S_Vec3> fileVertices = file.getVertices();
+		const std::span<const S_Triangle> fileTriangles = file.getTriangles();
+		materials.assign(fileMaterials.begin(), fileMaterials.end());
+		spheres.assign(fileSpheres.begin(), fileSpheres.end());
+		vertices.assign(fileVertices.begin(), fileVertices.end());
+		triangles.assign(fileTriangles.begin(), fileTriangles.end());
+		skyHorizon = file.getSkyHorizon();
+		skyZenith = file.getSkyZenith();
+		rebuildEmissive();
+
+		const S_BvhView bvh = file.getBvh();
+		if (bvh.isEmpty()) {
+			accelerator.clear();
+		}
+		else {
+			accelerator.assign(bvh);
+		}
+	}
+
+	void S_Scene::rebuildEmissive() {
+		emissiveTriangles.clear();
+		emissiveAreaCdf.clear();
+		float areaSum = 0.0f;
+		for (size_t i = 0; i < triangles.size(); ++i) {
+			const S_Triangle& triangle = triangles[i];
+			if (core::math::maxComponent(materials[triangle.material].emission) > 0.0f) {
+				const S_Vec3& v0 = vertices[triangle.vertices[0]];
+				areaSum += 0.5f * core::math::length(core::math::cross(vertices[triangle.vertices[1]] - v0, vertices[triangle.vertices[2]] - v0));
+				emissiveTriangles.push_back(static_cast<uint32_t>(i));
+				emissiveAreaCdf.push_back(areaSum);
+			}
+		}
+	}
+
+	void S_Scene::setSky(const S_Vec3& horizon, const S_Vec3& zenith) {
+		skyHorizon = horizon;
+		skyZenith = zenith;
+	}
+
+	S_Vec3 S_Scene::sky(const S_Vec3& direction) const {
+		const float t = 0.5f * (core::math::normalize(direction).y + 1.0f);
+		return core::math::lerp(skyHorizon, skyZenith, t);
+	}
+
+	void S_Scene::collectPrimitiveBounds(std::vector<S_Aabb>& bounds) const {
+		bounds.resize(triangles.size() + spheres.size());
+		for (size_t i = 0; i < triangles.size(); ++i) {
+			S_Aabb& box = bounds[i];
+			box = {};
+			for (const uint32_t vertex : triangles[i].vertices) {
+				box.extend(vertices[vertex]);
+			}
+		}
+		for (size_t i = 0; i < spheres.size(); ++i) {
+			const S_Vec3 radius(std::abs(spheres[i].radius));
+			bounds[triangles.size() + i] = { spheres[i].center - radius, spheres[i].center + radius };
+		}
+	}
+
+	bool S_Scene::intersectPrimitive(uint32_t primitive, const S_Ray& ray, float& t) const {
+		if (primitive < triangles.size()) {
+			const S_Triangle& triangle = triangles[primitive];
+			return intersectTriangle(vertices[triangle.vertices[0]], vertices[triangle.vertices[1]], vertices[triangle.vertices[2]], ray, t);
+		}
+		return intersectSphere(spheres[primitive - triangles.size()], ray, t);
+	}
+
+	void S_Scene::buildAccelerator(const S_BvhBuildSettings& settings) {
+		std::vector<S_Aabb> bounds;
+		collectPrimitiveBounds(bounds);
+
+		// Triangles are clipped exactly; spheres keep the builder's box split
+		const BvhSplitFunction splitPrimitive = [this](uint32_t primitive, const S_Aabb& clip, int axis, float position, S_Aabb& left, S_Aabb& right) {
+			if (primitive < triangles.size()) {
+				const S_Triangle& triangle = triangles[primitive];
+				const S_Vec3 corners[3] = { vertices[triangle.vertices[0]], vertices[triangle.vertices[1]], vertices[triangle.vertices[2]] };
+				splitTriangle(corners, clip, axis, position, left, right);
+				return;
+			}
+			left = clip;
+			right = clip;
+			left.max[axis] = std::min(left.max[axis], position);
+			right.min[axis] = std::max(right.min[axis], position);
+		};
+		accelerator.build(bounds, settings, settings.spatialSplits ? splitPrimitive : BvhSplitFunction{});
+	}
+
+	const S_Bvh& S_Scene::getAccelerator() const {
+		return accelerator;
+	}
+
+	void S_Scene::updateVertices(uint32_t firstVertex, std::span<const S_Vec3> positions) {
+		if (static_cast<size_t>(firstVertex) + positions.size() > vertices.size()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "updateVertices", "Vertex range out of bounds",
+				firstVertex, static_cast<uint64_t>(positions.size()));
+		}
+		std::copy(positions.begin(), positions.end(), vertices.begin() + firstVertex);
+
+		float areaSum = 0.0f;
+		for (size_t i = 0; i < emissiveTriangles.size(); ++i) {
+			const S_Triangle& triangle = triangles[emissiveTriangles[i]];
+			const S_Vec3& v0 = vertices[triangle.vertices[0]];
+			areaSum += 0.5f * core::math::length(core::math::cross(vertices[triangle.vertices[1]] - v0, vertices[triangle.vertices[2]] - v0));
+			emissiveAreaCdf[i] = areaSum;
+		}
+
+		if (accelerator.isBuilt()) {
+			std::vector<S_Aabb> bounds;
+			collectPrimitiveBounds(bounds);
+			accelerator.refit(bounds);
+		}
+	}
+
+	uint32_t S_Scene::findClosest(S_Ray& ray) const {
+		uint32_t closest = S_RayStream::NO_HIT;
+		if (accelerator.isBuilt()) {
+			accelerator.intersect(ray, [&](uint32_t primitive, S_Ray& candidateRay) {
+				float t;
+				if (!intersectPrimitive(primitive, candidateRay, t)) {
+					return false;
+				}
+				candidateRay.tMax = t;
+				closest = primitive;
+				return true;
+			});
+			return closest;
+		}
+
+		// Brute force over every primitive
+		for (uint32_t i = 0; i < triangles.size() + spheres.size(); ++i) {
+			float t;
+			if (intersectPrimitive(i, ray, t)) {
+				ray.tMax = t;
+				closest = i;
+			}
+		}
+		return closest;
+	}
+
+	uint32_t S_Scene::findAnyHit(const S_Ray& ray) const {
+		uint32_t blocker = S_RayStream::NO_HIT;
+		float t;
+		if (accelerator.isBuilt()) {
+			accelerator.occluded(ray, [&](uint32_t primitive, const S_Ray& shadowRay) {
+				if (!intersectPrimitive(primitive, shadowRay, t)) {
+					return false;
+				}
+				blocker = primitive;
+				return true;
+			});
+			return blocker;
+		}
+
+		for (uint32_t i = 0; i < triangles.size() + spheres.size(); ++i) {
+			if (intersectPrimitive(i, ray, t)) {
+				return i;
+			}
+		}
+		return blocker;
+	}
+
+	void S_Scene::fillHit(const S_Ray& ray, uint32_t primitive, S_Hit& hit) const {
+		hit.t = ray.tMax;
+		hit.position = ray.at(hit.t);
+		S_Vec3 normal;
+		if (primitive >= triangles.size()) {
+			const S_Sphere& sphere = spheres[primitive - triangles.size()];
+			normal = (hit.position - sphere.center) / sphere.radius;
+			hit.material = sphere.material;
+			hit.sampledEmitter = false;
+		}
+		else {
+			const S_Triangle& triangle = triangles[primitive];
+			const S_Vec3& v0 = vertices[triangle.vertices[0]];
+			normal = core::math::normalize(core::math::cross(vertices[triangle.vertices[1]] - v0, vertices[triangle.vertices[2]] - v0));
+			hit.material = triangle.material;
+			hit.sampledEmitter = core::math::maxComponent(materials[triangle.material].emission) > 0.0f;
+		}
+		hit.frontFace = core::math::dot(ray.direction, normal) < 0.0f;
+		hit.normal = hit.frontFace ? normal : -normal;
+	}
+
+	bool S_Scene::intersect(S_Ray& ray, S_Hit& hit) const {
+		const uint32_t primitive = findClosest(ray);
+		if (primitive == S_RayStream::NO_HIT) {
+			return false;
+		}
+		fillHit(ray, primitive, hit);
+		return true;
+	}
+
+	bool S_Scene::occluded(const S_Ray& ray) const {
+		return findAnyHit(ray) != S_RayStream::NO_HIT;
+	}
+
+	void S_Scene::traceStream(S_RayStream& rays, E_SimdLevel level, bool anyHit) const {
+		const size_t count = rays.size();
+		if (!rays.order.empty() && rays.order.size() != count) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_Scene", "traceStream", "Ray order does not match the stream",
+				static_cast<uint64_t>(rays.order.size()), static_cast<uint64_t>(count));
+		}
+
+		const E_SimdLevel best = S_RayStream::getBestSimdLevel();
+		if (level == E_SimdLevel::BEST || static_cast<uint8_t>(level) > static_cast<uint8_t>(best)) {
+			level = best;
+		}
+		if (!accelerator.isBuilt()) {
+			level = E_SimdLevel::SCALAR;
+		}
+
+		kernels::StreamKernel kernel = nullptr;
+#if defined(SPECTRA_X86_KERNELS)
+		if (level == E_SimdLevel::AVX2) {
+			kernel = anyHit ? kernels::occludedStreamAvx2 : kernels::intersectStreamAvx2;
+		}
+		else if (level == E_SimdLevel::AVX512) {
+			kernel = anyHit ? kernels::occludedStreamAvx512 : kernels::intersectStreamAvx512;
+		}
+#endif
+
+		auto& jobSystem = core::jobs::S_JobSystem::getInstance();
+		if (kernel == nullptr) {
+			jobSystem.parallelFor(0, count, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					S_Ray ray = rays.getRay(i);
+					if (anyHit) {
+						rays.primitive[i] = findAnyHit(ray);
+					}
+					else {
+						rays.primitive[i] = findClosest(ray);
+						rays.tMax[i] = ray.tMax;
+					}
+				}
+			}, 256);
+			return;
+		}
+
+		kernels::S_StreamGeometry geometry;
+		geometry.width = static_cast<uint32_t>(accelerator.getWidth());
+		geometry.nodes = geometry.width == 8 ? static_cast<const void*>(accelerator.getNodes8().data())
+			: static_cast<const void*>(accelerator.getNodes4().data());
+		geometry.primitiveIndices = accelerator.getPrimitiveIndices().data();
+		geometry.vertices = vertices.data();
+		geometry.triangles = triangles.data();
+		geometry.triangleCount = static_cast<uint32_t>(triangles.size());
+		geometry.spheres = spheres.data();
+
+		kernels::S_StreamView view;
+		view.originX = rays.originX.data();
+		view.originY = rays.originY.data();
+		view.originZ = rays.originZ.data();
+		view.directionX = rays.directionX.data();
+		view.directionY = rays.directionY.data();
+		view.directionZ = rays.directionZ.data();
+		view.tMin = rays.tMin.data();
+		view.tMax = rays.tMax.data();
+		view.primitive = rays.primitive.data();
+		view.order = rays.order.empty() ? nullptr : rays.order.data();
+
+		// Whole packets per job so every packet but the last is full
+		const size_t width = S_RayStream::getPacketWidth(level);
+		const size_t packetCount = (count + width - 1) / width;
+		jobSystem.parallelFor(0, packetCount, [&](size_t firstPacket, size_t lastPacket) {
+			kernel(geometry, view, static_cast<uint32_t>(firstPacket * width), static_cast<uint32_t>(std::min(lastPacket * width, count)));
+		}, 16);
+	}
+
+	void S_Scene::intersectStream(S_RayStream& rays, E_SimdLevel level) const {
+		traceStream(rays, level, false);
+	}
+
+	void S_Scene::occludedStream(S_RayStream& rays, E_SimdLevel level) const {
+		traceStream(rays, level, true);
+	}
+
+	bool S_Scene::getStreamHit(const S_RayStream& rays, size_t index, S_Hit& hit) const {
+		if (rays.primitive[index] == S_RayStream::NO_HIT) {
+			return false;
+		}
+		fillHit(rays.getRay(index), rays.primitive[index], hit);
+		return true;
+	}
+
+	bool S_Scene::sampleLight(float uSelect, float u1, float u2, S_LightSample& sample) const {
+		if (emissiveTriangles.empty()) {
+			return false;
+		}
+
+		const float totalArea = emissiveAreaCdf.back();
+		const auto selected = std::upper_bound(emissiveAreaCdf.begin(), emissiveAreaCdf.end(), uSelect * totalArea);
+		const size_t index = std::min(static_cast<size_t>(selected - emissiveAreaCdf.begin()), emissiveTriangles.size() - 1);
+		const S_Triangle& triangle = triangles[emissiveTriangles[index]];
+		const S_Vec3& v0 = vertices[triangle.vertices[0]];
+		const S_Vec3& v1 = vertices[triangle.vertices[1]];
+		const S_Vec3& v2 = vertices[triangle.vertices[2]];
+
+		// Uniform barycentrics by square-root warping
+		const float root = std::sqrt(u1);
+		const float b0 = 1.0f - root;
+		const float b1 = u2 * root;
+		sample.position = v0 * b0 + v1 * b1 + v2 * (1.0f - b0 - b1);
+		sample.normal = core::math::normalize(core::math::cross(v1 - v0, v2 - v0));
+		sample.emission = materials[triangle.material].emission;
+		sample.pdfArea = 1.0f / totalArea;
+		return true;
+	}
+
+	bool S_Scene::hasSampledLights() const {
+		return !emissiveTriangles.empty();
+	}
+
+	std::span<const S_SurfaceMaterial> S_Scene::getMaterials() const {
+		return materials;
+	}
+
+	std::span<const S_Sphere> S_Scene::getSpheres() const {
+		return spheres;
+	}
+
+	std::span<const S_Vec3> S_Scene::getVertices() const {
+		return vertices;
+	}
+
+	std::span<const S_Triangle> S_Scene::getTriangles() const {
+		return triangles;
+	}
+
+	const S_Vec3& S_Scene::getSkyHorizon() const {
+		return skyHorizon;
+	}
+
+	const S_Vec3& S_Scene::getSkyZenith() const {
+		return skyZenith;
+	}
+
+	const S_SurfaceMaterial& S_Scene::getMaterial(uint32_t index) const {
+		return materials[index];
+	}
+
+	size_t S_Scene::getMaterialCount() const {
+		return materials.size();
+	}
+
+	size_t S_Scene::getSphereCount() const {
+		return spheres.size();
+	}
+
+	size_t S_Scene::getTriangleCount() const {
+		return triangles.size();
+	}
+
+	size_t S_Scene::getVertexCount() const {
+		return vertices.size();
+	}
+}
@@ -0,0 +1,412 @@
+#include "S_SceneConverter.h"
+#include "S_QuantizedMesh.h"
+#include "S_Scene.h"
+#include "S_SceneFile.h"
+#include "SpectraInstrumentation.h"
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace spectra::render {
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::scenefile";
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		bool readText(const std::filesystem::path& path, std::string& text) {
+			std::ifstream stream(path, std::ios::binary);
+			if (!stream) {
+				return false;
+			}
+			std::ostringstream contents;
+			contents << stream.rdbuf();
+			text = std::move(contents).str();
+			return true;
+		}
+
+		bool isSpace(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		std::string_view trim(std::string_view text) {
+			while (!text.empty() && isSpace(text.front())) {
+				text.remove_prefix(1);
+			}
+			while (!text.empty() && isSpace(text.back())) {
+				text.remove_suffix(1);
+			}
+			return text;
+		}
+
+		// Removes and returns the next whitespace separated token of line
+		std::string_view nextToken(std::string_view& line) {
+			line = trim(line);
+			size_t end = 0;
+			while (end < line.size() && !isSpace(line[end])) {
+				++end;
+			}
+			const std::string_view token = line.substr(0, end);
+			line.remove_prefix(end);
+			return token;
+		}
+
+		bool parseFloat(std::string_view token, float& value) {
+			return !token.empty() && std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc{};
+		}
+
+		bool parseFloats(std::string_view& line, float* values, uint32_t count) {
+			for (uint32_t i = 0; i < count; ++i) {
+				if (!parseFloat(nextToken(line), values[i])) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// OBJ indices count from 1, negative ones back from the last element so far
+		bool resolveIndex(std::string_view token, size_t count, uint32_t& index) {
+			int64_t value = 0;
+			if (token.empty() || std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc{} || value == 0) {
+				return false;
+			}
+			const int64_t resolved = value > 0 ? value - 1 : static_cast<int64_t>(count) + value;
+			if (resolved < 0 || resolved >= static_cast<int64_t>(count)) {
+				return false;
+			}
+			index = static_cast<uint32_t>(resolved);
+			return true;
+		}
+
+		// Calls visit(line) for every line with its comment removed
+		template<typename F>
+		bool forEachLine(std::string_view text, F&& visit) {
+			while (!text.empty()) {
+				const size_t end = text.find('\n');
+				std::string_view line = text.substr(0, end);
+				text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+				line = line.substr(0, line.find('#'));
+				if (!visit(trim(line))) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		constexpr uint32_t NO_INDEX = 0xFFFFFFFFu;
+
+		struct S_CornerKey {
+			uint32_t position;
+			uint32_t uv;
+			uint32_t normal;
+
+			bool operator==(const S_CornerKey&) const = default;
+		};
+
+		struct S_CornerKeyHash {
+			size_t operator()(const S_CornerKey& key) const {
+				uint64_t hash = key.position * 0x9E3779B97F4A7C15ull;
+				hash ^= (key.uv + 0x7F4A7C15ull + (hash << 6) + (hash >> 2)) * 0xBF58476D1CE4E5B9ull;
+				hash ^= (key.normal + 0x94D049BBull + (hash << 6) + (hash >> 2)) * 0x94D049BB133111EBull;
+				return static_cast<size_t>(hash ^ (hash >> 31));
+			}
+		};
+
+		// One mesh of the OBJ as faces arrive, with its own de-duplicated vertices
+		struct S_ObjMesh {
+			std::string name;
+			uint32_t material = 0;
+			std::vector<S_Vec3> positions;
+			std::vector<S_Vec3> normals;
+			std::vector<float> uvs;
+			std::vector<uint32_t> indices;
+			std::unordered_map<S_CornerKey, uint32_t, S_CornerKeyHash> corners;
+			bool hasNormals = true;  // Every corner referred to a normal, likewise for UVs
+			bool hasUvs = true;
+		};
+
+		void parseMaterials(std::string_view text, std::unordered_map<std::string, S_SurfaceMaterial>& library) {
+			S_SurfaceMaterial* current = nullptr;
+			float shininess = -1.0f;
+			float roughness = -1.0f;
+			auto finish = [&]() {
+				if (current) {
+					if (roughness >= 0.0f) {
+						current->roughness = roughness;
+					}
+					else if (shininess >= 0.0f) {
+						current->roughness = std::sqrt(2.0f / (shininess + 2.0f));
+					}
+				}
+				shininess = -1.0f;
+				roughness = -1.0f;
+			};
+
+			forEachLine(text, [&](std::string_view line) {
+				const std::string_view keyword = nextToken(line);
+				if (keyword == "newmtl") {
+					finish();
+					current = &library[std::string(trim(line))];
+					*current = S_SurfaceMaterial{};
+					return true;
+				}
+				if (!current) {
+					return true;
+				}
+
+				float values[3];
+				if (keyword == "Kd" && parseFloats(line, values, 3)) {
+					current->albedo = S_Vec3(values[0], values[1], values[2]);
+				}
+				else if (keyword == "Ke" && parseFloats(line, values, 3)) {
+					current->emission = S_Vec3(values[0], values[1], values[2]);
+				}
+				else if (keyword == "Ns" && parseFloats(line, values, 1)) {
+					shininess = values[0];
+				}
+				else if (keyword == "Pr" && parseFloats(line, values, 1)) {
+					roughness = values[0];
+				}
+				else if (keyword == "Pm" && parseFloats(line, values, 1) && values[0] > 0.5f) {
+					current->type = E_SurfaceType::METAL;
+				}
+				else if (keyword == "Ni" && parseFloats(line, values, 1)) {
+					current->ior = values[0];
+				}
+				else if ((keyword == "d" && parseFloats(line, values, 1) && values[0] < 1.0f)
+					|| (keyword == "Tr" && parseFloats(line, values, 1) && values[0] > 0.0f)) {
+					current->type = E_SurfaceType::DIELECTRIC;
+				}
+				else if (keyword == "illum" && parseFloats(line, values, 1) && (values[0] == 4.0f || values[0] == 6.0f || values[0] == 7.0f)) {
+					current->type = E_SurfaceType::DIELECTRIC;
+				}
+				return true;
+			});
+			finish();
+		}
+	}
+
+	// S_SceneConverter implementations
+	bool S_SceneConverter::convertObj(const std::string& objPath, const std::string& scenePath, const S_SceneConvertSettings& settings) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		stats = {};
+		lastError.clear();
+		auto fail = [&](const std::string& message) {
+			lastError = message;
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_SceneConverter", "convertObj", message, objPath);
+			return false;
+		};
+
+		auto start = std::chrono::steady_clock::now();
+		std::string text;
+		if (!readText(objPath, text)) {
+			return fail("Could not read the OBJ file");
+		}
+
+		S_Scene scene;
+		std::unordered_map<std::string, S_SurfaceMaterial> library;
+		std::unordered_map<std::string, uint32_t> sceneMaterials;
+		auto useMaterial = [&](const std::string& name) {
+			const auto found = sceneMaterials.find(name);
+			if (found != sceneMaterials.end()) {
+				return found->second;
+			}
+			const auto defined = library.find(name);
+			const uint32_t material = scene.addMaterial(defined != library.end() ? defined->second : S_SurfaceMaterial{});
+			sceneMaterials.emplace(name, material);
+			return material;
+		};
+
+		std::vector<S_Vec3> positions;
+		std::vector<S_Vec3> normals;
+		std::vector<float> uvs;
+		std::vector<S_ObjMesh> meshes;
+		std::string groupName = "default";
+		std::string materialName;
+		bool meshChanged = true;
+		std::vector<uint32_t> polygon;
+		std::string error;
+
+		const std::filesystem::path directory = std::filesystem::path(objPath).parent_path();
+		const bool parsed = forEachLine(text, [&](std::string_view line) {
+			const std::string_view keyword = nextToken(line);
+			float values[3];
+			if (keyword == "v") {
+				if (!parseFloats(line, values, 3)) {
+					error = "Malformed vertex position";
+					return false;
+				}
+				positions.emplace_back(values[0], values[1], values[2]);
+			}
+			else if (keyword == "vt") {
+				if (!parseFloats(line, values, 2)) {
+					error = "Malformed texture coordinate";
+					return false;
+				}
+				uvs.push_back(values[0]);
+				uvs.push_back(values[1]);
+			}
+			else if (keyword == "vn") {
+				if (!parseFloats(line, values, 3)) {
+					error = "Malformed vertex normal";
+					return false;
+				}
+				normals.emplace_back(values[0], values[1], values[2]);
+			}
+			else if (keyword == "o" || keyword == "g") {
+				groupName = trim(line);
+				meshChanged = true;
+			}
+			else if (keyword == "usemtl") {
+				materialName = trim(line);
+				meshChanged = true;
+			}
+			else if (keyword == "mtllib") {
+				for (std::string_view file = nextToken(line); !file.empty(); file = nextToken(line)) {
+					std::string materialText;
+					if (readText(directory / file, materialText)) {
+						parseMaterials(materialText, library);
+					}
+					else {
+						Instrumentation::logRender(E_LogLevel::WARNING, "S_SceneConverter", "convertObj", "Could not read material library",
+							(directory / file).string());
+					}
+				}
+			}
+			else if (keyword == "f") {
+				if (meshChanged) {
+					if (meshes.empty() || !meshes.back().indices.empty()) {
+						meshes.emplace_back();
+					}
+					meshes.back().name = groupName;
+					meshes.back().material = useMaterial(materialName);
+					meshChanged = false;
+				}
+				S_ObjMesh& mesh = meshes.back();
+
+				polygon.clear();
+				for (std::string_view corner = nextToken(line); !corner.empty(); corner = nextToken(line)) {
+					S_CornerKey key{ NO_INDEX, NO_INDEX, NO_INDEX };
+					const size_t firstSlash = corner.find('/');
+					const size_t secondSlash = firstSlash == std::string_view::npos ? firstSlash : corner.find('/', firstSlash + 1);
+					const std::string_view uvToken = firstSlash == std::string_view::npos ? std::string_view{}
+						: corner.substr(firstSlash + 1, secondSlash == std::string_view::npos ? std::string_view::npos : secondSlash - firstSlash - 1);
+					const std::string_view normalToken = secondSlash == std::string_view::npos ? std::string_view{} : corner.substr(secondSlash + 1);
+					if (!resolveIndex(corner.substr(0, firstSlash), positions.size(), key.position)
+						|| (!uvToken.empty() && !resolveIndex(uvToken, uvs.size() / 2, key.uv))
+						|| (!normalToken.empty() && !resolveIndex(normalToken, normals.size(), key.normal))) {
+						error = "Face refers to a missing vertex";
+						return false;
+					}
+
+					const auto [entry, inserted] = mesh.corners.try_emplace(key, static_cast<uint32_t>(mesh.positions.size()));
+					if (inserted) {
+						mesh.positions.push_back(positions[key.position]);
+						mesh.normals.push_back(key.normal != NO_INDEX ? normals[key.normal] : S_Vec3(0.0f));
+						mesh.uvs.push_back(key.uv != NO_INDEX ? uvs[size_t(key.uv) * 2] : 0.0f);
+						mesh.uvs.push_back(key.uv != NO_INDEX ? uvs[size_t(key.uv) * 2 + 1] : 0.0f);
+						mesh.hasNormals = mesh.hasNormals && key.normal != NO_INDEX;
+						mesh.hasUvs = mesh.hasUvs && key.uv != NO_INDEX;
+					}
+					polygon.push_back(entry->second);
+				}
+				if (polygon.size() < 3) {
+					error = "Face with fewer than three corners";
+					return false;
+				}
+				for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+					mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+				}
+			}
+			return true;
+		});
+		if (!parsed) {
+			return fail(error);
+		}
+		if (!meshes.empty() && meshes.back().indices.empty()) {
+			meshes.pop_back();
+		}
+		if (meshes.empty()) {
+			return fail("OBJ file has no faces");
+		}
+
+		S_SceneFileWriter writer;
+		for (S_ObjMesh& mesh : meshes) {
+			const uint32_t firstVertex = static_cast<uint32_t>(scene.getVertexCount());
+			const uint32_t firstTriangle = scene.addMesh(mesh.positions, mesh.indices, mesh.material);
+			const uint32_t vertexCount = static_cast<uint32_t>(mesh.positions.size());
+			const uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+			mesh.corners.clear();
+			if (!settings.quantize) {
+				writer.addMesh(mesh.name, firstTriangle, triangleCount, firstVertex, vertexCount, mesh.material);
+				continue;
+			}
+
+			const auto quantizeStart = std::chrono::steady_clock::now();
+			S_VertexStreams streams;
+			streams.positions = mesh.positions;
+			if (mesh.hasNormals) {
+				streams.normals = mesh.normals;
+			}
+			if (mesh.hasUvs) {
+				streams.uvs = mesh.uvs;
+			}
+			S_QuantizedMesh quantized;
+			quantized.encode(streams);
+			writer.addMesh(mesh.name, firstTriangle, triangleCount, firstVertex, vertexCount, mesh.material, &quantized);
+			stats.quantizeMilliseconds += millisecondsSince(quantizeStart);
+		}
+		stats.parseMilliseconds = millisecondsSince(start) - stats.quantizeMilliseconds;
+
+		start = std::chrono::steady_clock::now();
+		scene.buildAccelerator(settings.bvh);
+		stats.bvhMilliseconds = millisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		writer.setScene(scene);
+		if (!writer.save(scenePath)) {
+			return fail("Could not write the scene file");
+		}
+		stats.writeMilliseconds = millisecondsSince(start);
+
+		std::error_code sizeError;
+		stats.fileBytes = static_cast<size_t>(std::filesystem::file_size(scenePath, sizeError));
+		stats.meshCount = static_cast<uint32_t>(meshes.size());
+		stats.materialCount = static_cast<uint32_t>(scene.getMaterialCount());
+		stats.triangleCount = static_cast<uint32_t>(scene.getTriangleCount());
+		stats.vertexCount = static_cast<uint32_t>(scene.getVertexCount());
+		return true;
+	}
+
+	const std::string& S_SceneConverter::getLastError() const {
+		return lastError;
+	}
+
+	const S_SceneConvertStats& S_SceneConverter::getStats() const {
+		return stats;
+	}
+
+	void S_SceneConverter::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "parseMilliseconds", stats.parseMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "bvhMilliseconds", stats.bvhMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "quantizeMilliseconds", stats.quantizeMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "writeMilliseconds", stats.writeMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "meshes", static_cast<double>(stats.meshCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "triangles", static_cast<double>(stats.triangleCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "fileBytes", static_cast<double>(stats.fileBytes));
+	}
+}
@@ -0,0 +1,561 @@
+#include "S_SceneFile.h"
+#include "S_TemporaryPath.h"
+#include "SpectraInstrumentation.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace spectra::render {
+	using core::math::S_Aabb;
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr uint32_t FILE_MAGIC = 0x4E435353;  // "SSCN"
+		constexpr uint32_t SECTION_COUNT = static_cast<uint32_t>(E_SceneSection::COUNT);
+
+		size_t alignUp(size_t value, size_t alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		void storeVec3(const S_Vec3& value, float* out) {
+			out[0] = value.x;
+			out[1] = value.y;
+			out[2] = value.z;
+		}
+
+		S_Vec3 loadVec3(const float* value) {
+			return S_Vec3(value[0], value[1], value[2]);
+		}
+
+		// Whether [offset, offset + size) lies within limit, without overflowing
+		bool inRange(uint64_t offset, uint64_t size, uint64_t limit) {
+			return offset <= limit && size <= limit - offset;
+		}
+	}
+
+	struct S_SceneFileView::S_SectionEntry {
+		uint64_t offset;       // From the start of the file
+		uint64_t size;
+		uint32_t count;
+		uint32_t elementSize;
+	};
+
+	struct S_SceneFileView::S_Header {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t size;
+		S_SectionEntry sections[SECTION_COUNT];
+	};
+
+	struct S_SceneFileView::S_Info {
+		float skyHorizon[3];
+		float skyZenith[3];
+		float boundsMin[3];
+		float boundsMax[3];
+		float bvhBoundsMin[3];
+		float bvhBoundsMax[3];
+		uint32_t bvhWidth;
+		uint32_t bvhPrimitiveCount;
+	};
+
+	struct S_SceneFileView::S_MeshRecord {
+		uint32_t nameOffset;   // Into STRINGS
+		uint32_t nameLength;
+		uint32_t firstTriangle;
+		uint32_t triangleCount;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t material;
+		uint32_t firstPacked;  // Into PACKED_VERTICES
+		uint32_t packedCount;  // Zero or vertexCount
+		float boundsMin[3];
+		float boundsMax[3];
+		float positionOffset[3];
+		float positionScale[3];
+		float uvOffset[2];
+		float uvScale[2];
+	};
+
+	struct S_SceneFileView::S_ProgramRecord {
+		uint32_t nameOffset;   // Into STRINGS
+		uint32_t nameLength;
+		uint64_t offset;       // Into PROGRAM_BYTES
+		uint64_t size;
+	};
+
+	// S_SceneFileView implementations
+	bool S_SceneFileView::parse(std::span<const std::byte> bytes, S_SceneFileView& view) {
+		view = S_SceneFileView{};
+		if (bytes.size() < sizeof(S_Header) || reinterpret_cast<uintptr_t>(bytes.data()) % BLOB_ALIGNMENT != 0) {
+			return false;
+		}
+		const auto* header = reinterpret_cast<const S_Header*>(bytes.data());
+		if (header->magic != FILE_MAGIC || header->version != FORMAT_VERSION || header->size != bytes.size()) {
+			return false;
+		}
+
+		const S_SectionEntry& info = header->sections[static_cast<uint32_t>(E_SceneSection::INFO)];
+		if (info.count != 1 || info.elementSize != sizeof(S_Info) || !inRange(info.offset, sizeof(S_Info), bytes.size())
+			|| info.offset % BLOB_ALIGNMENT != 0) {
+			return false;
+		}
+		const auto* infoRecord = reinterpret_cast<const S_Info*>(bytes.data() + info.offset);
+		const uint32_t nodeSize = infoRecord->bvhWidth == 8 ? sizeof(S_WideBvhNode<8>) : sizeof(S_WideBvhNode<4>);
+		const uint32_t elementSizes[SECTION_COUNT] = { sizeof(S_Info), sizeof(S_SurfaceMaterial), sizeof(S_Sphere), sizeof(S_Vec3),
+			sizeof(S_Triangle), sizeof(S_MeshRecord), sizeof(S_PackedVertex), nodeSize, sizeof(uint32_t), sizeof(S_ProgramRecord), 1, 1 };
+		for (uint32_t section = 0; section < SECTION_COUNT; ++section) {
+			const S_SectionEntry& entry = header->sections[section];
+			if (entry.elementSize != elementSizes[section] || entry.size != uint64_t(entry.count) * entry.elementSize) {
+				return false;
+			}
+			if (entry.size > 0 && (entry.offset < sizeof(S_Header) || entry.offset % BLOB_ALIGNMENT != 0 || !inRange(entry.offset, entry.size, bytes.size()))) {
+				return false;
+			}
+		}
+
+		view.bytes = bytes;
+		view.header = header;
+
+		// Records are few, so checking them keeps parsing independent of the geometry
+		const std::span<const char> strings = view.getArray<char>(E_SceneSection::STRINGS);
+		const uint32_t triangleCount = header->sections[static_cast<uint32_t>(E_SceneSection::TRIANGLES)].count;
+		const uint32_t vertexCount = header->sections[static_cast<uint32_t>(E_SceneSection::VERTICES)].count;
+		const uint32_t materialCount = header->sections[static_cast<uint32_t>(E_SceneSection::MATERIALS)].count;
+		const uint32_t packedCount = header->sections[static_cast<uint32_t>(E_SceneSection::PACKED_VERTICES)].count;
+		for (const S_MeshRecord& mesh : view.getArray<S_MeshRecord>(E_SceneSection::MESHES)) {
+			const bool valid = inRange(mesh.nameOffset, mesh.nameLength, strings.size()) && inRange(mesh.firstTriangle, mesh.triangleCount, triangleCount)
+				&& inRange(mesh.firstVertex, mesh.vertexCount, vertexCount) && mesh.material < materialCount
+				&& inRange(mesh.firstPacked, mesh.packedCount, packedCount) && (mesh.packedCount == 0 || mesh.packedCount == mesh.vertexCount);
+			if (!valid) {
+				view = S_SceneFileView{};
+				return false;
+			}
+		}
+		const uint64_t programBytes = header->sections[static_cast<uint32_t>(E_SceneSection::PROGRAM_BYTES)].size;
+		for (const S_ProgramRecord& program : view.getArray<S_ProgramRecord>(E_SceneSection::PROGRAMS)) {
+			if (!inRange(program.nameOffset, program.nameLength, strings.size()) || !inRange(program.offset, program.size, programBytes)) {
+				view = S_SceneFileView{};
+				return false;
+			}
+		}
+
+		const S_SectionEntry& nodes = header->sections[static_cast<uint32_t>(E_SceneSection::BVH_NODES)];
+		const S_SectionEntry& indices = header->sections[static_cast<uint32_t>(E_SceneSection::BVH_INDICES)];
+		if (nodes.count > 0) {
+			const uint32_t sphereCount = header->sections[static_cast<uint32_t>(E_SceneSection::SPHERES)].count;
+			if ((infoRecord->bvhWidth != 4 && infoRecord->bvhWidth != 8) || uint64_t(infoRecord->bvhPrimitiveCount) != uint64_t(triangleCount) + sphereCount
+				|| indices.count < infoRecord->bvhPrimitiveCount) {
+				view = S_SceneFileView{};
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool S_SceneFileView::verifyContents() const {
+		if (!header) {
+			return false;
+		}
+		const std::span<const S_Vec3> vertices = getVertices();
+		const size_t materialCount = getMaterials().size();
+		for (const S_Triangle& triangle : getTriangles()) {
+			if (triangle.vertices[0] >= vertices.size() || triangle.vertices[1] >= vertices.size() || triangle.vertices[2] >= vertices.size()
+				|| triangle.material >= materialCount) {
+				return false;
+			}
+		}
+		for (const S_Sphere& sphere : getSpheres()) {
+			if (sphere.material >= materialCount) {
+				return false;
+			}
+		}
+
+		const S_BvhView bvh = getBvh();
+		for (const uint32_t primitive : bvh.primitiveIndices) {
+			if (primitive >= bvh.primitiveCount) {
+				return false;
+			}
+		}
+
+		// Children must follow their parent, as the depth-first layout has them, which rules out
+		// cycles and bounds the depth traversal has to stack
+		auto verifyNodes = [&]<uint32_t N>(std::span<const S_WideBvhNode<N>> nodes) {
+			std::vector<uint32_t> depth(nodes.size(), 0);
+			for (uint32_t node = 0; node < nodes.size(); ++node) {
+				if (nodes[node].childCount > N) {
+					return false;
+				}
+				for (uint32_t child = 0; child < nodes[node].childCount; ++child) {
+					const uint8_t type = nodes[node].childType[child];
+					const uint32_t index = nodes[node].child[child];
+					if (type == S_WideBvhNode<N>::INTERNAL_CHILD) {
+						if (index <= node || index >= nodes.size() || depth[node] + 1 >= S_Bvh::MAX_DEPTH) {
+							return false;
+						}
+						depth[index] = depth[node] + 1;
+					}
+					else if (type == S_WideBvhNode<N>::EMPTY_CHILD || !inRange(index, type, bvh.primitiveIndices.size())) {
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+		return bvh.width == E_BvhWidth::WIDE_8 ? verifyNodes(bvh.nodes8) : verifyNodes(bvh.nodes4);
+	}
+
+	bool S_SceneFileView::isValid() const {
+		return header != nullptr;
+	}
+
+	std::span<const std::byte> S_SceneFileView::getBytes() const {
+		return bytes;
+	}
+
+	std::span<const std::byte> S_SceneFileView::getSection(E_SceneSection section) const {
+		if (section >= E_SceneSection::COUNT) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_SceneFileView", "getSection", "Section out of range",
+				static_cast<uint32_t>(section));
+		}
+		if (!header) {
+			return {};
+		}
+		const S_SectionEntry& entry = header->sections[static_cast<uint32_t>(section)];
+		return bytes.subspan(entry.offset, entry.size);
+	}
+
+	template<typename T>
+	std::span<const T> S_SceneFileView::getArray(E_SceneSection section) const {
+		if (!header) {
+			return {};
+		}
+		const S_SectionEntry& entry = header->sections[static_cast<uint32_t>(section)];
+		return { reinterpret_cast<const T*>(bytes.data() + entry.offset), entry.count };
+	}
+
+	std::span<const S_SurfaceMaterial> S_SceneFileView::getMaterials() const {
+		return getArray<S_SurfaceMaterial>(E_SceneSection::MATERIALS);
+	}
+
+	std::span<const S_Sphere> S_SceneFileView::getSpheres() const {
+		return getArray<S_Sphere>(E_SceneSection::SPHERES);
+	}
+
+	std::span<const S_Vec3> S_SceneFileView::getVertices() const {
+		return getArray<S_Vec3>(E_SceneSection::VERTICES);
+	}
+
+	std::span<const S_Triangle> S_SceneFileView::getTriangles() const {
+		return getArray<S_Triangle>(E_SceneSection::TRIANGLES);
+	}
+
+	S_Vec3 S_SceneFileView::getSkyHorizon() const {
+		return header ? loadVec3(getArray<S_Info>(E_SceneSection::INFO)[0].skyHorizon) : S_Vec3(0.0f);
+	}
+
+	S_Vec3 S_SceneFileView::getSkyZenith() const {
+		return header ? loadVec3(getArray<S_Info>(E_SceneSection::INFO)[0].skyZenith) : S_Vec3(0.0f);
+	}
+
+	S_Aabb S_SceneFileView::getBounds() const {
+		if (!header) {
+			return {};
+		}
+		const S_Info& info = getArray<S_Info>(E_SceneSection::INFO)[0];
+		return S_Aabb(loadVec3(info.boundsMin), loadVec3(info.boundsMax));
+	}
+
+	uint32_t S_SceneFileView::getMeshCount() const {
+		return static_cast<uint32_t>(getArray<S_MeshRecord>(E_SceneSection::MESHES).size());
+	}
+
+	S_SceneMesh S_SceneFileView::getMesh(uint32_t mesh) const {
+		if (mesh >= getMeshCount()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_SceneFileView", "getMesh", "Mesh out of range", mesh);
+		}
+		const S_MeshRecord& record = getArray<S_MeshRecord>(E_SceneSection::MESHES)[mesh];
+		const std::span<const char> strings = getArray<char>(E_SceneSection::STRINGS);
+		S_SceneMesh result;
+		result.name = std::string_view(strings.data() + record.nameOffset, record.nameLength);
+		result.firstTriangle = record.firstTriangle;
+		result.triangleCount = record.triangleCount;
+		result.firstVertex = record.firstVertex;
+		result.vertexCount = record.vertexCount;
+		result.material = record.material;
+		result.bounds = S_Aabb(loadVec3(record.boundsMin), loadVec3(record.boundsMax));
+		result.packedVertices = getArray<S_PackedVertex>(E_SceneSection::PACKED_VERTICES).subspan(record.firstPacked, record.packedCount);
+		result.positionOffset = loadVec3(record.positionOffset);
+		result.positionScale = loadVec3(record.positionScale);
+		std::memcpy(result.uvOffset, record.uvOffset, sizeof(result.uvOffset));
+		std::memcpy(result.uvScale, record.uvScale, sizeof(result.uvScale));
+		return result;
+	}
+
+	S_BvhView S_SceneFileView::getBvh() const {
+		S_BvhView view;
+		if (!header || header->sections[static_cast<uint32_t>(E_SceneSection::BVH_NODES)].count == 0) {
+			return view;
+		}
+		const S_Info& info = getArray<S_Info>(E_SceneSection::INFO)[0];
+		view.width = info.bvhWidth == 8 ? E_BvhWidth::WIDE_8 : E_BvhWidth::WIDE_4;
+		view.primitiveCount = info.bvhPrimitiveCount;
+		view.bounds = S_Aabb(loadVec3(info.bvhBoundsMin), loadVec3(info.bvhBoundsMax));
+		if (view.width == E_BvhWidth::WIDE_8) {
+			view.nodes8 = getArray<S_WideBvhNode<8>>(E_SceneSection::BVH_NODES);
+		}
+		else {
+			view.nodes4 = getArray<S_WideBvhNode<4>>(E_SceneSection::BVH_NODES);
+		}
+		view.primitiveIndices = getArray<uint32_t>(E_SceneSection::BVH_INDICES);
+		return view;
+	}
+
+	uint32_t S_SceneFileView::getProgramCount() const {
+		return static_cast<uint32_t>(getArray<S_ProgramRecord>(E_SceneSection::PROGRAMS).size());
+	}
+
+	S_SceneProgram S_SceneFileView::getProgram(uint32_t program) const {
+		if (program >= getProgramCount()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_SceneFileView", "getProgram", "Program out of range", program);
+		}
+		const S_ProgramRecord& record = getArray<S_ProgramRecord>(E_SceneSection::PROGRAMS)[program];
+		const std::span<const char> strings = getArray<char>(E_SceneSection::STRINGS);
+		return { std::string_view(strings.data() + record.nameOffset, record.nameLength),
+			getSection(E_SceneSection::PROGRAM_BYTES).subspan(record.offset, record.size) };
+	}
+
+	S_SceneProgram S_SceneFileView::findProgram(std::string_view name) const {
+		for (uint32_t program = 0; program < getProgramCount(); ++program) {
+			const S_SceneProgram found = getProgram(program);
+			if (found.name == name) {
+				return found;
+			}
+		}
+		return {};
+	}
+
+	// S_SceneFileWriter implementations
+	void S_SceneFileWriter::setScene(const S_Scene& source) {
+		scene = &source;
+	}
+
+	uint32_t S_SceneFileWriter::addMesh(std::string_view name, uint32_t firstTriangle, uint32_t triangleCount, uint32_t firstVertex,
+		uint32_t vertexCount, uint32_t material, const S_QuantizedMesh* quantized) {
+		if (quantized && quantized->getVertexCount() != vertexCount) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_SceneFileWriter", "addMesh",
+				"Quantized mesh does not match the vertex range", quantized->getVertexCount(), vertexCount);
+		}
+
+		S_PendingMesh& mesh = meshes.emplace_back();
+		mesh.name = name;
+		mesh.firstTriangle = firstTriangle;
+		mesh.triangleCount = triangleCount;
+		mesh.firstVertex = firstVertex;
+		mesh.vertexCount = vertexCount;
+		mesh.material = material;
+		mesh.uvOffset[0] = mesh.uvOffset[1] = 0.0f;
+		mesh.uvScale[0] = mesh.uvScale[1] = 0.0f;
+		if (quantized) {
+			mesh.packedVertices.assign(quantized->getVertices().begin(), quantized->getVertices().end());
+			mesh.positionOffset = quantized->getPositionOffset();
+			mesh.positionScale = quantized->getPositionScale();
+			std::memcpy(mesh.uvOffset, quantized->getUvOffset(), sizeof(mesh.uvOffset));
+			std::memcpy(mesh.uvScale, quantized->getUvScale(), sizeof(mesh.uvScale));
+		}
+		return static_cast<uint32_t>(meshes.size() - 1);
+	}
+
+	void S_SceneFileWriter::addProgram(std::string_view name, std::span<const std::byte> bytes) {
+		programs.push_back({ std::string(name), std::vector<std::byte>(bytes.begin(), bytes.end()) });
+	}
+
+	std::vector<std::byte> S_SceneFileWriter::write() const {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+		using Section = E_SceneSection;
+
+		if (!scene) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_SceneFileWriter", "write", "No scene set");
+		}
+		const std::span<const S_Vec3> vertices = scene->getVertices();
+		const std::span<const S_Triangle> triangles = scene->getTriangles();
+		const S_BvhView bvh = scene->getAccelerator().getView();
+
+		S_SceneFileView::S_Info info{};
+		storeVec3(scene->getSkyHorizon(), info.skyHorizon);
+		storeVec3(scene->getSkyZenith(), info.skyZenith);
+		S_Aabb bounds;
+		for (const S_Vec3& vertex : vertices) {
+			bounds.extend(vertex);
+		}
+		for (const S_Sphere& sphere : scene->getSpheres()) {
+			bounds.extend(S_Aabb(sphere.center - S_Vec3(sphere.radius), sphere.center + S_Vec3(sphere.radius)));
+		}
+		storeVec3(bounds.min, info.boundsMin);
+		storeVec3(bounds.max, info.boundsMax);
+		storeVec3(bvh.bounds.min, info.bvhBoundsMin);
+		storeVec3(bvh.bounds.max, info.bvhBoundsMax);
+		info.bvhWidth = static_cast<uint32_t>(bvh.width);
+		info.bvhPrimitiveCount = bvh.primitiveCount;
+
+		std::string strings;
+		std::vector<S_SceneFileView::S_MeshRecord> meshRecords;
+		std::vector<S_PackedVertex> packedVertices;
+		for (const S_PendingMesh& mesh : meshes) {
+			if (size_t(mesh.firstTriangle) + mesh.triangleCount > triangles.size() || size_t(mesh.firstVertex) + mesh.vertexCount > vertices.size()
+				|| mesh.material >= scene->getMaterialCount()) {
+				Instrumentation::logRender(E_LogLevel::ERROR, "S_SceneFileWriter", "write", "Mesh is outside the scene", mesh.name);
+			}
+			S_SceneFileView::S_MeshRecord record{};
+			record.nameOffset = static_cast<uint32_t>(strings.size());
+			record.nameLength = static_cast<uint32_t>(mesh.name.size());
+			record.firstTriangle = mesh.firstTriangle;
+			record.triangleCount = mesh.triangleCount;
+			record.firstVertex = mesh.firstVertex;
+			record.vertexCount = mesh.vertexCount;
+			record.material = mesh.material;
+			record.firstPacked = static_cast<uint32_t>(packedVertices.size());
+			record.packedCount = static_cast<uint32_t>(mesh.packedVertices.size());
+			S_Aabb meshBounds;
+			for (uint32_t v = 0; v < mesh.vertexCount; ++v) {
+				meshBounds.extend(vertices[mesh.firstVertex + v]);
+			}
+			storeVec3(meshBounds.min, record.boundsMin);
+			storeVec3(meshBounds.max, record.boundsMax);
+			storeVec3(mesh.positionOffset, record.positionOffset);
+			storeVec3(mesh.positionScale, record.positionScale);
+			std::memcpy(record.uvOffset, mesh.uvOffset, sizeof(record.uvOffset));
+			std::memcpy(record.uvScale, mesh.uvScale, sizeof(record.uvScale));
+			strings += mesh.name;
+			packedVertices.insert(packedVertices.end(), mesh.packedVertices.begin(), mesh.packedVertices.end());
+			meshRecords.push_back(record);
+		}
+
+		// Each program starts on its own boundary so it can be used in place as well
+		std::vector<S_SceneFileView::S_ProgramRecord> programRecords;
+		std::vector<std::byte> programBytes;
+		for (const S_PendingProgram& program : programs) {
+			const size_t offset = alignUp(programBytes.size(), S_SceneFileView::BLOB_ALIGNMENT);
+			programRecords.push_back({ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(program.name.size()), offset, program.bytes.size() });
+			strings += program.name;
+			programBytes.resize(offset);
+			programBytes.insert(programBytes.end(), program.bytes.begin(), program.bytes.end());
+		}
+
+		const void* nodeData = bvh.width == E_BvhWidth::WIDE_8 ? static_cast<const void*>(bvh.nodes8.data()) : static_cast<const void*>(bvh.nodes4.data());
+		const size_t nodeCount = bvh.width == E_BvhWidth::WIDE_8 ? bvh.nodes8.size() : bvh.nodes4.size();
+		const size_t nodeSize = bvh.width == E_BvhWidth::WIDE_8 ? sizeof(S_WideBvhNode<8>) : sizeof(S_WideBvhNode<4>);
+
+		struct S_Source {
+			const void* data;
+			size_t count;
+			size_t elementSize;
+		};
+		const S_Source sources[SECTION_COUNT] = {
+			{ &info, 1, sizeof(info) },
+			{ scene->getMaterials().data(), scene->getMaterials().size(), sizeof(S_SurfaceMaterial) },
+			{ scene->getSpheres().data(), scene->getSpheres().size(), sizeof(S_Sphere) },
+			{ vertices.data(), vertices.size(), sizeof(S_Vec3) },
+			{ triangles.data(), triangles.size(), sizeof(S_Triangle) },
+			{ meshRecords.data(), meshRecords.size(), sizeof(S_SceneFileView::S_MeshRecord) },
+			{ packedVertices.data(), packedVertices.size(), sizeof(S_PackedVertex) },
+			{ nodeData, nodeCount, nodeSize },
+			{ bvh.primitiveIndices.data(), bvh.primitiveIndices.size(), sizeof(uint32_t) },
+			{ programRecords.data(), programRecords.size(), sizeof(S_SceneFileView::S_ProgramRecord) },
+			{ programBytes.data(), programBytes.size(), 1 },
+			{ strings.data(), strings.size(), 1 }
+		};
+		static_assert(static_cast<uint32_t>(Section::STRINGS) + 1 == SECTION_COUNT);
+
+		S_SceneFileView::S_Header header{};
+		header.magic = FILE_MAGIC;
+		header.version = S_SceneFileView::FORMAT_VERSION;
+		size_t size = alignUp(sizeof(header), S_SceneFileView::BLOB_ALIGNMENT);
+		for (uint32_t section = 0; section < SECTION_COUNT; ++section) {
+			if (sources[section].count > UINT32_MAX) {
+				Instrumentation::logRender(E_LogLevel::ERROR, "S_SceneFileWriter", "write", "Section too large", section,
+					static_cast<uint64_t>(sources[section].count));
+			}
+			S_SceneFileView::S_SectionEntry& entry = header.sections[section];
+			entry.count = static_cast<uint32_t>(sources[section].count);
+			entry.elementSize = static_cast<uint32_t>(sources[section].elementSize);
+			entry.size = uint64_t(entry.count) * entry.elementSize;
+			entry.offset = entry.size > 0 ? size : 0;
+			size = alignUp(size + entry.size, S_SceneFileView::BLOB_ALIGNMENT);
+		}
+		header.size = size;
+
+		std::vector<std::byte> bytes(size);
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		for (uint32_t section = 0; section < SECTION_COUNT; ++section) {
+			const S_SceneFileView::S_SectionEntry& entry = header.sections[section];
+			if (entry.size > 0) {
+				std::memcpy(bytes.data() + entry.offset, sources[section].data, entry.size);
+			}
+		}
+		return bytes;
+	}
+
+	bool S_SceneFileWriter::save(const std::string& path) const {
+		const std::vector<std::byte> bytes = write();
+		const std::string temporaryPath = core::platform::S_TemporaryPath::make(path);
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			if (!stream) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_SceneFileWriter", "save",
+					"Could not write scene file", temporaryPath);
+				stream.close();
+				std::error_code error;
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_SceneFileWriter", "save",
+				"Could not replace scene file", path, error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	// S_SceneFile implementations
+	bool S_SceneFile::open(const std::string& path) {
+		close();
+		if (!file.open(path)) {
+			lastError = file.getLastError();
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_SceneFile", "open", "Could not map the scene file",
+				path, lastError);
+			return false;
+		}
+		if (!S_SceneFileView::parse({ file.getData(), file.getSize() }, view)) {
+			lastError = "Not a valid scene file of this version";
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_SceneFile", "open", "Ignoring a corrupt scene file", path);
+			file.close();
+			return false;
+		}
+		return true;
+	}
+
+	void S_SceneFile::close() {
+		view = S_SceneFileView{};
+		file.close();
+		lastError.clear();
+	}
+
+	bool S_SceneFile::isOpen() const {
+		return view.isValid();
+	}
+
+	const S_SceneFileView& S_SceneFile::getView() const {
+		return view;
+	}
+
+	const std::string& S_SceneFile::getLastError() const {
+		return lastError;
+	}
+}
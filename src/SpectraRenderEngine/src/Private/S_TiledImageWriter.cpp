@@ -0,0 +1,260 @@
+#include "S_TiledImageWriter.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+
+namespace spectra::render {
+	namespace {
+		constexpr uint32_t EXR_MAGIC = 20000630;
+		constexpr uint32_t EXR_VERSION = 2;
+		constexpr uint32_t EXR_TILED_FLAG = 0x200;
+		constexpr int32_t EXR_PIXEL_FLOAT = 2;
+		constexpr uint8_t EXR_RANDOM_Y = 2;  // Line order of files whose tiles are not in scanline order
+
+		// EXR is little-endian throughout
+		template<typename T>
+		void appendLittleEndian(std::vector<char>& bytes, T value) {
+			const auto raw = std::bit_cast<std::array<char, sizeof(T)>>(value);
+			for (size_t i = 0; i < sizeof(T); ++i) {
+				bytes.push_back(raw[std::endian::native == std::endian::little ? i : sizeof(T) - 1 - i]);
+			}
+		}
+
+		void appendString(std::vector<char>& bytes, const char* text) {
+			bytes.insert(bytes.end(), text, text + std::strlen(text) + 1);
+		}
+
+		void appendAttribute(std::vector<char>& bytes, const char* name, const char* type, const std::vector<char>& value) {
+			appendString(bytes, name);
+			appendString(bytes, type);
+			appendLittleEndian(bytes, static_cast<int32_t>(value.size()));
+			bytes.insert(bytes.end(), value.begin(), value.end());
+		}
+
+		std::vector<char> makeExrHeader(uint32_t width, uint32_t height, uint32_t tileSize) {
+			std::vector<char> header;
+			appendLittleEndian(header, EXR_MAGIC);
+			appendLittleEndian(header, EXR_VERSION | EXR_TILED_FLAG);
+
+			std::vector<char> value;
+			for (const char* channel : { "B", "G", "R" }) {
+				appendString(value, channel);
+				appendLittleEndian(value, EXR_PIXEL_FLOAT);
+				value.insert(value.end(), { 0, 0, 0, 0 });  // pLinear and reserved
+				appendLittleEndian(value, int32_t{ 1 });  // x and y sampling
+				appendLittleEndian(value, int32_t{ 1 });
+			}
+			value.push_back(0);
+			appendAttribute(header, "channels", "chlist", value);
+
+			appendAttribute(header, "compression", "compression", { 0 });
+
+			value.clear();
+			for (int32_t bound : { 0, 0, static_cast<int32_t>(width) - 1, static_cast<int32_t>(height) - 1 }) {
+				appendLittleEndian(value, bound);
+			}
+			appendAttribute(header, "dataWindow", "box2i", value);
+			appendAttribute(header, "displayWindow", "box2i", value);
+
+			appendAttribute(header, "lineOrder", "lineOrder", { static_cast<char>(EXR_RANDOM_Y) });
+
+			value.clear();
+			appendLittleEndian(value, 1.0f);
+			appendAttribute(header, "pixelAspectRatio", "float", value);
+			appendAttribute(header, "screenWindowWidth", "float", value);
+
+			value.clear();
+			appendLittleEndian(value, 0.0f);
+			appendLittleEndian(value, 0.0f);
+			appendAttribute(header, "screenWindowCenter", "v2f", value);
+
+			value.clear();
+			appendLittleEndian(value, tileSize);
+			appendLittleEndian(value, tileSize);
+			value.push_back(0);  // ONE_LEVEL, rounding down
+			appendAttribute(header, "tiles", "tiledesc", value);
+
+			header.push_back(0);
+			return header;
+		}
+	}
+
+	// S_TiledImageWriter implementations
+	S_TiledImageWriter::~S_TiledImageWriter() {
+		if (isOpen()) {
+			close();
+		}
+	}
+
+	bool S_TiledImageWriter::open(const std::string& filePath, E_ImageFormat imageFormat, uint32_t imageWidth, uint32_t imageHeight,
+		uint32_t imageTileSize) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (isOpen()) {
+			close();
+		}
+		if (imageWidth == 0 || imageHeight == 0 || imageTileSize == 0) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_TiledImageWriter", "open", "Image and tile size must be non-zero",
+				imageWidth, imageHeight, imageTileSize);
+			return false;
+		}
+
+		stream.open(filePath, std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_TiledImageWriter", "open", "Could not create image", filePath);
+			return false;
+		}
+		path = filePath;
+		format = imageFormat;
+		width = imageWidth;
+		height = imageHeight;
+		tileSize = imageTileSize;
+		tilesX = (width + tileSize - 1) / tileSize;
+		tilesY = (height + tileSize - 1) / tileSize;
+		tileWritten.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+		tilesWritten = 0;
+
+		if (format == E_ImageFormat::PFM) {
+			// A negative scale marks little-endian floats
+			const std::string header = "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n"
+				+ (std::endian::native == std::endian::little ? "-1.0\n" : "1.0\n");
+			stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+			dataStart = header.size();
+		}
+		else {
+			const std::vector<char> header = makeExrHeader(width, height, tileSize);
+			stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+			dataStart = header.size();
+
+			// Reserve the offset table; chunks follow it and the table is filled in by close()
+			chunkOffsets.assign(tileWritten.size(), 0);
+			scratch.assign(chunkOffsets.size() * sizeof(uint64_t), 0);
+			stream.write(scratch.data(), static_cast<std::streamsize>(scratch.size()));
+		}
+		return static_cast<bool>(stream);
+	}
+
+	bool S_TiledImageWriter::writeTile(uint32_t tileX, uint32_t tileY, std::span<const float> rgb) {
+		if (!isOpen() || tileX >= tilesX || tileY >= tilesY) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_TiledImageWriter", "writeTile",
+				"Tile outside the image or writer not open", tileX, tileY, path);
+			return false;
+		}
+		const uint32_t x0 = tileX * tileSize;
+		const uint32_t y0 = tileY * tileSize;
+		const uint32_t tileWidth = std::min(tileSize, width - x0);
+		const uint32_t tileHeight = std::min(tileSize, height - y0);
+		if (rgb.size() < static_cast<size_t>(tileWidth) * tileHeight * 3) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_TiledImageWriter", "writeTile",
+				"Tile data is smaller than the tile", tileX, tileY, rgb.size());
+			return false;
+		}
+
+		if (format == E_ImageFormat::PFM) {
+			const std::streamsize rowBytes = static_cast<std::streamsize>(tileWidth) * 3 * sizeof(float);
+			for (uint32_t row = 0; row < tileHeight; ++row) {
+				const uint64_t fileRow = height - 1 - (y0 + row);
+				stream.seekp(static_cast<std::streamoff>(dataStart + (fileRow * width + x0) * 3 * sizeof(float)));
+				stream.write(reinterpret_cast<const char*>(rgb.data() + static_cast<size_t>(row) * tileWidth * 3), rowBytes);
+			}
+		}
+		else {
+			// Chunk: tile and level coordinates, byte count, then per scanline the B, G and R runs
+			const uint32_t pixelBytes = tileWidth * tileHeight * 3 * sizeof(float);
+			scratch.clear();
+			for (int32_t value : { static_cast<int32_t>(tileX), static_cast<int32_t>(tileY), 0, 0, static_cast<int32_t>(pixelBytes) }) {
+				appendLittleEndian(scratch, value);
+			}
+			for (uint32_t row = 0; row < tileHeight; ++row) {
+				const float* line = rgb.data() + static_cast<size_t>(row) * tileWidth * 3;
+				for (int channel = 2; channel >= 0; --channel) {
+					for (uint32_t x = 0; x < tileWidth; ++x) {
+						appendLittleEndian(scratch, line[x * 3 + channel]);
+					}
+				}
+			}
+			stream.seekp(0, std::ios::end);
+			chunkOffsets[static_cast<size_t>(tileY) * tilesX + tileX] = static_cast<uint64_t>(stream.tellp());
+			stream.write(scratch.data(), static_cast<std::streamsize>(scratch.size()));
+		}
+
+		uint8_t& written = tileWritten[static_cast<size_t>(tileY) * tilesX + tileX];
+		tilesWritten += written ? 0 : 1;
+		written = 1;
+		return static_cast<bool>(stream);
+	}
+
+	bool S_TiledImageWriter::close() {
+		if (!isOpen()) {
+			return false;
+		}
+		if (format == E_ImageFormat::EXR) {
+			scratch.clear();
+			for (uint64_t offset : chunkOffsets) {
+				appendLittleEndian(scratch, offset);
+			}
+			stream.seekp(static_cast<std::streamoff>(dataStart));
+			stream.write(scratch.data(), static_cast<std::streamsize>(scratch.size()));
+		}
+		else if (tilesWritten < getTileCount()) {
+			// Give the file its full length even if the last rows were never written
+			stream.seekp(0, std::ios::end);
+			const uint64_t fullSize = dataStart + static_cast<uint64_t>(width) * height * 3 * sizeof(float);
+			const uint64_t currentSize = static_cast<uint64_t>(stream.tellp());
+			if (currentSize < fullSize) {
+				stream.seekp(static_cast<std::streamoff>(fullSize - 1));
+				stream.put(0);
+			}
+		}
+		const bool written = static_cast<bool>(stream);
+		stream.close();
+		scratch = {};
+
+		const bool complete = tilesWritten == getTileCount();
+		if (!complete || !written) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_TiledImageWriter", "close",
+				"Image closed incomplete or with write errors", path, tilesWritten, getTileCount());
+		}
+		return complete && written;
+	}
+
+	bool S_TiledImageWriter::isOpen() const {
+		return stream.is_open();
+	}
+
+	E_ImageFormat S_TiledImageWriter::getFormat() const {
+		return format;
+	}
+
+	uint32_t S_TiledImageWriter::getWidth() const {
+		return width;
+	}
+
+	uint32_t S_TiledImageWriter::getHeight() const {
+		return height;
+	}
+
+	uint32_t S_TiledImageWriter::getTileSize() const {
+		return tileSize;
+	}
+
+	uint32_t S_TiledImageWriter::getTileCount() const {
+		return tilesX * tilesY;
+	}
+
+	uint32_t S_TiledImageWriter::getTilesWritten() const {
+		return tilesWritten;
+	}
+
+	E_ImageFormat S_TiledImageWriter::formatFromPath(const std::string& filePath) {
+		std::string extension = std::filesystem::path(filePath).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".exr" ? E_ImageFormat::EXR : E_ImageFormat::PFM;
+	}
+}
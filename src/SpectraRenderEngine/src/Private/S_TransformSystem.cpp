@@ -0,0 +1,281 @@
+#include "S_TransformSystem.h"
+#include "S_JobSystem.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace spectra::render {
+	using core::ecs::S_Entity;
+	using core::math::S_Aabb;
+	using core::math::S_Transform;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::transforms";
+		constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+		constexpr uint32_t VISITING = NO_SLOT - 1;
+
+		// Slots per job when a level is propagated
+		constexpr size_t PROPAGATE_GRAIN = 1024;
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		struct S_Gathered {
+			S_Entity entity;
+			S_Entity parent;
+			const S_Transform* local;
+			S_Transform* world;
+			const S_Aabb* localBounds;  // Null for entities without bounds
+			S_Aabb* worldBounds;
+		};
+	}
+
+	// S_TransformSystem implementations
+	S_TransformSystem::S_TransformSystem(core::ecs::S_EntityWorld& world, const S_BvhBuildSettings& bvhSettings)
+		: world(&world), bvhSettings(bvhSettings) {
+		// Degenerate rather than empty default bounds keep unset entities out of NaN territory in the BVH
+		const S_Aabb point(core::math::S_Vec3(0.0f), core::math::S_Vec3(0.0f));
+		components.local = world.registerComponent<S_Transform>("LocalTransform");
+		components.world = world.registerComponent<S_Transform>("WorldTransform");
+		components.parent = world.registerComponent<S_Parent>("Parent");
+		components.localBounds = world.registerComponent<S_Aabb>("LocalBounds", point);
+		components.worldBounds = world.registerComponent<S_Aabb>("WorldBounds", point);
+	}
+
+	const S_TransformComponents& S_TransformSystem::getComponents() const {
+		return components;
+	}
+
+	void S_TransformSystem::rebuildHierarchy() {
+		// Every placed entity with its parent and component pointers, in chunk order
+		std::vector<S_Gathered> gathered;
+		gathered.reserve(world->getEntityCount());
+		slotOfEntity.assign(world->getEntityCapacity(), NO_SLOT);
+		for (const core::ecs::S_ChunkView& chunk : chunks) {
+			const std::span<const S_Entity> chunkEntities = chunk.getEntities();
+			const std::span<const S_Transform> local = chunk.read(components.local);
+			const std::span<S_Transform> placed = chunk.write(components.world);
+			const std::span<const S_Parent> parents = chunk.read(components.parent);
+			const bool bounded = chunk.has(components.localBounds) && chunk.has(components.worldBounds);
+			const std::span<const S_Aabb> boxes = bounded ? chunk.read(components.localBounds) : std::span<const S_Aabb>();
+			const std::span<S_Aabb> placedBoxes = bounded ? chunk.write(components.worldBounds) : std::span<S_Aabb>();
+			for (uint32_t row = 0; row < chunk.getCount(); ++row) {
+				slotOfEntity[chunkEntities[row].index] = static_cast<uint32_t>(gathered.size());
+				gathered.push_back({ chunkEntities[row], parents.empty() ? S_Entity{} : parents[row].entity, &local[row], &placed[row],
+					bounded ? &boxes[row] : nullptr, bounded ? &placedBoxes[row] : nullptr });
+			}
+		}
+
+		const uint32_t count = static_cast<uint32_t>(gathered.size());
+		std::vector<uint32_t> parentOf(count, NO_SLOT);
+		for (uint32_t i = 0; i < count; ++i) {
+			const S_Entity parent = gathered[i].parent;
+			if (world->isAlive(parent)) {
+				parentOf[i] = slotOfEntity[parent.index];
+			}
+		}
+
+		// Depths by walking up to the first known ancestor
+		std::vector<uint32_t> depths(count, NO_SLOT);
+		std::vector<uint32_t> path;
+		uint32_t levelCount = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			path.clear();
+			uint32_t current = i;
+			while (current != NO_SLOT && depths[current] == NO_SLOT) {
+				depths[current] = VISITING;
+				path.push_back(current);
+				current = parentOf[current];
+			}
+			if (current != NO_SLOT && depths[current] == VISITING) {
+				instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_TransformSystem", "update", "Parent cycle",
+					gathered[current].entity.index);
+			}
+			uint32_t depth = current == NO_SLOT ? 0 : depths[current] + 1;
+			for (size_t j = path.size(); j-- > 0;) {
+				depths[path[j]] = depth++;
+			}
+			levelCount = std::max(levelCount, depth);
+		}
+
+		// Counting sort by depth keeps chunk order within a level
+		levelOffsets.assign(levelCount + 1, 0);
+		for (uint32_t i = 0; i < count; ++i) {
+			++levelOffsets[depths[i] + 1];
+		}
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			levelOffsets[level + 1] += levelOffsets[level];
+		}
+		std::vector<uint32_t> slotOf(count);
+		{
+			std::vector<uint32_t> cursor(levelOffsets.begin(), levelOffsets.end() - 1);
+			for (uint32_t i = 0; i < count; ++i) {
+				slotOf[i] = cursor[depths[i]]++;
+			}
+		}
+
+		entities.resize(count);
+		parentSlots.resize(count);
+		primitiveSlots.resize(count);
+		localTransforms.resize(count);
+		worldTransforms.resize(count);
+		localBounds.resize(count);
+		worldBounds.resize(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint32_t slot = slotOf[i];
+			entities[slot] = gathered[i].entity;
+			parentSlots[slot] = parentOf[i] == NO_SLOT ? NO_SLOT : slotOf[parentOf[i]];
+			localTransforms[slot] = gathered[i].local;
+			worldTransforms[slot] = gathered[i].world;
+			localBounds[slot] = gathered[i].localBounds;
+			worldBounds[slot] = gathered[i].worldBounds;
+			slotOfEntity[gathered[i].entity.index] = slot;
+		}
+
+		bvhEntities.clear();
+		for (uint32_t slot = 0; slot < count; ++slot) {
+			primitiveSlots[slot] = localBounds[slot] ? static_cast<uint32_t>(bvhEntities.size()) : NO_SLOT;
+			if (localBounds[slot]) {
+				bvhEntities.push_back(entities[slot]);
+			}
+		}
+		primitiveBounds.assign(bvhEntities.size(), S_Aabb{});
+		dirtyPrimitives.assign(bvhEntities.size(), 0);
+		dirty.assign(count, 1);
+	}
+
+	void S_TransformSystem::update() {
+		const auto start = std::chrono::steady_clock::now();
+		auto& jobs = core::jobs::S_JobSystem::getInstance();
+		stats.rebuiltHierarchy = false;
+		stats.rebuiltBvh = false;
+		stats.hierarchyMilliseconds = 0.0;
+
+		// Reparenting through a Parent write changes the levels as much as a structural change
+		world->collectChunks({ components.placed(), 0 }, chunks);
+		bool rebuild = world->getStructureVersion() > seenVersion;
+		for (size_t i = 0; i < chunks.size() && !rebuild; ++i) {
+			rebuild = chunks[i].hasChangedSince(components.parent, seenVersion);
+		}
+		if (rebuild) {
+			const auto hierarchyStart = std::chrono::steady_clock::now();
+			rebuildHierarchy();
+			stats.rebuiltHierarchy = true;
+			stats.hierarchyMilliseconds = millisecondsSince(hierarchyStart);
+		}
+		else {
+			jobs.parallelFor(0, chunks.size(), [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const core::ecs::S_ChunkView& chunk = chunks[i];
+					if (chunk.hasChangedSince(components.local, seenVersion) || chunk.hasChangedSince(components.localBounds, seenVersion)) {
+						for (const S_Entity& entity : chunk.getEntities()) {
+							dirty[slotOfEntity[entity.index]] = 1;
+						}
+					}
+				}
+			}, 16);
+		}
+
+		// Parents are final before their children's level starts
+		const auto propagateStart = std::chrono::steady_clock::now();
+		std::atomic<uint32_t> dirtyCount{ 0 };
+		std::atomic<uint32_t> dirtyBoundsCount{ 0 };
+		const uint32_t levelCount = levelOffsets.empty() ? 0 : static_cast<uint32_t>(levelOffsets.size() - 1);
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			jobs.parallelFor(levelOffsets[level], levelOffsets[level + 1], [&](size_t begin, size_t end) {
+				uint32_t transformed = 0;
+				uint32_t bounded = 0;
+				for (size_t slot = begin; slot < end; ++slot) {
+					const uint32_t parent = parentSlots[slot];
+					if (parent != NO_SLOT && dirty[parent]) {
+						dirty[slot] = 1;
+					}
+					if (!dirty[slot]) {
+						continue;
+					}
+					const S_Transform placed = parent == NO_SLOT ? *localTransforms[slot] : core::math::compose(*worldTransforms[parent], *localTransforms[slot]);
+					*worldTransforms[slot] = placed;
+					++transformed;
+
+					const uint32_t primitive = primitiveSlots[slot];
+					if (primitive != NO_SLOT) {
+						const S_Aabb box = placed.transformAabb(*localBounds[slot]);
+						*worldBounds[slot] = box;
+						primitiveBounds[primitive] = box;
+						dirtyPrimitives[primitive] = 1;
+						++bounded;
+					}
+				}
+				dirtyCount.fetch_add(transformed, std::memory_order_relaxed);
+				dirtyBoundsCount.fetch_add(bounded, std::memory_order_relaxed);
+			}, PROPAGATE_GRAIN);
+		}
+
+		// Results were written through cached pointers; stamp the chunks they landed in
+		jobs.parallelFor(0, chunks.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				const core::ecs::S_ChunkView& chunk = chunks[i];
+				const std::span<const S_Entity> chunkEntities = chunk.getEntities();
+				const bool changed = std::any_of(chunkEntities.begin(), chunkEntities.end(), [&](const S_Entity& entity) {
+					return dirty[slotOfEntity[entity.index]] != 0;
+				});
+				if (changed) {
+					static_cast<void>(chunk.write(components.world));
+					static_cast<void>(chunk.write(components.worldBounds));
+				}
+			}
+		}, 16);
+		stats.propagateMilliseconds = millisecondsSince(propagateStart);
+
+		const auto bvhStart = std::chrono::steady_clock::now();
+		if (rebuild) {
+			bvh.build(primitiveBounds, bvhSettings);
+			stats.rebuiltBvh = true;
+		}
+		else if (dirtyBoundsCount.load() > 0) {
+			bvh.refit(primitiveBounds, dirtyPrimitives);
+		}
+		stats.bvhMilliseconds = millisecondsSince(bvhStart);
+
+		std::fill(dirty.begin(), dirty.end(), uint8_t{ 0 });
+		std::fill(dirtyPrimitives.begin(), dirtyPrimitives.end(), uint8_t{ 0 });
+		seenVersion = world->advanceVersion();
+
+		stats.entityCount = static_cast<uint32_t>(entities.size());
+		stats.levelCount = levelCount;
+		stats.boundedCount = static_cast<uint32_t>(bvhEntities.size());
+		stats.dirtyCount = dirtyCount.load();
+		stats.dirtyBoundsCount = dirtyBoundsCount.load();
+		stats.updateMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "update", stats.updateMilliseconds);
+	}
+
+	const S_Bvh& S_TransformSystem::getBvh() const {
+		return bvh;
+	}
+
+	std::span<const S_Entity> S_TransformSystem::getBvhEntities() const {
+		return bvhEntities;
+	}
+
+	const S_TransformSystemStats& S_TransformSystem::getStats() const {
+		return stats;
+	}
+
+	void S_TransformSystem::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "updateMilliseconds", stats.updateMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "hierarchyMilliseconds", stats.hierarchyMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "propagateMilliseconds", stats.propagateMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "bvhMilliseconds", stats.bvhMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "entities", static_cast<double>(stats.entityCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "levels", static_cast<double>(stats.levelCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "bounded", static_cast<double>(stats.boundedCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "dirty", static_cast<double>(stats.dirtyCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "dirtyBounds", static_cast<double>(stats.dirtyBoundsCount));
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+// Interface between S_QuantizedMesh and the vertex packing kernels, one translation unit per
+// instruction set. Packed vertices cross it as six 32-bit words each; a null stream packs as
+// zero on encode and is skipped on decode. SIMD kernels take ranges that are a multiple of
+// their width and leave the remainder to the scalar kernel.
+namespace spectra::render::kernels {
+	constexpr uint32_t PACKED_VERTEX_WORDS = 6;
+
+	struct S_VertexEncodeInput {
+		const float* positions = nullptr;  // Three per vertex
+		const float* normals = nullptr;    // Three per vertex
+		const float* tangents = nullptr;   // Four per vertex
+		const float* uvs = nullptr;        // Two per vertex
+		const float* weights = nullptr;    // Four per vertex
+		const uint8_t* joints = nullptr;   // Four per vertex
+		float positionOffset[3] = {};
+		float positionInverseScale[3] = {};
+		float uvOffset[2] = {};
+		float uvInverseScale[2] = {};
+	};
+
+	struct S_VertexDecodeOutput {
+		float* positions = nullptr;
+		float* normals = nullptr;
+		float* tangents = nullptr;
+		float* uvs = nullptr;
+		float* weights = nullptr;
+		uint8_t* joints = nullptr;
+		float positionOffset[3] = {};
+		float positionScale[3] = {};
+		float uvOffset[2] = {};
+		float uvScale[2] = {};
+	};
+
+	using VertexEncodeKernel = void (*)(const S_VertexEncodeInput& input, uint32_t* packed, uint32_t begin, uint32_t end);
+	using VertexDecodeKernel = void (*)(const uint32_t* packed, const S_VertexDecodeOutput& output, uint32_t begin, uint32_t end);
+
+	void encodeVerticesScalar(const S_VertexEncodeInput& input, uint32_t* packed, uint32_t begin, uint32_t end);
+	void decodeVerticesScalar(const uint32_t* packed, const S_VertexDecodeOutput& output, uint32_t begin, uint32_t end);
+
+#if defined(SPECTRA_X86_KERNELS)
+	void encodeVerticesAvx2(const S_VertexEncodeInput& input, uint32_t* packed, uint32_t begin, uint32_t end);
+	void decodeVerticesAvx2(const uint32_t* packed, const S_VertexDecodeOutput& output, uint32_t begin, uint32_t end);
+#endif
+}
@@ -0,0 +1,239 @@
+// Vertex packing shared by the kernel translation units, included after the policy P is
+// defined. P supplies a Float and an Int of WIDTH lanes, a Mask from comparing Floats, strided
+// gathers and scatters, and the arithmetic below. Every step is an exactly rounded IEEE
+// operation in the same order for every policy, so all kernels produce the same bits.
+namespace spectra::render::kernels {
+	namespace {
+		constexpr float SNORM16_MAXIMUM = 32767.0f;
+		constexpr float SNORM15_MAXIMUM = 16383.0f;
+		constexpr float UNORM16_MAXIMUM = 65535.0f;
+		constexpr float WEIGHT_UNITS = 15.0f;
+
+		template<typename P>
+		typename P::Float signOf(typename P::Float value) {
+			return P::select(P::ge(value, P::set1(0.0f)), P::set1(1.0f), P::set1(-1.0f));
+		}
+
+		template<typename P>
+		typename P::Int quantizeUnorm16(typename P::Float value, float offset, float inverseScale) {
+			typename P::Float scaled = P::mul(P::sub(value, P::set1(offset)), P::set1(inverseScale));
+			scaled = P::min(P::max(scaled, P::set1(0.0f)), P::set1(UNORM16_MAXIMUM));
+			return P::toInt(P::round(scaled));
+		}
+
+		template<typename P>
+		typename P::Float dequantize(typename P::Int value, float offset, float scale) {
+			return P::add(P::set1(offset), P::mul(P::toFloat(value), P::set1(scale)));
+		}
+
+		// Projects onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the
+		// diagonals. The coordinates come back as signed integers in [-maximum, maximum]; a zero
+		// vector encodes as +z.
+		template<typename P>
+		void encodeOctahedral(typename P::Float x, typename P::Float y, typename P::Float z, float maximum, typename P::Int& u, typename P::Int& v) {
+			using Float = typename P::Float;
+			const Float one = P::set1(1.0f);
+			const Float sum = P::add(P::add(P::abs(x), P::abs(y)), P::abs(z));
+			const Float inverse = P::select(P::lt(P::set1(0.0f), sum), P::div(one, sum), P::set1(0.0f));
+			Float ou = P::mul(x, inverse);
+			Float ov = P::mul(y, inverse);
+			const auto lower = P::lt(z, P::set1(0.0f));
+			const Float foldedU = P::mul(P::sub(one, P::abs(ov)), signOf<P>(ou));
+			const Float foldedV = P::mul(P::sub(one, P::abs(ou)), signOf<P>(ov));
+			ou = P::min(P::max(P::select(lower, foldedU, ou), P::set1(-1.0f)), one);
+			ov = P::min(P::max(P::select(lower, foldedV, ov), P::set1(-1.0f)), one);
+			u = P::toInt(P::round(P::mul(ou, P::set1(maximum))));
+			v = P::toInt(P::round(P::mul(ov, P::set1(maximum))));
+		}
+
+		template<typename P>
+		void decodeOctahedral(typename P::Int u, typename P::Int v, float maximum, typename P::Float& x, typename P::Float& y, typename P::Float& z) {
+			using Float = typename P::Float;
+			const Float one = P::set1(1.0f);
+			Float ou = P::max(P::mul(P::toFloat(u), P::set1(1.0f / maximum)), P::set1(-1.0f));
+			Float ov = P::max(P::mul(P::toFloat(v), P::set1(1.0f / maximum)), P::set1(-1.0f));
+			const Float oz = P::sub(P::sub(one, P::abs(ou)), P::abs(ov));
+			const auto lower = P::lt(oz, P::set1(0.0f));
+			const Float foldedU = P::mul(P::sub(one, P::abs(ov)), signOf<P>(ou));
+			const Float foldedV = P::mul(P::sub(one, P::abs(ou)), signOf<P>(ov));
+			ou = P::select(lower, foldedU, ou);
+			ov = P::select(lower, foldedV, ov);
+			const Float inverseLength = P::div(one, P::sqrt(P::add(P::add(P::mul(ou, ou), P::mul(ov, ov)), P::mul(oz, oz))));
+			x = P::mul(ou, inverseLength);
+			y = P::mul(ov, inverseLength);
+			z = P::mul(oz, inverseLength);
+		}
+
+		// Weights normalized to sum to 15 units, rounded down, with the units lost to rounding
+		// going to the lanes with the largest remainders. Each lane is within one unit of its
+		// exact share and the lanes always sum to 15, or to 0 when every weight is 0.
+		template<typename P>
+		typename P::Int encodeWeights(const float* weights) {
+			using Float = typename P::Float;
+			const Float zero = P::set1(0.0f);
+			const Float one = P::set1(1.0f);
+			Float scaled[4];
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				scaled[lane] = P::max(P::gather(weights + lane, 4), zero);
+			}
+			const Float sum = P::add(P::add(P::add(scaled[0], scaled[1]), scaled[2]), scaled[3]);
+			const auto any = P::lt(zero, sum);
+			const Float scale = P::select(any, P::div(P::set1(WEIGHT_UNITS), sum), zero);
+
+			Float floors[4];
+			Float remainders[4];
+			Float deficit = P::set1(WEIGHT_UNITS);
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				scaled[lane] = P::mul(scaled[lane], scale);
+				floors[lane] = P::floor(scaled[lane]);
+				remainders[lane] = P::sub(scaled[lane], floors[lane]);
+				deficit = P::sub(deficit, floors[lane]);
+			}
+			deficit = P::select(any, deficit, zero);
+
+			typename P::Int packed = P::setInt(0);
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				// Lanes ahead in the order of largest remainder first, earlier lane on ties
+				Float rank = zero;
+				for (uint32_t other = 0; other < 4; ++other) {
+					if (other != lane) {
+						const auto ahead = other < lane ? P::ge(remainders[other], remainders[lane]) : P::lt(remainders[lane], remainders[other]);
+						rank = P::add(rank, P::select(ahead, one, zero));
+					}
+				}
+				const Float units = P::min(P::add(floors[lane], P::select(P::lt(rank, deficit), one, zero)), P::set1(WEIGHT_UNITS));
+				packed = P::orInt(packed, P::shiftLeft(P::toInt(units), lane * 4));
+			}
+			return packed;
+		}
+
+		template<typename P>
+		void encodeVertices(const S_VertexEncodeInput& input, uint32_t* packed, uint32_t begin, uint32_t end) {
+			using Float = typename P::Float;
+			using Int = typename P::Int;
+			const Int low16 = P::setInt(0xFFFF);
+			const Int low15 = P::setInt(0x7FFF);
+
+			for (uint32_t first = begin; first < end; first += P::WIDTH) {
+				uint32_t* words = packed + size_t(first) * PACKED_VERTEX_WORDS;
+				Int word0 = P::setInt(0);
+				Int word1 = P::setInt(0);
+				Int word2 = P::setInt(0);
+				Int word3 = P::setInt(0);
+				Int word4 = P::setInt(0);
+
+				if (input.positions) {
+					const float* source = input.positions + size_t(first) * 3;
+					const Int x = quantizeUnorm16<P>(P::gather(source, 3), input.positionOffset[0], input.positionInverseScale[0]);
+					const Int y = quantizeUnorm16<P>(P::gather(source + 1, 3), input.positionOffset[1], input.positionInverseScale[1]);
+					word0 = P::orInt(x, P::shiftLeft(y, 16));
+					word1 = quantizeUnorm16<P>(P::gather(source + 2, 3), input.positionOffset[2], input.positionInverseScale[2]);
+				}
+				if (input.weights) {
+					word1 = P::orInt(word1, P::shiftLeft(encodeWeights<P>(input.weights + size_t(first) * 4), 16));
+				}
+				if (input.normals) {
+					const float* source = input.normals + size_t(first) * 3;
+					Int u;
+					Int v;
+					encodeOctahedral<P>(P::gather(source, 3), P::gather(source + 1, 3), P::gather(source + 2, 3), SNORM16_MAXIMUM, u, v);
+					word2 = P::orInt(P::andInt(u, low16), P::shiftLeft(v, 16));
+				}
+				if (input.tangents) {
+					const float* source = input.tangents + size_t(first) * 4;
+					Int u;
+					Int v;
+					encodeOctahedral<P>(P::gather(source, 4), P::gather(source + 1, 4), P::gather(source + 2, 4), SNORM15_MAXIMUM, u, v);
+					const Float negative = P::select(P::lt(P::gather(source + 3, 4), P::set1(0.0f)), P::set1(1.0f), P::set1(0.0f));
+					word3 = P::orInt(P::orInt(P::andInt(u, low15), P::shiftLeft(P::andInt(v, low15), 15)), P::shiftLeft(P::toInt(negative), 31));
+				}
+				if (input.uvs) {
+					const float* source = input.uvs + size_t(first) * 2;
+					const Int u = quantizeUnorm16<P>(P::gather(source, 2), input.uvOffset[0], input.uvInverseScale[0]);
+					const Int v = quantizeUnorm16<P>(P::gather(source + 1, 2), input.uvOffset[1], input.uvInverseScale[1]);
+					word4 = P::orInt(u, P::shiftLeft(v, 16));
+				}
+
+				P::scatterInt(words, PACKED_VERTEX_WORDS, word0);
+				P::scatterInt(words + 1, PACKED_VERTEX_WORDS, word1);
+				P::scatterInt(words + 2, PACKED_VERTEX_WORDS, word2);
+				P::scatterInt(words + 3, PACKED_VERTEX_WORDS, word3);
+				P::scatterInt(words + 4, PACKED_VERTEX_WORDS, word4);
+				for (uint32_t lane = 0; lane < P::WIDTH; ++lane) {
+					const uint8_t* joints = input.joints ? input.joints + size_t(first + lane) * 4 : nullptr;
+					words[lane * PACKED_VERTEX_WORDS + 5] = joints
+						? uint32_t(joints[0]) | uint32_t(joints[1]) << 8 | uint32_t(joints[2]) << 16 | uint32_t(joints[3]) << 24 : 0;
+				}
+			}
+		}
+
+		template<typename P>
+		void decodeVertices(const uint32_t* packed, const S_VertexDecodeOutput& output, uint32_t begin, uint32_t end) {
+			using Float = typename P::Float;
+			using Int = typename P::Int;
+			const Int low16 = P::setInt(0xFFFF);
+
+			for (uint32_t first = begin; first < end; first += P::WIDTH) {
+				const uint32_t* words = packed + size_t(first) * PACKED_VERTEX_WORDS;
+
+				if (output.positions) {
+					const Int word0 = P::gatherInt(words, PACKED_VERTEX_WORDS);
+					const Int word1 = P::gatherInt(words + 1, PACKED_VERTEX_WORDS);
+					float* destination = output.positions + size_t(first) * 3;
+					P::scatter(destination, 3, dequantize<P>(P::andInt(word0, low16), output.positionOffset[0], output.positionScale[0]));
+					P::scatter(destination + 1, 3, dequantize<P>(P::shiftRightLogical(word0, 16), output.positionOffset[1], output.positionScale[1]));
+					P::scatter(destination + 2, 3, dequantize<P>(P::andInt(word1, low16), output.positionOffset[2], output.positionScale[2]));
+				}
+				if (output.weights) {
+					const Int word1 = P::gatherInt(words + 1, PACKED_VERTEX_WORDS);
+					float* destination = output.weights + size_t(first) * 4;
+					for (uint32_t lane = 0; lane < 4; ++lane) {
+						const Int units = P::andInt(P::shiftRightLogical(word1, 16 + lane * 4), P::setInt(0xF));
+						P::scatter(destination + lane, 4, P::mul(P::toFloat(units), P::set1(1.0f / WEIGHT_UNITS)));
+					}
+				}
+				if (output.normals) {
+					const Int word2 = P::gatherInt(words + 2, PACKED_VERTEX_WORDS);
+					Float x;
+					Float y;
+					Float z;
+					decodeOctahedral<P>(P::shiftRightArithmetic(P::shiftLeft(word2, 16), 16), P::shiftRightArithmetic(word2, 16), SNORM16_MAXIMUM, x, y, z);
+					float* destination = output.normals + size_t(first) * 3;
+					P::scatter(destination, 3, x);
+					P::scatter(destination + 1, 3, y);
+					P::scatter(destination + 2, 3, z);
+				}
+				if (output.tangents) {
+					const Int word3 = P::gatherInt(words + 3, PACKED_VERTEX_WORDS);
+					Float x;
+					Float y;
+					Float z;
+					decodeOctahedral<P>(P::shiftRightArithmetic(P::shiftLeft(word3, 17), 17), P::shiftRightArithmetic(P::shiftLeft(word3, 2), 17),
+						SNORM15_MAXIMUM, x, y, z);
+					// The sign bit shifted down is -1 for negative handedness and 0 otherwise
+					const Float handedness = P::add(P::set1(1.0f), P::mul(P::set1(2.0f), P::toFloat(P::shiftRightArithmetic(word3, 31))));
+					float* destination = output.tangents + size_t(first) * 4;
+					P::scatter(destination, 4, x);
+					P::scatter(destination + 1, 4, y);
+					P::scatter(destination + 2, 4, z);
+					P::scatter(destination + 3, 4, handedness);
+				}
+				if (output.uvs) {
+					const Int word4 = P::gatherInt(words + 4, PACKED_VERTEX_WORDS);
+					float* destination = output.uvs + size_t(first) * 2;
+					P::scatter(destination, 2, dequantize<P>(P::andInt(word4, low16), output.uvOffset[0], output.uvScale[0]));
+					P::scatter(destination + 1, 2, dequantize<P>(P::shiftRightLogical(word4, 16), output.uvOffset[1], output.uvScale[1]));
+				}
+				if (output.joints) {
+					for (uint32_t lane = 0; lane < P::WIDTH; ++lane) {
+						const uint32_t word5 = words[lane * PACKED_VERTEX_WORDS + 5];
+						uint8_t* destination = output.joints + size_t(first + lane) * 4;
+						for (uint32_t joint = 0; joint < 4; ++joint) {
+							destination[joint] = static_cast<uint8_t>(word5 >> (joint * 8));
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#include "S_VertexKernels.h"
+
+#include <immintrin.h>
+
+// Compiled with AVX2 and FMA enabled, only called after S_CpuFeatures reports both. Eight
+// vertices per step, fields gathered from the interleaved streams.
+namespace spectra::render::kernels {
+	namespace {
+		struct S_Avx2 {
+			static constexpr uint32_t WIDTH = 8;
+			using Float = __m256;
+			using Int = __m256i;
+			using Mask = __m256;
+
+			static __m256i laneOffsets(uint32_t stride) {
+				return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(stride)));
+			}
+
+			static Float set1(float value) { return _mm256_set1_ps(value); }
+			static Int setInt(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+			static Float gather(const float* base, uint32_t stride) { return _mm256_i32gather_ps(base, laneOffsets(stride), 4); }
+			static Int gatherInt(const uint32_t* base, uint32_t stride) {
+				return _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), laneOffsets(stride), 4);
+			}
+			static void scatter(float* base, uint32_t stride, Float value) {
+				alignas(32) float lanes[WIDTH];
+				_mm256_store_ps(lanes, value);
+				for (uint32_t i = 0; i < WIDTH; ++i) {
+					base[i * stride] = lanes[i];
+				}
+			}
+			static void scatterInt(uint32_t* base, uint32_t stride, Int value) {
+				alignas(32) uint32_t lanes[WIDTH];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), value);
+				for (uint32_t i = 0; i < WIDTH; ++i) {
+					base[i * stride] = lanes[i];
+				}
+			}
+
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+			static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+			static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+			static Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+			static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+			static Float floor(Float a) { return _mm256_floor_ps(a); }
+			static Float round(Float a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+			static Mask lt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static Mask ge(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+			static Float select(Mask mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+
+			static Int toInt(Float a) { return _mm256_cvttps_epi32(a); }
+			static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+
+			static Int andInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+			static Int orInt(Int a, Int b) { return _mm256_or_si256(a, b); }
+			static Int shiftLeft(Int a, uint32_t count) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(static_cast<int>(count))); }
+			static Int shiftRightLogical(Int a, uint32_t count) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(static_cast<int>(count))); }
+			static Int shiftRightArithmetic(Int a, uint32_t count) { return _mm256_sra_epi32(a, _mm_cvtsi32_si128(static_cast<int>(count))); }
+		};
+	}
+}
+
+#include "S_VertexKernels.inl"
+
+namespace spectra::render::kernels {
+	void encodeVerticesAvx2(const S_VertexEncodeInput& input, uint32_t* packed, uint32_t begin, uint32_t end) {
+		encodeVertices<S_Avx2>(input, packed, begin, end);
+	}
+
+	void decodeVerticesAvx2(const uint32_t* packed, const S_VertexDecodeOutput& output, uint32_t begin, uint32_t end) {
+		decodeVertices<S_Avx2>(packed, output, begin, end);
+	}
+}
@@ -0,0 +1,61 @@
+#include "S_VertexKernels.h"
+
+#include <cmath>
+#include <cstring>
+
+// Baseline kernel, one vertex per step; also packs the vertices left over by the SIMD kernels
+namespace spectra::render::kernels {
+	namespace {
+		struct S_Scalar {
+			static constexpr uint32_t WIDTH = 1;
+			using Float = float;
+			using Int = uint32_t;
+			using Mask = bool;
+
+			static Float set1(float value) { return value; }
+			static Int setInt(uint32_t value) { return value; }
+			static Float gather(const float* base, uint32_t) { return *base; }
+			static Int gatherInt(const uint32_t* base, uint32_t) { return *base; }
+			static void scatter(float* base, uint32_t, Float value) { *base = value; }
+			static void scatterInt(uint32_t* base, uint32_t, Int value) { *base = value; }
+
+			static Float add(Float a, Float b) { return a + b; }
+			static Float sub(Float a, Float b) { return a - b; }
+			static Float mul(Float a, Float b) { return a * b; }
+			static Float div(Float a, Float b) { return a / b; }
+			// Second operand on ties and NaN, as minps and maxps do
+			static Float min(Float a, Float b) { return a < b ? a : b; }
+			static Float max(Float a, Float b) { return a > b ? a : b; }
+			static Float abs(Float a) { return std::fabs(a); }
+			static Float sqrt(Float a) { return std::sqrt(a); }
+			static Float floor(Float a) { return std::floor(a); }
+			static Float round(Float a) { return std::nearbyint(a); }  // To nearest even, like the SIMD conversions
+
+			static Mask lt(Float a, Float b) { return a < b; }
+			static Mask ge(Float a, Float b) { return a >= b; }
+			static Float select(Mask mask, Float a, Float b) { return mask ? a : b; }
+
+			// Whole floats to and from signed 32-bit lanes
+			static Int toInt(Float a) { return static_cast<uint32_t>(static_cast<int32_t>(a)); }
+			static Float toFloat(Int a) { return static_cast<float>(static_cast<int32_t>(a)); }
+
+			static Int andInt(Int a, Int b) { return a & b; }
+			static Int orInt(Int a, Int b) { return a | b; }
+			static Int shiftLeft(Int a, uint32_t count) { return a << count; }
+			static Int shiftRightLogical(Int a, uint32_t count) { return a >> count; }
+			static Int shiftRightArithmetic(Int a, uint32_t count) { return static_cast<uint32_t>(static_cast<int32_t>(a) >> count); }
+		};
+	}
+}
+
+#include "S_VertexKernels.inl"
+
+namespace spectra::render::kernels {
+	void encodeVerticesScalar(const S_VertexEncodeInput& input, uint32_t* packed, uint32_t begin, uint32_t end) {
+		encodeVertices<S_Scalar>(input, packed, begin, end);
+	}
+
+	void decodeVerticesScalar(const uint32_t* packed, const S_VertexDecodeOutput& output, uint32_t begin, uint32_t end) {
+		decodeVertices<S_Scalar>(packed, output, begin, end);
+	}
+}
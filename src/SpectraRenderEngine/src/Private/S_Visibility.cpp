@@ -0,0 +1,523 @@
+#include "S_Visibility.h"
+#include "S_CullingKernels.h"
+#include "S_JobSystem.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace spectra::render {
+	using core::math::S_Aabb;
+	using core::math::S_Vec3;
+
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::render::visibility";
+
+		// Bounds per frustum job, a multiple of every kernel width
+		constexpr uint32_t CULL_BLOCK = 4096;
+		constexpr uint32_t SIMD_WIDTH = 8;
+
+		// Occluder triangles set up per job, and tile rows per rasterization band
+		constexpr size_t SETUP_GRAIN = 512;
+		constexpr uint32_t BAND_ROWS = 2;
+
+		// Candidates tested per occlusion job
+		constexpr size_t TEST_GRAIN = 1024;
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		E_SimdLevel resolveLevel(E_SimdLevel level) {
+			const E_SimdLevel best = S_RayStream::getBestSimdLevel();
+			if (level == E_SimdLevel::BEST || static_cast<uint8_t>(level) > static_cast<uint8_t>(best)) {
+				level = best;
+			}
+			return level;
+		}
+
+		struct S_ClipVertex {
+			float x;
+			float y;
+			float z;
+			float w;
+		};
+
+		S_ClipVertex toClip(const S_CullingView& view, const S_Vec3& point) {
+			float out[4];
+			for (int row = 0; row < 4; ++row) {
+				out[row] = view.clip[row][0] * point.x + view.clip[row][1] * point.y + view.clip[row][2] * point.z + view.clip[row][3];
+			}
+			return { out[0], out[1], out[2], out[3] };
+		}
+
+		S_ClipVertex lerp(const S_ClipVertex& a, const S_ClipVertex& b, float t) {
+			return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+		}
+
+		// Sutherland-Hodgman against the near plane, clip z >= 0. Returns up to four vertices.
+		uint32_t clipNear(const S_ClipVertex (&triangle)[3], S_ClipVertex (&polygon)[4]) {
+			uint32_t count = 0;
+			for (uint32_t i = 0; i < 3; ++i) {
+				const S_ClipVertex& current = triangle[i];
+				const S_ClipVertex& next = triangle[(i + 1) % 3];
+				const bool currentInside = current.z >= 0.0f;
+				const bool nextInside = next.z >= 0.0f;
+				if (currentInside) {
+					polygon[count++] = current;
+				}
+				if (currentInside != nextInside) {
+					polygon[count++] = lerp(current, next, current.z / (current.z - next.z));
+				}
+			}
+			return count;
+		}
+
+		// Projects a near-clipped triangle to pixels and fills in its edge functions, depth plane
+		// and tile range. False for triangles that cover no area or lie off screen.
+		bool setupTriangle(const S_ClipVertex& a, const S_ClipVertex& b, const S_ClipVertex& c, float width, float height,
+			uint32_t tilesPerRow, uint32_t tileRows, kernels::S_RasterTriangle& triangle) {
+			const S_ClipVertex* vertices[3] = { &a, &b, &c };
+			float x[3], y[3], z[3];
+			for (int i = 0; i < 3; ++i) {
+				const float inverseW = 1.0f / vertices[i]->w;
+				x[i] = (vertices[i]->x * inverseW * 0.5f + 0.5f) * width;
+				y[i] = (0.5f - vertices[i]->y * inverseW * 0.5f) * height;
+				z[i] = vertices[i]->z * inverseW;
+			}
+
+			float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+			if (!(area != 0.0f) || !std::isfinite(area)) {
+				return false;
+			}
+			// Occluders hide from both sides, so back faces are turned around instead of culled
+			if (area < 0.0f) {
+				std::swap(x[1], x[2]);
+				std::swap(y[1], y[2]);
+				std::swap(z[1], z[2]);
+				area = -area;
+			}
+
+			const float minX = std::min({ x[0], x[1], x[2] });
+			const float maxX = std::max({ x[0], x[1], x[2] });
+			const float minY = std::min({ y[0], y[1], y[2] });
+			const float maxY = std::max({ y[0], y[1], y[2] });
+			if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) {
+				return false;
+			}
+
+			for (int i = 0; i < 3; ++i) {
+				const int j = (i + 1) % 3;
+				triangle.edges[i][0] = -(y[j] - y[i]);
+				triangle.edges[i][1] = x[j] - x[i];
+				triangle.edges[i][2] = (y[j] - y[i]) * x[i] - (x[j] - x[i]) * y[i];
+			}
+			const float depthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+			const float depthY = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+			triangle.depth[0] = depthX;
+			triangle.depth[1] = depthY;
+			triangle.depth[2] = z[0] - depthX * x[0] - depthY * y[0];
+			triangle.zMin = std::min({ z[0], z[1], z[2] });
+			triangle.zMax = std::max({ z[0], z[1], z[2] });
+
+			triangle.tileMinX = static_cast<uint32_t>(std::max(minX, 0.0f)) / S_OcclusionBuffer::TILE_WIDTH;
+			triangle.tileMinY = static_cast<uint32_t>(std::max(minY, 0.0f)) / S_OcclusionBuffer::TILE_HEIGHT;
+			triangle.tileMaxX = std::min(static_cast<uint32_t>(std::min(maxX, width - 1.0f)) / S_OcclusionBuffer::TILE_WIDTH, tilesPerRow - 1);
+			triangle.tileMaxY = std::min(static_cast<uint32_t>(std::min(maxY, height - 1.0f)) / S_OcclusionBuffer::TILE_HEIGHT, tileRows - 1);
+			return true;
+		}
+
+		kernels::S_CullingPlanes toKernelPlanes(const S_CullingView& view) {
+			kernels::S_CullingPlanes planes;
+			for (uint32_t plane = 0; plane < 6; ++plane) {
+				planes.a[plane] = view.planes[plane][0];
+				planes.b[plane] = view.planes[plane][1];
+				planes.c[plane] = view.planes[plane][2];
+				planes.d[plane] = view.planes[plane][3];
+			}
+			return planes;
+		}
+
+		// Culls fixed blocks in parallel, each writing its survivors at the start of its own
+		// range of visible, then closes the gaps in block order
+		template<typename Columns, typename Kernel>
+		void cullBlocks(const Columns& columns, const kernels::S_CullingPlanes& planes, uint32_t count, Kernel simdKernel, Kernel scalarKernel,
+			std::vector<uint32_t>& visible) {
+			visible.resize(count);
+			const uint32_t blockCount = (count + CULL_BLOCK - 1) / CULL_BLOCK;
+			std::vector<uint32_t> blockCounts(blockCount, 0);
+			uint32_t* output = visible.data();
+			core::jobs::S_JobSystem::getInstance().parallelFor(0, blockCount, [&](size_t first, size_t last) {
+				for (size_t block = first; block < last; ++block) {
+					const uint32_t begin = static_cast<uint32_t>(block) * CULL_BLOCK;
+					const uint32_t end = std::min(begin + CULL_BLOCK, count);
+					const uint32_t split = simdKernel ? begin + (end - begin) / SIMD_WIDTH * SIMD_WIDTH : begin;
+					uint32_t written = 0;
+					if (split > begin) {
+						written += simdKernel(columns, planes, begin, split, output + begin);
+					}
+					written += scalarKernel(columns, planes, split, end, output + begin + written);
+					blockCounts[block] = written;
+				}
+			}, 1);
+
+			uint32_t total = 0;
+			for (uint32_t block = 0; block < blockCount; ++block) {
+				const uint32_t* source = output + size_t(block) * CULL_BLOCK;
+				std::copy(source, source + blockCounts[block], output + total);
+				total += blockCounts[block];
+			}
+			visible.resize(total);
+		}
+	}
+
+	struct S_OcclusionScratch {
+		std::vector<S_ClipVertex> clipVertices;
+		std::vector<kernels::S_RasterTriangle> slots;
+		std::vector<uint8_t> used;
+		std::vector<std::vector<uint32_t>> bandTriangles;
+	};
+
+	// S_CullingView implementations
+	S_CullingView S_CullingView::perspective(const S_Vec3& position, const S_Vec3& target, const S_Vec3& up, float verticalFovDegrees,
+		float aspectRatio, float nearPlane, float farPlane) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (!(nearPlane > 0.0f) || !(farPlane > nearPlane) || !(verticalFovDegrees > 0.0f && verticalFovDegrees < 180.0f) || !(aspectRatio > 0.0f)) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_CullingView", "perspective", "Needs 0 < near < far, a field of view in (0, 180) and a positive aspect ratio",
+				nearPlane, farPlane, verticalFovDegrees, aspectRatio);
+		}
+
+		const S_Vec3 forward = core::math::normalize(target - position);
+		const S_Vec3 right = core::math::normalize(core::math::cross(forward, up));
+		const S_Vec3 trueUp = core::math::cross(right, forward);
+		const float scaleY = 1.0f / std::tan(verticalFovDegrees * std::numbers::pi_v<float> / 360.0f);
+		const float scaleX = scaleY / aspectRatio;
+		const float depthScale = farPlane / (farPlane - nearPlane);
+
+		S_CullingView view;
+		const S_Vec3 axes[4] = { right * scaleX, trueUp * scaleY, forward * depthScale, forward };
+		const float offsets[4] = { -core::math::dot(right, position) * scaleX, -core::math::dot(trueUp, position) * scaleY,
+			(-core::math::dot(forward, position) - nearPlane) * depthScale, -core::math::dot(forward, position) };
+		for (int row = 0; row < 4; ++row) {
+			view.clip[row][0] = axes[row].x;
+			view.clip[row][1] = axes[row].y;
+			view.clip[row][2] = axes[row].z;
+			view.clip[row][3] = offsets[row];
+		}
+
+		// Gribb-Hartmann: each plane is a sum or difference of the w row and another row
+		const int rows[6] = { 0, 0, 1, 1, 2, 2 };
+		const float signs[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+		for (int plane = 0; plane < 6; ++plane) {
+			float coefficients[4];
+			for (int column = 0; column < 4; ++column) {
+				const float other = signs[plane] * view.clip[rows[plane]][column];
+				// The near plane is the depth row alone, as clip depth starts at zero
+				coefficients[column] = plane == 4 ? other : view.clip[3][column] + other;
+			}
+			const float inverseLength = 1.0f / std::sqrt(coefficients[0] * coefficients[0] + coefficients[1] * coefficients[1]
+				+ coefficients[2] * coefficients[2]);
+			for (int column = 0; column < 4; ++column) {
+				view.planes[plane][column] = coefficients[column] * inverseLength;
+			}
+		}
+
+		view.position = position;
+		view.nearPlane = nearPlane;
+		view.farPlane = farPlane;
+		return view;
+	}
+
+	// S_CullingBoxes implementations
+	void S_CullingBoxes::push(const S_Aabb& box) {
+		minX.push_back(box.min.x);
+		minY.push_back(box.min.y);
+		minZ.push_back(box.min.z);
+		maxX.push_back(box.max.x);
+		maxY.push_back(box.max.y);
+		maxZ.push_back(box.max.z);
+	}
+
+	void S_CullingBoxes::clear() {
+		minX.clear();
+		minY.clear();
+		minZ.clear();
+		maxX.clear();
+		maxY.clear();
+		maxZ.clear();
+	}
+
+	size_t S_CullingBoxes::size() const {
+		return minX.size();
+	}
+
+	S_Aabb S_CullingBoxes::get(size_t index) const {
+		return { S_Vec3(minX[index], minY[index], minZ[index]), S_Vec3(maxX[index], maxY[index], maxZ[index]) };
+	}
+
+	// S_CullingSpheres implementations
+	void S_CullingSpheres::push(const S_Vec3& center, float sphereRadius) {
+		x.push_back(center.x);
+		y.push_back(center.y);
+		z.push_back(center.z);
+		radius.push_back(sphereRadius);
+	}
+
+	void S_CullingSpheres::clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	size_t S_CullingSpheres::size() const {
+		return x.size();
+	}
+
+	// S_FrustumCuller implementations
+	void S_FrustumCuller::cullBoxes(const S_CullingView& view, const S_CullingBoxes& boxes, std::vector<uint32_t>& visible, E_SimdLevel level) {
+		const auto start = std::chrono::steady_clock::now();
+		kernels::S_BoxColumns columns;
+		columns.minX = boxes.minX.data();
+		columns.minY = boxes.minY.data();
+		columns.minZ = boxes.minZ.data();
+		columns.maxX = boxes.maxX.data();
+		columns.maxY = boxes.maxY.data();
+		columns.maxZ = boxes.maxZ.data();
+
+		kernels::CullBoxesKernel kernel = nullptr;
+#if defined(SPECTRA_X86_KERNELS)
+		if (resolveLevel(level) != E_SimdLevel::SCALAR) {
+			kernel = kernels::cullBoxesAvx2;
+		}
+#endif
+		cullBlocks(columns, toKernelPlanes(view), static_cast<uint32_t>(boxes.size()), kernel, &kernels::cullBoxesScalar, visible);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "frustumBoxes", millisecondsSince(start));
+	}
+
+	void S_FrustumCuller::cullSpheres(const S_CullingView& view, const S_CullingSpheres& spheres, std::vector<uint32_t>& visible, E_SimdLevel level) {
+		const auto start = std::chrono::steady_clock::now();
+		kernels::S_SphereColumns columns;
+		columns.x = spheres.x.data();
+		columns.y = spheres.y.data();
+		columns.z = spheres.z.data();
+		columns.radius = spheres.radius.data();
+
+		kernels::CullSpheresKernel kernel = nullptr;
+#if defined(SPECTRA_X86_KERNELS)
+		if (resolveLevel(level) != E_SimdLevel::SCALAR) {
+			kernel = kernels::cullSpheresAvx2;
+		}
+#endif
+		cullBlocks(columns, toKernelPlanes(view), static_cast<uint32_t>(spheres.size()), kernel, &kernels::cullSpheresScalar, visible);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "frustumSpheres", millisecondsSince(start));
+	}
+
+	// S_OcclusionBuffer implementations
+	S_OcclusionBuffer::S_OcclusionBuffer(const S_OcclusionSettings& settings) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (settings.width == 0 || settings.height == 0) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_OcclusionBuffer", "S_OcclusionBuffer", "Buffer needs a size", settings.width, settings.height);
+		}
+		tilesPerRow = (settings.width + TILE_WIDTH - 1) / TILE_WIDTH;
+		tileRows = (settings.height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+		tiles.resize(size_t(tilesPerRow) * tileRows);
+		scratch = std::make_unique<S_OcclusionScratch>();
+		scratch->bandTriangles.resize((tileRows + BAND_ROWS - 1) / BAND_ROWS);
+	}
+
+	S_OcclusionBuffer::~S_OcclusionBuffer() = default;
+
+	void S_OcclusionBuffer::begin(const S_CullingView& cullingView) {
+		view = cullingView;
+		std::fill(tiles.begin(), tiles.end(), S_OcclusionTile{});
+		stats = {};
+	}
+
+	void S_OcclusionBuffer::renderOccluders(std::span<const S_Vec3> positions, std::span<const uint32_t> indices, E_SimdLevel level) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (indices.size() % 3 != 0) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_OcclusionBuffer", "renderOccluders", "Index count is not a multiple of three",
+				static_cast<uint64_t>(indices.size()));
+		}
+		if (!indices.empty() && *std::max_element(indices.begin(), indices.end()) >= positions.size()) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_OcclusionBuffer", "renderOccluders", "Index out of range",
+				static_cast<uint64_t>(positions.size()));
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		auto& jobs = core::jobs::S_JobSystem::getInstance();
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		const float width = static_cast<float>(getWidth());
+		const float height = static_cast<float>(getHeight());
+
+		std::vector<S_ClipVertex>& clipVertices = scratch->clipVertices;
+		clipVertices.resize(positions.size());
+		jobs.parallelFor(0, positions.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				clipVertices[i] = toClip(view, positions[i]);
+			}
+		}, SETUP_GRAIN * 4);
+
+		// Clipping leaves at most two triangles per occluder, set up into fixed slots
+		std::vector<kernels::S_RasterTriangle>& slots = scratch->slots;
+		std::vector<uint8_t>& used = scratch->used;
+		slots.resize(size_t(triangleCount) * 2);
+		used.assign(slots.size(), 0);
+		jobs.parallelFor(0, triangleCount, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				const S_ClipVertex triangle[3] = { clipVertices[indices[i * 3]], clipVertices[indices[i * 3 + 1]], clipVertices[indices[i * 3 + 2]] };
+				S_ClipVertex polygon[4];
+				const uint32_t vertexCount = clipNear(triangle, polygon);
+				for (uint32_t fan = 0; fan + 2 < vertexCount; ++fan) {
+					used[i * 2 + fan] = setupTriangle(polygon[0], polygon[fan + 1], polygon[fan + 2], width, height, tilesPerRow, tileRows,
+						slots[i * 2 + fan]) ? 1 : 0;
+				}
+			}
+		}, SETUP_GRAIN);
+
+		kernels::RasterizeKernel rasterize = kernels::rasterizeOccludersScalar;
+#if defined(SPECTRA_X86_KERNELS)
+		if (resolveLevel(level) != E_SimdLevel::SCALAR) {
+			rasterize = kernels::rasterizeOccludersAvx2;
+		}
+#endif
+		// Binned in slot order, which is submission order; bands own disjoint tile rows, so they
+		// rasterize without synchronization
+		uint32_t rasterizedCount = 0;
+		for (std::vector<uint32_t>& ids : scratch->bandTriangles) {
+			ids.clear();
+		}
+		for (uint32_t slot = 0; slot < used.size(); ++slot) {
+			if (used[slot]) {
+				++rasterizedCount;
+				for (uint32_t band = slots[slot].tileMinY / BAND_ROWS; band <= slots[slot].tileMaxY / BAND_ROWS; ++band) {
+					scratch->bandTriangles[band].push_back(slot);
+				}
+			}
+		}
+		jobs.parallelFor(0, scratch->bandTriangles.size(), [&](size_t first, size_t last) {
+			for (size_t band = first; band < last; ++band) {
+				const std::vector<uint32_t>& ids = scratch->bandTriangles[band];
+				const uint32_t rowBegin = static_cast<uint32_t>(band) * BAND_ROWS;
+				const uint32_t rowEnd = std::min(rowBegin + BAND_ROWS, tileRows);
+				rasterize(slots.data(), ids.data(), static_cast<uint32_t>(ids.size()), tiles.data(), tilesPerRow, rowBegin, rowEnd);
+			}
+		}, 1);
+
+		stats.occluderTriangles += triangleCount;
+		stats.rasterizedTriangles += rasterizedCount;
+		const double milliseconds = millisecondsSince(start);
+		stats.rasterMilliseconds += milliseconds;
+		Instrumentation::recordTiming(STATS_CATEGORY, "rasterize", milliseconds);
+	}
+
+	bool S_OcclusionBuffer::isVisible(const S_Aabb& box) const {
+		const float width = static_cast<float>(getWidth());
+		const float height = static_cast<float>(getHeight());
+		float minX = std::numeric_limits<float>::infinity();
+		float minY = std::numeric_limits<float>::infinity();
+		float maxX = -std::numeric_limits<float>::infinity();
+		float maxY = -std::numeric_limits<float>::infinity();
+		float zMin = std::numeric_limits<float>::infinity();
+		for (int corner = 0; corner < 8; ++corner) {
+			const S_Vec3 point(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z);
+			const S_ClipVertex clip = toClip(view, point);
+			if (clip.z < 0.0f) {
+				return true;
+			}
+			const float inverseW = 1.0f / clip.w;
+			const float x = (clip.x * inverseW * 0.5f + 0.5f) * width;
+			const float y = (0.5f - clip.y * inverseW * 0.5f) * height;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			zMin = std::min(zMin, clip.z * inverseW);
+		}
+		if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) {
+			return false;
+		}
+
+		const uint32_t tileMinX = static_cast<uint32_t>(std::max(minX, 0.0f)) / TILE_WIDTH;
+		const uint32_t tileMinY = static_cast<uint32_t>(std::max(minY, 0.0f)) / TILE_HEIGHT;
+		const uint32_t tileMaxX = std::min(static_cast<uint32_t>(std::min(maxX, width - 1.0f)) / TILE_WIDTH, tilesPerRow - 1);
+		const uint32_t tileMaxY = std::min(static_cast<uint32_t>(std::min(maxY, height - 1.0f)) / TILE_HEIGHT, tileRows - 1);
+		for (uint32_t tileRow = tileMinY; tileRow <= tileMaxY; ++tileRow) {
+			for (uint32_t tileColumn = tileMinX; tileColumn <= tileMaxX; ++tileColumn) {
+				if (zMin <= tiles[size_t(tileRow) * tilesPerRow + tileColumn].zMax0) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void S_OcclusionBuffer::cullBoxes(const S_CullingBoxes& boxes, std::span<const uint32_t> candidates, std::vector<uint32_t>& visible) const {
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<uint8_t> passed(candidates.size(), 0);
+		core::jobs::S_JobSystem::getInstance().parallelFor(0, candidates.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				passed[i] = isVisible(boxes.get(candidates[i])) ? 1 : 0;
+			}
+		}, TEST_GRAIN);
+
+		visible.clear();
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			if (passed[i]) {
+				visible.push_back(candidates[i]);
+			}
+		}
+
+		stats.testedCount = static_cast<uint32_t>(candidates.size());
+		stats.occludedCount = static_cast<uint32_t>(candidates.size() - visible.size());
+		stats.testMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "occlusionTest", stats.testMilliseconds);
+	}
+
+	void S_OcclusionBuffer::resolveDepth(std::vector<float>& depth) const {
+		const uint32_t width = getWidth();
+		const uint32_t height = getHeight();
+		depth.resize(size_t(width) * height);
+		for (uint32_t y = 0; y < height; ++y) {
+			for (uint32_t x = 0; x < width; ++x) {
+				const S_OcclusionTile& tile = tiles[size_t(y / TILE_HEIGHT) * tilesPerRow + x / TILE_WIDTH];
+				const uint32_t bit = (y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH;
+				depth[size_t(y) * width + x] = (tile.mask >> bit) & 1u ? std::min(tile.zMax0, tile.zMax1) : tile.zMax0;
+			}
+		}
+	}
+
+	uint32_t S_OcclusionBuffer::getWidth() const {
+		return tilesPerRow * TILE_WIDTH;
+	}
+
+	uint32_t S_OcclusionBuffer::getHeight() const {
+		return tileRows * TILE_HEIGHT;
+	}
+
+	const S_OcclusionStats& S_OcclusionBuffer::getStats() const {
+		return stats;
+	}
+
+	void S_OcclusionBuffer::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "rasterMilliseconds", stats.rasterMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "testMilliseconds", stats.testMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "occluderTriangles", static_cast<double>(stats.occluderTriangles));
+		Instrumentation::setGauge(STATS_CATEGORY, "rasterizedTriangles", static_cast<double>(stats.rasterizedTriangles));
+		Instrumentation::setGauge(STATS_CATEGORY, "tested", static_cast<double>(stats.testedCount));
+		Instrumentation::setGauge(STATS_CATEGORY, "occluded", static_cast<double>(stats.occludedCount));
+	}
+}
@@ -0,0 +1,291 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Aabb.h"
+#include "S_Ray.h"
+
+namespace spectra::render {
+	enum class SPEC_RENDER_ENGINE E_BvhWidth : uint8_t {
+		WIDE_4 = 4,  // 64-byte nodes, one cache line
+		WIDE_8 = 8   // 128-byte nodes, two cache lines
+	};
+
+	struct S_BvhBuildSettings {
+		E_BvhWidth width = E_BvhWidth::WIDE_4;
+		uint32_t binCount = 16;              // SAH bins per axis, at most 64
+		uint32_t maxLeafSize = 4;            // At most 254
+		float traversalCost = 1.0f;
+		float intersectionCost = 1.0f;
+		bool spatialSplits = false;
+		float spatialSplitOverlap = 1e-5f;   // Try spatial splits when the children overlap by more than this fraction of the root area
+		float spatialSplitBudget = 0.3f;     // Extra references spatial splits may create, relative to the primitive count
+		uint32_t parallelThreshold = 4096;   // Nodes with more references build their children as separate jobs
+	};
+
+	struct S_BvhStats {
+		double buildMilliseconds = 0.0;
+		double refitMilliseconds = 0.0;
+		uint32_t refitNodeCount = 0;         // Nodes requantized by the last refit
+		uint32_t primitiveCount = 0;
+		uint32_t referenceCount = 0;         // Primitives plus duplicates from spatial splits
+		uint32_t spatialSplitCount = 0;
+		uint32_t nodeCount = 0;
+		uint32_t leafCount = 0;
+		uint32_t maxDepth = 0;
+		float sahCost = 0.0f;                // Of the final wide tree, relative to a single root intersection
+		size_t nodeBytes = 0;
+		size_t indexBytes = 0;
+		double bytesPerPrimitive = 0.0;
+	};
+
+	// Bounds of the part of a primitive inside clip, cut at position along axis. Used by
+	// spatial splits; without one the builder cuts the primitive's box, which is valid for
+	// any primitive but less tight than clipping the actual shape.
+	using BvhSplitFunction = std::function<void(uint32_t primitive, const core::math::S_Aabb& clip, int axis, float position,
+		core::math::S_Aabb& left, core::math::S_Aabb& right)>;
+
+	// Wide node with child bounds quantized to 8 bits against a power-of-two grid anchored
+	// at origin. Quantization rounds outwards, so decoded boxes always contain the child.
+	// Children are packed at the front; child bounds are stored per axis for SIMD loads.
+	template<uint32_t N>
+	struct alignas(64) S_WideBvhNode {
+		static constexpr uint8_t EMPTY_CHILD = 0;
+		static constexpr uint8_t INTERNAL_CHILD = 0xFF;
+
+		float origin[3];
+		int8_t exponent[3];
+		uint8_t childCount;
+		uint32_t child[N];      // Node index for internal children, first primitive index entry for leaves
+		uint8_t childType[N];   // EMPTY_CHILD, INTERNAL_CHILD or the leaf's primitive count
+		uint8_t lower[3][N];
+		uint8_t upper[3][N];
+
+		[[nodiscard]] float scale(int axis) const {
+			return std::bit_cast<float>(static_cast<uint32_t>(exponent[axis] + 127) << 23);
+		}
+
+		[[nodiscard]] core::math::S_Aabb getChildBounds(uint32_t index) const {
+			core::math::S_Aabb box;
+			for (int axis = 0; axis < 3; ++axis) {
+				box.min[axis] = origin[axis] + static_cast<float>(lower[axis][index]) * scale(axis);
+				box.max[axis] = origin[axis] + static_cast<float>(upper[axis][index]) * scale(axis);
+			}
+			return box;
+		}
+	};
+
+	static_assert(sizeof(S_WideBvhNode<4>) == 64, "4-wide node should fill one cache line");
+	static_assert(sizeof(S_WideBvhNode<8>) == 128, "8-wide node should fill two cache lines");
+
+	// Non-owning tree in S_Bvh's layout, e.g. one stored in a scene file and traversed where
+	// it is mapped. Primitive tests are supplied by the caller as for S_Bvh.
+	struct S_BvhView {
+		E_BvhWidth width = E_BvhWidth::WIDE_4;
+		uint32_t primitiveCount = 0;
+		core::math::S_Aabb bounds;
+		std::span<const S_WideBvhNode<4>> nodes4;
+		std::span<const S_WideBvhNode<8>> nodes8;
+		std::span<const uint32_t> primitiveIndices;
+
+		[[nodiscard]] bool isEmpty() const { return nodes4.empty() && nodes8.empty(); }
+
+		// As S_Bvh::intersect()
+		template<typename F>
+		bool intersect(core::math::S_Ray& ray, F&& intersectPrimitive) const;
+
+		// As S_Bvh::occluded()
+		template<typename F>
+		bool occluded(const core::math::S_Ray& ray, F&& anyHit) const;
+
+	private:
+		friend class S_Bvh;
+
+		template<uint32_t N, bool ANY_HIT, typename F>
+		static bool traverse(std::span<const S_WideBvhNode<N>> nodes, std::span<const uint32_t> primitiveIndices, core::math::S_Ray& ray,
+			F& primitiveTest);
+	};
+
+	// Bounding volume hierarchy over abstract primitives. The builder runs binned SAH
+	// (optionally with spatial splits) on the job system, then collapses the binary tree
+	// into 4- or 8-wide quantized nodes laid out depth-first. Primitive tests are supplied
+	// by the caller, so the same tree serves triangles, spheres or instances.
+	class SPEC_RENDER_ENGINE S_Bvh {
+	public:
+		static constexpr uint32_t MAX_DEPTH = 96;
+
+		// Node and index storage is tracked under E_MemoryTag::GEOMETRY
+		S_Bvh();
+
+		void build(std::span<const core::math::S_Aabb> primitiveBounds, const S_BvhBuildSettings& settings,
+			const BvhSplitFunction& splitPrimitive = {});
+
+		// Recomputes node bounds for moved primitives, keeping the topology. Cheaper than a
+		// rebuild for animation, at the cost of tree quality as primitives drift.
+		void refit(std::span<const core::math::S_Aabb> primitiveBounds);
+
+		// Refit that only visits the paths from primitives flagged in dirtyPrimitives, one byte
+		// per primitive, to the root. Other subtrees keep their exact bounds from the build or
+		// the previous refit. After a build with spatial splits the first refit is a full one.
+		void refit(std::span<const core::math::S_Aabb> primitiveBounds, std::span<const uint8_t> dirtyPrimitives);
+
+		// Copies a tree built elsewhere, e.g. loaded from a scene file, instead of building one.
+		// The first partial refit after it is a full one.
+		void assign(const S_BvhView& view);
+
+		void clear();
+
+		[[nodiscard]] bool isBuilt() const;
+		[[nodiscard]] E_BvhWidth getWidth() const;
+		[[nodiscard]] const core::math::S_Aabb& getBounds() const;
+		[[nodiscard]] const S_BvhStats& getStats() const;
+		[[nodiscard]] const std::pmr::vector<uint32_t>& getPrimitiveIndices() const;
+		[[nodiscard]] const std::pmr::vector<S_WideBvhNode<4>>& getNodes4() const;
+		[[nodiscard]] const std::pmr::vector<S_WideBvhNode<8>>& getNodes8() const;
+
+		// Valid until the tree is rebuilt, refitted or cleared
+		[[nodiscard]] S_BvhView getView() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::render::bvh"
+		void publishStats() const;
+
+		// Calls intersectPrimitive(primitive, ray) for candidates, roughly front to back. It
+		// returns true on a hit and shortens ray.tMax. Returns whether anything was hit.
+		template<typename F>
+		bool intersect(core::math::S_Ray& ray, F&& intersectPrimitive) const;
+
+		// Stops at the first primitive for which anyHit(primitive, ray) returns true
+		template<typename F>
+		bool occluded(const core::math::S_Ray& ray, F&& anyHit) const;
+
+	private:
+		std::pmr::vector<S_WideBvhNode<4>> nodes4;
+		std::pmr::vector<S_WideBvhNode<8>> nodes8;
+		std::pmr::vector<uint32_t> primitiveIndices;
+		std::pmr::vector<core::math::S_Aabb> nodeBounds;  // Unquantized, for partial refits
+		core::math::S_Aabb bounds;
+		E_BvhWidth width = E_BvhWidth::WIDE_4;
+		uint32_t primitiveCount = 0;
+		bool built = false;
+		S_BvhStats stats;
+
+		template<uint32_t N>
+		void refitNodes(std::pmr::vector<S_WideBvhNode<N>>& nodes, std::span<const core::math::S_Aabb> primitiveBounds);
+
+		template<uint32_t N>
+		void refitDirtyNodes(std::pmr::vector<S_WideBvhNode<N>>& nodes, std::span<const core::math::S_Aabb> primitiveBounds,
+			std::span<const uint8_t> dirtyPrimitives);
+	};
+
+	template<typename F>
+	bool S_BvhView::intersect(core::math::S_Ray& ray, F&& intersectPrimitive) const {
+		return width == E_BvhWidth::WIDE_8
+			? traverse<8, false>(nodes8, primitiveIndices, ray, intersectPrimitive)
+			: traverse<4, false>(nodes4, primitiveIndices, ray, intersectPrimitive);
+	}
+
+	template<typename F>
+	bool S_BvhView::occluded(const core::math::S_Ray& ray, F&& anyHit) const {
+		core::math::S_Ray shadowRay = ray;
+		return width == E_BvhWidth::WIDE_8
+			? traverse<8, true>(nodes8, primitiveIndices, shadowRay, anyHit)
+			: traverse<4, true>(nodes4, primitiveIndices, shadowRay, anyHit);
+	}
+
+	template<typename F>
+	bool S_Bvh::intersect(core::math::S_Ray& ray, F&& intersectPrimitive) const {
+		return width == E_BvhWidth::WIDE_8
+			? S_BvhView::traverse<8, false>(nodes8, primitiveIndices, ray, intersectPrimitive)
+			: S_BvhView::traverse<4, false>(nodes4, primitiveIndices, ray, intersectPrimitive);
+	}
+
+	template<typename F>
+	bool S_Bvh::occluded(const core::math::S_Ray& ray, F&& anyHit) const {
+		core::math::S_Ray shadowRay = ray;
+		return width == E_BvhWidth::WIDE_8
+			? S_BvhView::traverse<8, true>(nodes8, primitiveIndices, shadowRay, anyHit)
+			: S_BvhView::traverse<4, true>(nodes4, primitiveIndices, shadowRay, anyHit);
+	}
+
+	template<uint32_t N, bool ANY_HIT, typename F>
+	bool S_BvhView::traverse(std::span<const S_WideBvhNode<N>> nodes, std::span<const uint32_t> primitiveIndices, core::math::S_Ray& ray,
+		F& primitiveTest) {
+		if (nodes.empty()) {
+			return false;
+		}
+
+		const float inverse[3] = { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+		const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+
+		// Entries are node indices, or leaf ranges with the primitive count in the upper half
+		uint64_t stack[S_Bvh::MAX_DEPTH * N];
+		uint32_t top = 0;
+		stack[top++] = 0;
+		bool hit = false;
+
+		while (top > 0) {
+			const uint64_t entry = stack[--top];
+			const uint32_t leafCount = static_cast<uint32_t>(entry >> 32);
+			if (leafCount > 0) {
+				const uint32_t first = static_cast<uint32_t>(entry);
+				for (uint32_t i = first; i < first + leafCount; ++i) {
+					if (primitiveTest(primitiveIndices[i], ray)) {
+						if constexpr (ANY_HIT) {
+							return true;
+						}
+						hit = true;
+					}
+				}
+				continue;
+			}
+
+			const S_WideBvhNode<N>& node = nodes[static_cast<uint32_t>(entry)];
+			float slabOrigin[3];
+			float slabScale[3];
+			for (int axis = 0; axis < 3; ++axis) {
+				slabScale[axis] = node.scale(axis) * inverse[axis];
+				slabOrigin[axis] = (node.origin[axis] - origin[axis]) * inverse[axis];
+			}
+
+			// Insertion sort by entry distance, farthest first, so the nearest child is popped next
+			float distances[N];
+			uint64_t children[N];
+			uint32_t hitCount = 0;
+			for (uint32_t i = 0; i < node.childCount; ++i) {
+				float tNear = ray.tMin;
+				float tFar = ray.tMax;
+				for (int axis = 0; axis < 3; ++axis) {
+					const float t0 = slabOrigin[axis] + static_cast<float>(node.lower[axis][i]) * slabScale[axis];
+					const float t1 = slabOrigin[axis] + static_cast<float>(node.upper[axis][i]) * slabScale[axis];
+					tNear = std::max(tNear, std::min(t0, t1));
+					tFar = std::min(tFar, std::max(t0, t1));
+				}
+				if (tNear > tFar) {
+					continue;
+				}
+
+				const uint64_t child = node.childType[i] == S_WideBvhNode<N>::INTERNAL_CHILD
+					? static_cast<uint64_t>(node.child[i])
+					: (static_cast<uint64_t>(node.childType[i]) << 32) | node.child[i];
+				uint32_t slot = hitCount++;
+				while (slot > 0 && distances[slot - 1] < tNear) {
+					distances[slot] = distances[slot - 1];
+					children[slot] = children[slot - 1];
+					--slot;
+				}
+				distances[slot] = tNear;
+				children[slot] = child;
+			}
+			for (uint32_t i = 0; i < hitCount; ++i) {
+				stack[top++] = children[i];
+			}
+		}
+		return hit;
+	}
+}
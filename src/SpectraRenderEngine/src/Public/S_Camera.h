@@ -0,0 +1,24 @@
+#pragma once
+#include "SpectraRenderEngine.h"
+#include "S_Ray.h"
+#include "S_Vec3.h"
+
+namespace spectra::render {
+	// Pinhole camera
+	class SPEC_RENDER_ENGINE S_Camera {
+		core::math::S_Vec3 origin;
+		core::math::S_Vec3 topLeft;
+		core::math::S_Vec3 horizontal;
+		core::math::S_Vec3 vertical;
+
+	public:
+		S_Camera(const core::math::S_Vec3& position, const core::math::S_Vec3& target, const core::math::S_Vec3& up,
+			float verticalFovDegrees, float aspectRatio);
+
+		// u and v in [0, 1] across the image, v = 0 is the top row
+		[[nodiscard]] core::math::S_Ray generateRay(float u, float v) const;
+
+		// Image coordinates of a point, the inverse of generateRay(); false behind the camera
+		bool project(const core::math::S_Vec3& point, float& u, float& v) const;
+	};
+}
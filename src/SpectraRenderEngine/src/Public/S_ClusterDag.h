@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Meshlets.h"
+#include "S_Vec3.h"
+
+namespace spectra::render {
+	struct S_ClusterDagSettings {
+		S_MeshletSettings meshlets;
+		uint32_t groupSize = 4;          // Clusters simplified together
+		float reductionTarget = 0.5f;    // Fraction of a group's triangles kept per level
+		float minimumReduction = 0.15f;  // Groups that lose less are undone and their clusters regrouped a level up
+		uint32_t maxLevels = 24;         // Grouping rounds, including ones where groups got stuck
+	};
+
+	// Sphere bounding a cluster's detail with the simplification error it carries. Errors and
+	// spheres grow from children to parents, so projected errors are monotonic down the DAG.
+	struct S_LodBounds {
+		core::math::S_Vec3 center;
+		float radius = 0.0f;
+		float error = 0.0f;
+	};
+
+	struct S_Cluster {
+		uint32_t vertexOffset = 0;    // Into getClusterVertices(), mesh vertex indices
+		uint32_t triangleOffset = 0;  // Into getClusterTriangles(), three local indices per triangle
+		uint32_t vertexCount = 0;
+		uint32_t triangleCount = 0;
+		S_MeshletBounds bounds;
+		S_LodBounds lod;              // Of the group that produced the cluster; zero error at level 0
+		S_LodBounds parent;           // Of the group the cluster was simplified in; infinite error for roots
+		uint32_t level = 0;
+		uint32_t parentGroup = NO_GROUP;
+
+		static constexpr uint32_t NO_GROUP = 0xFFFFFFFFu;
+	};
+
+	struct S_ClusterDagStats {
+		double buildMilliseconds = 0.0;
+		double simplifyMilliseconds = 0.0;   // Summed over jobs
+		uint32_t levelCount = 0;
+		uint32_t clusterCount = 0;
+		uint32_t groupCount = 0;
+		uint32_t rootCount = 0;
+		uint32_t sourceTriangles = 0;
+		uint32_t rootTriangles = 0;
+	};
+
+	struct S_ClusterPageCluster {
+		S_MeshletBounds bounds;
+		uint32_t vertexOffset = 0;    // Into the page's positions
+		uint32_t triangleOffset = 0;  // Into the page's triangle bytes
+		uint32_t vertexCount = 0;
+		uint32_t triangleCount = 0;
+	};
+
+	// Resident part of a cluster: what LOD selection reads and where the geometry lives
+	struct S_ClusterRecord {
+		S_LodBounds lod;
+		S_LodBounds parent;
+		uint32_t page = 0;
+		uint32_t pageCluster = 0;
+	};
+
+	struct S_ClusterPage {
+		std::span<const S_ClusterPageCluster> clusters;
+		std::span<const core::math::S_Vec3> positions;
+		std::span<const uint8_t> triangles;
+	};
+
+	class S_ClusterDag;
+
+	// Non-owning view of a file written by S_ClusterDag::writePages(). The header and cluster
+	// records stay resident; each page is self-contained and starts on a PAGE_ALIGNMENT
+	// boundary, so it can be read or mapped on its own.
+	class SPEC_RENDER_ENGINE S_ClusterPageView {
+	public:
+		static constexpr uint32_t FORMAT_VERSION = 1;
+		static constexpr uint32_t PAGE_ALIGNMENT = 4096;
+
+		// Validates the header, the records and every page; false leaves the view empty
+		static bool parse(std::span<const std::byte> bytes, S_ClusterPageView& view);
+
+		[[nodiscard]] bool isValid() const;
+		[[nodiscard]] uint32_t getClusterCount() const;
+		[[nodiscard]] const S_ClusterRecord& getCluster(uint32_t cluster) const;
+		[[nodiscard]] uint32_t getPageCount() const;
+		[[nodiscard]] std::span<const std::byte> getPageBytes(uint32_t page) const;
+		[[nodiscard]] S_ClusterPage getPage(uint32_t page) const;
+
+		// Parses page bytes on their own, e.g. read from the file at the page's offset
+		static bool parsePage(std::span<const std::byte> bytes, S_ClusterPage& page);
+
+	private:
+		friend class S_ClusterDag;
+
+		struct S_Header;
+		struct S_PageEntry;
+
+		std::span<const std::byte> bytes;
+		const S_Header* header = nullptr;
+		const S_PageEntry* pages = nullptr;
+		const S_ClusterRecord* clusters = nullptr;
+	};
+
+	// Hierarchy of clusters for virtualized geometry. Level 0 holds the meshlets of the source
+	// mesh; each further level groups neighbouring clusters, simplifies each group with its
+	// border locked and splits the result into new clusters. Groups are simplified in parallel
+	// on the job system. A cut through the DAG chosen by selectClusters() is crack free: a
+	// group is always drawn either entirely as its children or entirely as its simplification.
+	class SPEC_RENDER_ENGINE S_ClusterDag {
+	public:
+		// Three indices into positions per triangle
+		void build(std::span<const core::math::S_Vec3> positions, std::span<const uint32_t> indices, const S_ClusterDagSettings& settings = {});
+
+		// Clusters whose error seen from viewPosition is at most threshold while their parent's
+		// is above it. Errors are projected as error / distance to the LOD sphere.
+		void selectClusters(const core::math::S_Vec3& viewPosition, float threshold, std::vector<uint32_t>& selected) const;
+
+		[[nodiscard]] std::span<const S_Cluster> getClusters() const;
+		[[nodiscard]] std::span<const uint32_t> getClusterVertices() const;
+		[[nodiscard]] std::span<const uint8_t> getClusterTriangles() const;
+		[[nodiscard]] std::span<const core::math::S_Vec3> getPositions() const;
+
+		// Writes the page file S_ClusterPageView reads. Clusters simplified in the same group,
+		// which are always needed together, share a page; roots come first.
+		[[nodiscard]] std::vector<std::byte> writePages(uint32_t pageSize = 65536) const;
+
+		[[nodiscard]] const S_ClusterDagStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::render::clusters"
+		void publishStats() const;
+
+	private:
+		std::vector<core::math::S_Vec3> positions;
+		std::vector<S_Cluster> clusters;
+		std::vector<uint32_t> clusterVertices;
+		std::vector<uint8_t> clusterTriangles;
+		S_ClusterDagStats stats;
+
+		void appendClusters(const S_MeshletSet& meshlets, uint32_t level, const S_LodBounds& lod);
+	};
+}
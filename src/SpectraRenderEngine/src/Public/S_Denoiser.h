@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+
+namespace spectra::render {
+	struct S_DenoiserSettings {
+		uint32_t iterations = 5;          // A-trous passes, tap spacing doubles each pass (1, 2, 4, ...)
+		uint32_t tileSize = 64;           // Pixels per side of one job, rounded up to a multiple of 4
+		float luminanceSigma = 4.0f;      // In standard deviations of the pixel's filtered noise
+		float normalPower = 128.0f;       // Weight falls as exp(-normalPower * (1 - cos))
+		float depthSigma = 1.0f;          // In multiples of the local depth gradient per pixel of distance
+		float albedoSigma = 0.1f;
+	};
+
+	// Planar views of one frame, rows top to bottom. Three floats per pixel for color, albedo
+	// and normal, one for depth and variance. Variance is of the luminance of each pixel's
+	// mean; when empty it is estimated from the 3x3 neighbourhood instead.
+	struct S_DenoiserInput {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::span<const float> color;
+		std::span<const float> albedo;
+		std::span<const float> normal;
+		std::span<const float> depth;
+		std::span<const float> variance;
+	};
+
+	// Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) with the variance-driven
+	// luminance weight of SVGF (Schied et al. 2017). Color is divided by albedo before
+	// filtering so texture survives, and the weights compare first-hit albedo, normal and
+	// depth so geometric edges do too.
+	// Pixels are stored as padded planes and filtered four at a time with SSE, one tile per
+	// job; the result is identical for any thread count.
+	class SPEC_RENDER_ENGINE S_Denoiser {
+	public:
+		explicit S_Denoiser(const S_DenoiserSettings& settings = {});
+
+		// Writes the filtered color, three floats per pixel
+		void denoise(const S_DenoiserInput& input, std::vector<float>& output);
+
+		[[nodiscard]] const S_DenoiserSettings& getSettings() const;
+		[[nodiscard]] double getLastMilliseconds() const;
+
+	private:
+		S_DenoiserSettings settings;
+		std::pmr::vector<float> planes;  // Padded scratch planes, kept between frames
+		double lastMilliseconds = 0.0;
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Vec3.h"
+
+namespace spectra::render {
+	struct S_MeshletSettings {
+		uint32_t maxVertices = 64;    // At most 256, local indices are bytes
+		uint32_t maxTriangles = 124;
+	};
+
+	struct S_Meshlet {
+		uint32_t vertexOffset = 0;    // First entry of S_MeshletSet::vertices
+		uint32_t triangleOffset = 0;  // First byte of S_MeshletSet::triangles, three per triangle
+		uint32_t vertexCount = 0;
+		uint32_t triangleCount = 0;
+	};
+
+	// Meshlets of one mesh: vertices maps each meshlet's local indices to mesh vertices
+	struct S_MeshletSet {
+		std::vector<S_Meshlet> meshlets;
+		std::vector<uint32_t> vertices;
+		std::vector<uint8_t> triangles;
+
+		void clear();
+	};
+
+	// Bounding sphere and normal cone. The meshlet faces away from a viewer at position p when
+	// dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius; a cutoff of 1 never culls.
+	struct S_MeshletBounds {
+		core::math::S_Vec3 center;
+		float radius = 0.0f;
+		core::math::S_Vec3 coneAxis{ 0.0f, 0.0f, 1.0f };
+		float coneCutoff = 1.0f;
+	};
+
+	// Splits triangle lists into meshlets of bounded size. Meshlets grow greedily from a seed
+	// over neighbouring triangles, taking first those that add the fewest new vertices and then
+	// those nearest the meshlet's centre, so meshlets come out compact with few shared vertices.
+	class SPEC_RENDER_ENGINE S_MeshletBuilder {
+	public:
+		// Three indices into positions per triangle; meshlets are appended to set
+		static void build(std::span<const core::math::S_Vec3> positions, std::span<const uint32_t> indices, const S_MeshletSettings& settings,
+			S_MeshletSet& set);
+
+		[[nodiscard]] static S_MeshletBounds computeBounds(std::span<const core::math::S_Vec3> positions, const S_MeshletSet& set, uint32_t meshlet);
+
+		[[nodiscard]] static bool isBackfacing(const S_MeshletBounds& bounds, const core::math::S_Vec3& viewPosition);
+	};
+}
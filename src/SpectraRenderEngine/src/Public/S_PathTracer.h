@@ -0,0 +1,163 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Camera.h"
+#include "S_Random.h"
+#include "S_Sampler.h"
+#include "S_Scene.h"
+#include "S_TiledImageWriter.h"
+
+namespace spectra::render {
+	struct S_PathTracerSettings {
+		uint32_t width = 640;
+		uint32_t height = 480;
+		uint32_t tileSize = 32;
+		uint32_t samplesPerPass = 4;
+		uint32_t minSamples = 16;             // Per pixel before a tile may be considered converged
+		uint32_t maxSamples = 1024;
+		uint32_t maxAdaptiveBoost = 4;        // Noisy tiles take up to this many times samplesPerPass per pass
+		uint32_t maxDepth = 8;
+		float convergenceThreshold = 0.02f;   // Mean relative standard error of the tile's pixels, 0 disables
+		uint64_t seed = 0;
+		E_SamplerType sampler = E_SamplerType::SOBOL;
+	};
+
+	struct S_TileState {
+		uint32_t x0 = 0;
+		uint32_t y0 = 0;
+		uint32_t x1 = 0;  // Exclusive
+		uint32_t y1 = 0;  // Exclusive
+		uint32_t samples = 0;
+		float error = 0.0f;
+		bool converged = false;
+	};
+
+	struct S_PathTracerStats {
+		uint32_t passes = 0;
+		uint32_t tileCount = 0;
+		uint32_t convergedTiles = 0;
+		uint64_t pixelSamples = 0;
+		uint64_t rays = 0;               // Closest-hit and shadow rays traced
+		double renderMilliseconds = 0.0;
+		double megaRaysPerSecond = 0.0;
+	};
+
+	// Per-pixel averages of the camera ray's first hit, the guide buffers of S_Denoiser
+	struct S_PathTracerFeatures {
+		std::vector<float> albedo;    // Three floats per pixel, 1 where the ray escaped
+		std::vector<float> normal;    // Three floats per pixel, 0 where the ray escaped
+		std::vector<float> depth;     // Distance along the camera ray, 0 where it escaped
+		std::vector<float> variance;  // Of the luminance of the pixel mean
+	};
+
+	// Progressive CPU path tracer with next-event estimation towards emissive triangles.
+	// Each pass renders the unfinished tiles in parallel on the job system and accumulates
+	// into a float buffer; tiles stop once their noise estimate drops below the threshold,
+	// and noisier tiles receive more samples per pass.
+	// Every random decision is an S_Sampler dimension of (seed, pixel, sample index), so the
+	// image is bit-identical for any thread count.
+	// Accumulators are stored tile by tile, so a tile's pixels share cache lines and pages
+	// and finished tiles stream to an S_TiledImageWriter without a full-frame copy.
+	class SPEC_RENDER_ENGINE S_PathTracer {
+	public:
+		explicit S_PathTracer(const S_PathTracerSettings& settings);
+
+		// Clears the accumulation buffer. The scene and camera must outlive the render.
+		void begin(const S_Scene& scene, const S_Camera& camera);
+
+		// Returns false once every tile has converged or reached maxSamples
+		bool renderPass();
+
+		// A pass over the listed tiles only, skipping finished ones, for callers that schedule
+		// tiles themselves. Tiles earlier in the list are started first; repeated and out of range
+		// indices are skipped. Returns false when none of them was unfinished.
+		bool renderTiles(std::span<const uint32_t> tileIndices);
+
+		// Passes poll *flag between rows and stop once it is true, returning false; the
+		// accumulation is then partial and the render must start over with begin().
+		// nullptr detaches. The flag must outlive the render.
+		void setCancelFlag(const std::atomic<bool>* flag);
+
+		// begin() followed by passes until complete
+		void render(const S_Scene& scene, const S_Camera& camera);
+
+		[[nodiscard]] bool isComplete() const;
+
+		// Averaged linear RGB, three floats per pixel, rows top to bottom
+		void resolve(std::vector<float>& rgb) const;
+
+		// Writes one tile's pixels into a full image laid out like resolve()
+		void resolveTile(uint32_t tileIndex, std::span<float> rgb) const;
+
+		// Same layout as resolve()
+		void resolveFeatures(S_PathTracerFeatures& features) const;
+
+		// Writes each tile to writer once it converges or reaches maxSamples, on the calling
+		// thread after the pass. The writer must match the image and tile size; nullptr detaches.
+		void setOutput(S_TiledImageWriter* writer);
+
+		// renderPass() saves a checkpoint to path whenever intervalSeconds have passed since
+		// the last one; 0 disables
+		void setCheckpoint(const std::string& path, double intervalSeconds);
+
+		// Accumulation and tile state in native layout, written to a temporary file and renamed
+		bool saveCheckpoint(const std::string& path) const;
+
+		// Call after begin(). Restores a checkpoint taken with the same image, tile, sample and
+		// seed settings, returns false and leaves the render untouched otherwise. Finished tiles
+		// are streamed again to the current output.
+		bool loadCheckpoint(const std::string& path);
+
+		[[nodiscard]] const S_PathTracerSettings& getSettings() const;
+		[[nodiscard]] const std::vector<S_TileState>& getTiles() const;
+		[[nodiscard]] S_PathTracerStats getStats() const;
+
+		// Pushes the current stats to SpectraInstrumentation under "spectra::render::pathtracer"
+		void publishStats() const;
+
+	private:
+		struct S_PixelAccumulator {
+			core::math::S_Vec3 radiance;
+			float luminance = 0.0f;
+			float luminanceSquared = 0.0f;
+			core::math::S_Vec3 albedo;
+			core::math::S_Vec3 normal;
+			float depth = 0.0f;
+		};
+
+		S_PathTracerSettings settings;
+		S_Sampler sampler;
+		const S_Scene* scene = nullptr;
+		const S_Camera* camera = nullptr;
+		std::pmr::vector<S_PixelAccumulator> accumulators;  // Tile by tile, rows within a tile
+		std::vector<S_TileState> tiles;
+		std::vector<size_t> tileOffsets;                    // First accumulator of each tile
+		std::vector<uint8_t> tileStreamed;
+		std::vector<float> tileScratch;
+		S_TiledImageWriter* output = nullptr;
+		std::string checkpointPath;
+		double checkpointInterval = 0.0;
+		std::chrono::steady_clock::time_point lastCheckpoint;
+		std::vector<uint32_t> activeTiles;
+		std::vector<uint32_t> passSamples;
+		std::vector<uint32_t> tileQueued;                   // Stamp of the renderTiles() call that last queued each tile
+		uint32_t queueStamp = 0;
+		const std::atomic<bool>* cancelFlag = nullptr;
+		std::atomic<uint64_t> raysTraced{ 0 };
+		S_PathTracerStats stats;
+
+		[[nodiscard]] uint32_t samplesForPass(const S_TileState& tile) const;
+		[[nodiscard]] bool isCancelled() const;
+		bool runPass();
+		void renderTile(uint32_t tileIndex, uint32_t sampleCount);
+		void streamFinishedTiles();
+		[[nodiscard]] core::math::S_Vec3 tracePath(core::math::S_Ray ray, S_PixelSample pixelSample, S_PixelAccumulator& pixel, uint64_t& rays) const;
+	};
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_RayStream.h"
+#include "S_Vec3.h"
+#include "S_uint4.h"
+
+namespace spectra::render {
+	// Float vertex attributes, one entry per vertex in every stream that is not empty
+	struct S_VertexStreams {
+		std::span<const core::math::S_Vec3> positions;
+		std::span<const core::math::S_Vec3> normals;   // Any length, packed as directions
+		std::span<const float> tangents;                // Direction and handedness (+1 or -1), four per vertex
+		std::span<const float> uvs;                     // Two per vertex
+		std::span<const float> weights;                 // Four non-negative skin weights per vertex
+		std::span<const uint8_t> joints;                // Four per vertex, matching weights
+	};
+
+	// Streams as S_QuantizedMesh::decode() writes them, sized like the encoded streams
+	struct S_DecodedVertices {
+		std::vector<core::math::S_Vec3> positions;
+		std::vector<core::math::S_Vec3> normals;
+		std::vector<float> tangents;
+		std::vector<float> uvs;
+		std::vector<float> weights;
+		std::vector<uint8_t> joints;
+	};
+
+	// 24 bytes per vertex against 68 for the float streams. Six little-endian 32-bit words,
+	// which is how the SIMD kernels load it.
+	struct S_PackedVertex {
+		uint16_t position[3];  // Unorm16 across the mesh bounds
+		uint16_t weights;      // Four 4-bit lanes in units of 1/15, summing to 15, lane 0 lowest
+		uint32_t normal;       // Octahedral, snorm16 u in the low half, v in the high half
+		uint32_t tangent;      // Octahedral, snorm15 u in bits 0-14, v in bits 15-29, bit 31 set for negative handedness
+		uint16_t uv[2];        // Unorm16 across the mesh's UV range
+		uint8_t joints[4];
+
+		[[nodiscard]] core::math::S_uint4 getWeight(uint32_t lane) const { return core::math::S_uint4(weights >> (lane * 4)); }
+		void setWeight(uint32_t lane, core::math::S_uint4 weight) {
+			weights = static_cast<uint16_t>((weights & ~(0xFu << (lane * 4))) | (weight.value() << (lane * 4)));
+		}
+	};
+	static_assert(sizeof(S_PackedVertex) == 24);
+
+	// Largest error decoding can introduce per attribute, for the ranges of one mesh
+	struct S_VertexErrorBounds {
+		float position = 0.0f;       // Per axis, in mesh units
+		float normalDegrees = 0.0f;
+		float tangentDegrees = 0.0f;
+		float uv = 0.0f;             // Per component
+		float weight = 0.0f;         // Against the weights normalized to sum to one
+	};
+
+	struct S_QuantizedMeshStats {
+		double encodeMilliseconds = 0.0;
+		double decodeMilliseconds = 0.0;
+		uint32_t vertexCount = 0;
+		size_t packedBytes = 0;
+		size_t floatBytes = 0;       // Of the encoded streams
+	};
+
+	// Vertices packed into S_PackedVertex for meshes that are bound by memory bandwidth.
+	// Positions and UVs are quantized against ranges fitted to the mesh, directions are
+	// octahedral and skin weights are rounded to 4 bits so they still sum to one. Encode and
+	// decode run on the job system; the AVX2 kernels give the same bits as the scalar ones.
+	class SPEC_RENDER_ENGINE S_QuantizedMesh {
+	public:
+		S_QuantizedMesh();
+
+		// Fits the ranges to the streams and packs every vertex. Attributes of empty streams pack as zero.
+		void encode(const S_VertexStreams& streams, E_SimdLevel level = E_SimdLevel::BEST);
+
+		// Decodes the attributes that were encoded. AVX512 uses the AVX2 kernels.
+		void decode(S_DecodedVertices& vertices, E_SimdLevel level = E_SimdLevel::BEST) const;
+
+		[[nodiscard]] const std::pmr::vector<S_PackedVertex>& getVertices() const;
+		[[nodiscard]] uint32_t getVertexCount() const;
+
+		// position = positionOffset + quantized * positionScale, likewise for UVs
+		[[nodiscard]] const core::math::S_Vec3& getPositionOffset() const;
+		[[nodiscard]] const core::math::S_Vec3& getPositionScale() const;
+		[[nodiscard]] const float* getUvOffset() const;
+		[[nodiscard]] const float* getUvScale() const;
+
+		[[nodiscard]] S_VertexErrorBounds getErrorBounds() const;
+
+		// Largest error of decoded against original, in the units of S_VertexErrorBounds.
+		// A tangent whose handedness flipped counts as 180 degrees.
+		[[nodiscard]] static S_VertexErrorBounds measureError(const S_VertexStreams& original, const S_DecodedVertices& decoded);
+
+		[[nodiscard]] const S_QuantizedMeshStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::render::vertices"
+		void publishStats() const;
+
+	private:
+		std::pmr::vector<S_PackedVertex> vertices;
+		core::math::S_Vec3 positionOffset;
+		core::math::S_Vec3 positionScale;
+		float uvOffset[2] = {};
+		float uvScale[2] = {};
+		uint32_t presentStreams = 0;  // Bit per stream of S_VertexStreams, in declaration order
+		mutable S_QuantizedMeshStats stats;
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+
+namespace spectra::render {
+	// 64-bit finalizer from SplitMix64, turns structured keys into well-mixed seeds
+	[[nodiscard]] constexpr uint64_t mixBits(uint64_t value) {
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+		return value;
+	}
+
+	// PCG32 (O'Neill 2014): 64-bit LCG state with a permuted 32-bit output. Each
+	// stream is an independent sequence, so (seed, stream) pairs never overlap.
+	class S_Pcg32 {
+		uint64_t state = 0;
+		uint64_t increment = 1;
+
+	public:
+		constexpr S_Pcg32() = default;
+		constexpr S_Pcg32(uint64_t seed, uint64_t stream) {
+			reseed(seed, stream);
+		}
+
+		constexpr void reseed(uint64_t seed, uint64_t stream) {
+			state = 0;
+			increment = (stream << 1u) | 1u;
+			nextUint();
+			state += seed;
+			nextUint();
+		}
+
+		constexpr uint32_t nextUint() {
+			const uint64_t previous = state;
+			state = previous * 6364136223846793005ull + increment;
+			const uint32_t xorShifted = static_cast<uint32_t>(((previous >> 18u) ^ previous) >> 27u);
+			const uint32_t rotation = static_cast<uint32_t>(previous >> 59u);
+			return (xorShifted >> rotation) | (xorShifted << ((~rotation + 1u) & 31u));
+		}
+
+		// Uniform in [0, 1), never rounds up to 1
+		constexpr float nextFloat() {
+			return static_cast<float>(nextUint() >> 8) * 0x1.0p-24f;
+		}
+	};
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Aabb.h"
+#include "S_Ray.h"
+
+namespace spectra::render {
+	enum class SPEC_RENDER_ENGINE E_SimdLevel : uint8_t {
+		SCALAR = 0,   // One ray at a time through the scalar BVH traversal
+		AVX2,         // 8-ray packets
+		AVX512,       // 16-ray packets
+		BEST = 0xFF   // Widest level the CPU and the build support
+	};
+
+	// Rays in structure-of-arrays form, traced together by S_Scene::intersectStream().
+	// Packets are formed from consecutive entries of order, so sorting for coherence puts
+	// rays that take the same path through the BVH into the same packet.
+	struct SPEC_RENDER_ENGINE S_RayStream {
+		static constexpr uint32_t NO_HIT = 0xFFFFFFFFu;
+
+		std::vector<float> originX;
+		std::vector<float> originY;
+		std::vector<float> originZ;
+		std::vector<float> directionX;
+		std::vector<float> directionY;
+		std::vector<float> directionZ;
+		std::vector<float> tMin;
+		std::vector<float> tMax;       // Shortened to the closest hit
+		std::vector<uint32_t> primitive;  // Hit primitive after tracing, NO_HIT on a miss
+		std::vector<uint32_t> order;   // Trace order, empty traces rays by index
+
+		void resize(size_t count);
+		[[nodiscard]] size_t size() const;
+
+		void setRay(size_t index, const core::math::S_Ray& ray);
+		[[nodiscard]] core::math::S_Ray getRay(size_t index) const;
+
+		// Orders rays by direction octant, then origin and direction along Morton curves within
+		// bounds. Worth it for secondary rays; primary and shadow rays from a tile already are coherent.
+		void sortForCoherence(const core::math::S_Aabb& bounds);
+
+		// Level BEST resolves to on this machine
+		[[nodiscard]] static E_SimdLevel getBestSimdLevel();
+		[[nodiscard]] static uint32_t getPacketWidth(E_SimdLevel level);
+		[[nodiscard]] static const char* getSimdLevelName(E_SimdLevel level);
+	};
+}
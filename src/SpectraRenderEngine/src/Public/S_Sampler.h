@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+#include "SpectraRenderEngine.h"
+
+namespace spectra::render {
+	enum class SPEC_RENDER_ENGINE E_SamplerType : uint8_t {
+		INDEPENDENT = 0,  // PCG32 per sample, the reference
+		SOBOL,            // Owen-scrambled Sobol (0,2)-sequence per 2D dimension
+		RANK1,            // Extensible rank-1 lattice, Cranley-Patterson rotated per pixel
+		BLUE_NOISE        // Rank-1 lattice rotated by a blue-noise tile, error spreads as blue noise across pixels
+	};
+
+	struct S_Sample2D {
+		float u = 0.0f;
+		float v = 0.0f;
+	};
+
+	// Which sample of which pixel; cheap to copy into every call
+	struct S_PixelSample {
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint32_t index = 0;
+	};
+
+	// Stateless low-discrepancy sampler. Every value is a pure function of (seed, pixel,
+	// sample index, dimension), so any job may ask for any sample in any order and images
+	// do not depend on scheduling.
+	// A dimension is one decorrelated 1D or 2D slot, e.g. the pixel position or the BSDF
+	// direction of one bounce. Callers give every decision its own fixed dimension so sample
+	// i of a slot always lands on the same point set; mixing 1D and 2D use of a dimension is
+	// allowed but wastes the 2D stratification.
+	class SPEC_RENDER_ENGINE S_Sampler {
+		E_SamplerType type = E_SamplerType::SOBOL;
+		uint32_t seed = 0;
+
+	public:
+		static constexpr uint32_t BLUE_NOISE_SIZE = 64;  // Texels per side of the blue-noise tile
+
+		S_Sampler() = default;
+		explicit S_Sampler(E_SamplerType type, uint64_t seed = 0);
+
+		[[nodiscard]] float get1D(const S_PixelSample& sample, uint32_t dimension) const;
+		[[nodiscard]] S_Sample2D get2D(const S_PixelSample& sample, uint32_t dimension) const;
+
+		[[nodiscard]] E_SamplerType getType() const;
+		[[nodiscard]] static const char* getTypeName(E_SamplerType type);
+
+		// Value in [0, 1) of the shared tile, generated on first use by void-and-cluster
+		[[nodiscard]] static float getBlueNoise(uint32_t x, uint32_t y);
+	};
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Bvh.h"
+#include "S_Ray.h"
+#include "S_RayStream.h"
+#include "S_Vec3.h"
+
+namespace spectra::render {
+	enum class SPEC_RENDER_ENGINE E_SurfaceType : uint8_t {
+		DIFFUSE = 0,  // Lambertian
+		METAL,        // Mirror reflection perturbed by roughness
+		DIELECTRIC    // Glass-like, Schlick Fresnel between reflection and refraction
+	};
+
+	struct S_SurfaceMaterial {
+		E_SurfaceType type = E_SurfaceType::DIFFUSE;
+		core::math::S_Vec3 albedo{ 0.8f };
+		core::math::S_Vec3 emission{ 0.0f };
+		float roughness = 0.0f;
+		float ior = 1.5f;
+	};
+
+	struct S_Sphere {
+		core::math::S_Vec3 center;
+		float radius = 1.0f;
+		uint32_t material = 0;
+	};
+
+	// Indices into the scene's shared vertex array
+	struct S_Triangle {
+		uint32_t vertices[3] = {};
+		uint32_t material = 0;
+	};
+
+	struct S_Hit {
+		float t = 0.0f;
+		core::math::S_Vec3 position;
+		core::math::S_Vec3 normal;    // Unit geometric normal, facing against the incoming ray
+		uint32_t material = 0;
+		bool frontFace = true;        // False when the ray hit the back of the surface
+		bool sampledEmitter = false;  // Emissive triangle, its light is also reached through sampleLight()
+	};
+
+	struct S_LightSample {
+		core::math::S_Vec3 position;
+		core::math::S_Vec3 normal;
+		core::math::S_Vec3 emission;
+		float pdfArea = 0.0f;  // With respect to surface area over all emitters
+	};
+
+	class S_SceneFileView;
+
+	// Geometry and materials the CPU path tracer renders. Not thread-safe to modify,
+	// intersect() and occluded() may be called from any number of threads.
+	class SPEC_RENDER_ENGINE S_Scene {
+		std::vector<S_SurfaceMaterial> materials;
+		std::vector<S_Sphere> spheres;
+		std::vector<core::math::S_Vec3> vertices;
+		std::vector<S_Triangle> triangles;
+		std::vector<uint32_t> emissiveTriangles;
+		std::vector<float> emissiveAreaCdf;  // Running area sum over emissiveTriangles
+		core::math::S_Vec3 skyHorizon{ 0.0f };
+		core::math::S_Vec3 skyZenith{ 0.0f };
+		S_Bvh accelerator;  // Primitive ids are triangles first, then spheres
+
+		void collectPrimitiveBounds(std::vector<core::math::S_Aabb>& bounds) const;
+		bool intersectPrimitive(uint32_t primitive, const core::math::S_Ray& ray, float& t) const;
+
+		// Primitive ids, S_RayStream::NO_HIT when nothing is hit
+		uint32_t findClosest(core::math::S_Ray& ray) const;
+		uint32_t findAnyHit(const core::math::S_Ray& ray) const;
+		void fillHit(const core::math::S_Ray& ray, uint32_t primitive, S_Hit& hit) const;
+		void traceStream(S_RayStream& rays, E_SimdLevel level, bool anyHit) const;
+		void rebuildEmissive();
+
+	public:
+		uint32_t addMaterial(const S_SurfaceMaterial& material);
+
+		// Edits a material in place; triangles that start or stop emitting update the light list
+		void setMaterial(uint32_t index, const S_SurfaceMaterial& material);
+		void addSphere(const core::math::S_Vec3& center, float radius, uint32_t material);
+
+		// Three indices per triangle, relative to positions. Returns the first new triangle.
+		uint32_t addMesh(std::span<const core::math::S_Vec3> positions, std::span<const uint32_t> indices, uint32_t material);
+
+		// Replaces everything with the file's contents. Arrays are copied in bulk and a stored
+		// BVH is adopted as is, so nothing is parsed or built.
+		void load(const S_SceneFileView& file);
+
+		// Radiance of rays that leave the scene, blended from horizon to zenith
+		void setSky(const core::math::S_Vec3& horizon, const core::math::S_Vec3& zenith);
+		[[nodiscard]] core::math::S_Vec3 sky(const core::math::S_Vec3& direction) const;
+
+		// Builds the BVH over every sphere and triangle. Without one, or after more geometry is
+		// added, intersect() and occluded() test every primitive.
+		void buildAccelerator(const S_BvhBuildSettings& settings = {});
+		[[nodiscard]] const S_Bvh& getAccelerator() const;
+
+		// Moves existing vertices, e.g. for animation, and refits the BVH to them
+		void updateVertices(uint32_t firstVertex, std::span<const core::math::S_Vec3> positions);
+
+		// Closest hit in [ray.tMin, ray.tMax), shortens ray.tMax to the hit distance
+		bool intersect(core::math::S_Ray& ray, S_Hit& hit) const;
+
+		// Any hit in [ray.tMin, ray.tMax)
+		[[nodiscard]] bool occluded(const core::math::S_Ray& ray) const;
+
+		// Traces every ray of the stream in packets of the requested width, clamped to what the
+		// CPU supports. Falls back to single rays at SCALAR or without a BVH. Results match
+		// intersect(): tMax is shortened and primitive set for rays that hit.
+		void intersectStream(S_RayStream& rays, E_SimdLevel level = E_SimdLevel::BEST) const;
+
+		// Sets primitive to some blocker of each occluded ray, not necessarily the nearest
+		void occludedStream(S_RayStream& rays, E_SimdLevel level = E_SimdLevel::BEST) const;
+
+		// Surface details of a ray traced by intersectStream(), false on a miss
+		bool getStreamHit(const S_RayStream& rays, size_t index, S_Hit& hit) const;
+
+		// Uniform by area over emissive triangles, false when the scene has none.
+		// Emissive spheres are only found by hitting them.
+		bool sampleLight(float uSelect, float u1, float u2, S_LightSample& sample) const;
+		[[nodiscard]] bool hasSampledLights() const;
+
+		[[nodiscard]] std::span<const S_SurfaceMaterial> getMaterials() const;
+		[[nodiscard]] std::span<const S_Sphere> getSpheres() const;
+		[[nodiscard]] std::span<const core::math::S_Vec3> getVertices() const;
+		[[nodiscard]] std::span<const S_Triangle> getTriangles() const;
+		[[nodiscard]] const core::math::S_Vec3& getSkyHorizon() const;
+		[[nodiscard]] const core::math::S_Vec3& getSkyZenith() const;
+
+		[[nodiscard]] const S_SurfaceMaterial& getMaterial(uint32_t index) const;
+		[[nodiscard]] size_t getMaterialCount() const;
+		[[nodiscard]] size_t getSphereCount() const;
+		[[nodiscard]] size_t getTriangleCount() const;
+		[[nodiscard]] size_t getVertexCount() const;
+	};
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SpectraRenderEngine.h"
+#include "S_Bvh.h"
+
+namespace spectra::render {
+	struct S_SceneConvertSettings {
+		S_BvhBuildSettings bvh;   // The BVH is built once here and stored in the file
+		bool quantize = true;     // Also store every mesh as S_PackedVertex
+	};
+
+	struct S_SceneConvertStats {
+		double parseMilliseconds = 0.0;
+		double bvhMilliseconds = 0.0;
+		double quantizeMilliseconds = 0.0;
+		double writeMilliseconds = 0.0;
+		uint32_t meshCount = 0;
+		uint32_t materialCount = 0;
+		uint32_t triangleCount = 0;
+		uint32_t vertexCount = 0;
+		size_t fileBytes = 0;
+	};
+
+	// Offline conversion of interchange formats to scene files, so render jobs map a file
+	// instead of parsing text. Wavefront OBJ with its MTL libraries is supported: polygons are
+	// fanned into triangles, every object, group or material change starts a mesh and vertices
+	// are shared within a mesh where position, UV and normal all match. MTL parameters map to
+	// the closest S_SurfaceMaterial: Kd to albedo, Ke to emission, Pm above one half to metal,
+	// transparency or illum 4, 6 and 7 to dielectric with Ni as IOR, and Pr, or Ns otherwise,
+	// to roughness.
+	class SPEC_RENDER_ENGINE S_SceneConverter {
+	public:
+		// False, with a WARNING and getLastError(), when the OBJ cannot be read or refers to
+		// missing data, or the scene file cannot be written. Missing MTL files only warn.
+		bool convertObj(const std::string& objPath, const std::string& scenePath, const S_SceneConvertSettings& settings = {});
+
+		[[nodiscard]] const std::string& getLastError() const;
+		[[nodiscard]] const S_SceneConvertStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::render::scenefile"
+		void publishStats() const;
+
+	private:
+		std::string lastError;
+		S_SceneConvertStats stats;
+	};
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Bvh.h"
+#include "S_MappedFile.h"
+#include "S_QuantizedMesh.h"
+#include "S_Scene.h"
+
+namespace spectra::render {
+	enum class SPEC_RENDER_ENGINE E_SceneSection : uint32_t {
+		INFO = 0,            // One record: sky, bounds and BVH layout
+		MATERIALS,           // S_SurfaceMaterial
+		SPHERES,             // S_Sphere
+		VERTICES,            // S_Vec3
+		TRIANGLES,           // S_Triangle
+		MESHES,              // Mesh records
+		PACKED_VERTICES,     // S_PackedVertex of quantized meshes
+		BVH_NODES,           // S_WideBvhNode<4> or <8>, as INFO says
+		BVH_INDICES,         // uint32_t
+		PROGRAMS,            // Material program records
+		PROGRAM_BYTES,       // Program blobs, each BLOB_ALIGNMENT aligned
+		STRINGS,             // Names, not terminated
+		COUNT
+	};
+
+	// Named range of the scene's triangles and vertices. Quantized meshes also carry their
+	// vertices packed, one per scene vertex of the range.
+	struct S_SceneMesh {
+		std::string_view name;
+		uint32_t firstTriangle = 0;
+		uint32_t triangleCount = 0;
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t material = 0;
+		core::math::S_Aabb bounds;
+		std::span<const S_PackedVertex> packedVertices;  // Empty when not quantized
+		core::math::S_Vec3 positionOffset;               // Decoding ranges, as S_QuantizedMesh reports them
+		core::math::S_Vec3 positionScale;
+		float uvOffset[2] = {};
+		float uvScale[2] = {};
+	};
+
+	// Compiled material, e.g. S_MaterialProgram::serialize() bytes, handed on untouched
+	struct S_SceneProgram {
+		std::string_view name;
+		std::span<const std::byte> bytes;
+	};
+
+	// Non-owning view of a scene file. The header holds a fixed table with one entry per
+	// E_SceneSection; every section starts on a BLOB_ALIGNMENT boundary and records refer to
+	// each other by index or by offset from their section, never by address, so a file works
+	// wherever it is mapped. Data is native little-endian with this build's struct layouts.
+	class SPEC_RENDER_ENGINE S_SceneFileView {
+	public:
+		static constexpr uint32_t FORMAT_VERSION = 1;
+		static constexpr uint32_t BLOB_ALIGNMENT = 64;
+
+		// Validates the header, the section table and the mesh, program and BVH records, in
+		// time independent of the geometry size; false leaves the view empty. bytes must be
+		// BLOB_ALIGNMENT aligned, as mapped files are.
+		static bool parse(std::span<const std::byte> bytes, S_SceneFileView& view);
+
+		// Also checks every triangle, sphere and BVH node refers to data in the file, for files
+		// from untrusted sources. Linear in the file size.
+		[[nodiscard]] bool verifyContents() const;
+
+		[[nodiscard]] bool isValid() const;
+		[[nodiscard]] std::span<const std::byte> getBytes() const;
+		[[nodiscard]] std::span<const std::byte> getSection(E_SceneSection section) const;
+
+		[[nodiscard]] std::span<const S_SurfaceMaterial> getMaterials() const;
+		[[nodiscard]] std::span<const S_Sphere> getSpheres() const;
+		[[nodiscard]] std::span<const core::math::S_Vec3> getVertices() const;
+		[[nodiscard]] std::span<const S_Triangle> getTriangles() const;
+		[[nodiscard]] core::math::S_Vec3 getSkyHorizon() const;
+		[[nodiscard]] core::math::S_Vec3 getSkyZenith() const;
+		[[nodiscard]] core::math::S_Aabb getBounds() const;
+
+		[[nodiscard]] uint32_t getMeshCount() const;
+		[[nodiscard]] S_SceneMesh getMesh(uint32_t mesh) const;
+
+		// Over the scene's triangles then spheres, as S_Scene numbers primitives; empty when the
+		// file was written without one
+		[[nodiscard]] S_BvhView getBvh() const;
+
+		[[nodiscard]] uint32_t getProgramCount() const;
+		[[nodiscard]] S_SceneProgram getProgram(uint32_t program) const;
+
+		// Empty bytes when no program has the name
+		[[nodiscard]] S_SceneProgram findProgram(std::string_view name) const;
+
+	private:
+		friend class S_SceneFileWriter;
+
+		struct S_Header;
+		struct S_SectionEntry;
+		struct S_Info;
+		struct S_MeshRecord;
+		struct S_ProgramRecord;
+
+		std::span<const std::byte> bytes;
+		const S_Header* header = nullptr;
+
+		template<typename T>
+		std::span<const T> getArray(E_SceneSection section) const;
+	};
+
+	// Assembles a scene file from an S_Scene, its meshes and compiled materials
+	class SPEC_RENDER_ENGINE S_SceneFileWriter {
+	public:
+		// Geometry, materials, sky and, when built, the BVH of scene, which must outlive write()
+		void setScene(const S_Scene& scene);
+
+		// Ranges refer to the scene's triangles and vertices. A quantized mesh must have been
+		// encoded from exactly the vertex range. Returns the mesh index.
+		uint32_t addMesh(std::string_view name, uint32_t firstTriangle, uint32_t triangleCount, uint32_t firstVertex, uint32_t vertexCount,
+			uint32_t material, const S_QuantizedMesh* quantized = nullptr);
+
+		void addProgram(std::string_view name, std::span<const std::byte> bytes);
+
+		[[nodiscard]] std::vector<std::byte> write() const;
+
+		// Written to path + ".tmp" and renamed into place; false, with a WARNING, on failure
+		bool save(const std::string& path) const;
+
+	private:
+		struct S_PendingMesh {
+			std::string name;
+			uint32_t firstTriangle;
+			uint32_t triangleCount;
+			uint32_t firstVertex;
+			uint32_t vertexCount;
+			uint32_t material;
+			std::vector<S_PackedVertex> packedVertices;
+			core::math::S_Vec3 positionOffset;
+			core::math::S_Vec3 positionScale;
+			float uvOffset[2];
+			float uvScale[2];
+		};
+
+		struct S_PendingProgram {
+			std::string name;
+			std::vector<std::byte> bytes;
+		};
+
+		const S_Scene* scene = nullptr;
+		std::vector<S_PendingMesh> meshes;
+		std::vector<S_PendingProgram> programs;
+	};
+
+	// Scene file mapped read-only and used in place. Opening costs the mapping and parse(),
+	// pages are read as the data is touched.
+	class SPEC_RENDER_ENGINE S_SceneFile {
+	public:
+		// False, with a WARNING and getLastError(), when the file cannot be mapped or does not parse
+		bool open(const std::string& path);
+		void close();
+
+		[[nodiscard]] bool isOpen() const;
+		[[nodiscard]] const S_SceneFileView& getView() const;
+		[[nodiscard]] const std::string& getLastError() const;
+
+	private:
+		core::platform::S_MappedFile file;
+		S_SceneFileView view;
+		std::string lastError;
+	};
+}
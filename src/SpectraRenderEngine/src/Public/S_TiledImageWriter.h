@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+
+namespace spectra::render {
+	enum class SPEC_RENDER_ENGINE E_ImageFormat : uint8_t {
+		PFM = 0,  // Portable float map, scanlines bottom to top; tiles land in place by seeking
+		EXR       // OpenEXR, tiled, uncompressed 32-bit float B/G/R, tiles in any order
+	};
+
+	// Writes a linear RGB float image one tile at a time, in any order, so the full frame is
+	// never assembled in memory. Tiles lie on a grid of tileSize starting at the top left;
+	// edge tiles are clipped to the image.
+	// No external libraries: PFM is a header plus raw floats, and the OpenEXR writer emits the
+	// minimal single-part tiled layout (header, tile offset table, chunks) that any reader opens.
+	class SPEC_RENDER_ENGINE S_TiledImageWriter {
+		std::ofstream stream;
+		std::string path;
+		E_ImageFormat format = E_ImageFormat::EXR;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t tileSize = 0;
+		uint32_t tilesX = 0;
+		uint32_t tilesY = 0;
+		uint64_t dataStart = 0;                // PFM pixels or the EXR offset table
+		std::vector<uint64_t> chunkOffsets;    // EXR only, latest chunk of each tile
+		std::vector<uint8_t> tileWritten;
+		std::vector<char> scratch;
+		uint32_t tilesWritten = 0;
+
+	public:
+		S_TiledImageWriter() = default;
+		S_TiledImageWriter(const S_TiledImageWriter&) = delete;
+		S_TiledImageWriter& operator=(const S_TiledImageWriter&) = delete;
+		~S_TiledImageWriter();
+
+		// Creates or truncates path and writes the header
+		bool open(const std::string& filePath, E_ImageFormat imageFormat, uint32_t imageWidth, uint32_t imageHeight, uint32_t imageTileSize);
+
+		// rgb holds the tile's rows top to bottom, three floats per pixel. Writing a tile twice
+		// replaces it for PFM and appends a new chunk for EXR.
+		bool writeTile(uint32_t tileX, uint32_t tileY, std::span<const float> rgb);
+
+		// Finishes the file; for EXR this writes the offset table. Returns false if any tile is missing.
+		bool close();
+
+		[[nodiscard]] bool isOpen() const;
+		[[nodiscard]] E_ImageFormat getFormat() const;
+		[[nodiscard]] uint32_t getWidth() const;
+		[[nodiscard]] uint32_t getHeight() const;
+		[[nodiscard]] uint32_t getTileSize() const;
+		[[nodiscard]] uint32_t getTileCount() const;
+		[[nodiscard]] uint32_t getTilesWritten() const;
+
+		// EXR for ".exr", PFM otherwise
+		[[nodiscard]] static E_ImageFormat formatFromPath(const std::string& filePath);
+	};
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Aabb.h"
+#include "S_Bvh.h"
+#include "S_EntityWorld.h"
+#include "S_Transform.h"
+
+namespace spectra::render {
+	// Entity the local transform is relative to. Entities without one, or whose parent is gone
+	// or has no transform, are roots.
+	struct S_Parent {
+		core::ecs::S_Entity entity;
+	};
+
+	// Components S_TransformSystem registers in its world
+	struct S_TransformComponents {
+		core::ecs::S_ComponentType<core::math::S_Transform> local;
+		core::ecs::S_ComponentType<core::math::S_Transform> world;
+		core::ecs::S_ComponentType<S_Parent> parent;
+		core::ecs::S_ComponentType<core::math::S_Aabb> localBounds;
+		core::ecs::S_ComponentType<core::math::S_Aabb> worldBounds;
+
+		// What an entity needs to be placed, and to be placed and kept in the BVH
+		[[nodiscard]] core::ecs::ComponentMask placed() const { return local.mask() | world.mask(); }
+		[[nodiscard]] core::ecs::ComponentMask bounded() const { return placed() | localBounds.mask() | worldBounds.mask(); }
+	};
+
+	struct S_TransformSystemStats {
+		double updateMilliseconds = 0.0;
+		double hierarchyMilliseconds = 0.0;   // Rebuilding the level order, only after structural changes
+		double propagateMilliseconds = 0.0;
+		double bvhMilliseconds = 0.0;
+		uint32_t entityCount = 0;
+		uint32_t levelCount = 0;
+		uint32_t boundedCount = 0;
+		uint32_t dirtyCount = 0;              // World transforms recomputed by the last update
+		uint32_t dirtyBoundsCount = 0;
+		bool rebuiltHierarchy = false;
+		bool rebuiltBvh = false;
+	};
+
+	// Propagates local transforms down the parent hierarchy of an S_EntityWorld and keeps a
+	// BVH over world bounds. Entities are ordered by depth once per structural change; each
+	// level is then processed in parallel, parents before children. Only entities whose local
+	// transform or bounds changed since the last update, and their descendants, are
+	// recomputed, and the BVH refits only the paths above their bounds.
+	class SPEC_RENDER_ENGINE S_TransformSystem {
+	public:
+		// Registers the components in world, which must outlive the system
+		explicit S_TransformSystem(core::ecs::S_EntityWorld& world, const S_BvhBuildSettings& bvhSettings = {});
+
+		[[nodiscard]] const S_TransformComponents& getComponents() const;
+
+		void update();
+
+		[[nodiscard]] const S_Bvh& getBvh() const;
+
+		// Entity of each BVH primitive
+		[[nodiscard]] std::span<const core::ecs::S_Entity> getBvhEntities() const;
+
+		[[nodiscard]] const S_TransformSystemStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::render::transforms"
+		void publishStats() const;
+
+	private:
+		core::ecs::S_EntityWorld* world;
+		S_TransformComponents components;
+		S_BvhBuildSettings bvhSettings;
+		uint32_t seenVersion = 0;
+
+		// Slots in depth order: level l is [levelOffsets[l], levelOffsets[l + 1]). Component
+		// pointers stay valid until the next structural change, which rebuilds them.
+		std::vector<core::ecs::S_Entity> entities;
+		std::vector<uint32_t> parentSlots;
+		std::vector<uint32_t> primitiveSlots;    // Per slot, the BVH primitive or NO_SLOT
+		std::vector<uint32_t> levelOffsets;
+		std::vector<uint32_t> slotOfEntity;      // By S_Entity::index
+		std::vector<const core::math::S_Transform*> localTransforms;
+		std::vector<core::math::S_Transform*> worldTransforms;
+		std::vector<const core::math::S_Aabb*> localBounds;
+		std::vector<core::math::S_Aabb*> worldBounds;
+		std::vector<uint8_t> dirty;
+
+		S_Bvh bvh;
+		std::vector<core::ecs::S_Entity> bvhEntities;
+		std::vector<core::math::S_Aabb> primitiveBounds;
+		std::vector<uint8_t> dirtyPrimitives;
+		std::vector<core::ecs::S_ChunkView> chunks;
+		S_TransformSystemStats stats;
+
+		void rebuildHierarchy();
+	};
+}
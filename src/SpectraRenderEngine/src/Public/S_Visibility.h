@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "SpectraRenderEngine.h"
+#include "S_Aabb.h"
+#include "S_RayStream.h"
+#include "S_Vec3.h"
+
+namespace spectra::render {
+	// Camera as the culling passes see it. Clip space follows the ray camera's conventions: x
+	// right, y up, depth z / w from 0 at the near plane to 1 at the far plane.
+	struct SPEC_RENDER_ENGINE S_CullingView {
+		float clip[4][4] = {};    // Row-major world to clip transform
+		float planes[6][4] = {};  // Left, right, bottom, top, near, far; inside where a * x + b * y + c * z + d >= 0, unit normals
+		core::math::S_Vec3 position;
+		float nearPlane = 0.0f;
+		float farPlane = 0.0f;
+
+		[[nodiscard]] static S_CullingView perspective(const core::math::S_Vec3& position, const core::math::S_Vec3& target,
+			const core::math::S_Vec3& up, float verticalFovDegrees, float aspectRatio, float nearPlane, float farPlane);
+	};
+
+	// Bounds in structure-of-arrays form, the layout the culling kernels stream through
+	struct SPEC_RENDER_ENGINE S_CullingBoxes {
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+
+		void push(const core::math::S_Aabb& box);
+		void clear();
+		[[nodiscard]] size_t size() const;
+		[[nodiscard]] core::math::S_Aabb get(size_t index) const;
+	};
+
+	struct SPEC_RENDER_ENGINE S_CullingSpheres {
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> radius;
+
+		void push(const core::math::S_Vec3& center, float sphereRadius);
+		void clear();
+		[[nodiscard]] size_t size() const;
+	};
+
+	// Frustum tests over whole arrays of bounds, split into blocks for the job system. The
+	// result lists the indices of everything that may intersect the frustum, in ascending
+	// order; every level keeps exactly the same indices.
+	class SPEC_RENDER_ENGINE S_FrustumCuller {
+	public:
+		static void cullBoxes(const S_CullingView& view, const S_CullingBoxes& boxes, std::vector<uint32_t>& visible,
+			E_SimdLevel level = E_SimdLevel::BEST);
+
+		static void cullSpheres(const S_CullingView& view, const S_CullingSpheres& spheres, std::vector<uint32_t>& visible,
+			E_SimdLevel level = E_SimdLevel::BEST);
+	};
+
+	// Masked occlusion tile (Hasselgren et al. 2016): pixels set in mask are covered by the
+	// working layer, which is no farther than zMax1; the whole tile is covered no farther than zMax0.
+	struct S_OcclusionTile {
+		uint32_t mask = 0;
+		float zMax0 = 1.0f;
+		float zMax1 = 0.0f;
+	};
+
+	struct S_OcclusionSettings {
+		uint32_t width = 320;   // Rounded up to whole tiles
+		uint32_t height = 192;
+	};
+
+	struct S_OcclusionStats {
+		double rasterMilliseconds = 0.0;   // Setup and rasterization, summed over renderOccluders() since begin()
+		double testMilliseconds = 0.0;     // Of the last cullBoxes()
+		uint32_t occluderTriangles = 0;
+		uint32_t rasterizedTriangles = 0;  // After near clipping and dropping degenerate and off-screen ones
+		uint32_t testedCount = 0;
+		uint32_t occludedCount = 0;
+	};
+
+	struct S_OcclusionScratch;
+
+	// Low resolution depth buffer for culling against large occluders, in the style of masked
+	// software occlusion culling. Each 8x4 pixel tile keeps a coverage mask and two conservative
+	// depths instead of per-pixel depth, so triangles are rasterized a tile row per SIMD step.
+	// Occluders are clipped against the near plane only and binned into bands of tile rows that
+	// rasterize in parallel, each in submission order, which keeps the result deterministic.
+	// Bounds are then tested conservatively: a box is hidden only if its nearest depth lies
+	// behind every tile its screen rectangle touches.
+	class SPEC_RENDER_ENGINE S_OcclusionBuffer {
+	public:
+		static constexpr uint32_t TILE_WIDTH = 8;
+		static constexpr uint32_t TILE_HEIGHT = 4;
+
+		explicit S_OcclusionBuffer(const S_OcclusionSettings& settings = {});
+		~S_OcclusionBuffer();
+
+		S_OcclusionBuffer(const S_OcclusionBuffer&) = delete;
+		S_OcclusionBuffer& operator=(const S_OcclusionBuffer&) = delete;
+
+		// Clears the buffer for a new view
+		void begin(const S_CullingView& view);
+
+		// Rasterizes the indexed triangles, three indices each, as occluders. Can be called
+		// several times per view; AVX512 uses the AVX2 kernel.
+		void renderOccluders(std::span<const core::math::S_Vec3> positions, std::span<const uint32_t> indices,
+			E_SimdLevel level = E_SimdLevel::BEST);
+
+		// False when the box is off screen or hidden. Boxes crossing the near plane are visible.
+		[[nodiscard]] bool isVisible(const core::math::S_Aabb& box) const;
+
+		// Writes the candidates that pass isVisible(), in their order, on the job system
+		void cullBoxes(const S_CullingBoxes& boxes, std::span<const uint32_t> candidates, std::vector<uint32_t>& visible) const;
+
+		// Conservative depth per pixel, row-major, for inspecting the buffer
+		void resolveDepth(std::vector<float>& depth) const;
+
+		[[nodiscard]] uint32_t getWidth() const;
+		[[nodiscard]] uint32_t getHeight() const;
+		[[nodiscard]] const S_OcclusionStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::render::visibility"
+		void publishStats() const;
+
+	private:
+		uint32_t tilesPerRow = 0;
+		uint32_t tileRows = 0;
+		S_CullingView view;
+		std::vector<S_OcclusionTile> tiles;
+		std::unique_ptr<S_OcclusionScratch> scratch;  // Setup buffers kept between calls
+		mutable S_OcclusionStats stats;
+	};
+}
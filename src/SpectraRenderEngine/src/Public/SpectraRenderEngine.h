@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPEC_RENDER_ENGINE
+#if defined(_WIN32)
 #define SPEC_RENDER_ENGINE __declspec(dllexport)
+#else
+#define SPEC_RENDER_ENGINE __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPEC_RENDER_ENGINE SpectraRenderEngineInit();
\ No newline at end of file
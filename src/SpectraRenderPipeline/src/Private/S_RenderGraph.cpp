@@ -0,0 +1,932 @@
+#include "S_RenderGraph.h"
+#include "S_JobSystem.h"
+#include "S_LinearArena.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+namespace spectra::pipeline {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::pipeline::rendergraph";
+
+		// Barrier slots within a pass: aliasing before transitions, end barriers after the pass
+		constexpr uint32_t SLOT_ALIASING = 0;
+		constexpr uint32_t SLOT_TRANSITION = 1;
+		constexpr uint32_t SLOT_END = 2;
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		bool isWithin(E_ResourceAccess access, E_ResourceAccess mask) {
+			return (static_cast<uint32_t>(access) & ~static_cast<uint32_t>(mask)) == 0;
+		}
+
+		bool isSingleWrite(E_ResourceAccess access) {
+			return isWithin(access, WRITE_ACCESS_MASK) && std::has_single_bit(static_cast<uint32_t>(access));
+		}
+
+		uint64_t getAlignment(const S_TextureDesc& desc) {
+			return desc.sampleCount > 1 ? MSAA_RESOURCE_ALIGNMENT : RESOURCE_ALIGNMENT;
+		}
+	}
+
+	// S_RenderPassContext implementations
+	S_ResourceHandle S_RenderPassContext::getResource(S_RenderGraphResource resource) const {
+		return graph->getDeviceResource(resource);
+	}
+
+	// S_RenderPassBuilder implementations
+	S_RenderPassBuilder::S_RenderPassBuilder(S_RenderGraph& graph, uint32_t pass) : graph(&graph), pass(pass) {
+	}
+
+	S_RenderPassBuilder& S_RenderPassBuilder::read(S_RenderGraphResource resource, E_ResourceAccess access) {
+		graph->addAccess(pass, resource, access, false);
+		return *this;
+	}
+
+	S_RenderPassBuilder& S_RenderPassBuilder::write(S_RenderGraphResource resource, E_ResourceAccess access) {
+		graph->addAccess(pass, resource, access, true);
+		return *this;
+	}
+
+	S_RenderPassBuilder& S_RenderPassBuilder::setSideEffects() {
+		graph->passes[pass].sideEffects = true;
+		graph->compiled = false;
+		return *this;
+	}
+
+	uint32_t S_RenderPassBuilder::getPass() const {
+		return pass;
+	}
+
+	// S_RenderGraph implementations
+	S_RenderGraph::S_RenderGraph(const S_RenderGraphSettings& settings) : settings(settings) {
+	}
+
+	S_RenderGraphResource S_RenderGraph::createTexture(std::string name, const S_TextureDesc& desc) {
+		S_ResourceNode node;
+		node.name = std::move(name);
+		node.kind = E_ResourceKind::TEXTURE;
+		node.texture = desc;
+		return addResource(std::move(node));
+	}
+
+	S_RenderGraphResource S_RenderGraph::createBuffer(std::string name, const S_BufferDesc& desc) {
+		S_ResourceNode node;
+		node.name = std::move(name);
+		node.kind = E_ResourceKind::BUFFER;
+		node.buffer = desc;
+		return addResource(std::move(node));
+	}
+
+	S_RenderGraphResource S_RenderGraph::importTexture(std::string name, const S_TextureDesc& desc, E_ResourceAccess initialAccess,
+		E_ResourceAccess finalAccess, S_ResourceHandle handle) {
+		S_ResourceNode node;
+		node.name = std::move(name);
+		node.kind = E_ResourceKind::TEXTURE;
+		node.texture = desc;
+		node.initialAccess = initialAccess;
+		node.finalAccess = finalAccess;
+		node.handle = handle;
+		node.imported = true;
+		node.output = true;
+		return addResource(std::move(node));
+	}
+
+	S_RenderGraphResource S_RenderGraph::importBuffer(std::string name, const S_BufferDesc& desc, E_ResourceAccess initialAccess,
+		E_ResourceAccess finalAccess, S_ResourceHandle handle) {
+		S_ResourceNode node;
+		node.name = std::move(name);
+		node.kind = E_ResourceKind::BUFFER;
+		node.buffer = desc;
+		node.initialAccess = initialAccess;
+		node.finalAccess = finalAccess;
+		node.handle = handle;
+		node.imported = true;
+		node.output = true;
+		return addResource(std::move(node));
+	}
+
+	void S_RenderGraph::markOutput(S_RenderGraphResource resource) {
+		if (resource.index >= resources.size()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_RenderGraph", "markOutput",
+				"Unknown resource", resource.index);
+		}
+		resources[resource.index].output = true;
+		compiled = false;
+	}
+
+	S_RenderPassBuilder S_RenderGraph::addPass(std::string name, E_QueueType queue, RenderPassFunction execute) {
+		S_PassNode node;
+		node.name = std::move(name);
+		node.queue = queue;
+		node.execute = std::move(execute);
+		passes.push_back(std::move(node));
+		compiled = false;
+		return S_RenderPassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+	}
+
+	S_RenderGraphResource S_RenderGraph::addResource(S_ResourceNode node) {
+		resources.push_back(std::move(node));
+		compiled = false;
+		return { static_cast<uint32_t>(resources.size() - 1) };
+	}
+
+	void S_RenderGraph::addAccess(uint32_t pass, S_RenderGraphResource resource, E_ResourceAccess access, bool write) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (resource.index >= resources.size()) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_RenderGraph", "addAccess", "Unknown resource", passes[pass].name, resource.index);
+		}
+		const bool valid = write ? isSingleWrite(access)
+			: access != E_ResourceAccess::NONE && (isWithin(access, READ_ACCESS_MASK) || isSingleWrite(access));
+		if (!valid) {
+			Instrumentation::logRender(E_LogLevel::ERROR, "S_RenderGraph", "addAccess", write
+				? "Writes need exactly one write flag" : "Reads need read flags or a single write flag",
+				passes[pass].name, resources[resource.index].name, static_cast<uint32_t>(access));
+		}
+		if (!isWithin(access, getQueueAccessMask(passes[pass].queue))) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_RenderGraph", "addAccess", "Access not supported by the pass's queue",
+				passes[pass].name, resources[resource.index].name, static_cast<uint32_t>(access));
+		}
+		accesses.push_back({ pass, resource.index, access, !write, write });
+		compiled = false;
+	}
+
+	void S_RenderGraph::compile() {
+		const auto start = std::chrono::steady_clock::now();
+
+		mergeAccesses();
+		cullPasses();
+		orderPasses();
+		schedule();
+		placeResources();
+		buildBarriers();
+
+		stats = {};
+		stats.passes = static_cast<uint32_t>(passes.size());
+		stats.culledPasses = static_cast<uint32_t>(passes.size() - compiledPasses.size());
+		stats.resources = static_cast<uint32_t>(resources.size());
+		for (size_t index = 0; index < resources.size(); ++index) {
+			if (!resources[index].imported && placements[index].used) {
+				++stats.transientResources;
+				stats.transientBytes += placements[index].size;
+			}
+		}
+		for (uint64_t size : heapSizes) {
+			stats.heapBytes += size;
+		}
+		stats.barriers = static_cast<uint32_t>(barriers.size() + finalBarriers.size());
+		stats.barrierBatches = finalBarriers.empty() ? 0 : 1;
+		for (const S_CompiledPass& compiledPass : compiledPasses) {
+			stats.barrierBatches += (compiledPass.barrierCount ? 1 : 0) + (compiledPass.endBarrierCount ? 1 : 0);
+			stats.queueSignals += compiledPass.signalValue ? 1 : 0;
+		}
+		stats.queueWaits = static_cast<uint32_t>(waits.size() + finalWaits.size());
+		stats.compileMilliseconds = millisecondsSince(start);
+		compiled = true;
+
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "compile", stats.compileMilliseconds);
+	}
+
+	void S_RenderGraph::mergeAccesses() {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		std::stable_sort(accesses.begin(), accesses.end(), [](const S_PassAccess& a, const S_PassAccess& b) {
+			return a.pass != b.pass ? a.pass < b.pass : a.resource < b.resource;
+			});
+
+		size_t count = 0;
+		for (size_t index = 0; index < accesses.size();) {
+			S_PassAccess merged = accesses[index];
+			for (++index; index < accesses.size() && accesses[index].pass == merged.pass && accesses[index].resource == merged.resource; ++index) {
+				merged.access = merged.access | accesses[index].access;
+				merged.reads |= accesses[index].reads;
+				merged.writes |= accesses[index].writes;
+			}
+
+			// A resource is in one state during a pass: the write state if there is one, else every read state
+			const uint32_t writeFlags = static_cast<uint32_t>(merged.access & WRITE_ACCESS_MASK);
+			if (writeFlags && !isWithin(merged.access, static_cast<E_ResourceAccess>(writeFlags & (~writeFlags + 1)))) {
+				Instrumentation::logRender(E_LogLevel::WARNING, "S_RenderGraph", "compile",
+					"Pass uses a resource in conflicting states; keeping its first write state",
+					passes[merged.pass].name, resources[merged.resource].name, static_cast<uint32_t>(merged.access));
+				merged.access = static_cast<E_ResourceAccess>(writeFlags & (~writeFlags + 1));
+			}
+			accesses[count++] = merged;
+		}
+		accesses.resize(count);
+
+		passAccessStart.assign(passes.size() + 1, 0);
+		for (const S_PassAccess& access : accesses) {
+			++passAccessStart[access.pass + 1];
+		}
+		for (size_t pass = 0; pass < passes.size(); ++pass) {
+			passAccessStart[pass + 1] += passAccessStart[pass];
+		}
+	}
+
+	void S_RenderGraph::cullPasses() {
+		// Walk backwards from the outputs: a pass lives if it writes something still needed,
+		// its write ends that need, and its reads start new ones
+		std::vector<uint8_t> needed(resources.size());
+		for (size_t index = 0; index < resources.size(); ++index) {
+			needed[index] = resources[index].output ? 1 : 0;
+		}
+
+		for (size_t pass = passes.size(); pass-- > 0;) {
+			const uint32_t begin = passAccessStart[pass];
+			const uint32_t end = passAccessStart[pass + 1];
+
+			bool live = !settings.cullPasses || passes[pass].sideEffects;
+			for (uint32_t index = begin; index < end && !live; ++index) {
+				live = accesses[index].writes && needed[accesses[index].resource];
+			}
+			passes[pass].live = live;
+			if (!live) {
+				continue;
+			}
+			for (uint32_t index = begin; index < end; ++index) {
+				if (accesses[index].writes) {
+					needed[accesses[index].resource] = 0;
+				}
+			}
+			for (uint32_t index = begin; index < end; ++index) {
+				if (accesses[index].reads) {
+					needed[accesses[index].resource] = 1;
+				}
+			}
+		}
+	}
+
+	void S_RenderGraph::orderPasses() {
+		compiledPasses.clear();
+		queuePositions.clear();
+		for (std::vector<uint32_t>& queue : queuePasses) {
+			queue.clear();
+		}
+		for (uint32_t pass = 0; pass < passes.size(); ++pass) {
+			if (!passes[pass].live) {
+				continue;
+			}
+			S_CompiledPass compiledPass;
+			compiledPass.pass = pass;
+			compiledPass.queue = settings.asyncQueues ? passes[pass].queue : E_QueueType::GRAPHICS;
+			std::vector<uint32_t>& queue = queuePasses[static_cast<uint32_t>(compiledPass.queue)];
+			queuePositions.push_back(static_cast<uint32_t>(queue.size()));
+			queue.push_back(static_cast<uint32_t>(compiledPasses.size()));
+			compiledPasses.push_back(compiledPass);
+		}
+
+		// Group the uses per resource, keeping submission order within each group
+		resourceUseStart.assign(resources.size() + 1, 0);
+		for (const S_CompiledPass& compiledPass : compiledPasses) {
+			for (uint32_t index = passAccessStart[compiledPass.pass]; index < passAccessStart[compiledPass.pass + 1]; ++index) {
+				++resourceUseStart[accesses[index].resource + 1];
+			}
+		}
+		for (size_t resource = 0; resource < resources.size(); ++resource) {
+			resourceUseStart[resource + 1] += resourceUseStart[resource];
+		}
+		resourceUses.resize(resourceUseStart.back());
+
+		QueueClock none;
+		none.fill(INVALID_INDEX);
+		lastUses.assign(resources.size(), none);
+		std::vector<uint32_t> next(resourceUseStart.begin(), resourceUseStart.end() - 1);
+		for (uint32_t compiledPass = 0; compiledPass < compiledPasses.size(); ++compiledPass) {
+			const uint32_t pass = compiledPasses[compiledPass].pass;
+			for (uint32_t index = passAccessStart[pass]; index < passAccessStart[pass + 1]; ++index) {
+				const uint32_t resource = accesses[index].resource;
+				resourceUses[next[resource]++] = { compiledPass, index };
+				lastUses[resource][static_cast<uint32_t>(compiledPasses[compiledPass].queue)] = compiledPass;
+			}
+		}
+	}
+
+	bool S_RenderGraph::happensBefore(uint32_t compiledBefore, uint32_t compiledAfter) const {
+		if (compiledBefore == compiledAfter) {
+			return false;
+		}
+		const uint32_t queue = static_cast<uint32_t>(compiledPasses[compiledBefore].queue);
+		if (queue == static_cast<uint32_t>(compiledPasses[compiledAfter].queue)) {
+			return compiledBefore < compiledAfter;
+		}
+		return queuePositions[compiledBefore] < passClocks[compiledAfter][queue];
+	}
+
+	bool S_RenderGraph::isReleasedBefore(uint32_t resource, uint32_t compiledPass) const {
+		for (uint32_t lastUse : lastUses[resource]) {
+			if (lastUse != INVALID_INDEX && !happensBefore(lastUse, compiledPass)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void S_RenderGraph::schedule() {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		struct S_ResourceTrack {
+			E_ResourceAccess state = E_ResourceAccess::NONE;
+			uint32_t writerUse = INVALID_INDEX;       // Last use that wrote
+			uint32_t transitionUse = 0;               // First use in the current state
+			uint32_t transitionPass = INVALID_INDEX;  // Compiled pass recording the transition into it
+			uint32_t nextUse = 0;
+		};
+		std::vector<S_ResourceTrack> tracks(resources.size());
+		for (size_t resource = 0; resource < resources.size(); ++resource) {
+			tracks[resource].state = resources[resource].imported ? resources[resource].initialAccess : E_ResourceAccess::NONE;
+			tracks[resource].transitionUse = resourceUseStart[resource];
+			tracks[resource].nextUse = resourceUseStart[resource];
+		}
+
+		passClocks.resize(compiledPasses.size());
+		waits.clear();
+		finalWaits.clear();
+		pendingBarriers.clear();
+		std::array<QueueClock, QUEUE_TYPE_COUNT> queueClocks{};
+		std::vector<uint32_t> dependencies;
+
+		const auto queueOf = [&](uint32_t compiledPass) { return static_cast<uint32_t>(compiledPasses[compiledPass].queue); };
+		const auto dependOnUses = [&](uint32_t begin, uint32_t end) {
+			for (uint32_t use = begin; use < end; ++use) {
+				dependencies.push_back(resourceUses[use].compiledPass);
+			}
+		};
+
+		// Waits for the latest dependency on each other queue, skipping those another wait already implies
+		const auto addWaits = [&](uint32_t queue, QueueClock& clock, std::vector<S_QueueWait>& out) {
+			std::array<uint32_t, QUEUE_TYPE_COUNT> need{};
+			for (uint32_t dependency : dependencies) {
+				const uint32_t dependencyQueue = queueOf(dependency);
+				if (dependencyQueue != queue) {
+					need[dependencyQueue] = std::max(need[dependencyQueue], queuePositions[dependency] + 1);
+				}
+			}
+			std::array<uint32_t, QUEUE_TYPE_COUNT> signaller;
+			signaller.fill(INVALID_INDEX);
+			for (uint32_t other = 0; other < QUEUE_TYPE_COUNT; ++other) {
+				if (need[other] > clock[other]) {
+					signaller[other] = queuePasses[other][need[other] - 1];
+				}
+			}
+			for (uint32_t other = 0; other < QUEUE_TYPE_COUNT; ++other) {
+				if (signaller[other] == INVALID_INDEX) {
+					continue;
+				}
+				bool implied = false;
+				for (uint32_t via = 0; via < QUEUE_TYPE_COUNT && !implied; ++via) {
+					implied = via != other && signaller[via] != INVALID_INDEX && passClocks[signaller[via]][other] >= need[other];
+				}
+				if (!implied) {
+					compiledPasses[signaller[other]].signalValue = need[other];
+					out.push_back({ static_cast<E_QueueType>(other), need[other] });
+				}
+			}
+			for (uint32_t other = 0; other < QUEUE_TYPE_COUNT; ++other) {
+				if (signaller[other] != INVALID_INDEX) {
+					for (uint32_t known = 0; known < QUEUE_TYPE_COUNT; ++known) {
+						clock[known] = std::max(clock[known], passClocks[signaller[other]][known]);
+					}
+					clock[other] = std::max(clock[other], need[other]);
+				}
+			}
+		};
+
+		for (uint32_t compiledPass = 0; compiledPass < compiledPasses.size(); ++compiledPass) {
+			S_CompiledPass& current = compiledPasses[compiledPass];
+			const uint32_t queue = static_cast<uint32_t>(current.queue);
+			const uint32_t pass = current.pass;
+			dependencies.clear();
+
+			for (uint32_t index = passAccessStart[pass]; index < passAccessStart[pass + 1]; ++index) {
+				const S_PassAccess& access = accesses[index];
+				const uint32_t resource = access.resource;
+				const uint32_t firstUse = resourceUseStart[resource];
+				const uint32_t lastUse = resourceUseStart[resource + 1];
+				S_ResourceTrack& track = tracks[resource];
+				const uint32_t use = track.nextUse++;
+
+				if (access.reads && track.writerUse == INVALID_INDEX && !resources[resource].imported) {
+					Instrumentation::logRender(E_LogLevel::WARNING, "S_RenderGraph", "compile", "Pass reads a transient no earlier pass writes",
+						passes[pass].name, resources[resource].name);
+				}
+
+				// Data hazards: a write follows the last write and every read since, a read follows the last write
+				if (access.writes) {
+					dependOnUses(track.writerUse != INVALID_INDEX ? track.writerUse : firstUse, use);
+				}
+				else if (track.writerUse != INVALID_INDEX) {
+					dependencies.push_back(resourceUses[track.writerUse].compiledPass);
+				}
+				if (track.transitionPass != INVALID_INDEX) {
+					dependencies.push_back(track.transitionPass);
+				}
+
+				const E_ResourceAccess target = access.access;
+				if (target == track.state) {
+					// Unordered access needs its writes made visible even without a state change
+					const bool afterWrite = access.writes || track.writerUse + 1 == use;
+					if (target == E_ResourceAccess::UNORDERED_ACCESS && use > firstUse && afterWrite
+						&& queueOf(resourceUses[use - 1].compiledPass) == queue) {
+						S_Barrier barrier;
+						barrier.type = E_BarrierType::UAV;
+						barrier.resource = resource;
+						pendingBarriers.push_back({ compiledPass, SLOT_TRANSITION, barrier });
+					}
+				}
+				else if (!isWriteAccess(target) && !isWriteAccess(track.state) && track.state != E_ResourceAccess::NONE
+					&& isWithin(target, track.state)) {
+					// Already in a merged read state that covers this read
+				}
+				else {
+					// Everything using the old state must finish before it changes
+					dependOnUses(track.transitionUse, use);
+
+					uint32_t recordingPass = compiledPass;
+					uint32_t slot = SLOT_TRANSITION;
+					E_ResourceAccess mask = getQueueAccessMask(current.queue);
+					if (!isWithin(track.state, mask)) {
+						// The queue cannot leave this state; record the transition at the end of the previous
+						// use instead, if that queue can and every other use of the state is ordered before it
+						const uint32_t previous = use > firstUse ? resourceUses[use - 1].compiledPass : INVALID_INDEX;
+						bool movable = previous != INVALID_INDEX && isWithin(track.state, getQueueAccessMask(compiledPasses[previous].queue));
+						for (uint32_t other = track.transitionUse; movable && other + 1 < use; ++other) {
+							const uint32_t otherPass = resourceUses[other].compiledPass;
+							movable = otherPass == previous || happensBefore(otherPass, previous);
+						}
+						if (movable) {
+							recordingPass = previous;
+							slot = SLOT_END;
+							mask = getQueueAccessMask(compiledPasses[previous].queue);
+						}
+						else {
+							Instrumentation::logRender(E_LogLevel::WARNING, "S_RenderGraph", "compile",
+								"No queue can transition the resource out of its state; recording it on the pass's queue",
+								passes[pass].name, resources[resource].name, static_cast<uint32_t>(track.state));
+						}
+					}
+
+					// Reads until the next write share one transition into all their states
+					E_ResourceAccess after = target;
+					if (settings.mergeReadStates && !isWriteAccess(target)) {
+						for (uint32_t next = use + 1; next < lastUse; ++next) {
+							const S_PassAccess& nextAccess = accesses[resourceUses[next].access];
+							const E_ResourceAccess merged = after | nextAccess.access;
+							if (nextAccess.writes || isWriteAccess(nextAccess.access) || !isWithin(merged, mask)) {
+								break;
+							}
+							after = merged;
+						}
+					}
+
+					S_Barrier barrier;
+					barrier.type = E_BarrierType::TRANSITION;
+					barrier.resource = resource;
+					barrier.before = track.state;
+					barrier.after = after;
+					pendingBarriers.push_back({ recordingPass, slot, barrier });
+
+					track.state = after;
+					track.transitionUse = use;
+					track.transitionPass = recordingPass;
+				}
+				if (access.writes) {
+					track.writerUse = use;
+				}
+			}
+
+			// Same-queue order is kept by the queue and its barriers; other queues are waited on
+			QueueClock clock = queueClocks[queue];
+			clock[queue] = queuePositions[compiledPass];
+			current.firstWait = static_cast<uint32_t>(waits.size());
+			addWaits(queue, clock, waits);
+			current.waitCount = static_cast<uint32_t>(waits.size()) - current.firstWait;
+			passClocks[compiledPass] = clock;
+			queueClocks[queue] = clock;
+			queueClocks[queue][queue] = queuePositions[compiledPass] + 1;
+		}
+
+		// Imported resources end in their final access, on the graphics queue after every pass using them
+		finalStates.resize(resources.size());
+		finalBarriers.clear();
+		dependencies.clear();
+		for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+			finalStates[resource] = tracks[resource].state;
+			if (!resources[resource].imported || tracks[resource].state == resources[resource].finalAccess) {
+				continue;
+			}
+			S_Barrier barrier;
+			barrier.type = E_BarrierType::TRANSITION;
+			barrier.resource = resource;
+			barrier.before = tracks[resource].state;
+			barrier.after = resources[resource].finalAccess;
+			finalBarriers.push_back(barrier);
+			for (uint32_t lastUse : lastUses[resource]) {
+				if (lastUse != INVALID_INDEX) {
+					dependencies.push_back(lastUse);
+				}
+			}
+		}
+		QueueClock clock = queueClocks[static_cast<uint32_t>(E_QueueType::GRAPHICS)];
+		addWaits(static_cast<uint32_t>(E_QueueType::GRAPHICS), clock, finalWaits);
+	}
+
+	void S_RenderGraph::placeResources() {
+		placements.assign(resources.size(), {});
+		heapSizes.fill(0);
+
+		for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+			const S_ResourceNode& node = resources[resource];
+			S_ResourcePlacement& placement = placements[resource];
+			placement.imported = node.imported;
+			placement.used = resourceUseStart[resource] != resourceUseStart[resource + 1];
+			if (node.kind == E_ResourceKind::BUFFER) {
+				placement.category = E_HeapCategory::BUFFER;
+				placement.size = getBufferSize(node.buffer);
+			}
+			else {
+				placement.category = E_HeapCategory::TEXTURE;
+				placement.size = getTextureSize(node.texture);
+				for (uint32_t use = resourceUseStart[resource]; use < resourceUseStart[resource + 1]; ++use) {
+					if (hasAccess(accesses[resourceUses[use].access].access, E_ResourceAccess::RENDER_TARGET | E_ResourceAccess::DEPTH_WRITE)) {
+						placement.category = E_HeapCategory::RENDER_TARGET;
+					}
+				}
+			}
+			if (placement.used) {
+				placement.firstPass = resourceUses[resourceUseStart[resource]].compiledPass;
+				placement.lastPass = 0;
+				for (uint32_t lastUse : lastUses[resource]) {
+					placement.lastPass = lastUse != INVALID_INDEX ? std::max(placement.lastPass, lastUse) : placement.lastPass;
+				}
+			}
+		}
+
+		// Largest first, each at the lowest offset clear of every placed transient whose lifetime is
+		// not ordered before or after its own
+		std::vector<uint32_t> order;
+		for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+			if (!resources[resource].imported && placements[resource].used) {
+				order.push_back(resource);
+			}
+		}
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			return placements[a].size > placements[b].size;
+			});
+
+		std::array<std::vector<uint32_t>, HEAP_CATEGORY_COUNT> placed;
+		std::vector<uint32_t> conflicts;
+		for (uint32_t resource : order) {
+			S_ResourcePlacement& placement = placements[resource];
+			const uint32_t category = static_cast<uint32_t>(placement.category);
+			const uint64_t alignment = resources[resource].kind == E_ResourceKind::TEXTURE ? getAlignment(resources[resource].texture) : RESOURCE_ALIGNMENT;
+			uint64_t offset = 0;
+			if (settings.aliasMemory) {
+				conflicts.clear();
+				for (uint32_t other : placed[category]) {
+					if (!isReleasedBefore(other, placement.firstPass) && !isReleasedBefore(resource, placements[other].firstPass)) {
+						conflicts.push_back(other);
+					}
+				}
+				std::sort(conflicts.begin(), conflicts.end(), [&](uint32_t a, uint32_t b) {
+					return placements[a].offset < placements[b].offset;
+					});
+				for (uint32_t other : conflicts) {
+					if (offset + placement.size <= placements[other].offset) {
+						break;
+					}
+					offset = std::max(offset, alignUp(placements[other].offset + placements[other].size, alignment));
+				}
+			}
+			else {
+				offset = alignUp(heapSizes[category], alignment);
+			}
+			placement.offset = offset;
+			heapSizes[category] = std::max(heapSizes[category], offset + placement.size);
+			placed[category].push_back(resource);
+		}
+
+		// A transient taking over memory starts with an aliasing barrier against the latest previous owner
+		if (settings.aliasMemory) {
+			for (const std::vector<uint32_t>& category : placed) {
+				for (uint32_t resource : category) {
+					const S_ResourcePlacement& placement = placements[resource];
+					uint32_t previous = INVALID_INDEX;
+					for (uint32_t other : category) {
+						const S_ResourcePlacement& otherPlacement = placements[other];
+						const bool overlaps = other != resource && otherPlacement.offset < placement.offset + placement.size
+							&& placement.offset < otherPlacement.offset + otherPlacement.size;
+						if (overlaps && isReleasedBefore(other, placement.firstPass)
+							&& (previous == INVALID_INDEX || otherPlacement.lastPass > placements[previous].lastPass)) {
+							previous = other;
+						}
+					}
+					if (previous != INVALID_INDEX) {
+						S_Barrier barrier;
+						barrier.type = E_BarrierType::ALIASING;
+						barrier.resource = resource;
+						barrier.previousResource = previous;
+						pendingBarriers.push_back({ placement.firstPass, SLOT_ALIASING, barrier });
+					}
+				}
+			}
+		}
+	}
+
+	void S_RenderGraph::buildBarriers() {
+		std::stable_sort(pendingBarriers.begin(), pendingBarriers.end(), [](const S_PendingBarrier& a, const S_PendingBarrier& b) {
+			return a.compiledPass != b.compiledPass ? a.compiledPass < b.compiledPass : a.slot < b.slot;
+			});
+
+		barriers.clear();
+		size_t index = 0;
+		for (uint32_t compiledPass = 0; compiledPass < compiledPasses.size(); ++compiledPass) {
+			S_CompiledPass& current = compiledPasses[compiledPass];
+			current.firstBarrier = static_cast<uint32_t>(barriers.size());
+			for (; index < pendingBarriers.size() && pendingBarriers[index].compiledPass == compiledPass
+				&& pendingBarriers[index].slot != SLOT_END; ++index) {
+				barriers.push_back(pendingBarriers[index].barrier);
+			}
+			current.barrierCount = static_cast<uint32_t>(barriers.size()) - current.firstBarrier;
+			current.firstEndBarrier = static_cast<uint32_t>(barriers.size());
+			for (; index < pendingBarriers.size() && pendingBarriers[index].compiledPass == compiledPass; ++index) {
+				barriers.push_back(pendingBarriers[index].barrier);
+			}
+			current.endBarrierCount = static_cast<uint32_t>(barriers.size()) - current.firstEndBarrier;
+		}
+	}
+
+	void S_RenderGraph::execute() const {
+		if (!compiled) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::WARNING, "S_RenderGraph", "execute",
+				"Graph changed since the last compile; nothing executed");
+			return;
+		}
+		for (const S_CompiledPass& compiledPass : compiledPasses) {
+			const S_PassNode& node = passes[compiledPass.pass];
+			if (node.execute) {
+				node.execute({ this, compiledPass.pass, compiledPass.queue });
+			}
+		}
+	}
+
+	void S_RenderGraph::execute(I_RenderDevice& device) {
+		using instrumentation::Instrumentation;
+		using instrumentation::E_LogLevel;
+
+		if (!compiled) {
+			Instrumentation::logRender(E_LogLevel::WARNING, "S_RenderGraph", "execute", "Graph changed since the last compile; nothing executed");
+			return;
+		}
+		if (heapDevice != &device) {
+			releaseDeviceMemory();
+			heapDevice = &device;
+		}
+
+		// Heaps grow to the largest frame seen and are kept; placed resources are made per execute
+		for (uint32_t category = 0; category < HEAP_CATEGORY_COUNT; ++category) {
+			if (heapSizes[category] > heapCapacities[category]) {
+				if (heaps[category].isValid()) {
+					device.destroyHeap(heaps[category]);
+				}
+				heaps[category] = device.createHeap(static_cast<E_HeapCategory>(category), heapSizes[category]);
+				heapCapacities[category] = heapSizes[category];
+			}
+		}
+		deviceResources.assign(resources.size(), {});
+		for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+			const S_ResourceNode& node = resources[resource];
+			const S_ResourcePlacement& placement = placements[resource];
+			if (node.imported) {
+				if (placement.used && !node.handle.isValid()) {
+					Instrumentation::logRender(E_LogLevel::ERROR, "S_RenderGraph", "execute", "Imported resource has no device handle", node.name);
+				}
+				deviceResources[resource] = node.handle;
+			}
+			else if (placement.used) {
+				const S_HeapHandle heap = heaps[static_cast<uint32_t>(placement.category)];
+				deviceResources[resource] = node.kind == E_ResourceKind::BUFFER
+					? device.createPlacedBuffer(heap, placement.offset, node.buffer, node.name)
+					: device.createPlacedTexture(heap, placement.offset, node.texture, node.name);
+			}
+		}
+
+		const auto recordStart = std::chrono::steady_clock::now();
+		commandLists.assign(compiledPasses.size(), nullptr);
+		if (settings.parallelRecording) {
+			core::jobs::S_JobSystem::getInstance().parallelFor(0, compiledPasses.size(), [this, &device](size_t begin, size_t end) {
+				for (size_t compiledPass = begin; compiledPass < end; ++compiledPass) {
+					recordPass(device, static_cast<uint32_t>(compiledPass));
+				}
+				});
+		}
+		else {
+			for (uint32_t compiledPass = 0; compiledPass < compiledPasses.size(); ++compiledPass) {
+				recordPass(device, compiledPass);
+			}
+		}
+		stats.recordMilliseconds = millisecondsSince(recordStart);
+
+		// One submit per run of passes on a queue, cut before a pass that waits and after one that
+		// signals. Timeline values continue from what the device has signalled in earlier frames.
+		const auto submitStart = std::chrono::steady_clock::now();
+		std::array<uint64_t, QUEUE_TYPE_COUNT> base{};
+		for (uint32_t queue = 0; queue < QUEUE_TYPE_COUNT; ++queue) {
+			base[queue] = device.getSignaledValue(static_cast<E_QueueType>(queue));
+		}
+		std::array<std::vector<I_CommandList*>, QUEUE_TYPE_COUNT> batchLists;
+		std::array<std::vector<S_QueueWait>, QUEUE_TYPE_COUNT> batchWaits;
+		stats.submits = 0;
+		const auto flush = [&](uint32_t queue, uint64_t signalValue) {
+			if (batchLists[queue].empty() && batchWaits[queue].empty() && signalValue == 0) {
+				return;
+			}
+			device.submit(static_cast<E_QueueType>(queue), batchLists[queue], batchWaits[queue], signalValue ? base[queue] + signalValue : 0);
+			batchLists[queue].clear();
+			batchWaits[queue].clear();
+			++stats.submits;
+		};
+		const auto addWaits = [&](uint32_t queue, const S_QueueWait* first, uint32_t count) {
+			if (count && !batchLists[queue].empty()) {
+				flush(queue, 0);
+			}
+			for (uint32_t index = 0; index < count; ++index) {
+				const uint32_t other = static_cast<uint32_t>(first[index].queue);
+				batchWaits[queue].push_back({ first[index].queue, base[other] + first[index].value });
+			}
+		};
+
+		for (uint32_t compiledPass = 0; compiledPass < compiledPasses.size(); ++compiledPass) {
+			const S_CompiledPass& current = compiledPasses[compiledPass];
+			const uint32_t queue = static_cast<uint32_t>(current.queue);
+			addWaits(queue, waits.data() + current.firstWait, current.waitCount);
+			batchLists[queue].push_back(commandLists[compiledPass]);
+			if (current.signalValue) {
+				flush(queue, current.signalValue);
+			}
+		}
+		if (!finalBarriers.empty()) {
+			const uint32_t graphics = static_cast<uint32_t>(E_QueueType::GRAPHICS);
+			I_CommandList* commandList = device.beginCommandList(E_QueueType::GRAPHICS);
+			translateBarriers(*commandList, finalBarriers.data(), static_cast<uint32_t>(finalBarriers.size()));
+			commandList->close();
+			addWaits(graphics, finalWaits.data(), static_cast<uint32_t>(finalWaits.size()));
+			batchLists[graphics].push_back(commandList);
+		}
+		for (uint32_t queue = 0; queue < QUEUE_TYPE_COUNT; ++queue) {
+			flush(queue, 0);
+		}
+		stats.submitMilliseconds = millisecondsSince(submitStart);
+
+		// The device holds on to released resources until the submitted work has finished
+		for (uint32_t resource = 0; resource < resources.size(); ++resource) {
+			if (!resources[resource].imported && deviceResources[resource].isValid()) {
+				device.destroyResource(deviceResources[resource]);
+				deviceResources[resource] = {};
+			}
+		}
+
+		Instrumentation::recordTiming(STATS_CATEGORY, "record", stats.recordMilliseconds);
+		Instrumentation::recordTiming(STATS_CATEGORY, "submit", stats.submitMilliseconds);
+	}
+
+	void S_RenderGraph::recordPass(I_RenderDevice& device, uint32_t compiledPass) {
+		const S_CompiledPass& current = compiledPasses[compiledPass];
+		I_CommandList* commandList = device.beginCommandList(current.queue);
+		translateBarriers(*commandList, barriers.data() + current.firstBarrier, current.barrierCount);
+		const S_PassNode& node = passes[current.pass];
+		if (node.execute) {
+			node.execute({ this, current.pass, current.queue, commandList });
+		}
+		translateBarriers(*commandList, barriers.data() + current.firstEndBarrier, current.endBarrierCount);
+		commandList->close();
+		commandLists[compiledPass] = commandList;
+	}
+
+	void S_RenderGraph::translateBarriers(I_CommandList& commandList, const S_Barrier* first, uint32_t count) const {
+		if (count == 0) {
+			return;
+		}
+		core::memory::S_ScratchScope scratch;
+		S_ResourceBarrier* translated = scratch.allocateArray<S_ResourceBarrier>(count);
+		for (uint32_t index = 0; index < count; ++index) {
+			const S_Barrier& barrier = first[index];
+			translated[index] = { barrier.type, deviceResources[barrier.resource],
+				barrier.previousResource != INVALID_INDEX ? deviceResources[barrier.previousResource] : S_ResourceHandle{},
+				barrier.before, barrier.after };
+		}
+		commandList.barrier({ translated, count });
+	}
+
+	void S_RenderGraph::releaseDeviceMemory() {
+		if (heapDevice) {
+			for (S_HeapHandle& heap : heaps) {
+				if (heap.isValid()) {
+					heapDevice->destroyHeap(heap);
+				}
+				heap = {};
+			}
+		}
+		heapCapacities.fill(0);
+		heapDevice = nullptr;
+	}
+
+	void S_RenderGraph::reset() {
+		resources.clear();
+		passes.clear();
+		accesses.clear();
+		passAccessStart.clear();
+		compiledPasses.clear();
+		barriers.clear();
+		finalBarriers.clear();
+		waits.clear();
+		finalWaits.clear();
+		placements.clear();
+		heapSizes.fill(0);
+		stats = {};
+		compiled = false;
+	}
+
+	const std::vector<S_CompiledPass>& S_RenderGraph::getCompiledPasses() const {
+		return compiledPasses;
+	}
+
+	const std::vector<S_Barrier>& S_RenderGraph::getBarriers() const {
+		return barriers;
+	}
+
+	const std::vector<S_QueueWait>& S_RenderGraph::getWaits() const {
+		return waits;
+	}
+
+	const std::vector<S_Barrier>& S_RenderGraph::getFinalBarriers() const {
+		return finalBarriers;
+	}
+
+	const std::vector<S_QueueWait>& S_RenderGraph::getFinalWaits() const {
+		return finalWaits;
+	}
+
+	const S_ResourcePlacement& S_RenderGraph::getPlacement(S_RenderGraphResource resource) const {
+		if (resource.index >= placements.size()) {
+			instrumentation::Instrumentation::logRender(instrumentation::E_LogLevel::ERROR, "S_RenderGraph", "getPlacement",
+				"Unknown resource or graph not compiled", resource.index);
+		}
+		return placements[resource.index];
+	}
+
+	S_ResourceHandle S_RenderGraph::getDeviceResource(S_RenderGraphResource resource) const {
+		return resource.index < deviceResources.size() ? deviceResources[resource.index] : S_ResourceHandle{};
+	}
+
+	uint64_t S_RenderGraph::getHeapSize(E_HeapCategory category) const {
+		return heapSizes[static_cast<uint32_t>(category)];
+	}
+
+	bool S_RenderGraph::isPassCulled(uint32_t pass) const {
+		return !passes.at(pass).live;
+	}
+
+	const std::string& S_RenderGraph::getPassName(uint32_t pass) const {
+		return passes.at(pass).name;
+	}
+
+	const std::string& S_RenderGraph::getResourceName(S_RenderGraphResource resource) const {
+		return resources.at(resource.index).name;
+	}
+
+	const S_RenderGraphSettings& S_RenderGraph::getSettings() const {
+		return settings;
+	}
+
+	const S_RenderGraphStats& S_RenderGraph::getStats() const {
+		return stats;
+	}
+
+	void S_RenderGraph::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "passes", static_cast<double>(stats.passes));
+		Instrumentation::setGauge(STATS_CATEGORY, "culledPasses", static_cast<double>(stats.culledPasses));
+		Instrumentation::setGauge(STATS_CATEGORY, "resources", static_cast<double>(stats.resources));
+		Instrumentation::setGauge(STATS_CATEGORY, "transientResources", static_cast<double>(stats.transientResources));
+		Instrumentation::setGauge(STATS_CATEGORY, "transientBytes", static_cast<double>(stats.transientBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "heapBytes", static_cast<double>(stats.heapBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "barriers", static_cast<double>(stats.barriers));
+		Instrumentation::setGauge(STATS_CATEGORY, "barrierBatches", static_cast<double>(stats.barrierBatches));
+		Instrumentation::setGauge(STATS_CATEGORY, "queueWaits", static_cast<double>(stats.queueWaits));
+		Instrumentation::setGauge(STATS_CATEGORY, "queueSignals", static_cast<double>(stats.queueSignals));
+		Instrumentation::setGauge(STATS_CATEGORY, "compileMilliseconds", stats.compileMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "submits", static_cast<double>(stats.submits));
+		Instrumentation::setGauge(STATS_CATEGORY, "recordMilliseconds", stats.recordMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "submitMilliseconds", stats.submitMilliseconds);
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SpectraRenderPipeline.h"
+#include "S_RenderTypes.h"
+
+namespace spectra::pipeline {
+	// Buffers and textures share one handle space; the device knows which is which
+	struct S_ResourceHandle {
+		uint32_t index = INVALID_INDEX;
+
+		[[nodiscard]] bool isValid() const { return index != INVALID_INDEX; }
+		[[nodiscard]] bool operator==(const S_ResourceHandle&) const = default;
+	};
+
+	struct S_HeapHandle {
+		uint32_t index = INVALID_INDEX;
+
+		[[nodiscard]] bool isValid() const { return index != INVALID_INDEX; }
+	};
+
+	struct S_PipelineHandle {
+		uint32_t index = INVALID_INDEX;
+
+		[[nodiscard]] bool isValid() const { return index != INVALID_INDEX; }
+	};
+
+	enum class SPEC_RENDER_PIPELINE E_PipelineType : uint8_t {
+		GRAPHICS = 0,
+		COMPUTE
+	};
+
+	struct S_PipelineDesc {
+		std::string name;
+		E_PipelineType type = E_PipelineType::GRAPHICS;
+		std::vector<E_Format> renderTargetFormats;
+		E_Format depthFormat = E_Format::UNKNOWN;
+		uint32_t constantCount = 0;  // 32-bit root or push constants
+	};
+
+	struct S_Viewport {
+		float x = 0.0f;
+		float y = 0.0f;
+		float width = 0.0f;
+		float height = 0.0f;
+		float minDepth = 0.0f;
+		float maxDepth = 1.0f;
+	};
+
+	struct S_Rect {
+		int32_t x = 0;
+		int32_t y = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	// S_Barrier with device handles in place of graph resources
+	struct S_ResourceBarrier {
+		E_BarrierType type = E_BarrierType::TRANSITION;
+		S_ResourceHandle resource;
+		S_ResourceHandle previousResource;
+		E_ResourceAccess before = E_ResourceAccess::NONE;
+		E_ResourceAccess after = E_ResourceAccess::NONE;
+	};
+
+	// Commands for one queue, recorded by one thread at a time. Obtained from
+	// I_RenderDevice::beginCommandList() and valid until close() and the submit that follows.
+	class I_CommandList {
+	public:
+		virtual ~I_CommandList() = default;
+
+		[[nodiscard]] virtual E_QueueType getQueue() const = 0;
+
+		virtual void barrier(std::span<const S_ResourceBarrier> barriers) = 0;
+		virtual void setPipeline(S_PipelineHandle pipeline) = 0;
+		virtual void setRenderTargets(std::span<const S_ResourceHandle> colors, S_ResourceHandle depth) = 0;
+		virtual void clearRenderTarget(S_ResourceHandle target, const std::array<float, 4>& color) = 0;
+		virtual void clearDepth(S_ResourceHandle target, float depth) = 0;
+		virtual void setViewport(const S_Viewport& viewport) = 0;
+		virtual void setScissor(const S_Rect& scissor) = 0;
+		virtual void setVertexBuffer(uint32_t slot, S_ResourceHandle buffer, uint64_t offset, uint32_t stride) = 0;
+		virtual void setIndexBuffer(S_ResourceHandle buffer, uint64_t offset, bool indices32) = 0;
+
+		// Shader-visible resource in a flat binding slot, as with bindless descriptor indices
+		virtual void setResource(uint32_t slot, S_ResourceHandle resource) = 0;
+		virtual void setConstants(uint32_t offset, std::span<const uint32_t> values) = 0;
+
+		virtual void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) = 0;
+		virtual void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset,
+			uint32_t firstInstance) = 0;
+		virtual void drawIndirect(S_ResourceHandle arguments, uint64_t offset, uint32_t drawCount) = 0;
+		virtual void dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) = 0;
+		virtual void copyBuffer(S_ResourceHandle destination, uint64_t destinationOffset, S_ResourceHandle source, uint64_t sourceOffset,
+			uint64_t size) = 0;
+		virtual void copyTexture(S_ResourceHandle destination, S_ResourceHandle source) = 0;
+
+		virtual void beginMarker(std::string_view name) = 0;
+		virtual void endMarker() = 0;
+
+		// Ends recording; the list may then be submitted once
+		virtual void close() = 0;
+	};
+
+	// What every backend implements. Resource, heap and pipeline calls are thread-safe;
+	// beginCommandList() may be called from any number of threads at once, each thread
+	// recording from its own command allocator. submit(), beginFrame() and endFrame() belong
+	// to one thread. Work is submitted per queue against monotonically increasing timeline
+	// values, the model of D3D12 fences and Vulkan timeline semaphores.
+	class I_RenderDevice {
+	public:
+		virtual ~I_RenderDevice() = default;
+
+		[[nodiscard]] virtual const char* getName() const = 0;
+
+		[[nodiscard]] virtual S_ResourceHandle createBuffer(const S_BufferDesc& desc, std::string_view name,
+			E_ResourceAccess initialAccess = E_ResourceAccess::NONE) = 0;
+		[[nodiscard]] virtual S_ResourceHandle createTexture(const S_TextureDesc& desc, std::string_view name,
+			E_ResourceAccess initialAccess = E_ResourceAccess::NONE) = 0;
+
+		// Placed resources start with undefined contents in E_ResourceAccess::NONE
+		[[nodiscard]] virtual S_HeapHandle createHeap(E_HeapCategory category, uint64_t size) = 0;
+		[[nodiscard]] virtual S_ResourceHandle createPlacedBuffer(S_HeapHandle heap, uint64_t offset, const S_BufferDesc& desc,
+			std::string_view name) = 0;
+		[[nodiscard]] virtual S_ResourceHandle createPlacedTexture(S_HeapHandle heap, uint64_t offset, const S_TextureDesc& desc,
+			std::string_view name) = 0;
+
+		[[nodiscard]] virtual S_PipelineHandle createPipeline(const S_PipelineDesc& desc) = 0;
+
+		// Released once the work submitted so far has finished
+		virtual void destroyResource(S_ResourceHandle resource) = 0;
+		virtual void destroyHeap(S_HeapHandle heap) = 0;
+		virtual void destroyPipeline(S_PipelineHandle pipeline) = 0;
+
+		// Recycles the command allocators of the oldest frame in flight
+		virtual void beginFrame() = 0;
+		virtual void endFrame() = 0;
+
+		[[nodiscard]] virtual I_CommandList* beginCommandList(E_QueueType queue) = 0;
+
+		// Runs the lists on queue after it has seen every wait, then signals signalValue if non-zero
+		virtual void submit(E_QueueType queue, std::span<I_CommandList* const> lists, std::span<const S_QueueWait> waits,
+			uint64_t signalValue) = 0;
+
+		// Highest value signalled on the queue so far; new signals must exceed it
+		[[nodiscard]] virtual uint64_t getSignaledValue(E_QueueType queue) const = 0;
+		virtual void waitIdle() = 0;
+	};
+}
@@ -0,0 +1,274 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "SpectraRenderPipeline.h"
+#include "S_RenderDevice.h"
+#include "S_RenderTypes.h"
+
+namespace spectra::pipeline {
+	struct S_RenderGraphResource {
+		uint32_t index = INVALID_INDEX;
+
+		[[nodiscard]] bool isValid() const { return index != INVALID_INDEX; }
+	};
+
+	class S_RenderGraph;
+
+	// What a pass sees while it records. commandList is null when the graph executes without a device.
+	struct SPEC_RENDER_PIPELINE S_RenderPassContext {
+		const S_RenderGraph* graph = nullptr;
+		uint32_t pass = INVALID_INDEX;
+		E_QueueType queue = E_QueueType::GRAPHICS;
+		I_CommandList* commandList = nullptr;
+
+		// Device resource behind a graph resource during execute(device)
+		[[nodiscard]] S_ResourceHandle getResource(S_RenderGraphResource resource) const;
+	};
+
+	using RenderPassFunction = std::function<void(const S_RenderPassContext&)>;
+
+	// Declares the accesses of one pass, returned by S_RenderGraph::addPass()
+	class SPEC_RENDER_PIPELINE S_RenderPassBuilder {
+		S_RenderGraph* graph = nullptr;
+		uint32_t pass = INVALID_INDEX;
+
+	public:
+		S_RenderPassBuilder(S_RenderGraph& graph, uint32_t pass);
+
+		// access holds read flags, or a single write flag for reading in that state, e.g.
+		// RENDER_TARGET for blending or DEPTH_WRITE for depth testing
+		S_RenderPassBuilder& read(S_RenderGraphResource resource, E_ResourceAccess access);
+
+		// access must be a single write flag. A write replaces the contents unless the pass
+		// reads the resource as well.
+		S_RenderPassBuilder& write(S_RenderGraphResource resource, E_ResourceAccess access);
+
+		// Never culled, e.g. readbacks or work with effects outside the graph
+		S_RenderPassBuilder& setSideEffects();
+
+		[[nodiscard]] uint32_t getPass() const;
+	};
+
+	struct S_Barrier {
+		E_BarrierType type = E_BarrierType::TRANSITION;
+		uint32_t resource = INVALID_INDEX;
+		uint32_t previousResource = INVALID_INDEX;
+		E_ResourceAccess before = E_ResourceAccess::NONE;
+		E_ResourceAccess after = E_ResourceAccess::NONE;
+	};
+
+	// One live pass in submission order: its waits, one batch of barriers, the pass, then a
+	// batch of end barriers for transitions the next user's queue cannot perform (compute and
+	// copy queues cannot leave graphics-only states). A non-zero signalValue is signalled on
+	// the pass's queue last.
+	struct S_CompiledPass {
+		uint32_t pass = INVALID_INDEX;
+		E_QueueType queue = E_QueueType::GRAPHICS;
+		uint64_t signalValue = 0;
+		uint32_t firstWait = 0;
+		uint32_t waitCount = 0;
+		uint32_t firstBarrier = 0;
+		uint32_t barrierCount = 0;
+		uint32_t firstEndBarrier = 0;
+		uint32_t endBarrierCount = 0;
+	};
+
+	struct S_ResourcePlacement {
+		E_HeapCategory category = E_HeapCategory::TEXTURE;
+		uint64_t offset = 0;  // Within the category's transient heap
+		uint64_t size = 0;
+		uint32_t firstPass = INVALID_INDEX;  // Compiled pass indices of the first and last use
+		uint32_t lastPass = INVALID_INDEX;
+		bool imported = false;
+		bool used = false;  // Touched by a live pass
+	};
+
+	struct S_RenderGraphSettings {
+		bool cullPasses = true;
+		bool aliasMemory = true;
+		bool mergeReadStates = true;  // Transition once into every read state until the next write
+		bool asyncQueues = true;      // False runs compute and copy passes on the graphics queue
+		bool parallelRecording = true;  // Record passes on the job system rather than the calling thread
+	};
+
+	struct S_RenderGraphStats {
+		uint32_t passes = 0;
+		uint32_t culledPasses = 0;
+		uint32_t resources = 0;
+		uint32_t transientResources = 0;
+		uint64_t transientBytes = 0;  // Sum of the transients' sizes
+		uint64_t heapBytes = 0;       // Memory they occupy after aliasing
+		uint32_t barriers = 0;
+		uint32_t barrierBatches = 0;
+		uint32_t queueWaits = 0;
+		uint32_t queueSignals = 0;
+		double compileMilliseconds = 0.0;
+		uint32_t submits = 0;             // Of the last execute(device)
+		double recordMilliseconds = 0.0;  // Wall time of recording every pass
+		double submitMilliseconds = 0.0;
+	};
+
+	// Frame graph: passes declare the resources they read and write, and compile() turns the
+	// declarations into a schedule. Passes nothing depends on are culled, each transient gets
+	// a lifetime and a place in a heap shared with transients whose lifetimes are ordered
+	// before or after it, state transitions are batched per pass, and passes on the compute
+	// and copy queues wait only for work they have not already synchronized with.
+	// Everything runs on the CPU; execute() calls the pass functions in submission order so
+	// graphs can be built, compiled and measured without a device. Declaration order is
+	// submission order, so a pass may only depend on passes added before it.
+	class SPEC_RENDER_PIPELINE S_RenderGraph {
+	public:
+		S_RenderGraph() = default;
+		explicit S_RenderGraph(const S_RenderGraphSettings& settings);
+
+		[[nodiscard]] S_RenderGraphResource createTexture(std::string name, const S_TextureDesc& desc);
+		[[nodiscard]] S_RenderGraphResource createBuffer(std::string name, const S_BufferDesc& desc);
+
+		// Resources owned outside the graph, e.g. the swapchain image. They are outputs: the
+		// passes writing them are kept, and they end in finalAccess. handle is only needed
+		// for execute(device).
+		[[nodiscard]] S_RenderGraphResource importTexture(std::string name, const S_TextureDesc& desc, E_ResourceAccess initialAccess,
+			E_ResourceAccess finalAccess, S_ResourceHandle handle = {});
+		[[nodiscard]] S_RenderGraphResource importBuffer(std::string name, const S_BufferDesc& desc, E_ResourceAccess initialAccess,
+			E_ResourceAccess finalAccess, S_ResourceHandle handle = {});
+
+		// Keeps the passes producing a transient, e.g. one read back after the frame
+		void markOutput(S_RenderGraphResource resource);
+
+		S_RenderPassBuilder addPass(std::string name, E_QueueType queue, RenderPassFunction execute = {});
+
+		void compile();
+
+		// Calls every live pass in submission order; compile() first
+		void execute() const;
+
+		// Places the transients in device heaps, records every live pass into its own command
+		// list, in parallel unless disabled, and submits the lists with the compiled barriers,
+		// waits and signals. Transient device resources are released at the end.
+		void execute(I_RenderDevice& device);
+
+		// Frees the transient heaps; call before destroying the device
+		void releaseDeviceMemory();
+
+		// Drops passes and resources but keeps capacity, for rebuilding the graph every frame
+		void reset();
+
+		[[nodiscard]] const std::vector<S_CompiledPass>& getCompiledPasses() const;
+		[[nodiscard]] const std::vector<S_Barrier>& getBarriers() const;
+		[[nodiscard]] const std::vector<S_QueueWait>& getWaits() const;
+
+		// Transitions of imported resources into their final access, recorded on the graphics
+		// queue after the last pass once it has waited for the final waits
+		[[nodiscard]] const std::vector<S_Barrier>& getFinalBarriers() const;
+		[[nodiscard]] const std::vector<S_QueueWait>& getFinalWaits() const;
+
+		[[nodiscard]] const S_ResourcePlacement& getPlacement(S_RenderGraphResource resource) const;
+		[[nodiscard]] S_ResourceHandle getDeviceResource(S_RenderGraphResource resource) const;
+		[[nodiscard]] uint64_t getHeapSize(E_HeapCategory category) const;
+		[[nodiscard]] bool isPassCulled(uint32_t pass) const;
+		[[nodiscard]] const std::string& getPassName(uint32_t pass) const;
+		[[nodiscard]] const std::string& getResourceName(S_RenderGraphResource resource) const;
+		[[nodiscard]] const S_RenderGraphSettings& getSettings() const;
+		[[nodiscard]] const S_RenderGraphStats& getStats() const;
+
+		// Pushes the last compile's stats to SpectraInstrumentation under "spectra::pipeline::rendergraph"
+		void publishStats() const;
+
+	private:
+		friend class S_RenderPassBuilder;
+
+		struct S_ResourceNode {
+			std::string name;
+			E_ResourceKind kind = E_ResourceKind::TEXTURE;
+			S_TextureDesc texture;
+			S_BufferDesc buffer;
+			E_ResourceAccess initialAccess = E_ResourceAccess::NONE;
+			E_ResourceAccess finalAccess = E_ResourceAccess::NONE;
+			S_ResourceHandle handle;  // Imported resources only
+			bool imported = false;
+			bool output = false;
+		};
+
+		struct S_PassNode {
+			std::string name;
+			E_QueueType queue = E_QueueType::GRAPHICS;
+			RenderPassFunction execute;
+			bool sideEffects = false;
+			bool live = false;
+		};
+
+		// After compile() merges them, one per pass and resource; access is then the state
+		// the pass needs
+		struct S_PassAccess {
+			uint32_t pass = INVALID_INDEX;
+			uint32_t resource = INVALID_INDEX;
+			E_ResourceAccess access = E_ResourceAccess::NONE;
+			bool reads = false;
+			bool writes = false;
+		};
+
+		// A live pass's use of a resource, grouped per resource in submission order
+		struct S_ResourceUse {
+			uint32_t compiledPass = INVALID_INDEX;
+			uint32_t access = INVALID_INDEX;  // Index into accesses
+		};
+
+		// Barrier waiting to be batched; slot orders aliasing barriers, then transitions, then end barriers
+		struct S_PendingBarrier {
+			uint32_t compiledPass = INVALID_INDEX;
+			uint32_t slot = 0;
+			S_Barrier barrier;
+		};
+
+		// Per queue, how many of its passes are known complete when a compiled pass starts
+		using QueueClock = std::array<uint32_t, QUEUE_TYPE_COUNT>;
+
+		S_RenderGraphSettings settings;
+		std::vector<S_ResourceNode> resources;
+		std::vector<S_PassNode> passes;
+		std::vector<S_PassAccess> accesses;        // Sorted by pass and merged by compile()
+		std::vector<uint32_t> passAccessStart;     // First entry in accesses per pass, plus an end
+
+		std::vector<S_CompiledPass> compiledPasses;
+		std::vector<QueueClock> passClocks;        // Per compiled pass
+		std::vector<uint32_t> queuePositions;      // Per compiled pass, its index on its queue
+		std::array<std::vector<uint32_t>, QUEUE_TYPE_COUNT> queuePasses;  // Compiled passes per queue
+		std::vector<S_ResourceUse> resourceUses;
+		std::vector<uint32_t> resourceUseStart;    // First entry in resourceUses per resource, plus an end
+		std::vector<QueueClock> lastUses;          // Per resource, last compiled pass using it per queue
+		std::vector<E_ResourceAccess> finalStates;  // Per resource, its state after the last pass
+		std::vector<S_PendingBarrier> pendingBarriers;
+		std::vector<S_Barrier> barriers;
+		std::vector<S_Barrier> finalBarriers;
+		std::vector<S_QueueWait> waits;
+		std::vector<S_QueueWait> finalWaits;
+		std::vector<S_ResourcePlacement> placements;
+		std::array<uint64_t, HEAP_CATEGORY_COUNT> heapSizes{};
+		S_RenderGraphStats stats;
+		bool compiled = false;
+
+		// Device state of execute(device); heaps persist and grow, placed resources live for one execute
+		I_RenderDevice* heapDevice = nullptr;
+		std::array<S_HeapHandle, HEAP_CATEGORY_COUNT> heaps{};
+		std::array<uint64_t, HEAP_CATEGORY_COUNT> heapCapacities{};
+		std::vector<S_ResourceHandle> deviceResources;
+		std::vector<I_CommandList*> commandLists;  // Per compiled pass
+
+		S_RenderGraphResource addResource(S_ResourceNode node);
+		void addAccess(uint32_t pass, S_RenderGraphResource resource, E_ResourceAccess access, bool write);
+		[[nodiscard]] bool happensBefore(uint32_t compiledBefore, uint32_t compiledAfter) const;
+		[[nodiscard]] bool isReleasedBefore(uint32_t resource, uint32_t compiledPass) const;
+		void mergeAccesses();
+		void cullPasses();
+		void orderPasses();
+		void schedule();
+		void placeResources();
+		void buildBarriers();
+		void recordPass(I_RenderDevice& device, uint32_t compiledPass);
+		void translateBarriers(I_CommandList& commandList, const S_Barrier* first, uint32_t count) const;
+	};
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+
+#include "SpectraRenderPipeline.h"
+
+namespace spectra::pipeline {
+	constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+	enum class SPEC_RENDER_PIPELINE E_QueueType : uint8_t {
+		GRAPHICS = 0,
+		COMPUTE,
+		COPY
+	};
+	constexpr uint32_t QUEUE_TYPE_COUNT = 3;
+
+	enum class SPEC_RENDER_PIPELINE E_Format : uint8_t {
+		UNKNOWN = 0,
+		R8G8B8A8_UNORM,
+		R8G8B8A8_SRGB,
+		B8G8R8A8_UNORM,
+		R10G10B10A2_UNORM,
+		R11G11B10_FLOAT,
+		R16G16_FLOAT,
+		R16G16B16A16_FLOAT,
+		R32_FLOAT,
+		R32_UINT,
+		R32G32B32A32_FLOAT,
+		D32_FLOAT,
+		D24_UNORM_S8_UINT
+	};
+
+	[[nodiscard]] constexpr uint32_t getFormatBytes(E_Format format) {
+		switch (format) {
+		case E_Format::R16G16B16A16_FLOAT:
+			return 8;
+		case E_Format::R32G32B32A32_FLOAT:
+			return 16;
+		case E_Format::UNKNOWN:
+			return 0;
+		default:
+			return 4;
+		}
+	}
+
+	[[nodiscard]] constexpr bool isDepthFormat(E_Format format) {
+		return format == E_Format::D32_FLOAT || format == E_Format::D24_UNORM_S8_UINT;
+	}
+
+	// How a pass touches a resource. Read flags may be combined into one state; a write
+	// flag is exclusive and must be the only flag of its access.
+	enum class SPEC_RENDER_PIPELINE E_ResourceAccess : uint32_t {
+		NONE = 0,  // Undefined contents, e.g. a transient before its first write
+		VERTEX_BUFFER = 1u << 0,
+		INDEX_BUFFER = 1u << 1,
+		CONSTANT_BUFFER = 1u << 2,
+		INDIRECT_ARGUMENT = 1u << 3,
+		SHADER_READ = 1u << 4,
+		COPY_SOURCE = 1u << 5,
+		DEPTH_READ = 1u << 6,
+		PRESENT = 1u << 7,
+		RENDER_TARGET = 1u << 8,
+		DEPTH_WRITE = 1u << 9,
+		UNORDERED_ACCESS = 1u << 10,
+		COPY_DEST = 1u << 11
+	};
+
+	[[nodiscard]] constexpr E_ResourceAccess operator|(E_ResourceAccess a, E_ResourceAccess b) {
+		return static_cast<E_ResourceAccess>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+	}
+
+	[[nodiscard]] constexpr E_ResourceAccess operator&(E_ResourceAccess a, E_ResourceAccess b) {
+		return static_cast<E_ResourceAccess>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+	}
+
+	constexpr E_ResourceAccess READ_ACCESS_MASK = E_ResourceAccess::VERTEX_BUFFER | E_ResourceAccess::INDEX_BUFFER
+		| E_ResourceAccess::CONSTANT_BUFFER | E_ResourceAccess::INDIRECT_ARGUMENT | E_ResourceAccess::SHADER_READ
+		| E_ResourceAccess::COPY_SOURCE | E_ResourceAccess::DEPTH_READ | E_ResourceAccess::PRESENT;
+	constexpr E_ResourceAccess WRITE_ACCESS_MASK = E_ResourceAccess::RENDER_TARGET | E_ResourceAccess::DEPTH_WRITE
+		| E_ResourceAccess::UNORDERED_ACCESS | E_ResourceAccess::COPY_DEST;
+
+	[[nodiscard]] constexpr bool hasAccess(E_ResourceAccess access, E_ResourceAccess flags) {
+		return (access & flags) != E_ResourceAccess::NONE;
+	}
+
+	[[nodiscard]] constexpr bool isWriteAccess(E_ResourceAccess access) {
+		return hasAccess(access, WRITE_ACCESS_MASK);
+	}
+
+	// Accesses a queue of the given type is able to perform
+	[[nodiscard]] constexpr E_ResourceAccess getQueueAccessMask(E_QueueType queue) {
+		switch (queue) {
+		case E_QueueType::COPY:
+			return E_ResourceAccess::COPY_SOURCE | E_ResourceAccess::COPY_DEST;
+		case E_QueueType::COMPUTE:
+			return E_ResourceAccess::CONSTANT_BUFFER | E_ResourceAccess::INDIRECT_ARGUMENT | E_ResourceAccess::SHADER_READ
+				| E_ResourceAccess::COPY_SOURCE | E_ResourceAccess::COPY_DEST | E_ResourceAccess::UNORDERED_ACCESS;
+		default:
+			return READ_ACCESS_MASK | WRITE_ACCESS_MASK;
+		}
+	}
+
+	enum class SPEC_RENDER_PIPELINE E_BarrierType : uint8_t {
+		TRANSITION = 0,
+		ALIASING,       // Memory now belongs to resource; previousResource held it before
+		UAV             // Orders two unordered-access writes of the same resource
+	};
+
+	// Wait on another queue's timeline until it reaches value, D3D12 fences and Vulkan
+	// timeline semaphores alike
+	struct S_QueueWait {
+		E_QueueType queue = E_QueueType::GRAPHICS;
+		uint64_t value = 0;
+	};
+
+	struct S_TextureDesc {
+		uint32_t width = 1;
+		uint32_t height = 1;
+		uint32_t depth = 1;
+		uint32_t mipLevels = 1;
+		uint32_t arrayLayers = 1;
+		uint32_t sampleCount = 1;
+		E_Format format = E_Format::R8G8B8A8_UNORM;
+	};
+
+	struct S_BufferDesc {
+		uint64_t size = 0;
+	};
+
+	enum class SPEC_RENDER_PIPELINE E_ResourceKind : uint8_t {
+		TEXTURE = 0,
+		BUFFER
+	};
+
+	// Memory kinds that placed resources may not share on the most restrictive hardware
+	// (D3D12 resource heap tier 1), each aliased within its own heap
+	enum class SPEC_RENDER_PIPELINE E_HeapCategory : uint8_t {
+		BUFFER = 0,
+		RENDER_TARGET,  // Textures written as render target or depth
+		TEXTURE
+	};
+	constexpr uint32_t HEAP_CATEGORY_COUNT = 3;
+
+	// Placement alignment of buffers and single-sample textures, and of multisampled textures
+	constexpr uint64_t RESOURCE_ALIGNMENT = 64ull * 1024;
+	constexpr uint64_t MSAA_RESOURCE_ALIGNMENT = 4ull * 1024 * 1024;
+
+	[[nodiscard]] constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Estimated placed size: every mip of every layer at the format's size, aligned as above.
+	// Drivers pad further, so this is a lower bound good for budgeting and aliasing tests.
+	[[nodiscard]] constexpr uint64_t getTextureSize(const S_TextureDesc& desc) {
+		uint64_t bytes = 0;
+		for (uint32_t mip = 0; mip < desc.mipLevels; ++mip) {
+			const uint64_t width = desc.width >> mip ? desc.width >> mip : 1;
+			const uint64_t height = desc.height >> mip ? desc.height >> mip : 1;
+			const uint64_t depth = desc.depth >> mip ? desc.depth >> mip : 1;
+			bytes += width * height * depth * getFormatBytes(desc.format);
+		}
+		bytes *= static_cast<uint64_t>(desc.arrayLayers) * desc.sampleCount;
+		return alignUp(bytes, desc.sampleCount > 1 ? MSAA_RESOURCE_ALIGNMENT : RESOURCE_ALIGNMENT);
+	}
+
+	[[nodiscard]] constexpr uint64_t getBufferSize(const S_BufferDesc& desc) {
+		return alignUp(desc.size, RESOURCE_ALIGNMENT);
+	}
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPEC_RENDER_PIPELINE
+#if defined(_WIN32)
 #define SPEC_RENDER_PIPELINE __declspec(dllexport)
+#else
+#define SPEC_RENDER_PIPELINE __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPEC_RENDER_PIPELINE SpectraRenderPipelineInit();
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPECTRA_EDITORS
+#if defined(_WIN32)
 #define SPECTRA_EDITORS __declspec(dllexport)
+#else
+#define SPECTRA_EDITORS __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECTRA_EDITORS SpectraEditorsInit();
\ No newline at end of file
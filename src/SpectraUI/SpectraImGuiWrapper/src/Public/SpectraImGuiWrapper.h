@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SP_IMGUI_WRAPPER
+#if defined(_WIN32)
 #define SP_IMGUI_WRAPPER __declspec(dllexport)
+#else
+#define SP_IMGUI_WRAPPER __attribute__((visibility("default")))
+#endif
 #endif
 
 void SP_IMGUI_WRAPPER SpectraImGuiWrapperInit();
\ No newline at end of file
@@ -0,0 +1,439 @@
+#include "S_NodeGraph.h"
+#include "S_JobSystem.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+namespace spectra::ui::nodes {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::ui::nodes";
+		constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+		// Depth-first walk marks
+		constexpr uint8_t UNVISITED = 0;
+		constexpr uint8_t EXPANDED = 1;
+		constexpr uint8_t DONE = 2;
+		constexpr uint8_t OUTPUT = 3;  // Set after the walk, keeps requested results longest
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	// One evaluate() on the job system. A node's job is submitted by whichever job finishes its
+	// last input, so the counter only drains once the whole set has run.
+	struct S_NodeGraph::S_Schedule {
+		S_NodeGraph* graph = nullptr;
+		std::vector<uint32_t> slots;                        // Position in order per node, NO_SLOT outside it
+		std::unique_ptr<std::atomic<uint32_t>[]> pending;   // Inputs still running, per position
+		core::jobs::S_Counter counter;
+		std::atomic<bool> failed{ false };
+		std::mutex failureMutex;
+		std::exception_ptr failure;
+
+		void launch(uint32_t position) {
+			core::jobs::S_JobSystem::getInstance().run([this, position]() { execute(position); }, &counter);
+		}
+
+		void execute(uint32_t position) {
+			const uint32_t node = graph->order[position];
+			if (!failed.load(std::memory_order_relaxed)) {
+				try {
+					graph->evaluateNode(node);
+				}
+				catch (...) {
+					std::lock_guard lock(failureMutex);
+					if (!failure) {
+						failure = std::current_exception();
+					}
+					failed.store(true, std::memory_order_relaxed);
+				}
+			}
+			for (const uint32_t dependent : graph->nodes[node].dependents) {
+				const uint32_t slot = slots[dependent];
+				if (slot != NO_SLOT && pending[slot].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					launch(slot);
+				}
+			}
+		}
+	};
+
+	// S_NodeGraph implementations
+	S_NodeGraph::S_NodeGraph(S_NodeGraphSettings settings) : settings(settings) {
+	}
+
+	uint32_t S_NodeGraph::registerType(S_NodeType type) {
+		if (!type.evaluate) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_NodeGraph", "registerType",
+				"Node type has no evaluate function", type.name);
+		}
+		types.push_back(std::move(type));
+		return static_cast<uint32_t>(types.size() - 1);
+	}
+
+	uint32_t S_NodeGraph::addNode(uint32_t type) {
+		if (type >= types.size()) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_NodeGraph", "addNode", "Unknown node type", type);
+		}
+		S_Node& node = nodes.emplace_back();
+		node.type = type;
+		node.inputs.assign(types[type].inputCount, INVALID_NODE_ID);
+		node.parameters.assign(types[type].parameterCount, 0.0f);
+		++dirtiedNodes;
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	void S_NodeGraph::removeNode(uint32_t node) {
+		validateNode(node, "removeNode");
+		S_Node& removed = nodes[node];
+		for (const uint32_t source : removed.inputs) {
+			if (source != INVALID_NODE_ID) {
+				std::vector<uint32_t>& dependents = nodes[source].dependents;
+				dependents.erase(std::find(dependents.begin(), dependents.end(), node));
+			}
+		}
+		std::vector<uint32_t> dependents = std::move(removed.dependents);
+		for (const uint32_t dependent : dependents) {
+			std::replace(nodes[dependent].inputs.begin(), nodes[dependent].inputs.end(), node, INVALID_NODE_ID);
+			markDirty(dependent);
+		}
+		removed = S_Node{};
+		removed.alive = false;
+		removed.dirty = false;
+	}
+
+	bool S_NodeGraph::connect(uint32_t node, uint32_t slot, uint32_t source) {
+		validateNode(node, "connect");
+		if (source != INVALID_NODE_ID) {
+			validateNode(source, "connect");
+		}
+		S_Node& target = nodes[node];
+		if (slot >= target.inputs.size()) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_NodeGraph", "connect",
+				"Input slot out of range", types[target.type].name, slot);
+		}
+		const uint32_t previous = target.inputs[slot];
+		if (previous == source) {
+			return true;
+		}
+		if (source != INVALID_NODE_ID && (source == node || dependsOn(source, node))) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::WARNING, "S_NodeGraph", "connect",
+				"Connection would create a cycle", node, source);
+			return false;
+		}
+
+		if (previous != INVALID_NODE_ID) {
+			std::vector<uint32_t>& dependents = nodes[previous].dependents;
+			dependents.erase(std::find(dependents.begin(), dependents.end(), node));
+		}
+		if (source != INVALID_NODE_ID) {
+			nodes[source].dependents.push_back(node);
+		}
+		target.inputs[slot] = source;
+		markDirty(node);
+		return true;
+	}
+
+	void S_NodeGraph::setParameter(uint32_t node, uint32_t index, float value) {
+		validateNode(node, "setParameter");
+		std::vector<float>& parameters = nodes[node].parameters;
+		if (index >= parameters.size()) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_NodeGraph", "setParameter",
+				"Parameter index out of range", types[nodes[node].type].name, index);
+		}
+		// Sliders resend unchanged values; compared by bits so NaN is still an edit once
+		if (std::bit_cast<uint32_t>(parameters[index]) == std::bit_cast<uint32_t>(value)) {
+			return;
+		}
+		parameters[index] = value;
+		markDirty(node);
+	}
+
+	std::vector<std::shared_ptr<const S_NodeResult>> S_NodeGraph::evaluate(std::span<const uint32_t> outputs) {
+		for (const uint32_t output : outputs) {
+			validateNode(output, "evaluate");
+		}
+		const auto start = std::chrono::steady_clock::now();
+		++evaluationIndex;
+		stats = {};
+		stats.dirtiedNodes = std::exchange(dirtiedNodes, 0);
+
+		collect(outputs);
+		const auto& jobs = core::jobs::S_JobSystem::getInstance();
+		if (settings.parallel && order.size() > 1 && jobs.isRunning() && jobs.getThreadCount() > 1) {
+			runParallel();
+		}
+		else {
+			runSerial();
+		}
+		for (const uint32_t node : order) {
+			if (!nodes[node].dirty) {
+				++stats.evaluatedNodes;
+				stats.nodeMilliseconds += nodes[node].milliseconds;
+			}
+		}
+
+		// Handed out before eviction, so a budget smaller than the outputs still returns them
+		std::vector<std::shared_ptr<const S_NodeResult>> results;
+		results.reserve(outputs.size());
+		for (const uint32_t output : outputs) {
+			results.push_back(nodes[output].result);
+			marks[output] = OUTPUT;
+		}
+		evictResults();
+		stats.evaluateMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "evaluate", stats.evaluateMilliseconds);
+		return results;
+	}
+
+	std::shared_ptr<const S_NodeResult> S_NodeGraph::evaluate(uint32_t output) {
+		return evaluate(std::span<const uint32_t>(&output, 1)).front();
+	}
+
+	void S_NodeGraph::clearCache() {
+		for (S_Node& node : nodes) {
+			node.result.reset();
+		}
+	}
+
+	bool S_NodeGraph::isDirty(uint32_t node) const {
+		validateNode(node, "isDirty");
+		return nodes[node].dirty;
+	}
+
+	bool S_NodeGraph::hasCachedResult(uint32_t node) const {
+		validateNode(node, "hasCachedResult");
+		return nodes[node].result != nullptr;
+	}
+
+	float S_NodeGraph::getParameter(uint32_t node, uint32_t index) const {
+		validateNode(node, "getParameter");
+		return nodes[node].parameters.at(index);
+	}
+
+	uint32_t S_NodeGraph::getInput(uint32_t node, uint32_t slot) const {
+		validateNode(node, "getInput");
+		return nodes[node].inputs.at(slot);
+	}
+
+	uint32_t S_NodeGraph::getNodeCount() const {
+		return static_cast<uint32_t>(nodes.size());
+	}
+
+	std::vector<uint32_t> S_NodeGraph::getTopologicalOrder() const {
+		// Kahn's algorithm, counting connections so repeated inputs balance repeated dependents
+		std::vector<uint32_t> remaining(nodes.size(), 0);
+		std::vector<uint32_t> sorted;
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			if (!nodes[i].alive) {
+				continue;
+			}
+			remaining[i] = static_cast<uint32_t>(std::count_if(nodes[i].inputs.begin(), nodes[i].inputs.end(),
+				[](uint32_t input) { return input != INVALID_NODE_ID; }));
+			if (remaining[i] == 0) {
+				sorted.push_back(i);
+			}
+		}
+		for (size_t next = 0; next < sorted.size(); ++next) {
+			for (const uint32_t dependent : nodes[sorted[next]].dependents) {
+				if (--remaining[dependent] == 0) {
+					sorted.push_back(dependent);
+				}
+			}
+		}
+		return sorted;
+	}
+
+	const S_NodeEvaluationStats& S_NodeGraph::getStats() const {
+		return stats;
+	}
+
+	void S_NodeGraph::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "dirtiedNodes", stats.dirtiedNodes);
+		Instrumentation::setGauge(STATS_CATEGORY, "evaluatedNodes", stats.evaluatedNodes);
+		Instrumentation::setGauge(STATS_CATEGORY, "reusedResults", stats.reusedResults);
+		Instrumentation::setGauge(STATS_CATEGORY, "evictedResults", stats.evictedResults);
+		Instrumentation::setGauge(STATS_CATEGORY, "parallelWaves", stats.parallelWaves);
+		Instrumentation::setGauge(STATS_CATEGORY, "cachedBytes", static_cast<double>(stats.cachedBytes));
+		Instrumentation::setGauge(STATS_CATEGORY, "nodeMilliseconds", stats.nodeMilliseconds);
+	}
+
+	void S_NodeGraph::validateNode(uint32_t node, const char* method) const {
+		if (node >= nodes.size() || !nodes[node].alive) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_NodeGraph", method, "Invalid node id", node);
+		}
+	}
+
+	// Stops at nodes already dirty: everything downstream of a dirty node is dirty too
+	void S_NodeGraph::markDirty(uint32_t node) {
+		stack.assign(1, node);
+		while (!stack.empty()) {
+			S_Node& current = nodes[stack.back()];
+			stack.pop_back();
+			if (current.dirty) {
+				continue;
+			}
+			current.dirty = true;
+			current.result.reset();
+			++dirtiedNodes;
+			stack.insert(stack.end(), current.dependents.begin(), current.dependents.end());
+		}
+		nodes[node].dirty = true;
+		nodes[node].result.reset();
+	}
+
+	bool S_NodeGraph::dependsOn(uint32_t node, uint32_t upstream) {
+		marks.assign(nodes.size(), UNVISITED);
+		stack.assign(1, node);
+		while (!stack.empty()) {
+			const uint32_t current = stack.back();
+			stack.pop_back();
+			if (current == upstream) {
+				return true;
+			}
+			if (marks[current] != UNVISITED) {
+				continue;
+			}
+			marks[current] = DONE;
+			for (const uint32_t input : nodes[current].inputs) {
+				if (input != INVALID_NODE_ID) {
+					stack.push_back(input);
+				}
+			}
+		}
+		return false;
+	}
+
+	// Post-order walk from the outputs, not descending below clean cached results
+	void S_NodeGraph::collect(std::span<const uint32_t> outputs) {
+		order.clear();
+		marks.assign(nodes.size(), UNVISITED);
+		for (const uint32_t output : outputs) {
+			stack.assign(1, output);
+			while (!stack.empty()) {
+				const uint32_t current = stack.back();
+				S_Node& node = nodes[current];
+				if (marks[current] == DONE) {
+					stack.pop_back();
+					continue;
+				}
+				node.lastUse = evaluationIndex;
+				if (marks[current] == EXPANDED) {
+					marks[current] = DONE;
+					order.push_back(current);
+					stack.pop_back();
+					continue;
+				}
+				if (!node.dirty && node.result) {
+					marks[current] = DONE;
+					++stats.reusedResults;
+					stack.pop_back();
+					continue;
+				}
+				marks[current] = EXPANDED;
+				for (const uint32_t input : node.inputs) {
+					if (input != INVALID_NODE_ID && marks[input] != DONE) {
+						stack.push_back(input);
+					}
+				}
+			}
+		}
+	}
+
+	void S_NodeGraph::evaluateNode(uint32_t node) {
+		S_Node& current = nodes[node];
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<const S_NodeResult*> inputs(current.inputs.size(), nullptr);
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			if (current.inputs[i] != INVALID_NODE_ID) {
+				inputs[i] = nodes[current.inputs[i]].result.get();
+			}
+		}
+		auto result = std::make_shared<S_NodeResult>();
+		types[current.type].evaluate({ inputs, current.parameters }, *result);
+		current.result = std::move(result);
+		current.dirty = false;
+		current.milliseconds = millisecondsSince(start);
+	}
+
+	void S_NodeGraph::runSerial() {
+		for (const uint32_t node : order) {
+			evaluateNode(node);
+		}
+	}
+
+	void S_NodeGraph::runParallel() {
+		S_Schedule schedule;
+		schedule.graph = this;
+		schedule.slots.assign(nodes.size(), NO_SLOT);
+		for (uint32_t position = 0; position < order.size(); ++position) {
+			schedule.slots[order[position]] = position;
+		}
+
+		// Inputs inside the set hold a job back; the depth of each node gives the wave count
+		schedule.pending = std::make_unique<std::atomic<uint32_t>[]>(order.size());
+		std::vector<uint32_t> depths(order.size(), 1);
+		std::vector<uint32_t> ready;
+		for (uint32_t position = 0; position < order.size(); ++position) {
+			uint32_t count = 0;
+			for (const uint32_t input : nodes[order[position]].inputs) {
+				if (input != INVALID_NODE_ID && schedule.slots[input] != NO_SLOT) {
+					++count;
+					depths[position] = std::max(depths[position], depths[schedule.slots[input]] + 1);
+				}
+			}
+			schedule.pending[position].store(count, std::memory_order_relaxed);
+			if (count == 0) {
+				ready.push_back(position);
+			}
+		}
+		stats.parallelWaves = *std::max_element(depths.begin(), depths.end());
+
+		for (const uint32_t position : ready) {
+			schedule.launch(position);
+		}
+		core::jobs::S_JobSystem::getInstance().waitForCounter(schedule.counter);
+		if (schedule.failure) {
+			std::rethrow_exception(schedule.failure);
+		}
+	}
+
+	// Least recently used first; among results of the last evaluation the outputs go last
+	// and otherwise the cheapest to recompute first
+	void S_NodeGraph::evictResults() {
+		std::vector<uint32_t> cached;
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].result) {
+				cached.push_back(i);
+				stats.cachedBytes += nodes[i].result->getByteSize();
+			}
+		}
+		if (stats.cachedBytes <= settings.cacheBudgetBytes) {
+			return;
+		}
+		std::sort(cached.begin(), cached.end(), [this](uint32_t a, uint32_t b) {
+			const bool outputA = marks[a] == OUTPUT;
+			const bool outputB = marks[b] == OUTPUT;
+			if (nodes[a].lastUse != nodes[b].lastUse) {
+				return nodes[a].lastUse < nodes[b].lastUse;
+			}
+			return outputA != outputB ? outputB : nodes[a].milliseconds < nodes[b].milliseconds;
+		});
+		for (const uint32_t node : cached) {
+			if (stats.cachedBytes <= settings.cacheBudgetBytes) {
+				break;
+			}
+			stats.cachedBytes -= nodes[node].result->getByteSize();
+			nodes[node].result.reset();
+			++stats.evictedResults;
+		}
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SpectraNodes.h"
+
+namespace spectra::ui::nodes {
+	constexpr uint32_t INVALID_NODE_ID = 0xFFFFFFFFu;
+
+	// Output of a node: a scalar, a color or a whole image of floats
+	struct S_NodeResult {
+		std::vector<float> values;
+		uint32_t width = 0;   // Image results only
+		uint32_t height = 0;
+
+		[[nodiscard]] size_t getByteSize() const { return sizeof(*this) + values.capacity() * sizeof(float); }
+	};
+
+	// What a node function sees. Unconnected inputs are null.
+	struct S_NodeContext {
+		std::span<const S_NodeResult* const> inputs;
+		std::span<const float> parameters;
+	};
+
+	struct S_NodeType {
+		std::string name;
+		uint32_t inputCount = 0;
+		uint32_t parameterCount = 0;
+
+		// Runs on job system threads, several nodes at once, so it may only touch its arguments
+		std::function<void(const S_NodeContext& context, S_NodeResult& output)> evaluate;
+	};
+
+	struct S_NodeGraphSettings {
+		uint64_t cacheBudgetBytes = 256ull << 20;  // Results beyond it are evicted after each evaluation
+		bool parallel = true;                       // Independent branches as jobs while the job system runs
+	};
+
+	struct S_NodeEvaluationStats {
+		uint32_t dirtiedNodes = 0;     // By edits since the previous evaluation
+		uint32_t evaluatedNodes = 0;
+		uint32_t reusedResults = 0;    // Clean cached results the evaluation stopped at
+		uint32_t evictedResults = 0;
+		uint32_t parallelWaves = 0;    // Longest dependency chain evaluated, 0 when run serially
+		uint64_t cachedBytes = 0;
+		double evaluateMilliseconds = 0.0;
+		double nodeMilliseconds = 0.0;  // Summed over evaluated nodes, above evaluateMilliseconds when branches overlapped
+	};
+
+	// Runtime behind the node editor. Nodes are evaluated on demand and their results cached;
+	// an edit marks the node and everything downstream of it dirty, stopping at nodes already
+	// dirty, so evaluate() only reruns what the edit can reach and what the outputs need.
+	// Nodes to run are found by a depth-first walk from the outputs that stops at clean cached
+	// results, which yields them in dependency order; each is then submitted as a job once its
+	// last input is done, so independent branches overlap. After every evaluation the least
+	// recently used results beyond cacheBudgetBytes are dropped; such a node stays clean and
+	// is simply recomputed when next needed. Results are shared, so a caller may keep one past
+	// its eviction. Not thread-safe: edit and evaluate from one thread.
+	class SPEC_NODES S_NodeGraph {
+	public:
+		explicit S_NodeGraph(S_NodeGraphSettings settings = {});
+
+		// Returns the type id; logs an ERROR for a type without a function
+		uint32_t registerType(S_NodeType type);
+
+		// Parameters start at zero
+		uint32_t addNode(uint32_t type);
+
+		// Disconnects and dirties the node's dependents; the id is not reused
+		void removeNode(uint32_t node);
+
+		// Feeds the output of source to one input of node, INVALID_NODE_ID disconnects it.
+		// Returns false, with a WARNING, for a connection that would close a cycle.
+		bool connect(uint32_t node, uint32_t slot, uint32_t source);
+
+		// Setting the value a parameter already has dirties nothing
+		void setParameter(uint32_t node, uint32_t index, float value);
+
+		// Results in the order of outputs. Rethrows the first exception a node function threw,
+		// after every running job has finished; nodes that did not run stay dirty.
+		std::vector<std::shared_ptr<const S_NodeResult>> evaluate(std::span<const uint32_t> outputs);
+		std::shared_ptr<const S_NodeResult> evaluate(uint32_t output);
+
+		// Drops every cached result without dirtying anything
+		void clearCache();
+
+		[[nodiscard]] bool isDirty(uint32_t node) const;
+		[[nodiscard]] bool hasCachedResult(uint32_t node) const;
+		[[nodiscard]] float getParameter(uint32_t node, uint32_t index) const;
+		[[nodiscard]] uint32_t getInput(uint32_t node, uint32_t slot) const;
+		[[nodiscard]] uint32_t getNodeCount() const;  // Removed nodes included
+
+		// Live nodes, every node after its inputs
+		[[nodiscard]] std::vector<uint32_t> getTopologicalOrder() const;
+
+		// Of the last evaluate()
+		[[nodiscard]] const S_NodeEvaluationStats& getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::ui::nodes"
+		void publishStats() const;
+
+	private:
+		struct S_Node {
+			uint32_t type = 0;
+			bool alive = true;
+			bool dirty = true;
+			std::vector<uint32_t> inputs;
+			std::vector<float> parameters;
+			std::vector<uint32_t> dependents;  // One entry per connection
+			std::shared_ptr<const S_NodeResult> result;
+			uint64_t lastUse = 0;              // Evaluation that last needed the result
+			double milliseconds = 0.0;         // Of the last run, to evict cheap results first
+		};
+
+		struct S_Schedule;
+
+		S_NodeGraphSettings settings;
+		std::vector<S_NodeType> types;
+		std::vector<S_Node> nodes;
+		uint64_t evaluationIndex = 0;
+		uint32_t dirtiedNodes = 0;
+		S_NodeEvaluationStats stats;
+
+		// Scratch reused across evaluations
+		std::vector<uint32_t> order;
+		std::vector<uint32_t> stack;
+		std::vector<uint8_t> marks;
+
+		void validateNode(uint32_t node, const char* method) const;
+		void markDirty(uint32_t node);
+		[[nodiscard]] bool dependsOn(uint32_t node, uint32_t upstream);
+		void collect(std::span<const uint32_t> outputs);
+		void evaluateNode(uint32_t node);
+		void runSerial();
+		void runParallel();
+		void evictResults();
+	};
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPEC_NODES
+#if defined(_WIN32)
 #define SPEC_NODES __declspec(dllexport)
+#else
+#define SPEC_NODES __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPEC_NODES SpectraNodesInit();
\ No newline at end of file
@@ -0,0 +1,411 @@
+#include "S_ProgressiveViewport.h"
+#include "S_JobSystem.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+namespace spectra::ui::viewports {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::ui::viewports";
+
+		// Small tiles so the preview still spreads over every thread
+		constexpr uint32_t PREVIEW_TILE_SIZE = 16;
+
+		// Full-resolution samples before a tile may be considered converged
+		constexpr uint32_t MIN_SAMPLES = 16;
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		render::S_PathTracerSettings previewSettings(const S_ViewportSettings& settings) {
+			const uint32_t scale = std::max(1u, settings.previewScale);
+			render::S_PathTracerSettings preview;
+			preview.width = std::max(1u, (settings.width + scale - 1) / scale);
+			preview.height = std::max(1u, (settings.height + scale - 1) / scale);
+			preview.tileSize = PREVIEW_TILE_SIZE;
+			preview.samplesPerPass = 1;
+			preview.minSamples = 1;
+			preview.maxSamples = 1;
+			preview.maxAdaptiveBoost = 1;
+			preview.maxDepth = settings.previewDepth;
+			preview.convergenceThreshold = 0.0f;
+			preview.seed = settings.seed;
+			return preview;
+		}
+
+		render::S_PathTracerSettings refineSettings(const S_ViewportSettings& settings) {
+			render::S_PathTracerSettings refine;
+			refine.width = settings.width;
+			refine.height = settings.height;
+			refine.tileSize = settings.tileSize;
+			refine.samplesPerPass = settings.samplesPerPass;
+			refine.minSamples = std::min(MIN_SAMPLES, settings.maxSamples);
+			refine.maxSamples = settings.maxSamples;
+			refine.maxDepth = settings.maxDepth;
+			refine.convergenceThreshold = settings.convergenceThreshold;
+			refine.seed = settings.seed;
+			return refine;
+		}
+
+		bool isFinished(const render::S_TileState& tile, uint32_t maxSamples) {
+			return tile.converged || tile.samples >= maxSamples;
+		}
+	}
+
+	// S_ProgressiveViewport implementations
+	S_ProgressiveViewport::S_ProgressiveViewport(const render::S_Scene& scene, const render::S_Camera& camera, const S_ViewportSettings& settings)
+		: settings(settings), scene(scene), camera(camera), previewTracer(previewSettings(settings)), tracer(refineSettings(settings)) {
+		this->settings.focusBoost = std::max(1u, settings.focusBoost);
+		this->settings.previewScale = std::max(1u, settings.previewScale);
+
+		previewTracer.setCancelFlag(&cancelFlag);
+		tracer.setCancelFlag(&cancelFlag);
+		focusTiles.assign(tracer.getTiles().size(), 0);
+		image.assign(static_cast<size_t>(settings.width) * settings.height * 3, 0.0f);
+		editTime = S_Clock::now();
+		lastPresent = editTime;
+		renderThread = std::thread([this] { renderLoop(); });
+	}
+
+	S_ProgressiveViewport::~S_ProgressiveViewport() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			cancelFlag.store(true, std::memory_order_relaxed);
+		}
+		workCondition.notify_all();
+		renderThread.join();
+	}
+
+	void S_ProgressiveViewport::beginEdit() {
+		const auto start = S_Clock::now();
+		std::unique_lock<std::mutex> lock(mutex);
+		++editDepth;
+		if (!busy) {
+			return;
+		}
+
+		cancelFlag.store(true, std::memory_order_relaxed);
+		idleCondition.wait(lock, [this] { return !busy; });
+		const double cancelMilliseconds = millisecondsSince(start);
+		stats.cancellations++;
+		stats.lastCancelMilliseconds = cancelMilliseconds;
+		stats.maxCancelMilliseconds = std::max(stats.maxCancelMilliseconds, cancelMilliseconds);
+		cancelSum += cancelMilliseconds;
+		stats.averageCancelMilliseconds = cancelSum / static_cast<double>(stats.cancellations);
+	}
+
+	void S_ProgressiveViewport::endEdit() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (editDepth == 0) {
+				instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::WARNING, "S_ProgressiveViewport", "endEdit",
+					"endEdit() without beginEdit()");
+				return;
+			}
+			if (--editDepth > 0) {
+				return;
+			}
+			++generation;
+			editTime = S_Clock::now();
+		}
+		workCondition.notify_all();
+	}
+
+	void S_ProgressiveViewport::setCamera(const render::S_Camera& camera) {
+		beginEdit();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			this->camera = camera;
+		}
+		endEdit();
+	}
+
+	void S_ProgressiveViewport::setFocus(float u, float v) {
+		std::lock_guard<std::mutex> lock(mutex);
+		focusU = std::clamp(u, 0.0f, 1.0f);
+		focusV = std::clamp(v, 0.0f, 1.0f);
+		focusGeneration.fetch_add(1, std::memory_order_release);
+	}
+
+	void S_ProgressiveViewport::setFocus(const core::math::S_Vec3& point) {
+		float u;
+		float v;
+		bool visible;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			visible = camera.project(point, u, v);
+		}
+		if (visible) {
+			setFocus(u, v);
+		}
+	}
+
+	bool S_ProgressiveViewport::acquireFrame(std::vector<float>& rgb, S_ViewportFrame& frame) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (presentedFrame.index == acquiredFrame) {
+			return false;
+		}
+		rgb = presentedImage;
+		frame = presentedFrame;
+		acquiredFrame = presentedFrame.index;
+		return true;
+	}
+
+	bool S_ProgressiveViewport::waitForComplete(double timeoutMilliseconds) {
+		std::unique_lock<std::mutex> lock(mutex);
+		return idleCondition.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutMilliseconds), [this] {
+			return editDepth == 0 && completedGeneration == generation;
+		});
+	}
+
+	const S_ViewportSettings& S_ProgressiveViewport::getSettings() const {
+		return settings;
+	}
+
+	S_ViewportStats S_ProgressiveViewport::getStats() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	void S_ProgressiveViewport::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		const S_ViewportStats current = getStats();
+		Instrumentation::setGauge(STATS_CATEGORY, "generations", static_cast<double>(current.generations));
+		Instrumentation::setGauge(STATS_CATEGORY, "cancellations", static_cast<double>(current.cancellations));
+		Instrumentation::setGauge(STATS_CATEGORY, "presentedFrames", static_cast<double>(current.presentedFrames));
+		Instrumentation::setGauge(STATS_CATEGORY, "refinedTiles", static_cast<double>(current.refinedTiles));
+		Instrumentation::setGauge(STATS_CATEGORY, "maxFirstFrameMilliseconds", current.maxFirstFrameMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "averageFirstFrameMilliseconds", current.averageFirstFrameMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "maxCancelMilliseconds", current.maxCancelMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "averageCancelMilliseconds", current.averageCancelMilliseconds);
+		Instrumentation::setGauge(STATS_CATEGORY, "maxPresentGapMilliseconds", current.maxPresentGapMilliseconds);
+	}
+
+	void S_ProgressiveViewport::renderLoop() {
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			workCondition.wait(lock, [this] { return stopping || (editDepth == 0 && startedGeneration != generation); });
+			if (stopping) {
+				break;
+			}
+
+			const uint64_t current = generation;
+			const S_Clock::time_point start = editTime;
+			startedGeneration = current;
+			stats.generations++;
+			cancelFlag.store(false, std::memory_order_relaxed);
+			busy = true;
+			lock.unlock();
+
+			renderGeneration(current, start);
+
+			lock.lock();
+			busy = false;
+			idleCondition.notify_all();
+		}
+	}
+
+	// Runs without the lock; edits wait for it to return before touching the scene or camera
+	bool S_ProgressiveViewport::renderGeneration(uint64_t renderGeneration, S_Clock::time_point start) {
+		const auto cancelled = [this] { return cancelFlag.load(std::memory_order_relaxed); };
+
+		previewTracer.begin(scene, camera);
+		while (previewTracer.renderPass()) {
+		}
+		if (cancelled()) {
+			return false;
+		}
+		previewTracer.resolve(previewImage);
+		upscalePreview();
+		present(renderGeneration, start, true);
+
+		tracer.begin(scene, camera);
+		const std::vector<render::S_TileState>& tiles = tracer.getTiles();
+		const uint32_t maxSamples = tracer.getSettings().maxSamples;
+		const size_t batchSize = settings.batchTiles > 0
+			? settings.batchTiles
+			: static_cast<size_t>(core::jobs::S_JobSystem::getInstance().getThreadCount()) * 2;
+
+		uint64_t seenFocus = 0;
+		for (uint32_t round = 0; !tracer.isComplete(); ++round) {
+			// The first round covers every tile so the preview is replaced everywhere; then the
+			// rest only join every focusBoost rounds while focus tiles remain unfinished
+			bool focusUnfinished = false;
+			for (uint32_t t = 0; t < tiles.size(); ++t) {
+				focusUnfinished |= focusTiles[t] != 0 && !isFinished(tiles[t], maxSamples);
+			}
+			const bool everyTile = round % settings.focusBoost == 0 || !focusUnfinished;
+			pending.clear();
+			for (uint32_t t = 0; t < tiles.size(); ++t) {
+				if (!isFinished(tiles[t], maxSamples) && (everyTile || focusTiles[t] != 0)) {
+					pending.push_back(t);
+				}
+			}
+			bool resort = true;  // The new pending list is sorted before its first batch
+
+			size_t next = 0;
+			while (next < pending.size()) {
+				const uint64_t currentFocus = focusGeneration.load(std::memory_order_acquire);
+				if (resort || currentFocus != seenFocus) {
+					float u;
+					float v;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						u = focusU;
+						v = focusV;
+					}
+					updateFocusTiles(u, v);
+					pending.erase(pending.begin(), pending.begin() + static_cast<ptrdiff_t>(next));
+					next = 0;
+					sortPending(u, v);
+					resort = false;
+					seenFocus = currentFocus;
+				}
+
+				const size_t count = std::min(batchSize, pending.size() - next);
+				const std::span<const uint32_t> batch(pending.data() + next, count);
+				tracer.renderTiles(batch);
+				if (cancelled()) {
+					return false;
+				}
+				for (const uint32_t t : batch) {
+					tracer.resolveTile(t, image);
+				}
+				next += count;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stats.refinedTiles += count;
+				}
+
+				if (millisecondsSince(lastPresent) >= settings.presentIntervalMilliseconds) {
+					present(renderGeneration, start, false);
+				}
+			}
+		}
+
+		present(renderGeneration, start, false);
+		return true;
+	}
+
+	// Bilinear, with the preview's pixel centres mapped onto the full image
+	void S_ProgressiveViewport::upscalePreview() {
+		const render::S_PathTracerSettings& preview = previewTracer.getSettings();
+		const float scaleX = static_cast<float>(preview.width) / static_cast<float>(settings.width);
+		const float scaleY = static_cast<float>(preview.height) / static_cast<float>(settings.height);
+		const float maxX = static_cast<float>(preview.width - 1);
+		const float maxY = static_cast<float>(preview.height - 1);
+
+		for (uint32_t y = 0; y < settings.height; ++y) {
+			const float sy = std::clamp((static_cast<float>(y) + 0.5f) * scaleY - 0.5f, 0.0f, maxY);
+			const uint32_t y0 = static_cast<uint32_t>(sy);
+			const uint32_t y1 = std::min(y0 + 1, preview.height - 1);
+			const float fy = sy - static_cast<float>(y0);
+			for (uint32_t x = 0; x < settings.width; ++x) {
+				const float sx = std::clamp((static_cast<float>(x) + 0.5f) * scaleX - 0.5f, 0.0f, maxX);
+				const uint32_t x0 = static_cast<uint32_t>(sx);
+				const uint32_t x1 = std::min(x0 + 1, preview.width - 1);
+				const float fx = sx - static_cast<float>(x0);
+
+				const float* p00 = &previewImage[(static_cast<size_t>(y0) * preview.width + x0) * 3];
+				const float* p01 = &previewImage[(static_cast<size_t>(y0) * preview.width + x1) * 3];
+				const float* p10 = &previewImage[(static_cast<size_t>(y1) * preview.width + x0) * 3];
+				const float* p11 = &previewImage[(static_cast<size_t>(y1) * preview.width + x1) * 3];
+				float* out = &image[(static_cast<size_t>(y) * settings.width + x) * 3];
+				for (int c = 0; c < 3; ++c) {
+					const float top = p00[c] + (p01[c] - p00[c]) * fx;
+					const float bottom = p10[c] + (p11[c] - p10[c]) * fx;
+					out[c] = top + (bottom - top) * fy;
+				}
+			}
+		}
+	}
+
+	void S_ProgressiveViewport::updateFocusTiles(float u, float v) {
+		const float focusX = u * static_cast<float>(settings.width);
+		const float focusY = v * static_cast<float>(settings.height);
+		const float radius = settings.focusRadius * std::hypot(static_cast<float>(settings.width), static_cast<float>(settings.height));
+
+		const std::vector<render::S_TileState>& tiles = tracer.getTiles();
+		for (size_t t = 0; t < tiles.size(); ++t) {
+			// Nearest point of the tile, so tiles the circle only grazes count too
+			const float dx = std::clamp(focusX, static_cast<float>(tiles[t].x0), static_cast<float>(tiles[t].x1)) - focusX;
+			const float dy = std::clamp(focusY, static_cast<float>(tiles[t].y0), static_cast<float>(tiles[t].y1)) - focusY;
+			focusTiles[t] = dx * dx + dy * dy <= radius * radius ? 1 : 0;
+		}
+	}
+
+	void S_ProgressiveViewport::sortPending(float u, float v) {
+		const float focusX = u * static_cast<float>(settings.width);
+		const float focusY = v * static_cast<float>(settings.height);
+		const std::vector<render::S_TileState>& tiles = tracer.getTiles();
+		const auto distanceSquared = [&](uint32_t t) {
+			const float dx = 0.5f * static_cast<float>(tiles[t].x0 + tiles[t].x1) - focusX;
+			const float dy = 0.5f * static_cast<float>(tiles[t].y0 + tiles[t].y1) - focusY;
+			return dx * dx + dy * dy;
+		};
+		std::stable_sort(pending.begin(), pending.end(), [&](uint32_t a, uint32_t b) {
+			return distanceSquared(a) < distanceSquared(b);
+		});
+	}
+
+	void S_ProgressiveViewport::present(uint64_t renderGeneration, S_Clock::time_point start, bool preview) {
+		S_ViewportFrame frame;
+		frame.generation = renderGeneration;
+		frame.preview = preview;
+		if (!preview) {
+			const std::vector<render::S_TileState>& tiles = tracer.getTiles();
+			uint64_t refined = 0;
+			uint64_t samples = 0;
+			uint64_t pixels = 0;
+			uint64_t focusSamples = 0;
+			uint64_t focusPixels = 0;
+			for (size_t t = 0; t < tiles.size(); ++t) {
+				const uint64_t tilePixels = static_cast<uint64_t>(tiles[t].x1 - tiles[t].x0) * (tiles[t].y1 - tiles[t].y0);
+				refined += tiles[t].samples > 0 ? 1 : 0;
+				samples += tiles[t].samples * tilePixels;
+				pixels += tilePixels;
+				if (focusTiles[t] != 0) {
+					focusSamples += tiles[t].samples * tilePixels;
+					focusPixels += tilePixels;
+				}
+			}
+			frame.complete = tracer.isComplete();
+			frame.coverage = static_cast<float>(refined) / static_cast<float>(tiles.size());
+			frame.meanSamples = static_cast<float>(samples) / static_cast<float>(pixels);
+			frame.focusSamples = focusPixels > 0 ? static_cast<float>(focusSamples) / static_cast<float>(focusPixels) : 0.0f;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			const auto now = S_Clock::now();
+			frame.latencyMilliseconds = std::chrono::duration<double, std::milli>(now - start).count();
+			frame.index = ++stats.presentedFrames;
+			if (preview) {
+				++firstFrames;
+				stats.lastFirstFrameMilliseconds = frame.latencyMilliseconds;
+				stats.maxFirstFrameMilliseconds = std::max(stats.maxFirstFrameMilliseconds, frame.latencyMilliseconds);
+				firstFrameSum += frame.latencyMilliseconds;
+				stats.averageFirstFrameMilliseconds = firstFrameSum / static_cast<double>(firstFrames);
+			}
+			else {
+				const double gap = std::chrono::duration<double, std::milli>(now - lastPresent).count();
+				stats.maxPresentGapMilliseconds = std::max(stats.maxPresentGapMilliseconds, gap);
+			}
+			lastPresent = now;
+			presentedImage = image;
+			presentedFrame = frame;
+			if (frame.complete) {
+				completedGeneration = renderGeneration;
+			}
+		}
+		if (frame.complete) {
+			idleCondition.notify_all();
+		}
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, preview ? "firstFrame" : "present", frame.latencyMilliseconds);
+	}
+}
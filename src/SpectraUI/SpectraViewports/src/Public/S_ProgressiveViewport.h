@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SpectraViewports.h"
+#include "S_Camera.h"
+#include "S_PathTracer.h"
+#include "S_Scene.h"
+
+namespace spectra::ui::viewports {
+	struct S_ViewportSettings {
+		uint32_t width = 640;
+		uint32_t height = 480;
+		uint32_t tileSize = 32;
+		uint32_t previewScale = 8;              // The first frame is traced at 1/previewScale and upscaled
+		uint32_t previewDepth = 2;              // Bounces of the first frame
+		uint32_t samplesPerPass = 2;
+		uint32_t maxSamples = 256;
+		uint32_t maxDepth = 6;
+		float convergenceThreshold = 0.02f;
+		float focusRadius = 0.2f;               // Fraction of the image diagonal around the focus
+		uint32_t focusBoost = 4;                // Passes a focus tile gets for each pass of the others
+		uint32_t batchTiles = 0;                // Tiles between cancellation and present checks, 0 uses twice the thread count
+		double presentIntervalMilliseconds = 33.0;  // Refined frames are presented at this cadence
+		uint64_t seed = 0;
+	};
+
+	// What a presented image holds
+	struct S_ViewportFrame {
+		uint64_t index = 0;                 // Counts presented frames, starting at 1
+		uint64_t generation = 0;            // Counts restarts by edits
+		bool preview = false;               // Only the upscaled first frame so far
+		bool complete = false;              // Every tile converged or reached maxSamples
+		float coverage = 0.0f;              // Fraction of tiles refined at full resolution
+		float focusSamples = 0.0f;          // Mean samples per pixel of the tiles around the focus
+		float meanSamples = 0.0f;           // Over the whole image
+		double latencyMilliseconds = 0.0;   // Since the edit that started the generation
+	};
+
+	struct S_ViewportStats {
+		uint64_t generations = 0;
+		uint64_t cancellations = 0;         // Generations stopped by an edit before completing
+		uint64_t presentedFrames = 0;
+		uint64_t refinedTiles = 0;          // Tile passes at full resolution
+		double lastFirstFrameMilliseconds = 0.0;  // From edit to presented preview
+		double maxFirstFrameMilliseconds = 0.0;
+		double averageFirstFrameMilliseconds = 0.0;
+		double lastCancelMilliseconds = 0.0;      // From edit to the render thread standing still
+		double maxCancelMilliseconds = 0.0;
+		double averageCancelMilliseconds = 0.0;
+		double maxPresentGapMilliseconds = 0.0;   // Longest wait between refined frames
+	};
+
+	// Drives the CPU path tracer for an editor viewport on its own thread so the UI never waits
+	// on it. After every edit a preview at 1/previewScale resolution and a couple of bounces is
+	// traced and presented, typically within a few tens of milliseconds, then the image is
+	// refined at full resolution in small batches of tiles nearest the focus first; tiles
+	// within focusRadius of the focus get focusBoost passes for each pass of the rest. Refined
+	// frames are presented every presentIntervalMilliseconds, unrefined tiles still showing the
+	// upscaled preview. Edits cancel the work in flight through the tracer's cancel flag, which
+	// is polled between rows, and restart from the preview. Thread-safe; the scene may only be
+	// changed between beginEdit() and endEdit().
+	class SPECTRA_VIEWPORTS S_ProgressiveViewport {
+	public:
+		// Starts rendering. The scene must outlive the viewport.
+		S_ProgressiveViewport(const render::S_Scene& scene, const render::S_Camera& camera, const S_ViewportSettings& settings = {});
+		~S_ProgressiveViewport();
+
+		S_ProgressiveViewport(const S_ProgressiveViewport&) = delete;
+		S_ProgressiveViewport& operator=(const S_ProgressiveViewport&) = delete;
+
+		// Cancels the render and blocks until the render thread no longer reads the scene, which
+		// may then be edited, e.g. its materials. Edits nest.
+		void beginEdit();
+
+		// Restarts from the preview once the outermost edit ends
+		void endEdit();
+
+		// Cancels and restarts with the new camera
+		void setCamera(const render::S_Camera& camera);
+
+		// Moves the focus to image coordinates in [0, 1], e.g. under the cursor. Takes effect at
+		// the next batch without a restart.
+		void setFocus(float u, float v);
+
+		// Focuses on a world position, e.g. the selected object; ignored behind the camera
+		void setFocus(const core::math::S_Vec3& point);
+
+		// Copies the latest presented image, linear RGB with three floats per pixel and rows
+		// top to bottom, when it is newer than the last one acquired; false otherwise
+		bool acquireFrame(std::vector<float>& rgb, S_ViewportFrame& frame);
+
+		// Blocks until the current generation is complete, false on timeout
+		bool waitForComplete(double timeoutMilliseconds);
+
+		[[nodiscard]] const S_ViewportSettings& getSettings() const;
+		[[nodiscard]] S_ViewportStats getStats() const;
+
+		// Pushes the stats to SpectraInstrumentation under "spectra::ui::viewports"
+		void publishStats() const;
+
+	private:
+		using S_Clock = std::chrono::steady_clock;
+
+		S_ViewportSettings settings;
+		const render::S_Scene& scene;
+		render::S_Camera camera;
+		render::S_PathTracer previewTracer;
+		render::S_PathTracer tracer;
+		std::vector<uint8_t> focusTiles;        // Per tile of tracer, nonzero within focusRadius
+		std::vector<uint32_t> pending;          // Tiles left in the current round
+		std::vector<float> previewImage;
+		std::vector<float> image;               // Composited on the render thread
+		std::vector<float> presentedImage;
+		S_ViewportFrame presentedFrame;
+		uint64_t acquiredFrame = 0;
+		std::thread renderThread;
+		std::atomic<bool> cancelFlag{ false };
+		std::atomic<uint64_t> focusGeneration{ 0 };
+		mutable std::mutex mutex;
+		std::condition_variable workCondition;
+		std::condition_variable idleCondition;
+		float focusU = 0.5f;
+		float focusV = 0.5f;
+		uint32_t editDepth = 0;
+		uint64_t generation = 1;
+		uint64_t startedGeneration = 0;
+		uint64_t completedGeneration = 0;
+		S_Clock::time_point editTime;
+		S_Clock::time_point lastPresent;
+		bool busy = false;
+		bool stopping = false;
+		uint64_t firstFrames = 0;
+		double firstFrameSum = 0.0;
+		double cancelSum = 0.0;
+		S_ViewportStats stats;
+
+		void renderLoop();
+		bool renderGeneration(uint64_t renderGeneration, S_Clock::time_point start);
+		void upscalePreview();
+		void updateFocusTiles(float u, float v);
+		void sortPending(float u, float v);
+		void present(uint64_t renderGeneration, S_Clock::time_point start, bool preview);
+	};
+}
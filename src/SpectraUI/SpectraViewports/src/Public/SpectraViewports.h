@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPECTRA_VIEWPORTS
+#if defined(_WIN32)
 #define SPECTRA_VIEWPORTS __declspec(dllexport)
+#else
+#define SPECTRA_VIEWPORTS __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECTRA_VIEWPORTS SpectraViewportsInit();
\ No newline at end of file
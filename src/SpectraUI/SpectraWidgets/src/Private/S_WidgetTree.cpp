@@ -0,0 +1,506 @@
+#include "S_WidgetTree.h"
+#include "SpectraInstrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace spectra::ui::widgets {
+	namespace {
+		constexpr const char* STATS_CATEGORY = "spectra::ui::widgets";
+
+		// Clip of geometry that takes whatever scissor its parent applies
+		constexpr float UNBOUNDED = std::numeric_limits<float>::infinity();
+		constexpr S_Rect INHERIT_CLIP{ UNBOUNDED, UNBOUNDED, -UNBOUNDED, -UNBOUNDED };
+		constexpr S_Rect EMPTY_BOUNDS = INHERIT_CLIP;
+
+		// The atlas is a 16 by 16 grid of ASCII glyphs whose first cell is solid white
+		constexpr uint32_t ATLAS_CELLS = 16;
+		constexpr float ATLAS_CELL = 1.0f / static_cast<float>(ATLAS_CELLS);
+		constexpr float WHITE_UV = 0.5f * ATLAS_CELL;
+
+		double millisecondsSince(std::chrono::steady_clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		bool isInherited(const S_Rect& clip) {
+			return clip.x0 > clip.x1;
+		}
+
+		bool overlaps(const S_Rect& a, const S_Rect& b) {
+			return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+		}
+
+		bool contains(const S_Rect& outer, const S_Rect& inner) {
+			return inner.x0 >= outer.x0 && inner.y0 >= outer.y0 && inner.x1 <= outer.x1 && inner.y1 <= outer.y1;
+		}
+
+		S_Rect intersect(const S_Rect& a, const S_Rect& b) {
+			return { std::max(a.x0, b.x0), std::max(a.y0, b.y0), std::min(a.x1, b.x1), std::min(a.y1, b.y1) };
+		}
+
+		S_Rect unite(const S_Rect& a, const S_Rect& b) {
+			return { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+		}
+
+		S_Rect offset(const S_Rect& rect, float dx, float dy) {
+			return { rect.x0 + dx, rect.y0 + dy, rect.x1 + dx, rect.y1 + dy };
+		}
+
+		// Panels and sliders take the content width of the panel they sit in
+		bool isStretched(E_WidgetType type) {
+			return type == E_WidgetType::PANEL || type == E_WidgetType::SLIDER;
+		}
+
+		void addQuad(S_DrawList& list, S_Rect& bounds, const S_Rect& rect, const S_Rect& uv, uint32_t color) {
+			const uint32_t base = static_cast<uint32_t>(list.vertices.size());
+			list.vertices.push_back({ rect.x0, rect.y0, uv.x0, uv.y0, color });
+			list.vertices.push_back({ rect.x1, rect.y0, uv.x1, uv.y0, color });
+			list.vertices.push_back({ rect.x1, rect.y1, uv.x1, uv.y1, color });
+			list.vertices.push_back({ rect.x0, rect.y1, uv.x0, uv.y1, color });
+			list.indices.insert(list.indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+			bounds = unite(bounds, rect);
+		}
+
+		void addRect(S_DrawList& list, S_Rect& bounds, const S_Rect& rect, uint32_t color) {
+			addQuad(list, bounds, rect, { WHITE_UV, WHITE_UV, WHITE_UV, WHITE_UV }, color);
+		}
+
+		// One quad per visible glyph, characters outside printable ASCII show as '?'
+		void addText(S_DrawList& list, S_Rect& bounds, float x, float y, std::string_view text, const S_WidgetStyle& style, uint32_t color) {
+			for (const char character : text) {
+				if (character != ' ') {
+					const uint32_t cell = character > ' ' && character < 127 ? static_cast<uint32_t>(character) : static_cast<uint32_t>('?');
+					const float u = static_cast<float>(cell % ATLAS_CELLS) * ATLAS_CELL;
+					const float v = static_cast<float>(cell / ATLAS_CELLS) * ATLAS_CELL;
+					addQuad(list, bounds, { x, y, x + style.glyphWidth, y + style.lineHeight }, { u, v, u + ATLAS_CELL, v + ATLAS_CELL }, color);
+				}
+				x += style.glyphWidth;
+			}
+		}
+
+		// Extends the last command when it has the same scissor
+		void pushCommand(S_DrawList& list, const S_Rect& clip, const S_Rect& bounds, uint32_t indexOffset, uint32_t indexCount) {
+			if (indexCount == 0) {
+				return;
+			}
+			if (!list.commands.empty()) {
+				S_DrawCommand& last = list.commands.back();
+				if (last.clip == clip && last.indexOffset + last.indexCount == indexOffset) {
+					last.indexCount += indexCount;
+					last.bounds = unite(last.bounds, bounds);
+					return;
+				}
+			}
+			list.commands.push_back({ clip, bounds, indexOffset, indexCount });
+		}
+
+		// Appends a child's list under clip. A child command whose triangles fit its own scissor
+		// is not clipped by it, so it takes clip instead and can merge with its neighbours.
+		void appendList(S_DrawList& list, const S_DrawList& child, const S_Rect& clip) {
+			const uint32_t baseVertex = static_cast<uint32_t>(list.vertices.size());
+			const uint32_t baseIndex = static_cast<uint32_t>(list.indices.size());
+			list.vertices.insert(list.vertices.end(), child.vertices.begin(), child.vertices.end());
+			list.indices.resize(baseIndex + child.indices.size());
+			uint32_t* indices = list.indices.data() + baseIndex;
+			for (size_t i = 0; i < child.indices.size(); ++i) {
+				indices[i] = child.indices[i] + baseVertex;
+			}
+
+			for (const S_DrawCommand& command : child.commands) {
+				S_Rect commandClip = clip;
+				if (!isInherited(command.clip) && !contains(command.clip, command.bounds)) {
+					commandClip = isInherited(clip) ? command.clip : intersect(command.clip, clip);
+				}
+				pushCommand(list, commandClip, command.bounds, command.indexOffset + baseIndex, command.indexCount);
+			}
+		}
+
+		void translateList(S_DrawList& list, float dx, float dy) {
+			for (S_WidgetVertex& vertex : list.vertices) {
+				vertex.x += dx;
+				vertex.y += dy;
+			}
+			for (S_DrawCommand& command : list.commands) {
+				command.bounds = offset(command.bounds, dx, dy);
+				if (!isInherited(command.clip)) {
+					command.clip = offset(command.clip, dx, dy);
+				}
+			}
+		}
+
+		void clearList(S_DrawList& list) {
+			list.vertices.clear();
+			list.indices.clear();
+			list.commands.clear();
+		}
+	}
+
+	// S_WidgetTree implementations
+	S_WidgetTree::S_WidgetTree(const S_WidgetTreeSettings& settings)
+		: settings(settings) {
+		widgets.emplace_back();
+	}
+
+	uint32_t S_WidgetTree::addWidget(uint32_t parent, E_WidgetType type) {
+		validateWidget(parent, "addWidget");
+		if (widgets[parent].type != E_WidgetType::PANEL && widgets[parent].type != E_WidgetType::ROW) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_WidgetTree", "addWidget",
+				"Only panels and rows have children", parent);
+		}
+
+		const uint32_t id = static_cast<uint32_t>(widgets.size());
+		S_Widget& widget = widgets.emplace_back();
+		widget.type = type;
+		widget.parent = parent;
+		widgets[parent].children.push_back(id);
+		markLayout(parent);
+		aliveCount++;
+		return id;
+	}
+
+	void S_WidgetTree::removeWidget(uint32_t widget) {
+		validateWidget(widget, "removeWidget");
+		if (widget == ROOT_WIDGET_ID) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::WARNING, "S_WidgetTree", "removeWidget",
+				"The root cannot be removed");
+			return;
+		}
+
+		const uint32_t parent = widgets[widget].parent;
+		std::vector<uint32_t>& siblings = widgets[parent].children;
+		siblings.erase(std::find(siblings.begin(), siblings.end(), widget));
+		markLayout(parent);
+		releaseSubtree(widget);
+	}
+
+	void S_WidgetTree::setText(uint32_t widget, std::string_view text) {
+		validateWidget(widget, "setText");
+		if (widgets[widget].text != text) {
+			widgets[widget].text = text;
+			markLayout(widget);
+		}
+	}
+
+	// Only moves geometry within the widget, so its ancestors keep their layout
+	void S_WidgetTree::setValue(uint32_t widget, float value) {
+		validateWidget(widget, "setValue");
+		if (widgets[widget].type == E_WidgetType::SLIDER) {
+			value = std::clamp(value, 0.0f, 1.0f);
+		}
+		if (widgets[widget].value != value) {
+			widgets[widget].value = value;
+			markCache(widget);
+		}
+	}
+
+	void S_WidgetTree::setVisible(uint32_t widget, bool visible) {
+		validateWidget(widget, "setVisible");
+		if (widget != ROOT_WIDGET_ID && widgets[widget].visible != visible) {
+			widgets[widget].visible = visible;
+			markLayout(widgets[widget].parent);
+		}
+	}
+
+	void S_WidgetTree::setHeight(uint32_t panel, float height) {
+		validateWidget(panel, "setHeight");
+		height = std::max(0.0f, height);
+		if (panel != ROOT_WIDGET_ID && widgets[panel].fixedHeight != height) {
+			widgets[panel].fixedHeight = height;
+			markLayout(panel);
+		}
+	}
+
+	// Children keep their layout and cached geometry, which is translated when drawn
+	void S_WidgetTree::setScroll(uint32_t panel, float offset) {
+		validateWidget(panel, "setScroll");
+		if (widgets[panel].scroll != offset) {
+			widgets[panel].scroll = offset;
+			markCache(panel);
+		}
+	}
+
+	void S_WidgetTree::setStyle(const S_WidgetStyle& style) {
+		settings.style = style;
+		for (S_Widget& widget : widgets) {
+			widget.layoutDirty = true;
+			widget.cacheDirty = true;
+		}
+	}
+
+	const S_DrawList& S_WidgetTree::build(const S_Rect& viewport) {
+		const auto start = std::chrono::steady_clock::now();
+		stats = {};
+		stats.widgets = static_cast<uint32_t>(aliveCount);
+
+		if (!settings.retained) {
+			for (S_Widget& widget : widgets) {
+				widget.layoutDirty = true;
+				widget.cacheDirty = true;
+			}
+		}
+
+		// The root is a panel of the viewport's height, which clips to the viewport
+		S_Widget& root = widgets[ROOT_WIDGET_ID];
+		const float height = viewport.y1 - viewport.y0;
+		if (root.fixedHeight != height) {
+			root.fixedHeight = height;
+			markLayout(ROOT_WIDGET_ID);
+		}
+
+		layout(ROOT_WIDGET_ID, viewport.x1 - viewport.x0);
+		refresh(ROOT_WIDGET_ID, viewport.x0, viewport.y0);
+
+		const S_DrawList& list = root.cache;
+		stats.vertices = static_cast<uint32_t>(list.vertices.size());
+		stats.indices = static_cast<uint32_t>(list.indices.size());
+		stats.commands = static_cast<uint32_t>(list.commands.size());
+		stats.buildMilliseconds = millisecondsSince(start);
+		instrumentation::Instrumentation::recordTiming(STATS_CATEGORY, "build", stats.buildMilliseconds);
+		return list;
+	}
+
+	const std::string& S_WidgetTree::getText(uint32_t widget) const {
+		validateWidget(widget, "getText");
+		return widgets[widget].text;
+	}
+
+	float S_WidgetTree::getValue(uint32_t widget) const {
+		validateWidget(widget, "getValue");
+		return widgets[widget].value;
+	}
+
+	size_t S_WidgetTree::getWidgetCount() const {
+		return aliveCount;
+	}
+
+	const S_WidgetBuildStats& S_WidgetTree::getStats() const {
+		return stats;
+	}
+
+	void S_WidgetTree::publishStats() const {
+		using instrumentation::Instrumentation;
+
+		Instrumentation::setGauge(STATS_CATEGORY, "widgets", stats.widgets);
+		Instrumentation::setGauge(STATS_CATEGORY, "laidOut", stats.laidOut);
+		Instrumentation::setGauge(STATS_CATEGORY, "generated", stats.generated);
+		Instrumentation::setGauge(STATS_CATEGORY, "translated", stats.translated);
+		Instrumentation::setGauge(STATS_CATEGORY, "reused", stats.reused);
+		Instrumentation::setGauge(STATS_CATEGORY, "culled", stats.culled);
+		Instrumentation::setGauge(STATS_CATEGORY, "vertices", stats.vertices);
+		Instrumentation::setGauge(STATS_CATEGORY, "commands", stats.commands);
+	}
+
+	void S_WidgetTree::validateWidget(uint32_t widget, const char* method) const {
+		if (widget >= widgets.size() || !widgets[widget].alive) {
+			instrumentation::Instrumentation::logUI(instrumentation::E_LogLevel::ERROR, "S_WidgetTree", method, "Invalid widget id", widget);
+		}
+	}
+
+	// Walks to the root without stopping early: culled and hidden subtrees stay dirty through
+	// builds that clean their ancestors
+	void S_WidgetTree::markLayout(uint32_t widget) {
+		for (; widget != INVALID_WIDGET_ID; widget = widgets[widget].parent) {
+			widgets[widget].layoutDirty = true;
+			widgets[widget].cacheDirty = true;
+		}
+	}
+
+	void S_WidgetTree::markCache(uint32_t widget) {
+		for (; widget != INVALID_WIDGET_ID; widget = widgets[widget].parent) {
+			widgets[widget].cacheDirty = true;
+		}
+	}
+
+	void S_WidgetTree::releaseSubtree(uint32_t widget) {
+		S_Widget& released = widgets[widget];
+		for (const uint32_t child : released.children) {
+			releaseSubtree(child);
+		}
+		released.alive = false;
+		released.children = {};
+		released.text = {};
+		released.cache = {};
+		aliveCount--;
+	}
+
+	bool S_WidgetTree::isClipping(const S_Widget& widget) const {
+		return widget.type == E_WidgetType::PANEL && widget.fixedHeight > 0.0f;
+	}
+
+	// width is the width a panel assigns, 0 asks for the preferred one
+	void S_WidgetTree::layout(uint32_t id, float width) {
+		S_Widget& widget = widgets[id];
+		if (!widget.layoutDirty && widget.layoutWidth == width) {
+			return;
+		}
+		stats.laidOut++;
+
+		const S_WidgetStyle& style = settings.style;
+		const float textWidth = style.glyphWidth * static_cast<float>(widget.text.size());
+		const float previousWidth = widget.width;
+		const float previousHeight = widget.height;
+		switch (widget.type) {
+		case E_WidgetType::PANEL: {
+			const float contentWidth = width > 0.0f ? std::max(0.0f, width - 2.0f * style.padding) : 0.0f;
+			float y = style.padding;
+			float widest = 0.0f;
+			bool any = false;
+			for (const uint32_t childId : widget.children) {
+				S_Widget& child = widgets[childId];
+				if (!child.visible) {
+					continue;
+				}
+				layout(childId, contentWidth > 0.0f && isStretched(child.type) ? contentWidth : 0.0f);
+				child.offsetX = style.padding;
+				child.offsetY = y;
+				y += child.height + style.spacing;
+				widest = std::max(widest, child.width);
+				any = true;
+			}
+			widget.contentHeight = (any ? y - style.spacing : y) + style.padding;
+			widget.width = width > 0.0f ? width : widest + 2.0f * style.padding;
+			widget.height = widget.fixedHeight > 0.0f ? widget.fixedHeight : widget.contentHeight;
+			break;
+		}
+		case E_WidgetType::ROW: {
+			float x = 0.0f;
+			float tallest = 0.0f;
+			bool any = false;
+			for (const uint32_t childId : widget.children) {
+				S_Widget& child = widgets[childId];
+				if (!child.visible) {
+					continue;
+				}
+				layout(childId, 0.0f);
+				child.offsetX = x;
+				child.offsetY = 0.0f;
+				x += child.width + style.spacing;
+				tallest = std::max(tallest, child.height);
+				any = true;
+			}
+			widget.width = any ? x - style.spacing : 0.0f;
+			widget.height = tallest;
+			break;
+		}
+		case E_WidgetType::LABEL:
+			widget.width = textWidth;
+			widget.height = style.lineHeight;
+			break;
+		case E_WidgetType::BUTTON:
+			widget.width = textWidth + 2.0f * style.padding;
+			widget.height = style.lineHeight + 2.0f * style.padding;
+			break;
+		case E_WidgetType::CHECKBOX:
+			widget.width = style.lineHeight + (widget.text.empty() ? 0.0f : style.spacing + textWidth);
+			widget.height = style.lineHeight;
+			break;
+		case E_WidgetType::SLIDER:
+			widget.width = width > 0.0f ? width : style.sliderWidth;
+			widget.height = style.lineHeight + 2.0f * style.padding;
+			break;
+		}
+
+		widget.layoutDirty = false;
+		widget.layoutWidth = width;
+		if (widget.width != previousWidth || widget.height != previousHeight) {
+			widget.cacheDirty = true;
+		}
+	}
+
+	// Leaves the subtree's draw list for origin (x, y) in the widget's cache
+	void S_WidgetTree::refresh(uint32_t id, float x, float y) {
+		S_Widget& widget = widgets[id];
+		if (widget.cached && !widget.cacheDirty) {
+			if (x != widget.cacheX || y != widget.cacheY) {
+				translateList(widget.cache, x - widget.cacheX, y - widget.cacheY);
+				widget.cacheX = x;
+				widget.cacheY = y;
+				stats.translated++;
+			}
+			else {
+				stats.reused++;
+			}
+			return;
+		}
+		stats.generated++;
+
+		const bool clipping = isClipping(widget);
+		const S_Rect clip = clipping ? S_Rect{ x, y, x + widget.width, y + widget.height } : INHERIT_CLIP;
+		const float scroll = clipping ? std::clamp(widget.scroll, 0.0f, std::max(0.0f, widget.contentHeight - widget.height)) : 0.0f;
+
+		clearList(widget.cache);
+		generate(widget, x, y, clip);
+		for (const uint32_t childId : widget.children) {
+			S_Widget& child = widgets[childId];
+			if (!child.visible) {
+				continue;
+			}
+			const float childX = x + child.offsetX;
+			const float childY = y + child.offsetY - scroll;
+			if (clipping && !overlaps(clip, { childX, childY, childX + child.width, childY + child.height })) {
+				stats.culled++;
+				continue;
+			}
+			refresh(childId, childX, childY);
+			appendList(widget.cache, child.cache, clip);
+		}
+
+		widget.cacheDirty = false;
+		widget.cached = true;
+		widget.cacheX = x;
+		widget.cacheY = y;
+	}
+
+	// The widget's own primitives, drawn beneath its children. Positions inside the widget are
+	// rounded so a translated cache matches a regenerated one exactly.
+	void S_WidgetTree::generate(S_Widget& widget, float x, float y, const S_Rect& clip) const {
+		const S_WidgetStyle& style = settings.style;
+		S_DrawList& list = widget.cache;
+		const uint32_t firstIndex = static_cast<uint32_t>(list.indices.size());
+		S_Rect bounds = EMPTY_BOUNDS;
+		const S_Rect rect{ x, y, x + widget.width, y + widget.height };
+
+		switch (widget.type) {
+		case E_WidgetType::PANEL:
+			addRect(list, bounds, rect, style.panelColor);
+			break;
+		case E_WidgetType::ROW:
+			break;
+		case E_WidgetType::LABEL:
+			addText(list, bounds, x, y, widget.text, style, style.textColor);
+			break;
+		case E_WidgetType::BUTTON:
+			addRect(list, bounds, rect, style.frameColor);
+			addText(list, bounds, x + style.padding, y + style.padding, widget.text, style, style.textColor);
+			break;
+		case E_WidgetType::CHECKBOX: {
+			const S_Rect box{ x, y, x + style.lineHeight, y + style.lineHeight };
+			addRect(list, bounds, box, style.frameColor);
+			if (widget.value != 0.0f) {
+				const float inset = std::max(2.0f, std::round(style.lineHeight * 0.25f));
+				addRect(list, bounds, { box.x0 + inset, box.y0 + inset, box.x1 - inset, box.y1 - inset }, style.accentColor);
+			}
+			addText(list, bounds, box.x1 + style.spacing, y, widget.text, style, style.textColor);
+			break;
+		}
+		case E_WidgetType::SLIDER: {
+			addRect(list, bounds, rect, style.frameColor);
+			const float knobWidth = style.lineHeight;
+			const float knobX = x + std::round(widget.value * std::max(0.0f, widget.width - knobWidth));
+			addRect(list, bounds, { knobX, y, knobX + knobWidth, rect.y1 }, style.accentColor);
+
+			char digits[16];
+			const int length = std::snprintf(digits, sizeof(digits), "%.2f", widget.value);
+			const std::string_view text(digits, static_cast<size_t>(std::max(0, length)));
+			const float textX = x + std::round(0.5f * (widget.width - style.glyphWidth * static_cast<float>(text.size())));
+			addText(list, bounds, textX, y + style.padding, text, style, style.textColor);
+			break;
+		}
+		}
+
+		pushCommand(list, clip, bounds, firstIndex, static_cast<uint32_t>(list.indices.size()) - firstIndex);
+	}
+}
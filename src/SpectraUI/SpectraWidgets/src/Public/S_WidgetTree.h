@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SpectraWidgets.h"
+
+namespace spectra::ui::widgets {
+	constexpr uint32_t INVALID_WIDGET_ID = 0xFFFFFFFFu;
+	constexpr uint32_t ROOT_WIDGET_ID = 0;
+
+	enum class SPECRTA_WIDGETS E_WidgetType : uint8_t {
+		PANEL = 0,  // Stacks its children vertically; with a fixed height it clips and scrolls them
+		ROW,        // Places its children side by side
+		LABEL,
+		BUTTON,
+		CHECKBOX,   // Checked while its value is non-zero
+		SLIDER      // Value in [0, 1], stretches to the width of its panel
+	};
+
+	// Pixels, x1 and y1 exclusive
+	struct S_Rect {
+		float x0 = 0.0f;
+		float y0 = 0.0f;
+		float x1 = 0.0f;
+		float y1 = 0.0f;
+
+		bool operator==(const S_Rect& other) const = default;
+	};
+
+	struct S_WidgetVertex {
+		float x = 0.0f;
+		float y = 0.0f;
+		float u = 0.0f;        // Into the font atlas, whose first cell is solid white
+		float v = 0.0f;
+		uint32_t color = 0;    // Packed as 0xAABBGGRR
+
+		bool operator==(const S_WidgetVertex& other) const = default;
+	};
+
+	// Triangles sharing a scissor rectangle
+	struct S_DrawCommand {
+		S_Rect clip;
+		S_Rect bounds;         // Of the command's triangles
+		uint32_t indexOffset = 0;
+		uint32_t indexCount = 0;
+
+		bool operator==(const S_DrawCommand& other) const = default;
+	};
+
+	struct S_DrawList {
+		std::vector<S_WidgetVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<S_DrawCommand> commands;
+
+		bool operator==(const S_DrawList& other) const = default;
+	};
+
+	// Whole-pixel values keep every vertex on whole pixels
+	struct S_WidgetStyle {
+		float glyphWidth = 7.0f;         // Fixed advance of the atlas font
+		float lineHeight = 13.0f;
+		float padding = 4.0f;
+		float spacing = 2.0f;
+		float sliderWidth = 120.0f;      // Of sliders outside panels
+		uint32_t textColor = 0xFFE0E0E0u;
+		uint32_t panelColor = 0xFF2A2A2Au;
+		uint32_t frameColor = 0xFF404040u;
+		uint32_t accentColor = 0xFFE0853Du;
+	};
+
+	struct S_WidgetTreeSettings {
+		S_WidgetStyle style;
+		bool retained = true;  // False regenerates every widget on every build, as immediate mode would
+	};
+
+	struct S_WidgetBuildStats {
+		uint32_t widgets = 0;
+		uint32_t laidOut = 0;      // Widgets whose size and child placement were recomputed
+		uint32_t generated = 0;    // Widgets whose geometry was regenerated
+		uint32_t translated = 0;   // Clean subtrees moved in place
+		uint32_t reused = 0;       // Clean subtrees appended unchanged
+		uint32_t culled = 0;       // Subtrees outside a clipping panel
+		uint32_t vertices = 0;
+		uint32_t indices = 0;
+		uint32_t commands = 0;
+		double buildMilliseconds = 0.0;
+	};
+
+	// Retained widget tree for property panels with thousands of widgets. Layout and geometry
+	// are cached per widget: each keeps its size and the placement of its children, and the
+	// draw list of its whole subtree. An edit marks the widget and its ancestors, so build()
+	// only re-lays out and regenerates what the edit reaches; a clean subtree that merely moved
+	// is translated in place rather than regenerated. Parents assemble their lists from the
+	// children's, rebasing indices. Panels with a fixed height clip their children and skip
+	// those outside. A command whose triangles already fit its scissor takes its parent's
+	// scissor instead, so neighbouring commands merge and a frame usually needs only a few.
+	// The output is plain draw data, so it can be checked without a GPU. Not thread-safe.
+	class SPECRTA_WIDGETS S_WidgetTree {
+	public:
+		explicit S_WidgetTree(const S_WidgetTreeSettings& settings = {});
+
+		// Appends a widget to a PANEL or ROW, logs an ERROR for other parents
+		uint32_t addWidget(uint32_t parent, E_WidgetType type);
+
+		// Removes the widget with its subtree; ids are not reused and the root cannot be removed
+		void removeWidget(uint32_t widget);
+
+		// Each edit only marks the widget when the new input differs
+		void setText(uint32_t widget, std::string_view text);
+		void setValue(uint32_t widget, float value);
+		void setVisible(uint32_t widget, bool visible);
+
+		// A panel with a non-zero height clips its children and scrolls them by offset pixels
+		void setHeight(uint32_t panel, float height);
+		void setScroll(uint32_t panel, float offset);
+
+		// Invalidates every widget
+		void setStyle(const S_WidgetStyle& style);
+
+		// Lays out the root panel to fill the viewport and returns the frame's draw list, valid
+		// until the next edit
+		const S_DrawList& build(const S_Rect& viewport);
+
+		[[nodiscard]] const std::string& getText(uint32_t widget) const;
+		[[nodiscard]] float getValue(uint32_t widget) const;
+		[[nodiscard]] size_t getWidgetCount() const;
+		[[nodiscard]] const S_WidgetBuildStats& getStats() const;
+
+		// Pushes the stats of the last build to SpectraInstrumentation under "spectra::ui::widgets"
+		void publishStats() const;
+
+	private:
+		struct S_Widget {
+			E_WidgetType type = E_WidgetType::PANEL;
+			uint32_t parent = INVALID_WIDGET_ID;
+			std::vector<uint32_t> children;
+			std::string text;
+			float value = 0.0f;
+			float fixedHeight = 0.0f;
+			float scroll = 0.0f;
+			bool alive = true;
+			bool visible = true;
+			bool layoutDirty = true;     // Size or child placement may change
+			bool cacheDirty = true;      // Geometry of the widget or a descendant changed
+			float layoutWidth = -1.0f;   // Width the layout was computed for, 0 for the preferred one
+			float width = 0.0f;
+			float height = 0.0f;
+			float contentHeight = 0.0f;  // Of the children of a panel, for scroll limits
+			float offsetX = 0.0f;        // From the parent's origin, before scrolling
+			float offsetY = 0.0f;
+			float cacheX = 0.0f;         // Origin the cached draw list was generated or moved to
+			float cacheY = 0.0f;
+			bool cached = false;
+			S_DrawList cache;            // The subtree's draw list
+		};
+
+		S_WidgetTreeSettings settings;
+		std::vector<S_Widget> widgets;
+		size_t aliveCount = 1;
+		S_WidgetBuildStats stats;
+
+		void validateWidget(uint32_t widget, const char* method) const;
+		void markLayout(uint32_t widget);
+		void markCache(uint32_t widget);
+		void releaseSubtree(uint32_t widget);
+		void layout(uint32_t widget, float width);
+		void refresh(uint32_t widget, float x, float y);
+		void generate(S_Widget& widget, float x, float y, const S_Rect& clip) const;
+		[[nodiscard]] bool isClipping(const S_Widget& widget) const;
+	};
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPECRTA_WIDGETS
+#if defined(_WIN32)
 #define SPECRTA_WIDGETS __declspec(dllexport)
+#else
+#define SPECRTA_WIDGETS __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECRTA_WIDGETS SpectraWidgetsInit();
\ No newline at end of file
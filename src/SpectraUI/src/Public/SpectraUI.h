@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPECTRA_UI
+#if defined(_WIN32)
 #define SPECTRA_UI __declspec(dllexport)
+#else
+#define SPECTRA_UI __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECTRA_UI SpectraUI_Init();
\ No newline at end of file
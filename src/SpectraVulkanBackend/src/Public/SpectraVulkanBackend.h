@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef SPECRTA_VULKAN_BACKEND
+#if defined(_WIN32)
 #define SPECRTA_VULKAN_BACKEND __declspec(dllexport)
+#else
+#define SPECRTA_VULKAN_BACKEND __attribute__((visibility("default")))
+#endif
 #endif
 
 void SPECRTA_VULKAN_BACKEND SpectraVulkanBackend_Init();